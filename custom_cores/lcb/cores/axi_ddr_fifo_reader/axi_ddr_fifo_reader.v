@@ -0,0 +1,260 @@
+`timescale 1 ns / 1 ps
+
+module axi_ddr_fifo_reader #(
+  parameter integer S_AXI_ADDR_WIDTH = 8,
+  parameter integer M_AXI_ADDR_WIDTH = 32,
+  parameter integer FIFO_ADDR_WIDTH  = 13 // FIFO depth = 2^FIFO_ADDR_WIDTH
+)(
+  input  wire                        aclk,
+  input  wire                        aresetn,
+
+  // AXI4-Lite subordinate interface (registers)
+  input  wire [S_AXI_ADDR_WIDTH-1:0] s_axi_awaddr,  // AXI4-Lite subordinate: Write address
+  input  wire                        s_axi_awvalid, // AXI4-Lite subordinate: Write address valid
+  output wire                        s_axi_awready, // AXI4-Lite subordinate: Write address ready
+  input  wire [31:0]                 s_axi_wdata,   // AXI4-Lite subordinate: Write data
+  input  wire [3:0]                  s_axi_wstrb,   // AXI4-Lite subordinate: Write strobe
+  input  wire                        s_axi_wvalid,  // AXI4-Lite subordinate: Write data valid
+  output wire                        s_axi_wready,  // AXI4-Lite subordinate: Write data ready
+  output reg  [1:0]                  s_axi_bresp,   // AXI4-Lite subordinate: Write response
+  output reg                         s_axi_bvalid,  // AXI4-Lite subordinate: Write response valid
+  input  wire                        s_axi_bready,  // AXI4-Lite subordinate: Write response ready
+  input  wire [S_AXI_ADDR_WIDTH-1:0] s_axi_araddr,  // AXI4-Lite subordinate: Read address
+  input  wire                        s_axi_arvalid, // AXI4-Lite subordinate: Read address valid
+  output wire                        s_axi_arready, // AXI4-Lite subordinate: Read address ready
+  output reg  [31:0]                 s_axi_rdata,   // AXI4-Lite subordinate: Read data
+  output wire [1:0]                  s_axi_rresp,   // AXI4-Lite subordinate: Read data response
+  output reg                         s_axi_rvalid,  // AXI4-Lite subordinate: Read data valid
+  input  wire                        s_axi_rready,  // AXI4-Lite subordinate: Read data ready
+
+  // AXI4 manager interface (DDR reads only, one INCR burst at a time)
+  output reg  [M_AXI_ADDR_WIDTH-1:0] m_axi_araddr,  // AXI4 manager: Read address
+  output reg  [7:0]                  m_axi_arlen,   // AXI4 manager: Read burst length (beats - 1)
+  output wire [2:0]                  m_axi_arsize,  // AXI4 manager: Read burst size
+  output wire [1:0]                  m_axi_arburst, // AXI4 manager: Read burst type
+  output wire [3:0]                  m_axi_arcache, // AXI4 manager: Read cache type
+  output wire [2:0]                  m_axi_arprot,  // AXI4 manager: Read protection type
+  output reg                         m_axi_arvalid, // AXI4 manager: Read address valid
+  input  wire                        m_axi_arready, // AXI4 manager: Read address ready
+  input  wire [31:0]                 m_axi_rdata,   // AXI4 manager: Read data
+  input  wire [1:0]                  m_axi_rresp,   // AXI4 manager: Read data response
+  input  wire                        m_axi_rlast,   // AXI4 manager: Read last beat
+  input  wire                        m_axi_rvalid,  // AXI4 manager: Read data valid
+  output wire                        m_axi_rready,  // AXI4 manager: Read data ready
+
+  // Pass-through write port (from the AXI FIFO bridge)
+  input  wire [31:0]                 bridge_wr_data,
+  input  wire                        bridge_wr_en,
+  output wire                        bridge_full,
+
+  // FIFO write side
+  output wire [31:0]                 fifo_wr_data,
+  output wire                        fifo_wr_en,
+  input  wire                        fifo_full,
+  input  wire [FIFO_ADDR_WIDTH:0]    fifo_count,
+
+  // Sticky read error (DDR read returned an error response)
+  output reg                         rd_error
+);
+
+  // Response signals
+  localparam RESP_OKAY = 2'b00;
+  localparam RESP_SLVERR = 2'b10;
+
+  // Register word offsets
+  localparam CTRL_32_OFFSET      = 0; // [0] enable, [1] clear (restart from the buffer start)
+  localparam BASE_32_OFFSET      = 1; // Buffer base address (64-byte aligned)
+  localparam SIZE_32_OFFSET      = 2; // Buffer size in bytes (multiple of 64)
+  localparam WR_PTR_32_OFFSET    = 3; // End of the valid data (byte offset, written by the host)
+  localparam RD_PTR_32_OFFSET    = 4; // Next byte offset to read (read only)
+  localparam STATUS_32_OFFSET    = 5; // [0] enabled, [1] burst in flight, [2] read error, [3] empty (read only)
+  localparam WORDS_FED_32_OFFSET = 6; // Words written to the FIFO since the last clear (read only)
+
+  // Bursts never cross a 64-byte boundary (16 beats of 32 bits)
+  localparam integer BURST_MAX = 16;
+  localparam integer FIFO_DEPTH = 1 << FIFO_ADDR_WIDTH;
+
+  // Burst states
+  localparam S_IDLE = 2'd0;
+  localparam S_ADDR = 2'd1;
+  localparam S_DATA = 2'd2;
+
+  reg        enable;
+  reg [31:0] buf_base;
+  reg [31:0] buf_size;
+  reg [31:0] wr_ptr;
+  reg [31:0] rd_ptr;
+  reg [31:0] words_fed;
+  reg [1:0]  rd_state;
+
+  wire busy = (rd_state != S_IDLE);
+  wire empty = (rd_ptr == wr_ptr);
+
+
+  //// Register writes
+  // One write at a time, once both the address and data are valid and the last response is taken.
+  // The buffer can only be moved or resized, and the read pointer cleared, while the reader is
+  // stopped with no burst in flight; the write pointer can move at any time (within the buffer).
+  wire wr_accept = s_axi_awvalid && s_axi_wvalid && !s_axi_bvalid;
+  wire [S_AXI_ADDR_WIDTH-3:0] wr_index = s_axi_awaddr[S_AXI_ADDR_WIDTH-1:2];
+  wire stopped = !enable && !busy;
+  assign s_axi_awready = wr_accept;
+  assign s_axi_wready  = wr_accept;
+
+  // Next read pointer after one beat (wraps at the end of the buffer)
+  wire [31:0] rd_ptr_inc = rd_ptr + 32'd4;
+  wire [31:0] rd_ptr_next = (rd_ptr_inc >= buf_size) ? 32'd0 : rd_ptr_inc;
+  // Once a beat has failed, the rest of the burst is still accepted (to finish it) but dropped,
+  // so no word after a gap reaches the FIFO
+  wire r_beat = m_axi_rvalid && m_axi_rready;
+  wire r_beat_ok = r_beat && (m_axi_rresp == RESP_OKAY) && !rd_error;
+
+  always @(posedge aclk) begin
+    if (!aresetn) begin
+      enable <= 1'b0;
+      buf_base <= 32'd0;
+      buf_size <= 32'd0;
+      wr_ptr <= 32'd0;
+      rd_ptr <= 32'd0;
+      words_fed <= 32'd0;
+      rd_error <= 1'b0;
+      s_axi_bvalid <= 1'b0;
+      s_axi_bresp <= RESP_OKAY;
+    end else begin
+      // Reader progress (the read pointer stays on the first bad word)
+      if (r_beat_ok) begin
+        rd_ptr <= rd_ptr_next;
+        words_fed <= words_fed + 1;
+      end else if (r_beat) begin
+        rd_error <= 1'b1; // Stop on the first bad beat, since a dropped word would corrupt the command stream
+        enable <= 1'b0;
+      end
+
+      // Register writes
+      if (wr_accept) begin
+        s_axi_bvalid <= 1'b1;
+        s_axi_bresp <= RESP_OKAY;
+        case (wr_index)
+          CTRL_32_OFFSET: begin
+            if (s_axi_wdata[1]) begin
+              if (stopped && !s_axi_wdata[0]) begin
+                rd_ptr <= 32'd0;
+                words_fed <= 32'd0;
+                rd_error <= 1'b0;
+              end else begin
+                s_axi_bresp <= RESP_SLVERR;
+              end
+            end else if (s_axi_wdata[0] && rd_error) begin
+              s_axi_bresp <= RESP_SLVERR; // Clear the error before restarting
+            end else begin
+              enable <= s_axi_wdata[0];
+            end
+          end
+          BASE_32_OFFSET: begin
+            if (stopped) buf_base <= {s_axi_wdata[31:6], 6'd0};
+            else s_axi_bresp <= RESP_SLVERR;
+          end
+          SIZE_32_OFFSET: begin
+            if (stopped) begin
+              buf_size <= {s_axi_wdata[31:6], 6'd0};
+              wr_ptr <= 32'd0;
+              rd_ptr <= 32'd0;
+            end else begin
+              s_axi_bresp <= RESP_SLVERR;
+            end
+          end
+          WR_PTR_32_OFFSET: begin
+            if ({s_axi_wdata[31:2], 2'd0} < buf_size) wr_ptr <= {s_axi_wdata[31:2], 2'd0};
+            else s_axi_bresp <= RESP_SLVERR;
+          end
+          default: s_axi_bresp <= RESP_SLVERR; // Read-only or unused
+        endcase
+      end else if (s_axi_bready && s_axi_bvalid) begin
+        s_axi_bvalid <= 1'b0;
+      end
+    end
+  end
+
+
+  //// Register reads
+  assign s_axi_arready = !s_axi_rvalid;
+  assign s_axi_rresp = RESP_OKAY;
+  wire [S_AXI_ADDR_WIDTH-3:0] rd_index = s_axi_araddr[S_AXI_ADDR_WIDTH-1:2];
+
+  always @(posedge aclk) begin
+    if (!aresetn) begin
+      s_axi_rvalid <= 1'b0;
+      s_axi_rdata <= 32'd0;
+    end else if (s_axi_arvalid && s_axi_arready) begin
+      s_axi_rvalid <= 1'b1;
+      case (rd_index)
+        CTRL_32_OFFSET:      s_axi_rdata <= {31'd0, enable};
+        BASE_32_OFFSET:      s_axi_rdata <= buf_base;
+        SIZE_32_OFFSET:      s_axi_rdata <= buf_size;
+        WR_PTR_32_OFFSET:    s_axi_rdata <= wr_ptr;
+        RD_PTR_32_OFFSET:    s_axi_rdata <= rd_ptr;
+        STATUS_32_OFFSET:    s_axi_rdata <= {28'd0, empty, rd_error, busy, enable};
+        WORDS_FED_32_OFFSET: s_axi_rdata <= words_fed;
+        default:             s_axi_rdata <= 32'd0;
+      endcase
+    end else if (s_axi_rready && s_axi_rvalid) begin
+      s_axi_rvalid <= 1'b0;
+    end
+  end
+
+
+  //// DDR reads
+  // Words waiting in the circular buffer, and the longest burst that stays inside the current
+  // 64-byte block (the buffer is 64-byte aligned, so this also stops at the end of the buffer)
+  wire [31:0] avail_bytes = (wr_ptr >= rd_ptr) ? (wr_ptr - rd_ptr) : (buf_size - rd_ptr + wr_ptr);
+  wire [31:0] avail_words = avail_bytes >> 2;
+  wire [4:0]  block_words = 5'd16 - {1'b0, rd_ptr[5:2]};
+  wire [4:0]  burst_words = (avail_words < {27'd0, block_words}) ? avail_words[4:0] : block_words;
+  // Only ask for a burst the FIFO can already take (the write-side count never under-reports)
+  wire fifo_room = ({{(31 - FIFO_ADDR_WIDTH){1'b0}}, fifo_count} + BURST_MAX) <= FIFO_DEPTH;
+
+  assign m_axi_arsize  = 3'b010;  // 4 bytes per beat
+  assign m_axi_arburst = 2'b01;   // INCR
+  assign m_axi_arcache = 4'b0011; // Normal non-cacheable bufferable
+  assign m_axi_arprot  = 3'b000;
+
+  always @(posedge aclk) begin
+    if (!aresetn) begin
+      rd_state <= S_IDLE;
+      m_axi_araddr <= {M_AXI_ADDR_WIDTH{1'b0}};
+      m_axi_arlen <= 8'd0;
+      m_axi_arvalid <= 1'b0;
+    end else begin
+      case (rd_state)
+        S_IDLE: begin
+          if (enable && !rd_error && !empty && fifo_room) begin
+            m_axi_araddr <= buf_base + rd_ptr;
+            m_axi_arlen <= {3'd0, burst_words} - 8'd1;
+            m_axi_arvalid <= 1'b1;
+            rd_state <= S_ADDR;
+          end
+        end
+        S_ADDR: begin
+          if (m_axi_arready) begin
+            m_axi_arvalid <= 1'b0;
+            rd_state <= S_DATA;
+          end
+        end
+        S_DATA: begin
+          if (r_beat && m_axi_rlast) rd_state <= S_IDLE;
+        end
+        default: rd_state <= S_IDLE;
+      endcase
+    end
+  end
+
+
+  //// FIFO write mux
+  // Host writes through the bridge take priority (so a CANCEL always gets in); DDR beats wait
+  // for a free cycle with room in the FIFO
+  assign m_axi_rready = (rd_state == S_DATA) && !bridge_wr_en && !fifo_full;
+  assign fifo_wr_en   = bridge_wr_en || r_beat_ok;
+  assign fifo_wr_data = bridge_wr_en ? bridge_wr_data : m_axi_rdata;
+  assign bridge_full  = fifo_full;
+
+endmodule
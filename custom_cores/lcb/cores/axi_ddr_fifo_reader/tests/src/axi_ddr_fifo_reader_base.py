@@ -0,0 +1,217 @@
+import cocotb
+from cocotb.clock import Clock
+from cocotb.triggers import RisingEdge, ReadOnly
+from collections import deque
+
+
+class axi_ddr_fifo_reader_base:
+
+    # Register byte offsets
+    CTRL_OFFSET      = 0x00
+    BASE_OFFSET      = 0x04
+    SIZE_OFFSET      = 0x08
+    WR_PTR_OFFSET    = 0x0C
+    RD_PTR_OFFSET    = 0x10
+    STATUS_OFFSET    = 0x14
+    WORDS_FED_OFFSET = 0x18
+
+    # STATUS bits
+    STATUS_ENABLED  = 1 << 0
+    STATUS_BUSY     = 1 << 1
+    STATUS_RD_ERROR = 1 << 2
+    STATUS_EMPTY    = 1 << 3
+
+    RESP_OKAY   = 0
+    RESP_SLVERR = 2
+
+    def __init__(self, dut, clk_period=4, time_unit='ns'):
+        self.dut = dut
+        self.clk_period = clk_period
+        self.time_unit = time_unit
+
+        # Parameters
+        self.FIFO_ADDR_WIDTH = int(self.dut.FIFO_ADDR_WIDTH.value)
+        self.FIFO_DEPTH = 1 << self.FIFO_ADDR_WIDTH
+
+        cocotb.start_soon(Clock(dut.aclk, clk_period, time_unit).start(start_high=False))
+
+        self.dut._log.info(f"FIFO_ADDR_WIDTH set to {self.FIFO_ADDR_WIDTH} ({self.FIFO_DEPTH} word FIFO)")
+
+        # Initialize Input Signals
+        self.dut.s_axi_awaddr.value = 0
+        self.dut.s_axi_awvalid.value = 0
+        self.dut.s_axi_wdata.value = 0
+        self.dut.s_axi_wstrb.value = 0
+        self.dut.s_axi_wvalid.value = 0
+        self.dut.s_axi_bready.value = 0
+        self.dut.s_axi_araddr.value = 0
+        self.dut.s_axi_arvalid.value = 0
+        self.dut.s_axi_rready.value = 0
+        self.dut.m_axi_arready.value = 1
+        self.dut.m_axi_rdata.value = 0
+        self.dut.m_axi_rresp.value = 0
+        self.dut.m_axi_rlast.value = 0
+        self.dut.m_axi_rvalid.value = 0
+        self.dut.bridge_wr_data.value = 0
+        self.dut.bridge_wr_en.value = 0
+        self.dut.fifo_full.value = 0
+        self.dut.fifo_count.value = 0
+
+        # DDR model: byte addresses that answer with SLVERR, and a log of the bursts requested
+        self.error_addrs = set()
+        self.bursts = []            # (address, beats) per accepted read address
+        self.beats_accepted = 0     # R beats handshaked, good or bad
+
+        # FIFO model: every word written, and how many of them have been drained
+        self.fifo_words = []
+        self.fifo_drained = 0
+
+    @staticmethod
+    def ddr_word(addr):
+        """Contents of DDR at a byte address (distinct for every word)."""
+        return 0xD0000000 | ((addr >> 2) & 0x0FFFFFFF)
+
+    async def reset(self):
+        """Reset the DUT, hold reset for two clock cycles."""
+        await RisingEdge(self.dut.aclk)
+        self.dut.aresetn.value = 0
+        self.dut._log.info("STARTING RESET")
+        self.bursts = []
+        self.beats_accepted = 0
+        self.fifo_words = []
+        self.fifo_drained = 0
+
+        await RisingEdge(self.dut.aclk)
+        await RisingEdge(self.dut.aclk)
+        self.dut.aresetn.value = 1
+        self.dut._log.info("RESET COMPLETE")
+
+        await ReadOnly()
+        assert int(self.dut.rd_error.value) == 0, "Read error not cleared by reset"
+        assert int(self.dut.m_axi_arvalid.value) == 0, "Read address valid after reset"
+
+    async def ddr_model(self):
+        """
+        AXI4 read subordinate in front of DDR. Takes every read address at once and answers each
+        burst in order, one beat per cycle, with SLVERR on the addresses in error_addrs.
+        """
+        pending = deque()
+        beat = 0
+        while True:
+            await RisingEdge(self.dut.aclk)
+
+            if pending:
+                addr, beats = pending[0]
+                beat_addr = addr + 4 * beat
+                self.dut.m_axi_rvalid.value = 1
+                self.dut.m_axi_rdata.value = self.ddr_word(beat_addr)
+                self.dut.m_axi_rresp.value = self.RESP_SLVERR if beat_addr in self.error_addrs else self.RESP_OKAY
+                self.dut.m_axi_rlast.value = 1 if beat == beats - 1 else 0
+            else:
+                self.dut.m_axi_rvalid.value = 0
+                self.dut.m_axi_rlast.value = 0
+
+            await ReadOnly()
+            if pending and int(self.dut.m_axi_rvalid.value) == 1 and int(self.dut.m_axi_rready.value) == 1:
+                self.beats_accepted += 1
+                beat += 1
+                if beat == pending[0][1]:
+                    pending.popleft()
+                    beat = 0
+            if int(self.dut.m_axi_arvalid.value) == 1 and int(self.dut.m_axi_arready.value) == 1:
+                burst = (int(self.dut.m_axi_araddr.value), int(self.dut.m_axi_arlen.value) + 1)
+                self.dut._log.info(f"DDR_MODEL: Burst of {burst[1]} beats at {burst[0]:08x}")
+                self.bursts.append(burst)
+                pending.append(burst)
+
+    async def fifo_model(self):
+        """Write side of the FIFO being fed: records every word written and reports the fill level."""
+        while True:
+            await RisingEdge(self.dut.aclk)
+            level = len(self.fifo_words) - self.fifo_drained
+            self.dut.fifo_count.value = level
+            self.dut.fifo_full.value = 1 if level >= self.FIFO_DEPTH else 0
+
+            await ReadOnly()
+            if int(self.dut.fifo_wr_en.value) == 1:
+                assert len(self.fifo_words) - self.fifo_drained < self.FIFO_DEPTH, "FIFO written while full"
+                self.fifo_words.append(int(self.dut.fifo_wr_data.value))
+
+    def drain_fifo(self):
+        """Empty the FIFO (as if its reader had taken every word)."""
+        self.fifo_drained = len(self.fifo_words)
+
+    async def axil_write(self, offset, value):
+        """AXI4-Lite register write. Returns the write response."""
+        await RisingEdge(self.dut.aclk)
+        self.dut.s_axi_awaddr.value = offset
+        self.dut.s_axi_wdata.value = value
+        self.dut.s_axi_wstrb.value = 0xF
+        self.dut.s_axi_awvalid.value = 1
+        self.dut.s_axi_wvalid.value = 1
+        self.dut.s_axi_bready.value = 1
+        while True:
+            await ReadOnly()
+            accepted = int(self.dut.s_axi_awready.value) == 1
+            await RisingEdge(self.dut.aclk)
+            if accepted:
+                break
+        self.dut.s_axi_awvalid.value = 0
+        self.dut.s_axi_wvalid.value = 0
+        while True:
+            await ReadOnly()
+            if int(self.dut.s_axi_bvalid.value) == 1:
+                resp = int(self.dut.s_axi_bresp.value)
+                break
+            await RisingEdge(self.dut.aclk)
+        await RisingEdge(self.dut.aclk)
+        return resp
+
+    async def axil_read(self, offset):
+        """AXI4-Lite register read. Returns the data."""
+        await RisingEdge(self.dut.aclk)
+        self.dut.s_axi_araddr.value = offset
+        self.dut.s_axi_arvalid.value = 1
+        self.dut.s_axi_rready.value = 1
+        while True:
+            await ReadOnly()
+            accepted = int(self.dut.s_axi_arready.value) == 1
+            await RisingEdge(self.dut.aclk)
+            if accepted:
+                break
+        self.dut.s_axi_arvalid.value = 0
+        while True:
+            await ReadOnly()
+            if int(self.dut.s_axi_rvalid.value) == 1:
+                data = int(self.dut.s_axi_rdata.value)
+                break
+            await RisingEdge(self.dut.aclk)
+        await RisingEdge(self.dut.aclk)
+        return data
+
+    async def setup_buffer(self, base, size):
+        """Place the circular buffer while the reader is stopped."""
+        assert await self.axil_write(self.BASE_OFFSET, base) == self.RESP_OKAY, "BASE write refused"
+        assert await self.axil_write(self.SIZE_OFFSET, size) == self.RESP_OKAY, "SIZE write refused"
+
+    async def bridge_write(self, word):
+        """One write through the pass-through port."""
+        await RisingEdge(self.dut.aclk)
+        self.dut.bridge_wr_data.value = word
+        self.dut.bridge_wr_en.value = 1
+        await RisingEdge(self.dut.aclk)
+        self.dut.bridge_wr_en.value = 0
+
+    async def wait_for_stop(self, timeout_cycles=2000):
+        """Wait until the reader is disabled (or out of data) with no burst in flight."""
+        for _ in range(timeout_cycles):
+            await RisingEdge(self.dut.aclk)
+            await ReadOnly()
+            idle = int(self.dut.rd_state.value) == 0
+            if idle and (int(self.dut.enable.value) == 0 or int(self.dut.rd_ptr.value) == int(self.dut.wr_ptr.value)):
+                return
+        assert False, "Timed out waiting for the reader to stop"
+
+    def expected_words(self, base, first, count):
+        """DDR words for buffer word indices first .. first + count - 1."""
+        return [self.ddr_word(base + 4 * i) for i in range(first, first + count)]
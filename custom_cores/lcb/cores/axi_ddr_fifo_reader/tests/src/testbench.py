@@ -0,0 +1,142 @@
+import cocotb
+from cocotb.triggers import RisingEdge, ReadOnly
+
+from axi_ddr_fifo_reader_base import axi_ddr_fifo_reader_base
+
+# Buffer used by every test: 1 KiB at a 64-byte aligned address
+BUF_BASE = 0x10000
+BUF_SIZE = 0x400
+
+async def setup_testbench(dut, clk_period=4, time_unit='ns'):
+    tb = axi_ddr_fifo_reader_base(dut, clk_period, time_unit)
+    return tb
+
+async def start_models(tb):
+    await tb.reset()
+    return [cocotb.start_soon(tb.ddr_model()), cocotb.start_soon(tb.fifo_model())]
+
+async def stream_words(tb, words):
+    """Set up the buffer, mark the first words as valid, and enable the reader."""
+    await tb.setup_buffer(BUF_BASE, BUF_SIZE)
+    assert await tb.axil_write(tb.WR_PTR_OFFSET, 4 * words) == tb.RESP_OKAY, "WR_PTR write refused"
+    assert await tb.axil_write(tb.CTRL_OFFSET, 1) == tb.RESP_OKAY, "Enable refused"
+
+# DIRECTED TESTS
+@cocotb.test()
+async def test_reset(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_reset")
+
+    await tb.reset()
+
+    # Give time before ending the test
+    await RisingEdge(dut.aclk)
+    await RisingEdge(dut.aclk)
+
+@cocotb.test()
+async def test_stream(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_stream")
+    tasks = await start_models(tb)
+
+    # 40 words: two full 16-beat bursts and one of 8
+    words = 40
+    await stream_words(tb, words)
+    await tb.wait_for_stop()
+
+    assert tb.fifo_words == tb.expected_words(BUF_BASE, 0, words), "FIFO contents don't match the buffer"
+    assert tb.bursts == [(BUF_BASE, 16), (BUF_BASE + 64, 16), (BUF_BASE + 128, 8)], f"Unexpected bursts {tb.bursts}"
+    assert await tb.axil_read(tb.WORDS_FED_OFFSET) == words, "WORDS_FED doesn't match the words written"
+    assert await tb.axil_read(tb.RD_PTR_OFFSET) == 4 * words, "RD_PTR didn't reach WR_PTR"
+    status = await tb.axil_read(tb.STATUS_OFFSET)
+    assert status == tb.STATUS_ENABLED | tb.STATUS_EMPTY, f"Unexpected STATUS {status:#x}"
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_error_mid_burst(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_error_mid_burst")
+    tasks = await start_models(tb)
+
+    # Beat 4 of the second burst fails: only the 20 words before it may reach the FIFO,
+    # though the rest of that burst still has to be taken from the read channel
+    words = 40
+    bad_word = 20
+    tb.error_addrs = {BUF_BASE + 4 * bad_word}
+    await stream_words(tb, words)
+    await tb.wait_for_stop()
+
+    assert tb.fifo_words == tb.expected_words(BUF_BASE, 0, bad_word), \
+        f"Expected the {bad_word} words before the error, got {len(tb.fifo_words)} words"
+    assert len(tb.bursts) == 2, f"No burst should follow the error, got {tb.bursts}"
+    assert tb.beats_accepted == 32, f"The failed burst wasn't drained ({tb.beats_accepted} beats taken)"
+    assert int(dut.rd_error.value) == 1, "Read error not set"
+    assert await tb.axil_read(tb.WORDS_FED_OFFSET) == bad_word, "WORDS_FED counted words after the error"
+    assert await tb.axil_read(tb.RD_PTR_OFFSET) == 4 * bad_word, "RD_PTR should stay on the bad word"
+    status = await tb.axil_read(tb.STATUS_OFFSET)
+    assert status == tb.STATUS_RD_ERROR, f"Unexpected STATUS {status:#x}"
+
+    # The reader can't be restarted until the error is cleared
+    assert await tb.axil_write(tb.CTRL_OFFSET, 1) == tb.RESP_SLVERR, "Enable accepted with the error set"
+
+    # Host writes through the bridge still get in
+    await tb.bridge_write(0xE0000000)
+    await RisingEdge(dut.aclk)
+    assert tb.fifo_words[-1] == 0xE0000000, "Bridge write lost after the error"
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_error_first_and_last_beat(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_error_first_and_last_beat")
+    tasks = await start_models(tb)
+
+    # An error on the last beat of a burst keeps everything before it
+    tb.error_addrs = {BUF_BASE + 4 * 15}
+    await stream_words(tb, 40)
+    await tb.wait_for_stop()
+    assert tb.fifo_words == tb.expected_words(BUF_BASE, 0, 15), "Words lost or kept around a last-beat error"
+    assert len(tb.bursts) == 1, f"No burst should follow the error, got {tb.bursts}"
+
+    # Clear, then fail the first beat of the second burst
+    assert await tb.axil_write(tb.CTRL_OFFSET, 2) == tb.RESP_OKAY, "Clear refused"
+    assert int(dut.rd_error.value) == 0, "Clear didn't reset the read error"
+    tb.drain_fifo()
+    tb.error_addrs = {BUF_BASE + 4 * 16}
+    assert await tb.axil_write(tb.CTRL_OFFSET, 1) == tb.RESP_OKAY, "Enable refused after the clear"
+    await tb.wait_for_stop()
+    assert tb.fifo_words[15:] == tb.expected_words(BUF_BASE, 0, 16), "Restart after the clear didn't start at the buffer start"
+    assert await tb.axil_read(tb.WORDS_FED_OFFSET) == 16, "WORDS_FED counted the failed burst"
+    assert await tb.axil_read(tb.RD_PTR_OFFSET) == 4 * 16, "RD_PTR should stay on the bad word"
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_clear_and_restart(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_clear_and_restart")
+    tasks = await start_models(tb)
+
+    words = 24
+    tb.error_addrs = {BUF_BASE + 4 * 5}
+    await stream_words(tb, words)
+    await tb.wait_for_stop()
+    assert len(tb.fifo_words) == 5, f"Expected 5 words before the error, got {len(tb.fifo_words)}"
+
+    # Once the error is cleared and the bad word fixed, the whole stream plays from the start
+    tb.error_addrs = set()
+    tb.drain_fifo()
+    assert await tb.axil_write(tb.CTRL_OFFSET, 2) == tb.RESP_OKAY, "Clear refused"
+    assert await tb.axil_write(tb.CTRL_OFFSET, 1) == tb.RESP_OKAY, "Enable refused after the clear"
+    await tb.wait_for_stop()
+
+    assert tb.fifo_words[5:] == tb.expected_words(BUF_BASE, 0, words), "Restarted stream doesn't match the buffer"
+    assert await tb.axil_read(tb.WORDS_FED_OFFSET) == words, "WORDS_FED doesn't match the restarted stream"
+
+    for task in tasks:
+        task.kill()
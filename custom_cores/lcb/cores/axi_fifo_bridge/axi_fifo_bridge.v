@@ -3,6 +3,7 @@
 module axi_fifo_bridge #(
   parameter integer AXI_ADDR_WIDTH = 8,
   parameter integer AXI_DATA_WIDTH = 32,
+  parameter integer AXI_ID_WIDTH   = 12,
   parameter         ENABLE_WRITE   = 1, // 1=enable AXI writes to FIFO
   parameter         ENABLE_READ    = 1  // 1=enable AXI reads from FIFO
 )(
@@ -10,24 +11,36 @@ module axi_fifo_bridge #(
   input  wire                       wr_resetn,
   input  wire                       rd_resetn,
 
-  // AXI4-Lite subordinate interface
-  input  wire [AXI_ADDR_WIDTH-1:0]   s_axi_awaddr,  // AXI4-Lite slave: Write address
-  input  wire                        s_axi_awvalid, // AXI4-Lite slave: Write address valid
-  output wire                        s_axi_awready, // AXI4-Lite slave: Write address ready
-  input  wire [AXI_DATA_WIDTH-1:0]   s_axi_wdata,   // AXI4-Lite slave: Write data
-  input  wire [AXI_DATA_WIDTH/8-1:0] s_axi_wstrb,   // AXI4-Lite slave: Write strobe
-  input  wire                        s_axi_wvalid,  // AXI4-Lite slave: Write data valid
-  output wire                        s_axi_wready,  // AXI4-Lite slave: Write data ready
-  output reg  [1:0]                  s_axi_bresp,   // AXI4-Lite slave: Write response
-  output reg                         s_axi_bvalid,  // AXI4-Lite slave: Write response valid
-  input  wire                        s_axi_bready,  // AXI4-Lite slave: Write response ready
-  input  wire [AXI_ADDR_WIDTH-1:0]   s_axi_araddr,  // AXI4-Lite slave: Read address
-  input  wire                        s_axi_arvalid, // AXI4-Lite slave: Read address valid
-  output wire                        s_axi_arready, // AXI4-Lite slave: Read address ready
-  output reg  [AXI_DATA_WIDTH-1:0]   s_axi_rdata,   // AXI4-Lite slave: Read data
-  output reg  [1:0]                  s_axi_rresp,   // AXI4-Lite slave: Read data response
-  output reg                         s_axi_rvalid,  // AXI4-Lite slave: Read data valid
-  input  wire                        s_axi_rready,  // AXI4-Lite slave: Read data ready
+  // AXI4 subordinate interface (INCR/FIXED bursts, every beat goes to the FIFO)
+  input  wire [AXI_ID_WIDTH-1:0]     s_axi_awid,    // AXI4 slave: Write address ID
+  input  wire [AXI_ADDR_WIDTH-1:0]   s_axi_awaddr,  // AXI4 slave: Write address
+  input  wire [7:0]                  s_axi_awlen,   // AXI4 slave: Write burst length (beats - 1)
+  input  wire [2:0]                  s_axi_awsize,  // AXI4 slave: Write burst size
+  input  wire [1:0]                  s_axi_awburst, // AXI4 slave: Write burst type
+  input  wire                        s_axi_awvalid, // AXI4 slave: Write address valid
+  output wire                        s_axi_awready, // AXI4 slave: Write address ready
+  input  wire [AXI_DATA_WIDTH-1:0]   s_axi_wdata,   // AXI4 slave: Write data
+  input  wire [AXI_DATA_WIDTH/8-1:0] s_axi_wstrb,   // AXI4 slave: Write strobe
+  input  wire                        s_axi_wlast,   // AXI4 slave: Write last beat
+  input  wire                        s_axi_wvalid,  // AXI4 slave: Write data valid
+  output wire                        s_axi_wready,  // AXI4 slave: Write data ready
+  output reg  [AXI_ID_WIDTH-1:0]     s_axi_bid,     // AXI4 slave: Write response ID
+  output reg  [1:0]                  s_axi_bresp,   // AXI4 slave: Write response
+  output reg                         s_axi_bvalid,  // AXI4 slave: Write response valid
+  input  wire                        s_axi_bready,  // AXI4 slave: Write response ready
+  input  wire [AXI_ID_WIDTH-1:0]     s_axi_arid,    // AXI4 slave: Read address ID
+  input  wire [AXI_ADDR_WIDTH-1:0]   s_axi_araddr,  // AXI4 slave: Read address
+  input  wire [7:0]                  s_axi_arlen,   // AXI4 slave: Read burst length (beats - 1)
+  input  wire [2:0]                  s_axi_arsize,  // AXI4 slave: Read burst size
+  input  wire [1:0]                  s_axi_arburst, // AXI4 slave: Read burst type
+  input  wire                        s_axi_arvalid, // AXI4 slave: Read address valid
+  output wire                        s_axi_arready, // AXI4 slave: Read address ready
+  output reg  [AXI_ID_WIDTH-1:0]     s_axi_rid,     // AXI4 slave: Read data ID
+  output reg  [AXI_DATA_WIDTH-1:0]   s_axi_rdata,   // AXI4 slave: Read data
+  output reg  [1:0]                  s_axi_rresp,   // AXI4 slave: Read data response
+  output reg                         s_axi_rlast,   // AXI4 slave: Read last beat
+  output reg                         s_axi_rvalid,  // AXI4 slave: Read data valid
+  input  wire                        s_axi_rready,  // AXI4 slave: Read data ready
 
   // FIFO write side
   output wire [AXI_DATA_WIDTH-1:0]  fifo_wr_data,
@@ -50,28 +63,41 @@ module axi_fifo_bridge #(
 
 
   //// Write logic
-  // Allow write attempts always (no hanging), but send an error response if the FIFO is full or writes are disabled
-  wire   try_write = s_axi_awvalid && s_axi_wvalid;
-  wire   write_allowed = !fifo_full && ENABLE_WRITE;
-  assign s_axi_awready = 1; // Always ready to accept write requests, not allowed to hang
-  assign s_axi_wready  = 1; // Always ready to accept write data, not allowed to hang
+  // One write burst at a time: accept the address, then take one FIFO word per data beat.
+  // Every beat is accepted (no hanging), but the burst gets an error response if any beat
+  // hit a full FIFO or writes are disabled.
+  reg  w_active;  // Write address accepted, data beats in progress
+  reg  w_error;   // A beat of the current burst was not written
+  wire aw_accept = s_axi_awvalid && s_axi_awready;
+  wire try_write = s_axi_wvalid && s_axi_wready;
+  wire write_allowed = !fifo_full && ENABLE_WRITE;
+  assign s_axi_awready = !w_active && !s_axi_bvalid; // Ready for a new burst once the last response is taken
+  assign s_axi_wready  = w_active;                   // Data beats only inside an accepted burst
   assign fifo_wr_en    = try_write && write_allowed;
   assign fifo_wr_data  = s_axi_wdata;
 
-  // Write response
+  // Burst tracking and write response (one per burst, after the last beat)
   always @(posedge aclk) begin
     if (!wr_resetn) begin
+      w_active <= 1'b0;
+      w_error  <= 1'b0;
+      s_axi_bid <= {AXI_ID_WIDTH{1'b0}};
       s_axi_bvalid <= 1'b0;
       s_axi_bresp  <= 2'b00;
       fifo_overflow <= 1'b0; // Reset overflow flag on reset
     end else begin
-      if (fifo_wr_en) begin
-        s_axi_bvalid <= 1'b1;
-        s_axi_bresp  <= RESP_OKAY;
-      end else if (try_write && !write_allowed) begin
-        s_axi_bvalid <= 1'b1;
-        s_axi_bresp  <= RESP_SLVERR;
-        if (fifo_full) fifo_overflow <= 1'b1; // Indicate overflow if FIFO was trying to write when full
+      if (aw_accept) begin
+        w_active <= 1'b1;
+        w_error  <= 1'b0;
+        s_axi_bid <= s_axi_awid;
+      end else if (try_write) begin
+        if (s_axi_wlast) begin
+          w_active <= 1'b0;
+          s_axi_bvalid <= 1'b1;
+          s_axi_bresp  <= (w_error || !write_allowed) ? RESP_SLVERR : RESP_OKAY;
+        end
+        if (!write_allowed) w_error <= 1'b1;
+        if (!write_allowed && fifo_full) fifo_overflow <= 1'b1; // Indicate overflow if FIFO was trying to write when full
       end else if (s_axi_bready && s_axi_bvalid) begin
         s_axi_bvalid <= 1'b0;
       end
@@ -80,30 +106,49 @@ module axi_fifo_bridge #(
 
 
   //// Read logic:
-  // Allow read attempts always (no hanging), but send an error response if the FIFO is empty or reads are disabled
-  wire   try_read = s_axi_arvalid;
-  wire   read_allowed = !fifo_empty && ENABLE_READ;
-  assign s_axi_arready = 1; // Always ready to accept read requests, not allowed to hang
+  // One read burst at a time: accept the address, then pop one FIFO word per data beat.
+  // Every beat is returned (no hanging), with an error response and zero data if the FIFO
+  // is empty or reads are disabled.
+  reg        r_active;     // Read address accepted, data beats in progress
+  reg  [7:0] r_beats_left; // Beats remaining after the next one
+  wire ar_accept = s_axi_arvalid && s_axi_arready;
+  wire try_read = r_active && (!s_axi_rvalid || s_axi_rready); // Next beat can be presented
+  wire read_allowed = !fifo_empty && ENABLE_READ;
+  assign s_axi_arready = !r_active;
   assign fifo_rd_en    = try_read && read_allowed;
 
   always @(posedge aclk) begin
     if (!rd_resetn) begin
+      r_active <= 1'b0;
+      r_beats_left <= 8'd0;
+      s_axi_rid <= {AXI_ID_WIDTH{1'b0}};
       s_axi_rvalid <= 1'b0;
       s_axi_rresp  <= 2'b00;
+      s_axi_rlast  <= 1'b0;
       s_axi_rdata  <= {AXI_DATA_WIDTH{1'b0}};
       fifo_underflow <= 1'b0; // Reset underflow flag on reset
     end else begin
-      if (fifo_rd_en) begin
-        s_axi_rvalid <= 1'b1;
-        s_axi_rdata  <= fifo_rd_data;
-        s_axi_rresp  <= RESP_OKAY;
-      end else if (try_read && !read_allowed) begin
+      if (ar_accept) begin
+        r_active <= 1'b1;
+        r_beats_left <= s_axi_arlen;
+        s_axi_rid <= s_axi_arid;
+      end
+      if (try_read) begin
         s_axi_rvalid <= 1'b1;
-        s_axi_rdata  <= {AXI_DATA_WIDTH{1'b0}}; // Return zero data on error
-        s_axi_rresp  <= RESP_SLVERR;
-        if (fifo_empty) fifo_underflow <= 1'b1; // Indicate underflow if FIFO was trying to read when empty
+        s_axi_rlast  <= (r_beats_left == 8'd0);
+        if (r_beats_left == 8'd0) r_active <= 1'b0;
+        else r_beats_left <= r_beats_left - 1;
+        if (read_allowed) begin
+          s_axi_rdata  <= fifo_rd_data;
+          s_axi_rresp  <= RESP_OKAY;
+        end else begin
+          s_axi_rdata  <= {AXI_DATA_WIDTH{1'b0}}; // Return zero data on error
+          s_axi_rresp  <= RESP_SLVERR;
+          if (fifo_empty) fifo_underflow <= 1'b1; // Indicate underflow if FIFO was trying to read when empty
+        end
       end else if (s_axi_rready && s_axi_rvalid) begin
         s_axi_rvalid <= 1'b0;
+        s_axi_rlast  <= 1'b0;
       end
     end
   end
@@ -0,0 +1,209 @@
+import cocotb
+from cocotb.clock import Clock
+from cocotb.triggers import RisingEdge, ReadOnly
+from fwft_fifo_model import fwft_fifo_model
+
+
+class axi_fifo_bridge_base:
+
+    RESP_OKAY   = 0
+    RESP_SLVERR = 2
+
+    # AXI burst types
+    BURST_FIXED = 0
+    BURST_INCR  = 1
+
+    def __init__(self, dut, clk_period=4, time_unit='ns'):
+        self.dut = dut
+        self.clk_period = clk_period
+        self.time_unit = time_unit
+
+        # Parameters
+        self.AXI_DATA_WIDTH = int(self.dut.AXI_DATA_WIDTH.value)
+        self.AXI_ID_WIDTH = int(self.dut.AXI_ID_WIDTH.value)
+
+        cocotb.start_soon(Clock(dut.aclk, clk_period, time_unit).start(start_high=False))
+
+        self.dut._log.info(f"AXI_DATA_WIDTH set to {self.AXI_DATA_WIDTH}, AXI_ID_WIDTH set to {self.AXI_ID_WIDTH}")
+
+        # Initialize Input Signals
+        self.dut.s_axi_awid.value = 0
+        self.dut.s_axi_awaddr.value = 0
+        self.dut.s_axi_awlen.value = 0
+        self.dut.s_axi_awsize.value = 2
+        self.dut.s_axi_awburst.value = self.BURST_INCR
+        self.dut.s_axi_awvalid.value = 0
+        self.dut.s_axi_wdata.value = 0
+        self.dut.s_axi_wstrb.value = 0
+        self.dut.s_axi_wlast.value = 0
+        self.dut.s_axi_wvalid.value = 0
+        self.dut.s_axi_bready.value = 0
+        self.dut.s_axi_arid.value = 0
+        self.dut.s_axi_araddr.value = 0
+        self.dut.s_axi_arlen.value = 0
+        self.dut.s_axi_arsize.value = 2
+        self.dut.s_axi_arburst.value = self.BURST_INCR
+        self.dut.s_axi_arvalid.value = 0
+        self.dut.s_axi_rready.value = 0
+        self.dut.fifo_full.value = 0
+        self.dut.fifo_rd_data.value = 0
+        self.dut.fifo_empty.value = 1
+
+        # FIFO models: the write side FIFO the bridge fills, and the read side FIFO it drains
+        self.wr_fifo = fwft_fifo_model(dut, "WR_FIFO_MODEL", DEPTH=512)
+        self.rd_fifo = fwft_fifo_model(dut, "RD_FIFO_MODEL", DEPTH=512)
+
+        # Write responses seen, and data beats accepted before each one
+        self.b_responses = []   # (bid, bresp, beats accepted in the burst)
+        self.w_beats = 0
+
+    async def reset(self):
+        """Reset both paths, hold reset for two clock cycles."""
+        await RisingEdge(self.dut.aclk)
+        self.dut.wr_resetn.value = 0
+        self.dut.rd_resetn.value = 0
+        self.dut._log.info("STARTING RESET")
+        self.wr_fifo.reset()
+        self.rd_fifo.reset()
+        self.b_responses = []
+        self.w_beats = 0
+
+        await RisingEdge(self.dut.aclk)
+        await RisingEdge(self.dut.aclk)
+        self.dut.wr_resetn.value = 1
+        self.dut.rd_resetn.value = 1
+        self.dut._log.info("RESET COMPLETE")
+
+        await ReadOnly()
+        assert int(self.dut.s_axi_bvalid.value) == 0, "Write response valid after reset"
+        assert int(self.dut.s_axi_rvalid.value) == 0, "Read data valid after reset"
+        assert int(self.dut.fifo_overflow.value) == 0, "Overflow not reset"
+        assert int(self.dut.fifo_underflow.value) == 0, "Underflow not reset"
+
+    async def wr_fifo_model(self):
+        """Write side FIFO. Connected to DUT's fifo_wr_en, fifo_wr_data and fifo_full."""
+        while True:
+            await RisingEdge(self.dut.aclk)
+            self.dut.fifo_full.value = 1 if self.wr_fifo.is_full() else 0
+
+            await ReadOnly()
+            if int(self.dut.fifo_wr_en.value) == 1:
+                assert not self.wr_fifo.is_full(), "FIFO written while full"
+                self.wr_fifo.write_item(int(self.dut.fifo_wr_data.value))
+
+    async def rd_fifo_model(self):
+        """Read side FWFT FIFO. Connected to DUT's fifo_rd_en, fifo_rd_data and fifo_empty."""
+        while True:
+            await RisingEdge(self.dut.aclk)
+            self.dut.fifo_empty.value = 1 if self.rd_fifo.is_empty() else 0
+            fwft_data = self.rd_fifo.peek_item() if not self.rd_fifo.is_empty() else None
+            self.dut.fifo_rd_data.value = fwft_data if fwft_data is not None else 0
+
+            await ReadOnly()
+            if int(self.dut.fifo_rd_en.value) == 1:
+                assert not self.rd_fifo.is_empty(), "FIFO read while empty"
+                self.rd_fifo.pop_item()
+
+    async def write_monitor(self):
+        """Count W beats per burst and log each B response with the beats that came before it."""
+        while True:
+            await RisingEdge(self.dut.aclk)
+            await ReadOnly()
+            if int(self.dut.s_axi_wvalid.value) == 1 and int(self.dut.s_axi_wready.value) == 1:
+                self.w_beats += 1
+            if int(self.dut.s_axi_bvalid.value) == 1 and int(self.dut.s_axi_bready.value) == 1:
+                self.b_responses.append((int(self.dut.s_axi_bid.value), int(self.dut.s_axi_bresp.value), self.w_beats))
+                self.w_beats = 0
+
+    async def axi_write_burst(self, words, awid=0, burst=BURST_INCR, wvalid_gaps=0):
+        """
+        AXI4 write burst of len(words) beats, with wvalid_gaps idle cycles between beats.
+        Leaves bready high, so the response is taken as soon as it's valid.
+        """
+        await RisingEdge(self.dut.aclk)
+        self.dut.s_axi_awid.value = awid
+        self.dut.s_axi_awaddr.value = 0
+        self.dut.s_axi_awlen.value = len(words) - 1
+        self.dut.s_axi_awburst.value = burst
+        self.dut.s_axi_awvalid.value = 1
+        self.dut.s_axi_bready.value = 1
+        while True:
+            await ReadOnly()
+            accepted = int(self.dut.s_axi_awready.value) == 1
+            await RisingEdge(self.dut.aclk)
+            if accepted:
+                break
+        self.dut.s_axi_awvalid.value = 0
+
+        for i, word in enumerate(words):
+            self.dut.s_axi_wdata.value = word
+            self.dut.s_axi_wstrb.value = (1 << (self.AXI_DATA_WIDTH // 8)) - 1
+            self.dut.s_axi_wlast.value = 1 if i == len(words) - 1 else 0
+            self.dut.s_axi_wvalid.value = 1
+            while True:
+                await ReadOnly()
+                assert int(self.dut.s_axi_bvalid.value) == 0, f"Write response before the last beat (beat {i})"
+                accepted = int(self.dut.s_axi_wready.value) == 1
+                await RisingEdge(self.dut.aclk)
+                if accepted:
+                    break
+            self.dut.s_axi_wvalid.value = 0
+            self.dut.s_axi_wlast.value = 0
+            for _ in range(wvalid_gaps):
+                await RisingEdge(self.dut.aclk)
+
+    async def wait_for_b_responses(self, count, timeout_cycles=100):
+        """Wait until count write responses have been taken."""
+        for _ in range(timeout_cycles):
+            if len(self.b_responses) >= count:
+                return
+            await RisingEdge(self.dut.aclk)
+        assert False, f"Timed out waiting for {count} write responses, got {len(self.b_responses)}"
+
+    async def axi_read_burst(self, beats, arid=0, burst=BURST_INCR, rready_pattern=None):
+        """
+        AXI4 read burst of the given number of beats. rready_pattern, if given, is a list of rready values
+        cycled one per clock for backpressure. Returns [(data, resp, last, id)] for each beat, and checks
+        nothing more is returned after the beat marked last.
+        """
+        await RisingEdge(self.dut.aclk)
+        self.dut.s_axi_arid.value = arid
+        self.dut.s_axi_araddr.value = 0
+        self.dut.s_axi_arlen.value = beats - 1
+        self.dut.s_axi_arburst.value = burst
+        self.dut.s_axi_arvalid.value = 1
+        while True:
+            await ReadOnly()
+            accepted = int(self.dut.s_axi_arready.value) == 1
+            await RisingEdge(self.dut.aclk)
+            if accepted:
+                break
+        self.dut.s_axi_arvalid.value = 0
+
+        received = []
+        cycle = 0
+        for _ in range(16 * beats + 100):
+            self.dut.s_axi_rready.value = rready_pattern[cycle % len(rready_pattern)] if rready_pattern else 1
+            cycle += 1
+            await ReadOnly()
+            if int(self.dut.s_axi_rvalid.value) == 1 and int(self.dut.s_axi_rready.value) == 1:
+                received.append((int(self.dut.s_axi_rdata.value), int(self.dut.s_axi_rresp.value),
+                                 int(self.dut.s_axi_rlast.value), int(self.dut.s_axi_rid.value)))
+            await RisingEdge(self.dut.aclk)
+            if received and received[-1][2] == 1:
+                break
+        else:
+            assert False, f"Timed out waiting for RLAST, got {len(received)} of {beats} beats"
+        self.dut.s_axi_rready.value = 0
+
+        # No beats after RLAST
+        for _ in range(4):
+            await ReadOnly()
+            assert int(self.dut.s_axi_rvalid.value) == 0, "Read data valid after RLAST"
+            await RisingEdge(self.dut.aclk)
+        return received
+
+    @staticmethod
+    def burst_words(first, count):
+        """Distinct data words for a burst."""
+        return [(0xA5000000 | (first + i)) for i in range(count)]
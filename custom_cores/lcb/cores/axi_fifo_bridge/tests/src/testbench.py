@@ -0,0 +1,176 @@
+import cocotb
+from cocotb.triggers import RisingEdge, ReadOnly
+
+from axi_fifo_bridge_base import axi_fifo_bridge_base
+
+async def setup_testbench(dut, clk_period=4, time_unit='ns'):
+    tb = axi_fifo_bridge_base(dut, clk_period, time_unit)
+    return tb
+
+async def start_models(tb):
+    await tb.reset()
+    return [cocotb.start_soon(tb.wr_fifo_model()), cocotb.start_soon(tb.rd_fifo_model()),
+            cocotb.start_soon(tb.write_monitor())]
+
+# DIRECTED TESTS
+@cocotb.test()
+async def test_reset(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_reset")
+
+    await tb.reset()
+
+    # Give time before ending the test
+    await RisingEdge(dut.aclk)
+    await RisingEdge(dut.aclk)
+
+@cocotb.test()
+async def test_write_bursts(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_write_bursts")
+    tasks = await start_models(tb)
+
+    # Single beat, short, 16 beat and maximum (256 beat) bursts, some with gaps between beats,
+    # and a FIXED burst (the address is ignored, so every beat still goes to the FIFO)
+    bursts = [(1, tb.BURST_INCR, 0), (4, tb.BURST_INCR, 2), (16, tb.BURST_INCR, 0),
+              (256, tb.BURST_INCR, 0), (8, tb.BURST_FIXED, 1)]
+    expected = []
+    for i, (beats, burst, gaps) in enumerate(bursts):
+        words = tb.burst_words(len(expected), beats)
+        await tb.axi_write_burst(words, awid=0x100 + i, burst=burst, wvalid_gaps=gaps)
+        expected += words
+    await tb.wait_for_b_responses(len(bursts))
+
+    assert list(tb.wr_fifo.fifo) == expected, "FIFO contents don't match the beats written"
+    # One OKAY response per burst, with the burst's ID, after exactly its beats
+    for i, (beats, _, _) in enumerate(bursts):
+        assert tb.b_responses[i] == (0x100 + i, tb.RESP_OKAY, beats), \
+            f"Burst {i}: expected (ID {0x100 + i:#x}, OKAY, {beats} beats), got {tb.b_responses[i]}"
+    assert int(dut.fifo_overflow.value) == 0, "Unexpected overflow"
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_write_response_backpressure(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_write_response_backpressure")
+    tasks = await start_models(tb)
+
+    # With the response not taken, the next burst's address has to wait for it
+    await tb.axi_write_burst(tb.burst_words(0, 3), awid=1)
+    dut.s_axi_bready.value = 0
+    for _ in range(10):
+        await RisingEdge(dut.aclk)
+        await ReadOnly()
+        if int(dut.s_axi_bvalid.value) == 1:
+            break
+    assert int(dut.s_axi_bvalid.value) == 1, "No write response after WLAST"
+    assert int(dut.s_axi_awready.value) == 0, "Next write address accepted with a response pending"
+    for _ in range(5):
+        await RisingEdge(dut.aclk)
+        await ReadOnly()
+        assert int(dut.s_axi_bvalid.value) == 1, "Write response dropped before it was taken"
+        assert int(dut.s_axi_awready.value) == 0, "Next write address accepted with a response pending"
+
+    # axi_write_burst raises bready again, so the response is taken and the next burst goes through
+    await tb.axi_write_burst(tb.burst_words(3, 2), awid=2)
+    await tb.wait_for_b_responses(2)
+    assert [(bid, bresp) for bid, bresp, _ in tb.b_responses] == [(1, tb.RESP_OKAY), (2, tb.RESP_OKAY)], \
+        f"Unexpected write responses {tb.b_responses}"
+    assert list(tb.wr_fifo.fifo) == tb.burst_words(0, 5), "FIFO contents don't match the beats written"
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_write_full_fifo(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_write_full_fifo")
+    tasks = await start_models(tb)
+
+    # A burst that runs into a full FIFO: every beat is accepted, the ones past full are lost,
+    # and the whole burst gets SLVERR
+    tb.wr_fifo.DEPTH = 6
+    words = tb.burst_words(0, 10)
+    await tb.axi_write_burst(words, awid=7)
+    await tb.wait_for_b_responses(1)
+    assert list(tb.wr_fifo.fifo) == words[:6], "Expected only the words that fit in the FIFO"
+    assert tb.b_responses[0] == (7, tb.RESP_SLVERR, 10), f"Expected (7, SLVERR, 10 beats), got {tb.b_responses[0]}"
+    assert int(dut.fifo_overflow.value) == 1, "Overflow not set"
+
+    # Once there's room again, bursts are OKAY (overflow stays set until reset)
+    tb.wr_fifo.reset()
+    await tb.axi_write_burst(tb.burst_words(10, 4), awid=8)
+    await tb.wait_for_b_responses(2)
+    assert tb.b_responses[1] == (8, tb.RESP_OKAY, 4), f"Expected (8, OKAY, 4 beats), got {tb.b_responses[1]}"
+    assert list(tb.wr_fifo.fifo) == tb.burst_words(10, 4), "FIFO contents don't match the beats written"
+    assert int(dut.fifo_overflow.value) == 1, "Overflow cleared without a reset"
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_read_bursts(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_read_bursts")
+    tasks = await start_models(tb)
+
+    # Bursts of several lengths, with and without backpressure on rready
+    bursts = [(1, None), (4, None), (16, [1, 0, 0, 1]), (256, None), (8, [0, 1])]
+    words = tb.burst_words(0, sum(beats for beats, _ in bursts))
+    for word in words:
+        tb.rd_fifo.write_item(word)
+
+    first = 0
+    for i, (beats, rready_pattern) in enumerate(bursts):
+        received = await tb.axi_read_burst(beats, arid=0x200 + i, rready_pattern=rready_pattern)
+        assert len(received) == beats, f"Burst {i}: expected {beats} beats, got {len(received)}"
+        assert [data for data, _, _, _ in received] == words[first:first + beats], f"Burst {i}: wrong data"
+        assert all(resp == tb.RESP_OKAY for _, resp, _, _ in received), f"Burst {i}: unexpected error response"
+        assert [last for _, _, last, _ in received] == [0] * (beats - 1) + [1], f"Burst {i}: RLAST not only on the last beat"
+        assert all(rid == 0x200 + i for _, _, _, rid in received), f"Burst {i}: wrong RID"
+        first += beats
+    assert tb.rd_fifo.is_empty(), "Words left in the FIFO"
+    assert int(dut.fifo_underflow.value) == 0, "Unexpected underflow"
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_read_empty_fifo(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_read_empty_fifo")
+    tasks = await start_models(tb)
+
+    # Reading an empty FIFO still returns every beat, as zero data with SLVERR, and ends with RLAST
+    received = await tb.axi_read_burst(4, arid=3)
+    assert received == [(0, tb.RESP_SLVERR, 0, 3)] * 3 + [(0, tb.RESP_SLVERR, 1, 3)], \
+        f"Unexpected beats from an empty FIFO: {received}"
+    assert int(dut.fifo_underflow.value) == 1, "Underflow not set"
+
+    # A FIFO that runs empty mid-burst: OKAY beats until it's empty, then SLVERR
+    words = tb.burst_words(0, 2)
+    for word in words:
+        tb.rd_fifo.write_item(word)
+    received = await tb.axi_read_burst(5, arid=4, rready_pattern=[1, 0])
+    expected = [(words[0], tb.RESP_OKAY, 0, 4), (words[1], tb.RESP_OKAY, 0, 4),
+                (0, tb.RESP_SLVERR, 0, 4), (0, tb.RESP_SLVERR, 0, 4), (0, tb.RESP_SLVERR, 1, 4)]
+    assert received == expected, f"Expected {expected}, got {received}"
+
+    # The next burst with data in the FIFO is back to OKAY (underflow stays set until reset)
+    tb.rd_fifo.write_item(0x12345678)
+    received = await tb.axi_read_burst(1, arid=5)
+    assert received == [(0x12345678, tb.RESP_OKAY, 1, 5)], f"Unexpected beat {received}"
+    assert int(dut.fifo_underflow.value) == 1, "Underflow cleared without a reset"
+
+    # The read path reset clears it
+    await RisingEdge(dut.aclk)
+    dut.rd_resetn.value = 0
+    await RisingEdge(dut.aclk)
+    dut.rd_resetn.value = 1
+    await ReadOnly()
+    assert int(dut.fifo_underflow.value) == 0, "Read reset didn't clear underflow"
+
+    for task in tasks:
+        task.kill()
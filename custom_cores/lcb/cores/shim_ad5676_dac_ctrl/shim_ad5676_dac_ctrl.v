@@ -1,7 +1,8 @@
 `timescale 1 ns / 1 ps
 
 module shim_ad5676_dac_ctrl #(
-  parameter ABS_CAL_MAX = 16'd4096 // Maximum absolute calibration value
+  parameter ABS_CAL_MAX = 16'd4096, // Maximum absolute calibration value
+  parameter LOOP_ADDR_WIDTH = 8 // Loop block buffer depth is 2^LOOP_ADDR_WIDTH words (max 9)
 )(
   input  wire        clk,
   input  wire        resetn,
@@ -92,6 +93,7 @@ module shim_ad5676_dac_ctrl #(
   localparam CMD_DAC_WR_CH = 3'd3;
   localparam CMD_GET_CAL   = 3'd4;
   localparam CMD_ZERO      = 3'd5;
+  localparam CMD_LOOP      = 3'd6;
   localparam CMD_CANCEL    = 3'd7;
 
   // Command bit positions
@@ -99,6 +101,12 @@ module shim_ad5676_dac_ctrl #(
   localparam CONT_BIT = 27;
   localparam LDAC_BIT = 26;
 
+  // Loop command fields (block length in words, and passes with 0 repeating until cancelled)
+  localparam LOOP_LEN_LSB    = 16;
+  localparam LOOP_LEN_MSB    = 25;
+  localparam LOOP_PASSES_MSB = 15;
+  localparam integer LOOP_DEPTH = 1 << LOOP_ADDR_WIDTH;
+
   // DAC loading stages
   localparam DAC_LOAD_STAGE_INIT = 2'b00;
   localparam DAC_LOAD_STAGE_CAL  = 2'b01;
@@ -141,6 +149,24 @@ module shim_ad5676_dac_ctrl #(
   reg  signed [15:0] cal_val [0:7];
   wire [15:0] cal_midrange [0:7];
 
+  //// ---- Command source and loop block buffer
+  // Command word source (command buffer, or the loop buffer while replaying)
+  wire [31:0] src_word;
+  wire        src_empty;
+  wire        src_rd_en;
+  // Loop block buffer
+  reg  [31:0] loop_mem [0:LOOP_DEPTH-1];
+  reg         loop_capture; // First pass of the block, copied from the command buffer as it's read
+  reg         loop_replay; // Later passes, read from the loop buffer
+  reg         loop_forever;
+  reg  [15:0] loop_passes_left;
+  reg  [LOOP_ADDR_WIDTH:0] loop_len;
+  reg  [LOOP_ADDR_WIDTH-1:0] loop_ptr;
+  wire        loop_ptr_last;
+  wire        loop_cmd_valid;
+  wire        loop_break;
+  wire        loop_src;
+
   //// ---- Calibrated DAC value calculation
   reg         load_pair;
   reg  [1:0]  dac_load_stage;
@@ -200,11 +226,12 @@ module shim_ad5676_dac_ctrl #(
   ///////////////////////////////////////////////////////////////////////////////
 
   //// ---- Command word
-  assign cmd_word = cmd_buf_empty ? 32'd0 : cmd_buf_word;
+  assign cmd_word = src_empty ? 32'd0 : src_word;
   assign command = cmd_word[31:29];
-  assign next_cmd_ready = !cmd_buf_empty;
-  // Command word read enable
-  assign cmd_buf_rd_en = (state != S_ERROR) && next_cmd_ready && (read_next_dac_val_pair || cmd_done || cancel_wait);
+  assign next_cmd_ready = !src_empty;
+  // Command word read enable (the command buffer is only read when not replaying a loop)
+  assign src_rd_en = (state != S_ERROR) && next_cmd_ready && (read_next_dac_val_pair || cmd_done || cancel_wait);
+  assign cmd_buf_rd_en = src_rd_en && !loop_src;
   // Command bits processing
   always @(posedge clk) begin
     if (!resetn || state == S_ERROR) begin
@@ -257,6 +284,7 @@ module shim_ad5676_dac_ctrl #(
                           : (command == CMD_CANCEL) ? S_IDLE // If command is CANCEL, go to IDLE 
                           : (command == CMD_GET_CAL) ? S_IDLE // If command is GET_CAL, go to IDLE
                           : (command == CMD_ZERO) ? S_SET_MID // If command is ZERO, go to SET_MID to set all channels to midrange
+                          : (command == CMD_LOOP) ? (loop_cmd_valid ? S_IDLE : S_ERROR) // If command is LOOP, go to IDLE (error if nested or the block doesn't fit)
                           : S_ERROR; // If command is not recognized, go to ERROR state
   // Waiting for trigger flag
   assign waiting_for_trig = (state == S_TRIG_WAIT);
@@ -286,6 +314,53 @@ module shim_ad5676_dac_ctrl #(
   end
 
 
+  //// ---- Loop block
+  // LOOP marks the next block of command words (including DAC_WR data words) to be run a number of passes.
+  // The first pass is read from the command buffer and copied into the loop buffer; the rest replay from it.
+  assign loop_cmd_valid = !loop_capture && !loop_replay
+                          && cmd_word[LOOP_LEN_MSB:LOOP_LEN_LSB] != 0
+                          && cmd_word[LOOP_LEN_MSB:LOOP_LEN_LSB] <= LOOP_DEPTH;
+  assign loop_ptr_last = ({1'b0, loop_ptr} == loop_len - 1);
+  // A CANCEL waiting in the command buffer breaks out of a replay at the next point a cancel is accepted
+  assign loop_break = loop_replay && !cmd_buf_empty && cmd_buf_word[31:29] == CMD_CANCEL
+                      && (state == S_IDLE || state == S_DELAY || state == S_TRIG_WAIT || (state == S_DAC_WR && dac_wr_done));
+  assign loop_src = loop_replay && !loop_break;
+  assign src_word = loop_src ? loop_mem[loop_ptr] : cmd_buf_word;
+  assign src_empty = loop_src ? 1'b0 : cmd_buf_empty;
+  // Loop control
+  always @(posedge clk) begin
+    if (!resetn || state == S_ERROR || cancel_wait || (do_next_cmd && command == CMD_CANCEL)) begin
+      loop_capture <= 1'b0;
+      loop_replay <= 1'b0;
+      loop_forever <= 1'b0;
+      loop_passes_left <= 16'd0;
+      loop_len <= 0;
+      loop_ptr <= 0;
+    end else if (do_next_cmd && command == CMD_LOOP) begin
+      loop_capture <= 1'b1;
+      loop_forever <= (cmd_word[LOOP_PASSES_MSB:0] == 16'd0);
+      loop_passes_left <= cmd_word[LOOP_PASSES_MSB:0] - 1; // Passes after the first
+      loop_len <= cmd_word[LOOP_LEN_LSB+LOOP_ADDR_WIDTH:LOOP_LEN_LSB];
+      loop_ptr <= 0;
+    end else if (src_rd_en && (loop_capture || loop_src)) begin
+      loop_ptr <= loop_ptr_last ? 0 : loop_ptr + 1;
+      if (loop_ptr_last) begin
+        if (loop_capture) begin // First pass done, replay if there are passes left
+          loop_capture <= 1'b0;
+          loop_replay <= loop_forever || (loop_passes_left != 0);
+        end else if (!loop_forever) begin // Replay pass done, go back to the command buffer after the last one
+          loop_passes_left <= loop_passes_left - 1;
+          loop_replay <= (loop_passes_left != 1);
+        end
+      end
+    end
+  end
+  // Copy the first pass into the loop buffer
+  always @(posedge clk) begin
+    if (src_rd_en && loop_capture) loop_mem[loop_ptr] <= cmd_buf_word;
+  end
+
+
   //// ---- Delay timer
   always @(posedge clk) begin
     if (!resetn || state == S_ERROR || cancel_wait) delay_timer <= 25'd0;
@@ -0,0 +1,168 @@
+import cocotb
+from cocotb.triggers import RisingEdge, ReadOnly
+
+from shim_ad5676_dac_ctrl_base import shim_ad5676_dac_ctrl_base
+
+# Delay after a DAC_WR, long enough for the 4 SPI pair writes to finish
+DAC_WR_DELAY = 500
+
+async def setup_testbench(dut, clk_period=4, time_unit='ns'):
+    tb = shim_ad5676_dac_ctrl_base(dut, clk_period, time_unit)
+    return tb
+
+def ramp_values(step):
+    """Offset-format channel values for one step of a test waveform."""
+    return [0x8000 + 16 * step + ch for ch in range(8)]
+
+# DIRECTED TESTS
+@cocotb.test()
+async def test_reset(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_reset")
+
+    # Reset the DUT
+    await tb.reset()
+
+    # Give time before ending the test
+    await RisingEdge(dut.clk)
+    await RisingEdge(dut.clk)
+
+@cocotb.test()
+async def test_loop_replays_block(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_loop_replays_block")
+
+    await tb.reset()
+    cmd_buf_task = cocotb.start_soon(tb.command_buf_model())
+
+    # Two DAC writes and a delay, run 3 times, then a final delay
+    passes = 3
+    block = tb.dac_wr(ramp_values(0), DAC_WR_DELAY, cont=True) \
+            + tb.dac_wr(ramp_values(1), DAC_WR_DELAY, cont=True) \
+            + [tb.noop(100, cont=True)]
+    cmd_list = [tb.loop(len(block), passes)] + block + [tb.noop(10)]
+    tb.load_commands(cmd_list)
+
+    await tb.wait_for_idle()
+
+    # The block is only read from the command buffer once
+    assert tb.words_read == len(cmd_list), f"Expected {len(cmd_list)} command buffer reads, got {tb.words_read}"
+    assert tb.words_replayed == (passes - 1) * len(block), \
+        f"Expected {(passes - 1) * len(block)} replayed words, got {tb.words_replayed}"
+    # Every pass updates the DAC twice
+    assert tb.ldac_pulses == 2 * passes, f"Expected {2 * passes} LDAC pulses, got {tb.ldac_pulses}"
+    tb.assert_no_errors()
+
+    # The last replayed values are on the outputs
+    expected = [abs(v - 0x8000) for v in ramp_values(1)]
+    abs_vals = int(dut.abs_dac_val_concat.value)
+    for ch in range(8):
+        got = (abs_vals >> (15 * ch)) & 0x7FFF
+        assert got == expected[ch], f"Channel {ch}: expected |value| {expected[ch]}, got {got}"
+
+    cmd_buf_task.kill()
+
+@cocotb.test()
+async def test_loop_single_pass(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_loop_single_pass")
+
+    await tb.reset()
+    cmd_buf_task = cocotb.start_soon(tb.command_buf_model())
+
+    # One pass runs the block once, straight from the command buffer
+    block = tb.dac_wr(ramp_values(2), DAC_WR_DELAY, cont=True) + [tb.noop(20)]
+    cmd_list = [tb.loop(len(block), 1)] + block
+    tb.load_commands(cmd_list)
+
+    await tb.wait_for_idle()
+
+    assert tb.words_read == len(cmd_list), f"Expected {len(cmd_list)} command buffer reads, got {tb.words_read}"
+    assert tb.words_replayed == 0, f"Expected no replayed words, got {tb.words_replayed}"
+    assert tb.ldac_pulses == 1, f"Expected 1 LDAC pulse, got {tb.ldac_pulses}"
+    tb.assert_no_errors()
+
+    cmd_buf_task.kill()
+
+@cocotb.test()
+async def test_loop_full_buffer(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_loop_full_buffer")
+
+    await tb.reset()
+    cmd_buf_task = cocotb.start_soon(tb.command_buf_model())
+
+    # A block that fills the loop buffer exactly
+    block = [tb.noop(8, cont=True) for _ in range(tb.LOOP_DEPTH)]
+    passes = 2
+    cmd_list = [tb.loop(len(block), passes)] + block + [tb.noop(1)]
+    tb.load_commands(cmd_list)
+
+    await tb.wait_for_idle()
+
+    assert tb.words_read == len(cmd_list), f"Expected {len(cmd_list)} command buffer reads, got {tb.words_read}"
+    assert tb.words_replayed == (passes - 1) * len(block), \
+        f"Expected {(passes - 1) * len(block)} replayed words, got {tb.words_replayed}"
+    tb.assert_no_errors()
+
+    cmd_buf_task.kill()
+
+@cocotb.test()
+async def test_loop_forever_cancel(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_loop_forever_cancel")
+
+    await tb.reset()
+    cmd_buf_task = cocotb.start_soon(tb.command_buf_model())
+
+    # Zero passes repeats until cancelled, with no command buffer reads after the first pass
+    block = [tb.noop(20, cont=True)]
+    tb.load_commands([tb.loop(len(block), 0)] + block)
+    for _ in range(1000):
+        await RisingEdge(dut.clk)
+    await ReadOnly()
+    assert tb.words_read == 2, f"Expected 2 command buffer reads, got {tb.words_read}"
+    assert tb.words_replayed > 30, f"Expected the block to keep replaying, got {tb.words_replayed} replayed words"
+    assert int(dut.loop_replay.value) == 1, "Expected the loop to still be replaying"
+    tb.assert_no_errors()
+
+    # A CANCEL ends the delay and the loop
+    await RisingEdge(dut.clk)
+    tb.load_commands([tb.cancel()])
+    await tb.wait_for_idle(timeout_cycles=100)
+    replayed = tb.words_replayed
+    for _ in range(100):
+        await RisingEdge(dut.clk)
+    await ReadOnly()
+    assert tb.words_read == 3, f"Expected 3 command buffer reads, got {tb.words_read}"
+    assert tb.words_replayed == replayed, "Loop kept replaying after the CANCEL"
+    assert int(dut.state.value) == 6, f"Expected S_IDLE after cancel, got {tb.get_state_name(dut.state.value)}"
+    tb.assert_no_errors()
+
+    cmd_buf_task.kill()
+
+@cocotb.test()
+async def test_loop_bad_commands(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_loop_bad_commands")
+
+    cmd_buf_task = cocotb.start_soon(tb.command_buf_model())
+
+    bad_cmd_lists = {
+        "empty block": [tb.loop(0, 2)],
+        "block larger than the loop buffer": [tb.loop(tb.LOOP_DEPTH + 1, 2)],
+        "nested loop": [tb.loop(3, 2), tb.noop(10, cont=True), tb.loop(1, 2), tb.noop(10)],
+    }
+    for name, cmd_list in bad_cmd_lists.items():
+        tb.dut._log.info(f"Checking bad LOOP: {name}")
+        await tb.reset()
+        tb.load_commands(cmd_list)
+        for _ in range(100):
+            await RisingEdge(dut.clk)
+            await ReadOnly()
+            if int(dut.state.value) == 15:
+                break
+        assert int(dut.state.value) == 15, f"{name}: expected S_ERROR, got {tb.get_state_name(dut.state.value)}"
+        assert int(dut.bad_cmd.value) == 1, f"{name}: expected bad_cmd"
+
+    cmd_buf_task.kill()
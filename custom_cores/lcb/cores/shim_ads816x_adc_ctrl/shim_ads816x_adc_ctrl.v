@@ -1,6 +1,9 @@
 `timescale 1ns / 1ps
 
-module shim_ads816x_adc_ctrl (
+module shim_ads816x_adc_ctrl #(
+  parameter LOOP_ADDR_WIDTH = 8, // Loop block buffer depth is 2^LOOP_ADDR_WIDTH words (max 9)
+  parameter BOARD_ID = 0 // Board index (0-7) reported in frame marker words
+)(
   input  wire        clk,
   input  wire        resetn,
 
@@ -76,6 +79,9 @@ module shim_ads816x_adc_ctrl (
   localparam CMD_SET_ORD   = 3'd1;
   localparam CMD_ADC_RD    = 3'd2;
   localparam CMD_ADC_RD_CH = 3'd3;
+  localparam CMD_SET_AVG   = 3'd4;
+  localparam CMD_SET_FRAME = 3'd5;
+  localparam CMD_LOOP      = 3'd6;
   localparam CMD_CANCEL    = 3'd7;
 
   // Command bit positions
@@ -83,6 +89,21 @@ module shim_ads816x_adc_ctrl (
   localparam CONT_BIT = 27;
   localparam REPEAT_BIT = 26;
 
+  // Loop command fields (block length in words, and passes with 0 repeating until cancelled)
+  localparam LOOP_LEN_LSB    = 16;
+  localparam LOOP_LEN_MSB    = 25;
+  localparam LOOP_PASSES_MSB = 15;
+  localparam integer LOOP_DEPTH = 1 << LOOP_ADDR_WIDTH;
+
+  // Averaging (SET_AVG [3:0] is log2 of the reads per channel, up to 256 reads)
+  localparam AVG_LOG2_MAX = 4'd8;
+
+  // Framing (SET_FRAME [15:0] is the number of data words per frame, 0 turns framing off, up to 511)
+  // Marker word: {tag[3:0], board[2:0], drops[8:0], sequence[15:0]}
+  localparam FRAME_LEN_MAX = 16'd511;
+  localparam FRAME_MARKER_TAG = 4'hA;
+  localparam [2:0] FRAME_BOARD_ID = BOARD_ID;
+
   // Debug codes
   localparam DBG_MISO_DATA       = 4'd1;
   localparam DBG_STATE_TRANSITION= 4'd2;
@@ -124,6 +145,37 @@ module shim_ads816x_adc_ctrl (
   reg  [24:0] delay_timer, trigger_counter;
   // ADC sample order
   reg  [ 2:0] sample_order [0:7];
+  // ADC averaging (log2 of the reads per channel)
+  reg  [ 3:0] avg_log2;
+  // Framing
+  reg  [ 8:0] frame_len; // Data words per frame (0 = framing off)
+  reg  [ 8:0] frame_word_count; // Data words so far in the current frame
+  reg  [ 8:0] frame_drops; // Data words dropped so far in the current frame
+  reg  [15:0] frame_seq; // Sequence number of the current frame
+  reg  [15:0] marker_seq; // Pending marker's sequence number
+  reg  [ 8:0] marker_drops; // Pending marker's drop count
+  reg         frame_marker_pending;
+  wire        framing;
+  wire        frame_sample;
+  wire        frame_sample_dropped;
+
+  //// ---- Command source and loop block buffer
+  // Command word source (command buffer, or the loop buffer while replaying)
+  wire [31:0] src_word;
+  wire        src_empty;
+  wire        src_rd_en;
+  // Loop block buffer
+  reg  [31:0] loop_mem [0:LOOP_DEPTH-1];
+  reg         loop_capture; // First pass of the block, copied from the command buffer as it's read
+  reg         loop_replay; // Later passes, read from the loop buffer
+  reg         loop_forever;
+  reg  [15:0] loop_passes_left;
+  reg  [LOOP_ADDR_WIDTH:0] loop_len;
+  reg  [LOOP_ADDR_WIDTH-1:0] loop_ptr;
+  wire        loop_ptr_last;
+  wire        loop_cmd_valid;
+  wire        loop_break;
+  wire        loop_src;
 
 
   //// ---- ADC MOSI SPI control
@@ -139,6 +191,11 @@ module shim_ads816x_adc_ctrl (
   reg  [ 7:0] n_cs_high_time_latched;
   // SPI word index and bit counter
   reg  [ 3:0] adc_word_idx;
+  wire [ 2:0] next_slot;
+  // Averaging passes over the channels (averaging latched at the start of each ADC_RD)
+  reg  [ 3:0] rd_avg_log2;
+  reg  [ 7:0] adc_round;
+  wire        last_adc_round;
   reg  [ 4:0] spi_bit;
   reg         running_spi_bit;
   // SPI MOSI shift register
@@ -160,12 +217,24 @@ module shim_ads816x_adc_ctrl (
   // MISO data storage
   reg  [15:0] miso_data_storage;
   reg         miso_stored;
+  // Averaging accumulators (one per sample slot)
+  wire        adc_sample_valid;
+  reg  [23:0] acc [0:7];
+  reg  [ 2:0] acc_slot;
+  reg  [ 7:0] acc_round;
+  reg  [ 3:0] acc_shift;
+  wire [ 3:0] acc_shift_cur;
+  wire        acc_last_round;
+  wire [23:0] acc_sum;
+  wire [23:0] acc_avg;
+  wire [15:0] avg_data;
 
 
   //// ---- Data buffer write signals
   reg  [ 2:0] single_reads;
   wire        adc_pair_data_ready;
   wire        adc_ch_data_ready;
+  wire        frame_marker_ready;
   wire        debug_miso_data;
   wire        debug_state_transition;
   reg         debug_repeat_bit;
@@ -181,19 +250,20 @@ module shim_ads816x_adc_ctrl (
 
   //// ---- Command word processing
   always @(posedge clk) begin
-    if (cmd_buf_rd_en) prev_cmd_buf_word <= cmd_buf_word;
+    if (src_rd_en) prev_cmd_buf_word <= src_word;
   end
   assign cmd_word = (repeating) ? repeat_cmd_word
-                    : cmd_buf_empty ? 32'd0
-                    : cmd_buf_word;
+                    : src_empty ? 32'd0
+                    : src_word;
   assign command =  cmd_word[31:29];
   assign next_cmd_ready = start_repeat  ? 1'b0
                           : (repeating) ? 1'b1
-                          : !cmd_buf_empty;
+                          : !src_empty;
   // Allow a cancel command to cancel a repeat
   assign cancel_repeat = (repeat_counter > 0 && !cmd_buf_empty && cmd_buf_word[31:29] == CMD_CANCEL);
-  // Command word read enable
-  assign cmd_buf_rd_en = (state != S_ERROR) && !cmd_buf_empty && !repeating && (cmd_done || cancel_wait || start_repeat);
+  // Command word read enable (the command buffer is only read when not replaying a loop)
+  assign src_rd_en = (state != S_ERROR) && !src_empty && !repeating && (cmd_done || cancel_wait || start_repeat);
+  assign cmd_buf_rd_en = src_rd_en && !loop_src;
   // Command bits processing
   always @(posedge clk) begin
     if (!resetn || state == S_ERROR) begin
@@ -239,7 +309,10 @@ module shim_ads816x_adc_ctrl (
                           : (command == CMD_SET_ORD) ? S_IDLE // If command is SET_ORD, go to IDLE
                           : (command == CMD_ADC_RD) ? S_ADC_RD // If command is ADC read, go to ADC read state
                           : (command == CMD_ADC_RD_CH) ? S_ADC_RD_CH // If command is single-channel ADC read, go to ADC read state
+                          : (command == CMD_SET_AVG) ? ((cmd_word[3:0] <= AVG_LOG2_MAX) ? S_IDLE : S_ERROR) // If command is SET_AVG, go to IDLE (error if over 256 reads)
+                          : (command == CMD_SET_FRAME) ? ((cmd_word[15:0] <= FRAME_LEN_MAX) ? S_IDLE : S_ERROR) // If command is SET_FRAME, go to IDLE (error if the frame is too long)
                           : (command == CMD_CANCEL) ? S_IDLE // If command is CANCEL, go to IDLE
+                          : (command == CMD_LOOP) ? (loop_cmd_valid ? S_IDLE : S_ERROR) // If command is LOOP, go to IDLE (error if nested or the block doesn't fit)
                           : S_ERROR; // If command is unrecognized, go to ERROR state
   // Signal indicating the core is waiting for a trigger
   assign waiting_for_trig = (state == S_TRIG_WAIT);
@@ -283,10 +356,57 @@ module shim_ads816x_adc_ctrl (
   always @(posedge clk) begin
     if (!resetn || state == S_ERROR) repeat_counter <= 32'd0;
     else if (repeating && cmd_done) repeat_counter <= repeat_counter - 1;
-    else if (start_repeat) repeat_counter <= cmd_buf_word[31:0];
+    else if (start_repeat) repeat_counter <= src_word[31:0];
   end 
 
 
+  //// ---- Loop block
+  // LOOP marks the next block of command words (including repeat counts) to be run a number of passes.
+  // The first pass is read from the command buffer and copied into the loop buffer; the rest replay from it.
+  assign loop_cmd_valid = !loop_capture && !loop_replay
+                          && cmd_word[LOOP_LEN_MSB:LOOP_LEN_LSB] != 0
+                          && cmd_word[LOOP_LEN_MSB:LOOP_LEN_LSB] <= LOOP_DEPTH;
+  assign loop_ptr_last = ({1'b0, loop_ptr} == loop_len - 1);
+  // A CANCEL waiting in the command buffer breaks out of a replay at the next point a cancel is accepted
+  assign loop_break = loop_replay && !cmd_buf_empty && cmd_buf_word[31:29] == CMD_CANCEL && !repeating && !start_repeat
+                      && (state == S_IDLE || state == S_DELAY || state == S_TRIG_WAIT || (state == S_ADC_RD && adc_rd_done));
+  assign loop_src = loop_replay && !loop_break;
+  assign src_word = loop_src ? loop_mem[loop_ptr] : cmd_buf_word;
+  assign src_empty = loop_src ? 1'b0 : cmd_buf_empty;
+  // Loop control
+  always @(posedge clk) begin
+    if (!resetn || state == S_ERROR || cancel_wait || (do_next_cmd && command == CMD_CANCEL)) begin
+      loop_capture <= 1'b0;
+      loop_replay <= 1'b0;
+      loop_forever <= 1'b0;
+      loop_passes_left <= 16'd0;
+      loop_len <= 0;
+      loop_ptr <= 0;
+    end else if (do_next_cmd && command == CMD_LOOP) begin
+      loop_capture <= 1'b1;
+      loop_forever <= (cmd_word[LOOP_PASSES_MSB:0] == 16'd0);
+      loop_passes_left <= cmd_word[LOOP_PASSES_MSB:0] - 1; // Passes after the first
+      loop_len <= cmd_word[LOOP_LEN_LSB+LOOP_ADDR_WIDTH:LOOP_LEN_LSB];
+      loop_ptr <= 0;
+    end else if (src_rd_en && (loop_capture || loop_src)) begin
+      loop_ptr <= loop_ptr_last ? 0 : loop_ptr + 1;
+      if (loop_ptr_last) begin
+        if (loop_capture) begin // First pass done, replay if there are passes left
+          loop_capture <= 1'b0;
+          loop_replay <= loop_forever || (loop_passes_left != 0);
+        end else if (!loop_forever) begin // Replay pass done, go back to the command buffer after the last one
+          loop_passes_left <= loop_passes_left - 1;
+          loop_replay <= (loop_passes_left != 1);
+        end
+      end
+    end
+  end
+  // Copy the first pass into the loop buffer
+  always @(posedge clk) begin
+    if (src_rd_en && loop_capture) loop_mem[loop_ptr] <= cmd_buf_word;
+  end
+
+
   //// ---- Delay timer
   always @(posedge clk) begin
     if (!resetn || state == S_ERROR || cancel_wait) delay_timer <= 25'd0;
@@ -322,8 +442,8 @@ module shim_ads816x_adc_ctrl (
                  || (state == S_ADC_RD && !adc_rd_done && !wait_for_trig && delay_wait_done) // Delay too short
                  || (do_next_cmd && next_cmd_state == S_ERROR) // Bad command
                  || (cmd_done && expect_next && !next_cmd_ready) // Command buffer underflow
-                 || (start_repeat && cmd_buf_empty) // Command buffer underflow on repeat start
-                 || (try_data_write && data_buf_full); // Data buffer overflow
+                 || (start_repeat && src_empty) // Command buffer underflow on repeat start
+                 || (try_data_write && data_buf_full && !framing); // Data buffer overflow (words are dropped and counted instead when framing)
   // Boot check fail
   assign boot_readback_match = (miso_data_mosi_clk[15:8] == SET_OTF_CFG_DATA); // Readback matches the test value
   always @(posedge clk) begin
@@ -348,13 +468,13 @@ module shim_ads816x_adc_ctrl (
   // Command buffer underflow
   always @(posedge clk) begin
     if (!resetn) cmd_buf_underflow <= 1'b0;
-    else if ((cmd_done && expect_next && !next_cmd_ready) || (start_repeat && cmd_buf_empty))
+    else if ((cmd_done && expect_next && !next_cmd_ready) || (start_repeat && src_empty))
       cmd_buf_underflow <= 1'b1;
   end
   // Data buffer overflow
   always @(posedge clk) begin
     if (!resetn) data_buf_overflow <= 1'b0;
-    else if (try_data_write && data_buf_full) data_buf_overflow <= 1'b1;
+    else if (try_data_write && data_buf_full && !framing) data_buf_overflow <= 1'b1;
   end
 
 
@@ -378,8 +498,32 @@ module shim_ads816x_adc_ctrl (
   end
 
 
+  //// ---- Averaging
+  // Set the reads per channel with the CMD_SET_AVG command (used by later ADC_RD commands)
+  always @(posedge clk) begin
+    if (!resetn) avg_log2 <= 4'd0;
+    else if (do_next_cmd && command == CMD_SET_AVG && cmd_word[3:0] <= AVG_LOG2_MAX) avg_log2 <= cmd_word[3:0];
+  end
+  // Passes over the channels in the current ADC read (only the last one is followed by the dummy word)
+  assign last_adc_round = ({1'b0, adc_round} == (9'd1 << rd_avg_log2) - 9'd1);
+  always @(posedge clk) begin
+    if (!resetn || state == S_ERROR) begin
+      rd_avg_log2 <= 4'd0;
+      adc_round <= 8'd0;
+    end else if (do_next_cmd && command == CMD_ADC_RD) begin
+      rd_avg_log2 <= avg_log2;
+      adc_round <= 8'd0;
+    end else if (do_next_cmd && command == CMD_ADC_RD_CH) begin
+      adc_round <= 8'd0;
+    end else if (state == S_ADC_RD && adc_spi_cmd_done && adc_word_idx == 7 && !last_adc_round) begin
+      adc_round <= adc_round + 1;
+    end
+  end
+
+
   //// ---- ADC word sequencing
-  // ADC word count status (read comes in one word after writing the read request, so you need 8 + 1 = 9 words for 8 reads)
+  // ADC word count status (read comes in one word after writing the read request, so you need 8 + 1 = 9 words for 8 reads,
+  // or 8 * 2^avg_log2 + 1 words when averaging since the word index wraps back to 0 for each pass but the last)
   assign last_adc_word = (state == S_ADC_RD && adc_word_idx == 8) || (state == S_ADC_RD_CH && adc_word_idx == 1);
   assign adc_spi_cmd_done = ((state == S_ADC_RD)
                              || (state == S_ADC_RD_CH)
@@ -398,10 +542,13 @@ module shim_ads816x_adc_ctrl (
     if (!resetn || state == S_ERROR) adc_word_idx <= 4'd0;
     else if (do_next_cmd && (command == CMD_ADC_RD || command == CMD_ADC_RD_CH)) adc_word_idx <= 4'd0;
     else if ((state == S_ADC_RD || state == S_ADC_RD_CH) && adc_spi_cmd_done) begin
-      if (!last_adc_word) adc_word_idx <= adc_word_idx + 1;
-      else adc_word_idx <= 4'd0;
+      if (last_adc_word) adc_word_idx <= 4'd0;
+      else if (state == S_ADC_RD && adc_word_idx == 7 && !last_adc_round) adc_word_idx <= 4'd0; // Start the next averaging pass
+      else adc_word_idx <= adc_word_idx + 1;
     end
   end
+  // Sample order slot of the next word (wraps to the first slot for the next averaging pass)
+  assign next_slot = adc_word_idx[2:0] + 3'd1;
 
 
   //// ---- SPI MOSI control
@@ -463,10 +610,10 @@ module shim_ads816x_adc_ctrl (
     // When starting an 8ch command, start with index 0
     end else if (do_next_cmd && (next_cmd_state == S_ADC_RD)) begin
       mosi_shift_reg <= {spi_req_otf_sample_cmd(sample_order[adc_word_idx[2:0]]), 8'd0};
-    // Otherwise, use the next adc_word_idx (increment happens at the same cycle, so use +1 here)
+    // Otherwise, use the next sample order slot (increment happens at the same cycle, so use next_slot here)
     end else if ((state == S_ADC_RD) && adc_spi_cmd_done) begin
       // The first word uses the next channel in the sequence
-      if (!last_adc_word) mosi_shift_reg <= {spi_req_otf_sample_cmd(sample_order[adc_word_idx[2:0]]+1), 8'd0};
+      if (!last_adc_word) mosi_shift_reg <= {spi_req_otf_sample_cmd(sample_order[next_slot]), 8'd0};
       // The last (ninth for this command) word is always channel 0 (dummy read to allow one-cycle MISO delay)
       else if (last_adc_word) mosi_shift_reg <= {spi_req_otf_sample_cmd(3'b0), 8'd0};
     // When starting a single-channel command, use the channel from the command word
@@ -483,7 +630,7 @@ module shim_ads816x_adc_ctrl (
   always @(posedge clk) begin
     if (!resetn || state == S_ERROR) start_miso_mosi_clk <= 1'b0; // Reset start MISO read signal on reset or error
     else if ((state == S_TEST_RD 
-              || ((state == S_ADC_RD || state == S_ADC_RD_CH) && adc_word_idx > 0))
+              || ((state == S_ADC_RD || state == S_ADC_RD_CH) && (adc_word_idx > 0 || adc_round > 0)))
              && n_cs_timer == 2) start_miso_mosi_clk <= 1'b1;
     else start_miso_mosi_clk <= 1'b0;
   end
@@ -536,7 +683,7 @@ module shim_ads816x_adc_ctrl (
 
   //// ---- ADC data output
   // When two data words are ready (one stored, one just read), adc data word is ready
-  assign adc_pair_data_ready = (state != S_TEST_RD && setup_done && !n_miso_data_ready_mosi_clk && miso_stored && single_reads == 0);
+  assign adc_pair_data_ready = (state != S_TEST_RD && setup_done && !n_miso_data_ready_mosi_clk && miso_stored && single_reads == 0 && acc_last_round);
   // When reading one channel, data word is ready when one word is read
   assign adc_ch_data_ready = (single_reads > 0 && !n_miso_data_ready_mosi_clk);
   // Single read count (could be two in a row, make sure the second isn't lost)
@@ -573,6 +720,7 @@ module shim_ads816x_adc_ctrl (
   // Attempt to write data to the data buffer if any of the following are true
   assign try_data_write = adc_pair_data_ready
                           || adc_ch_data_ready
+                          || frame_marker_ready
                           || debug_miso_data
                           || debug_state_transition
                           || debug_repeat_bit
@@ -586,18 +734,42 @@ module shim_ads816x_adc_ctrl (
     else if (try_data_write && !data_buf_full) data_buf_wr_en <= 1'b1; // Write data word when two words are ready and buffer isn't full
     else data_buf_wr_en <= 1'b0;
   end
+  // ADC_RD sample from the MISO buffer (8 per averaging pass)
+  assign adc_sample_valid = (state != S_TEST_RD && !n_miso_data_ready_mosi_clk && single_reads == 0);
+  // Averaging accumulators
+  // Each slot sums its reads over the passes; the last pass outputs the sum shifted down (truncated mean).
+  // The shift is taken from the MOSI side at the first sample of a read, after the previous read's data is out.
+  assign acc_shift_cur = (acc_slot == 0 && acc_round == 0) ? rd_avg_log2 : acc_shift;
+  assign acc_last_round = ({1'b0, acc_round} == (9'd1 << acc_shift_cur) - 9'd1);
+  assign acc_sum = ((acc_round == 0) ? 24'd0 : acc[acc_slot]) + {8'd0, miso_data_mosi_clk};
+  assign acc_avg = acc_sum >> acc_shift_cur;
+  assign avg_data = acc_avg[15:0];
+  always @(posedge clk) begin
+    if (!resetn || state == S_ERROR) begin
+      acc_slot <= 3'd0;
+      acc_round <= 8'd0;
+      acc_shift <= 4'd0;
+    end else if (adc_sample_valid) begin
+      if (acc_slot == 0 && acc_round == 0) acc_shift <= rd_avg_log2;
+      acc_slot <= acc_slot + 1;
+      if (acc_slot == 7) acc_round <= acc_last_round ? 8'd0 : acc_round + 1;
+    end
+  end
+  always @(posedge clk) begin
+    if (adc_sample_valid && !acc_last_round) acc[acc_slot] <= acc_sum;
+  end
   // MISO data stored flag
-  // Alternate storing and writing MISO data
+  // Alternate storing and writing MISO data (averaged samples only come out in the last pass)
   always @(posedge clk) begin
     if (!resetn || state == S_ERROR) miso_stored <= 1'b0; // Reset MISO stored flag on reset or error
-    else if (state != S_TEST_RD && !n_miso_data_ready_mosi_clk && single_reads == 0) miso_stored <= ~miso_stored; // Toggle MISO stored flag when MISO data is ready to be read
+    else if (adc_sample_valid && acc_last_round) miso_stored <= ~miso_stored; // Toggle MISO stored flag when MISO data is ready to be read
   end
   // MISO data storage
-  // Store the last MISO data word when it is ready
+  // Store the last (averaged) MISO data word when it is ready
   always @(posedge clk) begin
     if (!resetn || state == S_ERROR) miso_data_storage <= 16'd0; // Reset MISO data storage on reset or error
-    else if (!n_miso_data_ready_mosi_clk && single_reads == 0) begin
-      miso_data_storage <= miso_data_mosi_clk; // Store the last MISO data word
+    else if (!n_miso_data_ready_mosi_clk && single_reads == 0 && acc_last_round) begin
+      miso_data_storage <= avg_data; // Store the last MISO data word
     end
   end
   // MISO data word
@@ -605,9 +777,12 @@ module shim_ads816x_adc_ctrl (
   always @(posedge clk) begin
     if (!resetn) data_word <= 32'd0; // Reset data word on reset
     else if (try_data_write && !data_buf_full) begin
+      // If a frame marker is waiting, write it first (a sample in the same cycle is dropped and counted)
+      if (frame_marker_ready) begin
+        data_word <= {FRAME_MARKER_TAG, FRAME_BOARD_ID, marker_drops, marker_seq};
       // If ADC data pair is ready, write the two MISO data words to the data buffer
-      if (adc_pair_data_ready) begin 
-        data_word <= {miso_data_mosi_clk[15:0], miso_data_storage};
+      end else if (adc_pair_data_ready) begin 
+        data_word <= {avg_data, miso_data_storage};
       // If single ADC sample is ready, write single MISO data word with upper 16 bits zeroed
       end else if (adc_ch_data_ready) begin
         data_word <= {16'd0, miso_data_mosi_clk[15:0]}; 
@@ -634,6 +809,54 @@ module shim_ads816x_adc_ctrl (
   end
 
 
+  //// ---- Framing
+  // SET_FRAME writes marker 0 and starts frame 1; each frame's marker follows its last data word.
+  // While framing, a sample that finds the data buffer full is dropped and counted in its frame's
+  // marker instead of raising an overflow. A marker waits for the first free slot and takes it ahead
+  // of any sample, so markers are never lost: if a whole frame passes with the previous marker still
+  // waiting, every sample in it was dropped, and its marker is skipped (the next sequence number jumps).
+  assign framing = (frame_len != 9'd0);
+  assign frame_marker_ready = frame_marker_pending && !data_buf_full;
+  assign frame_sample = adc_pair_data_ready || adc_ch_data_ready;
+  assign frame_sample_dropped = frame_sample && (data_buf_full || frame_marker_ready);
+  always @(posedge clk) begin
+    if (!resetn) begin
+      frame_len <= 9'd0;
+      frame_word_count <= 9'd0;
+      frame_drops <= 9'd0;
+      frame_seq <= 16'd0;
+      marker_seq <= 16'd0;
+      marker_drops <= 9'd0;
+      frame_marker_pending <= 1'b0;
+    end else if (do_next_cmd && command == CMD_SET_FRAME && cmd_word[15:0] <= FRAME_LEN_MAX) begin
+      frame_len <= cmd_word[8:0];
+      frame_word_count <= 9'd0;
+      frame_drops <= 9'd0;
+      frame_seq <= 16'd1;
+      marker_seq <= 16'd0;
+      marker_drops <= 9'd0;
+      frame_marker_pending <= (cmd_word[8:0] != 9'd0);
+    end else if (framing) begin
+      if (frame_marker_ready) frame_marker_pending <= 1'b0;
+      if (frame_sample) begin
+        if (frame_word_count == frame_len - 9'd1) begin
+          frame_word_count <= 9'd0;
+          frame_drops <= 9'd0;
+          frame_seq <= frame_seq + 1;
+          if (!frame_marker_pending || frame_marker_ready) begin
+            frame_marker_pending <= 1'b1;
+            marker_seq <= frame_seq;
+            marker_drops <= frame_drops + frame_sample_dropped;
+          end
+        end else begin
+          frame_word_count <= frame_word_count + 1;
+          frame_drops <= frame_drops + frame_sample_dropped;
+        end
+      end
+    end
+  end
+
+
   //// ---- Functions for command clarity
   // SPI command to write to an ADC register
   function [23:0] spi_reg_write_cmd(input [10:0] reg_addr, input [7:0] reg_data);
@@ -0,0 +1 @@
+../../fifo_async/fifo_async.v
\ No newline at end of file
@@ -0,0 +1,290 @@
+import cocotb
+from cocotb.clock import Clock
+from cocotb.triggers import RisingEdge, FallingEdge, ReadOnly
+from collections import deque
+from fwft_fifo_model import fwft_fifo_model
+
+
+class shim_ads816x_adc_ctrl_base:
+
+    CMD_ENCODING = {
+        0: 'CMD_NO_OP',
+        1: 'CMD_SET_ORD',
+        2: 'CMD_ADC_RD',
+        3: 'CMD_ADC_RD_CH',
+        4: 'CMD_SET_AVG',
+        5: 'CMD_SET_FRAME',
+        6: 'CMD_LOOP',
+        7: 'CMD_CANCEL'
+    }
+
+    STATE_ENCODING = {
+        0: 'S_RESET',
+        1: 'S_INIT',
+        2: 'S_TEST_WR',
+        3: 'S_REQ_RD',
+        4: 'S_TEST_RD',
+        5: 'S_IDLE',
+        6: 'S_DELAY',
+        7: 'S_TRIG_WAIT',
+        8: 'S_ADC_RD',
+        9: 'S_ADC_RD_CH',
+        15: 'S_ERROR'
+    }
+
+    # Command bit positions
+    TRIG_BIT = 28
+    CONT_BIT = 27
+    REPEAT_BIT = 26
+    LOOP_LEN_LSB = 16
+
+    # n_cs high time used by every test (clock cycles)
+    N_CS_HIGH_TIME = 4
+
+    def __init__ (self, dut, clk_period=4, time_unit='ns'):
+        self.dut = dut
+        self.clk_period = clk_period
+        self.time_unit = time_unit
+
+        # Parameters
+        self.LOOP_ADDR_WIDTH = int(self.dut.LOOP_ADDR_WIDTH.value)
+        self.LOOP_DEPTH = 1 << self.LOOP_ADDR_WIDTH
+        self.BOARD_ID = int(self.dut.BOARD_ID.value)
+
+        # Initialize clocks
+        cocotb.start_soon(Clock(dut.clk, clk_period, time_unit).start(start_high=False))
+        cocotb.start_soon(Clock(dut.miso_sck, clk_period, time_unit).start(start_high=False))
+
+        self.dut._log.info(f"LOOP_ADDR_WIDTH set to {self.LOOP_ADDR_WIDTH} ({self.LOOP_DEPTH} word loop buffer)")
+        self.dut._log.info(f"BOARD_ID set to {self.BOARD_ID}")
+
+        # Initialize Input Signals
+        self.dut.boot_test_skip.value = 1
+        self.dut.debug.value = 0
+        self.dut.n_cs_high_time.value = self.N_CS_HIGH_TIME
+        self.dut.cmd_buf_word.value = 0
+        self.dut.cmd_buf_empty.value = 1
+        self.dut.data_buf_full.value = 0
+        self.dut.trigger.value = 0
+        self.dut.miso.value = 0
+
+        # Interface FIFOs
+        self.cmd_buf = fwft_fifo_model(dut, "CMD_FIFO_MODEL", DEPTH=64)
+        self.data_buf = fwft_fifo_model(dut, "DATA_FIFO_MODEL", DEPTH=1024)
+        self.data_buf_hold_full = False # Report the data buffer as full regardless of its contents
+
+        # ADC model: conversions requested on MOSI and not yet read back, and every (channel, value) read back
+        self.adc_pending = deque()
+        self.adc_reads = []
+        self.adc_ch_reads = [0] * 8 # Reads per channel, so each read of a channel returns a different value
+
+        # Activity counters
+        self.words_read = 0      # Words read from the command buffer
+        self.words_replayed = 0  # Words taken from the loop buffer
+
+    def get_state_name(self, state_value):
+        """Get the state name from the state value."""
+        state_int = int(state_value)
+        return self.STATE_ENCODING.get(state_int, f'STATE_{state_int}')
+
+    def get_cmd_name(self, cmd_value):
+        """Get the command name from the command value."""
+        cmd_int = int(cmd_value)
+        return self.CMD_ENCODING.get(cmd_int, f'CMD_{cmd_int}')
+
+    async def reset(self):
+        """Reset the DUT, hold reset for two clock cycles."""
+        await RisingEdge(self.dut.clk)
+        self.dut.resetn.value = 0
+        self.dut.miso_resetn.value = 0
+        self.dut._log.info("STARTING RESET")
+        self.cmd_buf.reset()
+        self.data_buf.reset()
+        self.data_buf_hold_full = False
+        self.adc_pending.clear()
+        self.adc_reads = []
+        self.adc_ch_reads = [0] * 8
+        self.words_read = 0
+        self.words_replayed = 0
+
+        await RisingEdge(self.dut.clk)
+
+        await RisingEdge(self.dut.clk)
+        self.dut.resetn.value = 1
+        self.dut.miso_resetn.value = 1
+        self.dut._log.info("RESET COMPLETE")
+
+        # Check the expected output after reset
+        assert int(self.dut.state.value) == 0, "DUT did not reset to initial state"
+        assert int(self.dut.loop_capture.value) == 0, "Loop capture not reset"
+        assert int(self.dut.loop_replay.value) == 0, "Loop replay not reset"
+
+        # Boot test is skipped, so the core goes straight to IDLE
+        await RisingEdge(self.dut.clk)
+        await ReadOnly()
+        assert int(self.dut.state.value) == 5, f"Expected S_IDLE after reset, got {self.get_state_name(self.dut.state.value)}"
+
+    async def command_buf_model(self):
+        """
+        Model of the command buffer. Connected to DUT's cmd_buf_rd_en, cmd_buf_word, and cmd_buf_empty.
+        Also counts command buffer reads and loop buffer replays.
+        """
+        while True:
+            await RisingEdge(self.dut.clk)
+
+            # Update Buffer status signals
+            self.dut.cmd_buf_empty.value = 1 if self.cmd_buf.is_empty() else 0
+
+            # FWFT behavior: always present the next item on cmd_buf_word
+            fwft_data = self.cmd_buf.peek_item() if not self.cmd_buf.is_empty() else None
+            self.dut.cmd_buf_word.value = fwft_data if fwft_data is not None else 0
+
+            await ReadOnly() # Wait for combinational logic to settle
+            # Buffer reads
+            if int(self.dut.cmd_buf_rd_en.value) == 1 and not self.cmd_buf.is_empty():
+                self.cmd_buf.pop_item()
+                self.words_read += 1
+            elif int(self.dut.src_rd_en.value) == 1:
+                self.words_replayed += 1
+
+    async def data_buf_model(self):
+        """
+        Model of the data buffer. Connected to DUT's data_buf_wr_en, data_word, and data_buf_full.
+        Words are never read out, so everything the DUT writes stays in data_buf for checking.
+        """
+        while True:
+            await RisingEdge(self.dut.clk)
+
+            # Update Buffer status signals
+            self.dut.data_buf_full.value = 1 if (self.data_buf_hold_full or self.data_buf.is_full()) else 0
+
+            await ReadOnly()
+            if int(self.dut.data_buf_wr_en.value) == 1:
+                self.data_buf.write_item(int(self.dut.data_word.value))
+
+    def adc_sample(self, ch):
+        """Value the ADC model returns for the next conversion of a channel (distinct per channel, varies per read)."""
+        value = (0x1000 * ch + 0x100 + 37 * self.adc_ch_reads[ch]) & 0xFFFF
+        self.adc_ch_reads[ch] += 1
+        return value
+
+    async def adc_spi_model(self):
+        """
+        MISO side of the ADS816x model. Returns each conversion queued by adc_mosi_model during the
+        following SPI word (the one-word delay the dummy word covers).
+        """
+        word = 0
+        while True:
+            await FallingEdge(self.dut.miso_sck)
+            start = int(self.dut.start_miso.value) == 1
+            miso_bit = int(self.dut.miso_bit.value)
+            if start and miso_bit == 0:
+                if self.adc_pending:
+                    ch = self.adc_pending.popleft()
+                    word = self.adc_sample(ch)
+                    self.adc_reads.append((ch, word))
+                else:
+                    self.dut._log.warning("ADC_MODEL: MISO read with no conversion requested")
+                    word = 0
+                bit = 15
+            elif miso_bit >= 2:
+                bit = miso_bit - 1
+            else:
+                bit = 0 # Last bit is sampled as the word is written to the MISO FIFO
+            self.dut.miso.value = (word >> bit) & 1
+
+    async def adc_mosi_model(self):
+        """MOSI side of the ADS816x model. Queues the channel of each sample request as its SPI word starts (n_cs falling)."""
+        prev_n_cs = 1
+        while True:
+            await RisingEdge(self.dut.clk)
+            await ReadOnly()
+            n_cs = int(self.dut.n_cs.value)
+            if prev_n_cs == 1 and n_cs == 0 and int(self.dut.state.value) in (8, 9):
+                spi_cmd = int(self.dut.mosi_shift_reg.value) >> 8
+                assert (spi_cmd >> 14) == 0b10, f"Unexpected SPI command {spi_cmd:04x} in an ADC read"
+                # The first word of a read isn't preceded by a MISO read, so the last read's dummy conversion is dropped
+                if int(self.dut.adc_word_idx.value) == 0 and int(self.dut.adc_round.value) == 0:
+                    self.adc_pending.clear()
+                self.adc_pending.append((spi_cmd >> 11) & 0x7)
+            prev_n_cs = n_cs
+
+    def expected_adc_rd_words(self, reads, avg_log2=0):
+        """Data words for one ADC_RD from its (channel, value) reads: each slot's truncated mean, packed in pairs."""
+        assert len(reads) == 8 << avg_log2, f"Expected {8 << avg_log2} reads, got {len(reads)}"
+        avgs = [sum(reads[r * 8 + slot][1] for r in range(1 << avg_log2)) >> avg_log2 for slot in range(8)]
+        return [(avgs[i + 1] << 16) | avgs[i] for i in range(0, 8, 2)]
+
+    def frame_marker(self, seq, drops=0):
+        """Frame marker word: tag, board ID, samples dropped in the frame, and the frame's sequence number."""
+        return (0xA << 28) | ((self.BOARD_ID & 0x7) << 25) | ((drops & 0x1FF) << 16) | (seq & 0xFFFF)
+
+    def data_words(self):
+        """All data words written so far, oldest first."""
+        return list(self.data_buf.fifo)
+
+    def load_commands(self, cmd_list):
+        """Put a list of command words in the command buffer all at once (so multi-word commands never underflow)."""
+        for cmd in cmd_list:
+            self.cmd_buf.write_item(cmd)
+
+    async def wait_for_idle(self, timeout_cycles=20000):
+        """Wait until the DUT is idle with nothing left to read."""
+        for _ in range(timeout_cycles):
+            await RisingEdge(self.dut.clk)
+            await ReadOnly()
+            if (int(self.dut.state.value) == 5 and self.cmd_buf.is_empty()
+                and int(self.dut.loop_capture.value) == 0 and int(self.dut.loop_replay.value) == 0):
+                return
+        assert False, f"Timed out waiting for S_IDLE, state is {self.get_state_name(self.dut.state.value)}"
+
+    async def wait_for_error(self, timeout_cycles=100):
+        """Wait until the DUT reaches S_ERROR."""
+        for _ in range(timeout_cycles):
+            await RisingEdge(self.dut.clk)
+            await ReadOnly()
+            if int(self.dut.state.value) == 15:
+                return
+        assert False, f"Timed out waiting for S_ERROR, state is {self.get_state_name(self.dut.state.value)}"
+
+    def assert_no_errors(self):
+        """Check that no error flag is set."""
+        for flag in ['boot_fail', 'cmd_buf_underflow', 'data_buf_overflow', 'unexp_trig',
+                     'delay_too_short', 'bad_cmd']:
+            assert int(getattr(self.dut, flag).value) == 0, f"Unexpected error flag {flag}"
+
+    def adc_rd_delay(self, avg_log2=0):
+        """Delay long enough for an ADC_RD's SPI words (8 per averaging pass plus the dummy) to finish."""
+        spi_words = (8 << avg_log2) + 1
+        return spi_words * (self.N_CS_HIGH_TIME + 24) + 50
+
+    # Command word generators
+    def noop(self, value, trig=False, cont=False):
+        return ((0 << 29) | (int(trig) << self.TRIG_BIT) | (int(cont) << self.CONT_BIT)
+                | (value & 0x1FFFFFF))
+
+    def set_ord(self, order):
+        """SET_ORD command word for a list of 8 channels, one per sample slot."""
+        word = 1 << 29
+        for slot, ch in enumerate(order):
+            word |= (ch & 0x7) << (3 * slot)
+        return word
+
+    def adc_rd(self, value, trig=False, cont=False):
+        return ((2 << 29) | (int(trig) << self.TRIG_BIT) | (int(cont) << self.CONT_BIT)
+                | (value & 0x1FFFFFF))
+
+    def adc_rd_ch(self, ch):
+        return (3 << 29) | (ch & 0x7)
+
+    def set_avg(self, avg_log2):
+        return (4 << 29) | (avg_log2 & 0xF)
+
+    def set_frame(self, frame_len):
+        return (5 << 29) | (frame_len & 0xFFFF)
+
+    def loop(self, block_words, passes):
+        return (6 << 29) | ((block_words & 0x3FF) << self.LOOP_LEN_LSB) | (passes & 0xFFFF)
+
+    def cancel(self):
+        return 7 << 29
@@ -0,0 +1,424 @@
+import cocotb
+from cocotb.triggers import RisingEdge, ReadOnly
+
+from shim_ads816x_adc_ctrl_base import shim_ads816x_adc_ctrl_base
+
+async def setup_testbench(dut, clk_period=4, time_unit='ns'):
+    tb = shim_ads816x_adc_ctrl_base(dut, clk_period, time_unit)
+    return tb
+
+async def start_models(tb):
+    await tb.reset()
+    return [cocotb.start_soon(tb.command_buf_model()), cocotb.start_soon(tb.data_buf_model()),
+            cocotb.start_soon(tb.adc_mosi_model()), cocotb.start_soon(tb.adc_spi_model())]
+
+async def settle(tb, cycles=200):
+    """Let the last read's data out after the command stream is done."""
+    for _ in range(cycles):
+        await RisingEdge(tb.dut.clk)
+    await ReadOnly()
+
+# DIRECTED TESTS
+@cocotb.test()
+async def test_reset(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_reset")
+
+    # Reset the DUT
+    await tb.reset()
+
+    # Give time before ending the test
+    await RisingEdge(dut.clk)
+    await RisingEdge(dut.clk)
+
+@cocotb.test()
+async def test_loop_replays_block(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_loop_replays_block")
+    tasks = await start_models(tb)
+
+    # An 8-channel read and a delay, run 3 times, then a final delay
+    passes = 3
+    block = [tb.adc_rd(tb.adc_rd_delay(), cont=True), tb.noop(100, cont=True)]
+    cmd_list = [tb.loop(len(block), passes)] + block + [tb.noop(10)]
+    tb.load_commands(cmd_list)
+
+    await tb.wait_for_idle()
+    await settle(tb)
+
+    # The block is only read from the command buffer once
+    assert tb.words_read == len(cmd_list), f"Expected {len(cmd_list)} command buffer reads, got {tb.words_read}"
+    assert tb.words_replayed == (passes - 1) * len(block), \
+        f"Expected {(passes - 1) * len(block)} replayed words, got {tb.words_replayed}"
+    # Every pass reads the 8 channels (4 data words)
+    assert len(tb.data_words()) == 4 * passes, f"Expected {4 * passes} data words, got {len(tb.data_words())}"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_loop_single_pass(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_loop_single_pass")
+    tasks = await start_models(tb)
+
+    # One pass runs the block once, straight from the command buffer
+    block = [tb.adc_rd(tb.adc_rd_delay(), cont=True), tb.noop(20)]
+    cmd_list = [tb.loop(len(block), 1)] + block
+    tb.load_commands(cmd_list)
+
+    await tb.wait_for_idle()
+    await settle(tb)
+
+    assert tb.words_read == len(cmd_list), f"Expected {len(cmd_list)} command buffer reads, got {tb.words_read}"
+    assert tb.words_replayed == 0, f"Expected no replayed words, got {tb.words_replayed}"
+    assert len(tb.data_words()) == 4, f"Expected 4 data words, got {len(tb.data_words())}"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_loop_full_buffer(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_loop_full_buffer")
+    tasks = await start_models(tb)
+
+    # A block that fills the loop buffer exactly
+    block = [tb.noop(8, cont=True) for _ in range(tb.LOOP_DEPTH)]
+    passes = 2
+    cmd_list = [tb.loop(len(block), passes)] + block + [tb.noop(1)]
+    tb.load_commands(cmd_list)
+
+    await tb.wait_for_idle()
+
+    assert tb.words_read == len(cmd_list), f"Expected {len(cmd_list)} command buffer reads, got {tb.words_read}"
+    assert tb.words_replayed == (passes - 1) * len(block), \
+        f"Expected {(passes - 1) * len(block)} replayed words, got {tb.words_replayed}"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_loop_forever_cancel(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_loop_forever_cancel")
+    tasks = await start_models(tb)
+
+    # Zero passes repeats until cancelled, with no command buffer reads after the first pass
+    block = [tb.noop(20, cont=True)]
+    tb.load_commands([tb.loop(len(block), 0)] + block)
+    for _ in range(1000):
+        await RisingEdge(dut.clk)
+    await ReadOnly()
+    assert tb.words_read == 2, f"Expected 2 command buffer reads, got {tb.words_read}"
+    assert tb.words_replayed > 30, f"Expected the block to keep replaying, got {tb.words_replayed} replayed words"
+    assert int(dut.loop_replay.value) == 1, "Expected the loop to still be replaying"
+    tb.assert_no_errors()
+
+    # A CANCEL ends the delay and the loop
+    await RisingEdge(dut.clk)
+    tb.load_commands([tb.cancel()])
+    await tb.wait_for_idle(timeout_cycles=100)
+    replayed = tb.words_replayed
+    for _ in range(100):
+        await RisingEdge(dut.clk)
+    await ReadOnly()
+    assert tb.words_read == 3, f"Expected 3 command buffer reads, got {tb.words_read}"
+    assert tb.words_replayed == replayed, "Loop kept replaying after the CANCEL"
+    assert int(dut.state.value) == 5, f"Expected S_IDLE after cancel, got {tb.get_state_name(dut.state.value)}"
+    tb.assert_no_errors()
+
+    # Commands after the CANCEL run from the command buffer again
+    tb.load_commands([tb.noop(10)])
+    await tb.wait_for_idle()
+    assert tb.words_read == 4, f"Expected 4 command buffer reads, got {tb.words_read}"
+    assert tb.words_replayed == replayed, "Command after the CANCEL was taken from the loop buffer"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_loop_forever_cancel_during_read(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_loop_forever_cancel_during_read")
+    tasks = await start_models(tb)
+
+    # A forever loop of reads stops at the end of the read it's in, and keeps that read's data
+    block = [tb.adc_rd(tb.adc_rd_delay(), cont=True)]
+    tb.load_commands([tb.loop(len(block), 0)] + block)
+    for _ in range(3 * tb.adc_rd_delay()):
+        await RisingEdge(dut.clk)
+    await ReadOnly()
+    assert int(dut.loop_replay.value) == 1, "Expected the loop to still be replaying"
+
+    await RisingEdge(dut.clk)
+    tb.load_commands([tb.cancel()])
+    await tb.wait_for_idle(timeout_cycles=2 * tb.adc_rd_delay())
+    await settle(tb)
+    assert tb.words_read == 3, f"Expected 3 command buffer reads, got {tb.words_read}"
+    reads = 1 + tb.words_replayed
+    assert len(tb.data_words()) == 4 * reads, \
+        f"Expected {4 * reads} data words for {reads} reads, got {len(tb.data_words())}"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_loop_bad_commands(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_loop_bad_commands")
+
+    tasks = [cocotb.start_soon(tb.command_buf_model()), cocotb.start_soon(tb.data_buf_model())]
+
+    bad_cmd_lists = {
+        "empty block": [tb.loop(0, 2)],
+        "empty block, forever": [tb.loop(0, 0)],
+        "block larger than the loop buffer": [tb.loop(tb.LOOP_DEPTH + 1, 2)],
+        "nested loop": [tb.loop(3, 2), tb.noop(10, cont=True), tb.loop(1, 2), tb.noop(10)],
+        "nested loop on the last block word": [tb.loop(2, 2), tb.noop(10, cont=True), tb.loop(1, 2), tb.noop(10)],
+    }
+    for name, cmd_list in bad_cmd_lists.items():
+        tb.dut._log.info(f"Checking bad LOOP: {name}")
+        await tb.reset()
+        tb.load_commands(cmd_list)
+        await tb.wait_for_error()
+        assert int(dut.bad_cmd.value) == 1, f"{name}: expected bad_cmd"
+        await RisingEdge(dut.clk) # Loop state clears on the first cycle in S_ERROR
+        await ReadOnly()
+        assert int(dut.loop_capture.value) == 0 and int(dut.loop_replay.value) == 0, \
+            f"{name}: loop still active in S_ERROR"
+
+    # A LOOP straight after the last replayed word of a finished one is fine
+    await tb.reset()
+    tb.load_commands([tb.loop(1, 2), tb.noop(10, cont=True), tb.loop(1, 2), tb.noop(10)])
+    await tb.wait_for_idle()
+    assert tb.words_replayed == 2, f"Expected 2 replayed words, got {tb.words_replayed}"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_avg_sample_order(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_avg_sample_order")
+    tasks = await start_models(tb)
+
+    # 4 reads per channel in a non-default order: every pass follows the order, and each slot is averaged
+    order = [5, 2, 7, 0, 3, 6, 1, 4]
+    avg_log2 = 2
+    tb.load_commands([tb.set_ord(order), tb.set_avg(avg_log2),
+                      tb.adc_rd(tb.adc_rd_delay(avg_log2)), tb.noop(10)])
+
+    await tb.wait_for_idle()
+    await settle(tb)
+
+    channels = [ch for ch, _ in tb.adc_reads]
+    assert channels == order * (1 << avg_log2), f"Reads didn't follow the sample order: {channels}"
+    expected = tb.expected_adc_rd_words(tb.adc_reads, avg_log2)
+    assert tb.data_words() == expected, \
+        f"Expected averaged words {[f'{w:08x}' for w in expected]}, got {[f'{w:08x}' for w in tb.data_words()]}"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_avg_repeated_channels(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_avg_repeated_channels")
+    tasks = await start_models(tb)
+
+    # An order can read a channel in several slots; each slot still averages only its own reads
+    order = [3, 3, 6, 6, 3, 3, 6, 6]
+    avg_log2 = 1
+    tb.load_commands([tb.set_ord(order), tb.set_avg(avg_log2),
+                      tb.adc_rd(tb.adc_rd_delay(avg_log2)), tb.noop(10)])
+
+    await tb.wait_for_idle()
+    await settle(tb)
+
+    channels = [ch for ch, _ in tb.adc_reads]
+    assert channels == order * (1 << avg_log2), f"Reads didn't follow the sample order: {channels}"
+    expected = tb.expected_adc_rd_words(tb.adc_reads, avg_log2)
+    assert tb.data_words() == expected, \
+        f"Expected averaged words {[f'{w:08x}' for w in expected]}, got {[f'{w:08x}' for w in tb.data_words()]}"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_avg_changes_between_reads(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_avg_changes_between_reads")
+    tasks = await start_models(tb)
+
+    # Averaging is latched per ADC_RD: averaged, plain, then averaged again, all in the same order
+    order = [7, 6, 5, 4, 3, 2, 1, 0]
+    avg_settings = [3, 0, 1]
+    cmd_list = [tb.set_ord(order)]
+    for avg_log2 in avg_settings:
+        cmd_list += [tb.set_avg(avg_log2), tb.adc_rd(tb.adc_rd_delay(avg_log2), cont=True)]
+    cmd_list += [tb.noop(10)]
+    tb.load_commands(cmd_list)
+
+    await tb.wait_for_idle()
+    await settle(tb)
+
+    expected = []
+    first = 0
+    for avg_log2 in avg_settings:
+        reads = tb.adc_reads[first:first + (8 << avg_log2)]
+        channels = [ch for ch, _ in reads]
+        assert channels == order * (1 << avg_log2), f"Reads didn't follow the sample order at avg_log2 {avg_log2}: {channels}"
+        expected += tb.expected_adc_rd_words(reads, avg_log2)
+        first += 8 << avg_log2
+    assert len(tb.adc_reads) == first, f"Expected {first} reads, got {len(tb.adc_reads)}"
+    assert tb.data_words() == expected, \
+        f"Expected words {[f'{w:08x}' for w in expected]}, got {[f'{w:08x}' for w in tb.data_words()]}"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_frame_markers(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_frame_markers")
+    tasks = await start_models(tb)
+
+    # 3-word frames over two 8-channel reads and a single-channel read (9 data words, 3 frames).
+    # Marker 0 goes out with SET_FRAME, and each frame's marker follows its last word, even mid-read.
+    frame_len = 3
+    tb.load_commands([tb.set_frame(frame_len),
+                      tb.adc_rd(tb.adc_rd_delay(), cont=True), tb.adc_rd(tb.adc_rd_delay(), cont=True),
+                      tb.adc_rd_ch(6), tb.noop(10)])
+
+    await tb.wait_for_idle()
+    await settle(tb)
+
+    assert len(tb.adc_reads) == 17, f"Expected 17 reads, got {len(tb.adc_reads)}"
+    assert tb.adc_reads[16][0] == 6, f"Single-channel read took channel {tb.adc_reads[16][0]}"
+    samples = tb.expected_adc_rd_words(tb.adc_reads[0:8]) + tb.expected_adc_rd_words(tb.adc_reads[8:16]) \
+              + [tb.adc_reads[16][1]]
+    expected = [tb.frame_marker(0)]
+    for frame in range(len(samples) // frame_len):
+        expected += samples[frame * frame_len:(frame + 1) * frame_len] + [tb.frame_marker(frame + 1)]
+    assert tb.data_words() == expected, \
+        f"Expected words {[f'{w:08x}' for w in expected]}, got {[f'{w:08x}' for w in tb.data_words()]}"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_frame_drops(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_frame_drops")
+    tasks = await start_models(tb)
+
+    # One read per 4-word frame, with a long gap after each read
+    frame_len = 4
+    cmd_list = [tb.set_frame(frame_len)]
+    for _ in range(3):
+        cmd_list += [tb.adc_rd(tb.adc_rd_delay(), cont=True), tb.noop(1000, cont=True)]
+    cmd_list += [tb.noop(10)]
+    tb.load_commands(cmd_list)
+
+    # Fill the data buffer after the first 2 words of the second read, and free it once that read is over
+    for _ in range(20000):
+        await RisingEdge(dut.clk)
+        await ReadOnly()
+        if len(tb.data_words()) == 1 + frame_len + 1 + 2:
+            break
+    await RisingEdge(dut.clk)
+    tb.data_buf_hold_full = True
+    while len(tb.adc_reads) < 16:
+        await RisingEdge(dut.clk)
+    await settle(tb)
+    assert int(dut.data_buf_overflow.value) == 0, "Overflow raised while framing"
+    assert int(dut.state.value) != 15, "Dropped samples stopped the core while framing"
+    await RisingEdge(dut.clk)
+    tb.data_buf_hold_full = False
+
+    await tb.wait_for_idle()
+    await settle(tb)
+
+    # The dropped words are only counted in their frame's marker, which waits for room in the buffer
+    reads = [tb.expected_adc_rd_words(tb.adc_reads[i * 8:(i + 1) * 8]) for i in range(3)]
+    expected = [tb.frame_marker(0)] \
+               + reads[0] + [tb.frame_marker(1)] \
+               + reads[1][:2] + [tb.frame_marker(2, drops=2)] \
+               + reads[2] + [tb.frame_marker(3)]
+    assert tb.data_words() == expected, \
+        f"Expected words {[f'{w:08x}' for w in expected]}, got {[f'{w:08x}' for w in tb.data_words()]}"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_frame_skipped_marker(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_frame_skipped_marker")
+    tasks = await start_models(tb)
+
+    # With the buffer full from the start, marker 0 waits and every word of frame 1 is dropped.
+    # Frame 1's marker can't be queued behind marker 0, so it's skipped and the sequence jumps to 2.
+    frame_len = 4
+    tb.data_buf_hold_full = True
+    tb.load_commands([tb.set_frame(frame_len), tb.adc_rd(tb.adc_rd_delay(), cont=True), tb.noop(1000, cont=True),
+                      tb.adc_rd(tb.adc_rd_delay(), cont=True), tb.noop(10)])
+    while len(tb.adc_reads) < 8:
+        await RisingEdge(dut.clk)
+    await settle(tb)
+    assert len(tb.data_words()) == 0, "Words written to a full buffer"
+    await RisingEdge(dut.clk)
+    tb.data_buf_hold_full = False
+
+    await tb.wait_for_idle()
+    await settle(tb)
+
+    expected = [tb.frame_marker(0)] + tb.expected_adc_rd_words(tb.adc_reads[8:16]) + [tb.frame_marker(2)]
+    assert tb.data_words() == expected, \
+        f"Expected words {[f'{w:08x}' for w in expected]}, got {[f'{w:08x}' for w in tb.data_words()]}"
+    tb.assert_no_errors()
+
+    for task in tasks:
+        task.kill()
+
+@cocotb.test()
+async def test_frame_off_overflow(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_frame_off_overflow")
+    tasks = await start_models(tb)
+
+    # SET_FRAME 0 turns framing off: after the first SET_FRAME's marker 0 there are no more markers,
+    # and a full buffer is an overflow error again
+    tb.load_commands([tb.set_frame(4), tb.set_frame(0), tb.adc_rd(tb.adc_rd_delay()), tb.noop(10)])
+    await tb.wait_for_idle()
+    await settle(tb)
+    expected = [tb.frame_marker(0)] + tb.expected_adc_rd_words(tb.adc_reads[0:8])
+    assert tb.data_words() == expected, \
+        f"Expected words {[f'{w:08x}' for w in expected]}, got {[f'{w:08x}' for w in tb.data_words()]}"
+    tb.assert_no_errors()
+
+    tb.data_buf_hold_full = True
+    tb.load_commands([tb.adc_rd(tb.adc_rd_delay()), tb.noop(10)])
+    await tb.wait_for_error(timeout_cycles=2 * tb.adc_rd_delay())
+    assert int(dut.data_buf_overflow.value) == 1, "Expected data_buf_overflow with framing off"
+
+    # A frame longer than 511 words is a bad command
+    await tb.reset()
+    tb.load_commands([tb.set_frame(512)])
+    await tb.wait_for_error()
+    assert int(dut.bad_cmd.value) == 1, "Expected bad_cmd for a 512-word frame"
+
+    for task in tasks:
+        task.kill()
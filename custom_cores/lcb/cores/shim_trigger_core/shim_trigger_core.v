@@ -1,7 +1,8 @@
 `timescale 1 ns / 1 ps
 
 module shim_trigger_core #(
-  parameter TRIGGER_LOCKOUT_DEFAULT = 10000000 // Default lockout period in clock cycles (e.g., 10000000 at 20 MHz SPI clock -> 0.5 seconds)
+  parameter TRIGGER_LOCKOUT_DEFAULT = 10000000, // Default lockout period in clock cycles (e.g., 10000000 at 20 MHz SPI clock -> 0.5 seconds)
+  parameter DELTA_RESYNC_INTERVAL = 256 // Logged triggers per full timestamp in delta log mode (1 to 65536)
 ) (
   input  wire        clk,
   input  wire        resetn,
@@ -79,6 +80,16 @@ module shim_trigger_core #(
   reg [31:0] second_word; // Second word to write to data buffer
   reg        trig_data_second_word; // Flag to indicate if the second word is being written
 
+  // Delta log mode (selected by bit 0 of the RESET_COUNT value)
+  reg         delta_mode; // Log 32-bit deltas with periodic full timestamps instead of 64-bit timestamps
+  reg         delta_synced; // A full timestamp has been logged since the last count reset
+  reg  [63:0] last_log_time; // Timer value of the last logged trigger
+  reg  [15:0] delta_count; // Deltas logged since the last full timestamp
+  wire [63:0] log_delta = trig_timer - last_log_time;
+  wire        log_resync = !delta_synced || (log_delta[63:31] != 0) || (delta_count >= DELTA_RESYNC_INTERVAL - 1);
+  wire        log_two_words = !delta_mode || log_resync; // Full timestamps take two words
+  wire        log_room = !data_buf_full && !(log_two_words && data_buf_almost_full);
+
   // External trigger synchronization
   always @(posedge clk) begin
     if (!resetn) begin
@@ -171,7 +182,7 @@ module shim_trigger_core #(
   // Data buffer overflow
   always @(posedge clk) begin
     if (!resetn) data_buf_overflow <= 0;
-    else if (do_log && (data_buf_full || data_buf_almost_full)) data_buf_overflow <= 1;
+    else if (do_log && !log_room) data_buf_overflow <= 1;
   end
 
   //// Read enable
@@ -194,13 +205,19 @@ module shim_trigger_core #(
   end
 
   //// Data buffer write logic
-  // Write two sequential 32-bit words to the data buffer each trigger
+  // Full mode: write two sequential 32-bit words to the data buffer each trigger
+  // Delta mode: write {1'b0, delta[30:0]} from the last logged trigger, or a two-word full
+  //   timestamp {1'b1, timer[62:32]}, timer[31:0] on the first trigger after a count reset,
+  //   when the delta doesn't fit in 31 bits, or every DELTA_RESYNC_INTERVAL logged triggers
   always @(posedge clk) begin
     if (!resetn) begin
       data_word_wr_en <= 0;
       data_word <= 32'h0;
       second_word <= 32'h0;
       trig_data_second_word <= 0;
+      last_log_time <= 64'h0;
+      delta_count <= 16'h0;
+      delta_synced <= 0;
     // If already writing a word
     end else if (data_word_wr_en) begin
       // If already writing the second word, disable write and reset flag
@@ -212,12 +229,31 @@ module shim_trigger_core #(
         data_word <= second_word; // Write second word
         trig_data_second_word <= 1; // Set flag to write second word next cycle
       end
-    // Write first word on trigger if buffer has at least two free entries
-    end else if (do_log && !data_buf_full && !data_buf_almost_full) begin
+    // Write first word on trigger if buffer has room for the whole entry
+    end else if (do_log && log_room) begin
       data_word_wr_en <= 1;
-      data_word <= trig_timer[31:0]; // First word is the lower 32 bits of the timer
-      second_word <= trig_timer[63:32]; // Second word is the upper 32 bits of the timer
+      last_log_time <= trig_timer;
+      if (!delta_mode) begin
+        data_word <= trig_timer[31:0]; // First word is the lower 32 bits of the timer
+        second_word <= trig_timer[63:32]; // Second word is the upper 32 bits of the timer
+      end else if (log_resync) begin
+        data_word <= {1'b1, trig_timer[62:32]}; // Flagged upper bits of the timer
+        second_word <= trig_timer[31:0]; // Lower 32 bits of the timer
+        delta_count <= 16'h0;
+        delta_synced <= 1;
+      end else begin
+        data_word <= {1'b0, log_delta[30:0]}; // Single delta word
+        trig_data_second_word <= 1; // Stop after this word
+        delta_count <= delta_count + 1;
+      end
     end
+    if (resetn && reset_count) delta_synced <= 0; // Next logged trigger after a count reset is a full timestamp
+  end
+
+  // Delta log mode select
+  always @(posedge clk) begin
+    if (!resetn) delta_mode <= 0;
+    else if (reset_count) delta_mode <= cmd_val[0];
   end
 
 endmodule
@@ -0,0 +1 @@
+../../../../shared_tests/fwft_fifo_model.py
\ No newline at end of file
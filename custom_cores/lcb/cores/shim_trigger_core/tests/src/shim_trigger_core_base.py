@@ -14,6 +14,7 @@ class shim_trigger_core_base:
         3: 'CMD_EXPECT_EXT_TRIG',
         4: 'CMD_DELAY',
         5: 'CMD_FORCE_TRIG',
+        6: 'CMD_RESET_COUNT',
         7: 'CMD_CANCEL'
     }
 
@@ -34,6 +35,7 @@ class shim_trigger_core_base:
         # Parameters
         self.TRIGGER_LOCKOUT_DEFAULT = int(self.dut.TRIGGER_LOCKOUT_DEFAULT.value)
         self.TRIGGER_LOCKOUT_MIN = int(self.dut.TRIGGER_LOCKOUT_MIN.value)
+        self.DELTA_RESYNC_INTERVAL = int(self.dut.DELTA_RESYNC_INTERVAL.value)
         self.MAX_CMD_VALUE = 0x1FFFFFFF  # 29 bits for cmd_value
 
         # Initialize clock
@@ -60,6 +62,9 @@ class shim_trigger_core_base:
         # For tracking expected trigger timing data
         self.expected_trig_timer_list = []
 
+        # For tracking logged trigger times in delta log mode
+        self.logged_trig_time_list = []
+
     def get_state_name(self, state_value):
         """Get the state name from the state value."""
         state_int = int(state_value)
@@ -80,6 +85,7 @@ class shim_trigger_core_base:
         self.data_buf.reset()
         self.executing_cmd_queue.clear()
         self.expected_trig_timer_list.clear()
+        self.logged_trig_time_list.clear()
 
         await RisingEdge(self.dut.clk)
 
@@ -153,10 +159,10 @@ class shim_trigger_core_base:
                 assert int(self.dut.next_cmd_state.value) == 1, \
                     f"next_cmd_state should be S_IDLE when cmd_buf_empty is 1, but got {self.get_state_name(int(self.dut.next_cmd_state.value))}"
                 
-            # next_cmd_state should be S_IDLE when cmd_type is CMD_CANCEL or CMD_FORCE_TRIG
-            elif int(self.dut.cmd_type.value) == 7 or int(self.dut.cmd_type.value) == 5:
+            # next_cmd_state should be S_IDLE when cmd_type is CMD_CANCEL, CMD_FORCE_TRIG or CMD_RESET_COUNT
+            elif int(self.dut.cmd_type.value) in (5, 6, 7):
                 assert int(self.dut.next_cmd_state.value) == 1, \
-                    f"next_cmd_state should be S_IDLE when cmd_type is CMD_CANCEL or CMD_FORCE_TRIG, but got {self.get_state_name(int(self.dut.next_cmd_state.value))}"
+                    f"next_cmd_state should be S_IDLE when cmd_type is CMD_CANCEL, CMD_FORCE_TRIG or CMD_RESET_COUNT, but got {self.get_state_name(int(self.dut.next_cmd_state.value))}"
                 
             # next_cmd_state should be S_IDLE or S_ERROR if cmd_type is CMD_SET_LOCKOUT and cmd_val is above or equal to TRIGGER_LOCKOUT_MIN or below it respectively
             elif int(self.dut.cmd_type.value) == 2:
@@ -268,12 +274,13 @@ class shim_trigger_core_base:
         if n == 0:
             return cmd_list
 
-        unexpected_prob = 0.05  # ~5% chance to produce an unexpected command (types 0 or 6)
+        unexpected_prob = 0.05  # ~5% chance to produce an unexpected command (type 0)
 
         while len(cmd_list) < n:
             # Pick whether to generate an unexpected command
+            # (CMD_RESET_COUNT is left out, since it restarts the timer the data scoreboard tracks)
             if random.random() < unexpected_prob:
-                cmd_type = random.choice([0, 6])  # unexpected types
+                cmd_type = 0  # unexpected type
             else:
                 cmd_type = random.choice([1, 2, 3, 4, 5, 7])  # expected types
 
@@ -374,6 +381,8 @@ class shim_trigger_core_base:
                     task = cocotb.start_soon(self.cmd_delay_scoreboard(cmd_value, command_i))
                 elif cmd_type == 5:
                     task = cocotb.start_soon(self.cmd_force_trig_scoreboard(cmd_value, command_i))
+                elif cmd_type == 6:
+                    task = cocotb.start_soon(self.cmd_reset_count_scoreboard(cmd_value, command_i))
                 elif cmd_type == 7:
                     task = cocotb.start_soon(self.cmd_cancel_scoreboard(cmd_value, command_i))
                 else:
@@ -582,6 +591,22 @@ class shim_trigger_core_base:
         assert int(self.dut.state.value) == 1, \
             f"For command index:{command_i} State should be S_IDLE after FORCE_TRIG command, but got {self.get_state_name(int(self.dut.state.value))}"
 
+    async def cmd_reset_count_scoreboard(self, cmd_value, command_i):
+        """ Scoreboard to verify RESET_COUNT command."""
+        self.dut._log.info(f"Verifying RESET_COUNT command for command index:{command_i} with value {cmd_value}")
+        assert int(self.dut.reset_count.value) == 1, "reset_count should be asserted immediately for RESET_COUNT command"
+
+        await RisingEdge(self.dut.clk)
+        await ReadOnly()
+        assert int(self.dut.trig_counter.value) == 0, \
+            f"For command index:{command_i} trig_counter should be 0 after RESET_COUNT command, but got {int(self.dut.trig_counter.value)}"
+        assert int(self.dut.trig_timer.value) == 0, \
+            f"For command index:{command_i} trig_timer should be 0 after RESET_COUNT command, but got {int(self.dut.trig_timer.value)}"
+        assert int(self.dut.delta_mode.value) == (cmd_value & 1), \
+            f"For command index:{command_i} delta_mode should be {cmd_value & 1} after RESET_COUNT command, but got {int(self.dut.delta_mode.value)}"
+        assert int(self.dut.delta_synced.value) == 0, \
+            f"For command index:{command_i} delta_synced should be 0 after RESET_COUNT command, but got {int(self.dut.delta_synced.value)}"
+
     async def cmd_cancel_scoreboard(self, cmd_value, command_i):
         """ Scoreboard to verify CANCEL command."""
         self.dut._log.info(f"Verifying CANCEL command for command index:{command_i} with value {cmd_value}")
@@ -690,6 +715,52 @@ class shim_trigger_core_base:
             num_of_data_words_checked += 1
         
         self.dut._log.info("Data buffer scoreboard for trig_timer finished.")
-        
 
-            
+    async def logged_trig_time_tracker(self):
+        """Record the trigger timer value of every trigger the DUT accepts for logging."""
+        while True:
+            await RisingEdge(self.dut.clk)
+            await ReadOnly()
+            if int(self.dut.do_log.value) == 1 and int(self.dut.data_word_wr_en.value) == 0 and int(self.dut.log_room.value) == 1:
+                self.logged_trig_time_list.append(int(self.dut.trig_timer.value))
+
+    async def data_buf_delta_scoreboard(self):
+        """
+        Decode delta log mode words from the data buffer model the same way the software does
+        and compare the rebuilt absolute times with the logged trigger times.
+        Only should be started after all commands have been sent and processed.
+        """
+        self.dut._log.info("Starting data buffer scoreboard for delta log mode.")
+        last_time = None
+        deltas_since_resync = 0
+
+        while len(self.logged_trig_time_list) > 0 or not self.data_buf.is_empty():
+            await RisingEdge(self.dut.clk)
+            await ReadOnly()
+            if self.data_buf.get_num_items() == 0:
+                continue
+
+            first_word = int(self.data_buf.peek_item())
+            if first_word & 0x80000000:
+                # Full timestamp pair, wait for the second word
+                if self.data_buf.get_num_items() < 2:
+                    continue
+                self.data_buf.pop_item()
+                second_word = int(self.data_buf.pop_item())
+                trig_time = ((first_word & 0x7FFFFFFF) << 32) | second_word
+                deltas_since_resync = 0
+            else:
+                self.data_buf.pop_item()
+                assert last_time is not None, f"Delta word 0x{first_word:08X} received before any full timestamp"
+                trig_time = last_time + first_word
+                deltas_since_resync += 1
+                assert deltas_since_resync < self.DELTA_RESYNC_INTERVAL, \
+                    f"{deltas_since_resync} delta words in a row, expected a full timestamp every {self.DELTA_RESYNC_INTERVAL} entries"
+
+            expected_time = self.logged_trig_time_list.pop(0)
+            assert trig_time == expected_time, \
+                f"Delta log time mismatch: expected {expected_time} but got {trig_time}"
+            self.dut._log.info(f"Delta log time match: {trig_time}")
+            last_time = trig_time
+
+        self.dut._log.info("Data buffer scoreboard for delta log mode finished.")
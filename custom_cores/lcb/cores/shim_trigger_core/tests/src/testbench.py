@@ -460,6 +460,67 @@ async def test_back_to_back_force_trig_cmd(dut):
     data_buf_task.kill()
     data_buf_scoreboard_task.kill()
 
+@cocotb.test()
+async def test_delta_log_mode(dut):
+    tb = await setup_testbench(dut)
+    tb.dut._log.info("STARTING TEST: test_delta_log_mode")
+
+    # First have the DUT at a known state
+    await tb.reset()
+
+    # Start monitor_cmd_done and monitor_state_transitions tasks
+    monitor_cmd_done_task = cocotb.start_soon(tb.monitor_cmd_done())
+    monitor_state_transitions_task = cocotb.start_soon(tb.monitor_state_transitions())
+
+    # Actual Reset
+    await tb.reset()
+
+    cmd_list = []
+
+    # Reset the count and switch to delta log mode
+    cmd_list.append(tb.command_word_generator(6, 1))
+
+    # Logged force triggers with varying delays between them (enough to cross several resync intervals)
+    for i in range(10):
+        cmd_list.append(tb.command_word_generator(5, 1 << 28))
+        cmd_list.append(tb.command_word_generator(4, 3 + 7 * i))
+
+    # Start the command buffer model, data buffer model and logged time tracker
+    await RisingEdge(dut.clk)
+    cmd_buf_task = cocotb.start_soon(tb.command_buf_model())
+    data_buf_task = cocotb.start_soon(tb.data_buf_model())
+    logged_time_task = cocotb.start_soon(tb.logged_trig_time_tracker())
+
+    # Start the scoreboard to monitor command execution
+    scoreboard_executing_cmd_task = cocotb.start_soon(tb.executing_command_scoreboard(len(cmd_list)))
+
+    # Send the commands to the command buffer
+    await tb.send_commands(cmd_list)
+
+    await scoreboard_executing_cmd_task
+
+    # All ten triggers should have been logged without overflow
+    assert len(tb.logged_trig_time_list) == 10, \
+        f"Expected 10 logged triggers but got {len(tb.logged_trig_time_list)}"
+    assert int(dut.data_buf_overflow.value) == 0, "data_buf_overflow should not be set"
+
+    # Decode the delta log and check the rebuilt times
+    data_buf_scoreboard_task = cocotb.start_soon(tb.data_buf_delta_scoreboard())
+    await data_buf_scoreboard_task
+
+    # Give time before ending the test and ensure we don't collide with other tests
+    await RisingEdge(dut.clk)
+    await RisingEdge(dut.clk)
+    await RisingEdge(dut.clk)
+    await RisingEdge(dut.clk)
+    cmd_buf_task.kill()
+    monitor_cmd_done_task.kill()
+    monitor_state_transitions_task.kill()
+    scoreboard_executing_cmd_task.kill()
+    logged_time_task.kill()
+    data_buf_task.kill()
+    data_buf_scoreboard_task.kill()
+
 @cocotb.test()
 async def test_random_cmd_sequence(dut):
     seed = 1234
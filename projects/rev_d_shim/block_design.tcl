@@ -16,6 +16,18 @@ if {$use_ext_clk != 0 && $use_ext_clk != 1} {
   exit 1
 }
 
+## Variably choose whether to feed the DAC command FIFOs from DDR
+# When set, each board's DAC command FIFO is also fed by an axi_ddr_fifo_reader that plays a
+# circular buffer in DDR through S_AXI_HP0, so whole waveforms can be uploaded once.
+# The PetaLinux build then also adds the u-dma-buf buffer, CMA, and module in cfg/.../petalinux/*/options/dac_cmd_ddr_buffer/
+set dac_cmd_ddr_buffer 0
+
+# If the DAC DDR buffer option is not 0 or 1, then error out
+if {$dac_cmd_ddr_buffer != 0 && $dac_cmd_ddr_buffer != 1} {
+  puts "Error: dac_cmd_ddr_buffer must be 0 or 1."
+  exit 1
+}
+
 ## Variably define the default SPI clock frequency (MHz)
 set spi_clk_freq_mhz 20.000
 
@@ -144,6 +156,7 @@ cell xilinx.com:ip:xlconstant:1.1 const_1 {
 
 ### Create processing system
 # Enable M_AXI_GP0 and M_AXI_GP1
+# Enable S_AXI_HP0 for the DAC DDR buffer readers (if used)
 # Enable UART1 on the correct MIO pins
 # UART1 baud rate 921600
 # Pullup for UART1 RX
@@ -157,6 +170,7 @@ init_ps ps {
   PCW_USE_M_AXI_GP0 1
   PCW_USE_M_AXI_GP1 1
   PCW_USE_S_AXI_ACP 0
+  PCW_USE_S_AXI_HP0 $dac_cmd_ddr_buffer
   PCW_UART1_PERIPHERAL_ENABLE 1
   PCW_UART1_UART1_IO {MIO 36 .. 37}
   PCW_UART1_BAUD_RATE 921600
@@ -174,6 +188,9 @@ init_ps ps {
   M_AXI_GP0_ACLK ps/FCLK_CLK0
   M_AXI_GP1_ACLK ps/FCLK_CLK0
 }
+if {$dac_cmd_ddr_buffer} {
+  wire ps/S_AXI_HP0_ACLK ps/FCLK_CLK0
+}
 
 ## PS clock reset core
 # Create proc_sys_reset
@@ -444,6 +461,14 @@ for {set i 0} {$i < $board_count} {incr i} {
 }
 # Trigger command and data FIFOs
 addr 0x80100000 128 axi_spi_interface/trig_fifo_axi_bridge/S_AXI ps/M_AXI_GP1
+# DAC DDR buffer readers: registers next to each board's FIFOs, reading all of DDR through S_AXI_HP0
+if {$dac_cmd_ddr_buffer} {
+  wire axi_spi_interface/M_AXI ps/S_AXI_HP0
+  for {set i 0} {$i < $board_count} {incr i} {
+    addr 0x800${i}2000 128 axi_spi_interface/dac_ddr_reader_${i}/S_AXI ps/M_AXI_GP1
+    addr 0x00000000 1G ps/S_AXI_HP0 axi_spi_interface/dac_ddr_reader_${i}/M_AXI
+  }
+}
 
 ## AXI-domain over/underflow detection
 wire axi_spi_interface/dac_cmd_buf_overflow hw_manager/dac_cmd_buf_overflow
@@ -471,9 +496,10 @@ addr 0x40100000 256 status_reg/S_AXI ps/M_AXI_GP0
 #  1151 : 1120 --  32b SPI clock frequency in Hz
 #  1183 : 1152 --  32b Debug 1 (SPI clock locked, spi_off, DAC/ADC ~CS high time)
 #  1215 : 1184 --  32b Trigger counter (number of triggers received)
-#  2047 : 1216 -- RESERVED (0)
+#  1247 : 1216 --  32b Design options (0: DAC DDR buffer readers present)
+#  2047 : 1248 -- RESERVED (0)
 cell xilinx.com:ip:xlconcat:2.1 sts_concat {
-  NUM_PORTS 7
+  NUM_PORTS 8
 } {
   In0 hw_manager/status_word
   In1 axi_spi_interface/cmd_fifo_sts
@@ -504,12 +530,20 @@ cell xilinx.com:ip:xlconstant:1.1 pad_17 {
   dout debug_1/In4
 }
 
+# Design options
+cell xilinx.com:ip:xlconstant:1.1 design_opts {
+  CONST_VAL $dac_cmd_ddr_buffer
+  CONST_WIDTH 32
+} {
+  dout sts_concat/In6
+}
+
 # Pad reserved bits
 cell xilinx.com:ip:xlconstant:1.1 pad_sts_reserved {
   CONST_VAL 0
-  CONST_WIDTH [expr {2048 - 1216}]
+  CONST_WIDTH [expr {2048 - 1248}]
 } {
-  dout sts_concat/In6
+  dout sts_concat/In7
 }
 
 ## IRQ interrupt concat
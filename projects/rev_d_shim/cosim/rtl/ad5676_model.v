@@ -0,0 +1,78 @@
+`timescale 1 ns / 1 ps
+
+// Behavioral AD5676 for the co-simulation.
+// 24-bit frames {cmd[3:0], addr[3:0], data[15:0]} are shifted in MSB first while n_cs is low
+// and acted on once n_cs is back high:
+//   0001 write input register, 0011 write input and DAC register, 1001 read back an input register.
+// LDAC (the controllers' active-high pulse) copies every input register to its DAC register.
+// A readback comes out on SDO during the next frame as {8'h00, data}. SDI is sampled on the
+// rising edge of sclk and SDO changes on the falling edge, so with the MISO clock looped back
+// with no delay each bit is stable when shim_ad5676_dac_ctrl samples it; the last bit is held
+// after the frame, where the controller takes its final readback bit.
+module ad5676_model (
+  input  wire         sclk,
+  input  wire         n_cs,
+  input  wire         sdi,
+  output reg          sdo,
+  input  wire         ldac,
+  output wire [127:0] dac_out // DAC register per channel (offset binary), channel 0 in the low bits
+);
+
+  localparam CMD_WRITE_INPUT  = 4'b0001;
+  localparam CMD_WRITE_UPDATE = 4'b0011;
+  localparam CMD_READBACK     = 4'b1001;
+
+  reg [23:0] shift_in   = 24'd0;
+  reg [ 4:0] bit_count  = 5'd0;  // Bits shifted in during the current frame
+  reg [23:0] sdo_frame  = 24'd0; // Shifted out during the current frame
+  reg [15:0] input_reg [0:7];
+  reg [15:0] dac_reg   [0:7];
+
+  integer i;
+  initial begin
+    sdo = 1'b0;
+    for (i = 0; i < 8; i = i + 1) begin
+      input_reg[i] = 16'h0000;
+      dac_reg[i] = 16'h0000;
+    end
+  end
+
+  // Input shift register and frame decode (input registers use blocking writes so
+  // an LDAC on the same edge as the frame's end picks up the new value)
+  always @(posedge sclk) begin
+    if (!n_cs) begin
+      shift_in <= {shift_in[22:0], sdi};
+      if (bit_count != 5'd31) bit_count <= bit_count + 1;
+    end else if (bit_count != 0) begin
+      sdo_frame <= 24'd0;
+      if (bit_count == 5'd24) begin
+        case (shift_in[23:20])
+          CMD_WRITE_INPUT: input_reg[shift_in[18:16]] = shift_in[15:0];
+          CMD_WRITE_UPDATE: begin
+            input_reg[shift_in[18:16]] = shift_in[15:0];
+            dac_reg[shift_in[18:16]] <= shift_in[15:0];
+          end
+          CMD_READBACK: sdo_frame <= {8'h00, input_reg[shift_in[18:16]]};
+          default: ;
+        endcase
+      end
+      bit_count <= 5'd0;
+    end
+    if (ldac) begin
+      for (i = 0; i < 8; i = i + 1) dac_reg[i] <= input_reg[i];
+    end
+  end
+
+  // Readback output, one bit per clock (held on the last bit once the frame is over)
+  always @(negedge sclk) begin
+    sdo <= sdo_frame[5'd23 - ((bit_count > 5'd23) ? 5'd23 : bit_count)];
+  end
+
+  genvar ch;
+  generate
+    for (ch = 0; ch < 8; ch = ch + 1) begin : out_gen
+      assign dac_out[16 * ch +: 16] = dac_reg[ch];
+    end
+  endgenerate
+
+endmodule
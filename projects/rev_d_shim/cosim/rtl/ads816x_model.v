@@ -0,0 +1,55 @@
+`timescale 1 ns / 1 ps
+
+// Behavioral ADS8168 (on-the-fly mode only) for the co-simulation.
+// Frames are shifted in MSB first while n_cs is low and acted on once n_cs is back high:
+//   24-bit {00001, addr[10:0], data[7:0]} writes a register,
+//   24-bit {00010, addr[10:0], 8'd0} reads a register back as {data, 8'h00} in the next frame,
+//   16-bit {2'b10, ch[2:0], 11'd0} requests channel ch, output in the next frame.
+// Conversions are ideal: a channel reads back analog_in for that channel (offset binary, the
+// same code the ADC would produce for the DAC output wired to it). SDO changes on the falling
+// edge of sclk and holds its last bit after the frame, matching shim_ads816x_adc_ctrl's capture
+// with a zero-delay MISO clock loopback.
+module ads816x_model (
+  input  wire         sclk,
+  input  wire         n_cs,
+  input  wire         sdi,
+  output reg          sdo,
+  input  wire [127:0] analog_in // Input per channel, channel 0 in the low bits
+);
+
+  localparam SPI_CMD_REG_WRITE = 5'b00001;
+  localparam SPI_CMD_REG_READ  = 5'b00010;
+
+  reg [23:0] shift_in  = 24'd0;
+  reg [ 4:0] bit_count = 5'd0;  // Bits shifted in during the current frame
+  reg [15:0] sdo_frame = 16'd0; // Shifted out during the current frame
+  reg [ 7:0] regs [0:255];      // Low 256 register addresses (covers OTF_CFG at 0x2A)
+
+  integer i;
+  initial begin
+    sdo = 1'b0;
+    for (i = 0; i < 256; i = i + 1) regs[i] = 8'h00;
+  end
+
+  always @(posedge sclk) begin
+    if (!n_cs) begin
+      shift_in <= {shift_in[22:0], sdi};
+      if (bit_count != 5'd31) bit_count <= bit_count + 1;
+    end else if (bit_count != 0) begin
+      sdo_frame <= 16'd0;
+      if (bit_count == 5'd24) begin
+        if (shift_in[23:19] == SPI_CMD_REG_WRITE) regs[shift_in[15:8]] <= shift_in[7:0];
+        else if (shift_in[23:19] == SPI_CMD_REG_READ) sdo_frame <= {regs[shift_in[15:8]], 8'h00};
+      end else if (bit_count == 5'd16 && shift_in[15:14] == 2'b10) begin
+        sdo_frame <= analog_in[16 * shift_in[13:11] +: 16];
+      end
+      bit_count <= 5'd0;
+    end
+  end
+
+  // Conversion/readback output, one bit per clock (held on the last bit once the frame is over)
+  always @(negedge sclk) begin
+    sdo <= sdo_frame[4'd15 - ((bit_count > 5'd15) ? 4'd15 : bit_count[3:0])];
+  end
+
+endmodule
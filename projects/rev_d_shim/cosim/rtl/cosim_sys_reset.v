@@ -0,0 +1,31 @@
+`timescale 1 ns / 1 ps
+
+// Stand-in for Xilinx proc_sys_reset: synchronizes an active-low external reset to
+// slowest_sync_clk and holds peripheral_aresetn low for HOLD_CYCLES more cycles.
+module cosim_sys_reset #(
+  parameter integer HOLD_CYCLES = 16
+)(
+  input  wire slowest_sync_clk,
+  input  wire ext_reset_in,     // Active low
+  output reg  peripheral_aresetn
+);
+
+  reg [1:0] reset_sync = 2'b00;
+  reg [7:0] hold_count = 8'd0;
+
+  initial peripheral_aresetn = 1'b0;
+
+  always @(posedge slowest_sync_clk) begin
+    reset_sync <= {reset_sync[0], ext_reset_in};
+    if (!reset_sync[1]) begin
+      hold_count <= 8'd0;
+      peripheral_aresetn <= 1'b0;
+    end else if (hold_count < HOLD_CYCLES) begin
+      hold_count <= hold_count + 1;
+      peripheral_aresetn <= 1'b0;
+    end else begin
+      peripheral_aresetn <= 1'b1;
+    end
+  end
+
+endmodule
@@ -0,0 +1,789 @@
+`timescale 1 ns / 1 ps
+
+// Programmable logic of the Rev D shim for the Verilator co-simulation.
+// Mirrors block_design.tcl (and its modules) with the PS, clock wizard, I/O buffers and
+// DDR buffer readers removed: the real control, status, FIFO, bridge and SPI cores are
+// wired as in the block design, and each board's SPI pins go to behavioral AD5676 and
+// ADS816x models (each ADC channel reads back the same board's DAC channel).
+//
+// The harness drives the PS side:
+//   - cfg_*  is the AXI-Lite port of shim_axi_sys_ctrl (offset within 0x40000000)
+//   - fifo_* is one AXI4 port shared by the FIFO bridges, fifo_axi_sel picks the bridge
+//            (2*i: DAC board i, 2*i+1: ADC board i, 16: trigger), as the address decode does
+//   - sts_data is the status register contents (0x40100000)
+module shim_cosim_top #(
+  parameter integer BOARD_COUNT = 4,
+  parameter integer SPI_CLK_FREQ_HZ = 20000000,
+  parameter integer DAC_CMD_FIFO_ADDR_WIDTH = 13,
+  parameter integer DAC_DATA_FIFO_ADDR_WIDTH = 12,
+  parameter integer ADC_CMD_FIFO_ADDR_WIDTH = 10,
+  parameter integer ADC_DATA_FIFO_ADDR_WIDTH = 13,
+  parameter integer TRIG_CMD_FIFO_ADDR_WIDTH = 10,
+  parameter integer TRIG_DATA_FIFO_ADDR_WIDTH = 10,
+  // Hardware manager timeouts (aclk cycles), shortened from the block design defaults
+  // so a simulated boot doesn't take seconds of model time
+  parameter integer SHUTDOWN_FORCE_DELAY = 10000,
+  parameter integer SHUTDOWN_RESET_PULSE = 1000,
+  parameter integer SHUTDOWN_RESET_DELAY = 10000,
+  parameter integer SPI_RESET_WAIT = 100000,
+  parameter integer SPI_START_WAIT = 10000000
+)(
+  input  wire         aclk,
+  input  wire         aresetn,
+  input  wire         spi_clk,
+  input  wire         ext_trig,
+  input  wire         ext_en,         // Manual_Enable
+
+  // Configuration registers (AXI-Lite)
+  input  wire [15:0]  cfg_awaddr,
+  input  wire         cfg_awvalid,
+  output wire         cfg_awready,
+  input  wire [31:0]  cfg_wdata,
+  input  wire [ 3:0]  cfg_wstrb,
+  input  wire         cfg_wvalid,
+  output wire         cfg_wready,
+  output wire [ 1:0]  cfg_bresp,
+  output wire         cfg_bvalid,
+  input  wire         cfg_bready,
+  input  wire [15:0]  cfg_araddr,
+  input  wire         cfg_arvalid,
+  output wire         cfg_arready,
+  output wire [31:0]  cfg_rdata,
+  output wire [ 1:0]  cfg_rresp,
+  output wire         cfg_rvalid,
+  input  wire         cfg_rready,
+
+  // FIFO bridges (AXI4, single beats from the harness)
+  input  wire [ 4:0]  fifo_axi_sel,
+  input  wire [31:0]  fifo_awaddr,
+  input  wire         fifo_awvalid,
+  output wire         fifo_awready,
+  input  wire [31:0]  fifo_wdata,
+  input  wire         fifo_wvalid,
+  output wire         fifo_wready,
+  output wire [ 1:0]  fifo_bresp,
+  output wire         fifo_bvalid,
+  input  wire         fifo_bready,
+  input  wire [31:0]  fifo_araddr,
+  input  wire         fifo_arvalid,
+  output wire         fifo_arready,
+  output wire [31:0]  fifo_rdata,
+  output wire [ 1:0]  fifo_rresp,
+  output wire         fifo_rvalid,
+  input  wire         fifo_rready,
+
+  // Status register contents
+  output wire [1247:0] sts_data,
+
+  // Probes for the harness's latency measurements
+  output wire         ldac,
+  output wire [ 7:0]  n_dac_cs,
+  output wire [ 7:0]  n_adc_cs,
+  output wire [ 7:0]  dac_data_wr_en,
+  output wire [ 7:0]  adc_data_wr_en,
+  output wire         trig_out,
+  output wire         ps_interrupt
+);
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Configuration and hardware manager (aclk)
+
+  wire        unlock_cfg;
+  wire        sys_en;
+  wire [16:0] cmd_buf_reset;
+  wire [16:0] data_buf_reset;
+  wire [14:0] integ_thresh_avg;
+  wire [31:0] integ_window;
+  wire        integ_en;
+  wire [15:0] boot_test_skip;
+  wire [15:0] debug;
+  wire        mosi_sck_pol;
+  wire        miso_sck_pol;
+  wire signed [15:0] dac_cal_init;
+  wire        sys_en_oob, cmd_buf_reset_oob, data_buf_reset_oob, integ_thresh_avg_oob;
+  wire        integ_window_oob, integ_en_oob, boot_test_skip_oob, debug_oob;
+  wire        mosi_sck_pol_oob, miso_sck_pol_oob, dac_cal_init_oob;
+  wire        sys_ctrl_lock_viol;
+
+  shim_axi_sys_ctrl #(
+    .AXI_ADDR_WIDTH(16),
+    .INTEG_THRESHOLD_AVERAGE_DEFAULT(16384),
+    .INTEG_WINDOW_DEFAULT(5000000),
+    .INTEG_EN_DEFAULT(1),
+    .MOSI_SCK_POL_DEFAULT(0),
+    .MISO_SCK_POL_DEFAULT(1),
+    .DAC_CAL_INIT_DEFAULT(14)
+  ) axi_sys_ctrl (
+    .aclk(aclk),
+    .aresetn(aresetn),
+    .unlock(unlock_cfg),
+    .sys_en(sys_en),
+    .cmd_buf_reset(cmd_buf_reset),
+    .data_buf_reset(data_buf_reset),
+    .integ_thresh_avg(integ_thresh_avg),
+    .integ_window(integ_window),
+    .integ_en(integ_en),
+    .boot_test_skip(boot_test_skip),
+    .debug(debug),
+    .mosi_sck_pol(mosi_sck_pol),
+    .miso_sck_pol(miso_sck_pol),
+    .dac_cal_init(dac_cal_init),
+    .sys_en_oob(sys_en_oob),
+    .cmd_buf_reset_oob(cmd_buf_reset_oob),
+    .data_buf_reset_oob(data_buf_reset_oob),
+    .integ_thresh_avg_oob(integ_thresh_avg_oob),
+    .integ_window_oob(integ_window_oob),
+    .integ_en_oob(integ_en_oob),
+    .boot_test_skip_oob(boot_test_skip_oob),
+    .debug_oob(debug_oob),
+    .mosi_sck_pol_oob(mosi_sck_pol_oob),
+    .miso_sck_pol_oob(miso_sck_pol_oob),
+    .dac_cal_init_oob(dac_cal_init_oob),
+    .lock_viol(sys_ctrl_lock_viol),
+    .s_axi_awaddr(cfg_awaddr),
+    .s_axi_awvalid(cfg_awvalid),
+    .s_axi_awready(cfg_awready),
+    .s_axi_wdata(cfg_wdata),
+    .s_axi_wstrb(cfg_wstrb),
+    .s_axi_wvalid(cfg_wvalid),
+    .s_axi_wready(cfg_wready),
+    .s_axi_bresp(cfg_bresp),
+    .s_axi_bvalid(cfg_bvalid),
+    .s_axi_bready(cfg_bready),
+    .s_axi_araddr(cfg_araddr),
+    .s_axi_arvalid(cfg_arvalid),
+    .s_axi_arready(cfg_arready),
+    .s_axi_rdata(cfg_rdata),
+    .s_axi_rresp(cfg_rresp),
+    .s_axi_rvalid(cfg_rvalid),
+    .s_axi_rready(cfg_rready)
+  );
+
+  // SPI ~CS high time calculations
+  wire [4:0] dac_n_cs_high_time;
+  wire [7:0] adc_n_cs_high_time;
+  wire       dac_calc_done, adc_calc_done;
+  wire       dac_calc_lock_viol, adc_calc_lock_viol;
+
+  shim_ad5676_dac_timing_calc dac_timing_calc (
+    .clk(aclk),
+    .resetn(aresetn),
+    .spi_clk_freq_hz(SPI_CLK_FREQ_HZ),
+    .calc(~unlock_cfg),
+    .n_cs_high_time(dac_n_cs_high_time),
+    .done(dac_calc_done),
+    .lock_viol(dac_calc_lock_viol)
+  );
+  shim_ads816x_adc_timing_calc #(
+    .ADS_MODEL_ID(8)
+  ) adc_timing_calc (
+    .clk(aclk),
+    .resetn(aresetn),
+    .spi_clk_freq_hz(SPI_CLK_FREQ_HZ),
+    .calc(~unlock_cfg),
+    .n_cs_high_time(adc_n_cs_high_time),
+    .done(adc_calc_done),
+    .lock_viol(adc_calc_lock_viol)
+  );
+
+  // Status from the SPI domain (synchronized to aclk) and the FIFO bridges
+  wire        spi_off;
+  wire [ 7:0] over_thresh, thresh_underflow, thresh_overflow;
+  wire [31:0] trig_counter;
+  wire        bad_trig_cmd, trig_data_buf_overflow;
+  wire [ 7:0] dac_boot_fail, bad_dac_cmd, dac_cal_oob, dac_val_oob;
+  wire [ 7:0] dac_cmd_buf_underflow, dac_data_buf_overflow, unexp_dac_trig;
+  wire [ 7:0] ldac_misalign, dac_delay_too_short;
+  wire [ 7:0] adc_boot_fail, bad_adc_cmd, adc_cmd_buf_underflow, adc_data_buf_overflow;
+  wire [ 7:0] unexp_adc_trig, adc_delay_too_short;
+  wire [16:0] bridge_overflow;  // Write to a full command FIFO
+  wire [16:0] bridge_underflow; // Read from an empty data FIFO
+
+  wire [7:0] dac_cmd_buf_overflow, dac_data_buf_underflow;
+  wire [7:0] adc_cmd_buf_overflow, adc_data_buf_underflow;
+
+  wire spi_clk_gate;
+  wire spi_en;
+  wire block_bufs;
+  wire [31:0] hw_status_word;
+
+  shim_hw_manager #(
+    .SHUTDOWN_FORCE_DELAY(SHUTDOWN_FORCE_DELAY),
+    .SHUTDOWN_RESET_PULSE(SHUTDOWN_RESET_PULSE),
+    .SHUTDOWN_RESET_DELAY(SHUTDOWN_RESET_DELAY),
+    .SPI_RESET_WAIT(SPI_RESET_WAIT),
+    .SPI_START_WAIT(SPI_START_WAIT)
+  ) hw_manager (
+    .clk(aclk),
+    .aresetn(aresetn),
+    .sys_en(sys_en),
+    .spi_off(spi_off),
+    .calc_n_cs_done(dac_calc_done | adc_calc_done),
+    .ext_en(ext_en),
+    .lock_viol(dac_calc_lock_viol | adc_calc_lock_viol | sys_ctrl_lock_viol),
+    .sys_en_oob(sys_en_oob),
+    .cmd_buf_reset_oob(cmd_buf_reset_oob),
+    .data_buf_reset_oob(data_buf_reset_oob),
+    .integ_thresh_avg_oob(integ_thresh_avg_oob),
+    .integ_window_oob(integ_window_oob),
+    .integ_en_oob(integ_en_oob),
+    .boot_test_skip_oob(boot_test_skip_oob),
+    .debug_oob(debug_oob),
+    .mosi_sck_pol_oob(mosi_sck_pol_oob),
+    .miso_sck_pol_oob(miso_sck_pol_oob),
+    .dac_cal_init_oob(dac_cal_init_oob),
+    .shutdown_sense(8'd0),
+    .over_thresh(over_thresh),
+    .thresh_underflow(thresh_underflow),
+    .thresh_overflow(thresh_overflow),
+    .bad_trig_cmd(bad_trig_cmd),
+    .trig_cmd_buf_overflow(bridge_overflow[16]),
+    .trig_data_buf_underflow(bridge_underflow[16]),
+    .trig_data_buf_overflow(trig_data_buf_overflow),
+    .dac_boot_fail(dac_boot_fail),
+    .bad_dac_cmd(bad_dac_cmd),
+    .dac_cal_oob(dac_cal_oob),
+    .dac_val_oob(dac_val_oob),
+    .dac_cmd_buf_underflow(dac_cmd_buf_underflow),
+    .dac_cmd_buf_overflow(dac_cmd_buf_overflow),
+    .dac_data_buf_underflow(dac_data_buf_underflow),
+    .dac_data_buf_overflow(dac_data_buf_overflow),
+    .unexp_dac_trig(unexp_dac_trig),
+    .ldac_misalign(ldac_misalign),
+    .dac_delay_too_short(dac_delay_too_short),
+    .adc_boot_fail(adc_boot_fail),
+    .bad_adc_cmd(bad_adc_cmd),
+    .adc_cmd_buf_underflow(adc_cmd_buf_underflow),
+    .adc_cmd_buf_overflow(adc_cmd_buf_overflow),
+    .adc_data_buf_underflow(adc_data_buf_underflow),
+    .adc_data_buf_overflow(adc_data_buf_overflow),
+    .unexp_adc_trig(unexp_adc_trig),
+    .adc_delay_too_short(adc_delay_too_short),
+    .unlock_cfg(unlock_cfg),
+    .spi_clk_gate(spi_clk_gate),
+    .spi_en(spi_en),
+    .shutdown_sense_en(),
+    .block_bufs(block_bufs),
+    .n_shutdown_force(),
+    .shutdown_rst(),
+    .status_word(hw_status_word),
+    .ps_interrupt(ps_interrupt)
+  );
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // SPI clock domain
+
+  // SPI clock as seen by the boards (gated by the hardware manager, like the BUFGCE).
+  // The MISO clock comes back from the boards with its delay already compensated
+  // by the polarity setting, so the cores see the same edges as spi_clk.
+  reg  spi_clk_gate_en = 1'b0;
+  always @(negedge spi_clk) spi_clk_gate_en <= spi_clk_gate;
+  wire spi_sck = spi_clk & spi_clk_gate_en;
+
+  wire spi_sync_resetn;
+  cosim_sys_reset sync_reset (
+    .slowest_sync_clk(spi_clk),
+    .ext_reset_in(aresetn),
+    .peripheral_aresetn(spi_sync_resetn)
+  );
+
+  wire        spi_en_sync;
+  wire        block_bufs_sync;
+  wire [14:0] integ_thresh_avg_sync;
+  wire [31:0] integ_window_sync;
+  wire        integ_en_sync;
+  wire [ 4:0] dac_n_cs_high_time_sync;
+  wire [ 7:0] adc_n_cs_high_time_sync;
+  wire [15:0] boot_test_skip_sync;
+  wire [15:0] debug_sync;
+  wire signed [15:0] dac_cal_init_sync;
+
+  shim_spi_cfg_sync spi_cfg_sync (
+    .aclk(aclk),
+    .aresetn(aresetn),
+    .spi_clk(spi_clk),
+    .spi_resetn(spi_sync_resetn),
+    .spi_en(spi_en),
+    .block_bufs(block_bufs),
+    .integ_thresh_avg(integ_thresh_avg),
+    .integ_window(integ_window),
+    .integ_en(integ_en),
+    .dac_n_cs_high_time(dac_n_cs_high_time),
+    .adc_n_cs_high_time(adc_n_cs_high_time),
+    .boot_test_skip(boot_test_skip),
+    .debug(debug),
+    .dac_cal_init(dac_cal_init),
+    .spi_en_sync(spi_en_sync),
+    .block_bufs_sync(block_bufs_sync),
+    .integ_thresh_avg_sync(integ_thresh_avg_sync),
+    .integ_window_sync(integ_window_sync),
+    .integ_en_sync(integ_en_sync),
+    .dac_n_cs_high_time_sync(dac_n_cs_high_time_sync),
+    .adc_n_cs_high_time_sync(adc_n_cs_high_time_sync),
+    .boot_test_skip_sync(boot_test_skip_sync),
+    .debug_sync(debug_sync),
+    .dac_cal_init_sync(dac_cal_init_sync)
+  );
+
+  wire spi_core_resetn;
+  cosim_sys_reset spi_rst_core (
+    .slowest_sync_clk(spi_clk),
+    .ext_reset_in(spi_en_sync),
+    .peripheral_aresetn(spi_core_resetn)
+  );
+
+  // Per-board signals in the SPI domain (unused boards padded as in the block design)
+  wire [7:0] dac_setup_done_ch, adc_setup_done;
+  wire [7:0] over_thresh_spi, thresh_underflow_spi, thresh_overflow_spi;
+  wire [7:0] dac_boot_fail_spi, bad_dac_cmd_spi, dac_cal_oob_spi, dac_val_oob_spi;
+  wire [7:0] dac_cmd_buf_underflow_spi, dac_data_buf_overflow_spi, unexp_dac_trig_spi;
+  wire [7:0] ldac_misalign_spi, dac_delay_too_short_spi;
+  wire [7:0] adc_boot_fail_spi, bad_adc_cmd_spi, adc_cmd_buf_underflow_spi, adc_data_buf_overflow_spi;
+  wire [7:0] unexp_adc_trig_spi, adc_delay_too_short_spi;
+  wire [7:0] dac_waiting_for_trig, adc_waiting_for_trig;
+  wire [7:0] board_ldac;
+  wire       ldac_shared = |board_ldac;
+  wire       spi_off_spi = ~&(dac_setup_done_ch & adc_setup_done);
+
+  wire [31:0] trig_counter_spi;
+  wire        bad_trig_cmd_spi, trig_data_buf_overflow_spi;
+
+  shim_spi_sts_sync spi_sts_sync (
+    .aclk(aclk),
+    .aresetn(aresetn),
+    .spi_clk(spi_clk),
+    .spi_resetn(spi_sync_resetn),
+    .spi_off(spi_off_spi),
+    .over_thresh(over_thresh_spi),
+    .thresh_underflow(thresh_underflow_spi),
+    .thresh_overflow(thresh_overflow_spi),
+    .trig_counter(trig_counter_spi),
+    .bad_trig_cmd(bad_trig_cmd_spi),
+    .trig_data_buf_overflow(trig_data_buf_overflow_spi),
+    .dac_boot_fail(dac_boot_fail_spi),
+    .bad_dac_cmd(bad_dac_cmd_spi),
+    .dac_cal_oob(dac_cal_oob_spi),
+    .dac_val_oob(dac_val_oob_spi),
+    .dac_cmd_buf_underflow(dac_cmd_buf_underflow_spi),
+    .dac_data_buf_overflow(dac_data_buf_overflow_spi),
+    .unexp_dac_trig(unexp_dac_trig_spi),
+    .ldac_misalign(ldac_misalign_spi),
+    .dac_delay_too_short(dac_delay_too_short_spi),
+    .adc_boot_fail(adc_boot_fail_spi),
+    .bad_adc_cmd(bad_adc_cmd_spi),
+    .adc_cmd_buf_underflow(adc_cmd_buf_underflow_spi),
+    .adc_data_buf_overflow(adc_data_buf_overflow_spi),
+    .unexp_adc_trig(unexp_adc_trig_spi),
+    .adc_delay_too_short(adc_delay_too_short_spi),
+    .spi_off_sync(spi_off),
+    .over_thresh_sync(over_thresh),
+    .thresh_underflow_sync(thresh_underflow),
+    .thresh_overflow_sync(thresh_overflow),
+    .trig_counter_sync(trig_counter),
+    .bad_trig_cmd_sync(bad_trig_cmd),
+    .trig_data_buf_overflow_sync(trig_data_buf_overflow),
+    .dac_boot_fail_sync(dac_boot_fail),
+    .bad_dac_cmd_sync(bad_dac_cmd),
+    .dac_cal_oob_sync(dac_cal_oob),
+    .dac_val_oob_sync(dac_val_oob),
+    .dac_cmd_buf_underflow_sync(dac_cmd_buf_underflow),
+    .dac_data_buf_overflow_sync(dac_data_buf_overflow),
+    .unexp_dac_trig_sync(unexp_dac_trig),
+    .ldac_misalign_sync(ldac_misalign),
+    .dac_delay_too_short_sync(dac_delay_too_short),
+    .adc_boot_fail_sync(adc_boot_fail),
+    .bad_adc_cmd_sync(bad_adc_cmd),
+    .adc_cmd_buf_underflow_sync(adc_cmd_buf_underflow),
+    .adc_data_buf_overflow_sync(adc_data_buf_overflow),
+    .unexp_adc_trig_sync(unexp_adc_trig),
+    .adc_delay_too_short_sync(adc_delay_too_short)
+  );
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // FIFOs and AXI bridges
+  // Index 2*i is DAC board i, 2*i+1 is ADC board i, 16 is the trigger (as cmd_buf_reset)
+
+  wire [31:0] cmd_fifo_rd_data [0:16];
+  wire        cmd_fifo_rd_en   [0:16];
+  wire        cmd_fifo_empty   [0:16];
+  wire [31:0] data_fifo_wr_data[0:16];
+  wire        data_fifo_wr_en  [0:16];
+  wire        data_fifo_full   [0:16];
+  wire        data_fifo_almost_full [0:16];
+  wire [31:0] cmd_fifo_sts     [0:16];
+  wire [31:0] data_fifo_sts    [0:16];
+
+  wire [16:0] bridge_awready, bridge_wready, bridge_bvalid, bridge_arready, bridge_rvalid;
+  wire [ 1:0] bridge_bresp [0:16];
+  wire [ 1:0] bridge_rresp [0:16];
+  wire [31:0] bridge_rdata [0:16];
+
+  genvar i;
+  generate
+    for (i = 0; i < 17; i = i + 1) begin : buf_gen
+      localparam integer IS_TRIG = (i == 16);
+      localparam integer IS_ADC = (i % 2 == 1) && !IS_TRIG;
+      localparam integer CMD_AW = IS_TRIG ? TRIG_CMD_FIFO_ADDR_WIDTH
+                                : IS_ADC ? ADC_CMD_FIFO_ADDR_WIDTH : DAC_CMD_FIFO_ADDR_WIDTH;
+      localparam integer DATA_AW = IS_TRIG ? TRIG_DATA_FIFO_ADDR_WIDTH
+                                 : IS_ADC ? ADC_DATA_FIFO_ADDR_WIDTH : DAC_DATA_FIFO_ADDR_WIDTH;
+
+      if (IS_TRIG || (i / 2) < BOARD_COUNT) begin : present
+        // Buffer resets, one per FIFO clock
+        wire cmd_aclk_resetn, cmd_spi_resetn, data_aclk_resetn, data_spi_resetn;
+        cosim_sys_reset cmd_aclk_rst (.slowest_sync_clk(aclk), .ext_reset_in(~cmd_buf_reset[i]), .peripheral_aresetn(cmd_aclk_resetn));
+        cosim_sys_reset cmd_spi_rst (.slowest_sync_clk(spi_clk), .ext_reset_in(~cmd_buf_reset[i]), .peripheral_aresetn(cmd_spi_resetn));
+        cosim_sys_reset data_aclk_rst (.slowest_sync_clk(aclk), .ext_reset_in(~data_buf_reset[i]), .peripheral_aresetn(data_aclk_resetn));
+        cosim_sys_reset data_spi_rst (.slowest_sync_clk(spi_clk), .ext_reset_in(~data_buf_reset[i]), .peripheral_aresetn(data_spi_resetn));
+
+        wire [31:0]      cmd_wr_data;
+        wire             cmd_wr_en;
+        wire             cmd_full, cmd_almost_full, cmd_almost_empty;
+        wire [CMD_AW:0]  cmd_count;
+        wire [31:0]      data_rd_data;
+        wire             data_rd_en;
+        wire             data_empty, data_almost_empty;
+        wire [DATA_AW:0] data_count;
+
+        fifo_async #(
+          .DATA_WIDTH(32),
+          .ADDR_WIDTH(CMD_AW)
+        ) cmd_fifo (
+          .wr_clk(aclk),
+          .wr_rst_n(cmd_aclk_resetn),
+          .wr_data(cmd_wr_data),
+          .wr_en(cmd_wr_en),
+          .fifo_count_wr_clk(cmd_count),
+          .full(cmd_full),
+          .almost_full(cmd_almost_full),
+          .rd_clk(spi_clk),
+          .rd_rst_n(cmd_spi_resetn),
+          .rd_data(cmd_fifo_rd_data[i]),
+          .rd_en(cmd_fifo_rd_en[i]),
+          .fifo_count_rd_clk(),
+          .empty(cmd_fifo_empty[i]),
+          .almost_empty(cmd_almost_empty)
+        );
+        assign cmd_fifo_sts[i] = {1'b1, cmd_almost_empty, cmd_fifo_empty[i], cmd_almost_full, cmd_full,
+                                  {(26 - CMD_AW){1'b0}}, cmd_count};
+
+        fifo_async #(
+          .DATA_WIDTH(32),
+          .ADDR_WIDTH(DATA_AW)
+        ) data_fifo (
+          .wr_clk(spi_clk),
+          .wr_rst_n(data_spi_resetn),
+          .wr_data(data_fifo_wr_data[i]),
+          .wr_en(data_fifo_wr_en[i]),
+          .fifo_count_wr_clk(),
+          .full(data_fifo_full[i]),
+          .almost_full(data_fifo_almost_full[i]),
+          .rd_clk(aclk),
+          .rd_rst_n(data_aclk_resetn),
+          .rd_data(data_rd_data),
+          .rd_en(data_rd_en),
+          .fifo_count_rd_clk(data_count),
+          .empty(data_empty),
+          .almost_empty(data_almost_empty)
+        );
+        assign data_fifo_sts[i] = {1'b1, data_almost_empty, data_empty, data_fifo_almost_full[i], data_fifo_full[i],
+                                   {(26 - DATA_AW){1'b0}}, data_count};
+
+        wire sel = (fifo_axi_sel == i);
+        axi_fifo_bridge #(
+          .AXI_ADDR_WIDTH(32),
+          .AXI_DATA_WIDTH(32)
+        ) bridge (
+          .aclk(aclk),
+          .wr_resetn(cmd_spi_resetn),
+          .rd_resetn(data_spi_resetn),
+          .s_axi_awid(12'd0),
+          .s_axi_awaddr(fifo_awaddr),
+          .s_axi_awlen(8'd0),
+          .s_axi_awsize(3'd2),
+          .s_axi_awburst(2'b01),
+          .s_axi_awvalid(fifo_awvalid & sel),
+          .s_axi_awready(bridge_awready[i]),
+          .s_axi_wdata(fifo_wdata),
+          .s_axi_wstrb(4'hF),
+          .s_axi_wlast(1'b1),
+          .s_axi_wvalid(fifo_wvalid & sel),
+          .s_axi_wready(bridge_wready[i]),
+          .s_axi_bid(),
+          .s_axi_bresp(bridge_bresp[i]),
+          .s_axi_bvalid(bridge_bvalid[i]),
+          .s_axi_bready(fifo_bready & sel),
+          .s_axi_arid(12'd0),
+          .s_axi_araddr(fifo_araddr),
+          .s_axi_arlen(8'd0),
+          .s_axi_arsize(3'd2),
+          .s_axi_arburst(2'b01),
+          .s_axi_arvalid(fifo_arvalid & sel),
+          .s_axi_arready(bridge_arready[i]),
+          .s_axi_rid(),
+          .s_axi_rdata(bridge_rdata[i]),
+          .s_axi_rresp(bridge_rresp[i]),
+          .s_axi_rlast(),
+          .s_axi_rvalid(bridge_rvalid[i]),
+          .s_axi_rready(fifo_rready & sel),
+          .fifo_wr_data(cmd_wr_data),
+          .fifo_wr_en(cmd_wr_en),
+          .fifo_full(cmd_full),
+          .fifo_rd_data(data_rd_data),
+          .fifo_rd_en(data_rd_en),
+          .fifo_empty(data_empty),
+          .fifo_underflow(bridge_underflow[i]),
+          .fifo_overflow(bridge_overflow[i])
+        );
+      end else begin : absent
+        assign cmd_fifo_rd_data[i] = 32'd0;
+        assign cmd_fifo_empty[i] = 1'b1;
+        assign data_fifo_full[i] = 1'b0;
+        assign data_fifo_almost_full[i] = 1'b0;
+        assign cmd_fifo_sts[i] = 32'd0;
+        assign data_fifo_sts[i] = 32'd0;
+        assign bridge_awready[i] = 1'b0;
+        assign bridge_wready[i] = 1'b0;
+        assign bridge_bvalid[i] = 1'b0;
+        assign bridge_bresp[i] = 2'b00;
+        assign bridge_arready[i] = 1'b0;
+        assign bridge_rvalid[i] = 1'b0;
+        assign bridge_rresp[i] = 2'b00;
+        assign bridge_rdata[i] = 32'd0;
+        assign bridge_underflow[i] = 1'b0;
+        assign bridge_overflow[i] = 1'b0;
+      end
+
+      assign sts_data[32 + 32 * i +: 32] = cmd_fifo_sts[i];
+      assign sts_data[576 + 32 * i +: 32] = data_fifo_sts[i];
+    end
+  endgenerate
+
+  // Shared FIFO port (a deselected or missing bridge never answers; the harness times out)
+  assign fifo_awready = (fifo_axi_sel <= 16) ? bridge_awready[fifo_axi_sel] : 1'b0;
+  assign fifo_wready  = (fifo_axi_sel <= 16) ? bridge_wready[fifo_axi_sel]  : 1'b0;
+  assign fifo_bvalid  = (fifo_axi_sel <= 16) ? bridge_bvalid[fifo_axi_sel]  : 1'b0;
+  assign fifo_bresp   = (fifo_axi_sel <= 16) ? bridge_bresp[fifo_axi_sel]   : 2'b00;
+  assign fifo_arready = (fifo_axi_sel <= 16) ? bridge_arready[fifo_axi_sel] : 1'b0;
+  assign fifo_rvalid  = (fifo_axi_sel <= 16) ? bridge_rvalid[fifo_axi_sel]  : 1'b0;
+  assign fifo_rresp   = (fifo_axi_sel <= 16) ? bridge_rresp[fifo_axi_sel]   : 2'b00;
+  assign fifo_rdata   = (fifo_axi_sel <= 16) ? bridge_rdata[fifo_axi_sel]   : 32'd0;
+
+  generate
+    for (i = 0; i < 8; i = i + 1) begin : flag_gen
+      assign dac_cmd_buf_overflow[i]   = bridge_overflow[2 * i];
+      assign adc_cmd_buf_overflow[i]   = bridge_overflow[2 * i + 1];
+      assign dac_data_buf_underflow[i] = bridge_underflow[2 * i];
+      assign adc_data_buf_underflow[i] = bridge_underflow[2 * i + 1];
+    end
+  endgenerate
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Trigger core
+
+  wire [31:0] trig_data_word;
+  wire        trig_data_word_wr_en;
+  assign data_fifo_wr_data[16] = trig_data_word;
+  assign data_fifo_wr_en[16] = trig_data_word_wr_en;
+
+  shim_trigger_core #(
+    .TRIGGER_LOCKOUT_DEFAULT(10000000)
+  ) trig_core (
+    .clk(spi_clk),
+    .resetn(spi_core_resetn),
+    .cmd_word_rd_en(cmd_fifo_rd_en[16]),
+    .cmd_word(cmd_fifo_rd_data[16]),
+    .cmd_buf_empty(cmd_fifo_empty[16] | block_bufs_sync),
+    .data_word_wr_en(trig_data_word_wr_en),
+    .data_word(trig_data_word),
+    .data_buf_full(data_fifo_full[16] | block_bufs_sync),
+    .data_buf_almost_full(data_fifo_almost_full[16]),
+    .ext_trig(ext_trig),
+    .dac_waiting_for_trig(dac_waiting_for_trig),
+    .adc_waiting_for_trig(adc_waiting_for_trig),
+    .trig_out(trig_out),
+    .trig_counter(trig_counter_spi),
+    .data_buf_overflow(trig_data_buf_overflow_spi),
+    .bad_cmd(bad_trig_cmd_spi)
+  );
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // DAC and ADC channels, each with its board's converter models
+
+  generate
+    for (i = 0; i < 8; i = i + 1) begin : board_gen
+      if (i < BOARD_COUNT) begin : present
+        localparam integer DAC = 2 * i;
+        localparam integer ADC = 2 * i + 1;
+
+        wire          dac_mosi, dac_miso, dac_setup_done, integ_setup_done;
+        wire          adc_mosi, adc_miso;
+        wire [119:0]  abs_dac_val_concat;
+        wire [127:0]  dac_out;
+        wire          dac_miso_resetn, adc_miso_resetn;
+        wire [31:0]   dac_data_word, adc_data_word;
+
+        assign data_fifo_wr_data[DAC] = dac_data_word;
+        assign data_fifo_wr_data[ADC] = adc_data_word;
+        assign dac_data_wr_en[i] = data_fifo_wr_en[DAC];
+        assign adc_data_wr_en[i] = data_fifo_wr_en[ADC];
+
+        // DAC channel
+        cosim_sys_reset dac_miso_rst (
+          .slowest_sync_clk(spi_sck),
+          .ext_reset_in(spi_core_resetn),
+          .peripheral_aresetn(dac_miso_resetn)
+        );
+        shim_ad5676_dac_ctrl #(
+          .ABS_CAL_MAX(4096)
+        ) dac_spi (
+          .clk(spi_clk),
+          .resetn(spi_core_resetn),
+          .boot_test_skip(boot_test_skip_sync[DAC]),
+          .debug(debug_sync[DAC]),
+          .n_cs_high_time(dac_n_cs_high_time_sync),
+          .cal_init_val(dac_cal_init_sync),
+          .setup_done(dac_setup_done),
+          .cmd_buf_rd_en(cmd_fifo_rd_en[DAC]),
+          .cmd_buf_word(cmd_fifo_rd_data[DAC]),
+          .cmd_buf_empty(cmd_fifo_empty[DAC] | block_bufs_sync),
+          .data_buf_wr_en(data_fifo_wr_en[DAC]),
+          .data_word(dac_data_word),
+          .data_buf_full(data_fifo_full[DAC] | (block_bufs_sync & ~debug_sync[DAC])),
+          .trigger(trig_out),
+          .ldac_shared(ldac_shared),
+          .waiting_for_trig(dac_waiting_for_trig[i]),
+          .boot_fail(dac_boot_fail_spi[i]),
+          .cmd_buf_underflow(dac_cmd_buf_underflow_spi[i]),
+          .data_buf_overflow(dac_data_buf_overflow_spi[i]),
+          .unexp_trig(unexp_dac_trig_spi[i]),
+          .ldac_misalign(ldac_misalign_spi[i]),
+          .delay_too_short(dac_delay_too_short_spi[i]),
+          .bad_cmd(bad_dac_cmd_spi[i]),
+          .cal_oob(dac_cal_oob_spi[i]),
+          .dac_val_oob(dac_val_oob_spi[i]),
+          .abs_dac_val_concat(abs_dac_val_concat),
+          .n_cs(n_dac_cs[i]),
+          .mosi(dac_mosi),
+          .miso_sck(spi_sck),
+          .miso_resetn(dac_miso_resetn),
+          .miso(dac_miso),
+          .ldac(board_ldac[i])
+        );
+        shim_threshold_integrator threshold_core (
+          .clk(spi_clk),
+          .resetn(spi_core_resetn),
+          .enable(integ_en_sync),
+          .window(integ_window_sync),
+          .threshold_average(integ_thresh_avg_sync),
+          .sample_core_done(dac_setup_done),
+          .abs_sample_concat(abs_dac_val_concat),
+          .err_overflow(thresh_overflow_spi[i]),
+          .err_underflow(thresh_underflow_spi[i]),
+          .over_thresh(over_thresh_spi[i]),
+          .setup_done(integ_setup_done)
+        );
+        assign dac_setup_done_ch[i] = (~integ_en_sync | integ_setup_done) & dac_setup_done;
+
+        ad5676_model dac_model (
+          .sclk(spi_sck),
+          .n_cs(n_dac_cs[i]),
+          .sdi(dac_mosi),
+          .sdo(dac_miso),
+          .ldac(ldac_shared),
+          .dac_out(dac_out)
+        );
+
+        // ADC channel
+        cosim_sys_reset adc_miso_rst (
+          .slowest_sync_clk(spi_sck),
+          .ext_reset_in(spi_core_resetn),
+          .peripheral_aresetn(adc_miso_resetn)
+        );
+        shim_ads816x_adc_ctrl #(
+          .BOARD_ID(i)
+        ) adc_spi (
+          .clk(spi_clk),
+          .resetn(spi_core_resetn),
+          .boot_test_skip(boot_test_skip_sync[ADC]),
+          .debug(debug_sync[ADC]),
+          .n_cs_high_time(adc_n_cs_high_time_sync),
+          .setup_done(adc_setup_done[i]),
+          .cmd_buf_rd_en(cmd_fifo_rd_en[ADC]),
+          .cmd_buf_word(cmd_fifo_rd_data[ADC]),
+          .cmd_buf_empty(cmd_fifo_empty[ADC] | block_bufs_sync),
+          .data_buf_wr_en(data_fifo_wr_en[ADC]),
+          .data_word(adc_data_word),
+          .data_buf_full(data_fifo_full[ADC] | (block_bufs_sync & ~debug_sync[ADC])),
+          .trigger(trig_out),
+          .waiting_for_trig(adc_waiting_for_trig[i]),
+          .boot_fail(adc_boot_fail_spi[i]),
+          .cmd_buf_underflow(adc_cmd_buf_underflow_spi[i]),
+          .data_buf_overflow(adc_data_buf_overflow_spi[i]),
+          .unexp_trig(unexp_adc_trig_spi[i]),
+          .delay_too_short(adc_delay_too_short_spi[i]),
+          .bad_cmd(bad_adc_cmd_spi[i]),
+          .n_cs(n_adc_cs[i]),
+          .mosi(adc_mosi),
+          .miso_sck(spi_sck),
+          .miso_resetn(adc_miso_resetn),
+          .miso(adc_miso)
+        );
+
+        ads816x_model adc_model (
+          .sclk(spi_sck),
+          .n_cs(n_adc_cs[i]),
+          .sdi(adc_mosi),
+          .sdo(adc_miso),
+          .analog_in(dac_out)
+        );
+      end else begin : absent
+        assign dac_setup_done_ch[i] = 1'b1;
+        assign adc_setup_done[i] = 1'b1;
+        assign dac_waiting_for_trig[i] = 1'b1;
+        assign adc_waiting_for_trig[i] = 1'b1;
+        assign board_ldac[i] = 1'b0;
+        assign n_dac_cs[i] = 1'b1;
+        assign n_adc_cs[i] = 1'b1;
+        assign dac_data_wr_en[i] = 1'b0;
+        assign adc_data_wr_en[i] = 1'b0;
+        assign data_fifo_wr_en[2 * i] = 1'b0;
+        assign data_fifo_wr_en[2 * i + 1] = 1'b0;
+        assign data_fifo_wr_data[2 * i] = 32'd0;
+        assign data_fifo_wr_data[2 * i + 1] = 32'd0;
+        assign cmd_fifo_rd_en[2 * i] = 1'b0;
+        assign cmd_fifo_rd_en[2 * i + 1] = 1'b0;
+        assign over_thresh_spi[i] = 1'b0;
+        assign thresh_underflow_spi[i] = 1'b0;
+        assign thresh_overflow_spi[i] = 1'b0;
+        assign dac_boot_fail_spi[i] = 1'b0;
+        assign bad_dac_cmd_spi[i] = 1'b0;
+        assign dac_cal_oob_spi[i] = 1'b0;
+        assign dac_val_oob_spi[i] = 1'b0;
+        assign dac_cmd_buf_underflow_spi[i] = 1'b0;
+        assign dac_data_buf_overflow_spi[i] = 1'b0;
+        assign unexp_dac_trig_spi[i] = 1'b0;
+        assign ldac_misalign_spi[i] = 1'b0;
+        assign dac_delay_too_short_spi[i] = 1'b0;
+        assign adc_boot_fail_spi[i] = 1'b0;
+        assign bad_adc_cmd_spi[i] = 1'b0;
+        assign adc_cmd_buf_underflow_spi[i] = 1'b0;
+        assign adc_data_buf_overflow_spi[i] = 1'b0;
+        assign unexp_adc_trig_spi[i] = 1'b0;
+        assign adc_delay_too_short_spi[i] = 1'b0;
+      end
+    end
+  endgenerate
+
+  assign ldac = ldac_shared;
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Status register (layout as in block_design.tcl)
+
+  assign sts_data[31:0]      = hw_status_word;
+  assign sts_data[1151:1120] = SPI_CLK_FREQ_HZ;
+  assign sts_data[1183:1152] = {17'd0, adc_n_cs_high_time, dac_n_cs_high_time, spi_off, 1'b1};
+  assign sts_data[1215:1184] = trig_counter;
+  assign sts_data[1247:1216] = 32'd0; // No DAC DDR buffer readers
+
+endmodule
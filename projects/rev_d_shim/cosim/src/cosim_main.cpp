@@ -0,0 +1,698 @@
+// shim-cosim: runs the Verilated programmable logic (rtl/shim_cosim_top.v) and serves
+// shim-test's register and FIFO accesses from the shared memory mailbox in hw_cosim.h,
+// measuring access round trips, DAC/ADC latency and FIFO occupancy as it goes.
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <verilated.h>
+#include "Vshim_cosim_top.h"
+#if VM_TRACE
+#include <verilated_vcd_c.h>
+#endif
+
+extern "C" {
+#include "hw_cosim.h"
+#include "map_memory.h"
+#include "sys_ctrl.h"
+#include "sys_sts.h"
+#include "spi_clk_ctrl.h"
+#include "dac_ctrl.h"
+#include "adc_ctrl.h"
+#include "trigger_ctrl.h"
+}
+
+//////////////////// Harness Settings ////////////////////
+#define ACLK_HALF_PERIOD_PS     5000ULL   // 100 MHz FCLK_CLK0
+#define RESET_CYCLES            32        // aclk cycles aresetn is held low at startup
+#define AXI_TIMEOUT_CYCLES      4096      // aclk cycles before an unanswered access gives up
+#define FREE_RUN_CHUNK_CYCLES   64        // aclk cycles run between mailbox polls when free-running
+#define OCCUPANCY_POLL_CYCLES   8         // aclk cycles between FIFO occupancy samples
+#define EXT_TRIG_PULSE_CYCLES   4         // SPI clock cycles an external trigger pulse is held high
+#define ADC_TIMESTAMP_DEPTH     (1 << 16) // Sample timestamps kept per ADC board
+#define FIFO_SEL_TRIG           16        // fifo_axi_sel of the trigger bridge
+
+#define AXI_RESP_OKAY   0
+#define AXI_RESP_SLVERR 2
+//////////////////////////////////////////////////////////////////
+
+// Running min/mean/max of a latency in picoseconds
+struct latency_stat_t {
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t min = UINT64_MAX;
+  uint64_t max = 0;
+
+  void add(uint64_t value) {
+    count++;
+    sum += value;
+    min = std::min(min, value);
+    max = std::max(max, value);
+  }
+};
+
+struct harness_t {
+  Vshim_cosim_top *top = nullptr;
+#if VM_TRACE
+  VerilatedVcdC *vcd = nullptr;
+#endif
+  hw_cosim_mailbox_t *mb = nullptr;
+  const char *shm_name = HW_COSIM_DEFAULT_NAME;
+  bool verbose = false;
+  uint32_t lockstep_cycles = 0;   // 0: free-run between accesses
+  uint64_t ext_trig_period = 0;   // SPI clock cycles between external trigger pulses (0: none)
+
+  // Timeline
+  uint64_t time_ps = 0;
+  uint64_t spi_half_period_ps = 0;
+  uint64_t next_aclk_edge_ps = 0;
+  uint64_t next_spi_edge_ps = 0;
+  uint64_t aclk_cycles = 0;
+  uint64_t spi_clk_cycles = 0;
+  uint32_t spi_clk_freq_hz = 0;
+  uint32_t board_count = 0;
+
+  // Probe history
+  uint8_t prev_n_dac_cs = 0xFF;
+  uint8_t prev_ldac = 0;
+  uint32_t prev_hw_status = 0;
+
+  // DAC latency: a write into an empty command FIFO until the next ~CS fall and LDAC
+  bool dac_pending_cs[8] = {};
+  bool dac_pending_ldac[8] = {};
+  uint64_t dac_write_ps[8] = {};
+  latency_stat_t dac_cs_latency;
+  latency_stat_t dac_ldac_latency;
+
+  // ADC latency: each sample written to the data FIFO until software reads it
+  std::deque<uint64_t> adc_sample_ps[8];
+  latency_stat_t adc_read_latency;
+
+  // Access round trips (model aclk cycles, host wall time in ns)
+  latency_stat_t access_cycles[4];
+  latency_stat_t access_wall_ns[4];
+  uint64_t decerr_count = 0;
+  uint64_t timeout_count = 0;
+
+  // Peak FIFO occupancy (words), indexed like fifo_axi_sel
+  uint32_t cmd_fifo_peak[17] = {};
+  uint32_t data_fifo_peak[17] = {};
+  uint64_t hw_status_changes = 0;
+
+  // Clock wizard registers (no clock is reconfigured, it always reports locked)
+  std::map<uint32_t, uint32_t> spi_clk_regs;
+};
+
+enum { ACCESS_CFG, ACCESS_STS, ACCESS_FIFO_WRITE, ACCESS_FIFO_READ };
+static const char *g_access_names[4] = {"config register", "status register", "FIFO write", "FIFO read"};
+
+static harness_t g_h;
+static volatile sig_atomic_t g_stop = 0;
+
+// Stop serving, print the report and remove the mailbox
+static void handle_signal(int sig) {
+  (void)sig;
+  g_stop = 1;
+}
+
+static bool pid_alive(uint32_t pid) {
+  return pid != 0 && (kill((pid_t)pid, 0) == 0 || errno != ESRCH);
+}
+
+static uint32_t sts_word(uint32_t index) {
+  return (index * 32 < 1248) ? (uint32_t)g_h.top->sts_data[index] : 0;
+}
+
+//////////////////// Clocks and Probes ////////////////////
+
+// Sample the SPI-domain probes after a rising SPI clock edge
+static void on_spi_posedge() {
+  Vshim_cosim_top *top = g_h.top;
+  uint8_t n_dac_cs = top->n_dac_cs;
+  uint8_t ldac = top->ldac;
+
+  for (uint32_t b = 0; b < g_h.board_count; b++) {
+    bool cs_fell = ((g_h.prev_n_dac_cs >> b) & 1) && !((n_dac_cs >> b) & 1);
+    if (cs_fell && g_h.dac_pending_cs[b]) {
+      g_h.dac_cs_latency.add(g_h.time_ps - g_h.dac_write_ps[b]);
+      g_h.dac_pending_cs[b] = false;
+    }
+    if (ldac && !g_h.prev_ldac && g_h.dac_pending_ldac[b]) {
+      g_h.dac_ldac_latency.add(g_h.time_ps - g_h.dac_write_ps[b]);
+      g_h.dac_pending_ldac[b] = false;
+    }
+    if ((top->adc_data_wr_en >> b) & 1) {
+      if (g_h.adc_sample_ps[b].size() >= ADC_TIMESTAMP_DEPTH) g_h.adc_sample_ps[b].pop_front();
+      g_h.adc_sample_ps[b].push_back(g_h.time_ps);
+    }
+  }
+  g_h.prev_n_dac_cs = n_dac_cs;
+  g_h.prev_ldac = ldac;
+
+  if (g_h.ext_trig_period != 0) {
+    top->ext_trig = (g_h.spi_clk_cycles % g_h.ext_trig_period) < EXT_TRIG_PULSE_CYCLES;
+  }
+}
+
+// Sample the aclk-domain status after a rising aclk edge
+static void on_aclk_posedge() {
+  uint32_t hw_status = sts_word(HW_STS_REG_OFFSET);
+  if (hw_status != g_h.prev_hw_status) {
+    g_h.hw_status_changes++;
+    if (g_h.verbose) {
+      printf("[%10.3f us] Hardware state %u, status code 0x%04X, board %u\n", g_h.time_ps / 1e6,
+             HW_STS_STATE(hw_status), HW_STS_CODE(hw_status), HW_STS_BOARD(hw_status));
+    }
+    g_h.prev_hw_status = hw_status;
+  }
+
+  if (g_h.aclk_cycles % OCCUPANCY_POLL_CYCLES == 0) {
+    for (int i = 0; i < 17; i++) {
+      uint32_t cmd = FIFO_STS_WORD_COUNT(sts_word(1 + i));
+      uint32_t data = FIFO_STS_WORD_COUNT(sts_word(18 + i));
+      g_h.cmd_fifo_peak[i] = std::max(g_h.cmd_fifo_peak[i], cmd);
+      g_h.data_fifo_peak[i] = std::max(g_h.data_fifo_peak[i], data);
+    }
+  }
+}
+
+// Process the next clock edge(s). Returns true if aclk rose.
+static bool step_edge() {
+  Vshim_cosim_top *top = g_h.top;
+  uint64_t t = std::min(g_h.next_aclk_edge_ps, g_h.next_spi_edge_ps);
+  bool aclk_rose = false;
+  bool spi_rose = false;
+
+  g_h.time_ps = t;
+  if (g_h.next_aclk_edge_ps == t) {
+    top->aclk = !top->aclk;
+    g_h.next_aclk_edge_ps += ACLK_HALF_PERIOD_PS;
+    if (top->aclk) {
+      g_h.aclk_cycles++;
+      aclk_rose = true;
+    }
+  }
+  if (g_h.next_spi_edge_ps == t) {
+    top->spi_clk = !top->spi_clk;
+    g_h.next_spi_edge_ps += g_h.spi_half_period_ps;
+    if (top->spi_clk) {
+      g_h.spi_clk_cycles++;
+      spi_rose = true;
+    }
+  }
+  top->eval();
+#if VM_TRACE
+  if (g_h.vcd) g_h.vcd->dump(t);
+#endif
+
+  if (spi_rose) on_spi_posedge();
+  if (aclk_rose) on_aclk_posedge();
+  return aclk_rose;
+}
+
+// Run up to (not including) the next rising aclk edge
+static void run_to_aclk_posedge() {
+  while (!(g_h.next_aclk_edge_ps <= g_h.next_spi_edge_ps && !g_h.top->aclk)) step_edge();
+}
+
+// Run whole aclk cycles
+static void run_cycles(uint64_t cycles) {
+  for (uint64_t i = 0; i < cycles; i++) {
+    while (!step_edge()) {}
+  }
+}
+
+//////////////////// AXI Master ////////////////////
+// Inputs change just after a rising aclk edge; a handshake is taken from the valid/ready
+// pair right before the next rising edge, as the slave sees it.
+
+static uint32_t axi_lite_write(uint32_t offset, uint32_t value) {
+  Vshim_cosim_top *top = g_h.top;
+  top->cfg_awaddr = offset;
+  top->cfg_awvalid = 1;
+  top->cfg_wdata = value;
+  top->cfg_wstrb = 0xF;
+  top->cfg_wvalid = 1;
+  top->cfg_bready = 1;
+  top->eval();
+
+  for (int n = 0; n < AXI_TIMEOUT_CYCLES; n++) {
+    run_to_aclk_posedge();
+    bool aw = top->cfg_awvalid && top->cfg_awready;
+    bool w = top->cfg_wvalid && top->cfg_wready;
+    bool b = top->cfg_bvalid && top->cfg_bready;
+    uint32_t resp = top->cfg_bresp;
+    step_edge();
+    if (aw) top->cfg_awvalid = 0;
+    if (w) top->cfg_wvalid = 0;
+    if (b) top->cfg_bready = 0;
+    top->eval();
+    if (b) return resp;
+  }
+  top->cfg_awvalid = 0;
+  top->cfg_wvalid = 0;
+  top->cfg_bready = 0;
+  top->eval();
+  g_h.timeout_count++;
+  return AXI_RESP_SLVERR;
+}
+
+static uint32_t axi_lite_read(uint32_t offset, uint32_t *value) {
+  Vshim_cosim_top *top = g_h.top;
+  top->cfg_araddr = offset;
+  top->cfg_arvalid = 1;
+  top->cfg_rready = 1;
+  top->eval();
+
+  for (int n = 0; n < AXI_TIMEOUT_CYCLES; n++) {
+    run_to_aclk_posedge();
+    bool ar = top->cfg_arvalid && top->cfg_arready;
+    bool r = top->cfg_rvalid && top->cfg_rready;
+    uint32_t data = top->cfg_rdata;
+    uint32_t resp = top->cfg_rresp;
+    step_edge();
+    if (ar) top->cfg_arvalid = 0;
+    if (r) top->cfg_rready = 0;
+    top->eval();
+    if (r) {
+      *value = data;
+      return resp;
+    }
+  }
+  top->cfg_arvalid = 0;
+  top->cfg_rready = 0;
+  top->eval();
+  g_h.timeout_count++;
+  *value = 0;
+  return AXI_RESP_SLVERR;
+}
+
+static uint32_t axi_fifo_write(uint32_t sel, uint32_t addr, uint32_t value) {
+  Vshim_cosim_top *top = g_h.top;
+  top->fifo_axi_sel = sel;
+  top->fifo_awaddr = addr;
+  top->fifo_awvalid = 1;
+  top->fifo_wdata = value;
+  top->fifo_wvalid = 1;
+  top->fifo_bready = 1;
+  top->eval();
+
+  for (int n = 0; n < AXI_TIMEOUT_CYCLES; n++) {
+    run_to_aclk_posedge();
+    bool aw = top->fifo_awvalid && top->fifo_awready;
+    bool w = top->fifo_wvalid && top->fifo_wready;
+    bool b = top->fifo_bvalid && top->fifo_bready;
+    uint32_t resp = top->fifo_bresp;
+    step_edge();
+    if (aw) top->fifo_awvalid = 0;
+    if (w) top->fifo_wvalid = 0;
+    if (b) top->fifo_bready = 0;
+    top->eval();
+    if (b) return resp;
+  }
+  top->fifo_awvalid = 0;
+  top->fifo_wvalid = 0;
+  top->fifo_bready = 0;
+  top->eval();
+  g_h.timeout_count++;
+  return AXI_RESP_SLVERR;
+}
+
+static uint32_t axi_fifo_read(uint32_t sel, uint32_t addr, uint32_t *value) {
+  Vshim_cosim_top *top = g_h.top;
+  top->fifo_axi_sel = sel;
+  top->fifo_araddr = addr;
+  top->fifo_arvalid = 1;
+  top->fifo_rready = 1;
+  top->eval();
+
+  for (int n = 0; n < AXI_TIMEOUT_CYCLES; n++) {
+    run_to_aclk_posedge();
+    bool ar = top->fifo_arvalid && top->fifo_arready;
+    bool r = top->fifo_rvalid && top->fifo_rready;
+    uint32_t data = top->fifo_rdata;
+    uint32_t resp = top->fifo_rresp;
+    step_edge();
+    if (ar) top->fifo_arvalid = 0;
+    if (r) top->fifo_rready = 0;
+    top->eval();
+    if (r) {
+      *value = data;
+      return resp;
+    }
+  }
+  top->fifo_arvalid = 0;
+  top->fifo_rready = 0;
+  top->eval();
+  g_h.timeout_count++;
+  *value = 0;
+  return AXI_RESP_SLVERR;
+}
+
+//////////////////// Address Decode ////////////////////
+
+// FIFO bridge for an address (fifo_axi_sel value, -1 if none)
+static int fifo_sel(uint32_t phys_addr) {
+  if (phys_addr - (uint32_t)TRIG_FIFO < AXI_FIFO_BRIDGE_RANGE) return FIFO_SEL_TRIG;
+  // The bridges ignore the address within their range, so burst beats all reach the FIFO
+  for (uint32_t b = 0; b < g_h.board_count; b++) {
+    if (phys_addr - (uint32_t)DAC_FIFO(b) < AXI_FIFO_BRIDGE_RANGE) return 2 * b;
+    if (phys_addr - (uint32_t)ADC_FIFO(b) < AXI_FIFO_BRIDGE_RANGE) return 2 * b + 1;
+  }
+  return -1;
+}
+
+// Forget latency bookkeeping for buffers the software is resetting
+static void note_buf_reset(uint32_t offset, uint32_t value) {
+  for (uint32_t b = 0; b < g_h.board_count; b++) {
+    if (offset == CMD_BUF_RESET_OFFSET && ((value >> (2 * b)) & 1)) {
+      g_h.dac_pending_cs[b] = false;
+      g_h.dac_pending_ldac[b] = false;
+    }
+    if (offset == DATA_BUF_RESET_OFFSET && ((value >> (2 * b + 1)) & 1)) {
+      g_h.adc_sample_ps[b].clear();
+    }
+  }
+}
+
+static uint32_t do_access(uint32_t op, uint32_t phys_addr, uint32_t *data, int *kind) {
+  bool write = (op == HW_COSIM_OP_WRITE);
+
+  if (phys_addr - SYS_CTRL_BASE < 0x10000) {
+    *kind = ACCESS_CFG;
+    uint32_t offset = phys_addr - SYS_CTRL_BASE;
+    if (!write) return axi_lite_read(offset, data);
+    if (offset / 4 == CMD_BUF_RESET_OFFSET || offset / 4 == DATA_BUF_RESET_OFFSET) note_buf_reset(offset / 4, *data);
+    return axi_lite_write(offset, *data);
+  }
+
+  if (phys_addr - SYS_STS < 0x1000) {
+    *kind = ACCESS_STS;
+    run_cycles(1); // Status register read latency
+    if (!write) *data = sts_word((phys_addr - SYS_STS) / 4);
+    return AXI_RESP_OKAY;
+  }
+
+  if (phys_addr - SPI_CLK_BASE < SPI_CLK_WORDCOUNT * 4) {
+    *kind = ACCESS_CFG;
+    run_cycles(1);
+    uint32_t offset = phys_addr - SPI_CLK_BASE;
+    if (write) g_h.spi_clk_regs[offset] = *data;
+    else *data = (offset == SPI_CLK_STATUS_OFFSET) ? 1 : g_h.spi_clk_regs[offset];
+    return AXI_RESP_OKAY;
+  }
+
+  int sel = fifo_sel(phys_addr);
+  if (sel < 0) {
+    if (!write) *data = 0;
+    return HW_COSIM_RESP_DECERR;
+  }
+
+  if (write) {
+    *kind = ACCESS_FIFO_WRITE;
+    // Start a DAC latency measurement on a write into an empty command FIFO
+    if (sel != FIFO_SEL_TRIG && (sel % 2) == 0 && FIFO_STS_EMPTY(sts_word(1 + sel))) {
+      uint32_t b = sel / 2;
+      g_h.dac_pending_cs[b] = true;
+      g_h.dac_pending_ldac[b] = true;
+      g_h.dac_write_ps[b] = g_h.time_ps;
+    }
+    return axi_fifo_write(sel, phys_addr, *data);
+  }
+
+  *kind = ACCESS_FIFO_READ;
+  bool had_data = !FIFO_STS_EMPTY(sts_word(18 + sel));
+  uint32_t resp = axi_fifo_read(sel, phys_addr, data);
+  if (sel != FIFO_SEL_TRIG && (sel % 2) == 1 && had_data && !g_h.adc_sample_ps[sel / 2].empty()) {
+    g_h.adc_read_latency.add(g_h.time_ps - g_h.adc_sample_ps[sel / 2].front());
+    g_h.adc_sample_ps[sel / 2].pop_front();
+  }
+  return resp;
+}
+
+//////////////////// Mailbox ////////////////////
+
+static void service_request() {
+  hw_cosim_mailbox_t *mb = g_h.mb;
+  auto wall_start = std::chrono::steady_clock::now();
+  uint64_t cycle_start = g_h.aclk_cycles;
+
+  uint32_t data = mb->data;
+  int kind = ACCESS_CFG;
+  uint32_t resp = do_access(mb->op, mb->addr, &data, &kind);
+  if (resp == HW_COSIM_RESP_DECERR) {
+    g_h.decerr_count++;
+  } else {
+    g_h.access_cycles[kind].add(g_h.aclk_cycles - cycle_start);
+    g_h.access_wall_ns[kind].add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - wall_start).count());
+  }
+  if (g_h.lockstep_cycles > 0) run_cycles(g_h.lockstep_cycles);
+
+  mb->data = data;
+  mb->resp = resp;
+  mb->aclk_cycles = g_h.aclk_cycles;
+  mb->spi_clk_cycles = g_h.spi_clk_cycles;
+  __atomic_store_n(&mb->ack_seq, mb->req_seq, __ATOMIC_RELEASE);
+}
+
+static int create_mailbox() {
+  shm_unlink(g_h.shm_name); // Clear out a mailbox left by a harness that crashed
+  int fd = shm_open(g_h.shm_name, O_CREAT | O_EXCL | O_RDWR, 0666);
+  if (fd < 0) {
+    fprintf(stderr, "Failed to create mailbox '%s': %s\n", g_h.shm_name, strerror(errno));
+    return -1;
+  }
+  if (ftruncate(fd, sizeof(hw_cosim_mailbox_t)) != 0) {
+    fprintf(stderr, "Failed to size mailbox '%s': %s\n", g_h.shm_name, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  void *mem = mmap(NULL, sizeof(hw_cosim_mailbox_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) {
+    fprintf(stderr, "Failed to map mailbox '%s': %s\n", g_h.shm_name, strerror(errno));
+    return -1;
+  }
+
+  hw_cosim_mailbox_t *mb = (hw_cosim_mailbox_t *)mem;
+  memset(mb, 0, sizeof(*mb));
+  mb->version = HW_COSIM_VERSION;
+  mb->harness_pid = (uint32_t)getpid();
+  mb->spi_clk_freq_hz = g_h.spi_clk_freq_hz;
+  mb->board_count = g_h.board_count;
+  __atomic_store_n(&mb->magic, HW_COSIM_MAGIC, __ATOMIC_RELEASE); // Ready for clients
+  g_h.mb = mb;
+  return 0;
+}
+
+//////////////////// Report ////////////////////
+
+static void print_latency(const char *name, const latency_stat_t &s, double scale, const char *unit) {
+  if (s.count == 0) {
+    printf("  %-34s (none)\n", name);
+    return;
+  }
+  printf("  %-34s n=%-8llu min %10.3f  mean %10.3f  max %10.3f %s\n", name, (unsigned long long)s.count,
+         s.min / scale, (double)s.sum / s.count / scale, s.max / scale, unit);
+}
+
+static void print_report() {
+  printf("\n---- Co-simulation report (%.3f ms model time, %llu aclk / %llu SPI clock cycles) ----\n",
+         g_h.time_ps / 1e9, (unsigned long long)g_h.aclk_cycles, (unsigned long long)g_h.spi_clk_cycles);
+
+  printf("Access round trip (model aclk cycles / host wall time):\n");
+  for (int k = 0; k < 4; k++) {
+    if (g_h.access_cycles[k].count == 0) continue;
+    char name[64];
+    snprintf(name, sizeof(name), "%s (cycles)", g_access_names[k]);
+    print_latency(name, g_h.access_cycles[k], 1.0, "cyc");
+    snprintf(name, sizeof(name), "%s (wall)", g_access_names[k]);
+    print_latency(name, g_h.access_wall_ns[k], 1e3, "us");
+  }
+  if (g_h.decerr_count > 0) printf("  %llu accesses to unmapped addresses\n", (unsigned long long)g_h.decerr_count);
+  if (g_h.timeout_count > 0) printf("  %llu accesses timed out\n", (unsigned long long)g_h.timeout_count);
+
+  printf("End-to-end latency (model time):\n");
+  print_latency("DAC write to first ~CS", g_h.dac_cs_latency, 1e6, "us");
+  print_latency("DAC write to LDAC", g_h.dac_ldac_latency, 1e6, "us");
+  print_latency("ADC sample to software read", g_h.adc_read_latency, 1e6, "us");
+
+  printf("Peak FIFO occupancy (words):\n");
+  for (uint32_t b = 0; b < g_h.board_count; b++) {
+    printf("  Board %u: DAC cmd %6u  DAC data %6u  ADC cmd %6u  ADC data %6u\n", b,
+           g_h.cmd_fifo_peak[2 * b], g_h.data_fifo_peak[2 * b],
+           g_h.cmd_fifo_peak[2 * b + 1], g_h.data_fifo_peak[2 * b + 1]);
+  }
+  printf("  Trigger: cmd %6u  data %6u\n", g_h.cmd_fifo_peak[FIFO_SEL_TRIG], g_h.data_fifo_peak[FIFO_SEL_TRIG]);
+
+  uint32_t hw_status = sts_word(HW_STS_REG_OFFSET);
+  printf("Hardware state %u, status code 0x%04X, board %u (%llu status changes)\n",
+         HW_STS_STATE(hw_status), HW_STS_CODE(hw_status), HW_STS_BOARD(hw_status),
+         (unsigned long long)g_h.hw_status_changes);
+  fflush(stdout);
+}
+
+static void reset_stats() {
+  g_h.dac_cs_latency = latency_stat_t();
+  g_h.dac_ldac_latency = latency_stat_t();
+  g_h.adc_read_latency = latency_stat_t();
+  for (int k = 0; k < 4; k++) {
+    g_h.access_cycles[k] = latency_stat_t();
+    g_h.access_wall_ns[k] = latency_stat_t();
+  }
+  g_h.decerr_count = 0;
+  g_h.timeout_count = 0;
+  memset(g_h.cmd_fifo_peak, 0, sizeof(g_h.cmd_fifo_peak));
+  memset(g_h.data_fifo_peak, 0, sizeof(g_h.data_fifo_peak));
+  g_h.hw_status_changes = 0;
+}
+
+//////////////////// Main ////////////////////
+
+static void print_usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [--name shm_name] [--lockstep cycles] [--ext-trig-period spi_cycles]%s [--verbose]\n",
+          prog,
+#if VM_TRACE
+          " [--vcd file]"
+#else
+          ""
+#endif
+  );
+  fprintf(stderr, "  --name             Mailbox name (default %s, pass the same to shim-test --cosim)\n", HW_COSIM_DEFAULT_NAME);
+  fprintf(stderr, "  --lockstep         Only advance the model this many aclk cycles per access (default: free-run)\n");
+  fprintf(stderr, "  --ext-trig-period  Pulse the external trigger input every this many SPI clock cycles\n");
+#if VM_TRACE
+  fprintf(stderr, "  --vcd              Dump a waveform (grows quickly, for short sessions)\n");
+#endif
+  fprintf(stderr, "  --verbose          Log hardware status changes\n");
+}
+
+int main(int argc, char **argv) {
+  const char *vcd_path = NULL;
+  for (int i = 1; i < argc; i++) {
+    bool has_value = (i + 1 < argc);
+    if (strcmp(argv[i], "--name") == 0 && has_value) {
+      g_h.shm_name = argv[++i];
+    } else if (strcmp(argv[i], "--lockstep") == 0 && has_value) {
+      g_h.lockstep_cycles = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--ext-trig-period") == 0 && has_value) {
+      g_h.ext_trig_period = strtoull(argv[++i], NULL, 0);
+      if (g_h.ext_trig_period != 0 && g_h.ext_trig_period <= EXT_TRIG_PULSE_CYCLES) {
+        fprintf(stderr, "External trigger period must be more than %d SPI clock cycles\n", EXT_TRIG_PULSE_CYCLES);
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--vcd") == 0 && has_value) {
+      vcd_path = argv[++i];
+    } else if (strcmp(argv[i], "--verbose") == 0) {
+      g_h.verbose = true;
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+#if !VM_TRACE
+  if (vcd_path != NULL) {
+    fprintf(stderr, "Waveform dumps need a harness built with TRACE=1\n");
+    return EXIT_FAILURE;
+  }
+#endif
+
+  Verilated::commandArgs(argc, argv);
+  g_h.top = new Vshim_cosim_top;
+  Vshim_cosim_top *top = g_h.top;
+#if VM_TRACE
+  if (vcd_path != NULL) {
+    Verilated::traceEverOn(true);
+    g_h.vcd = new VerilatedVcdC;
+    top->trace(g_h.vcd, 99);
+    g_h.vcd->open(vcd_path);
+  }
+#endif
+
+  // The SPI clock frequency and board count are build parameters of the model; read them back
+  top->aclk = 0;
+  top->spi_clk = 0;
+  top->aresetn = 0;
+  top->ext_en = 1;
+  top->ext_trig = 0;
+  top->eval();
+  g_h.spi_clk_freq_hz = sts_word(SPI_CLK_FREQ_OFFSET);
+  if (g_h.spi_clk_freq_hz == 0) {
+    fprintf(stderr, "Model reports no SPI clock frequency\n");
+    return EXIT_FAILURE;
+  }
+  g_h.spi_half_period_ps = 500000000000ULL / g_h.spi_clk_freq_hz;
+  g_h.next_aclk_edge_ps = ACLK_HALF_PERIOD_PS;
+  g_h.next_spi_edge_ps = g_h.spi_half_period_ps;
+  for (uint32_t b = 0; b < 8; b++) {
+    if (sts_word(DAC_CMD_FIFO_STS_OFFSET(b)) >> 31) g_h.board_count = b + 1;
+  }
+
+  run_cycles(RESET_CYCLES);
+  top->aresetn = 1;
+  run_cycles(RESET_CYCLES);
+
+  if (create_mailbox() != 0) return EXIT_FAILURE;
+  signal(SIGINT, handle_signal);
+  signal(SIGTERM, handle_signal);
+  printf("shim-cosim: %u boards, %u Hz SPI clock, %s, waiting on '%s'\n", g_h.board_count, g_h.spi_clk_freq_hz,
+         g_h.lockstep_cycles ? "lockstep" : "free-running", g_h.shm_name);
+  fflush(stdout);
+
+  hw_cosim_mailbox_t *mb = g_h.mb;
+  bool had_client = false;
+  while (!g_stop) {
+    if (__atomic_load_n(&mb->req_seq, __ATOMIC_ACQUIRE) != mb->ack_seq) {
+      service_request();
+      continue;
+    }
+
+    uint32_t client = mb->client_pid;
+    if (client != 0 && !pid_alive(client)) {
+      __sync_bool_compare_and_swap(&mb->client_pid, client, 0); // Client died without detaching
+      client = 0;
+    }
+    if (client == 0) {
+      // Report at the end of each client session, then idle until the next one
+      if (had_client) {
+        print_report();
+        reset_stats();
+        had_client = false;
+      }
+      usleep(1000);
+      continue;
+    }
+    if (!had_client) {
+      if (g_h.verbose) printf("Client pid %u attached\n", client);
+      had_client = true;
+    }
+
+    if (g_h.lockstep_cycles == 0) run_cycles(FREE_RUN_CHUNK_CYCLES);
+    else sched_yield();
+  }
+
+  if (had_client) print_report(); // Otherwise already reported when the last client left
+  mb->magic = 0;
+  shm_unlink(g_h.shm_name);
+#if VM_TRACE
+  if (g_h.vcd) {
+    g_h.vcd->close();
+    delete g_h.vcd;
+  }
+#endif
+  top->final();
+  delete top;
+  return EXIT_SUCCESS;
+}
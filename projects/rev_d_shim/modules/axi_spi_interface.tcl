@@ -28,6 +28,9 @@ if {$dac_cmd_fifo_addr_width < 10 || $dac_cmd_fifo_addr_width > 17 ||
   exit 1
 }
 
+# Get whether the DAC command FIFOs are also fed from DDR
+set dac_cmd_ddr_buffer [module_get_upvar dac_cmd_ddr_buffer]
+
 ##################################################
 
 ### Ports
@@ -41,6 +44,10 @@ create_bd_pin -dir I -type clock spi_clk
 
 # AXI interface
 create_bd_intf_pin -mode slave -vlnv xilinx.com:interface:aximm_rtl:1.0 S_AXI
+# DDR read interface for the DAC DDR buffer readers
+if {$dac_cmd_ddr_buffer} {
+  create_bd_intf_pin -mode master -vlnv xilinx.com:interface:aximm_rtl:1.0 M_AXI
+}
 
 # Status concatenated out
 create_bd_pin -dir O -from 543 -to 0 cmd_fifo_sts
@@ -134,15 +141,26 @@ cell xilinx.com:ip:xlconstant:1.1 trig_data_sts_word_padding {
   CONST_WIDTH [expr {32 - (6 + $trig_data_fifo_addr_width)}]
 } {}
 
+# DAC DDR buffer readers' smart connect to DDR (one manager per board)
+if {$dac_cmd_ddr_buffer} {
+  cell xilinx.com:ip:smartconnect:1.0 dac_ddr_axi_intercon {
+    NUM_SI $board_count
+    NUM_MI 1
+  } {
+    aclk aclk
+    M00_AXI M_AXI
+    aresetn aresetn
+  }
+}
 
 ## FIFO declarations
 # Each FIFO has a 32-bit data width and 10-bit address width
 for {set i 0} {$i < $board_count} {incr i} {
 
-  ## DAC/ADC channel smart connect
+  ## DAC/ADC channel smart connect (plus the DAC DDR buffer reader registers, if used)
   cell xilinx.com:ip:smartconnect:1.0 ch${i}_axi_intercon {
     NUM_SI 1
-    NUM_MI 2
+    NUM_MI [expr {$dac_cmd_ddr_buffer ? 3 : 2}]
   } {
     aclk aclk
     S00_AXI board_ch_axi_intercon/M0${i}_AXI
@@ -256,14 +274,35 @@ for {set i 0} {$i < $board_count} {incr i} {
     wr_resetn dac_cmd_fifo_${i}_spi_clk_rst/peripheral_aresetn
     rd_resetn dac_data_fifo_${i}_spi_clk_rst/peripheral_aresetn
     S_AXI ch${i}_axi_intercon/M00_AXI
-    fifo_wr_data dac_cmd_fifo_${i}/wr_data
-    fifo_wr_en dac_cmd_fifo_${i}/wr_en
-    fifo_full dac_cmd_fifo_${i}/full
     fifo_rd_data dac_data_fifo_${i}/rd_data
     fifo_rd_en dac_data_fifo_${i}/rd_en
     fifo_empty dac_data_fifo_${i}/empty
   }
 
+  ## DAC command FIFO write port
+  if {$dac_cmd_ddr_buffer} {
+    # DDR buffer reader between the bridge and the FIFO (bridge writes pass straight through)
+    cell lcb:user:axi_ddr_fifo_reader dac_ddr_reader_$i {
+      FIFO_ADDR_WIDTH $dac_cmd_fifo_addr_width
+    } {
+      aclk aclk
+      aresetn aresetn
+      S_AXI ch${i}_axi_intercon/M02_AXI
+      M_AXI dac_ddr_axi_intercon/S0${i}_AXI
+      bridge_wr_data dac_fifo_${i}_axi_bridge/fifo_wr_data
+      bridge_wr_en dac_fifo_${i}_axi_bridge/fifo_wr_en
+      bridge_full dac_fifo_${i}_axi_bridge/fifo_full
+      fifo_wr_data dac_cmd_fifo_${i}/wr_data
+      fifo_wr_en dac_cmd_fifo_${i}/wr_en
+      fifo_full dac_cmd_fifo_${i}/full
+      fifo_count dac_cmd_fifo_${i}/fifo_count_wr_clk
+    }
+  } else {
+    wire dac_fifo_${i}_axi_bridge/fifo_wr_data dac_cmd_fifo_${i}/wr_data
+    wire dac_fifo_${i}_axi_bridge/fifo_wr_en dac_cmd_fifo_${i}/wr_en
+    wire dac_fifo_${i}_axi_bridge/fifo_full dac_cmd_fifo_${i}/full
+  }
+
 
   ## ADC command FIFO
   # ADC command FIFO resetn
@@ -79,8 +79,11 @@ cell xilinx.com:ip:proc_sys_reset:5.0 miso_rst {} {
   ext_reset_in resetn
   slowest_sync_clk miso_sck
 }
-## ADC SPI core
-cell lcb:user:shim_ads816x_adc_ctrl adc_spi {} {
+## ADC SPI core (board index from the calling loop, reported in frame marker words)
+set board_id [module_get_upvar i]
+cell lcb:user:shim_ads816x_adc_ctrl adc_spi {
+  BOARD_ID $board_id
+} {
   clk spi_clk
   resetn resetn
   boot_test_skip boot_test_skip
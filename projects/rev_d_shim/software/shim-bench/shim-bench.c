@@ -0,0 +1,601 @@
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Include hardware control modules (shared with shim-test, see shared_sources)
+#include "sys_ctrl.h"
+#include "adc_ctrl.h"
+#include "dac_ctrl.h"
+#include "sys_sts.h"
+#include "map_memory.h"
+#include "hw_backend.h"
+#include "hw_sim.h"
+#include "hw_cosim.h"
+#include "spi_timing.h"
+
+//////////////////// Benchmark Definitions ////////////////////
+#define BENCH_DEFAULT_ITERATIONS   5        // Repetitions of each FIFO benchmark
+#define BENCH_STATUS_READS         100000   // Status reads per latency run
+#define BENCH_STATUS_SAMPLES       10000    // Individually timed status reads for percentiles
+#define BENCH_DRAIN_WORDS          16384    // ADC words drained per board in the drain benchmark
+#define BENCH_SINK_WORDS           (1 << 20) // Words written per file sink run
+#define BENCH_SINK_CHUNK           256      // Words per write, as in the ADC stream threads
+#define BENCH_RUNNING_TIMEOUT_MS   2000     // Time allowed for the system to reach S_RUNNING
+#define BENCH_MAX_METRICS          12
+#define BENCH_MAX_RESULTS          64
+
+// One benchmark result: a name, its parameters and its measured metrics
+typedef struct {
+  char name[48];
+  int boards;
+  uint32_t words;
+  int metric_count;
+  const char *metric_names[BENCH_MAX_METRICS];
+  double metric_values[BENCH_MAX_METRICS];
+} bench_result_t;
+
+// Benchmark run state
+typedef struct {
+  struct sys_ctrl_t *sys_ctrl;
+  struct sys_sts_t *sys_sts;
+  struct dac_ctrl_t *dac_ctrl;
+  struct adc_ctrl_t *adc_ctrl;
+  int iterations;
+  uint8_t board_mask;
+  const char *sink_dir;
+  bool verbose;
+  bench_result_t results[BENCH_MAX_RESULTS];
+  int result_count;
+} bench_t;
+
+//////////////////////////////////////////////////////////////////
+
+static double bench_now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bench_result_t *bench_add_result(bench_t *bench, const char *name, int boards, uint32_t words) {
+  if (bench->result_count >= BENCH_MAX_RESULTS) {
+    fprintf(stderr, "Too many benchmark results, dropping '%s'\n", name);
+    static bench_result_t discard;
+    memset(&discard, 0, sizeof(discard));
+    return &discard;
+  }
+  bench_result_t *result = &bench->results[bench->result_count++];
+  memset(result, 0, sizeof(*result));
+  snprintf(result->name, sizeof(result->name), "%s", name);
+  result->boards = boards;
+  result->words = words;
+  return result;
+}
+
+static void bench_add_metric(bench_result_t *result, const char *name, double value) {
+  if (result->metric_count >= BENCH_MAX_METRICS) return;
+  result->metric_names[result->metric_count] = name;
+  result->metric_values[result->metric_count] = value;
+  result->metric_count++;
+}
+
+static int compare_double(const void *a, const void *b) {
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+// Best, median and mean rate over repeated timings of the same amount of work
+static void bench_add_rate_metrics(bench_result_t *result, double *seconds, int count, uint32_t words) {
+  qsort(seconds, (size_t)count, sizeof(double), compare_double);
+  double total = 0;
+  for (int i = 0; i < count; i++) total += seconds[i];
+  bench_add_metric(result, "words_per_s_best", words / seconds[0]);
+  bench_add_metric(result, "words_per_s_median", words / seconds[count / 2]);
+  bench_add_metric(result, "words_per_s_mean", words * count / total);
+  bench_add_metric(result, "ns_per_word_median", seconds[count / 2] * 1e9 / words);
+}
+
+// Hardware status without its board field
+static uint32_t bench_state(bench_t *bench) {
+  return HW_STS_STATE(sys_sts_get_hw_status(bench->sys_sts, false));
+}
+
+// Power-cycle the system with clean buffers and wait for S_RUNNING
+static int bench_restart_system(bench_t *bench) {
+  sys_ctrl_turn_off(bench->sys_ctrl, false);
+  sys_ctrl_set_cmd_buf_reset(bench->sys_ctrl, 0x1FFFF, false);
+  sys_ctrl_set_data_buf_reset(bench->sys_ctrl, 0x1FFFF, false);
+  usleep(1000);
+  sys_ctrl_set_cmd_buf_reset(bench->sys_ctrl, 0, false);
+  sys_ctrl_set_data_buf_reset(bench->sys_ctrl, 0, false);
+  sys_ctrl_turn_on(bench->sys_ctrl, false);
+
+  for (int ms = 0; ms < BENCH_RUNNING_TIMEOUT_MS; ms++) {
+    uint32_t state = bench_state(bench);
+    if (state == S_RUNNING) return 0;
+    if (state == S_HALTED) break;
+    usleep(1000);
+  }
+  fprintf(stderr, "System did not reach the running state:\n");
+  print_hw_status(sys_sts_get_hw_status(bench->sys_sts, false), false);
+  return -1;
+}
+
+// Number of ADC data words produced by one ADC_RD command
+#define BENCH_WORDS_PER_ADC_RD 4
+
+// Shortest delay (in SPI cycles) that an ADC_RD can safely use at the measured SPI clock
+static uint32_t bench_adc_rd_cycles(bench_t *bench) {
+  return create_spi_timing(sys_sts_get_spi_clk_freq_hz(bench->sys_sts, false)).adc_rd_min_delay;
+}
+
+// Queue ADC_RD commands that will produce word_count data words on a board
+static void bench_queue_adc_reads(bench_t *bench, uint8_t board, uint32_t word_count) {
+  uint32_t reads = (word_count + BENCH_WORDS_PER_ADC_RD - 1) / BENCH_WORDS_PER_ADC_RD;
+  adc_cmd_adc_rd(bench->adc_ctrl, board, false, false, bench_adc_rd_cycles(bench), reads - 1, 0, false);
+}
+
+//////////////////// Benchmarks ////////////////////
+
+// Status register read latency
+static void bench_status_latency(bench_t *bench) {
+  volatile uint32_t sink = 0;
+
+  // Clock overhead, subtracted from the individually timed reads
+  double overhead = 0;
+  for (int i = 0; i < 1000; i++) {
+    double t0 = bench_now_s();
+    overhead += bench_now_s() - t0;
+  }
+  overhead /= 1000;
+
+  double *samples = malloc(BENCH_STATUS_SAMPLES * sizeof(double));
+  if (samples == NULL) {
+    fprintf(stderr, "Failed to allocate status latency samples\n");
+    return;
+  }
+  for (int i = 0; i < BENCH_STATUS_SAMPLES; i++) {
+    double t0 = bench_now_s();
+    sink += sys_sts_get_hw_status(bench->sys_sts, false);
+    samples[i] = bench_now_s() - t0 - overhead;
+  }
+  qsort(samples, BENCH_STATUS_SAMPLES, sizeof(double), compare_double);
+
+  double t0 = bench_now_s();
+  for (int i = 0; i < BENCH_STATUS_READS; i++) {
+    sink += sys_sts_get_hw_status(bench->sys_sts, false);
+  }
+  double elapsed = bench_now_s() - t0;
+  (void)sink;
+
+  bench_result_t *result = bench_add_result(bench, "status_read_latency", 0, BENCH_STATUS_READS);
+  bench_add_metric(result, "ns_mean", elapsed * 1e9 / BENCH_STATUS_READS);
+  bench_add_metric(result, "ns_min", samples[0] * 1e9);
+  bench_add_metric(result, "ns_p50", samples[BENCH_STATUS_SAMPLES / 2] * 1e9);
+  bench_add_metric(result, "ns_p99", samples[BENCH_STATUS_SAMPLES * 99 / 100] * 1e9);
+  bench_add_metric(result, "ns_max", samples[BENCH_STATUS_SAMPLES - 1] * 1e9);
+  bench_add_metric(result, "reads_per_s", BENCH_STATUS_READS / elapsed);
+  free(samples);
+}
+
+// DAC command FIFO write rate, one command at a time (API) and as a raw word burst.
+// The first command waits for a trigger that never comes, so the FIFO only fills.
+static int bench_fifo_write(bench_t *bench, uint8_t board) {
+  uint32_t words = DAC_CMD_FIFO_WORDCOUNT - 2;
+  uint32_t *burst = malloc(words * sizeof(uint32_t));
+  double *single_s = malloc(bench->iterations * sizeof(double));
+  double *burst_s = malloc(bench->iterations * sizeof(double));
+  if (burst == NULL || single_s == NULL || burst_s == NULL) {
+    fprintf(stderr, "Failed to allocate FIFO write buffers\n");
+    free(burst);
+    free(single_s);
+    free(burst_s);
+    return -1;
+  }
+  uint32_t noop_word = ((uint32_t)DAC_CMD_NO_OP << DAC_CMD_CMD_LSB) | (1u << DAC_CMD_TRIG_BIT) | 1;
+  for (uint32_t i = 0; i < words; i++) burst[i] = noop_word;
+
+  int result = 0;
+  for (int iter = 0; iter < bench->iterations && result == 0; iter++) {
+    for (int mode = 0; mode < 2; mode++) {
+      dac_cmd_noop(bench->dac_ctrl, board, true, false, false, 1, false);
+
+      double t0 = bench_now_s();
+      if (mode == 0) {
+        for (uint32_t i = 0; i < words; i++) {
+          dac_cmd_noop(bench->dac_ctrl, board, true, false, false, 1, false);
+        }
+      } else {
+        volatile uint32_t *fifo = bench->dac_ctrl->buffer[board];
+        for (uint32_t i = 0; i < words; i++) {
+          hw_write32(fifo, burst[i]);
+        }
+      }
+      double elapsed = bench_now_s() - t0;
+      (mode == 0 ? single_s : burst_s)[iter] = elapsed;
+
+      // Every word must have landed in the FIFO
+      uint32_t count = FIFO_STS_WORD_COUNT(sys_sts_get_dac_cmd_fifo_status(bench->sys_sts, board, false));
+      if (count != words) {
+        fprintf(stderr, "DAC[%d] command FIFO holds %u words after writing %u\n", board, count, words);
+        result = -1;
+      }
+
+      // Empty the FIFO, then cancel the trigger wait
+      sys_ctrl_set_cmd_buf_reset(bench->sys_ctrl, 1u << (2 * board), false);
+      sys_ctrl_set_cmd_buf_reset(bench->sys_ctrl, 0, false);
+      dac_cmd_cancel(bench->dac_ctrl, board, false);
+      if (bench_state(bench) != S_RUNNING || result != 0) {
+        result = -1;
+        break;
+      }
+    }
+  }
+
+  if (result == 0) {
+    bench_result_t *single = bench_add_result(bench, "dac_fifo_write_single", 1, words);
+    bench_add_rate_metrics(single, single_s, bench->iterations, words);
+    bench_result_t *raw = bench_add_result(bench, "dac_fifo_write_burst", 1, words);
+    bench_add_rate_metrics(raw, burst_s, bench->iterations, words);
+  }
+  free(burst);
+  free(single_s);
+  free(burst_s);
+  return result;
+}
+
+// Wait for a board's ADC data FIFO to hold at least word_count words
+static int bench_wait_adc_words(bench_t *bench, uint8_t board, uint32_t word_count) {
+  double deadline = bench_now_s() + 5.0;
+  while (FIFO_STS_WORD_COUNT(sys_sts_get_adc_data_fifo_status(bench->sys_sts, board, false)) < word_count) {
+    if (bench_now_s() > deadline || bench_state(bench) != S_RUNNING) {
+      fprintf(stderr, "ADC[%d] data FIFO did not fill to %u words\n", board, word_count);
+      return -1;
+    }
+    usleep(100);
+  }
+  return 0;
+}
+
+// ADC data FIFO read rate, one word at a time (API) and as a raw burst
+static int bench_fifo_read(bench_t *bench, uint8_t board) {
+  uint32_t words = ADC_DATA_FIFO_WORDCOUNT - BENCH_WORDS_PER_ADC_RD;
+  uint32_t *buffer = malloc(words * sizeof(uint32_t));
+  double *single_s = malloc(bench->iterations * sizeof(double));
+  double *burst_s = malloc(bench->iterations * sizeof(double));
+  if (buffer == NULL || single_s == NULL || burst_s == NULL) {
+    fprintf(stderr, "Failed to allocate FIFO read buffers\n");
+    free(buffer);
+    free(single_s);
+    free(burst_s);
+    return -1;
+  }
+
+  int result = 0;
+  for (int iter = 0; iter < bench->iterations && result == 0; iter++) {
+    for (int mode = 0; mode < 2; mode++) {
+      bench_queue_adc_reads(bench, board, words);
+      if (bench_wait_adc_words(bench, board, words) != 0) {
+        result = -1;
+        break;
+      }
+
+      double t0 = bench_now_s();
+      if (mode == 0) {
+        for (uint32_t i = 0; i < words; i++) {
+          buffer[i] = adc_read_word(bench->adc_ctrl, board);
+        }
+      } else {
+        volatile uint32_t *fifo = bench->adc_ctrl->buffer[board];
+        for (uint32_t i = 0; i < words; i++) {
+          buffer[i] = hw_read32(fifo);
+        }
+      }
+      (mode == 0 ? single_s : burst_s)[iter] = bench_now_s() - t0;
+
+      if (bench_state(bench) != S_RUNNING) {
+        fprintf(stderr, "System halted while reading ADC[%d] data\n", board);
+        result = -1;
+        break;
+      }
+    }
+  }
+
+  if (result == 0) {
+    bench_result_t *single = bench_add_result(bench, "adc_fifo_read_single", 1, words);
+    bench_add_rate_metrics(single, single_s, bench->iterations, words);
+    bench_result_t *raw = bench_add_result(bench, "adc_fifo_read_burst", 1, words);
+    bench_add_rate_metrics(raw, burst_s, bench->iterations, words);
+  }
+  free(buffer);
+  free(single_s);
+  free(burst_s);
+  return result;
+}
+
+// End-to-end drain: every board produces ADC data at the fastest safe rate while
+// one thread drains all of them, polling FIFO status like the stream threads do.
+static void bench_drain(bench_t *bench, const uint8_t *boards, int board_count) {
+  uint32_t *buffer = malloc(BENCH_DRAIN_WORDS * sizeof(uint32_t));
+  if (buffer == NULL) {
+    fprintf(stderr, "Failed to allocate drain buffer\n");
+    return;
+  }
+  if (bench_restart_system(bench) != 0) {
+    free(buffer);
+    return;
+  }
+
+  uint32_t remaining[8] = {0};
+  uint64_t status_reads = 0;
+  uint32_t peak_fill = 0;
+  for (int i = 0; i < board_count; i++) remaining[i] = BENCH_DRAIN_WORDS;
+
+  double t0 = bench_now_s();
+  for (int i = 0; i < board_count; i++) {
+    bench_queue_adc_reads(bench, boards[i], BENCH_DRAIN_WORDS);
+  }
+
+  bool done = false;
+  bool halted = false;
+  while (!done && !halted) {
+    done = true;
+    for (int i = 0; i < board_count; i++) {
+      if (remaining[i] == 0) continue;
+      done = false;
+      uint32_t available = FIFO_STS_WORD_COUNT(sys_sts_get_adc_data_fifo_status(bench->sys_sts, boards[i], false));
+      status_reads++;
+      if (available > peak_fill) peak_fill = available;
+      if (available > remaining[i]) available = remaining[i];
+      for (uint32_t w = 0; w < available; w++) {
+        buffer[w] = adc_read_word(bench->adc_ctrl, boards[i]);
+      }
+      remaining[i] -= available;
+    }
+    if ((status_reads & 0x3F) == 0) {
+      halted = bench_state(bench) != S_RUNNING;
+    }
+  }
+  double elapsed = bench_now_s() - t0;
+  uint32_t hw_status = sys_sts_get_hw_status(bench->sys_sts, false);
+  halted = halted || HW_STS_STATE(hw_status) != S_RUNNING;
+
+  uint32_t words = BENCH_DRAIN_WORDS * (uint32_t)board_count;
+  uint32_t spi_clk_freq_hz = sys_sts_get_spi_clk_freq_hz(bench->sys_sts, false);
+  bench_result_t *result = bench_add_result(bench, "adc_drain", board_count, words);
+  bench_add_metric(result, "words_per_s", words / elapsed);
+  bench_add_metric(result, "mb_per_s", words * 4.0 / elapsed / 1e6);
+  bench_add_metric(result, "offered_words_per_s",
+                   (double)spi_clk_freq_hz / bench_adc_rd_cycles(bench) * BENCH_WORDS_PER_ADC_RD * board_count);
+  bench_add_metric(result, "seconds", elapsed);
+  bench_add_metric(result, "peak_fifo_words", peak_fill);
+  bench_add_metric(result, "status_reads", (double)status_reads);
+  bench_add_metric(result, "halted", halted ? 1 : 0);
+  bench_add_metric(result, "halt_code", halted ? HW_STS_CODE(hw_status) : 0);
+  if (halted && bench->verbose) {
+    fprintf(stderr, "Drain with %d board(s) halted the system:\n", board_count);
+    print_hw_status(hw_status, false);
+  }
+  free(buffer);
+}
+
+// File sink bandwidth for the binary and text formats used by the ADC stream threads
+static void bench_file_sink(bench_t *bench) {
+  uint32_t *words = malloc(BENCH_SINK_WORDS * sizeof(uint32_t));
+  if (words == NULL) {
+    fprintf(stderr, "Failed to allocate file sink buffer\n");
+    return;
+  }
+  unsigned int seed = 1;
+  for (uint32_t i = 0; i < BENCH_SINK_WORDS; i++) {
+    words[i] = ((uint32_t)rand_r(&seed) << 16) ^ (uint32_t)rand_r(&seed);
+  }
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s/shim-bench-sink-%d.tmp", bench->sink_dir, (int)getpid());
+
+  for (int binary = 1; binary >= 0; binary--) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+      fprintf(stderr, "Failed to open file sink '%s': %s\n", path, strerror(errno));
+      break;
+    }
+
+    double t0 = bench_now_s();
+    for (uint32_t start = 0; start < BENCH_SINK_WORDS; start += BENCH_SINK_CHUNK) {
+      if (binary) {
+        fwrite(&words[start], sizeof(uint32_t), BENCH_SINK_CHUNK, file);
+      } else {
+        for (uint32_t i = start; i < start + BENCH_SINK_CHUNK; i++) {
+          fprintf(file, "%d %d%s", offset_to_signed(words[i] & 0xFFFF), offset_to_signed(words[i] >> 16),
+                  (i % 4 == 3) ? "\n" : " ");
+        }
+      }
+      fflush(file);
+    }
+    fsync(fileno(file));
+    long bytes = ftell(file);
+    fclose(file);
+    double elapsed = bench_now_s() - t0;
+
+    bench_result_t *result = bench_add_result(bench, binary ? "file_sink_binary" : "file_sink_text", 0, BENCH_SINK_WORDS);
+    bench_add_metric(result, "words_per_s", BENCH_SINK_WORDS / elapsed);
+    bench_add_metric(result, "mb_per_s", bytes / elapsed / 1e6);
+    bench_add_metric(result, "bytes", (double)bytes);
+  }
+  unlink(path);
+  free(words);
+}
+
+//////////////////// JSON output ////////////////////
+
+static void bench_write_json(bench_t *bench, FILE *out) {
+  time_t now = time(NULL);
+  char timestamp[32];
+  strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+  char hostname[64] = "unknown";
+  gethostname(hostname, sizeof(hostname) - 1);
+
+  fprintf(out, "{\n");
+  fprintf(out, "  \"tool\": \"shim-bench\",\n");
+  fprintf(out, "  \"timestamp\": \"%s\",\n", timestamp);
+  fprintf(out, "  \"host\": \"%s\",\n", hostname);
+  fprintf(out, "  \"backend\": \"%s\",\n", hw_backend_name());
+  fprintf(out, "  \"spi_clk_freq_hz\": %" PRIu32 ",\n", sys_sts_get_spi_clk_freq_hz(bench->sys_sts, false));
+  fprintf(out, "  \"iterations\": %d,\n", bench->iterations);
+  fprintf(out, "  \"board_mask\": %u,\n", bench->board_mask);
+  fprintf(out, "  \"results\": [");
+  for (int r = 0; r < bench->result_count; r++) {
+    bench_result_t *result = &bench->results[r];
+    fprintf(out, "%s\n    {\"name\": \"%s\", \"boards\": %d, \"words\": %" PRIu32,
+            r == 0 ? "" : ",", result->name, result->boards, result->words);
+    for (int m = 0; m < result->metric_count; m++) {
+      fprintf(out, ", \"%s\": %.6g", result->metric_names[m], result->metric_values[m]);
+    }
+    fprintf(out, "}");
+  }
+  fprintf(out, "\n  ]\n}\n");
+}
+
+//////////////////// Main ////////////////////
+int main(int argc, char *argv[])
+{
+  //////////////////// 1. Setup ////////////////////
+  // Parse optional arguments
+  //   --verbose          : progress output on stderr
+  //   --uio | --devmem   : map AXI windows only from UIO regions / only from /dev/mem
+  //   --sim [spi_clk_hz] : benchmark the cycle-approximate hardware simulator
+  //   --cosim [shm_name] : benchmark the Verilated RTL in a running shim-cosim harness
+  //   --iterations <n>   : repetitions of each FIFO benchmark
+  //   --boards <mask>    : boards to use (default: every board with FIFOs present)
+  //   --sink-dir <dir>   : directory for the file sink benchmark (default: /tmp)
+  //   --out <file>       : write the JSON results to a file instead of stdout
+  bench_t bench;
+  memset(&bench, 0, sizeof(bench));
+  bench.iterations = BENCH_DEFAULT_ITERATIONS;
+  bench.board_mask = 0xFF;
+  bench.sink_dir = "/tmp";
+  const char *out_path = NULL;
+  bool sim_mode = false;
+
+  for (int i = 1; i < argc; i++) {
+    bool has_value = (i + 1 < argc);
+    if (strcmp(argv[i], "--verbose") == 0) {
+      bench.verbose = true;
+    } else if (strcmp(argv[i], "--uio") == 0) {
+      map_memory_set_backend(MAP_BACKEND_UIO);
+    } else if (strcmp(argv[i], "--devmem") == 0) {
+      map_memory_set_backend(MAP_BACKEND_DEVMEM);
+    } else if (strcmp(argv[i], "--sim") == 0) {
+      hw_sim_config_t sim_config = hw_sim_default_config();
+      if (has_value && argv[i + 1][0] != '-') {
+        sim_config.spi_clk_freq_hz = (uint32_t)strtoul(argv[++i], NULL, 0);
+      }
+      hw_sim_install(&sim_config);
+      sim_mode = true;
+    } else if (strcmp(argv[i], "--cosim") == 0) {
+      const char *shm_name = HW_COSIM_DEFAULT_NAME;
+      if (has_value && argv[i + 1][0] != '-') {
+        shm_name = argv[++i];
+      }
+      if (hw_cosim_install(shm_name, bench.verbose) != 0) return EXIT_FAILURE;
+      sim_mode = true;
+    } else if (strcmp(argv[i], "--iterations") == 0 && has_value) {
+      bench.iterations = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--boards") == 0 && has_value) {
+      bench.board_mask = (uint8_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--sink-dir") == 0 && has_value) {
+      bench.sink_dir = argv[++i];
+    } else if (strcmp(argv[i], "--out") == 0 && has_value) {
+      out_path = argv[++i];
+    } else {
+      fprintf(stderr, "Usage: %s [--verbose] [--uio | --devmem | --sim [spi_clk_hz] | --cosim [shm_name]]\n"
+                      "          [--iterations <n>] [--boards <mask>] [--sink-dir <dir>] [--out <file>]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (bench.iterations < 1) {
+    fprintf(stderr, "Iterations must be at least 1\n");
+    return EXIT_FAILURE;
+  }
+
+  // The benchmark drives the FIFOs directly, so nothing else may own the hardware
+  if (!sim_mode && claim_hw_ownership(HW_OWNER_LOCK_PATH, bench.verbose) < 0) {
+    fprintf(stderr, "Hardware is already owned by another process (lock '%s').\n", HW_OWNER_LOCK_PATH);
+    return EXIT_FAILURE;
+  }
+
+  struct sys_ctrl_t sys_ctrl = create_sys_ctrl(false);
+  struct sys_sts_t sys_sts = create_sys_sts(false);
+  struct dac_ctrl_t dac_ctrl = create_dac_ctrl(false);
+  struct adc_ctrl_t adc_ctrl = create_adc_ctrl(false);
+  bench.sys_ctrl = &sys_ctrl;
+  bench.sys_sts = &sys_sts;
+  bench.dac_ctrl = &dac_ctrl;
+  bench.adc_ctrl = &adc_ctrl;
+
+  //////////////////// 2. Benchmarks ////////////////////
+  if (bench.verbose) fprintf(stderr, "Backend: %s\n", hw_backend_name());
+  if (bench_restart_system(&bench) != 0) {
+    sys_ctrl_turn_off(&sys_ctrl, false);
+    return EXIT_FAILURE;
+  }
+
+  // Boards that were asked for and actually have FIFOs
+  uint8_t boards[8];
+  int board_count = 0;
+  for (int b = 0; b < 8; b++) {
+    if (((bench.board_mask >> b) & 1) &&
+        FIFO_PRESENT(sys_sts_get_adc_data_fifo_status(&sys_sts, (uint8_t)b, false)) &&
+        FIFO_PRESENT(sys_sts_get_dac_cmd_fifo_status(&sys_sts, (uint8_t)b, false))) {
+      boards[board_count++] = (uint8_t)b;
+    }
+  }
+  if (board_count == 0) {
+    fprintf(stderr, "No boards with FIFOs present in mask 0x%02X\n", bench.board_mask);
+    sys_ctrl_turn_off(&sys_ctrl, false);
+    return EXIT_FAILURE;
+  }
+
+  if (bench.verbose) fprintf(stderr, "Status read latency...\n");
+  bench_status_latency(&bench);
+
+  if (bench.verbose) fprintf(stderr, "DAC FIFO write rate (board %d)...\n", boards[0]);
+  if (bench_fifo_write(&bench, boards[0]) != 0) {
+    fprintf(stderr, "DAC FIFO write benchmark failed\n");
+  }
+
+  if (bench.verbose) fprintf(stderr, "ADC FIFO read rate (board %d)...\n", boards[0]);
+  if (bench_restart_system(&bench) == 0 && bench_fifo_read(&bench, boards[0]) != 0) {
+    fprintf(stderr, "ADC FIFO read benchmark failed\n");
+  }
+
+  for (int n = 1; n <= board_count; n++) {
+    if (bench.verbose) fprintf(stderr, "ADC drain with %d board(s)...\n", n);
+    bench_drain(&bench, boards, n);
+  }
+
+  if (bench.verbose) fprintf(stderr, "File sink bandwidth (%s)...\n", bench.sink_dir);
+  bench_file_sink(&bench);
+
+  //////////////////// 3. Results ////////////////////
+  FILE *out = stdout;
+  if (out_path != NULL) {
+    out = fopen(out_path, "w");
+    if (out == NULL) {
+      fprintf(stderr, "Failed to open '%s': %s\n", out_path, strerror(errno));
+      out = stdout;
+    }
+  }
+  bench_write_json(&bench, out);
+  if (out != stdout) fclose(out);
+
+  sys_ctrl_turn_off(&sys_ctrl, false);
+  return 0;
+}
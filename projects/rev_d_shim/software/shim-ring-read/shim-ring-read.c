@@ -0,0 +1,184 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Include hardware control modules (shared with shim-test, see shared_sources)
+#include "shm_ring.h"
+#include "map_memory.h"
+
+//////////////////// Ring Reader Definitions ////////////////////
+#define RING_READ_CHUNK_WORDS   4096   // Words copied out of the ring at a time
+#define RING_READ_POLL_US       1000   // Sleep between polls while the ring is empty
+#define RING_READ_WAIT_POLL_MS  100    // Retry interval while waiting for a ring to appear
+
+//////////////////////////////////////////////////////////////////
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void handle_signal(int sig) {
+  (void)sig;
+  g_stop = 1;
+}
+
+// Write words as raw binary, or as signed samples 8 per line (the stream_adc_data_to_file format)
+static int write_words(FILE *out, const uint32_t *words, uint32_t count, bool binary_mode, int *samples_on_line) {
+  if (binary_mode) {
+    return (fwrite(words, sizeof(uint32_t), count, out) == count) ? 0 : -1;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    int16_t samples[2] = {offset_to_signed((uint16_t)(words[i] & 0xFFFF)),          // Bits 15:0
+                          offset_to_signed((uint16_t)((words[i] >> 16) & 0xFFFF))}; // Bits 31:16
+    for (int j = 0; j < 2; j++) {
+      fprintf(out, *samples_on_line > 0 ? " %d" : "%d", samples[j]);
+      if (++(*samples_on_line) >= 8) {
+        fprintf(out, "\n");
+        *samples_on_line = 0;
+      }
+    }
+  }
+  return ferror(out) ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+  //////////////////// 1. Setup ////////////////////
+  // Arguments: <board> then
+  //   --out <file>   : write to a file instead of stdout
+  //   --bin          : raw 32-bit words instead of signed samples as text
+  //   --words <n>    : stop after n words (default: until the stream stops)
+  //   --oldest       : start from the oldest word still in the ring instead of new data
+  //   --wait         : wait for the ring to be created instead of failing
+  //   --verbose      : progress output on stderr
+  const char *out_path = NULL;
+  bool binary_mode = false;
+  uint64_t max_words = 0;
+  bool from_oldest = false;
+  bool wait_for_ring = false;
+  bool verbose = false;
+  int board = -1;
+
+  for (int i = 1; i < argc; i++) {
+    bool has_value = (i + 1 < argc);
+    if (strcmp(argv[i], "--out") == 0 && has_value) {
+      out_path = argv[++i];
+    } else if (strcmp(argv[i], "--bin") == 0) {
+      binary_mode = true;
+    } else if (strcmp(argv[i], "--words") == 0 && has_value) {
+      max_words = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--oldest") == 0) {
+      from_oldest = true;
+    } else if (strcmp(argv[i], "--wait") == 0) {
+      wait_for_ring = true;
+    } else if (strcmp(argv[i], "--verbose") == 0) {
+      verbose = true;
+    } else if (board < 0 && argv[i][0] != '-') {
+      char *endptr;
+      board = (int)strtol(argv[i], &endptr, 0);
+      if (*endptr != '\0' || board < 0 || board > 7) board = -2;
+    } else {
+      board = -2;
+      break;
+    }
+  }
+  if (board < 0) {
+    fprintf(stderr, "Usage: %s <board> [--out <file>] [--bin] [--words <n>] [--oldest] [--wait] [--verbose]\n", argv[0]);
+    fprintf(stderr, "Reads the ADC data ring a shim-test daemon fills with 'stream_adc_data_to_shm <board>'.\n");
+    return EXIT_FAILURE;
+  }
+
+  signal(SIGINT, handle_signal);
+  signal(SIGTERM, handle_signal);
+
+  char ring_name[64];
+  snprintf(ring_name, sizeof(ring_name), SHM_RING_ADC_NAME_FMT, board);
+  // Quietly wait for the stream to start, then attach
+  while (wait_for_ring && !g_stop) {
+    int fd = shm_open(ring_name, O_RDONLY, 0);
+    if (fd >= 0) {
+      close(fd);
+      break;
+    }
+    usleep(RING_READ_WAIT_POLL_MS * 1000);
+  }
+  struct shm_ring_t ring;
+  if (shm_ring_attach(&ring, ring_name, verbose) != 0) {
+    return EXIT_FAILURE;
+  }
+
+  FILE *out = stdout;
+  if (out_path != NULL) {
+    out = fopen(out_path, binary_mode ? "wb" : "w");
+    if (out == NULL) {
+      fprintf(stderr, "Failed to open output file '%s': %s\n", out_path, strerror(errno));
+      shm_ring_close(&ring);
+      return EXIT_FAILURE;
+    }
+  }
+
+  //////////////////// 2. Read Loop ////////////////////
+  // Until 2^32 words have gone through, a write position under the capacity means the ring
+  // hasn't filled yet (afterwards starting at "oldest" can only skip some words)
+  uint32_t capacity = ring.header->capacity_words;
+  uint32_t read_count = shm_ring_position(&ring);
+  if (from_oldest) {
+    read_count = read_count > capacity ? read_count - capacity : 0;
+  }
+
+  static uint32_t buffer[RING_READ_CHUNK_WORDS];
+  uint64_t words_read = 0;
+  uint64_t words_lost = 0;
+  uint64_t overruns = 0;
+  int samples_on_line = 0;
+  int result = EXIT_SUCCESS;
+
+  while (!g_stop && (max_words == 0 || words_read < max_words)) {
+    uint32_t chunk = RING_READ_CHUNK_WORDS;
+    if (max_words != 0 && max_words - words_read < chunk) {
+      chunk = (uint32_t)(max_words - words_read);
+    }
+
+    uint32_t start = read_count;
+    int64_t count = shm_ring_read(&ring, &read_count, buffer, chunk);
+    if (count < 0) {
+      // Fell behind the writer: skip ahead and keep going
+      overruns++;
+      words_lost += (uint32_t)(read_count - start);
+      fprintf(stderr, "Ring reader overrun: skipped %u words\n", (uint32_t)(read_count - start));
+      continue;
+    }
+    if (count == 0) {
+      // Drained after the writer stopped: done
+      if (!shm_ring_active(&ring) && shm_ring_position(&ring) == read_count) break;
+      usleep(RING_READ_POLL_US);
+      continue;
+    }
+
+    if (write_words(out, buffer, (uint32_t)count, binary_mode, &samples_on_line) != 0) {
+      fprintf(stderr, "Failed to write output: %s\n", strerror(errno));
+      result = EXIT_FAILURE;
+      break;
+    }
+    words_read += (uint64_t)count;
+  }
+
+  if (!binary_mode && samples_on_line > 0) {
+    fprintf(out, "\n");
+  }
+  if (out != stdout) {
+    fclose(out);
+  } else {
+    fflush(out);
+  }
+
+  fprintf(stderr, "Read %llu words from ring '%s' (%llu overruns, %llu words lost)\n",
+          (unsigned long long)words_read, ring_name, (unsigned long long)overruns, (unsigned long long)words_lost);
+  shm_ring_close(&ring);
+  return result;
+}
@@ -2,11 +2,12 @@
 #define ADC_COMMANDS_H
 
 #include "command_helper.h"
+#include "shm_ring.h"
 
 // Structure for ADC command data (used for streaming commands from file)
 typedef struct {
-  char type;              // Command type: 'T' (Trigger), 'D' (Delay), 'O' (Order)
-  uint32_t value;         // Command value (for T, D commands - trigger cycles, delay cycles)
+  char type;              // Command type: 'T' (Trigger), 'D' (Delay), 'O' (Order), 'A' (Averaging)
+  uint32_t value;         // Command value (for T, D commands - trigger cycles, delay cycles; for A - log2 of reads per channel)
   uint32_t repeat_count;  // Repeat count for T, D commands (0 = execute once)
   uint8_t order[8];       // Channel order array (for O commands - specifies sampling order 0-7)
 } adc_command_t;
@@ -19,8 +20,20 @@ typedef struct {
   uint64_t word_count;         // Number of words to read from ADC
   volatile bool* should_stop;
   bool binary_mode;            // true for binary format, false for ASCII format
+  bool calibrated;             // Apply cal to each block before writing
+  struct cal_table_t cal;      // Correction snapshot taken when the stream started
+  uint16_t frame_len;          // Data words per frame to check (0 = not framed, words are written as read)
+  struct adc_frame_check_t frame_check;
 } adc_data_stream_params_t;
 
+// Structure to pass data to the ADC shared memory streaming thread (for daemon mode clients)
+typedef struct {
+  command_context_t* ctx;
+  uint8_t board;
+  struct shm_ring_t ring;      // Ring owned by the thread, unlinked when the stream stops
+  volatile bool* should_stop;
+} adc_shm_stream_params_t;
+
 // Structure to pass data to the ADC command streaming thread (for streaming commands from file)
 typedef struct {
   command_context_t* ctx;
@@ -29,8 +42,11 @@ typedef struct {
   volatile bool* should_stop;
   adc_command_t* commands;
   int command_count;
+  uint32_t* words;      // Commands encoded for one pass
+  size_t word_count;
   int iterations;  // Total number of iterations to perform
   bool simple_mode;     // Whether to unroll repeats instead of using repeat count in commands
+  bool owns_buffers;    // Free commands and words when the stream ends (false for experiment plans)
 } adc_command_stream_params_t;
 
 // ADC FIFO status commands
@@ -46,6 +62,9 @@ int cmd_read_adc_dbg(const char** args, int arg_count, const command_flag_t* fla
 int cmd_adc_noop(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_adc_cancel(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_adc_set_ord(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_adc_set_avg(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_adc_set_frame(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_adc_frame_sts(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
 // ADC reading operations
 int cmd_do_adc_rd(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
@@ -53,10 +72,21 @@ int cmd_do_adc_rd_ch(const char** args, int arg_count, const command_flag_t* fla
 
 // ADC data streaming operations (reading ADC data to files)
 int cmd_stream_adc_data_to_file(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_stream_adc_data_to_shm(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_stop_adc_data_stream(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
 // ADC command streaming operations (streaming commands from files)
 int cmd_stream_adc_commands_from_file(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_stop_adc_cmd_stream(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
+// Validate and parse an ADC command file into *commands (allocated, caller frees). Returns 0 on success.
+int parse_adc_command_file(const char* file_path, const struct spi_timing_t* timing, adc_command_t** commands, int* command_count);
+// Encode one pass of ADC commands into an allocated word buffer (NULL on allocation failure)
+uint32_t* encode_adc_commands(const adc_command_t* commands, int command_count, size_t* word_count);
+// Start a board's ADC command stream thread from parsed and encoded commands. With owns_buffers the
+// thread frees commands and words when it ends; otherwise they must outlive the stream.
+int start_adc_cmd_stream(command_context_t* ctx, uint8_t board, const char* file_path, adc_command_t* commands,
+                         int command_count, uint32_t* words, size_t word_count, int iterations, bool simple_mode,
+                         bool owns_buffers);
+
 #endif // ADC_COMMANDS_H
@@ -48,11 +48,19 @@ int parse_command_line(const char* line, const char** args, int* arg_count, comm
 command_entry_t* find_command(const char* name);
 
 // Command logging utilities
-void log_command_if_enabled(command_context_t* ctx, const char* command_line);
+// Each logged command is preceded by a "# @<seconds>" line, where seconds is the monotonic start
+// time relative to the start of the log, and both are flushed before the command runs. Once it
+// returns, a "# => rc=<result> <seconds> s" line records its result and duration (missing if the
+// session died during the command). load_commands ignores these lines.
+#define LOG_ENTRY_PREFIX "# @"
+#define LOG_RESULT_PREFIX "# => "
+void log_command_start(command_context_t* ctx, const char* command_line, const struct timespec* start_time);
+void log_command_result(command_context_t* ctx, const struct timespec* start_time, int result);
 
 // Command logging and loading commands
 int cmd_log_commands(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_stop_log(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_load_commands(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_replay_commands(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
 #endif // COMMAND_HANDLER_H
@@ -5,13 +5,20 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <pthread.h>
+#include <time.h>
 
 #include "sys_ctrl.h"
 #include "sys_sts.h"
 #include "adc_ctrl.h"
+#include "adc_frame.h"
 #include "dac_ctrl.h"
 #include "trigger_ctrl.h"
+#include "dac_ddr_buf.h"
 #include "spi_clk_ctrl.h"
+#include "spi_timing.h"
+#include "cal_table.h"
+#include "cal_store.h"
+#include "preemph.h"
 
 #define MAX_ARGS 16     // Maximum command arguments (including command name)
 #define MAX_FLAGS 5     // Maximum command flags
@@ -24,7 +31,8 @@ typedef enum {
   FLAG_SIMPLE,
   FLAG_BIN,
   FLAG_NO_RESET,
-  FLAG_NO_CAL
+  FLAG_NO_CAL,
+  FLAG_CAL
 } command_flag_t;
 
 // Global context passed to all command handlers
@@ -36,10 +44,16 @@ typedef struct command_context {
   struct dac_ctrl_t* dac_ctrl;
   struct adc_ctrl_t* adc_ctrl;
   struct trigger_ctrl_t* trigger_ctrl;
+  struct dac_ddr_buf_t* dac_ddr_buf;
   
   // System state
   bool* verbose;
   bool* should_exit;
+
+  // Console streams
+  FILE* in;                                  // Input for interactive prompts (the client's socket in daemon mode)
+  FILE* console_out;                         // Output of background threads, never sent to a daemon client
+  FILE* console_err;
   
   // ADC streaming management
   pthread_t adc_data_stream_threads[8];      // Thread handles for ADC data streaming (reading to file)
@@ -48,6 +62,8 @@ typedef struct command_context {
   pthread_t adc_cmd_stream_threads[8];       // Thread handles for ADC command streaming (from file)
   bool adc_cmd_stream_running[8];            // Status of each ADC command stream thread
   volatile bool adc_cmd_stream_stop[8];      // Stop signals for each ADC command stream thread
+  struct adc_frame_stats_t adc_frame_stats[8]; // Frame check counters of each board's last file stream (live while it runs)
+  uint16_t adc_frame_stats_len[8];           // Frame length that stream was checked against (0 = not framed)
   
   // DAC streaming management
   pthread_t dac_cmd_stream_threads[8];      // Thread handles for DAC command streaming
@@ -66,16 +82,39 @@ typedef struct command_context {
   pthread_t fieldmap_thread;                // Thread handle for fieldmap data collection
   bool fieldmap_running;                    // Status of fieldmap thread
   volatile bool fieldmap_stop;              // Stop signal for fieldmap thread
+  pthread_t regulate_thread;                // Thread handle for closed-loop regulation
+  bool regulate_running;                    // Status of regulation thread (true until it's joined)
+  volatile bool regulate_done;              // Set by the regulation thread when it exits
+  volatile bool regulate_stop;              // Stop signal for regulation thread
   
   // Command logging
   FILE* log_file;                       // File handle for command logging
   bool logging_enabled;                 // Whether command logging is active
+  struct timespec log_start_time;       // Monotonic time logging started (entry timestamps are relative to it)
+  int command_depth;                    // Nesting depth of execute_command (only top-level commands are logged)
+  bool replay_active;                   // A replay_commands is running (replays can't nest)
   
   // ADC bias calibration storage (64 channels, 8 boards * 8 channels each)
   double adc_bias[64];                  // ADC bias values for each channel (0-63)
   bool adc_bias_valid[64];              // Whether each ADC bias value is valid
   double adc_bias_previous[64];         // Previous ADC bias values for comparison
   bool adc_bias_previous_valid[64];     // Whether each previous ADC bias value is valid
+
+  // DAC->ADC gain/offset correction tables fitted by cal_fit (applied to captured ADC data)
+  struct cal_table_t adc_cal;
+
+  // DAC offsets set by channel_cal/set_dac_cal (pushed back to the DAC cores after 'on')
+  int16_t dac_cal[64];
+  bool dac_cal_valid[64];
+
+  // Calibration store (see cal_store.h); an empty path disables loading and saving
+  char cal_store_path[1024];
+  int64_t adc_bias_time[8];             // When each board's ADC bias was last measured (Unix seconds, 0 = never)
+  int64_t dac_cal_time[8];              // When each board's DAC offsets were last set
+  int64_t adc_cal_time[8];              // When each board's correction table was last fitted
+
+  // Eddy-current pre-emphasis applied to DAC waveform files when loaded (see preemph.h)
+  struct preemph_t preemph;
 } command_context_t;
 
 // Basic parsing and validation utilities
@@ -88,9 +127,16 @@ int parse_trigger_mode(const char* mode_str, const char* value_str, bool* is_tri
 int validate_board_number(const char* board_str);
 int validate_channel_number(const char* channel_str, int* board, int* channel);
 
+// SPI command timing (see spi_timing.h) for the measured SPI clock
+struct spi_timing_t get_spi_timing(command_context_t* ctx);
+int validate_dac_wr_delay(const struct spi_timing_t* timing, uint32_t delay_cycles);
+int validate_adc_rd_delay(const struct spi_timing_t* timing, uint32_t delay_cycles);
+int validate_adc_rd_avg_delay(const struct spi_timing_t* timing, uint32_t delay_cycles, uint8_t avg_log2);
+
 // File path resolution with glob support
-int resolve_file_path(const char* pattern, char* resolved_path, size_t resolved_path_size);
-int resolve_file_pattern(const char* pattern, char* resolved_path, size_t resolved_path_size);
+// (multiple matches prompt for a choice, read from in)
+int resolve_file_path(const char* pattern, char* resolved_path, size_t resolved_path_size, FILE* in);
+int resolve_file_pattern(const char* pattern, char* resolved_path, size_t resolved_path_size, FILE* in);
 
 // File path utilities
 void clean_and_expand_path(const char* input_path, char* full_path, size_t full_path_size);
@@ -98,7 +144,11 @@ void set_file_permissions(const char* file_path, bool verbose);
 
 // File selection utilities
 int prompt_file_selection(const char* prompt_text, const char* default_file,
-                         char* resolved_path, size_t resolved_path_size);
+                         char* resolved_path, size_t resolved_path_size, FILE* in);
+
+// ADC correction for captured data: the fitted table, with offset-only entries from the
+// ADC bias for channels that have a bias but no fit
+void get_adc_correction(command_context_t* ctx, struct cal_table_t* table);
 
 // Display/output helper functions
 void print_trigger_data(uint64_t data);
@@ -3,6 +3,8 @@
 
 #include "command_helper.h"
 
+struct waveform_pack; // waveform_pack.h
+
 // Structure to hold a parsed waveform command
 typedef struct {
   bool is_trigger;     // true for T, false for D
@@ -10,6 +12,8 @@ typedef struct {
   bool has_ch_vals;    // whether channel values are present
   int16_t ch_vals[8];  // channel values (if present)
   bool cont;           // continue flag
+  int loop_commands;   // Commands in the hardware loop block starting here (0 if none)
+  uint32_t loop_passes; // Passes of that block (0 repeats until cancelled)
 } waveform_command_t;
 
 // Structure to pass data to the DAC streaming thread
@@ -20,7 +24,12 @@ typedef struct {
   volatile bool* should_stop;
   waveform_command_t* commands;
   int command_count;
+  uint32_t* words;      // Commands encoded for one pass (cont set throughout)
+  size_t word_count;
   int iterations;       // Number of times to iterate through the waveform
+  bool owns_buffers;    // Free commands and words (or pack) when the stream ends (false for experiment plans)
+  const struct waveform_pack* pack; // Packed waveform decoded on the fly instead of commands/words (NULL if none)
+  struct preemph_t* preemph;        // Pre-emphasis applied while decoding a pack (owned by the thread, NULL if none)
 } dac_command_stream_params_t;
 
 // Structure to pass data to the DAC debug streaming thread
@@ -48,11 +57,52 @@ int cmd_do_dac_wr_ch(const char** args, int arg_count, const command_flag_t* fla
 int cmd_get_dac_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_do_dac_get_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_set_dac_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+
+// Push the remembered DAC offsets (ctx->dac_cal) to all connected boards with batched SET_CAL
+// commands and confirm them with a GET_CAL readback. Returns the number of channels pushed, or -1
+// if any readback was missing or wrong.
+int push_dac_cal(command_context_t* ctx);
 int cmd_dac_zero(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
 // DAC command streaming operations (streaming commands from files)
 int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_stop_dac_cmd_stream(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// DAC DDR buffer operations (whole waveform uploaded once, played by the board's DDR reader)
+int cmd_upload_dac_waveform(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_dac_ddr_sts(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_stop_dac_ddr(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Run a waveform file through a model of the board's threshold integrator with the current integ_window
+// and integ_average, reporting each channel's margin and the first trip. Returns -1 if it would trip.
+int cmd_precheck(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+
+// Validate and parse a waveform file into *commands (allocated, caller frees). Returns 0 on success.
+int parse_waveform_file(const char* file_path, const struct spi_timing_t* timing, waveform_command_t** commands, int* command_count);
+// FIFO words a parsed command takes (including the LOOP word of a block it starts)
+uint32_t waveform_command_words(const waveform_command_t* cmd);
+// Whether a parsed waveform ends in a loop that repeats until cancelled
+bool waveform_loops_forever(const waveform_command_t* commands, int command_count);
+// Encode one pass of waveform commands into an allocated word buffer (NULL on allocation failure)
+uint32_t* encode_waveform_commands(const waveform_command_t* commands, int command_count, size_t* word_count);
+// Apply the pre-emphasis for a board's channels to one parsed command / one pass of parsed commands
+// in place (trigger waits hold for the coefficients' trigger_hold). The pass version returns the
+// filter state with the clipping report.
+void preemph_waveform_command(const struct preemph_t* preemph, struct preemph_state_t* state, waveform_command_t* cmd);
+struct preemph_state_t preemph_waveform_commands(const struct preemph_t* preemph, uint8_t board, uint32_t spi_clk_freq_hz,
+                                                 waveform_command_t* commands, int command_count);
+// Start a board's DAC command stream thread from parsed and encoded commands. With owns_buffers the
+// thread frees commands and words when it ends; otherwise they must outlive the stream.
+int start_dac_cmd_stream(command_context_t* ctx, uint8_t board, const char* file_path, waveform_command_t* commands,
+                         int command_count, uint32_t* words, size_t word_count, int iterations, bool owns_buffers);
+
+// Load a packed waveform (see waveform_pack.h), warning if it was converted at another SPI clock.
+// Returns 1 if the file isn't packed.
+int load_dac_waveform_pack(const char* file_path, const struct spi_timing_t* timing, struct waveform_pack* pack);
+// Start a board's DAC command stream thread decoding a packed waveform on the fly (with pre-emphasis
+// if preemph isn't NULL; it is copied). With owns_pack the thread frees the pack (and its struct).
+int start_dac_packed_stream(command_context_t* ctx, uint8_t board, const char* file_path, const struct waveform_pack* pack,
+                            int iterations, const struct preemph_t* preemph, bool owns_pack);
+// Pack a D/T waveform file into the compact format
+int cmd_pack_dac_waveform(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
 // DAC debug streaming operations (streaming debug data to files)
 int cmd_stream_dac_debug(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
@@ -0,0 +1,26 @@
+#ifndef DAEMON_SERVER_H
+#define DAEMON_SERVER_H
+
+#include <stdbool.h>
+#include "command_helper.h"
+
+//////////////////// Daemon Definitions ////////////////////
+// Default Unix domain socket for daemon mode
+#define DAEMON_DEFAULT_SOCKET_PATH  "/tmp/shim-test.sock"
+
+// Line sent by the daemon after each command's output: "@@END <result>"
+#define DAEMON_END_MARKER           "@@END"
+
+// Maximum number of simultaneously connected clients
+#define DAEMON_MAX_CLIENTS          8
+
+//////////////////////////////////////////////////////////////////
+
+// Run the daemon: serve commands from clients on socket_path until 'exit' is received.
+// Commands from all clients are executed one at a time against the shared context.
+int daemon_run(command_context_t* ctx, const char* socket_path);
+
+// Run an interactive client connected to a daemon on socket_path
+int daemon_client_run(const char* socket_path);
+
+#endif // DAEMON_SERVER_H
@@ -17,6 +17,27 @@ int cmd_print_adc_bias(const char** args, int arg_count, const command_flag_t* f
 int cmd_save_adc_bias(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_load_adc_bias(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
+// DAC->ADC correction table commands - fit gain/offset per channel from a sweep, print, discard
+int cmd_cal_fit(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_print_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_clear_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+
+// Waveform pre-emphasis commands (load coefficients, print them, discard them)
+int cmd_load_preemph(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_print_preemph(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_clear_preemph(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+
+// Calibration store commands - save/load every board's calibration, and probe calibrated channels for drift
+int cmd_save_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_load_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_cal_verify(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+
+// Load a calibration store into the context at startup (0 loaded, 1 no file, -1 invalid)
+int load_calibration_store(command_context_t* ctx, const char* path);
+
+// Crosstalk matrix command - drive each connected channel in turn and write the 64x64 coupling matrix
+int cmd_crosstalk(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+
 // Waveform test command - easily load, run, and log waveforms
 int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
@@ -32,6 +53,12 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
 // Stop fieldmap data collection command
 int cmd_stop_fieldmap(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
+// Closed-loop current regulation command
+int cmd_regulate(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+
+// Stop closed-loop regulation command
+int cmd_stop_regulate(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+
 // Stop trigger monitor command
 int cmd_stop_trigger_monitor(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
@@ -0,0 +1,97 @@
+#ifndef EXPERIMENT_PLAN_H
+#define EXPERIMENT_PLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include <sys/types.h>
+#include "command_helper.h"
+#include "dac_commands.h"
+#include "adc_commands.h"
+#include "waveform_pack.h"
+
+//////////////////// Experiment Plan Definitions ////////////////////
+// Everything a waveform run needs, computed from a single parse of each distinct DAC/ADC file:
+// encoded command words for one pass (handed to the streamers as-is), trigger and ADC word
+// counts, FIFO load, expected duration and output file sizes. A file shared by several boards
+// is parsed once, and unchanged files are reused from the previous plan on the next run.
+// With pre-emphasis loaded, a DAC file is filtered per board (the coefficients are per channel).
+// Packed DAC files keep only their packed bytes; the streams decode them on the fly.
+#define EXPERIMENT_PLAN_MAX_SOURCES 16 // One DAC and one ADC file per board
+
+// Upper bounds on ASCII output sizes (see the ADC/trigger data stream threads)
+#define EXPERIMENT_PLAN_ADC_ASCII_BYTES_PER_WORD  14 // Two "-32768" samples plus separators
+#define EXPERIMENT_PLAN_TRIG_ASCII_BYTES          19 // "0x%016x\n"
+
+//////////////////////////////////////////////////////////////////
+
+// One parsed and encoded DAC or ADC command file
+typedef struct {
+  char path[1024];
+  bool is_dac;
+  struct timespec mtime;         // File identity when parsed (reused only while unchanged)
+  off_t size;
+  uint32_t spi_clk_freq_hz;      // Timing the delays were converted with
+  waveform_command_t* dac_commands;
+  adc_command_t* adc_commands;
+  int command_count;
+  uint32_t* words;               // Encoded commands for one pass (NULL for packed files)
+  size_t word_count;
+  bool packed;                   // DAC file in the packed format (see waveform_pack.h)
+  waveform_pack_t pack;
+  uint32_t triggers;             // Triggers waited for per pass
+  uint64_t adc_data_words;       // ADC data words produced per pass (ADC files)
+  uint64_t timed_cycles;         // Delay cycles per pass, not counting trigger waits
+  uint32_t max_gap_words;        // Most command words between trigger waits
+  int preemph_board;             // Board the commands were pre-emphasized for (-1: verbatim)
+  uint32_t preemph_generation;   // Coefficients they were filtered with
+  struct preemph_state_t preemph; // Clipping report
+  bool in_use;
+} plan_source_t;
+
+// Per-board part of a plan
+typedef struct {
+  int dac_source;                // Index into sources
+  int adc_source;
+  int dac_iterations;
+  int adc_iterations;
+  uint32_t triggers;             // Total triggers over all iterations
+  uint64_t adc_data_words;       // Total ADC data words
+  uint64_t timed_cycles;         // Longer of the DAC/ADC timed cycles over all iterations
+  uint64_t adc_file_bytes;       // Output size (exact for binary, upper bound for ASCII)
+} board_plan_t;
+
+typedef struct {
+  plan_source_t sources[EXPERIMENT_PLAN_MAX_SOURCES];
+  int source_count;
+  bool boards[8];
+  board_plan_t board[8];
+  uint32_t total_triggers;       // Same on every board
+  uint32_t lockout_cycles;
+  double spi_freq_mhz;
+  uint64_t duration_cycles;      // Minimum run time: timed cycles plus one lockout per trigger
+  uint64_t trig_file_bytes;
+  bool binary_output;
+  int parsed_files;              // Files parsed by the last build (the rest were reused)
+} experiment_plan_t;
+
+// Build (or rebuild) a plan for the given boards. A plan that was built before keeps the
+// sources whose files haven't changed; the rest are parsed once each. Returns 0 on success,
+// -1 on a parse error or inconsistent trigger counts (printed). The plan's buffers must
+// outlive any streams started from it.
+int experiment_plan_build(experiment_plan_t* plan, command_context_t* ctx, const bool boards[8],
+                          const char dac_files[8][1024], const char adc_files[8][1024],
+                          const int dac_iterations[8], const int adc_iterations[8],
+                          uint32_t lockout_cycles, double spi_freq_mhz, bool binary_output);
+
+// Print the plan summary (per-board counts, FIFO load, duration and output sizes)
+void experiment_plan_print(const experiment_plan_t* plan, bool verbose);
+
+// Start the DAC and ADC command streams of every board from the plan's encoded words
+int experiment_plan_start_streams(const experiment_plan_t* plan, command_context_t* ctx);
+
+// Free every source
+void experiment_plan_free(experiment_plan_t* plan);
+
+#endif // EXPERIMENT_PLAN_H
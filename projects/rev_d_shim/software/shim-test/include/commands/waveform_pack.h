@@ -0,0 +1,73 @@
+#ifndef WAVEFORM_PACK_H
+#define WAVEFORM_PACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "dac_commands.h"
+
+//////////////////// Packed Waveform Definitions ////////////////////
+// Compact binary form of a DAC command (D/T) file. After a fixed header, each command is an
+// op byte plus varints:
+//   CMD     flags (trigger, has values, value same as previous, values same as previous
+//           command with values); then the value unless same, then 8 zigzag deltas against
+//           the previous values unless same. An unchanged command is a single byte.
+//   REPEAT  <distance> <count>: replay count commands starting distance commands back
+//           (distance 1 is a run of the previous command; count > distance repeats a block).
+// Streams decode it into FIFO words on the fly, so memory use is the file size plus a ring
+// of the last WAVEFORM_PACK_MAX_DISTANCE commands.
+#define WAVEFORM_PACK_MAGIC         (uint32_t) 0x5A574853 // "SHWZ"
+#define WAVEFORM_PACK_VERSION       (uint16_t) 1
+#define WAVEFORM_PACK_MAX_DISTANCE  4096 // Longest repeated block (commands); power of two
+#define WAVEFORM_PACK_MIN_REPEAT    4    // Shortest replay worth a REPEAT op (commands)
+
+//////////////////////////////////////////////////////////////////
+
+// A packed waveform, with the counts a stream or plan needs without decoding it
+typedef struct waveform_pack {
+  uint32_t spi_clk_freq_hz;      // SPI clock the delays were converted with
+  uint64_t command_count;
+  uint64_t word_count;           // FIFO words for one pass
+  uint64_t timed_cycles;         // Delay cycles per pass, not counting trigger waits
+  uint32_t triggers;             // Triggers waited for per pass
+  uint32_t max_gap_words;        // Most command words between trigger waits
+  uint8_t* data;                 // Encoded commands
+  size_t size;
+} waveform_pack_t;
+
+// Sequential decoder for one pass
+typedef struct {
+  const waveform_pack_t* pack;
+  size_t pos;
+  uint64_t decoded;
+  int16_t prev_vals[8];          // Values of the last command that had them
+  uint32_t repeat_distance;      // Active REPEAT op
+  uint64_t repeat_left;
+  waveform_command_t* history;   // Ring of the last WAVEFORM_PACK_MAX_DISTANCE commands
+} waveform_unpacker_t;
+
+// Pack parsed commands (delays already in cycles at spi_clk_freq_hz). Returns 0 on success.
+int waveform_pack_commands(const waveform_command_t* commands, int command_count, uint32_t spi_clk_freq_hz,
+                           waveform_pack_t* pack);
+
+// Save to / load from a file. Loading returns 1 if the file isn't a packed waveform.
+int waveform_pack_save(const waveform_pack_t* pack, const char* path);
+int waveform_pack_load(const char* path, waveform_pack_t* pack);
+
+// Whether a file starts with the packed waveform magic
+bool waveform_pack_is_packed(const char* path);
+
+void waveform_pack_free(waveform_pack_t* pack);
+
+// Start a pass (allocates the history ring). Returns 0 on success.
+int waveform_unpacker_init(waveform_unpacker_t* unpacker, const waveform_pack_t* pack);
+
+// Decode the next command: 1 if one was decoded, 0 at the end of the pass, -1 if the data is corrupt
+int waveform_unpacker_next(waveform_unpacker_t* unpacker, waveform_command_t* cmd);
+
+// Rewind to the start of the pass
+void waveform_unpacker_rewind(waveform_unpacker_t* unpacker);
+
+void waveform_unpacker_free(waveform_unpacker_t* unpacker);
+
+#endif // WAVEFORM_PACK_H
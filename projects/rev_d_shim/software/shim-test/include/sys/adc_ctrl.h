@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "map_memory.h"
 
 //////////////////// ADC Control Definitions ////////////////////
@@ -31,6 +32,9 @@
 #define ADC_CMD_SET_ORD   1
 #define ADC_CMD_ADC_RD    2
 #define ADC_CMD_ADC_RD_CH 3
+#define ADC_CMD_SET_AVG   4
+#define ADC_CMD_SET_FRAME 5
+#define ADC_CMD_LOOP      6
 #define ADC_CMD_CANCEL    7
 
 // ADC command bits
@@ -39,6 +43,24 @@
 #define ADC_CMD_CONT_BIT 27
 #define ADC_CMD_REPEAT_BIT 26
 
+// LOOP command fields: [25:16] block length in words, [15:0] passes (0 repeats until cancelled)
+#define ADC_LOOP_LEN_LSB    16
+#define ADC_LOOP_LEN_MAX    0x3FF
+#define ADC_LOOP_PASSES_MAX 0xFFFF
+// Loop buffer depth (longest block, in words)
+#define ADC_LOOP_WORDCOUNT  256
+
+// SET_AVG command field: [3:0] log2 of the reads averaged per channel by ADC_RD (1 to 256 reads)
+#define ADC_AVG_LOG2_MAX    8
+
+// SET_FRAME command field: [15:0] data words per frame (0 turns framing off)
+#define ADC_FRAME_LEN_MAX   511
+// Frame marker word: {tag[31:28], board[27:25], drops[24:16], sequence[15:0]}
+#define ADC_FRAME_MARKER_TAG               0xA
+#define ADC_FRAME_IS_MARKER(word, board)   (((word) >> 25) == ((ADC_FRAME_MARKER_TAG << 3) | ((board) & 0x7)))
+#define ADC_FRAME_DROPS(word)              (((word) >> 16) & 0x1FF) // Data words of the frame that were dropped
+#define ADC_FRAME_SEQ(word)                ((word) & 0xFFFF)        // Frame number (marker 0 starts framing)
+
 // ADC debug codes
 #define ADC_DBG(word)                (((word) >> 28) & 0x0F) // Top 4 bits for debug code
 #define ADC_DBG_MISO_DATA            1
@@ -56,6 +78,7 @@
 // ADC control structure
 struct adc_ctrl_t {
   volatile uint32_t *buffer[8];  // ADC FIFO (command and data)
+  uint16_t frame_len[8];         // Data words per frame set by SET_FRAME (0 = framing off)
 };
 
 // Function declarations
@@ -76,9 +99,31 @@ char* adc_format_single(uint32_t data_word, bool verbose);
 
 // ADC command word functions
 void adc_cmd_noop(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool trig, bool cont, uint32_t value, bool verbose);
-void adc_cmd_adc_rd(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool trig, bool cont, uint32_t value, uint32_t repeat_count, bool verbose);
+// ADC_RD with avg_log2 > 0 averages 2^avg_log2 reads per channel, setting SET_AVG around it (the delay must cover the longer read)
+void adc_cmd_adc_rd(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool trig, bool cont, uint32_t value, uint32_t repeat_count, uint8_t avg_log2, bool verbose);
 void adc_cmd_adc_rd_ch(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint8_t ch, uint32_t repeat_count, bool verbose);
 void adc_cmd_set_ord(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint8_t channel_order[8], bool verbose);
+void adc_cmd_set_avg(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint8_t avg_log2, bool verbose);
+// SET_FRAME also records the frame length, so data streams know to check the markers
+void adc_cmd_set_frame(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint16_t frame_len, bool verbose);
 void adc_cmd_cancel(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool verbose);
 
+// Command stream functions (precomputed sequences, pushed in bulk)
+// Encode a NO_OP/ADC_RD command word without a repeat count (value must be 25 bits)
+uint32_t adc_encode_cmd(uint8_t cmd, bool trig, bool cont, uint32_t value);
+// Encode an ADC_RD command (plus its repeat word when repeat_count > 0); returns the word count
+size_t adc_encode_adc_rd(uint32_t words[2], bool trig, bool cont, uint32_t value, uint32_t repeat_count);
+// Encode a SET_ORD command word (entries must be 0-7)
+uint32_t adc_encode_set_ord(const uint8_t channel_order[8]);
+// Encode a SET_AVG command word (avg_log2 must be 0 to ADC_AVG_LOG2_MAX)
+uint32_t adc_encode_set_avg(uint8_t avg_log2);
+// Encode a SET_FRAME command word (frame_len must be 0 to ADC_FRAME_LEN_MAX)
+uint32_t adc_encode_set_frame(uint16_t frame_len);
+// Encode a LOOP command word (block_words must be 1 to ADC_LOOP_WORDCOUNT)
+uint32_t adc_encode_loop(uint32_t block_words, uint32_t passes);
+// Push encoded command words into a board's command FIFO
+void adc_write_cmd_words(struct adc_ctrl_t *adc_ctrl, uint8_t board, const uint32_t *words, size_t count);
+// Pop count data words from a board (the caller checks the FIFO holds them)
+void adc_read_words(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint32_t *words, size_t count);
+
 #endif // ADC_CTRL_H
@@ -0,0 +1,94 @@
+#ifndef ADC_FRAME_H
+#define ADC_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "adc_ctrl.h"
+
+//////////////////// ADC Frame Check Definitions ////////////////////
+// Continuity check for a board's framed ADC data (SET_FRAME, see the ADC core README). Each
+// frame's marker follows the frame's surviving data words, so exactly frame_len - drops data
+// words sit between consecutive markers, and a jump in sequence number means the frames in
+// between were dropped whole: (jump - 1) * frame_len + drops words are missing from that span.
+//
+// Sample words can look like markers, so a word is only taken as one where its own drop count
+// puts it (frame_len - drops words after the previous marker):
+//   - with the next sequence number, it is accepted right away (a sample word matching the tag,
+//     board, sequence number and drop count at that spot together is a 2^-32 chance)
+//   - with a jump in sequence number, it is held back until the next marker confirms it the
+//     same way, since the sequence number no longer narrows it down
+// If no marker turns up within a frame of the last one, the data isn't framed the way it was set
+// up (or a stall of 65536 frames wrapped the sequence number). The data is then passed on
+// unverified until a pair of markers with consecutive sequence numbers lines up again, which is
+// also how the check syncs at the start of the stream, unless it opens with marker 0.
+//
+// At the end of the stream, a held-back jump is accepted once the stream has run past every spot
+// the marker before it could have been followed without one. Otherwise its marker-like words are
+// stripped (not passed on as data) and the words after the last accepted marker are unverified.
+#define ADC_FRAME_MAX_CANDIDATES 32                            // Unconfirmed markers tracked at once
+#define ADC_FRAME_HOLD_WORDS     (4 * (ADC_FRAME_LEN_MAX + 1)) // Words held back behind them
+
+//////////////////////////////////////////////////////////////////
+
+// Counters for one stream (live while it runs)
+struct adc_frame_stats_t {
+  uint64_t data_words;           // Data words passed on
+  uint64_t markers;              // Markers accepted
+  uint64_t gaps;                 // Spans between markers with words missing
+  uint64_t words_lost;           // Data words missing from those spans
+  uint64_t unverified;           // Data words passed on in spans no pair of markers accounts for
+  uint64_t sync_losses;          // Times no marker turned up where one had to
+  uint64_t stripped;             // Marker-like words left out at the end of the stream, unconfirmed
+};
+
+// A marker-like word waiting for confirmation
+struct adc_frame_candidate_t {
+  uint64_t index;                // Stream position
+  uint16_t seq;
+  int parent;                    // Candidate it follows a jump from, or -1 for the last accepted marker
+};
+
+// Checker state for one board's stream
+struct adc_frame_check_t {
+  uint8_t board;
+  uint32_t frame_len;
+  FILE *log;                     // Gap log (NULL for none)
+
+  bool synced;                   // last_seq/last_index belong to an accepted marker
+  uint16_t last_seq;
+  uint64_t last_index;           // Stream position of the last accepted marker
+  uint64_t span_start;           // Data word offset of the current span (after the last marker)
+  uint64_t span_words;           // Data words passed on in the current span
+  uint64_t index;                // Words taken in so far
+
+  // Words held back, from the oldest candidate on
+  uint32_t hold[ADC_FRAME_HOLD_WORDS];
+  uint64_t hold_index;           // Stream position of hold[0]
+  size_t hold_count;
+  struct adc_frame_candidate_t candidates[ADC_FRAME_MAX_CANDIDATES];
+  int candidate_count;
+
+  struct adc_frame_stats_t stats;
+};
+
+// Start checking a stream from the given board with frame_len data words per frame (1 to
+// ADC_FRAME_LEN_MAX). Gaps are logged to log (if not NULL) under a header.
+void adc_frame_check_init(struct adc_frame_check_t *check, uint8_t board, uint32_t frame_len, FILE *log);
+
+// Take in count stream words and pass on the data words in order, less the markers. Words held
+// back behind an unconfirmed marker come out later, so data needs room for count +
+// ADC_FRAME_HOLD_WORDS words. Returns the number of data words written to data.
+size_t adc_frame_check_words(struct adc_frame_check_t *check, const uint32_t *words, size_t count, uint32_t *data);
+
+// End of stream: settle the words held back (see above), pass them on (room for
+// ADC_FRAME_HOLD_WORDS) and log the summary.
+// Returns the number of data words written to data.
+size_t adc_frame_check_finish(struct adc_frame_check_t *check, uint32_t *data);
+
+// Whether every data word so far is accounted for by a pair of markers with nothing missing
+// (the words after the last marker, check->span_words, can't be checked yet)
+bool adc_frame_check_complete(const struct adc_frame_check_t *check);
+
+#endif // ADC_FRAME_H
@@ -0,0 +1,66 @@
+#ifndef CAL_STORE_H
+#define CAL_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "cal_table.h"
+
+//////////////////// Calibration Store Definitions ////////////////////
+// Binary file holding the calibration of every board slot: a header followed by
+// CAL_STORE_BOARDS fixed-size records, protected by a CRC-32 over the records.
+// Readers reject files with a different version or record size.
+#define CAL_STORE_MAGIC          (uint32_t) 0x4C434853 // "SHCL"
+#define CAL_STORE_VERSION        (uint16_t) 1
+#define CAL_STORE_BOARDS         8
+#define CAL_STORE_DEFAULT_FILE   ".shim_cal.bin" // Default store, in $HOME
+#define CAL_STORE_MAX_AGE_S      (int64_t) (7 * 24 * 3600) // Older entries are reported as stale
+
+//////////////////////////////////////////////////////////////////
+
+// One board slot. Times are Unix seconds (0 if that calibration was never stored);
+// valid masks have one bit per channel.
+struct cal_store_board_t {
+  int64_t adc_bias_time;         // When the ADC bias was measured (find_bias/load_adc_bias)
+  int64_t dac_cal_time;          // When the DAC offsets were set (channel_cal/set_dac_cal)
+  int64_t adc_fit_time;          // When the gain/offset fit was made (cal_fit)
+  uint8_t adc_bias_valid;        // Channels with an ADC bias
+  uint8_t dac_cal_valid;         // Channels with a DAC offset
+  uint8_t fit_status[8];         // CAL_FIT_* per channel
+  uint8_t fit_order[8];
+  uint8_t reserved[6];
+  float adc_bias[8];
+  int16_t dac_cal[8];            // DAC SET_CAL offsets
+  int32_t fit_mul[8];            // cal_table_t coefficients
+  int32_t fit_add[8];
+  int32_t fit_quad[8];
+  float fit_gain[8];
+  float fit_offset[8];
+  float fit_rms[8];
+};
+
+// Contents of a store file
+struct cal_store_t {
+  int64_t saved_time;            // When the file was written
+  struct cal_store_board_t boards[CAL_STORE_BOARDS];
+};
+
+// Default store path ($HOME/CAL_STORE_DEFAULT_FILE, or the working directory without $HOME)
+void cal_store_default_path(char *path, size_t size);
+
+// Write a store atomically (temporary file, then rename). Returns 0 on success, -1 on error.
+int cal_store_save(const struct cal_store_t *store, const char *path);
+
+// Read and validate a store. Returns 0 on success, 1 if the file doesn't exist,
+// -1 if it can't be read or fails validation (the reason is printed).
+int cal_store_load(struct cal_store_t *store, const char *path);
+
+// Move a store that failed to load aside to <path>.bak (replacing an older backup) so the
+// next save doesn't overwrite it. Returns 0 on success, -1 on error (the reason is printed).
+int cal_store_backup(const char *path, char *backup_path, size_t size);
+
+// Copy a board's fit entries into/out of a correction table
+void cal_store_put_fit(struct cal_store_board_t *board_rec, const struct cal_table_t *table, int board);
+void cal_store_get_fit(const struct cal_store_board_t *board_rec, struct cal_table_t *table, int board);
+
+#endif // CAL_STORE_H
@@ -0,0 +1,80 @@
+#ifndef CAL_TABLE_H
+#define CAL_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//////////////////// Calibration Table Definitions ////////////////////
+// Per-channel DAC->ADC correction. Each channel's fit maps a raw (signed) ADC sample y
+// back to the DAC code that produced it:
+//   corrected = c0 + c1*y + c2*y^2
+// stored in fixed point so the capture path only needs integer multiply-adds:
+//   corrected = (y*mul + add + ((y*y*quad) >> CAL_TABLE_QUAD_SHIFT)) >> CAL_TABLE_FRAC_BITS
+#define CAL_TABLE_CHANNELS      64
+#define CAL_TABLE_MAX_ORDER     2
+#define CAL_TABLE_FRAC_BITS     14 // mul and add are Q14
+#define CAL_TABLE_QUAD_SHIFT    20 // quad is Q(14 + 20), applied in 64 bits
+#define CAL_TABLE_MAX_POINTS    64 // Sweep points per channel accepted by cal_table_fit
+
+// Coefficient limits that keep the linear kernel inside 32 bits
+// (|y*mul| < 2^30 and |add| < 2^29)
+#define CAL_TABLE_MAX_MUL       (int32_t) (2 << CAL_TABLE_FRAC_BITS)     // |c1| < 2
+#define CAL_TABLE_MAX_ADD       (int32_t) (16384 << CAL_TABLE_FRAC_BITS) // |c0| < 16384 codes
+
+// Per-channel fit status
+#define CAL_FIT_NONE            (uint8_t) 0 // Not fitted (no correction applied)
+#define CAL_FIT_OK              (uint8_t) 1 // Fitted from sweep data
+#define CAL_FIT_OFFSET_ONLY     (uint8_t) 2 // Offset-only entry (e.g. from an ADC bias measurement)
+#define CAL_FIT_NO_DATA         (uint8_t) 3 // Too few sweep points
+#define CAL_FIT_SINGULAR        (uint8_t) 4 // ADC readings don't vary with the DAC code
+#define CAL_FIT_OUT_OF_RANGE    (uint8_t) 5 // Coefficients don't fit the fixed-point table
+
+//////////////////////////////////////////////////////////////////
+
+// Correction table for all channels. The kernel only reads mul/add/quad (uncorrected
+// channels hold the identity, mul = 1.0); the float fields are fit diagnostics.
+struct cal_table_t {
+  int32_t mul[CAL_TABLE_CHANNELS];    // c1, Q14
+  int32_t add[CAL_TABLE_CHANNELS];    // c0, Q14, with the final rounding folded in
+  int32_t quad[CAL_TABLE_CHANNELS];   // c2, Q34 (zero for linear fits)
+  uint8_t status[CAL_TABLE_CHANNELS]; // CAL_FIT_*
+  uint8_t order[CAL_TABLE_CHANNELS];  // Polynomial order of the fit
+  float gain[CAL_TABLE_CHANNELS];     // Forward DAC->ADC gain (ADC codes per DAC code) at zero
+  float offset[CAL_TABLE_CHANNELS];   // ADC reading at DAC code zero
+  float rms_residual[CAL_TABLE_CHANNELS]; // Fit residual in DAC codes
+};
+
+// Create an identity table (every channel passes through unchanged)
+struct cal_table_t create_cal_table(void);
+
+// Whether a channel has a correction (fitted or offset-only)
+bool cal_table_channel_valid(const struct cal_table_t *table, int ch);
+
+// Name of a CAL_FIT_* status
+const char *cal_fit_status_name(uint8_t status);
+
+// Fit every channel selected in ch_mask from one sweep: dac_codes[point] is shared by all
+// channels and adc[point * CAL_TABLE_CHANNELS + ch] is the (averaged) signed ADC reading of
+// channel ch at that point. order is 1 (gain and offset) or 2. Channels outside the mask
+// are left as they were. Returns the number of channels fitted successfully.
+int cal_table_fit(struct cal_table_t *table, const bool ch_mask[CAL_TABLE_CHANNELS],
+                  const double *dac_codes, const double *adc, int points, int order);
+
+// Set an offset-only entry that subtracts an ADC bias from the channel
+void cal_table_set_offset(struct cal_table_t *table, int ch, double adc_bias);
+
+// Reset a channel to the identity
+void cal_table_clear_channel(struct cal_table_t *table, int ch);
+
+// Correct a single signed sample
+int16_t cal_table_apply_sample(const struct cal_table_t *table, int ch, int16_t sample);
+
+// Correct a block of packed ADC_RD data words from one board (default channel order:
+// each word holds channels 2k (bits 15:0) and 2k+1 (bits 31:16), four words per read).
+// first_word is the index of words[0] within its read (0-3) so blocks can split reads.
+// out may alias words. Samples stay in offset binary, saturated to 16 bits.
+void cal_table_apply_words(const struct cal_table_t *table, uint8_t board, const uint32_t *words,
+                           uint32_t *out, size_t count, uint32_t first_word);
+
+#endif // CAL_TABLE_H
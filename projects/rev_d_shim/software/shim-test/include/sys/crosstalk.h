@@ -0,0 +1,60 @@
+#ifndef CROSSTALK_H
+#define CROSSTALK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//////////////////// Crosstalk Matrix Definitions ////////////////////
+// Coupling between every pair of channels, measured by driving one channel at a time to
+// +/-amplitude and reading all channels. The +/- difference cancels offsets, so each entry is
+// the measured channel's response per unit of drive (ADC codes per DAC code; the diagonal is
+// the channel's own loop gain).
+#define CROSSTALK_CHANNELS   64
+
+// Binary matrix file: a crosstalk_file_header_t followed by CROSSTALK_CHANNELS^2 float32
+// entries, row-major by driven channel (NaN where either channel wasn't measured)
+#define CROSSTALK_MAGIC      (uint32_t) 0x54584853 // "SHXT"
+#define CROSSTALK_VERSION    (uint16_t) 1
+
+//////////////////////////////////////////////////////////////////
+
+typedef struct {
+  uint32_t magic;                // CROSSTALK_MAGIC
+  uint16_t version;              // CROSSTALK_VERSION
+  uint16_t channels;             // CROSSTALK_CHANNELS
+  uint64_t channel_mask;         // Measured channels (bit per channel)
+  float amplitude;               // Drive amplitude in DAC codes
+  uint32_t samples;              // ADC reads averaged per polarity
+  int64_t time;                  // Unix time of the measurement
+} crosstalk_file_header_t;
+
+// Coupling matrix
+struct crosstalk_matrix_t {
+  uint64_t channel_mask;         // Measured channels (bit per channel)
+  float amplitude;               // Drive amplitude in DAC codes
+  uint32_t samples;              // ADC reads averaged per polarity
+  int64_t time;
+  float coupling[CROSSTALK_CHANNELS][CROSSTALK_CHANNELS]; // [driven][measured]
+};
+
+// Create an empty matrix (every entry NaN) for the channels in channel_mask
+struct crosstalk_matrix_t create_crosstalk_matrix(uint64_t channel_mask, float amplitude, uint32_t samples);
+
+// Add `reads` whole ADC_RD reads (four packed words each, default channel order) into a
+// board's eight per-channel sums
+void crosstalk_accumulate(int32_t sums[8], const uint32_t *words, size_t reads);
+
+// Fill the row of a driven channel from the per-channel sums at +amplitude and -amplitude
+void crosstalk_set_row(struct crosstalk_matrix_t *matrix, int driven,
+                       const int32_t pos_sums[CROSSTALK_CHANNELS], const int32_t neg_sums[CROSSTALK_CHANNELS]);
+
+// Coupling of `measured` relative to the driven channel's own response (NaN if unavailable)
+float crosstalk_relative(const struct crosstalk_matrix_t *matrix, int driven, int measured);
+
+// Write the matrix as CSV (measured channels only) or in the binary format.
+// Return 0 on success, -1 on error (the reason is printed).
+int crosstalk_save_csv(const struct crosstalk_matrix_t *matrix, const char *path);
+int crosstalk_save_bin(const struct crosstalk_matrix_t *matrix, const char *path);
+
+#endif // CROSSTALK_H
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "map_memory.h"
 
 //////////////////// DAC Control Definitions ////////////////////
@@ -34,6 +35,7 @@
 #define DAC_CMD_DAC_WR_CH 3
 #define DAC_CMD_GET_CAL   4
 #define DAC_CMD_ZERO      5
+#define DAC_CMD_LOOP      6
 #define DAC_CMD_CANCEL    7
 
 // DAC command bits
@@ -42,6 +44,16 @@
 #define DAC_CMD_CONT_BIT 27
 #define DAC_CMD_LDAC_BIT 26
 
+// Words in a DAC_WR command (command word plus 4 packed channel pairs)
+#define DAC_WR_WORDCOUNT 5
+
+// LOOP command fields: [25:16] block length in words, [15:0] passes (0 repeats until cancelled)
+#define DAC_LOOP_LEN_LSB    16
+#define DAC_LOOP_LEN_MAX    0x3FF
+#define DAC_LOOP_PASSES_MAX 0xFFFF
+// Loop buffer depth (longest block, in words)
+#define DAC_LOOP_WORDCOUNT  256
+
 // DAC data codes
 #define DAC_DATA_CODE(word)       (((word) >> 28) & 0x0F) // Top 4 bits for debug code
 #define DAC_DBG_MISO_DATA         1
@@ -86,7 +98,20 @@ void dac_cmd_dac_wr(struct dac_ctrl_t *dac_ctrl, uint8_t board, int16_t ch_vals[
 void dac_cmd_dac_wr_ch(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t ch, int16_t ch_val, bool verbose);
 void dac_cmd_set_cal(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t channel, int16_t offset, bool verbose);
 void dac_cmd_get_cal(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t channel, bool verbose);
+// SET_CAL/GET_CAL for every channel in channel_mask, sent as one burst
+void dac_cmd_set_cal_batch(struct dac_ctrl_t *dac_ctrl, uint8_t board, const int16_t cal[8], uint8_t channel_mask, bool verbose);
+void dac_cmd_get_cal_batch(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t channel_mask, bool verbose);
 void dac_cmd_zero(struct dac_ctrl_t *dac_ctrl, uint8_t board, bool verbose);
 void dac_cmd_cancel(struct dac_ctrl_t *dac_ctrl, uint8_t board, bool verbose);
 
+// Command stream functions (precomputed sequences, pushed in bulk)
+// Encode a NO_OP/DAC_WR command word (value must be a 25-bit delay or trigger count)
+uint32_t dac_encode_cmd(uint8_t cmd, bool trig, bool cont, bool ldac, uint32_t value);
+// Encode a full DAC_WR command (command word plus packed channel values)
+void dac_encode_dac_wr(uint32_t words[DAC_WR_WORDCOUNT], const int16_t ch_vals[8], bool trig, bool cont, bool ldac, uint32_t value);
+// Encode a LOOP command word (block_words must be 1 to DAC_LOOP_WORDCOUNT)
+uint32_t dac_encode_loop(uint32_t block_words, uint32_t passes);
+// Push encoded command words into a board's command FIFO (whole commands only)
+void dac_write_cmd_words(struct dac_ctrl_t *dac_ctrl, uint8_t board, const uint32_t *words, size_t count);
+
 #endif // DAC_CTRL_H
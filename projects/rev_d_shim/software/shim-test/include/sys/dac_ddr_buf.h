@@ -0,0 +1,73 @@
+#ifndef DAC_DDR_BUF_H
+#define DAC_DDR_BUF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sys_sts.h"
+
+//////////////////// DAC DDR Buffer Definitions ////////////////////
+// Optional design path (dac_cmd_ddr_buffer in block_design.tcl): each DAC command FIFO
+// is refilled by an axi_ddr_fifo_reader core from a circular buffer in DDR, so a whole
+// waveform can be uploaded once and played without the host streaming it.
+// Reader register block for each board
+#define DAC_DDR_READER(board)  (0x80002000 + (board) * 0x10000)
+#define DAC_DDR_READER_WORDCOUNT 7
+
+// 32-bit offsets within a reader's registers
+#define DAC_DDR_CTRL_OFFSET      (uint32_t) 0 // [0] enable, [1] clear (only while stopped)
+#define DAC_DDR_BASE_OFFSET      (uint32_t) 1 // Buffer base address (64-byte aligned)
+#define DAC_DDR_SIZE_OFFSET      (uint32_t) 2 // Buffer size in bytes (multiple of 64)
+#define DAC_DDR_WR_PTR_OFFSET    (uint32_t) 3 // Byte offset just past the last valid word
+#define DAC_DDR_RD_PTR_OFFSET    (uint32_t) 4 // Byte offset of the next word to read
+#define DAC_DDR_STATUS_OFFSET    (uint32_t) 5 // Status bits below
+#define DAC_DDR_WORDS_FED_OFFSET (uint32_t) 6 // Words fed to the FIFO since the last clear
+
+#define DAC_DDR_CTRL_ENABLE      (uint32_t) (1 << 0)
+#define DAC_DDR_CTRL_CLEAR       (uint32_t) (1 << 1)
+#define DAC_DDR_STS_ENABLED(sts)  ((sts) & 0x1)        // Reader enabled
+#define DAC_DDR_STS_BUSY(sts)     (((sts) >> 1) & 0x1) // Burst in flight
+#define DAC_DDR_STS_RD_ERROR(sts) (((sts) >> 2) & 0x1) // DDR read returned an error
+#define DAC_DDR_STS_EMPTY(sts)    (((sts) >> 3) & 0x1) // Read pointer caught up with the write pointer
+
+// DMA buffer shared by all boards (u-dma-buf device in the device tree), split evenly between them
+#define DAC_DDR_BUF_NAME       "shim_dac_ddr_buf"
+#define DAC_DDR_BUF_SIM_BYTES  (size_t)(128 << 20) // Simulated buffer size, matching the device tree
+#define DAC_DDR_BUF_ALIGN      64                  // Reader base/size granularity in bytes
+// An early end is placed at least this many words past the read pointer, well clear of any burst in flight
+#define DAC_DDR_END_MARGIN_WORDS 256
+
+//////////////////////////////////////////////////////////////////
+
+// DAC DDR buffer structure
+struct dac_ddr_buf_t {
+  volatile uint32_t *reader[8]; // Reader registers for each board
+  volatile uint32_t *mem;       // DMA buffer (NULL until the first upload maps it)
+  uint32_t phys_addr;           // DMA buffer physical address
+  size_t size_bytes;            // DMA buffer size
+  bool present;                 // Readers are in the bitstream
+};
+
+// Create DAC DDR buffer structure (presence is read from the design options status word)
+struct dac_ddr_buf_t create_dac_ddr_buf(struct sys_sts_t *sys_sts, bool verbose);
+
+// Upload a command stream to a board's slice of the buffer and arm its reader (must be stopped).
+// The words are played once; the reader is left disabled until dac_ddr_buf_start.
+int dac_ddr_buf_upload(struct dac_ddr_buf_t *ddr_buf, uint8_t board, const uint32_t *words, size_t count, bool verbose);
+// Most command words one board's slice can hold (0 if the buffer can't be mapped)
+size_t dac_ddr_buf_max_words(struct dac_ddr_buf_t *ddr_buf, bool verbose);
+// Enable a board's reader
+int dac_ddr_buf_start(struct dac_ddr_buf_t *ddr_buf, uint8_t board, bool verbose);
+// End a board's playback early at the first whole command (outside any loop block) far enough
+// past the read pointer: that command's cont bit is cleared in DDR and the write pointer moved
+// just past it, so the core idles cleanly once the words already queued have played.
+// Returns 1 if playback is too close to its end to cut short.
+int dac_ddr_buf_end_early(struct dac_ddr_buf_t *ddr_buf, uint8_t board, bool verbose);
+// Disable a board's reader and wait for its burst in flight to finish
+int dac_ddr_buf_stop(struct dac_ddr_buf_t *ddr_buf, uint8_t board, bool verbose);
+// Read a board's reader status word
+uint32_t dac_ddr_buf_status(struct dac_ddr_buf_t *ddr_buf, uint8_t board);
+// Print a board's reader registers
+void print_dac_ddr_buf_status(struct dac_ddr_buf_t *ddr_buf, uint8_t board);
+
+#endif // DAC_DDR_BUF_H
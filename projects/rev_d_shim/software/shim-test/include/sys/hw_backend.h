@@ -0,0 +1,60 @@
+#ifndef HW_BACKEND_H
+#define HW_BACKEND_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "map_memory.h"
+#include "hw_trace.h"
+
+//////////////////// Hardware Backend ////////////////////
+// Every register and FIFO access in the sys modules goes through hw_read32/hw_write32.
+// With no backend installed these are plain volatile accesses to the mapped registers.
+// An installed backend (e.g. the simulator in hw_sim.h) receives the physical address instead.
+// Accesses are also recorded by the flight recorder in hw_trace.h while it is enabled.
+typedef struct {
+  const char *name;                                      // Backend name for status output
+  uint32_t (*read32)(uint32_t phys_addr);                // Read a register or pop a FIFO word
+  void (*write32)(uint32_t phys_addr, uint32_t value);   // Write a register or push a FIFO word
+} hw_backend_ops_t;
+
+// Installed backend (NULL for direct memory-mapped access)
+extern const hw_backend_ops_t *g_hw_backend;
+
+// Install a backend (NULL restores direct access). Must be called before any hardware is mapped.
+void hw_backend_install(const hw_backend_ops_t *ops);
+
+// Name of the active backend
+const char *hw_backend_name(void);
+
+// Longest burst hw_write_burst32 emits as a single multi-word store
+#define HW_BURST_MAX_WORDS 6
+
+// Push count words into a FIFO with multi-word stores, so each group of up to HW_BURST_MAX_WORDS
+// becomes one AXI burst through the FIFO bridge. reg must be the start of a FIFO bridge window.
+void hw_write_burst32(volatile uint32_t *reg, const uint32_t *words, size_t count);
+
+//////////////////////////////////////////////////////////////////
+
+// Read a 32-bit register
+static inline uint32_t hw_read32(volatile uint32_t *reg) {
+  uint32_t value;
+  if (__builtin_expect(g_hw_backend != NULL, 0)) {
+    value = g_hw_backend->read32(map_memory_phys_addr(reg));
+  } else {
+    value = *reg;
+  }
+  hw_trace_record(HW_TRACE_READ, reg, value);
+  return value;
+}
+
+// Write a 32-bit register
+static inline void hw_write32(volatile uint32_t *reg, uint32_t value) {
+  hw_trace_record(HW_TRACE_WRITE, reg, value);
+  if (__builtin_expect(g_hw_backend != NULL, 0)) {
+    g_hw_backend->write32(map_memory_phys_addr(reg), value);
+    return;
+  }
+  *reg = value;
+}
+
+#endif // HW_BACKEND_H
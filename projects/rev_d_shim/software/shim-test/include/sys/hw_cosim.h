@@ -0,0 +1,55 @@
+#ifndef HW_COSIM_H
+#define HW_COSIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////// Co-simulation Bridge Definitions ////////////////////
+// Backend that sends every register and FIFO access to the Verilator model of the
+// programmable logic (projects/rev_d_shim/cosim) through a shared memory mailbox.
+// The harness creates the mailbox and runs the RTL. For each access the client fills in
+// op/addr/data and bumps req_seq; the harness runs the AXI transaction on the model,
+// fills in data/resp and the model time, then sets ack_seq to match.
+// This header is also compiled into the harness, so it must stay plain C.
+#define HW_COSIM_MAGIC          (uint32_t) 0x53484353 // "SHCS"
+#define HW_COSIM_VERSION        (uint32_t) 1
+#define HW_COSIM_DEFAULT_NAME   "/shim_cosim"
+#define HW_COSIM_SPIN_POLLS     (uint32_t) 2000       // Polls before yielding the CPU while waiting on the harness
+
+// Request operations
+#define HW_COSIM_OP_READ        (uint32_t) 1
+#define HW_COSIM_OP_WRITE       (uint32_t) 2
+
+// Response codes (AXI BRESP/RRESP, plus one for addresses the model doesn't decode)
+#define HW_COSIM_RESP_OKAY      (uint32_t) 0
+#define HW_COSIM_RESP_SLVERR    (uint32_t) 2
+#define HW_COSIM_RESP_DECERR    (uint32_t) 3
+
+//////////////////////////////////////////////////////////////////
+
+// Mailbox at the start of the shared memory object
+typedef struct {
+  uint32_t magic;                  // HW_COSIM_MAGIC once the harness is ready
+  uint32_t version;                // HW_COSIM_VERSION
+  volatile uint32_t harness_pid;   // Harness process (the client gives up if it exits)
+  volatile uint32_t client_pid;    // Attached client (0 if none; one at a time)
+  volatile uint32_t req_seq;       // Bumped by the client once a request is filled in
+  volatile uint32_t ack_seq;       // Set to req_seq by the harness once it is done
+  uint32_t op;                     // HW_COSIM_OP_*
+  uint32_t addr;                   // Physical address
+  uint32_t data;                   // Write value, or read result
+  uint32_t resp;                   // HW_COSIM_RESP_* of the last request
+  uint64_t aclk_cycles;            // Model time when the last request completed
+  uint64_t spi_clk_cycles;
+  uint32_t spi_clk_freq_hz;        // SPI clock the model runs at
+  uint32_t board_count;            // Boards in the model
+} hw_cosim_mailbox_t;
+
+// Attach to a running harness and install the co-simulation backend
+// (must be called before any hardware is mapped). Returns -1 if there is no harness.
+int hw_cosim_install(const char *shm_name, bool verbose);
+
+// Model time of the last completed access in SPI clock cycles
+uint64_t hw_cosim_now_cycles(void);
+
+#endif // HW_COSIM_H
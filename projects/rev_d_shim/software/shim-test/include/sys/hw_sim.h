@@ -0,0 +1,43 @@
+#ifndef HW_SIM_H
+#define HW_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////// Hardware Simulator Definitions ////////////////////
+// Cycle-approximate model of the programmable logic behind the AXI windows:
+// FIFO depths and status words, the DAC/ADC/trigger command cores running at
+// the SPI clock, and the hardware manager's state and fault codes.
+// Simulated time follows the wall clock (scaled by time_scale) and is advanced
+// lazily on every register access.
+#define HW_SIM_DEFAULT_SPI_CLK_HZ  (uint32_t) 20000000 // 20 MHz SPI clock
+#define HW_SIM_DEFAULT_BOARD_MASK  (uint8_t) 0xFF      // All 8 boards present
+#define HW_SIM_STARTUP_US          (uint32_t) 1000     // Enable to S_RUNNING
+// The remaining words of a multi-word command (DAC_WR data, ADC repeat count)
+// must arrive within this time of the last FIFO write, or the core underflows
+#define HW_SIM_BURST_GRACE_US      (uint32_t) 10
+
+//////////////////////////////////////////////////////////////////
+
+// Simulator configuration
+typedef struct {
+  uint32_t spi_clk_freq_hz;  // SPI clock the DAC, ADC and trigger cores run at
+  uint8_t board_mask;        // Boards whose FIFOs are present
+  double time_scale;         // Simulated seconds per wall-clock second
+  uint32_t ext_trig_period;  // External trigger period in SPI cycles (0 for none)
+  double loopback_gain;      // ADC reading per DAC LSB on the same board and channel
+  int16_t loopback_offset;   // ADC reading offset in LSBs
+  uint16_t noise_lsb;        // Peak uniform noise added to each ADC sample
+  bool dac_ddr_buffer;       // DAC command FIFOs have DDR readers (dac_cmd_ddr_buffer design option)
+} hw_sim_config_t;
+
+// Default simulator configuration
+hw_sim_config_t hw_sim_default_config(void);
+
+// Install the simulator as the hardware backend (must be called before any hardware is mapped)
+void hw_sim_install(const hw_sim_config_t *config);
+
+// Current simulated time in SPI clock cycles
+uint64_t hw_sim_now_cycles(void);
+
+#endif // HW_SIM_H
@@ -0,0 +1,67 @@
+#ifndef HW_TRACE_H
+#define HW_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+//////////////////// Hardware Trace Definitions ////////////////////
+// Flight recorder for register and FIFO accesses. When enabled, every hw_read32/hw_write32
+// (and each word of hw_write_burst32) is appended to a ring owned by the calling thread,
+// so recording takes no locks. The rings keep the most recent accesses and are merged
+// by timestamp when dumped (on demand, or automatically when the hardware leaves S_RUNNING).
+// On hardware the timestamps are raw Cortex-A9 global timer ticks (clock_gettime is a syscall on
+// the Zynq, ~1 us per access), converted to time at dump; the simulator uses CLOCK_MONOTONIC.
+#define HW_TRACE_DEFAULT_ENTRIES (uint32_t) 4096 // Entries per thread ring (rounded up to a power of two)
+#define HW_TRACE_MAX_THREADS     (uint32_t) 32   // Rings that can be registered (later threads are not traced)
+#define HW_TRACE_DUMP_PATH       "/tmp/shim-hw-trace.txt" // Automatic dump destination
+
+// Cortex-A9 global timer (shared by both cores, so ticks order accesses across threads)
+#define HW_TRACE_GTIMER_PAGE     (uint32_t) 0xF8F00000 // Private peripheral page holding the timer
+#define HW_TRACE_GTIMER_OFFSET   (uint32_t) 0x200      // Timer registers within the page
+#define HW_TRACE_GTIMER_LO       0 // Counter bits [31:0] (word index from the timer registers)
+#define HW_TRACE_GTIMER_HI       1 // Counter bits [63:32]
+#define HW_TRACE_GTIMER_CTRL     2 // Control (bit 0 set while the timer counts)
+#define HW_TRACE_CALIBRATE_NS    (uint64_t) 10000000 // Minimum span to measure the tick rate over at dump
+
+// Access types
+#define HW_TRACE_READ  (uint8_t) 0
+#define HW_TRACE_WRITE (uint8_t) 1
+
+//////////////////////////////////////////////////////////////////
+
+// Nonzero while recording (checked inline on every register access)
+extern volatile int g_hw_trace_enabled;
+
+// Start recording with ring_entries per thread (0 for the default). Existing rings keep their size.
+// The first call picks the timestamp source (mapping the global timer on hardware).
+void hw_trace_enable(uint32_t ring_entries);
+
+// Stop recording (the rings are kept for dumping)
+void hw_trace_disable(void);
+
+// Discard all recorded entries
+void hw_trace_clear(void);
+
+// Record one access (called through hw_trace_record when enabled)
+void hw_trace_record_slow(uint8_t op, const volatile uint32_t *reg, uint32_t value);
+
+// Write all recorded entries, oldest first, with their decoded register names.
+// Returns the number of entries written.
+size_t hw_trace_dump(FILE *out);
+
+// Dump to a file path (returns the number of entries written, or -1 if the file can't be opened)
+long hw_trace_dump_to_file(const char *path);
+
+// Print ring usage (timestamp source, threads, entries, overwritten entries)
+void hw_trace_print_status(void);
+
+// Record an access if tracing is enabled
+static inline void hw_trace_record(uint8_t op, const volatile uint32_t *reg, uint32_t value) {
+  if (__builtin_expect(g_hw_trace_enabled, 0)) {
+    hw_trace_record_slow(op, reg, value);
+  }
+}
+
+#endif // HW_TRACE_H
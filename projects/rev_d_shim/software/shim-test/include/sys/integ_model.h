@@ -0,0 +1,90 @@
+#ifndef INTEG_MODEL_H
+#define INTEG_MODEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+//////////////////// Threshold Integrator Model ////////////////////
+// Bit-accurate host copy of shim_threshold_integrator, for checking a waveform against the
+// integ_window / integ_average settings before running it. Every 16th SPI clock the core adds
+// each channel's |calibrated DAC value| to a running sum and takes off the sample leaving the
+// window. Samples leave in chunks of 2^chunk_width (chunk_width = MSB of the window - 10): each
+// chunk's sum goes through a FIFO and is spread back out over the steps of a later chunk period
+// (the sum >> chunk_width each step, plus one on the last remainder - 1 steps). The system halts
+// with STS_OVER_THRESH once a sum exceeds threshold_average * (window >> 4).
+//
+// The model follows the core's timers exactly, including where the approximation differs from a
+// true rolling sum: a chunk period is 16 * (2^chunk_width - 1) + 1 cycles, and the outflow step at
+// the end of each period is overwritten before it is added. Since the DAC output only changes at
+// LDAC, the input is a series of holds, and a hold covering many sample steps costs the same as
+// a short one: the steps are added in closed form, 8 channels at a time, since a run of steps
+// with one input and one outflow chunk only ever moves the sum in one direction.
+#define INTEG_WINDOW_MIN          2048 // Smaller windows trip as soon as the integrator is enabled
+#define INTEG_THRESHOLD_MASK      0x7FFF // threshold_average is a 15-bit port
+#define INTEG_SAMPLE_CYCLES       16   // Cycles per sample step
+#define INTEG_FIFO_ENTRIES        1024 // rolling_sum_mem depth (8 entries, one per channel, per chunk)
+#define INTEG_MODEL_MAX_RUNS      1024 // Runs of identical chunks in flight (at most ~250 chunks are)
+
+//////////////////////////////////////////////////////////////////
+
+// Consecutive chunks with the same sums
+struct integ_chunk_run_t {
+  uint64_t sum[8];
+  uint64_t count;
+};
+
+// Integrator state for one board's 8 channels, from the cycle the core starts RUNNING
+struct integ_model_t {
+  // Settings, derived as the core does in IDLE/SETUP
+  uint32_t window;
+  uint32_t threshold_average;
+  uint32_t chunk_width;
+  uint32_t period_steps;         // Outflow steps added per chunk period (2^chunk_width - 1)
+  uint64_t period_cycles;        // Chunk period (16 * period_steps + 1)
+  uint64_t max_value;            // Sum limit (threshold_average * (window >> 4))
+  uint64_t cycle;                // Cycles of input given so far
+
+  // Inflow: the chunk being summed
+  uint64_t sample_cycle;         // Cycle of its next sample
+  uint32_t sample_index;         // Samples in it so far
+  uint64_t chunk_sum[8];
+
+  // Chunk sums waiting in the FIFO, run-length coded
+  struct integ_chunk_run_t runs[INTEG_MODEL_MAX_RUNS];
+  uint32_t run_head;             // Ring index of the oldest run
+  uint32_t run_count;
+  uint64_t run_head_period;      // Outflow period of the oldest run's first chunk
+
+  // Running sums
+  uint64_t first_steps;          // Steps before the first chunk leaves (outflow value 0)
+  uint64_t first_done;
+  uint64_t period_step;          // Steps added since the first chunk period began
+  int64_t total_sum[8];
+
+  // Results
+  int64_t peak_sum[8];
+  uint64_t peak_cycle[8];        // Cycle each peak was first reached
+  bool tripped;
+  uint64_t trip_cycle;           // First cycle a sum was over the limit
+  uint8_t trip_channels;         // Channels over the limit on that cycle (bit per channel)
+  bool fifo_overflow;            // This window overflows the core's FIFO (STS_THRESH_OVERFLOW)
+  uint64_t fifo_overflow_cycle;
+  uint32_t fifo_peak_entries;
+};
+
+// Start the model as the core enters RUNNING with all inputs zero.
+// Returns -1 if the window is under INTEG_WINDOW_MIN (the core trips straight away).
+int integ_model_init(struct integ_model_t *model, uint32_t window, uint32_t threshold_average);
+
+// Hold the 8 inputs (|calibrated DAC value| per channel) for a number of cycles
+void integ_model_hold(struct integ_model_t *model, const uint16_t input[8], uint64_t cycles);
+
+// Cycles after which a held input has fully replaced the window's contents
+uint64_t integ_model_settle_cycles(const struct integ_model_t *model);
+
+// Print the per-channel peaks and margins, the first trip, and any FIFO overflow
+// (channels numbered from board * 8, times from the SPI clock if it is nonzero)
+void integ_model_print_report(const struct integ_model_t *model, uint8_t board, uint32_t spi_clk_freq_hz, FILE *out);
+
+#endif // INTEG_MODEL_H
@@ -2,9 +2,62 @@
 #define MAP_MEMORY_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 
-// Function declaration for mapping 32-bit memory regions
-uint32_t *map_32bit_memory(uint32_t base_addr, uint32_t size, char *name, int verbose);
+// Lock file held by the process that owns the hardware mappings (taken by the first real
+// hardware mapping if not claimed before; spi-clk-test takes the same file)
+#define HW_OWNER_LOCK_PATH "/tmp/shim-test.lock"
+
+//////////////////// Memory Map Registry ////////////////////
+// Contiguous AXI windows, each mapped once and shared by every module that lives in it.
+// Names match the device tree nodes that export them as UIO regions.
+#define AXI_CTRL_WINDOW_NAME  "shim_axi_ctrl"
+#define AXI_CTRL_WINDOW_BASE  (uint32_t) 0x40000000 // M_AXI_GP0: sys ctrl, status, SPI clock
+#define AXI_CTRL_WINDOW_SIZE  (uint32_t) 0x00208000 // Through the end of the SPI clock interface
+#define AXI_FIFO_WINDOW_NAME  "shim_axi_fifo"
+#define AXI_FIFO_WINDOW_BASE  (uint32_t) 0x80000000 // M_AXI_GP1: DAC/ADC FIFOs (8 boards) and trigger FIFO
+#define AXI_FIFO_WINDOW_SIZE  (uint32_t) 0x00110000 // 0x80000000 - 0x8010FFFF
+#define AXI_FIFO_BRIDGE_RANGE (uint32_t) 128        // Bytes per FIFO bridge; every address in it reaches the FIFO
+
+// DMA buffers in DDR shared with the programmable logic (u-dma-buf devices named in the device tree).
+// The simulator stands them in with plain memory at a made-up DDR address.
+#define MAP_DMA_BUF_MAX       4
+#define MAP_SIM_DMA_BASE      (uint32_t) 0x10000000
+
+// How mapped regions are obtained
+typedef enum {
+  MAP_BACKEND_AUTO,   // UIO region if the device tree exports one, otherwise /dev/mem
+  MAP_BACKEND_DEVMEM, // Always /dev/mem (requires root)
+  MAP_BACKEND_UIO,    // Only UIO regions (fails if a window isn't exported)
+  MAP_BACKEND_SIM     // Plain memory stand-ins; register accesses go to the simulator (see hw_sim.h)
+} map_backend_t;
+
+// Select the mapping backend (must be called before any region is mapped)
+void map_memory_set_backend(map_backend_t backend);
+
+// Map a 32-bit memory region. Regions inside a registry window share that window's mapping.
+uint32_t *map_32bit_memory(uint32_t base_addr, size_t wordcount, char *name, bool verbose);
+
+// Physical address of a pointer returned by map_32bit_memory (0 if it isn't in a registry window)
+uint32_t map_memory_phys_addr(const volatile uint32_t *ptr);
+
+// Map a u-dma-buf DMA buffer (/dev/<name>, uncached). Sets its physical address and size.
+// Under MAP_BACKEND_SIM an anonymous buffer of sim_size bytes stands in.
+volatile uint32_t *map_dma_buffer(const char *name, size_t sim_size, uint32_t *phys_addr, size_t *size_bytes, bool verbose);
+
+// Host pointer to size_bytes at a physical address inside a mapped DMA buffer (NULL if none holds it)
+volatile uint32_t *map_memory_dma_ptr(uint32_t phys_addr, size_t size_bytes);
+
+// Print the registry windows and how each one was mapped
+void map_memory_print_registry(void);
+
+// Find the /dev/uioN device whose name matches uio_name. Returns the UIO index, or -1 if not found.
+int find_uio_device(const char *uio_name, char *dev_path, size_t dev_path_size);
+
+// Take exclusive ownership of the hardware mappings (returns the lock fd, or -1 if another process
+// owns them; claiming again from the owning process returns the same fd)
+int claim_hw_ownership(const char *lock_path, bool verbose);
 
 // Function declarations for signed/offset conversion
 int16_t offset_to_signed(uint16_t val);
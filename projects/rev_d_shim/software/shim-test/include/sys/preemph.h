@@ -0,0 +1,80 @@
+#ifndef PREEMPH_H
+#define PREEMPH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+//////////////////// Pre-emphasis Definitions ////////////////////
+// Multi-exponential eddy-current compensation applied to DAC waveforms. Each channel has up
+// to PREEMPH_MAX_TERMS terms (amplitude a_k, time constant tau_k), and every write x becomes
+//   y = x + sum_k a_k * (x - l_k)
+// where l_k is x low-passed with tau_k (a step overshoots by sum a_k and relaxes back to x).
+// Between writes l_k decays towards the held value over the command's hold time, so the
+// filter follows the waveform's own (variable) timing. The state is Q8 DAC codes and the
+// amplitudes/decays Q15, so a step is a few integer multiply-adds per lane, done across the
+// 8 channels of a DAC_WR word group at once.
+#define PREEMPH_CHANNELS        64
+#define PREEMPH_MAX_TERMS       4
+#define PREEMPH_MAX_AMPLITUDE   4.0   // Largest accepted |a_k|
+#define PREEMPH_Q15_BITS        15    // Amplitudes and decays
+#define PREEMPH_STATE_BITS      8     // Fractional bits of the low-pass state
+#define PREEMPH_DAC_LIMIT       32767 // Outputs are clamped to +/- this
+#define PREEMPH_HOLD_SETTLED    UINT32_MAX // Hold long enough for every term to settle
+
+//////////////////////////////////////////////////////////////////
+
+// Coefficients for all channels (loaded from a coefficients file)
+struct preemph_t {
+  int term_count[PREEMPH_CHANNELS];
+  int32_t amplitude_q15[PREEMPH_CHANNELS][PREEMPH_MAX_TERMS];
+  double amplitude[PREEMPH_CHANNELS][PREEMPH_MAX_TERMS];
+  double tau_s[PREEMPH_CHANNELS][PREEMPH_MAX_TERMS];
+  double trigger_hold_s;         // Assumed time per trigger wait (0: trigger waits settle fully)
+  bool loaded;
+  uint32_t generation;           // Bumped on every load/clear (cached filtered waveforms check it)
+  char path[1024];
+};
+
+// Filter state and clipping report for one board's 8 channels
+struct preemph_state_t {
+  uint8_t board;
+  uint32_t spi_clk_freq_hz;
+  int16_t input[8];              // Last unfiltered value written
+  int32_t level[PREEMPH_MAX_TERMS][8]; // Low-passed input (Q8 codes)
+  int32_t decay[PREEMPH_MAX_TERMS][8]; // Q15 decay for decay_cycles
+  uint32_t decay_cycles;         // Hold the cached decays are for (PREEMPH_HOLD_SETTLED: none yet)
+  uint64_t writes;
+  uint64_t clipped[8];           // Writes clamped per channel
+  int32_t peak[8];               // Largest |unclamped output| per channel
+  int32_t residual;              // Largest |x - l_k| after the last hold (codes): nonzero means unsettled
+};
+
+// Create an empty set (no channel filtered)
+struct preemph_t create_preemph(void);
+
+// Load a coefficients file: lines of "<channel|*> <amplitude> <tau>" (tau with ns/us/ms/s,
+// '*' for every channel) and an optional "trigger_hold <time>"; '#' starts a comment.
+// Returns 0 on success, -1 on an error (printed; the set is left unchanged).
+int preemph_load(struct preemph_t *preemph, const char *path);
+
+// Whether any of a board's channels has a term
+bool preemph_board_active(const struct preemph_t *preemph, uint8_t board);
+
+// Start a board's filter at rest (all levels zero)
+struct preemph_state_t create_preemph_state(uint8_t board, uint32_t spi_clk_freq_hz);
+
+// Filter one DAC_WR word group in place (clamped to +/-PREEMPH_DAC_LIMIT), then advance the
+// state over hold_cycles (PREEMPH_HOLD_SETTLED for a full settle). ch_vals NULL only holds.
+void preemph_step(const struct preemph_t *preemph, struct preemph_state_t *state, int16_t ch_vals[8], uint32_t hold_cycles);
+
+// Hold cycles assumed for a wait on trigger_count triggers
+uint32_t preemph_trigger_hold_cycles(const struct preemph_t *preemph, uint32_t trigger_count, uint32_t spi_clk_freq_hz);
+
+// Print the coefficients of every filtered channel
+void preemph_print(const struct preemph_t *preemph, FILE *out);
+
+// Print a board's clipping report (writes, clipped writes and peak per channel)
+void preemph_print_report(const struct preemph_state_t *state, FILE *out);
+
+#endif // PREEMPH_H
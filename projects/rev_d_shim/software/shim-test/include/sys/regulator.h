@@ -0,0 +1,63 @@
+#ifndef REGULATOR_H
+#define REGULATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+//////////////////// Closed-Loop Regulator Definitions ////////////////////
+// Fixed-point PI controller working in DAC codes: the output is the target plus
+// kp*error + ki*sum(error), with gains in Q16 and the integrator held in Q16 so the
+// update is a handful of integer multiply-adds. The integrator stops growing while the
+// output is saturated (conditional integration anti-windup).
+#define PI_CTRL_FRAC_BITS       16
+#define PI_CTRL_MAX_GAIN        8.0   // Largest accepted kp/ki
+#define PI_CTRL_OUTPUT_LIMIT    32767 // Symmetric DAC code limit
+
+// Loop-time histogram buckets (upper edges in microseconds; the last bucket is open-ended)
+#define LOOP_HIST_BINS          12
+
+//////////////////////////////////////////////////////////////////
+
+struct pi_ctrl_t {
+  int32_t kp;                    // Q16
+  int32_t ki;                    // Q16
+  int64_t integral;              // Q16, in DAC codes
+  int32_t limit;                 // Output clamp (DAC codes)
+  bool saturated;                // Last output hit the clamp
+};
+
+// Timing statistics for one loop measurement (wake-up lateness, read-to-write latency...)
+struct loop_hist_t {
+  uint64_t count;
+  uint64_t sum_ns;
+  uint64_t min_ns;
+  uint64_t max_ns;
+  uint64_t bins[LOOP_HIST_BINS];
+};
+
+// Create a controller (gains are clamped to +/-PI_CTRL_MAX_GAIN)
+struct pi_ctrl_t create_pi_ctrl(double kp, double ki, int32_t limit);
+
+// One controller step: returns the new output for a measurement (both in DAC codes)
+int16_t pi_ctrl_update(struct pi_ctrl_t *pi, int16_t target, int32_t measured);
+
+// Clear the integrator
+void pi_ctrl_reset(struct pi_ctrl_t *pi);
+
+// Create an empty histogram
+struct loop_hist_t create_loop_hist(void);
+
+// Add one sample
+void loop_hist_add(struct loop_hist_t *hist, uint64_t ns);
+
+// Upper edge of a bucket in microseconds (0 for the open-ended last bucket)
+uint32_t loop_hist_edge_us(int bin);
+
+// Percentile estimate from the buckets (upper edge of the bucket holding it, or max_ns)
+uint64_t loop_hist_percentile_ns(const struct loop_hist_t *hist, double percentile);
+
+// Print min/mean/max, p99 and the non-empty buckets with a bar per bucket
+void loop_hist_print(const struct loop_hist_t *hist, const char *name, FILE *out);
+
+#endif // REGULATOR_H
@@ -0,0 +1,67 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//////////////////// Shared Memory Ring Definitions ////////////////////
+// Ring header magic ("SHRG")
+#define SHM_RING_MAGIC            (uint32_t) 0x53485247
+
+// Default ring size in 32-bit words (must be a power of two)
+#define SHM_RING_DEFAULT_WORDS    (uint32_t) 0x100000 // 4 MiB of data
+
+// Shared memory object name for each ADC data stream
+#define SHM_RING_ADC_NAME_FMT     "/shim_adc%d"
+
+//////////////////////////////////////////////////////////////////
+
+// Header at the start of every ring, followed by capacity_words data words.
+// There is a single writer (the daemon) and any number of readers. The counts are 32 bits so
+// they're read and written whole on the Zynq's 32-bit cores, and wrap (readers keep their own
+// position and only compare differences). The writer raises write_claim before overwriting any
+// slots and write_count once the words are in (release), so a reader loads write_count (acquire)
+// to see what's there and write_claim after copying to see whether it was lapped meanwhile.
+typedef struct {
+  uint32_t magic;              // SHM_RING_MAGIC once the ring is initialized
+  uint32_t capacity_words;     // Number of data words (power of two, at most 2^30)
+  uint32_t write_count;        // Total words ever written, mod 2^32
+  uint32_t write_claim;        // write_count plus the words being written
+  uint32_t active;             // Nonzero while the writer is streaming
+  uint32_t reserved;
+} shm_ring_header_t;
+
+// Shared memory ring handle
+struct shm_ring_t {
+  char name[64];               // POSIX shared memory object name
+  shm_ring_header_t *header;   // Mapped ring header
+  volatile uint32_t *data;     // Mapped ring data (capacity_words long)
+  size_t map_size;             // Total mapped size in bytes
+  bool owner;                  // True for the writer (unlinks on close)
+};
+
+// Create (or recreate) a ring as its writer. Returns 0 on success, -1 on error.
+int shm_ring_create(struct shm_ring_t *ring, const char *name, uint32_t capacity_words, bool verbose);
+
+// Attach to an existing ring as a reader. Returns 0 on success, -1 on error.
+int shm_ring_attach(struct shm_ring_t *ring, const char *name, bool verbose);
+
+// Append words to the ring (writer only, at most capacity_words at a time)
+void shm_ring_write(struct shm_ring_t *ring, const uint32_t *words, uint32_t count);
+
+// Position of the next word the writer will write, to start reading new data from
+uint32_t shm_ring_position(const struct shm_ring_t *ring);
+
+// Copy up to max_words words starting at *read_count into out (reader side).
+// Advances *read_count and returns the number of words copied, or -1 if the
+// reader was overrun (in which case *read_count is moved to the oldest valid word).
+int64_t shm_ring_read(const struct shm_ring_t *ring, uint32_t *read_count, uint32_t *out, uint32_t max_words);
+
+// Whether the writer is still streaming into the ring
+bool shm_ring_active(const struct shm_ring_t *ring);
+
+// Unmap the ring, unlinking it if this handle is the writer
+void shm_ring_close(struct shm_ring_t *ring);
+
+#endif // SHM_RING_H
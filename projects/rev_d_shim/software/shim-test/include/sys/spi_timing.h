@@ -0,0 +1,78 @@
+#ifndef SPI_TIMING_H
+#define SPI_TIMING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////// SPI Timing Definitions ////////////////////
+// Host-side copy of shim_ad5676_dac_timing_calc and shim_ads816x_adc_timing_calc.
+// Times are in "NiS" (2^30 NiS = 1 s, rounded up) so cycles = ceil(f_hz * T_NiS / 2^30),
+// exactly as the hardware computes them.
+#define SPI_TIMING_NIS_SHIFT            30
+
+// AD5676 DAC: 830 ns update, 30 ns minimum ~CS high time
+#define SPI_TIMING_DAC_T_UPDATE_NIS     (uint64_t) 892
+#define SPI_TIMING_DAC_T_MIN_N_CS_NIS   (uint64_t) 33
+#define SPI_TIMING_DAC_MIN_N_CS_CYCLES  (uint32_t) 4   // Needed for DAC value loading and calibration
+#define SPI_TIMING_DAC_MAX_N_CS_CYCLES  (uint32_t) 32
+#define SPI_TIMING_DAC_SPI_BITS         (uint32_t) 24
+
+// ADS8168 ADC: 660 ns conversion, 1000 ns cycle
+#define SPI_TIMING_ADC_T_CONV_NIS       (uint64_t) 709
+#define SPI_TIMING_ADC_T_CYCLE_NIS      (uint64_t) 1074
+#define SPI_TIMING_ADC_MIN_N_CS_CYCLES  (uint32_t) 3   // Needed for the ADC core to send data
+#define SPI_TIMING_ADC_MAX_N_CS_CYCLES  (uint32_t) 256
+#define SPI_TIMING_ADC_SPI_BITS         (uint32_t) 16
+
+// SPI words sent per command
+#define SPI_TIMING_DAC_WR_WORDS         (uint32_t) 8 // One per channel
+#define SPI_TIMING_DAC_WR_CH_WORDS      (uint32_t) 1
+#define SPI_TIMING_ADC_RD_WORDS         (uint32_t) 9 // Order setup plus 8 conversions
+#define SPI_TIMING_ADC_RD_CH_WORDS      (uint32_t) 2 // Channel select plus conversion
+
+// Cycles per SPI word beyond ~CS high time and data bits (~CS release),
+// and per command for fetching the command word and latching completion
+#define SPI_TIMING_WORD_OVERHEAD_CYCLES (uint32_t) 1
+#define SPI_TIMING_CMD_OVERHEAD_CYCLES  (uint32_t) 4
+
+// Largest delay a DAC/ADC command can hold (25-bit value field)
+#define SPI_TIMING_MAX_DELAY_CYCLES     (uint32_t) 0x1FFFFFF
+
+//////////////////////////////////////////////////////////////////
+
+// SPI timing derived from a measured SPI clock frequency
+struct spi_timing_t {
+  uint32_t spi_clk_freq_hz;     // SPI clock frequency the timing was computed for
+  uint32_t dac_n_cs_high_time;  // DAC ~CS high time register value (cycles minus 1)
+  uint32_t adc_n_cs_high_time;  // ADC ~CS high time register value (cycles minus 1)
+  uint32_t dac_word_cycles;     // Cycles per DAC SPI word
+  uint32_t adc_word_cycles;     // Cycles per ADC SPI word
+  uint32_t dac_wr_min_delay;    // Minimum delay for DAC_WR (all channels)
+  uint32_t dac_wr_ch_cycles;    // Duration of DAC_WR_CH
+  uint32_t adc_rd_min_delay;    // Minimum delay for ADC_RD (all channels)
+  uint32_t adc_rd_ch_cycles;    // Duration of ADC_RD_CH
+};
+
+// Compute the timing for an SPI clock frequency (0 Hz gives an all-zero timing, see spi_timing_valid)
+struct spi_timing_t create_spi_timing(uint32_t spi_clk_freq_hz);
+
+// Minimum delay for ADC_RD averaging 2^avg_log2 reads per channel (8 * 2^avg_log2 + 1 words)
+uint32_t spi_timing_adc_rd_avg_min_delay(const struct spi_timing_t *timing, uint32_t avg_log2);
+
+// Whether the timing came from a usable (nonzero) SPI clock frequency
+bool spi_timing_valid(const struct spi_timing_t *timing);
+
+// ~CS high time register values, bit-exact with the timing_calc cores
+uint32_t spi_timing_dac_n_cs_high_time(uint32_t spi_clk_freq_hz);
+uint32_t spi_timing_adc_n_cs_high_time(uint32_t spi_clk_freq_hz);
+
+// Physical time <-> SPI clock cycles (ns to cycles rounds up)
+uint64_t spi_timing_ns_to_cycles(const struct spi_timing_t *timing, double ns);
+double spi_timing_cycles_to_ns(const struct spi_timing_t *timing, uint64_t cycles);
+
+// Parse a delay: plain cycles, "min", or a time with a ns/us/ms/s suffix (e.g. "12.5us").
+// "min" resolves to min_cycles. Returns 0 on success, -1 if malformed, out of range, or a
+// time is given without a valid timing.
+int spi_timing_parse_delay(const struct spi_timing_t *timing, const char *str, uint32_t min_cycles, uint32_t *cycles);
+
+#endif // SPI_TIMING_H
@@ -63,6 +63,8 @@ void sys_ctrl_set_integ_window(struct sys_ctrl_t *sys_ctrl, uint32_t value, bool
 void sys_ctrl_set_integ_threshold_average(struct sys_ctrl_t *sys_ctrl, uint32_t value, bool verbose);
 // Set the integrator enable register to a 32-bit value
 void sys_ctrl_set_integ_enable(struct sys_ctrl_t *sys_ctrl, uint32_t value, bool verbose);
+// Read back the integrator window, threshold average and enable registers
+void sys_ctrl_get_integ_settings(struct sys_ctrl_t *sys_ctrl, uint32_t *window, uint32_t *threshold_average, uint32_t *enable);
 
 
 #endif // SYS_CTRL_H
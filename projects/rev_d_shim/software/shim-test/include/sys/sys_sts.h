@@ -31,6 +31,9 @@
 #define DEBUG_ADC_CS_HIGH_TIME(word) (((word) >> 7) & 0xFF) // ADC ~CS high time (8 bits)
 // Trigger counter offset
 #define TRIG_COUNTER_OFFSET         (uint32_t) 37 // Trigger counter offset
+// Design options (build-time features present in the bitstream)
+#define DESIGN_OPTS_OFFSET          (uint32_t) 38 // Design options offset
+#define DESIGN_OPT_DAC_DDR_BUF_BIT  0 // DAC command streams can be fed from DDR
 
 // Macro for extracting the 4-bit state
 #define HW_STS_STATE(hw_status) ((hw_status) & 0xF)
@@ -127,6 +130,7 @@ struct sys_sts_t {
   volatile uint32_t *spi_clk_freq_hz;        // SPI clock frequency in Hz
   volatile uint32_t *debug;                  // Debug register
   volatile uint32_t *trig_counter;           // Trigger counter
+  volatile uint32_t *design_opts;            // Design options
 };
 
 // Structure initialization function
@@ -154,6 +158,8 @@ uint32_t sys_sts_get_trig_data_fifo_status(struct sys_sts_t *sys_sts, bool verbo
 uint32_t sys_sts_get_debug(struct sys_sts_t *sys_sts, bool verbose);
 // Get trigger counter value
 uint32_t sys_sts_get_trig_counter(struct sys_sts_t *sys_sts, bool verbose);
+// Get design options word
+uint32_t sys_sts_get_design_opts(struct sys_sts_t *sys_sts, bool verbose);
 
 // Interpret and print hardware status
 void print_hw_status(uint32_t hw_status, bool verbose);
@@ -164,7 +170,10 @@ void print_debug_register(struct sys_sts_t *sys_sts);
 // Print FIFO status details
 void print_fifo_status(uint32_t fifo_status, const char *fifo_name);
 
-// Hardware manager interrupt monitoring
+// Hardware manager interrupt monitoring (UIO device named after its device tree node).
+// Starting it while a monitor is already running does nothing. When the hardware leaves
+// S_RUNNING the monitor exits, dumping the hw_trace flight recorder if it is enabled.
+#define HW_MANAGER_IRQ_UIO_NAME "hw_manager_irq"
 int sys_sts_start_hw_manager_irq_monitor(struct sys_sts_t *sys_sts, bool verbose);
 
 #endif // SYS_STS_H
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 //////////////////// Trigger Control Definitions ////////////////////
 // Trigger FIFO address
@@ -26,18 +27,37 @@
 #define TRIG_CMD_LOG_BIT      28   // Trigger logging enable bit
 #define TRIG_CMD_VALUE_MASK   0x0FFFFFFF // Command value mask (lower 28 bits)
 
+// Trigger data format
+// Full format: two words per trigger, timer[31:0] then timer[63:32]
+// Delta format (RESET_COUNT value bit 0 set): {0, delta[30:0]} from the previous logged trigger,
+//   or a full timestamp {1, timer[62:32]} then timer[31:0] after a count reset, on large gaps,
+//   and periodically to resynchronize
+#define TRIG_RESET_COUNT_DELTA 0x1        // RESET_COUNT value bit selecting the delta format
+#define TRIG_DATA_RESYNC_FLAG  0x80000000 // Marks the first word of a full timestamp in the delta format
+#define TRIG_DELTA_MAX         0x7FFFFFFF // Largest delta word (and timestamp upper word) in the delta format
+
 //////////////////////////////////////////////////////////////////
 
 // Trigger control structure
 struct trigger_ctrl_t {
   volatile uint32_t *buffer; // Trigger FIFO (command and data)
+  bool delta_log;            // Data is in the delta format (sent with each RESET_COUNT)
+  // Data decoder state
+  bool have_first_word;      // First word of a two-word entry read, waiting for the second
+  uint32_t first_word;
+  uint64_t last_timestamp;   // Last decoded timestamp (base for delta words)
 };
 
 // Create trigger control structure
 struct trigger_ctrl_t create_trigger_ctrl(bool verbose);
 
-// Read 64-bit trigger data from FIFO as a pair of 32-bit words
+// Reset the data decoder for the given format (after a format change or a core reset)
+void trigger_reset_decoder(struct trigger_ctrl_t *trigger_ctrl, bool delta_log);
+// Read the next 64-bit trigger timestamp from the FIFO (one or two words, depending on the format)
 uint64_t trigger_read(struct trigger_ctrl_t *trigger_ctrl);
+// Read and decode up to words_available words from the FIFO, storing at most max_count timestamps.
+// A trailing half entry is kept and completed by the next call. Returns the number of timestamps stored.
+size_t trigger_read_timestamps(struct trigger_ctrl_t *trigger_ctrl, uint64_t *timestamps, size_t max_count, uint32_t words_available);
 
 // Trigger command functions
 void trigger_cmd_sync_ch(struct trigger_ctrl_t *trigger_ctrl, bool log, bool verbose);
@@ -47,5 +67,15 @@ void trigger_cmd_delay(struct trigger_ctrl_t *trigger_ctrl, uint32_t cycles, boo
 void trigger_cmd_force_trig(struct trigger_ctrl_t *trigger_ctrl, bool log, bool verbose);
 void trigger_cmd_reset_count(struct trigger_ctrl_t *trigger_ctrl, bool verbose);
 void trigger_cmd_cancel(struct trigger_ctrl_t *trigger_ctrl, bool verbose);
+// Switch the data format (sends RESET_COUNT). The data FIFO should be empty first.
+void trigger_cmd_set_log_format(struct trigger_ctrl_t *trigger_ctrl, bool delta_log, bool verbose);
+
+// Command stream functions (precomputed sequences, pushed in bulk)
+// Encode a trigger command word (value must fit TRIG_CMD_VALUE_MASK)
+uint32_t trigger_encode_cmd(uint8_t cmd, bool log, uint32_t value);
+// Encode a RESET_COUNT command word keeping the given data format
+uint32_t trigger_encode_reset_count(bool delta_log);
+// Push encoded command words into the trigger command FIFO
+void trigger_write_cmd_words(struct trigger_ctrl_t *trigger_ctrl, const uint32_t *words, size_t count);
 
 #endif // TRIGGER_CTRL_H
@@ -16,15 +16,96 @@
 #include "spi_clk_ctrl.h"
 #include "sys_sts.h"
 #include "trigger_ctrl.h"
+#include "dac_ddr_buf.h"
 #include "command_handler.h"
+#include "experiment_commands.h"
+#include "daemon_server.h"
+#include "map_memory.h"
+#include "hw_sim.h"
+#include "hw_cosim.h"
+#include "hw_trace.h"
 
 //////////////////// Main ////////////////////
 int main(int argc, char *argv[])
 {
   //////////////////// 1. Setup ////////////////////
+  // Parse optional arguments
+  //   --verbose          : verbose output
+  //   --uio | --devmem   : map AXI windows only from UIO regions / only from /dev/mem (default: UIO if exported)
+  //   --sim [spi_clk_hz] : run against the cycle-approximate hardware simulator instead of the hardware
+  //   --cosim [shm_name] : run against the Verilated RTL in a running shim-cosim harness (see projects/rev_d_shim/cosim)
+  //   --trace [entries]  : record every register access in per-thread rings (see the hw_trace command)
+  //   --daemon [socket]  : own the hardware and serve commands on a Unix socket
+  //   --connect [socket] : connect to a running daemon instead of mapping hardware
+  //   --cal-store <file> : calibration store to load at startup and update after each calibration
+  //                        (default: CAL_STORE_DEFAULT_FILE in $HOME; none in --sim or --cosim)
+  //   --no-cal-store     : don't load or save a calibration store
+  bool verbose = false;
+  bool daemon_mode = false;
+  bool connect_mode = false;
+  bool sim_mode = false;
+  const char* socket_path = DAEMON_DEFAULT_SOCKET_PATH;
+  const char* cal_store_arg = NULL;
+  bool no_cal_store = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--verbose") == 0) {
+      verbose = true;
+    } else if (strcmp(argv[i], "--uio") == 0) {
+      map_memory_set_backend(MAP_BACKEND_UIO);
+    } else if (strcmp(argv[i], "--devmem") == 0) {
+      map_memory_set_backend(MAP_BACKEND_DEVMEM);
+    } else if (strcmp(argv[i], "--sim") == 0) {
+      hw_sim_config_t sim_config = hw_sim_default_config();
+      if (i + 1 < argc && argv[i + 1][0] != '-') {
+        sim_config.spi_clk_freq_hz = (uint32_t)strtoul(argv[++i], NULL, 0);
+      }
+      hw_sim_install(&sim_config);
+      sim_mode = true;
+    } else if (strcmp(argv[i], "--cosim") == 0) {
+      const char *shm_name = HW_COSIM_DEFAULT_NAME;
+      if (i + 1 < argc && argv[i + 1][0] != '-') {
+        shm_name = argv[++i];
+      }
+      if (hw_cosim_install(shm_name, verbose) != 0) return EXIT_FAILURE;
+      sim_mode = true;
+    } else if (strcmp(argv[i], "--trace") == 0) {
+      uint32_t trace_entries = 0;
+      if (i + 1 < argc && argv[i + 1][0] != '-') {
+        trace_entries = (uint32_t)strtoul(argv[++i], NULL, 0);
+      }
+      hw_trace_enable(trace_entries);
+    } else if (strcmp(argv[i], "--daemon") == 0 || strcmp(argv[i], "--connect") == 0) {
+      daemon_mode = (strcmp(argv[i], "--daemon") == 0);
+      connect_mode = !daemon_mode;
+      if (i + 1 < argc && argv[i + 1][0] != '-') {
+        socket_path = argv[++i];
+      }
+    } else if (strcmp(argv[i], "--cal-store") == 0 && i + 1 < argc) {
+      cal_store_arg = argv[++i];
+    } else if (strcmp(argv[i], "--no-cal-store") == 0) {
+      no_cal_store = true;
+    } else {
+      fprintf(stderr, "Usage: %s [--verbose] [--uio | --devmem | --sim [spi_clk_hz] | --cosim [shm_name]] [--trace [entries]] [--daemon [socket] | --connect [socket]] [--cal-store <file> | --no-cal-store]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Clients never touch the hardware directly
+  if (connect_mode) {
+    return daemon_client_run(socket_path) == 0 ? 0 : EXIT_FAILURE;
+  }
+
   printf("Rev. C to D One-to-One Test Program\n");
   printf("Setup:\n");
 
+  // Only one process may own the hardware mappings at a time (each simulator is private, and
+  // a co-simulation harness takes one client at a time)
+  if (!sim_mode && claim_hw_ownership(HW_OWNER_LOCK_PATH, verbose) < 0) {
+    fprintf(stderr, "Hardware is already owned by another process (lock '%s').\n", HW_OWNER_LOCK_PATH);
+    fprintf(stderr, "If a shim-test daemon is running, connect to it with '%s --connect'.\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
   //// Hardware control structures
   struct sys_ctrl_t sys_ctrl;         // System control and configuration
   struct spi_clk_ctrl_t spi_clk_ctrl; // SPI clock control interface
@@ -32,12 +113,7 @@ int main(int argc, char *argv[])
   struct dac_ctrl_t dac_ctrl;         // DAC command FIFOs (all boards)
   struct adc_ctrl_t adc_ctrl;         // ADC command and data FIFOs (all boards)
   struct trigger_ctrl_t trigger_ctrl; // Trigger command and data FIFOs
-
-  // Parse optional verbose argument
-  bool verbose = false;
-  if (argc == 2 && strcmp(argv[1], "--verbose") == 0) {
-    verbose = true;
-  }
+  struct dac_ddr_buf_t dac_ddr_buf;   // DAC DDR buffer readers (if in the design)
 
   // Initialize hardware control structures
   printf("Initializing hardware control modules...\n");
@@ -62,14 +138,15 @@ int main(int argc, char *argv[])
   trigger_ctrl = create_trigger_ctrl(verbose);
   printf("Trigger control module initialized\n");
 
-  printf("Hardware initialization complete.\n");
+  dac_ddr_buf = create_dac_ddr_buf(&sys_sts, verbose);
+  printf("DAC DDR buffer module initialized (%s)\n", dac_ddr_buf.present ? "readers present" : "not in this design");
 
-  // Print help
-  print_help();
+  printf("Hardware initialization complete.\n");
+  if (verbose) {
+    map_memory_print_registry();
+  }
 
   //////////////////// 2. Command Loop ////////////////////
-  printf("Entering command loop. Type 'help' for available commands.\n");
-
   // Set up command context
   bool should_exit = false;
   command_context_t cmd_ctx = {
@@ -79,8 +156,12 @@ int main(int argc, char *argv[])
     .dac_ctrl = &dac_ctrl,
     .adc_ctrl = &adc_ctrl,
     .trigger_ctrl = &trigger_ctrl,
+    .dac_ddr_buf = &dac_ddr_buf,
     .verbose = &verbose,
     .should_exit = &should_exit,
+    .in = stdin,                        // Prompts read from the terminal
+    .console_out = stdout,
+    .console_err = stderr,
     .adc_data_stream_threads = {0},    // Initialize thread handles to 0
     .adc_data_stream_running = {false}, // Initialize all data streams as not running
     .adc_data_stream_stop = {false},    // Initialize all data stream stop flags as false
@@ -92,14 +173,60 @@ int main(int argc, char *argv[])
     .trig_data_stream_stop = false,     // Initialize trigger data stream stop flag as false
     .fieldmap_running = false,          // Initialize fieldmap as not running
     .fieldmap_stop = false,             // Initialize fieldmap stop flag as false
+    .regulate_running = false,          // Initialize regulation as not running
+    .regulate_stop = false,             // Initialize regulation stop flag as false
+    .regulate_done = false,             // Initialize regulation exit flag as false
     .log_file = NULL,              // Initialize log file as NULL
     .logging_enabled = false,      // Initialize logging as disabled
+    .command_depth = 0,            // No command executing yet
+    .replay_active = false,        // No replay running yet
     .adc_bias = {0.0},             // Initialize all ADC bias values to 0.0
     .adc_bias_valid = {false},     // Initialize all ADC bias validity flags to false
     .adc_bias_previous = {0.0},    // Initialize all previous ADC bias values to 0.0
-    .adc_bias_previous_valid = {false}  // Initialize all previous ADC bias validity flags to false
+    .adc_bias_previous_valid = {false}, // Initialize all previous ADC bias validity flags to false
+    .adc_cal = create_cal_table(), // No fitted ADC corrections yet
+    .dac_cal = {0},                // No DAC offsets known yet
+    .dac_cal_valid = {false},
+    .cal_store_path = "",          // Calibration store disabled until set below
+    .adc_bias_time = {0},
+    .dac_cal_time = {0},
+    .adc_cal_time = {0},
+    .preemph = create_preemph()    // No pre-emphasis until load_preemph
   };
 
+  // Restore the last calibration (the simulator only uses a store when one is given)
+  if (!no_cal_store && (cal_store_arg != NULL || !sim_mode)) {
+    if (cal_store_arg != NULL) {
+      clean_and_expand_path(cal_store_arg, cmd_ctx.cal_store_path, sizeof(cmd_ctx.cal_store_path));
+    } else {
+      cal_store_default_path(cmd_ctx.cal_store_path, sizeof(cmd_ctx.cal_store_path));
+    }
+    int store_result = load_calibration_store(&cmd_ctx, cmd_ctx.cal_store_path);
+    if (store_result == 1) {
+      printf("No calibration store at '%s' yet; it will be created by the first calibration.\n", cmd_ctx.cal_store_path);
+    } else if (store_result < 0) {
+      // Keep the unreadable file for inspection; the next autosave would otherwise replace it
+      char backup_path[sizeof(cmd_ctx.cal_store_path) + 4];
+      if (cal_store_backup(cmd_ctx.cal_store_path, backup_path, sizeof(backup_path)) == 0) {
+        fprintf(stderr, "WARNING: Calibration store not loaded; moved it to '%s'. "
+                "A new store will be created by the next calibration.\n", backup_path);
+      } else {
+        fprintf(stderr, "WARNING: Calibration store not loaded; it will be replaced by the next calibration.\n");
+      }
+    }
+  }
+
+  if (daemon_mode) {
+    // Serve commands from socket clients until one of them sends 'exit'
+    if (daemon_run(&cmd_ctx, socket_path) != 0) {
+      should_exit = true;
+    }
+  } else {
+    // Print help
+    print_help();
+    printf("Entering command loop. Type 'help' for available commands.\n");
+  }
+
   char command[256];
   while (!should_exit) {
     printf("\n");
@@ -182,6 +309,15 @@ int main(int argc, char *argv[])
     }
   }
   
+  // Stop closed-loop regulation if running
+  if (cmd_ctx.regulate_running) {
+    printf("Stopping closed-loop regulation...\n");
+    cmd_ctx.regulate_stop = true;
+    if (pthread_join(cmd_ctx.regulate_thread, NULL) != 0) {
+      fprintf(stderr, "Failed to join regulation thread\n");
+    }
+  }
+  
   // Close log file if logging is active
   if (cmd_ctx.logging_enabled && cmd_ctx.log_file != NULL) {
     printf("Closing command log file...\n");
@@ -14,11 +14,12 @@
 #include "sys_sts.h"
 #include "adc_ctrl.h"
 #include "map_memory.h"
+#include "shm_ring.h"
 
 // Forward declarations for helper functions
 static void* adc_data_stream_thread(void* arg);
+static void* adc_shm_stream_thread(void* arg);
 static void* adc_cmd_stream_thread(void* arg);
-static int parse_adc_command_file(const char* file_path, adc_command_t** commands, int* command_count);
 
 // Local helper function to check if system is running
 static int validate_system_running(command_context_t* ctx) {
@@ -266,6 +267,86 @@ int cmd_adc_set_ord(const char** args, int arg_count, const command_flag_t* flag
   return 0;
 }
 
+// Parse an averaging count (reads per channel, a power of two from 1 to 2^ADC_AVG_LOG2_MAX) into its log2
+static int parse_adc_avg(const char* str, uint8_t* avg_log2) {
+  char* endptr;
+  uint32_t reads = parse_value(str, &endptr);
+  if (*endptr != '\0' || reads == 0 || (reads & (reads - 1)) != 0 || reads > (1u << ADC_AVG_LOG2_MAX)) return -1;
+  *avg_log2 = 0;
+  while ((1u << *avg_log2) < reads) (*avg_log2)++;
+  return 0;
+}
+
+int cmd_adc_set_avg(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  int board = validate_board_number(args[0]);
+  if (board < 0) {
+    fprintf(stderr, "Invalid board number for adc_set_avg: '%s'. Must be 0-7.\n", args[0]);
+    return -1;
+  }
+  
+  uint8_t avg_log2;
+  if (parse_adc_avg(args[1], &avg_log2) < 0) {
+    fprintf(stderr, "Invalid averaging for adc_set_avg: '%s'. Must be a power of two from 1 to %u.\n", args[1], 1u << ADC_AVG_LOG2_MAX);
+    return -1;
+  }
+  
+  adc_cmd_set_avg(ctx->adc_ctrl, (uint8_t)board, avg_log2, *(ctx->verbose));
+  printf("ADC averaging set for board %d: %u reads per channel\n", board, 1u << avg_log2);
+  return 0;
+}
+
+int cmd_adc_set_frame(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  int board = validate_board_number(args[0]);
+  if (board < 0) {
+    fprintf(stderr, "Invalid board number for adc_set_frame: '%s'. Must be 0-7.\n", args[0]);
+    return -1;
+  }
+  
+  char* endptr;
+  uint32_t frame_len = parse_value(args[1], &endptr);
+  if (*endptr != '\0' || frame_len > ADC_FRAME_LEN_MAX) {
+    fprintf(stderr, "Invalid frame length for adc_set_frame: '%s'. Must be 0 to %d data words.\n", args[1], ADC_FRAME_LEN_MAX);
+    return -1;
+  }
+  // Markers in a stream that isn't checking for them would land in its file as samples
+  if (ctx->adc_data_stream_running[board]) {
+    fprintf(stderr, "ADC data stream for board %d is running. Stop it before changing the framing.\n", board);
+    return -1;
+  }
+  
+  adc_cmd_set_frame(ctx->adc_ctrl, (uint8_t)board, (uint16_t)frame_len, *(ctx->verbose));
+  if (frame_len == 0) printf("ADC framing turned off for board %d\n", board);
+  else printf("ADC framing set for board %d: a marker every %u data words\n", board, frame_len);
+  return 0;
+}
+
+int cmd_adc_frame_sts(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  int first = 0, last = 7;
+  if (arg_count > 0) {
+    first = last = validate_board_number(args[0]);
+    if (first < 0) {
+      fprintf(stderr, "Invalid board number for adc_frame_sts: '%s'. Must be 0-7.\n", args[0]);
+      return -1;
+    }
+  }
+  
+  for (int board = first; board <= last; board++) {
+    printf("Board %d: framing %s", board, ctx->adc_ctrl->frame_len[board] ? "" : "off");
+    if (ctx->adc_ctrl->frame_len[board]) printf("%u data words per frame", ctx->adc_ctrl->frame_len[board]);
+    if (ctx->adc_frame_stats_len[board] == 0) {
+      printf(", no framed file stream yet\n");
+      continue;
+    }
+    // A snapshot of the counters the stream thread updates after each block
+    struct adc_frame_stats_t stats = ctx->adc_frame_stats[board];
+    printf(", %s stream: %llu data words, %llu markers, %llu gaps, %llu words lost, %llu unverified, %llu sync losses\n",
+           ctx->adc_data_stream_running[board] ? "running" : "last",
+           (unsigned long long)stats.data_words, (unsigned long long)stats.markers, (unsigned long long)stats.gaps,
+           (unsigned long long)stats.words_lost, (unsigned long long)stats.unverified, (unsigned long long)stats.sync_losses);
+  }
+  return 0;
+}
+
 // ADC reading operations
 int cmd_do_adc_rd(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   int board = validate_board_number(args[0]);
@@ -274,10 +355,28 @@ int cmd_do_adc_rd(const char** args, int arg_count, const command_flag_t* flags,
     return -1;
   }
   
+  // Parse optional averaging (args[4], default 1 read per channel) first, since it sets the minimum delay
+  uint8_t avg_log2 = 0;
+  if (arg_count >= 5 && parse_adc_avg(args[4], &avg_log2) < 0) {
+    fprintf(stderr, "Invalid averaging for adc_rd: '%s'. Must be a power of two from 1 to %u.\n", args[4], 1u << ADC_AVG_LOG2_MAX);
+    return -1;
+  }
+  
   // Parse trigger mode (args[1]) and value (args[2])
   bool is_trigger;
   uint32_t value;
-  if (parse_trigger_mode(args[1], args[2], &is_trigger, &value) < 0) {
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  if (strcmp(args[1], "delay") == 0) {
+    // Delays may be given in cycles, as a time (e.g. "10us"), or as "min"
+    is_trigger = false;
+    if (spi_timing_parse_delay(&timing, args[2], spi_timing_adc_rd_avg_min_delay(&timing, avg_log2), &value) < 0) {
+      fprintf(stderr, "Invalid delay for adc_rd: '%s'. Use cycles (max 0x1FFFFFF), a time with ns/us/ms/s, or 'min'.\n", args[2]);
+      return -1;
+    }
+    if (validate_adc_rd_avg_delay(&timing, value, avg_log2) < 0) {
+      return -1;
+    }
+  } else if (parse_trigger_mode(args[1], args[2], &is_trigger, &value) < 0) {
     return -1;
   }
   
@@ -297,13 +396,13 @@ int cmd_do_adc_rd(const char** args, int arg_count, const command_flag_t* flags,
     }
   }
   
-  printf("Performing ADC read on board %d (%s mode, value %u, repeat_count %ld)...\n", 
-         board, is_trigger ? "trigger" : "delay", value, repeat_count);
+  printf("Performing ADC read on board %d (%s mode, value %u, repeat_count %ld, %u reads per channel)...\n", 
+         board, is_trigger ? "trigger" : "delay", value, repeat_count, 1u << avg_log2);
   
-  adc_cmd_adc_rd(ctx->adc_ctrl, (uint8_t)board, is_trigger, false, value, (uint32_t)repeat_count, *(ctx->verbose));
+  adc_cmd_adc_rd(ctx->adc_ctrl, (uint8_t)board, is_trigger, false, value, (uint32_t)repeat_count, avg_log2, *(ctx->verbose));
   
-  printf("ADC read command sent to board %d: adc_rd(%s, %u, repeat_count=%ld).\n", 
-         board, is_trigger ? "trigger" : "delay", value, repeat_count);
+  printf("ADC read command sent to board %d: adc_rd(%s, %u, repeat_count=%ld, avg=%u).\n", 
+         board, is_trigger ? "trigger" : "delay", value, repeat_count, 1u << avg_log2);
   return 0;
 }
 
@@ -335,6 +434,36 @@ int cmd_do_adc_rd_ch(const char** args, int arg_count, const command_flag_t* fla
   return 0;
 }
 
+// Write data words to a stream file (raw words, or eight samples per line in ASCII). Returns 0 on success, -1 on error.
+static int write_adc_stream_words(FILE* file, const uint32_t* words, size_t count, bool binary_mode, int* samples_on_line) {
+  if (binary_mode) {
+    // Binary mode: write raw 32-bit words directly
+    return (fwrite(words, sizeof(uint32_t), count, file) == count) ? 0 : -1;
+  }
+  // ASCII mode: convert and write samples as text
+  for (size_t i = 0; i < count; i++) {
+    uint32_t word = words[i];
+    
+    // Extract two 16-bit samples from the 32-bit word and convert them from offset format to signed
+    int16_t samples[2] = {offset_to_signed((uint16_t)(word & 0xFFFF)),          // Bits 15:0
+                          offset_to_signed((uint16_t)((word >> 16) & 0xFFFF))}; // Bits 31:16
+    for (int j = 0; j < 2; j++) {
+      if (*samples_on_line > 0) {
+        fprintf(file, " ");
+      }
+      fprintf(file, "%d", samples[j]);
+      (*samples_on_line)++;
+      
+      // Check if we need a new line
+      if (*samples_on_line >= 8) {
+        fprintf(file, "\n");
+        *samples_on_line = 0;
+      }
+    }
+  }
+  return ferror(file) ? -1 : 0;
+}
+
 // Thread function for ADC data streaming
 static void* adc_data_stream_thread(void* arg) {
   adc_data_stream_params_t* stream_data = (adc_data_stream_params_t*)arg;
@@ -344,31 +473,52 @@ static void* adc_data_stream_thread(void* arg) {
   uint64_t word_count = stream_data->word_count;
   volatile bool* should_stop = stream_data->should_stop;
   bool binary_mode = stream_data->binary_mode;
+  bool calibrated = stream_data->calibrated;
+  bool framed = stream_data->frame_len > 0;
+  struct adc_frame_check_t* frame_check = &stream_data->frame_check;
   bool verbose = *(ctx->verbose);
   
   if (verbose) {
-    printf("ADC Data Stream Thread[%d]: Starting to write %llu words to file '%s' (%s format)\n", 
-           board, word_count, file_path, binary_mode ? "binary" : "ASCII");
+    fprintf(ctx->console_out, "ADC Data Stream Thread[%d]: Starting to write %llu words to file '%s' (%s format%s%s)\n", 
+           board, word_count, file_path, binary_mode ? "binary" : "ASCII", calibrated ? ", calibrated" : "",
+           framed ? ", frame checked" : "");
   }
   
   // Open file for writing (binary or text mode based on format)
   FILE* file = fopen(file_path, binary_mode ? "wb" : "w");
   if (file == NULL) {
-    fprintf(stderr, "ADC Data Stream Thread[%d]: Failed to open file '%s' for writing: %s\n", 
+    fprintf(ctx->console_err, "ADC Data Stream Thread[%d]: Failed to open file '%s' for writing: %s\n", 
            board, file_path, strerror(errno));
     goto cleanup;
   }
   
+  // Framed data: markers are checked and stripped, and gaps go to a log next to the data
+  FILE* frame_log = NULL;
+  char frame_log_path[1040];
+  if (framed) {
+    snprintf(frame_log_path, sizeof(frame_log_path), "%s.frames", file_path);
+    frame_log = fopen(frame_log_path, "w");
+    if (frame_log == NULL) {
+      fprintf(ctx->console_err, "ADC Data Stream Thread[%d]: Failed to open frame log '%s' for writing: %s\n",
+              board, frame_log_path, strerror(errno));
+      fclose(file);
+      goto cleanup;
+    }
+    adc_frame_check_init(frame_check, board, stream_data->frame_len, frame_log);
+  }
+  
+  uint64_t words_read = 0;
   uint64_t words_written = 0;
-  uint32_t write_buffer[256]; // Buffer for writing data
+  uint32_t read_buffer[256]; // Buffer for reading the FIFO
+  uint32_t write_buffer[256 + ADC_FRAME_HOLD_WORDS]; // Data words to write (framed blocks can release held words)
   int samples_on_line = 0; // Track samples per line for formatting (ASCII mode only)
   
-  while (words_written < word_count && !(*should_stop)) {
+  while (words_read < word_count && !(*should_stop)) {
     // Check data FIFO status
     uint32_t data_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, board, false);
     
     if (FIFO_PRESENT(data_status) == 0) {
-      fprintf(stderr, "ADC Data Stream Thread[%d]: Data FIFO not present, stopping stream\n", board);
+      fprintf(ctx->console_err, "ADC Data Stream Thread[%d]: Data FIFO not present, stopping stream\n", board);
       break;
     }
     
@@ -380,74 +530,45 @@ static void* adc_data_stream_thread(void* arg) {
       if (words_to_read > 256) {
         words_to_read = 256;
       }
-      if (words_written + words_to_read > word_count) {
-        words_to_read = (uint32_t)(word_count - words_written);
+      if (words_read + words_to_read > word_count) {
+        words_to_read = (uint32_t)(word_count - words_read);
       }
       
       // Read data from FIFO
       for (uint32_t i = 0; i < words_to_read; i++) {
-        write_buffer[i] = adc_read_word(ctx->adc_ctrl, board);
+        read_buffer[i] = adc_read_word(ctx->adc_ctrl, board);
       }
+      words_read += words_to_read;
       
-      // Write data based on format mode
-      if (binary_mode) {
-        // Binary mode: write raw 32-bit words directly
-        size_t written = fwrite(write_buffer, sizeof(uint32_t), words_to_read, file);
-        if (written != words_to_read) {
-          fprintf(stderr, "ADC Data Stream Thread[%d]: Failed to write to file: %s\n", 
-                 board, strerror(errno));
-          break;
-        }
+      size_t data_count = words_to_read;
+      if (framed) {
+        data_count = adc_frame_check_words(frame_check, read_buffer, words_to_read, write_buffer);
+        ctx->adc_frame_stats[board] = frame_check->stats;
       } else {
-        // ASCII mode: convert and write samples as text
-        for (uint32_t i = 0; i < words_to_read; i++) {
-          uint32_t word = write_buffer[i];
-          
-          // Extract two 16-bit samples from the 32-bit word
-          uint16_t sample1_offset = (uint16_t)(word & 0xFFFF);        // Bits 15:0
-          uint16_t sample2_offset = (uint16_t)((word >> 16) & 0xFFFF); // Bits 31:16
-          
-          // Convert from offset format to signed using the offset_to_signed function
-          int16_t sample1_signed = offset_to_signed(sample1_offset);
-          int16_t sample2_signed = offset_to_signed(sample2_offset);
-          
-          // Write sample1
-          if (samples_on_line > 0) {
-            fprintf(file, " ");
-          }
-          fprintf(file, "%d", sample1_signed);
-          samples_on_line++;
-          
-          // Check if we need a new line
-          if (samples_on_line >= 8) {
-            fprintf(file, "\n");
-            samples_on_line = 0;
-          }
-          
-          // Write sample2
-          if (samples_on_line > 0) {
-            fprintf(file, " ");
-          }
-          fprintf(file, "%d", sample2_signed);
-          samples_on_line++;
-          
-          // Check if we need a new line
-          if (samples_on_line >= 8) {
-            fprintf(file, "\n");
-            samples_on_line = 0;
-          }
-        }
+        memcpy(write_buffer, read_buffer, words_to_read * sizeof(uint32_t));
+      }
+      
+      // Correct in place (integer kernel, the block may end partway through a read)
+      if (calibrated) {
+        cal_table_apply_words(&stream_data->cal, board, write_buffer, write_buffer, data_count,
+                              (uint32_t)(words_written & 3));
+      }
+      
+      if (write_adc_stream_words(file, write_buffer, data_count, binary_mode, &samples_on_line) < 0) {
+        fprintf(ctx->console_err, "ADC Data Stream Thread[%d]: Failed to write to file: %s\n", 
+               board, strerror(errno));
+        break;
       }
       
       // Flush the file to ensure data is written
       fflush(file);
       
-      words_written += words_to_read;
+      words_written += data_count;
       
-      if (verbose && words_written % 10000 == 0) {
-        printf("ADC Data Stream Thread[%d]: Written %llu/%llu words (%.1f%%)\n",
-               board, words_written, word_count,
-               (double)words_written / word_count * 100.0);
+      if (verbose && words_read % 10000 == 0) {
+        fprintf(ctx->console_out, "ADC Data Stream Thread[%d]: Read %llu/%llu words (%.1f%%)\n",
+               board, words_read, word_count,
+               (double)words_read / word_count * 100.0);
       }
     } else {
       // No data available, sleep briefly
@@ -455,21 +576,41 @@ static void* adc_data_stream_thread(void* arg) {
     }
   }
   
-  if (file) {
-    // Add final newline if needed (ASCII mode only, if last line has samples but isn't complete)
-    if (!binary_mode && samples_on_line > 0) {
-      fprintf(file, "\n");
+  // Pass on the words held back behind an unconfirmed marker and log the frame check summary
+  if (framed) {
+    size_t data_count = adc_frame_check_finish(frame_check, write_buffer);
+    ctx->adc_frame_stats[board] = frame_check->stats;
+    if (calibrated) {
+      cal_table_apply_words(&stream_data->cal, board, write_buffer, write_buffer, data_count,
+                            (uint32_t)(words_written & 3));
     }
-    fclose(file);
+    if (write_adc_stream_words(file, write_buffer, data_count, binary_mode, &samples_on_line) < 0) {
+      fprintf(ctx->console_err, "ADC Data Stream Thread[%d]: Failed to write to file: %s\n", board, strerror(errno));
+    }
+    words_written += data_count;
+    fclose(frame_log);
   }
   
+  // Add final newline if needed (ASCII mode only, if last line has samples but isn't complete)
+  if (!binary_mode && samples_on_line > 0) {
+    fprintf(file, "\n");
+  }
+  fclose(file);
+  
   if (*should_stop) {
-    printf("ADC Data Stream Thread[%d]: Stream stopped by user after writing %llu words\n",
+    fprintf(ctx->console_out, "ADC Data Stream Thread[%d]: Stream stopped by user after writing %llu words\n",
            board, words_written);
   } else {
-    printf("ADC Data Stream Thread[%d]: Stream completed, wrote %llu words to file '%s'\n",
+    fprintf(ctx->console_out, "ADC Data Stream Thread[%d]: Stream completed, wrote %llu words to file '%s'\n",
            board, words_written, file_path);
   }
+  if (framed) {
+    struct adc_frame_stats_t* stats = &frame_check->stats;
+    fprintf(ctx->console_out, "ADC Data Stream Thread[%d]: Frame check %s: %llu markers stripped, %llu gaps (%llu words lost), %llu words unverified, %llu unconfirmed markers stripped (see '%s')\n",
+           board, adc_frame_check_complete(frame_check) ? "complete" : "INCOMPLETE",
+           (unsigned long long)stats->markers, (unsigned long long)stats->gaps, (unsigned long long)stats->words_lost,
+           (unsigned long long)stats->unverified, (unsigned long long)stats->stripped, frame_log_path);
+  }
   
 cleanup:
   ctx->adc_data_stream_running[board] = false;
@@ -493,8 +634,9 @@ int cmd_stream_adc_data_to_file(const char** args, int arg_count, const command_
     return -1;
   }
   
-  // Check for binary mode flag
+  // Check for binary mode and calibration flags
   bool binary_mode = has_flag(flags, flag_count, FLAG_BIN);
+  bool calibrated = has_flag(flags, flag_count, FLAG_CAL);
   
   // Check if stream is already running
   if (ctx->adc_data_stream_running[board]) {
@@ -562,6 +704,18 @@ int cmd_stream_adc_data_to_file(const char** args, int arg_count, const command_
   stream_data->word_count = word_count;
   stream_data->should_stop = &(ctx->adc_data_stream_stop[board]);
   stream_data->binary_mode = binary_mode;
+  stream_data->calibrated = calibrated;
+  stream_data->frame_len = ctx->adc_ctrl->frame_len[board];
+  if (calibrated) {
+    get_adc_correction(ctx, &stream_data->cal);
+    int corrected_channels = 0;
+    for (int ch = board * 8; ch < board * 8 + 8; ch++) {
+      if (cal_table_channel_valid(&stream_data->cal, ch)) corrected_channels++;
+    }
+    if (corrected_channels == 0) {
+      printf("No cal_fit or find_bias corrections for board %d; samples will pass through unchanged.\n", board);
+    }
+  }
   
   if (*(ctx->verbose)) {
     printf("Stream parameters: board=%d, word_count=%llu, file='%s', format=%s\n", 
@@ -574,6 +728,8 @@ int cmd_stream_adc_data_to_file(const char** args, int arg_count, const command_
   // Initialize stop flag and mark stream as running
   ctx->adc_data_stream_stop[board] = false;
   ctx->adc_data_stream_running[board] = true;
+  memset(&ctx->adc_frame_stats[board], 0, sizeof(ctx->adc_frame_stats[board]));
+  ctx->adc_frame_stats_len[board] = stream_data->frame_len;
   
   if (*(ctx->verbose)) {
     printf("Initialized stream flags, creating pthread...\n");
@@ -624,8 +780,131 @@ int cmd_stop_adc_data_stream(const char** args, int arg_count, const command_fla
   return 0;
 }
 
+// ADC data streaming thread into a shared memory ring (daemon mode consumers attach to the ring)
+static void* adc_shm_stream_thread(void* arg) {
+  adc_shm_stream_params_t* stream_data = (adc_shm_stream_params_t*)arg;
+  command_context_t* ctx = stream_data->ctx;
+  uint8_t board = stream_data->board;
+  volatile bool* should_stop = stream_data->should_stop;
+  bool verbose = *(ctx->verbose);
+  struct shm_ring_t* ring = &(stream_data->ring);
+  
+  if (verbose) {
+    fprintf(ctx->console_out, "ADC SHM Stream Thread[%d]: Streaming into ring '%s' (%u words)\n",
+           board, ring->name, ring->header->capacity_words);
+  }
+  
+  uint64_t words_streamed = 0;
+  uint32_t read_buffer[256]; // Buffer for batching ring writes
+  
+  while (!(*should_stop)) {
+    uint32_t data_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, board, false);
+    
+    if (FIFO_PRESENT(data_status) == 0) {
+      fprintf(ctx->console_err, "ADC SHM Stream Thread[%d]: Data FIFO not present, stopping stream\n", board);
+      break;
+    }
+    
+    uint32_t words_available = FIFO_STS_WORD_COUNT(data_status);
+    if (words_available == 0) {
+      usleep(100);
+      continue;
+    }
+    if (words_available > 256) {
+      words_available = 256;
+    }
+    
+    for (uint32_t i = 0; i < words_available; i++) {
+      read_buffer[i] = adc_read_word(ctx->adc_ctrl, board);
+    }
+    shm_ring_write(ring, read_buffer, words_available);
+    words_streamed += words_available;
+  }
+  
+  fprintf(ctx->console_out, "ADC SHM Stream Thread[%d]: Stream stopped after %llu words\n", board, words_streamed);
+  
+  shm_ring_close(ring);
+  ctx->adc_data_stream_running[board] = false;
+  free(stream_data);
+  return NULL;
+}
+
+int cmd_stream_adc_data_to_shm(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  // Parse board number
+  int board = parse_board_number(args[0]);
+  if (board < 0) {
+    fprintf(stderr, "Invalid board number for stream_adc_data_to_shm: '%s'. Must be 0-7.\n", args[0]);
+    return -1;
+  }
+  
+  // Parse optional ring size
+  uint32_t ring_words = SHM_RING_DEFAULT_WORDS;
+  if (arg_count > 1) {
+    char* endptr;
+    ring_words = parse_value(args[1], &endptr);
+    if (*endptr != '\0' || ring_words == 0 || (ring_words & (ring_words - 1)) != 0) {
+      fprintf(stderr, "Invalid ring size for stream_adc_data_to_shm: '%s'. Must be a power of two.\n", args[1]);
+      return -1;
+    }
+  }
+  
+  // The ring shares the data stream slot, since both drain the same FIFO
+  if (ctx->adc_data_stream_running[board]) {
+    printf("ADC data stream for board %d is already running.\n", board);
+    return -1;
+  }
+  
+  if (FIFO_PRESENT(sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, *(ctx->verbose))) == 0) {
+    printf("ADC data FIFO for board %d is not present. Cannot start streaming.\n", board);
+    return -1;
+  }
+  
+  adc_shm_stream_params_t* stream_data = malloc(sizeof(adc_shm_stream_params_t));
+  if (stream_data == NULL) {
+    fprintf(stderr, "Failed to allocate memory for stream data\n");
+    return -1;
+  }
+  
+  char ring_name[64];
+  snprintf(ring_name, sizeof(ring_name), SHM_RING_ADC_NAME_FMT, board);
+  if (shm_ring_create(&(stream_data->ring), ring_name, ring_words, *(ctx->verbose)) != 0) {
+    free(stream_data);
+    return -1;
+  }
+  
+  stream_data->ctx = ctx;
+  stream_data->board = (uint8_t)board;
+  stream_data->should_stop = &(ctx->adc_data_stream_stop[board]);
+  
+  ctx->adc_data_stream_stop[board] = false;
+  ctx->adc_data_stream_running[board] = true;
+  
+  if (pthread_create(&(ctx->adc_data_stream_threads[board]), NULL, adc_shm_stream_thread, stream_data) != 0) {
+    fprintf(stderr, "Failed to create ADC SHM streaming thread for board %d: %s\n", board, strerror(errno));
+    ctx->adc_data_stream_running[board] = false;
+    shm_ring_close(&(stream_data->ring));
+    free(stream_data);
+    return -1;
+  }
+  
+  printf("Started ADC data streaming for board %d into shared memory ring '%s' (%u words)\n",
+         board, ring_name, ring_words);
+  return 0;
+}
+
+// Parse the value field of an ADC command line: a trigger count for T, or an ADC read delay for D
+// (cycles, a time like "10us", or "min" for the shortest delay an ADC read at the current averaging allows)
+static int parse_adc_command_value(const struct spi_timing_t* timing, char type, const char* value_str, uint8_t avg_log2, uint32_t* value) {
+  if (type == 'T') {
+    char* endptr;
+    *value = parse_value(value_str, &endptr);
+    return (*endptr == '\0' && *value <= 0x1FFFFFF) ? 0 : -1;
+  }
+  return spi_timing_parse_delay(timing, value_str, spi_timing_adc_rd_avg_min_delay(timing, avg_log2), value);
+}
+
 // Function to validate and parse an ADC command file
-static int parse_adc_command_file(const char* file_path, adc_command_t** commands, int* command_count) {
+int parse_adc_command_file(const char* file_path, const struct spi_timing_t* timing, adc_command_t** commands, int* command_count) {
   FILE* file = fopen(file_path, "r");
   if (file == NULL) {
     fprintf(stderr, "Failed to open ADC command file '%s': %s\n", file_path, strerror(errno));
@@ -636,6 +915,7 @@ static int parse_adc_command_file(const char* file_path, adc_command_t** command
   char line[512];
   int line_num = 0;
   int valid_lines = 0;
+  uint8_t avg_log2 = 0; // Averaging set by 'A' lines, for checking later D delays
   
   while (fgets(line, sizeof(line), file)) {
     line_num++;
@@ -647,15 +927,16 @@ static int parse_adc_command_file(const char* file_path, adc_command_t** command
       continue;
     }
     
-    // Check if line starts with T, D, or O (removed L support)
-    if (*trimmed != 'T' && *trimmed != 'D' && *trimmed != 'O') {
-      fprintf(stderr, "Invalid line %d: must start with 'T', 'D', or 'O'\n", line_num);
+    // Check if line starts with T, D, O, or A (removed L support)
+    if (*trimmed != 'T' && *trimmed != 'D' && *trimmed != 'O' && *trimmed != 'A') {
+      fprintf(stderr, "Invalid line %d: must start with 'T', 'D', 'O', or 'A'\n", line_num);
       fclose(file);
       return -1;
     }
     
     // Parse the line to validate format
     char mode;
+    char value_str[64];
     uint32_t value, repeat_count;
     uint8_t s1, s2, s3, s4, s5, s6, s7, s8;
     
@@ -674,9 +955,17 @@ static int parse_adc_command_file(const char* file_path, adc_command_t** command
         fclose(file);
         return -1;
       }
+    } else if (*trimmed == 'A') {
+      // Averaging command: A <reads per channel> (applies to the D lines after it)
+      if (sscanf(trimmed, "%c %63s", &mode, value_str) != 2 || parse_adc_avg(value_str, &avg_log2) < 0) {
+        fprintf(stderr, "Invalid line %d: 'A' command must have a power of two from 1 to %u reads per channel\n",
+                line_num, 1u << ADC_AVG_LOG2_MAX);
+        fclose(file);
+        return -1;
+      }
     } else {
       // T, D commands: <cmd> <value> [repeat_count]
-      int parsed = sscanf(trimmed, "%c %u %u", &mode, &value, &repeat_count);
+      int parsed = sscanf(trimmed, "%c %63s %u", &mode, value_str, &repeat_count);
       if (parsed < 2) {
         fprintf(stderr, "Invalid line %d: must have command and value\n", line_num);
         fclose(file);
@@ -686,9 +975,17 @@ static int parse_adc_command_file(const char* file_path, adc_command_t** command
         repeat_count = 0; // Default repeat count
       }
       
-      // Validate value range
-      if (value > 0x1FFFFFF) {
-        fprintf(stderr, "Invalid line %d: value %u out of range (max 0x1FFFFFF or 33554431)\n", line_num, value);
+      // Validate value range (times need the SPI clock to convert to cycles)
+      if (parse_adc_command_value(timing, mode, value_str, avg_log2, &value) < 0) {
+        fprintf(stderr, "Invalid line %d: value '%s' must be 0 to 0x1FFFFFF (33554431) cycles%s\n", line_num, value_str,
+                (mode == 'D') ? ", a time with ns/us/ms/s, or 'min' (times need a running SPI clock)" : "");
+        fclose(file);
+        return -1;
+      }
+      
+      // Validate ADC read delays against the hardware's minimum command spacing
+      if (mode == 'D' && validate_adc_rd_avg_delay(timing, value, avg_log2) < 0) {
+        fprintf(stderr, "Invalid line %d: ADC read delay too short\n", line_num);
         fclose(file);
         return -1;
       }
@@ -722,6 +1019,7 @@ static int parse_adc_command_file(const char* file_path, adc_command_t** command
   rewind(file);
   line_num = 0;
   *command_count = 0;
+  avg_log2 = 0;
   
   while (fgets(line, sizeof(line), file)) {
     line_num++;
@@ -744,10 +1042,22 @@ static int parse_adc_command_file(const char* file_path, adc_command_t** command
       cmd->order[4] = s5; cmd->order[5] = s6; cmd->order[6] = s7; cmd->order[7] = s8;
       cmd->value = 0; // Not used for order commands
       cmd->repeat_count = 0; // Not used for order commands
+    } else if (*trimmed == 'A') {
+      char value_str[64];
+      sscanf(trimmed, "%c %63s", &cmd->type, value_str);
+      parse_adc_avg(value_str, &avg_log2);
+      cmd->value = avg_log2; // Stored as log2 of the reads per channel
+      cmd->repeat_count = 0;
+      for (int i = 0; i < 8; i++) {
+        cmd->order[i] = 0;
+      }
     } else {
       // Parse T, D commands with optional repeat_count
+      char value_str[64];
       uint32_t repeat_count;
-      int parsed = sscanf(trimmed, "%c %u %u", &cmd->type, &cmd->value, &repeat_count);
+      int parsed = sscanf(trimmed, "%c %63s %u", &cmd->type, value_str, &repeat_count);
+      cmd->value = 0;
+      parse_adc_command_value(timing, cmd->type, value_str, avg_log2, &cmd->value);
       if (parsed >= 3) {
         cmd->repeat_count = repeat_count;
       } else {
@@ -766,6 +1076,39 @@ static int parse_adc_command_file(const char* file_path, adc_command_t** command
   return 0;
 }
 
+// Encode one pass of ADC commands
+uint32_t* encode_adc_commands(const adc_command_t* commands, int command_count, size_t* word_count) {
+  size_t count = 0;
+  for (int i = 0; i < command_count; i++) {
+    count += ((commands[i].type == 'D') && (commands[i].repeat_count > 0)) ? 2 : 1;
+  }
+  uint32_t* words = malloc(count * sizeof(uint32_t));
+  if (words == NULL) {
+    fprintf(stderr, "Failed to allocate memory for encoded ADC commands\n");
+    return NULL;
+  }
+  size_t w = 0;
+  for (int i = 0; i < command_count; i++) {
+    const adc_command_t* cmd = &commands[i];
+    switch (cmd->type) {
+      case 'T':
+        words[w++] = adc_encode_cmd(ADC_CMD_NO_OP, true, false, cmd->value);
+        break;
+      case 'D':
+        w += adc_encode_adc_rd(&words[w], false, false, cmd->value, cmd->repeat_count);
+        break;
+      case 'A':
+        words[w++] = adc_encode_set_avg((uint8_t)cmd->value);
+        break;
+      default: // 'O'
+        words[w++] = adc_encode_set_ord(cmd->order);
+        break;
+    }
+  }
+  *word_count = count;
+  return words;
+}
+
 // ADC command streaming thread function (for streaming commands from file)
 static void* adc_cmd_stream_thread(void* arg) {
   adc_command_stream_params_t* stream_data = (adc_command_stream_params_t*)arg;
@@ -775,13 +1118,13 @@ static void* adc_cmd_stream_thread(void* arg) {
   volatile bool* should_stop = stream_data->should_stop;
   adc_command_t* commands = stream_data->commands;
   int command_count = stream_data->command_count;
+  const uint32_t* words = stream_data->words;
   int iterations = stream_data->iterations;
-  bool simple_mode = stream_data->simple_mode;
   bool verbose = *(ctx->verbose);
 
   if (verbose) {
-    printf("ADC Command Stream Thread[%d]: Started streaming from file '%s' (%d commands, %d iteration%s)\n",
-           board, file_path, command_count, iterations, iterations == 1 ? "" : "s");
+    fprintf(ctx->console_out, "ADC Command Stream Thread[%d]: Started streaming from file '%s' (%d commands, %zu words, %d iteration%s)\n",
+           board, file_path, command_count, stream_data->word_count, iterations, iterations == 1 ? "" : "s");
   }
 
   int total_commands_sent = 0;
@@ -790,80 +1133,119 @@ static void* adc_cmd_stream_thread(void* arg) {
 
   while (!(*should_stop) && current_iteration < iterations) {
     int cmd_index = 0;
-    int commands_sent_this_iteration = 0;
+    size_t word_index = 0;
 
+    // Push as many whole commands as the FIFO has room for in one burst
     while (!(*should_stop) && cmd_index < command_count) {
-      adc_command_t* cmd = &commands[cmd_index];
-
-      // Calculate words needed for this command
-      uint32_t words_needed = ((cmd->type == 'D') && (cmd->repeat_count > 0)) ? 2 : 1;
-
       // Check ADC command FIFO status
       uint32_t fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, board, false);
 
       if (FIFO_PRESENT(fifo_status) == 0) {
-        fprintf(stderr, "ADC Command Stream Thread[%d]: FIFO not present, stopping stream\n", board);
+        fprintf(ctx->console_err, "ADC Command Stream Thread[%d]: FIFO not present, stopping stream\n", board);
         goto cleanup;
       }
 
       uint32_t words_used = FIFO_STS_WORD_COUNT(fifo_status) + 1; // +1 for safety margin
       uint32_t words_available = ADC_CMD_FIFO_WORDCOUNT - words_used;
 
-      if (words_available >= words_needed) {
-        // Send the command
-        switch (cmd->type) {
-          case 'T':
-            adc_cmd_noop(ctx->adc_ctrl, board, true, false, cmd->value, false);
-            break;
-          case 'D':
-            adc_cmd_adc_rd(ctx->adc_ctrl, board, false, false, cmd->value, cmd->repeat_count, false);
-            break;
-          case 'O':
-            adc_cmd_set_ord(ctx->adc_ctrl, board, cmd->order, false);
-            break;
-          default:
-            fprintf(stderr, "ADC Command Stream Thread[%d]: Invalid command type '%c'\n", board, cmd->type);
-            break;
-        }
-
-        commands_sent_this_iteration++;
-        total_commands_sent++;
-        total_words_sent += words_needed;
-        cmd_index++;
-
-        if (verbose) {
-          printf("ADC Command Stream Thread[%d]: Iteration %d/%d, Sent command %d/%d (type=%c, value=%u, repeat=%u) [FIFO: %u/%u words, %d needed]\n",
-                 board, current_iteration + 1, iterations, commands_sent_this_iteration, command_count,
-                 cmd->type, cmd->value, cmd->repeat_count, words_used, ADC_CMD_FIFO_WORDCOUNT, words_needed);
-        }
-      } else {
+      int burst_commands = 0;
+      uint32_t burst_words = 0;
+      while (cmd_index + burst_commands < command_count) {
+        const adc_command_t* cmd = &commands[cmd_index + burst_commands];
+        uint32_t words_needed = ((cmd->type == 'D') && (cmd->repeat_count > 0)) ? 2 : 1;
+        if (burst_words + words_needed > words_available) break;
+        burst_words += words_needed;
+        burst_commands++;
+      }
+
+      if (burst_commands == 0) {
         // Not enough space in FIFO, sleep and try again
         usleep(1000); // 1ms
+        continue;
+      }
+
+      adc_write_cmd_words(ctx->adc_ctrl, board, &words[word_index], burst_words);
+
+      if (verbose) {
+        fprintf(ctx->console_out, "ADC Command Stream Thread[%d]: Iteration %d/%d, Sent commands %d-%d/%d (%u words) [FIFO: %u/%u words]\n",
+               board, current_iteration + 1, iterations, cmd_index + 1, cmd_index + burst_commands, command_count,
+               burst_words, words_used, ADC_CMD_FIFO_WORDCOUNT);
       }
+
+      cmd_index += burst_commands;
+      word_index += burst_words;
+      total_commands_sent += burst_commands;
+      total_words_sent += burst_words;
     }
 
     current_iteration++;
     if (current_iteration < iterations && verbose) {
-      printf("ADC Command Stream Thread[%d]: Completed iteration %d/%d, starting next iteration\n",
+      fprintf(ctx->console_out, "ADC Command Stream Thread[%d]: Completed iteration %d/%d, starting next iteration\n",
              board, current_iteration, iterations);
     }
   }
 
 cleanup:
   if (*should_stop) {
-    printf("ADC Command Stream Thread[%d]: Stopping (user requested), sent %d total commands (%d total words)\n",
+    fprintf(ctx->console_out, "ADC Command Stream Thread[%d]: Stopping (user requested), sent %d total commands (%d total words)\n",
            board, total_commands_sent, total_words_sent);
   } else {
-    printf("ADC Command Stream Thread[%d]: Completed, sent %d total commands (%d total words, %d iteration%s)\n",
+    fprintf(ctx->console_out, "ADC Command Stream Thread[%d]: Completed, sent %d total commands (%d total words, %d iteration%s)\n",
            board, total_commands_sent, total_words_sent, iterations, iterations == 1 ? "" : "s");
   }
 
   ctx->adc_cmd_stream_running[board] = false;
-  free(stream_data->commands);
+  if (stream_data->owns_buffers) {
+    free(stream_data->commands);
+    free(stream_data->words);
+  }
   free(stream_data);
   return NULL;
 }
 
+// Start an ADC command stream thread from parsed and encoded commands
+int start_adc_cmd_stream(command_context_t* ctx, uint8_t board, const char* file_path, adc_command_t* commands,
+                         int command_count, uint32_t* words, size_t word_count, int iterations, bool simple_mode,
+                         bool owns_buffers) {
+  // Check if stream is already running
+  if (ctx->adc_cmd_stream_running[board]) {
+    printf("ADC command stream for board %d is already running.\n", board);
+    return -1;
+  }
+
+  // Allocate thread data structure
+  adc_command_stream_params_t* stream_data = malloc(sizeof(adc_command_stream_params_t));
+  if (stream_data == NULL) {
+    fprintf(stderr, "Failed to allocate memory for ADC stream data\n");
+    return -1;
+  }
+
+  stream_data->ctx = ctx;
+  stream_data->board = board;
+  snprintf(stream_data->file_path, sizeof(stream_data->file_path), "%s", file_path);
+  stream_data->should_stop = &(ctx->adc_cmd_stream_stop[board]);
+  stream_data->commands = commands;
+  stream_data->command_count = command_count;
+  stream_data->words = words;
+  stream_data->word_count = word_count;
+  stream_data->iterations = iterations;
+  stream_data->simple_mode = simple_mode;
+  stream_data->owns_buffers = owns_buffers;
+
+  // Initialize stop flag and mark stream as running
+  ctx->adc_cmd_stream_stop[board] = false;
+  ctx->adc_cmd_stream_running[board] = true;
+
+  // Create the streaming thread
+  if (pthread_create(&(ctx->adc_cmd_stream_threads[board]), NULL, adc_cmd_stream_thread, stream_data) != 0) {
+    fprintf(stderr, "Failed to create ADC command streaming thread for board %d: %s\n", board, strerror(errno));
+    ctx->adc_cmd_stream_running[board] = false;
+    free(stream_data);
+    return -1;
+  }
+  return 0;
+}
+
 int cmd_stream_adc_commands_from_file(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   // Parse board number
   int board = parse_board_number(args[0]);
@@ -900,7 +1282,7 @@ int cmd_stream_adc_commands_from_file(const char** args, int arg_count, const co
   
   // Resolve glob pattern if present
   char resolved_path[1024];
-  if (resolve_file_pattern(args[1], resolved_path, sizeof(resolved_path)) != 0) {
+  if (resolve_file_pattern(args[1], resolved_path, sizeof(resolved_path), ctx->in) != 0) {
     return -1;
   }
   
@@ -912,7 +1294,8 @@ int cmd_stream_adc_commands_from_file(const char** args, int arg_count, const co
   adc_command_t* commands = NULL;
   int command_count = 0;
   
-  if (parse_adc_command_file(full_path, &commands, &command_count) != 0) {
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  if (parse_adc_command_file(full_path, &timing, &commands, &command_count) != 0) {
     return -1; // Error already printed by parse_adc_command_file
   }
   
@@ -923,36 +1306,21 @@ int cmd_stream_adc_commands_from_file(const char** args, int arg_count, const co
     }
   }
   
-  // Allocate thread data structure
-  adc_command_stream_params_t* stream_data = malloc(sizeof(adc_command_stream_params_t));
-  if (stream_data == NULL) {
-    fprintf(stderr, "Failed to allocate memory for ADC stream data\n");
+  // Encode one pass up front; the thread pushes it in bursts for every iteration
+  size_t word_count = 0;
+  uint32_t* words = encode_adc_commands(commands, command_count, &word_count);
+  if (words == NULL) {
     free(commands);
     return -1;
   }
-  
-  stream_data->ctx = ctx;
-  stream_data->board = (uint8_t)board;
-  snprintf(stream_data->file_path, sizeof(stream_data->file_path), "%s", full_path);
-  stream_data->should_stop = &(ctx->adc_cmd_stream_stop[board]);
-  stream_data->commands = commands;
-  stream_data->command_count = command_count;
-  stream_data->iterations = iterations;
-  stream_data->simple_mode = simple_mode;
-  
-  // Initialize stop flag and mark stream as running
-  ctx->adc_cmd_stream_stop[board] = false;
-  ctx->adc_cmd_stream_running[board] = true;
-  
-  // Create the streaming thread
-  if (pthread_create(&(ctx->adc_cmd_stream_threads[board]), NULL, adc_cmd_stream_thread, stream_data) != 0) {
-    fprintf(stderr, "Failed to create ADC command streaming thread for board %d: %s\n", board, strerror(errno));
-    ctx->adc_cmd_stream_running[board] = false;
+
+  if (start_adc_cmd_stream(ctx, (uint8_t)board, full_path, commands, command_count, words, word_count,
+                           iterations, simple_mode, true) != 0) {
     free(commands);
-    free(stream_data);
+    free(words);
     return -1;
   }
-  
+
   if (*(ctx->verbose)) {
     printf("Started ADC command streaming for board %d from file '%s' (%d iteration%s)%s\n", 
            board, full_path, iterations, iterations == 1 ? "" : "s",
@@ -9,6 +9,7 @@
 #include <errno.h>
 #include <pthread.h>
 #include <glob.h>
+#include <time.h>
 #include "command_handler.h"
 #include "command_helper.h"
 #include "system_commands.h"
@@ -16,6 +17,7 @@
 #include "dac_commands.h"
 #include "trigger_commands.h"
 #include "experiment_commands.h"
+#include "hw_trace.h"
 
 /**
  * Command Table
@@ -65,20 +67,27 @@ static command_entry_t command_table[] = {
   {"invert_mosi_clk", cmd_invert_mosi_clk, {0, 0, {-1}, "Invert MOSI SCK polarity register"}},
   {"invert_miso_clk", cmd_invert_miso_clk, {0, 0, {-1}, "Invert MISO SCK polarity register"}},
   {"spi_clk_freq", cmd_spi_clk_freq, {0, 0, {-1}, "Show SPI clock frequency in MHz (and Hz if verbose)"}},
+  {"mem_map", cmd_mem_map, {0, 0, {-1}, "Show the memory map registry windows and whether each was mapped from UIO or /dev/mem"}},
+  {"hw_trace", cmd_hw_trace, {1, 2, {-1}, "Register access flight recorder: <on [entries_per_thread] | off | clear | status | dump [file]> (dumped to " HW_TRACE_DUMP_PATH " automatically if the hardware halts)"}},
   
   // ===== DAC COMMANDS (from dac_commands.h) =====
   {"dac_cmd_fifo_sts", cmd_dac_cmd_fifo_sts, {1, 1, {-1}, "Show DAC command FIFO status for specified board (0-7)"}},
   {"dac_data_fifo_sts", cmd_dac_data_fifo_sts, {1, 1, {-1}, "Show DAC data FIFO status for specified board (0-7)"}},
   {"read_dac_data", cmd_read_dac_data, {1, 1, {FLAG_ALL, -1}, "Read and print data (debug or calibration) from specified board (0-7)"}},
-  {"dac_noop", cmd_dac_noop, {3, 3, {FLAG_CONTINUE, -1}, "Send DAC no-op command: <board|all> <\"trig\"|\"delay\"> <value> [--continue]"}},
+  {"dac_noop", cmd_dac_noop, {3, 3, {FLAG_CONTINUE, -1}, "Send DAC no-op command: <board|all> <\"trig\"|\"delay\"> <value> [--continue] (delay in cycles, a time like 10us, or min)"}},
   {"dac_cancel", cmd_dac_cancel, {1, 1, {-1}, "Send DAC cancel command to specified board (0-7)"}},
   {"do_dac_wr", cmd_do_dac_wr, {11, 11, {FLAG_CONTINUE, -1}, "Send DAC write update command: <board> <ch0> <ch1> <ch2> <ch3> <ch4> <ch5> <ch6> <ch7> <\"trig\"|\"delay\"> <value> [--continue]"}},
   {"do_dac_wr_ch", cmd_do_dac_wr_ch, {2, 2, {-1}, "Write DAC single channel: <channel> <value> (channel 0-63, board=ch/8, ch=ch%8)"}},
   {"get_dac_cal", cmd_get_dac_cal, {0, 1, {FLAG_ALL, FLAG_NO_RESET, -1}, "Get DAC calibration value: <channel> [--no_reset] OR --all [--no_reset] (channel 0-63, board=ch/8, ch=ch%8)"}},
   {"do_dac_get_cal", cmd_do_dac_get_cal, {1, 1, {-1}, "Send DAC GET_CAL command for single channel: <channel> (channel 0-63, board=ch/8, ch=ch%8)"}},
   {"set_dac_cal", cmd_set_dac_cal, {2, 2, {-1}, "Set DAC calibration value for single channel: <channel> <cal_value> (channel 0-63, cal_value -32768 to 32767)"}},
-  {"stream_dac_commands_from_file", cmd_stream_dac_commands_from_file, {2, 3, {-1}, "Start DAC command streaming from waveform file: <board> <file_path> [iterations] (supports * wildcards)"}},
+  {"stream_dac_commands_from_file", cmd_stream_dac_commands_from_file, {2, 3, {-1}, "Start DAC command streaming from waveform file: <board> <file_path> [iterations] (supports * wildcards; packed waveforms are decoded on the fly; 'L <passes>' ... 'E' blocks are replayed by the core, 0 passes until dac_cancel)"}},
+  {"pack_dac_waveform", cmd_pack_dac_waveform, {2, 2, {-1}, "Pack a D/T waveform file into the compact delta/run/block-repeat format (verified exact; delays given as times use the current SPI clock): <file_path> <packed_path>"}},
   {"stop_dac_cmd_stream", cmd_stop_dac_cmd_stream, {1, 1, {-1}, "Stop DAC command streaming for specified board (0-7)"}},
+  {"upload_dac_waveform", cmd_upload_dac_waveform, {2, 3, {-1}, "Upload a whole waveform file to a board's DAC DDR buffer and play it with no host streaming: <board> <file_path> [iterations] (needs the dac_cmd_ddr_buffer design option; text or packed files)"}},
+  {"dac_ddr_sts", cmd_dac_ddr_sts, {1, 1, {-1}, "Show the DAC DDR buffer reader status for specified board (0-7)"}},
+  {"stop_dac_ddr", cmd_stop_dac_ddr, {1, 1, {-1}, "Stop DAC DDR buffer playback for specified board (0-7) at the next command boundary past what is already queued (the core idles cleanly)"}},
+  {"precheck", cmd_precheck, {2, 3, {-1}, "Check a waveform against the integrator threshold before running it: <board> <file_path> [trigger_wait] (uses the current integ_window/integ_average; trigger waits default to the DAC write time; fails if any channel would trip)"}},
   {"stream_dac_debug", cmd_stream_dac_debug, {2, 2, {-1}, "Start DAC debug data streaming to file: <board> <file_path> (streams DAC debug data to file)"}},
   {"stop_dac_debug_stream", cmd_stop_dac_debug_stream, {1, 1, {-1}, "Stop DAC debug data streaming for specified board (0-7)"}},
   
@@ -91,10 +100,14 @@ static command_entry_t command_table[] = {
   {"adc_noop", cmd_adc_noop, {3, 3, {FLAG_CONTINUE, -1}, "Send ADC no-op command: <board|all> <\"trig\"|\"delay\"> <value> [--continue]"}},
   {"adc_cancel", cmd_adc_cancel, {1, 1, {-1}, "Send ADC cancel command to specified board (0-7)"}},
   {"adc_set_ord", cmd_adc_set_ord, {9, 9, {-1}, "Set ADC channel order: <board> <ord0> <ord1> <ord2> <ord3> <ord4> <ord5> <ord6> <ord7> (each order value must be 0-7)"}},
-  {"do_adc_rd", cmd_do_adc_rd, {3, 4, {-1}, "Perform ADC read: <board> <\"trig\"|\"delay\"> <value> [repeat_count] (sends adc_rd command with repeat count, defaults to 0)"}},
+  {"adc_set_avg", cmd_adc_set_avg, {2, 2, {-1}, "Set ADC averaging for later ADC reads: <board> <reads> (reads per channel averaged in hardware, a power of two from 1 to 256)"}},
+  {"adc_set_frame", cmd_adc_set_frame, {2, 2, {-1}, "Set ADC framing: <board> <frame_length> (a sequence-numbered marker after every frame_length data words, 1 to 511, 0 for off; file streams check the markers, strip them and log any gaps)"}},
+  {"adc_frame_sts", cmd_adc_frame_sts, {0, 1, {-1}, "Show frame check counters of the ADC file streams: [board] (live while a stream runs; all boards by default)"}},
+  {"do_adc_rd", cmd_do_adc_rd, {3, 5, {-1}, "Perform ADC read: <board> <\"trig\"|\"delay\"> <value> [repeat_count] [avg] (sends adc_rd command with repeat count, defaults to 0; delay in cycles, a time like 10us, or min; avg averages that many reads per channel in hardware, a power of two up to 256)"}},
   {"do_adc_rd_ch", cmd_do_adc_rd_ch, {1, 2, {-1}, "Read ADC single channel: <channel> [repeat_count] (channel 0-63, board=ch/8, ch=ch%8, repeat_count defaults to 0)"}},
-  {"stream_adc_data_to_file", cmd_stream_adc_data_to_file, {3, 3, {FLAG_BIN, -1}, "Start ADC data streaming to file: <board> <word_count> <file_path> [--bin]"}},
+  {"stream_adc_data_to_file", cmd_stream_adc_data_to_file, {3, 3, {FLAG_BIN, FLAG_CAL, -1}, "Start ADC data streaming to file: <board> <word_count> <file_path> [--bin] [--cal] (--cal applies the cal_fit/find_bias corrections, assuming ADC_RD data in default channel order)"}},
   {"stream_adc_commands_from_file", cmd_stream_adc_commands_from_file, {2, 3, {FLAG_SIMPLE, -1}, "Start ADC command streaming from file: <board> <file_path> [iterations] [--simple] (supports * wildcards, iterations defaults to 1)"}},
+  {"stream_adc_data_to_shm", cmd_stream_adc_data_to_shm, {1, 2, {-1}, "Start ADC data streaming into shared memory ring /shim_adc<board>: <board> [ring_words] (ring_words must be a power of two, stop with stop_adc_data_stream; read it with shim-ring-read <board>)"}},
   {"stop_adc_data_stream", cmd_stop_adc_data_stream, {1, 1, {-1}, "Stop ADC data streaming for specified board (0-7)"}},
   {"stop_adc_cmd_stream", cmd_stop_adc_cmd_stream, {1, 1, {-1}, "Stop ADC command streaming for specified board (0-7)"}},
   
@@ -106,6 +119,7 @@ static command_entry_t command_table[] = {
   {"force_trig", cmd_trig_force_trig, {0, 1, {-1}, "Send trigger force trigger command [log]"}},
   {"trig_cancel", cmd_trig_cancel, {0, 0, {-1}, "Send trigger cancel command"}},
   {"trig_reset_count", cmd_trig_reset_count, {0, 0, {-1}, "Reset trigger counter and timer to zero"}},
+  {"trig_log_format", cmd_trig_log_format, {0, 1, {-1}, "Show or set the trigger data format: [full|delta] (delta logs one 32-bit word per trigger with periodic full timestamps; resets the trigger count, data FIFO must be empty)"}},
   {"trig_count", cmd_trig_count, {0, 0, {-1}, "Show current trigger count"}},
   {"trig_set_lockout", cmd_trig_set_lockout, {1, 1, {-1}, "Send trigger set lockout command with cycles (1 - 0x0FFFFFFF)"}},
   {"trig_delay", cmd_trig_delay, {1, 1, {-1}, "Send trigger delay command with cycles (0 - 0x0FFFFFFF)"}},
@@ -120,9 +134,21 @@ static command_entry_t command_table[] = {
   {"print_adc_bias", cmd_print_adc_bias, {0, 0, {-1}, "Print current ADC bias values for all channels"}},
   {"save_adc_bias", cmd_save_adc_bias, {1, 1, {-1}, "Save ADC bias values to CSV file: <filename>"}},
   {"load_adc_bias", cmd_load_adc_bias, {1, 1, {-1}, "Load ADC bias values from CSV file: <filename>"}},
+  {"cal_fit", cmd_cal_fit, {0, 2, {FLAG_NO_RESET, -1}, "Fit per-channel DAC->ADC gain/offset correction tables from a hardware-timed sweep of all connected channels: [order] [span] (order 1 = gain/offset (default), 2 = quadratic; span = max DAC code, default 3276) [--no_reset]"}},
+  {"print_cal", cmd_print_cal, {0, 0, {-1}, "Print the fitted DAC->ADC correction table for all channels"}},
+  {"clear_cal", cmd_clear_cal, {0, 0, {-1}, "Discard all fitted DAC->ADC corrections"}},
+  {"load_preemph", cmd_load_preemph, {1, 1, {-1}, "Load per-channel eddy-current pre-emphasis applied to DAC waveform files (stream_dac_commands_from_file, waveform_test) with a clipping report: <file> (lines of '<channel|*> <amplitude> <tau>', up to 4 terms per channel, optional 'trigger_hold <time>' for trigger waits)"}},
+  {"print_preemph", cmd_print_preemph, {0, 0, {-1}, "Print the loaded pre-emphasis coefficients"}},
+  {"clear_preemph", cmd_clear_preemph, {0, 0, {-1}, "Discard the pre-emphasis (waveforms are played verbatim)"}},
+  {"save_cal", cmd_save_cal, {0, 1, {-1}, "Save every board's calibration (ADC bias, DAC offsets, DAC->ADC fits, with timestamps) to a calibration store: [file] (default: the session's store, saved automatically after each calibration)"}},
+  {"load_cal", cmd_load_cal, {0, 1, {-1}, "Load a calibration store and write its DAC offsets to the running hardware: [file] (default: the session's store, loaded at startup)"}},
+  {"cal_verify", cmd_cal_verify, {0, 1, {FLAG_NO_RESET, -1}, "Quick three-point drift check of every calibrated channel against its stored calibration: [tolerance] (DAC codes, default 32) [--no_reset]"}},
+  {"crosstalk", cmd_crosstalk, {1, 4, {FLAG_BIN, FLAG_NO_RESET, -1}, "Measure the channel coupling matrix: drive every connected channel to +/-amplitude in turn (hardware-timed) and read all channels: <file> [amplitude] [samples] [settle] (amps, default 1.0; reads per polarity, default 4; settle default 1ms) [--bin] [--no_reset]"}},
   {"waveform_test", cmd_waveform_test, {0, 0, {FLAG_NO_RESET, FLAG_NO_CAL, -1}, "Interactive waveform test: prompts for DAC/ADC files, iterations, output file, and trigger lockout [--no_reset] [--no_cal]"}},
-  {"fieldmap", cmd_fieldmap, {0, 0, {FLAG_NO_RESET, FLAG_NO_CAL, -1}, "Interactive fieldmap data collection: prompts for channel range, amplitude, delay, and log file [--no_reset] [--no_cal]"}},
+  {"fieldmap", cmd_fieldmap, {0, 0, {FLAG_NO_RESET, FLAG_NO_CAL, -1}, "Interactive fieldmap data collection: prompts for channel range, amplitude, delay, trigger lockout (0 for internally timed steps), and log file; the whole sweep runs from precomputed command streams [--no_reset] [--no_cal]"}},
   {"stop_fieldmap", cmd_stop_fieldmap, {0, 0, {-1}, "Stop fieldmap data collection"}},
+  {"regulate", cmd_regulate, {3, 7, {FLAG_NO_RESET, -1}, "Closed-loop current regulation: hold channels at a target with a per-channel fixed-point PI loop on a real-time thread, reporting loop jitter and read-to-write latency: <first_ch> <last_ch> <target_amps> [period] [kp] [ki] [duration] (period default 1ms; kp 0.2, ki 0.05; duration default until stop_regulate) [--no_reset]"}},
+  {"stop_regulate", cmd_stop_regulate, {0, 0, {-1}, "Stop closed-loop regulation and print its timing report"}},
   {"stop_trigger_monitor", cmd_stop_trigger_monitor, {0, 0, {-1}, "Stop trigger monitoring thread"}},
   {"stop_waveform", cmd_stop_waveform, {0, 0, {-1}, "Stop waveform test - stops all streaming and monitoring"}},
   {"rev_c_compat", cmd_rev_c_compat, {0, 0, {FLAG_BIN, FLAG_NO_RESET, -1}, "Interactive Rev C compatibility mode: prompts for DAC file, iterations, output file, and delay [--bin] [--no_reset]"}},
@@ -132,6 +158,7 @@ static command_entry_t command_table[] = {
   {"log_commands", cmd_log_commands, {1, 1, {-1}, "Start logging commands to file: <file_path>"}},
   {"stop_log", cmd_stop_log, {0, 0, {-1}, "Stop logging commands"}},
   {"load_commands", cmd_load_commands, {1, 1, {-1}, "Load and execute commands from file: <file_path> (0.25s delay between commands, supports * wildcards)"}},
+  {"replay_commands", cmd_replay_commands, {1, 2, {-1}, "Replay a command log with its original timing: <file_path> [speed] (speed 1 = original, 10 = 10x faster, 0 or \"max\" = as fast as possible; reports timing drift, supports * wildcards)"}},
   
   // Sentinel entry - marks end of table (must be last)
   {NULL, NULL, {0, 0, {-1}, NULL}}
@@ -140,14 +167,30 @@ static command_entry_t command_table[] = {
 // Forward declarations for helper functions
 static void print_wrapped_line(const char* prefix, const char* text, const char* continuation_indent);
 
-// Log command if logging is enabled
-void log_command_if_enabled(command_context_t* ctx, const char* command_line) {
+// Seconds elapsed between two monotonic timestamps
+static double timespec_diff_s(const struct timespec* start, const struct timespec* end) {
+  return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Log a command before it runs (if logging is enabled), with its start time relative to the log start
+void log_command_start(command_context_t* ctx, const char* command_line, const struct timespec* start_time) {
   if (ctx->logging_enabled && ctx->log_file != NULL) {
+    fprintf(ctx->log_file, "%s%.6f\n", LOG_ENTRY_PREFIX, timespec_diff_s(&ctx->log_start_time, start_time));
     fprintf(ctx->log_file, "%s\n", command_line);
     fflush(ctx->log_file);
   }
 }
 
+// Log the result and duration of the command logged last
+void log_command_result(command_context_t* ctx, const struct timespec* start_time, int result) {
+  if (ctx->logging_enabled && ctx->log_file != NULL) {
+    struct timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    fprintf(ctx->log_file, "%src=%d %.6f s\n", LOG_RESULT_PREFIX, result, timespec_diff_s(start_time, &end_time));
+    fflush(ctx->log_file);
+  }
+}
+
 int cmd_log_commands(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   // Stop current logging if active
   if (ctx->logging_enabled && ctx->log_file != NULL) {
@@ -171,6 +214,12 @@ int cmd_log_commands(const char** args, int arg_count, const command_flag_t* fla
   // Set file permissions for group access
   set_file_permissions(full_path, *(ctx->verbose));
   
+  // Entry timestamps are relative to now
+  clock_gettime(CLOCK_MONOTONIC, &ctx->log_start_time);
+  fprintf(ctx->log_file, "# shim-test command log (%s<seconds since log start> precedes each command, %src=<result> <duration> s follows it)\n",
+          LOG_ENTRY_PREFIX, LOG_RESULT_PREFIX);
+  fflush(ctx->log_file);
+  
   ctx->logging_enabled = true;
   printf("Started logging commands to file '%s'\n", full_path);
   return 0;
@@ -192,7 +241,7 @@ int cmd_stop_log(const char** args, int arg_count, const command_flag_t* flags,
 int cmd_load_commands(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   // Resolve file pattern (handles glob patterns)
   char resolved_path[1024];
-  if (resolve_file_pattern(args[0], resolved_path, sizeof(resolved_path)) != 0) {
+  if (resolve_file_pattern(args[0], resolved_path, sizeof(resolved_path), ctx->in) != 0) {
     return -1;
   }
   
@@ -251,6 +300,183 @@ int cmd_load_commands(const char** args, int arg_count, const command_flag_t* fl
   return 0;
 }
 
+// Replay a command log, reproducing the original inter-command timing (optionally scaled)
+int cmd_replay_commands(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  // A log that replays itself (or a replay that replays another) would never end
+  if (ctx->replay_active) {
+    fprintf(stderr, "replay_commands can't be run from a replayed command log.\n");
+    return -1;
+  }
+  
+  // Parse speed factor: 1 = original timing, 10 = 10x faster, 0 or "max" = as fast as possible
+  double speed = 1.0;
+  if (arg_count > 1) {
+    if (strcmp(args[1], "max") == 0) {
+      speed = 0.0;
+    } else {
+      char* endptr;
+      speed = strtod(args[1], &endptr);
+      if (*endptr != '\0' || speed < 0.0) {
+        fprintf(stderr, "Invalid speed for replay_commands: '%s'. Must be a non-negative number or 'max'.\n", args[1]);
+        return -1;
+      }
+    }
+  }
+  
+  char resolved_path[1024];
+  if (resolve_file_pattern(args[0], resolved_path, sizeof(resolved_path), ctx->in) != 0) {
+    return -1;
+  }
+  
+  FILE* file = fopen(resolved_path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open command file '%s' for reading: %s\n", resolved_path, strerror(errno));
+    return -1;
+  }
+  
+  if (speed == 0.0) {
+    printf("Replaying commands from file '%s' as fast as possible...\n", resolved_path);
+  } else {
+    printf("Replaying commands from file '%s' at %.3gx speed...\n", resolved_path, speed);
+  }
+  
+  char line[256];
+  int line_number = 0;
+  int commands_executed = 0;
+  int result_mismatches = 0;
+  
+  // Timing of the current entry as recorded in the log (untimed logs get the load_commands 0.25s gap)
+  bool have_entry_time = false;
+  bool have_entry_result = false;
+  double entry_time = 0.0;
+  int entry_result = 0;
+  double last_original_time = 0.0;
+  double first_original_time = -1.0;
+  
+  double max_drift = 0.0;              // Drift with the largest magnitude (late or early)
+  double sum_abs_drift = 0.0;
+  
+  struct timespec replay_start;
+  clock_gettime(CLOCK_MONOTONIC, &replay_start);
+  ctx->replay_active = true;
+  
+  while (fgets(line, sizeof(line), file) != NULL) {
+    line_number++;
+    
+    // Remove newline character
+    size_t len = strlen(line);
+    if (len > 0 && line[len - 1] == '\n') {
+      line[len - 1] = '\0';
+    }
+    
+    // Pick up timing metadata from the log entry header
+    // (older logs carry the result there too: "# @<seconds> rc=<result>")
+    if (strncmp(line, LOG_ENTRY_PREFIX, strlen(LOG_ENTRY_PREFIX)) == 0) {
+      int fields = sscanf(line + strlen(LOG_ENTRY_PREFIX), "%lf rc=%d", &entry_time, &entry_result);
+      have_entry_time = fields >= 1;
+      have_entry_result = fields == 2;
+      continue;
+    }
+    
+    // Skip empty lines and lines starting with # (comments)
+    if (strlen(line) == 0 || line[0] == '#') {
+      continue;
+    }
+    
+    if (!have_entry_time) {
+      entry_time = (commands_executed == 0) ? 0.0 : last_original_time + 0.25;
+      entry_result = 0;
+      have_entry_result = true; // Plain command files are expected to succeed
+    }
+    
+    // The result follows the command line in current logs
+    long next_line_pos = ftell(file);
+    char result_line[256];
+    bool read_result_line = false;
+    if (fgets(result_line, sizeof(result_line), file) != NULL &&
+        strncmp(result_line, LOG_RESULT_PREFIX, strlen(LOG_RESULT_PREFIX)) == 0) {
+      if (sscanf(result_line + strlen(LOG_RESULT_PREFIX), "rc=%d", &entry_result) == 1) {
+        have_entry_result = true;
+      }
+      read_result_line = true;
+    } else {
+      fseek(file, next_line_pos, SEEK_SET);
+    }
+    if (first_original_time < 0.0) {
+      first_original_time = entry_time;
+    }
+    double original_offset = entry_time - first_original_time;
+    last_original_time = entry_time;
+    
+    // Wait until this command's scheduled time in the replay
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double scheduled = (speed == 0.0) ? 0.0 : original_offset / speed;
+    double elapsed = timespec_diff_s(&replay_start, &now);
+    if (scheduled > elapsed) {
+      usleep((useconds_t)((scheduled - elapsed) * 1e6));
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      elapsed = timespec_diff_s(&replay_start, &now);
+    }
+    
+    // Drift is measured against the scaled original schedule
+    double drift = (speed == 0.0) ? 0.0 : elapsed - scheduled;
+    double abs_drift = (drift >= 0.0) ? drift : -drift;
+    if (abs_drift > ((max_drift >= 0.0) ? max_drift : -max_drift)) max_drift = drift;
+    sum_abs_drift += abs_drift;
+    
+    if (*(ctx->verbose)) {
+      printf("Replaying line %d at %.6f s (scheduled %.6f s, drift %+.3f ms): %s\n",
+             line_number, elapsed, scheduled, drift * 1e3, line);
+    } else {
+      printf("Replaying line %d: %s\n", line_number, line);
+    }
+    
+    int result = execute_command(line, ctx);
+    commands_executed++;
+    have_entry_time = false;
+    
+    if (!have_entry_result) {
+      printf("Line %d has no logged result (the logged session ended during it)\n", line_number);
+    } else if (result != entry_result) {
+      result_mismatches++;
+      printf("Line %d returned %d (logged result was %d)\n", line_number, result, entry_result);
+      // A command that originally succeeded now failing leaves the system in an unknown state
+      if (entry_result == 0) {
+        printf("Stopping replay at line %d.\n", line_number);
+        break;
+      }
+    }
+    
+    have_entry_result = false;
+    if (read_result_line) line_number++;
+    
+    if (*(ctx->should_exit)) {
+      break;
+    }
+  }
+  
+  ctx->replay_active = false;
+  fclose(file);
+  
+  struct timespec replay_end;
+  clock_gettime(CLOCK_MONOTONIC, &replay_end);
+  double replay_duration = timespec_diff_s(&replay_start, &replay_end);
+  double original_duration = (first_original_time < 0.0) ? 0.0 : last_original_time - first_original_time;
+  
+  printf("Replayed %d commands from file '%s'.\n", commands_executed, resolved_path);
+  printf("  Original span (first to last command start): %.6f s\n", original_duration);
+  printf("  Replay duration:                            %.6f s\n", replay_duration);
+  if (speed != 0.0 && commands_executed > 0) {
+    printf("  Start time drift: max %+.3f ms, mean |drift| %.3f ms\n", max_drift * 1e3, sum_abs_drift / commands_executed * 1e3);
+  }
+  if (result_mismatches > 0) {
+    printf("  %d command(s) returned a different result than logged\n", result_mismatches);
+    return -1;
+  }
+  return 0;
+}
+
 // Helper function for printing wrapped lines
 static void print_wrapped_line(const char* prefix, const char* text, const char* continuation_indent) {
   const int max_line_length = 80;
@@ -356,6 +582,12 @@ void print_command_help(const char* command_name) {
         case FLAG_NO_RESET:
           printf(" --no_reset");
           break;
+        case FLAG_NO_CAL:
+          printf(" --no_cal");
+          break;
+        case FLAG_CAL:
+          printf(" --cal");
+          break;
       }
     }
     printf("\n");
@@ -440,7 +672,11 @@ void print_help(void) {
         strstr(command_table[i].name, "waveform_test") || strstr(command_table[i].name, "fieldmap") ||
         strstr(command_table[i].name, "stop_fieldmap") || strstr(command_table[i].name, "stop_trigger_monitor") ||
         strstr(command_table[i].name, "stop_waveform") || strstr(command_table[i].name, "rev_c_compat") ||
-        strstr(command_table[i].name, "zero_all_dacs")) {
+        strstr(command_table[i].name, "zero_all_dacs") || strstr(command_table[i].name, "cal_fit") ||
+        strstr(command_table[i].name, "print_cal") || strstr(command_table[i].name, "clear_cal") ||
+        strstr(command_table[i].name, "save_cal") || strstr(command_table[i].name, "load_cal") ||
+        strstr(command_table[i].name, "cal_verify") || strstr(command_table[i].name, "crosstalk") ||
+        strstr(command_table[i].name, "regulate") || strstr(command_table[i].name, "preemph")) {
       char prefix[32];
       snprintf(prefix, sizeof(prefix), "  %-20s ", command_table[i].name);
       print_wrapped_line(prefix, command_table[i].info.description, "                         ");
@@ -451,7 +687,7 @@ void print_help(void) {
   printf("\nLogging and Loading Commands:\n");
   for (int i = 0; i < total_commands; i++) {
     if (strstr(command_table[i].name, "log_commands") || strstr(command_table[i].name, "stop_log") ||
-        strstr(command_table[i].name, "load_commands")) {
+        strstr(command_table[i].name, "load_commands") || strstr(command_table[i].name, "replay_commands")) {
       char prefix[32];
       snprintf(prefix, sizeof(prefix), "  %-20s ", command_table[i].name);
       print_wrapped_line(prefix, command_table[i].info.description, "                         ");
@@ -513,6 +749,8 @@ int parse_command_line(const char* line, const char** args, int* arg_count, comm
         flags[(*flag_count)++] = FLAG_NO_RESET;
       } else if (strcmp(token, "--no_cal") == 0) {
         flags[(*flag_count)++] = FLAG_NO_CAL;
+      } else if (strcmp(token, "--cal") == 0) {
+        flags[(*flag_count)++] = FLAG_CAL;
       } else {
         // Unknown flag - return error
         printf("Error: Unknown flag '%s'\n", token);
@@ -590,6 +828,7 @@ int execute_command(const char* line, command_context_t* ctx) {
         case FLAG_BIN: flag_name = "--bin"; break;
         case FLAG_NO_RESET: flag_name = "--no_reset"; break;
         case FLAG_NO_CAL: flag_name = "--no_cal"; break;
+        case FLAG_CAL: flag_name = "--cal"; break;
       }
       printf("Error: Command '%s' does not accept flag '%s'\n", args[0], flag_name);
       printf("\n");
@@ -598,9 +837,25 @@ int execute_command(const char* line, command_context_t* ctx) {
     }
   }
   
-  // Log command if enabled
-  log_command_if_enabled(ctx, line);
+  // Log top-level commands only (commands run by load/replay are covered by that line),
+  // and never the logging commands themselves so a replay can't truncate its own log.
+  // The line is flushed before the command runs so a command that hangs or crashes is on record.
+  struct timespec start_time;
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+  FILE* logged_to = NULL;
+  if (ctx->command_depth == 0 && cmd->handler != cmd_log_commands && cmd->handler != cmd_stop_log) {
+    log_command_start(ctx, line, &start_time);
+    logged_to = ctx->logging_enabled ? ctx->log_file : NULL;
+  }
+  
+  ctx->command_depth++;
+  int result = cmd->handler(&args[1], cmd_args, flags, flag_count, ctx);
+  ctx->command_depth--;
+  
+  // Only complete the entry in the log it was started in
+  if (logged_to != NULL && ctx->logging_enabled && ctx->log_file == logged_to) {
+    log_command_result(ctx, &start_time, result);
+  }
   
-  // Execute command
-  return cmd->handler(&args[1], cmd_args, flags, flag_count, ctx);
+  return result;
 }
@@ -41,7 +41,7 @@ int has_flag(const command_flag_t* flags, int flag_count, command_flag_t target_
 }
 
 // Resolve file patterns with glob wildcards
-int resolve_file_pattern(const char* pattern, char* resolved_path, size_t resolved_path_size) {
+int resolve_file_pattern(const char* pattern, char* resolved_path, size_t resolved_path_size, FILE* in) {
   glob_t glob_result;
   
   // Try to expand the pattern
@@ -65,14 +65,14 @@ int resolve_file_pattern(const char* pattern, char* resolved_path, size_t resolv
       fflush(stdout);
       
       int choice;
-      if (scanf("%d", &choice) != 1 || choice < 1 || choice > (int)glob_result.gl_pathc) {
+      if (fscanf(in, "%d", &choice) != 1 || choice < 1 || choice > (int)glob_result.gl_pathc) {
         printf("Invalid choice. Using first match: %s\n", glob_result.gl_pathv[0]);
         choice = 1;
       }
       
       // Clear remaining characters from input buffer (including newline)
       int c;
-      while ((c = getchar()) != '\n' && c != EOF);
+      while ((c = fgetc(in)) != '\n' && c != EOF);
       
       // Use the selected match (convert to 0-based index)
       strncpy(resolved_path, glob_result.gl_pathv[choice - 1], resolved_path_size - 1);
@@ -91,8 +91,8 @@ int resolve_file_pattern(const char* pattern, char* resolved_path, size_t resolv
   }
 }
 
-int resolve_file_path(const char* pattern, char* resolved_path, size_t resolved_path_size) {
-  return resolve_file_pattern(pattern, resolved_path, resolved_path_size);
+int resolve_file_path(const char* pattern, char* resolved_path, size_t resolved_path_size, FILE* in) {
+  return resolve_file_pattern(pattern, resolved_path, resolved_path_size, in);
 }
 
 // Parse trigger mode string ("trig" or "delay") into boolean and validate value
@@ -143,6 +143,51 @@ int validate_channel_number(const char* channel_str, int* board, int* channel) {
   return 0;
 }
 
+// SPI command timing for the SPI clock frequency the hardware measures
+struct spi_timing_t get_spi_timing(command_context_t* ctx) {
+  return create_spi_timing(sys_sts_get_spi_clk_freq_hz(ctx->sys_sts, false));
+}
+
+// Check a delay against the minimum spacing the timing_calc cores enforce, or -1 if it would halt the system
+static int validate_min_delay(const struct spi_timing_t* timing, uint32_t delay_cycles, uint32_t min_cycles, const char* cmd_name) {
+  if (!spi_timing_valid(timing)) {
+    printf("Warning: SPI clock frequency is unavailable, cannot check the %s delay of %u cycles\n", cmd_name, delay_cycles);
+    return 0;
+  }
+  if (delay_cycles < min_cycles) {
+    printf("Error: %s delay of %u cycles (%.1f ns) is shorter than the minimum of %u cycles (%.1f ns at %.3f MHz)\n",
+           cmd_name, delay_cycles, spi_timing_cycles_to_ns(timing, delay_cycles),
+           min_cycles, spi_timing_cycles_to_ns(timing, min_cycles), timing->spi_clk_freq_hz / 1e6);
+    return -1;
+  }
+  return 0;
+}
+
+// Validate the delay of a DAC write (all channels)
+int validate_dac_wr_delay(const struct spi_timing_t* timing, uint32_t delay_cycles) {
+  return validate_min_delay(timing, delay_cycles, timing->dac_wr_min_delay, "DAC write");
+}
+
+// Validate the delay of an ADC read (all channels)
+int validate_adc_rd_delay(const struct spi_timing_t* timing, uint32_t delay_cycles) {
+  return validate_min_delay(timing, delay_cycles, timing->adc_rd_min_delay, "ADC read");
+}
+
+// Validate the delay of an averaged ADC read (2^avg_log2 reads per channel)
+int validate_adc_rd_avg_delay(const struct spi_timing_t* timing, uint32_t delay_cycles, uint8_t avg_log2) {
+  return validate_min_delay(timing, delay_cycles, spi_timing_adc_rd_avg_min_delay(timing, avg_log2), "averaged ADC read");
+}
+
+// ADC correction for captured data (fitted entries, else offset-only from the ADC bias)
+void get_adc_correction(command_context_t* ctx, struct cal_table_t* table) {
+  *table = ctx->adc_cal;
+  for (int ch = 0; ch < CAL_TABLE_CHANNELS; ch++) {
+    if (!cal_table_channel_valid(table, ch) && ctx->adc_bias_valid[ch]) {
+      cal_table_set_offset(table, ch, ctx->adc_bias[ch]);
+    }
+  }
+}
+
 // Print 64-bit trigger data breakdown
 void print_trigger_data(uint64_t data) {
   uint32_t low_word = data & 0xFFFFFFFF;
@@ -202,7 +247,7 @@ void set_file_permissions(const char* file_path, bool verbose) {
 
 // Prompt user for file selection with optional default
 int prompt_file_selection(const char* prompt_text, const char* default_file,
-                         char* resolved_path, size_t resolved_path_size) {
+                         char* resolved_path, size_t resolved_path_size, FILE* in) {
   char input_buffer[1024];
   
   // Display prompt with default if provided
@@ -214,7 +259,7 @@ int prompt_file_selection(const char* prompt_text, const char* default_file,
   fflush(stdout);
   
   // Read user input
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), in) == NULL) {
     fprintf(stderr, "Failed to read file input.\n");
     return -1;
   }
@@ -241,7 +286,7 @@ int prompt_file_selection(const char* prompt_text, const char* default_file,
   }
   
   // Resolve the input pattern/path
-  if (resolve_file_pattern(input_buffer, resolved_path, resolved_path_size) != 0) {
+  if (resolve_file_pattern(input_buffer, resolved_path, resolved_path_size, in) != 0) {
     fprintf(stderr, "Failed to resolve file pattern: '%s'\n", input_buffer);
     return -1;
   }
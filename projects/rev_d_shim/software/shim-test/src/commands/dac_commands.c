@@ -9,17 +9,29 @@
 #include <errno.h>
 #include <pthread.h>
 #include <glob.h>
+#include <time.h>
 #include "dac_commands.h"
 #include "command_helper.h"
 #include "system_commands.h"
 #include "sys_sts.h"
 #include "sys_ctrl.h"
 #include "dac_ctrl.h"
+#include "waveform_pack.h"
+#include "dac_ddr_buf.h"
+#include "integ_model.h"
 
 // Local helper function to check if system is running
 static int validate_system_running(command_context_t* ctx);
 // DAC debug streaming thread function
 static void* dac_debug_stream_thread(void* arg);
+static bool dac_ddr_playing(command_context_t* ctx, int board);
+
+// Whether a board's DDR reader is still feeding its command FIFO
+static bool dac_ddr_playing(command_context_t* ctx, int board) {
+  if (!ctx->dac_ddr_buf->present) return false;
+  uint32_t sts = dac_ddr_buf_status(ctx->dac_ddr_buf, (uint8_t)board);
+  return DAC_DDR_STS_ENABLED(sts) && !DAC_DDR_STS_EMPTY(sts);
+}
 
 static int validate_system_running(command_context_t* ctx) {
   uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, *(ctx->verbose));
@@ -212,7 +224,18 @@ int cmd_do_dac_wr(const char** args, int arg_count, const command_flag_t* flags,
   
   bool is_trigger;
   uint32_t value;
-  if (parse_trigger_mode(args[9], args[10], &is_trigger, &value) < 0) {
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  if (strcmp(args[9], "delay") == 0) {
+    // Delays may be given in cycles, as a time (e.g. "10us"), or as "min"
+    is_trigger = false;
+    if (spi_timing_parse_delay(&timing, args[10], timing.dac_wr_min_delay, &value) < 0) {
+      fprintf(stderr, "Invalid delay for do_dac_wr: '%s'. Use cycles (max 0x1FFFFFF), a time with ns/us/ms/s, or 'min'.\n", args[10]);
+      return -1;
+    }
+    if (validate_dac_wr_delay(&timing, value) < 0) {
+      return -1;
+    }
+  } else if (parse_trigger_mode(args[9], args[10], &is_trigger, &value) < 0) {
     return -1;
   }
   
@@ -369,36 +392,48 @@ int cmd_get_dac_cal(const char** args, int arg_count, const command_flag_t* flag
   }
   usleep(10000); // 10ms to let cancel commands complete
   
-  // Iterate through all channels to get calibration values
+  // Read the calibration values with one GET_CAL in flight per board: each round sends the
+  // same channel to every board, then collects the replies as they arrive
+  uint32_t cal_data_words[64];
+  bool cal_data_valid[64] = {false};
+  for (int channel = 0; channel < 8; channel++) {
+    bool pending[8] = {false};
+    int pending_count = 0;
+    for (int board = 0; board < 8; board++) {
+      int ch = board * 8 + channel;
+      if (!connected_boards[board] || ch < start_ch || ch > end_ch) continue;
+      dac_cmd_get_cal(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, *(ctx->verbose));
+      pending[board] = true;
+      pending_count++;
+    }
+
+    for (int tries = 0; pending_count > 0 && tries < 100; tries++) {
+      for (int board = 0; board < 8; board++) {
+        if (!pending[board]) continue;
+        uint32_t dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, *(ctx->verbose));
+        if (FIFO_STS_WORD_COUNT(dac_data_fifo_status) > 0) {
+          cal_data_words[board * 8 + channel] = dac_read_data(ctx->dac_ctrl, (uint8_t)board);
+          cal_data_valid[board * 8 + channel] = true;
+          pending[board] = false;
+          pending_count--;
+        }
+      }
+      if (pending_count > 0) usleep(100); // 0.1ms
+    }
+  }
+
+  // Print in channel order
   for (int ch = start_ch; ch <= end_ch; ch++) {
-    int board, channel;
-    board = ch / 8;
-    channel = ch % 8;
-    
     // If getting all channels, skip boards that are not connected
-    if (get_all && !connected_boards[board]) {
+    if (get_all && !connected_boards[ch / 8]) {
       continue;
     }
     
     if (get_all) {
       printf("Ch %02d : ", ch);
-      fflush(stdout);
-    }
-    
-    // Send get_cal command
-    dac_cmd_get_cal(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, *(ctx->verbose));
-    
-    // Read calibration data once available
-    int tries = 0;
-    uint32_t dac_data_fifo_status;
-    while (tries < 100) {
-      dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, *(ctx->verbose));
-      if (FIFO_STS_WORD_COUNT(dac_data_fifo_status) > 0) break;
-      usleep(100); // 0.1ms
-      tries++;
     }
     
-    if (FIFO_STS_WORD_COUNT(dac_data_fifo_status) == 0) {
+    if (!cal_data_valid[ch]) {
       if (get_all) {
         printf("No data available\n");
       } else {
@@ -408,12 +443,11 @@ int cmd_get_dac_cal(const char** args, int arg_count, const command_flag_t* flag
       continue;
     }
     
-    // Read and print calibration data
-    uint32_t cal_data_word = dac_read_data(ctx->dac_ctrl, (uint8_t)board);
+    // Print calibration data
     if (!get_all && *(ctx->verbose)) {
       printf("  ");
     }
-    printf("%s\n", dac_format_data(cal_data_word, *(ctx->verbose)));
+    printf("%s\n", dac_format_data(cal_data_words[ch], *(ctx->verbose)));
   }
   
   if (*(ctx->verbose)) {
@@ -480,16 +514,80 @@ int cmd_set_dac_cal(const char** args, int arg_count, const command_flag_t* flag
   printf("Setting DAC calibration for channel %d (board %d, channel %d) to %ld...\n", 
          atoi(args[0]), board, channel, cal_value);
   
-  // Send the set_cal command
+  // Send the set_cal command and remember it for the calibration store
   dac_cmd_set_cal(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, (int16_t)cal_value, *(ctx->verbose));
+  int ch = board * 8 + channel;
+  ctx->dac_cal[ch] = (int16_t)cal_value;
+  ctx->dac_cal_valid[ch] = true;
+  ctx->dac_cal_time[board] = (int64_t)time(NULL);
   
   printf("DAC calibration set for channel %d (board %d, channel %d) to %ld.\n", 
          atoi(args[0]), board, channel, cal_value);
   return 0;
 }
 
+// Push the remembered DAC offsets to the hardware: one SET_CAL burst per board, then one
+// GET_CAL burst to read every value back
+int push_dac_cal(command_context_t* ctx) {
+  uint8_t masks[8] = {0};
+  int expected[8] = {0};
+  int pushed = 0;
+  for (int board = 0; board < 8; board++) {
+    uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+    uint32_t dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+    if (!FIFO_PRESENT(dac_cmd_fifo_status) || !FIFO_PRESENT(dac_data_fifo_status)) continue;
+    for (int channel = 0; channel < 8; channel++) {
+      if (ctx->dac_cal_valid[board * 8 + channel]) {
+        masks[board] |= (uint8_t)(1u << channel);
+        expected[board]++;
+      }
+    }
+    if (masks[board] == 0) continue;
+    dac_cmd_set_cal_batch(ctx->dac_ctrl, (uint8_t)board, &ctx->dac_cal[board * 8], masks[board], *(ctx->verbose));
+    dac_cmd_get_cal_batch(ctx->dac_ctrl, (uint8_t)board, masks[board], *(ctx->verbose));
+    pushed += expected[board];
+  }
+
+  // Confirm each board's readback
+  int mismatches = 0;
+  for (int board = 0; board < 8; board++) {
+    if (masks[board] == 0) continue;
+    int tries = 0;
+    while (FIFO_STS_WORD_COUNT(sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false)) < (uint32_t)expected[board] &&
+           tries++ < 1000) {
+      usleep(100); // 0.1ms
+    }
+    for (int n = 0; n < expected[board]; n++) {
+      if (FIFO_STS_WORD_COUNT(sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false)) == 0) {
+        fprintf(stderr, "DAC board %d: only %d of %d calibration values read back\n", board, n, expected[board]);
+        mismatches += expected[board] - n;
+        break;
+      }
+      uint32_t word = dac_read_data(ctx->dac_ctrl, (uint8_t)board);
+      int ch = board * 8 + DAC_CAL_DATA_CH(word);
+      if (DAC_DATA_CODE(word) != DAC_CAL_DATA || DAC_CAL_DATA_VAL(word) != ctx->dac_cal[ch]) {
+        fprintf(stderr, "DAC board %d: unexpected calibration readback 0x%08X (channel %d should be %d)\n",
+                board, word, ch, ctx->dac_cal[ch]);
+        mismatches++;
+      }
+    }
+  }
+  return mismatches == 0 ? pushed : -1;
+}
+
+// Parse the value field of a waveform line: a trigger count for T, or a delay for D
+// (cycles, a time like "10us", or "min" for the shortest delay the command allows)
+static int parse_waveform_value(const struct spi_timing_t* timing, char mode, const char* value_str, bool has_ch_vals, uint32_t* value) {
+  if (mode == 'T') {
+    char* endptr;
+    *value = parse_value(value_str, &endptr);
+    return (*endptr == '\0' && *value <= 0x1FFFFFF) ? 0 : -1;
+  }
+  return spi_timing_parse_delay(timing, value_str, has_ch_vals ? timing->dac_wr_min_delay : 0, value);
+}
+
 // Function to validate and parse a waveform file
-static int parse_waveform_file(const char* file_path, waveform_command_t** commands, int* command_count) {
+int parse_waveform_file(const char* file_path, const struct spi_timing_t* timing, waveform_command_t** commands, int* command_count) {
   FILE* file = fopen(file_path, "r");
   if (file == NULL) {
     fprintf(stderr, "Failed to open waveform file '%s': %s\n", file_path, strerror(errno));
@@ -500,6 +598,10 @@ static int parse_waveform_file(const char* file_path, waveform_command_t** comma
   char line[512];
   int line_num = 0;
   int valid_lines = 0;
+  int loop_line = 0;          // Line of the open L (0 if none)
+  uint32_t loop_words = 0;    // FIFO words in the open block
+  uint32_t loop_passes = 0;
+  int forever_line = 0;       // Line of an L that repeats until cancelled (nothing may follow its block)
   
   while (fgets(line, sizeof(line), file)) {
     line_num++;
@@ -511,19 +613,83 @@ static int parse_waveform_file(const char* file_path, waveform_command_t** comma
       continue;
     }
     
+    // L <passes> opens a block the DAC core replays from its loop buffer; E closes it
+    if (*trimmed == 'L' || *trimmed == 'E') {
+      char mode;
+      char value_str[64];
+      char extra[8];
+      int parsed = sscanf(trimmed, "%c %63s %7s", &mode, value_str, extra);
+      if (mode == 'L') {
+        char* endptr = NULL;
+        if (parsed == 2) loop_passes = parse_value(value_str, &endptr);
+        if (parsed != 2 || *endptr != '\0' || loop_passes > DAC_LOOP_PASSES_MAX) {
+          fprintf(stderr, "Invalid line %d: expected 'L <passes>' with passes 0 to %d (0 repeats until cancelled)\n",
+                  line_num, DAC_LOOP_PASSES_MAX);
+          fclose(file);
+          return -1;
+        }
+        if (loop_line != 0) {
+          fprintf(stderr, "Invalid line %d: loops can't be nested (loop opened on line %d)\n", line_num, loop_line);
+          fclose(file);
+          return -1;
+        }
+        if (forever_line != 0) {
+          fprintf(stderr, "Invalid line %d: nothing can follow the loop on line %d, which repeats until cancelled\n",
+                  line_num, forever_line);
+          fclose(file);
+          return -1;
+        }
+        loop_line = line_num;
+        loop_words = 0;
+      } else {
+        if (parsed != 1) {
+          fprintf(stderr, "Invalid line %d: 'E' takes no value\n", line_num);
+          fclose(file);
+          return -1;
+        }
+        if (loop_line == 0) {
+          fprintf(stderr, "Invalid line %d: 'E' without a matching 'L'\n", line_num);
+          fclose(file);
+          return -1;
+        }
+        if (loop_words == 0) {
+          fprintf(stderr, "Invalid line %d: loop opened on line %d is empty\n", line_num, loop_line);
+          fclose(file);
+          return -1;
+        }
+        if (loop_words > DAC_LOOP_WORDCOUNT) {
+          fprintf(stderr, "Invalid line %d: loop opened on line %d takes %u words, more than the %d word loop buffer\n",
+                  line_num, loop_line, loop_words, DAC_LOOP_WORDCOUNT);
+          fclose(file);
+          return -1;
+        }
+        if (loop_passes == 0) forever_line = loop_line;
+        loop_line = 0;
+      }
+      continue;
+    }
+    
     // Check if line starts with D or T
     if (*trimmed != 'D' && *trimmed != 'T') {
-      fprintf(stderr, "Invalid line %d: must start with 'D' or 'T'\n", line_num);
+      fprintf(stderr, "Invalid line %d: must start with 'D', 'T', 'L' or 'E'\n", line_num);
+      fclose(file);
+      return -1;
+    }
+    
+    if (forever_line != 0 && loop_line == 0) {
+      fprintf(stderr, "Invalid line %d: nothing can follow the loop on line %d, which repeats until cancelled\n",
+              line_num, forever_line);
       fclose(file);
       return -1;
     }
     
     // Parse the line to validate format
     char mode;
+    char value_str[64];
     uint32_t value;
     int16_t ch_vals[8];
-    int parsed = sscanf(trimmed, "%c %u %hd %hd %hd %hd %hd %hd %hd %hd", 
-                       &mode, &value, &ch_vals[0], &ch_vals[1], &ch_vals[2], &ch_vals[3],
+    int parsed = sscanf(trimmed, "%c %63s %hd %hd %hd %hd %hd %hd %hd %hd", 
+                       &mode, value_str, &ch_vals[0], &ch_vals[1], &ch_vals[2], &ch_vals[3],
                        &ch_vals[4], &ch_vals[5], &ch_vals[6], &ch_vals[7]);
     
     if (parsed < 2) {
@@ -538,9 +704,17 @@ static int parse_waveform_file(const char* file_path, waveform_command_t** comma
       return -1;
     }
     
-    // Validate value range
-    if (value > 0x1FFFFFF) {
-      fprintf(stderr, "Invalid line %d: value %u out of range (max 0x1FFFFFF or 33554431)\n", line_num, value);
+    // Validate value range (times need the SPI clock to convert to cycles)
+    if (parse_waveform_value(timing, mode, value_str, parsed == 10, &value) < 0) {
+      fprintf(stderr, "Invalid line %d: value '%s' must be 0 to 0x1FFFFFF (33554431) cycles%s\n", line_num, value_str,
+              (mode == 'D') ? ", a time with ns/us/ms/s, or 'min' (times need a running SPI clock)" : "");
+      fclose(file);
+      return -1;
+    }
+    
+    // Validate DAC write delays against the hardware's minimum command spacing
+    if (mode == 'D' && parsed == 10 && validate_dac_wr_delay(timing, value) < 0) {
+      fprintf(stderr, "Invalid line %d: DAC write delay too short\n", line_num);
       fclose(file);
       return -1;
     }
@@ -557,9 +731,16 @@ static int parse_waveform_file(const char* file_path, waveform_command_t** comma
       }
     }
     
+    if (loop_line != 0) loop_words += (parsed == 10) ? DAC_WR_WORDCOUNT : 1;
     valid_lines++;
   }
   
+  if (loop_line != 0) {
+    fprintf(stderr, "Invalid line %d: loop has no closing 'E'\n", loop_line);
+    fclose(file);
+    return -1;
+  }
+  
   if (valid_lines == 0) {
     fprintf(stderr, "No valid commands found in waveform file\n");
     fclose(file);
@@ -578,6 +759,8 @@ static int parse_waveform_file(const char* file_path, waveform_command_t** comma
   rewind(file);
   line_num = 0;
   int cmd_index = 0;
+  int loop_start = -1; // Command that opens the current block
+  bool loop_pending = false;
   
   while (fgets(line, sizeof(line), file)) {
     line_num++;
@@ -589,14 +772,36 @@ static int parse_waveform_file(const char* file_path, waveform_command_t** comma
       continue;
     }
     
+    // The block's first command carries its length and passes
+    if (*trimmed == 'L') {
+      char value_str[64];
+      sscanf(trimmed + 1, "%63s", value_str);
+      loop_passes = parse_value(value_str, NULL);
+      loop_pending = true;
+      continue;
+    }
+    if (*trimmed == 'E') {
+      (*commands)[loop_start].loop_commands = cmd_index - loop_start;
+      continue;
+    }
+    
     waveform_command_t* cmd = &(*commands)[cmd_index];
+    cmd->loop_commands = 0;
+    cmd->loop_passes = 0;
+    if (loop_pending) {
+      loop_start = cmd_index;
+      cmd->loop_passes = loop_passes;
+      loop_pending = false;
+    }
     
     char mode;
-    uint32_t value;
+    char value_str[64];
+    uint32_t value = 0;
     int16_t ch_vals[8];
-    int parsed = sscanf(trimmed, "%c %u %hd %hd %hd %hd %hd %hd %hd %hd", 
-                       &mode, &value, &ch_vals[0], &ch_vals[1], &ch_vals[2], &ch_vals[3],
+    int parsed = sscanf(trimmed, "%c %63s %hd %hd %hd %hd %hd %hd %hd %hd", 
+                       &mode, value_str, &ch_vals[0], &ch_vals[1], &ch_vals[2], &ch_vals[3],
                        &ch_vals[4], &ch_vals[5], &ch_vals[6], &ch_vals[7]);
+    parse_waveform_value(timing, mode, value_str, parsed == 10, &value);
     
     cmd->is_trigger = (mode == 'T');
     cmd->value = value;
@@ -617,6 +822,67 @@ static int parse_waveform_file(const char* file_path, waveform_command_t** comma
   return 0;
 }
 
+// FIFO words for a parsed command
+uint32_t waveform_command_words(const waveform_command_t* cmd) {
+  return (cmd->loop_commands > 0 ? 1 : 0) + (cmd->has_ch_vals ? DAC_WR_WORDCOUNT : 1);
+}
+
+// Whether a parsed waveform ends in a loop that repeats until cancelled
+bool waveform_loops_forever(const waveform_command_t* commands, int command_count) {
+  for (int i = 0; i < command_count; i++) {
+    if (commands[i].loop_commands > 0 && commands[i].loop_passes == 0) return true;
+  }
+  return false;
+}
+
+// Encode one pass of waveform commands (cont set on every command; the streamer clears it on the final one)
+uint32_t* encode_waveform_commands(const waveform_command_t* commands, int command_count, size_t* word_count) {
+  size_t count = 0;
+  for (int i = 0; i < command_count; i++) {
+    count += waveform_command_words(&commands[i]);
+  }
+  uint32_t* words = malloc(count * sizeof(uint32_t));
+  if (words == NULL) {
+    fprintf(stderr, "Failed to allocate memory for encoded waveform commands\n");
+    return NULL;
+  }
+  size_t w = 0;
+  for (int i = 0; i < command_count; i++) {
+    const waveform_command_t* cmd = &commands[i];
+    if (cmd->loop_commands > 0) {
+      uint32_t block_words = 0;
+      for (int k = i; k < i + cmd->loop_commands; k++) {
+        block_words += commands[k].has_ch_vals ? DAC_WR_WORDCOUNT : 1;
+      }
+      words[w++] = dac_encode_loop(block_words, cmd->loop_passes);
+    }
+    if (cmd->has_ch_vals) {
+      dac_encode_dac_wr(&words[w], cmd->ch_vals, cmd->is_trigger, true, true, cmd->value);
+      w += DAC_WR_WORDCOUNT;
+    } else {
+      words[w++] = dac_encode_cmd(DAC_CMD_NO_OP, cmd->is_trigger, true, false, cmd->value);
+    }
+  }
+  *word_count = count;
+  return words;
+}
+
+// Pre-emphasize one parsed command in place
+void preemph_waveform_command(const struct preemph_t* preemph, struct preemph_state_t* state, waveform_command_t* cmd) {
+  uint32_t hold = cmd->is_trigger ? preemph_trigger_hold_cycles(preemph, cmd->value, state->spi_clk_freq_hz) : cmd->value;
+  preemph_step(preemph, state, cmd->has_ch_vals ? cmd->ch_vals : NULL, hold);
+}
+
+// Pre-emphasize one pass of a board's waveform in place
+struct preemph_state_t preemph_waveform_commands(const struct preemph_t* preemph, uint8_t board, uint32_t spi_clk_freq_hz,
+                                                 waveform_command_t* commands, int command_count) {
+  struct preemph_state_t state = create_preemph_state(board, spi_clk_freq_hz);
+  for (int i = 0; i < command_count; i++) {
+    preemph_waveform_command(preemph, &state, &commands[i]);
+  }
+  return state;
+}
+
 // Thread function for DAC debug data streaming
 static void* dac_debug_stream_thread(void* arg) {
   dac_debug_stream_params_t* stream_data = (dac_debug_stream_params_t*)arg;
@@ -627,14 +893,14 @@ static void* dac_debug_stream_thread(void* arg) {
   bool verbose = *(ctx->verbose);
   
   if (verbose) {
-    printf("DAC Debug Stream Thread[%d]: Starting to write debug data to file '%s'\n", 
+    fprintf(ctx->console_out, "DAC Debug Stream Thread[%d]: Starting to write debug data to file '%s'\n", 
            board, file_path);
   }
   
   // Open file for writing (text mode for formatted output)
   FILE* file = fopen(file_path, "w");
   if (file == NULL) {
-    fprintf(stderr, "DAC Debug Stream Thread[%d]: Failed to open file '%s' for writing: %s\n", 
+    fprintf(ctx->console_err, "DAC Debug Stream Thread[%d]: Failed to open file '%s' for writing: %s\n", 
            board, file_path, strerror(errno));
     goto cleanup;
   }
@@ -651,7 +917,7 @@ static void* dac_debug_stream_thread(void* arg) {
     uint32_t data_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, board, false);
     
     if (FIFO_PRESENT(data_status) == 0) {
-      fprintf(stderr, "DAC Debug Stream Thread[%d]: Data FIFO not present, stopping stream\n", board);
+      fprintf(ctx->console_err, "DAC Debug Stream Thread[%d]: Data FIFO not present, stopping stream\n", board);
       break;
     }
     
@@ -689,10 +955,10 @@ cleanup:
   }
   
   if (*should_stop) {
-    printf("DAC Debug Stream Thread[%d]: Stopping stream (user requested), wrote %llu debug samples to '%s'\n", 
+    fprintf(ctx->console_out, "DAC Debug Stream Thread[%d]: Stopping stream (user requested), wrote %llu debug samples to '%s'\n", 
            board, samples_written, file_path);
   } else {
-    printf("DAC Debug Stream Thread[%d]: Stream ended, wrote %llu debug samples to '%s'\n", 
+    fprintf(ctx->console_out, "DAC Debug Stream Thread[%d]: Stream ended, wrote %llu debug samples to '%s'\n", 
            board, samples_written, file_path);
   }
   
@@ -710,11 +976,12 @@ void* dac_cmd_stream_thread(void* arg) {
   volatile bool* should_stop = stream_data->should_stop;
   waveform_command_t* commands = stream_data->commands;
   int command_count = stream_data->command_count;
+  const uint32_t* words = stream_data->words;
   int iterations = stream_data->iterations;
   
   if (*(ctx->verbose)) {
-    printf("DAC Command Stream Thread[%d]: Started streaming from file '%s' (%d commands, %d iteration%s)\n", 
-           board, file_path, command_count, iterations, iterations == 1 ? "" : "s");
+    fprintf(ctx->console_out, "DAC Command Stream Thread[%d]: Started streaming from file '%s' (%d commands, %zu words, %d iteration%s)\n", 
+           board, file_path, command_count, stream_data->word_count, iterations, iterations == 1 ? "" : "s");
   }
   
   int total_commands_sent = 0;
@@ -723,78 +990,316 @@ void* dac_cmd_stream_thread(void* arg) {
   
   while (!(*should_stop) && current_iteration < iterations) {
     int cmd_index = 0;
-    int commands_sent_this_iteration = 0;
+    size_t word_index = 0;
+    bool last_iteration = (current_iteration == iterations - 1);
     
-    // Process all commands in the current iteration
+    // Push as many whole commands as the FIFO has room for in one burst
     while (!(*should_stop) && cmd_index < command_count) {
       // Check DAC command FIFO status
       uint32_t fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, board, false);
       
       if (FIFO_PRESENT(fifo_status) == 0) {
-        fprintf(stderr, "DAC Command Stream Thread[%d]: FIFO not present, stopping stream\n", board);
+        fprintf(ctx->console_err, "DAC Command Stream Thread[%d]: FIFO not present, stopping stream\n", board);
         goto cleanup;
       }
       
       uint32_t words_used = FIFO_STS_WORD_COUNT(fifo_status) + 1; // +1 for safety margin
       uint32_t words_available = DAC_CMD_FIFO_WORDCOUNT - words_used;
       
-      // Check if we have space for the next command
-      waveform_command_t* cmd = &commands[cmd_index];
-      uint32_t words_needed = cmd->has_ch_vals ? 5 : 1; // dac_wr needs 5 words, noop needs 1
+      int burst_commands = 0;
+      uint32_t burst_words = 0;
+      while (cmd_index + burst_commands < command_count) {
+        uint32_t words_needed = waveform_command_words(&commands[cmd_index + burst_commands]);
+        if (burst_words + words_needed > words_available) break;
+        burst_words += words_needed;
+        burst_commands++;
+      }
       
-      if (words_available >= words_needed) {
-        // For iterating, we need to adjust the 'cont' flag:
-        // - Set cont=true for all commands except the last command of the last iteration
-        bool is_last_command_of_last_it = (current_iteration == iterations - 1) && (cmd_index == command_count - 1);
-        bool cont_flag = !is_last_command_of_last_it;
-        
-        // Send the command
-        if (cmd->has_ch_vals) {
-          dac_cmd_dac_wr(ctx->dac_ctrl, board, cmd->ch_vals, cmd->is_trigger, cont_flag, true, cmd->value, false);
-        } else {
-          dac_cmd_noop(ctx->dac_ctrl, board, cmd->is_trigger, cont_flag, false, cmd->value, false);
-        }
-        
-        commands_sent_this_iteration++;
-        total_commands_sent++;
-        total_words_sent += words_needed;
-        cmd_index++;
-        
-        if (*(ctx->verbose)) {
-          printf("DAC Command Stream Thread[%d]: Iteration %d/%d, Sent command %d/%d (%s, value=%u, %s, cont=%s) [FIFO: %u/%u words, %d needed]\n", 
-                 board, current_iteration + 1, iterations, commands_sent_this_iteration, command_count, 
-                 cmd->is_trigger ? "trigger" : "delay", cmd->value,
-                 cmd->has_ch_vals ? "with ch_vals" : "noop",
-                 cont_flag ? "true" : "false", words_used, DAC_CMD_FIFO_WORDCOUNT, words_needed);
-        }
-      } else {
+      if (burst_commands == 0) {
         // Not enough space in FIFO, sleep and try again
         usleep(1000); // 1ms
+        continue;
       }
+      
+      // The final command of the final iteration is sent with cont cleared so the core idles after it
+      bool ends_stream = last_iteration && (cmd_index + burst_commands == command_count);
+      uint32_t final_words = ends_stream ? waveform_command_words(&commands[command_count - 1]) : 0;
+      dac_write_cmd_words(ctx->dac_ctrl, board, &words[word_index], burst_words - final_words);
+      if (ends_stream) {
+        uint32_t final_cmd[1 + DAC_WR_WORDCOUNT];
+        memcpy(final_cmd, &words[word_index + burst_words - final_words], final_words * sizeof(uint32_t));
+        final_cmd[commands[command_count - 1].loop_commands > 0 ? 1 : 0] &= ~(1u << DAC_CMD_CONT_BIT);
+        dac_write_cmd_words(ctx->dac_ctrl, board, final_cmd, final_words);
+      }
+      
+      if (*(ctx->verbose)) {
+        fprintf(ctx->console_out, "DAC Command Stream Thread[%d]: Iteration %d/%d, Sent commands %d-%d/%d (%u words) [FIFO: %u/%u words]\n", 
+               board, current_iteration + 1, iterations, cmd_index + 1, cmd_index + burst_commands, command_count,
+               burst_words, words_used, DAC_CMD_FIFO_WORDCOUNT);
+      }
+      
+      cmd_index += burst_commands;
+      word_index += burst_words;
+      total_commands_sent += burst_commands;
+      total_words_sent += burst_words;
     }
     
     current_iteration++;
     if (current_iteration < iterations && *(ctx->verbose)) {
-      printf("DAC Command Stream Thread[%d]: Completed iteration %d/%d, starting next iteration\n", 
+      fprintf(ctx->console_out, "DAC Command Stream Thread[%d]: Completed iteration %d/%d, starting next iteration\n", 
              board, current_iteration, iterations);
     }
   }
 
 cleanup:
   if (*should_stop) {
-    printf("DAC Command Stream Thread[%d]: Stopping (user requested), sent %d total commands (%d total words)\n",
+    fprintf(ctx->console_out, "DAC Command Stream Thread[%d]: Stopping (user requested), sent %d total commands (%d total words)\n",
            board, total_commands_sent, total_words_sent);
   } else {
-    printf("DAC Command Stream Thread[%d]: Completed, sent %d total commands (%d total words, %d iteration%s)\n", 
+    fprintf(ctx->console_out, "DAC Command Stream Thread[%d]: Completed, sent %d total commands (%d total words, %d iteration%s)\n", 
            board, total_commands_sent, total_words_sent, iterations, iterations == 1 ? "" : "s");
   }
   
   ctx->dac_cmd_stream_running[board] = false;
-  free(stream_data->commands);
+  if (stream_data->owns_buffers) {
+    free(stream_data->commands);
+    free(stream_data->words);
+  }
   free(stream_data);
   return NULL;
 }
 
+// Start a DAC command stream thread from parsed and encoded commands
+int start_dac_cmd_stream(command_context_t* ctx, uint8_t board, const char* file_path, waveform_command_t* commands,
+                         int command_count, uint32_t* words, size_t word_count, int iterations, bool owns_buffers) {
+  // Check if stream is already running
+  if (ctx->dac_cmd_stream_running[board]) {
+    printf("DAC command stream for board %d is already running.\n", board);
+    return -1;
+  }
+  
+  // Allocate thread data structure
+  dac_command_stream_params_t* stream_data = malloc(sizeof(dac_command_stream_params_t));
+  if (stream_data == NULL) {
+    fprintf(stderr, "Failed to allocate memory for stream data\n");
+    return -1;
+  }
+  
+  stream_data->ctx = ctx;
+  stream_data->board = board;
+  snprintf(stream_data->file_path, sizeof(stream_data->file_path), "%s", file_path);
+  stream_data->should_stop = &(ctx->dac_cmd_stream_stop[board]);
+  stream_data->commands = commands;
+  stream_data->command_count = command_count;
+  stream_data->words = words;
+  stream_data->word_count = word_count;
+  stream_data->iterations = iterations;
+  stream_data->owns_buffers = owns_buffers;
+  stream_data->pack = NULL;
+  stream_data->preemph = NULL;
+  
+  // Initialize stop flag and mark stream as running
+  ctx->dac_cmd_stream_stop[board] = false;
+  ctx->dac_cmd_stream_running[board] = true;
+  
+  // Create the streaming thread
+  if (pthread_create(&(ctx->dac_cmd_stream_threads[board]), NULL, dac_cmd_stream_thread, stream_data) != 0) {
+    fprintf(stderr, "Failed to create DAC command streaming thread for board %d: %s\n", board, strerror(errno));
+    ctx->dac_cmd_stream_running[board] = false;
+    free(stream_data);
+    return -1;
+  }
+  return 0;
+}
+
+// Thread function for DAC streaming from a packed waveform: commands are decoded (and
+// pre-emphasized) just ahead of the FIFO, so only the packed bytes stay in memory
+static void* dac_packed_stream_thread(void* arg) {
+  dac_command_stream_params_t* stream_data = (dac_command_stream_params_t*)arg;
+  command_context_t* ctx = stream_data->ctx;
+  uint8_t board = stream_data->board;
+  volatile bool* should_stop = stream_data->should_stop;
+  const waveform_pack_t* pack = stream_data->pack;
+  const struct preemph_t* preemph = stream_data->preemph;
+  int iterations = stream_data->iterations;
+  uint32_t burst[DAC_CMD_FIFO_WORDCOUNT];
+  
+  if (*(ctx->verbose)) {
+    fprintf(ctx->console_out, "DAC Command Stream Thread[%d]: Started streaming packed waveform '%s' (%llu commands, %llu words, %d iteration%s)\n",
+           board, stream_data->file_path, (unsigned long long)pack->command_count, (unsigned long long)pack->word_count,
+           iterations, iterations == 1 ? "" : "s");
+  }
+  
+  uint64_t total_commands_sent = 0;
+  uint64_t total_words_sent = 0;
+  int current_iteration = 0;
+  bool corrupt = false;
+  struct preemph_state_t preemph_state = create_preemph_state(board, get_spi_timing(ctx).spi_clk_freq_hz);
+  uint32_t spi_clk_freq_hz = preemph_state.spi_clk_freq_hz;
+  waveform_unpacker_t unpacker = {0};
+  if (waveform_unpacker_init(&unpacker, pack) != 0) {
+    goto cleanup;
+  }
+  
+  while (!(*should_stop) && current_iteration < iterations && !corrupt) {
+    bool last_iteration = (current_iteration == iterations - 1);
+    waveform_unpacker_rewind(&unpacker);
+    preemph_state = create_preemph_state(board, spi_clk_freq_hz); // Every pass starts from rest
+    waveform_command_t pending;
+    int have = waveform_unpacker_next(&unpacker, &pending);
+    if (have == 1 && preemph != NULL) preemph_waveform_command(preemph, &preemph_state, &pending);
+    
+    while (!(*should_stop) && have == 1) {
+      uint32_t fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, board, false);
+      if (FIFO_PRESENT(fifo_status) == 0) {
+        fprintf(ctx->console_err, "DAC Command Stream Thread[%d]: FIFO not present, stopping stream\n", board);
+        goto cleanup;
+      }
+      uint32_t words_used = FIFO_STS_WORD_COUNT(fifo_status) + 1; // +1 for safety margin
+      uint32_t words_available = DAC_CMD_FIFO_WORDCOUNT - words_used;
+      
+      // Expand whole commands into the burst until the FIFO's free space is used
+      uint32_t burst_words = 0;
+      uint32_t burst_commands = 0;
+      while (have == 1) {
+        uint32_t words_needed = pending.has_ch_vals ? DAC_WR_WORDCOUNT : 1;
+        if (burst_words + words_needed > words_available) break;
+        // The final command of the final iteration is sent with cont cleared so the core idles after it
+        bool cont = !(last_iteration && unpacker.decoded == pack->command_count);
+        if (pending.has_ch_vals) {
+          dac_encode_dac_wr(&burst[burst_words], pending.ch_vals, pending.is_trigger, cont, true, pending.value);
+        } else {
+          burst[burst_words] = dac_encode_cmd(DAC_CMD_NO_OP, pending.is_trigger, cont, false, pending.value);
+        }
+        burst_words += words_needed;
+        burst_commands++;
+        have = waveform_unpacker_next(&unpacker, &pending);
+        if (have == 1 && preemph != NULL) preemph_waveform_command(preemph, &preemph_state, &pending);
+      }
+      
+      if (burst_commands == 0) {
+        // Not enough space in FIFO, sleep and try again
+        usleep(1000); // 1ms
+        continue;
+      }
+      dac_write_cmd_words(ctx->dac_ctrl, board, burst, burst_words);
+      total_commands_sent += burst_commands;
+      total_words_sent += burst_words;
+      
+      if (*(ctx->verbose)) {
+        fprintf(ctx->console_out, "DAC Command Stream Thread[%d]: Iteration %d/%d, sent %u commands (%u words), %llu/%llu decoded [FIFO: %u/%u words]\n",
+               board, current_iteration + 1, iterations, burst_commands, burst_words,
+               (unsigned long long)unpacker.decoded, (unsigned long long)pack->command_count, words_used, DAC_CMD_FIFO_WORDCOUNT);
+      }
+    }
+    if (have < 0) {
+      fprintf(ctx->console_err, "DAC Command Stream Thread[%d]: Packed waveform '%s' is corrupt at command %llu, stopping stream\n",
+              board, stream_data->file_path, (unsigned long long)unpacker.decoded);
+      corrupt = true;
+    }
+    current_iteration++;
+  }
+
+cleanup:
+  if (*should_stop) {
+    fprintf(ctx->console_out, "DAC Command Stream Thread[%d]: Stopping (user requested), sent %llu total commands (%llu total words)\n",
+           board, (unsigned long long)total_commands_sent, (unsigned long long)total_words_sent);
+  } else if (!corrupt) {
+    fprintf(ctx->console_out, "DAC Command Stream Thread[%d]: Completed, sent %llu total commands (%llu total words, %d iteration%s)\n",
+           board, (unsigned long long)total_commands_sent, (unsigned long long)total_words_sent,
+           iterations, iterations == 1 ? "" : "s");
+  }
+  if (preemph != NULL && preemph_state.writes > 0) {
+    preemph_print_report(&preemph_state, stdout);
+  }
+  
+  waveform_unpacker_free(&unpacker);
+  ctx->dac_cmd_stream_running[board] = false;
+  if (stream_data->owns_buffers) {
+    waveform_pack_free((waveform_pack_t*)stream_data->pack);
+    free((void*)stream_data->pack);
+  }
+  free(stream_data->preemph);
+  free(stream_data);
+  return NULL;
+}
+
+// Start a DAC command stream thread that decodes a packed waveform
+int start_dac_packed_stream(command_context_t* ctx, uint8_t board, const char* file_path, const struct waveform_pack* pack,
+                            int iterations, const struct preemph_t* preemph, bool owns_pack) {
+  if (ctx->dac_cmd_stream_running[board]) {
+    printf("DAC command stream for board %d is already running.\n", board);
+    return -1;
+  }
+  
+  dac_command_stream_params_t* stream_data = calloc(1, sizeof(dac_command_stream_params_t));
+  if (stream_data == NULL) {
+    fprintf(stderr, "Failed to allocate memory for stream data\n");
+    return -1;
+  }
+  if (preemph != NULL) {
+    stream_data->preemph = malloc(sizeof(struct preemph_t));
+    if (stream_data->preemph == NULL) {
+      fprintf(stderr, "Failed to allocate memory for stream data\n");
+      free(stream_data);
+      return -1;
+    }
+    *stream_data->preemph = *preemph;
+  }
+  stream_data->ctx = ctx;
+  stream_data->board = board;
+  snprintf(stream_data->file_path, sizeof(stream_data->file_path), "%s", file_path);
+  stream_data->should_stop = &(ctx->dac_cmd_stream_stop[board]);
+  stream_data->iterations = iterations;
+  stream_data->owns_buffers = owns_pack;
+  stream_data->pack = pack;
+  
+  ctx->dac_cmd_stream_stop[board] = false;
+  ctx->dac_cmd_stream_running[board] = true;
+  
+  if (pthread_create(&(ctx->dac_cmd_stream_threads[board]), NULL, dac_packed_stream_thread, stream_data) != 0) {
+    fprintf(stderr, "Failed to create DAC command streaming thread for board %d: %s\n", board, strerror(errno));
+    ctx->dac_cmd_stream_running[board] = false;
+    free(stream_data->preemph);
+    free(stream_data);
+    return -1;
+  }
+  return 0;
+}
+
+// Load a packed waveform and check it against the current SPI clock. Returns 1 if the file isn't packed.
+int load_dac_waveform_pack(const char* file_path, const struct spi_timing_t* timing, struct waveform_pack* pack) {
+  int result = waveform_pack_load(file_path, pack);
+  if (result != 0) return result;
+  if (pack->spi_clk_freq_hz != 0 && pack->spi_clk_freq_hz != timing->spi_clk_freq_hz) {
+    printf("WARNING: Packed waveform '%s' was converted at %.3f MHz but the SPI clock is %.3f MHz; delays written as times will be off.\n",
+           file_path, pack->spi_clk_freq_hz / 1e6, timing->spi_clk_freq_hz / 1e6);
+  }
+  return 0;
+}
+
+// Warn if the words between triggers (or the whole waveform, without triggers) exceed the DAC FIFO
+static void check_dac_trigger_gaps(bool found_trigger, uint64_t total_words, uint64_t max_gap, bool verbose) {
+  if (!found_trigger) {
+    // No trigger commands found - check if total command size exceeds FIFO
+    if (total_words > DAC_CMD_FIFO_WORDCOUNT) {
+      printf("WARNING: Waveform contains no triggers and requires %llu words, which exceeds DAC FIFO size (%u words).\n", 
+             (unsigned long long)total_words, DAC_CMD_FIFO_WORDCOUNT);
+      printf("         This may cause FIFO overflow during streaming. Consider adding trigger commands, keeping delays long, or reducing waveform size.\n");
+    } else if (verbose) {
+      printf("No trigger validation: Waveform requires %llu words (FIFO size: %u words) - OK\n", 
+             (unsigned long long)total_words, DAC_CMD_FIFO_WORDCOUNT);
+    }
+  } else if (max_gap > DAC_CMD_FIFO_WORDCOUNT) {
+    printf("WARNING: Maximum gap between triggers is %llu words, which exceeds DAC FIFO size (%u words).\n", 
+           (unsigned long long)max_gap, DAC_CMD_FIFO_WORDCOUNT);
+    printf("         This may cause FIFO underflow during streaming. Consider reducing number of delay commands between triggers or keeping delays long.\n");
+  } else if (verbose) {
+    printf("Trigger gap validation: Maximum gap is %llu words (FIFO size: %u words) - OK\n", 
+           (unsigned long long)max_gap, DAC_CMD_FIFO_WORDCOUNT);
+  }
+}
+
 int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   // Parse board number
   int board = parse_board_number(args[0]);
@@ -819,6 +1324,10 @@ int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const co
     printf("DAC command stream for board %d is already running.\n", board);
     return -1;
   }
+  if (dac_ddr_playing(ctx, board)) {
+    printf("DAC DDR buffer for board %d is still playing. Stop it with stop_dac_ddr first.\n", board);
+    return -1;
+  }
   
   // Check DAC command FIFO presence
   if (FIFO_PRESENT(sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, *(ctx->verbose))) == 0) {
@@ -828,7 +1337,7 @@ int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const co
   
   // Resolve glob pattern if present
   char resolved_path[1024];
-  if (resolve_file_pattern(args[1], resolved_path, sizeof(resolved_path)) != 0) {
+  if (resolve_file_pattern(args[1], resolved_path, sizeof(resolved_path), ctx->in) != 0) {
     return -1;
   }
   
@@ -836,11 +1345,40 @@ int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const co
   char full_path[1024];
   clean_and_expand_path(resolved_path, full_path, sizeof(full_path));
   
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  
+  // Packed waveforms are decoded by the stream thread as it goes
+  waveform_pack_t* pack = malloc(sizeof(waveform_pack_t));
+  if (pack == NULL) {
+    fprintf(stderr, "Failed to allocate memory for packed waveform\n");
+    return -1;
+  }
+  int pack_result = load_dac_waveform_pack(full_path, &timing, pack);
+  if (pack_result < 0) {
+    free(pack);
+    return -1;
+  }
+  if (pack_result == 0) {
+    check_dac_trigger_gaps(pack->triggers > 0, pack->word_count, pack->max_gap_words, *(ctx->verbose));
+    if (*(ctx->verbose)) {
+      printf("Starting packed DAC command streaming for board %d from file '%s' (%llu commands, %zu bytes, iterating %d time%s)\n",
+             board, full_path, (unsigned long long)pack->command_count, pack->size, iterations, iterations == 1 ? "" : "s");
+    }
+    bool preemph = preemph_board_active(&ctx->preemph, (uint8_t)board);
+    if (start_dac_packed_stream(ctx, (uint8_t)board, full_path, pack, iterations, preemph ? &ctx->preemph : NULL, true) != 0) {
+      waveform_pack_free(pack);
+      free(pack);
+      return -1;
+    }
+    return 0;
+  }
+  free(pack);
+  
   // Parse and validate the waveform file
   waveform_command_t* commands = NULL;
   int command_count = 0;
   
-  if (parse_waveform_file(full_path, &commands, &command_count) != 0) {
+  if (parse_waveform_file(full_path, &timing, &commands, &command_count) != 0) {
     return -1; // Error already printed by parse_waveform_file
   }
   
@@ -848,6 +1386,13 @@ int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const co
     printf("Parsed %d commands from waveform file '%s'\n", command_count, full_path);
   }
   
+  // A loop that repeats until cancelled never hands back to the next iteration
+  if (iterations > 1 && waveform_loops_forever(commands, command_count)) {
+    fprintf(stderr, "Waveform file '%s' ends in a loop that repeats until cancelled; it can't be iterated\n", full_path);
+    free(commands);
+    return -1;
+  }
+  
   // Validate trigger gaps to prevent FIFO underflow
   int words_since_last_trigger = 0;
   int max_gap = 0;
@@ -855,7 +1400,7 @@ int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const co
   
   for (int i = 0; i < command_count; i++) {
     waveform_command_t* cmd = &commands[i];
-    uint32_t words_needed = cmd->has_ch_vals ? 5 : 1; // dac_wr needs 5 words, noop needs 1
+    uint32_t words_needed = waveform_command_words(cmd); // dac_wr needs 5 words, noop needs 1, plus any LOOP word
     
     if (cmd->is_trigger) {
       // Found a trigger command - check the gap since last trigger
@@ -875,52 +1420,32 @@ int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const co
   }
   
   // Warn if any gap exceeds FIFO size
-  if (!found_trigger) {
-    // No trigger commands found - check if total command size exceeds FIFO
-    int total_words = words_since_last_trigger;
-    if (total_words > DAC_CMD_FIFO_WORDCOUNT) {
-      printf("WARNING: Waveform contains no triggers and requires %d words, which exceeds DAC FIFO size (%u words).\n", 
-             total_words, DAC_CMD_FIFO_WORDCOUNT);
-      printf("         This may cause FIFO overflow during streaming. Consider adding trigger commands, keeping delays long, or reducing waveform size.\n");
-    } else if (*(ctx->verbose)) {
-      printf("No trigger validation: Waveform requires %d words (FIFO size: %u words) - OK\n", 
-             total_words, DAC_CMD_FIFO_WORDCOUNT);
+  check_dac_trigger_gaps(found_trigger, (uint64_t)words_since_last_trigger, (uint64_t)max_gap, *(ctx->verbose));
+  
+  // Apply the loaded pre-emphasis before encoding
+  if (preemph_board_active(&ctx->preemph, (uint8_t)board)) {
+    struct preemph_state_t preemph_state = preemph_waveform_commands(&ctx->preemph, (uint8_t)board, timing.spi_clk_freq_hz,
+                                                                     commands, command_count);
+    preemph_print_report(&preemph_state, stdout);
+    for (int i = 0; i < command_count; i++) {
+      if (commands[i].loop_commands > 0) {
+        printf("  Loops are filtered once; every pass replays the first pass's pre-emphasized values\n");
+        break;
+      }
     }
-  } else if (max_gap > DAC_CMD_FIFO_WORDCOUNT) {
-    printf("WARNING: Maximum gap between triggers is %d words, which exceeds DAC FIFO size (%u words).\n", 
-           max_gap, DAC_CMD_FIFO_WORDCOUNT);
-    printf("         This may cause FIFO underflow during streaming. Consider reducing number of delay commands between triggers or keeping delays long.\n");
-  } else if (*(ctx->verbose)) {
-    printf("Trigger gap validation: Maximum gap is %d words (FIFO size: %u words) - OK\n", 
-           max_gap, DAC_CMD_FIFO_WORDCOUNT);
   }
   
-  // Allocate thread data structure
-  dac_command_stream_params_t* stream_data = malloc(sizeof(dac_command_stream_params_t));
-  if (stream_data == NULL) {
-    fprintf(stderr, "Failed to allocate memory for stream data\n");
+  // Encode one pass up front; the thread pushes it in bursts for every iteration
+  size_t word_count = 0;
+  uint32_t* words = encode_waveform_commands(commands, command_count, &word_count);
+  if (words == NULL) {
     free(commands);
     return -1;
   }
   
-  stream_data->ctx = ctx;
-  stream_data->board = (uint8_t)board;
-  snprintf(stream_data->file_path, sizeof(stream_data->file_path), "%s", full_path);
-  stream_data->should_stop = &(ctx->dac_cmd_stream_stop[board]);
-  stream_data->commands = commands;
-  stream_data->command_count = command_count;
-  stream_data->iterations = iterations;
-  
-  // Initialize stop flag and mark stream as running
-  ctx->dac_cmd_stream_stop[board] = false;
-  ctx->dac_cmd_stream_running[board] = true;
-  
-  // Create the streaming thread
-  if (pthread_create(&(ctx->dac_cmd_stream_threads[board]), NULL, dac_cmd_stream_thread, stream_data) != 0) {
-    fprintf(stderr, "Failed to create DAC command streaming thread for board %d: %s\n", board, strerror(errno));
-    ctx->dac_cmd_stream_running[board] = false;
+  if (start_dac_cmd_stream(ctx, (uint8_t)board, full_path, commands, command_count, words, word_count, iterations, true) != 0) {
     free(commands);
-    free(stream_data);
+    free(words);
     return -1;
   }
   
@@ -931,6 +1456,99 @@ int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const co
   return 0;
 }
 
+static double elapsed_ms(const struct timespec* start, const struct timespec* end) {
+  return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+int cmd_pack_dac_waveform(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  char resolved_path[1024];
+  if (resolve_file_pattern(args[0], resolved_path, sizeof(resolved_path), ctx->in) != 0) {
+    return -1;
+  }
+  char in_path[1024];
+  char out_path[1024];
+  clean_and_expand_path(resolved_path, in_path, sizeof(in_path));
+  clean_and_expand_path(args[1], out_path, sizeof(out_path));
+  if (waveform_pack_is_packed(in_path)) {
+    fprintf(stderr, "'%s' is already a packed waveform\n", in_path);
+    return -1;
+  }
+  
+  // Delays written as times are converted with the current SPI clock (recorded in the pack)
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  struct timespec t0, t1, t2, t3;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  waveform_command_t* commands = NULL;
+  int command_count = 0;
+  if (parse_waveform_file(in_path, &timing, &commands, &command_count) != 0) {
+    return -1;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  
+  waveform_pack_t pack;
+  if (waveform_pack_commands(commands, command_count, timing.spi_clk_freq_hz, &pack) != 0) {
+    free(commands);
+    return -1;
+  }
+  
+  // Check the round trip is exact before writing anything
+  waveform_unpacker_t unpacker;
+  if (waveform_unpacker_init(&unpacker, &pack) != 0) {
+    waveform_pack_free(&pack);
+    free(commands);
+    return -1;
+  }
+  int mismatch = -1;
+  waveform_command_t decoded;
+  for (int i = 0; i < command_count && mismatch < 0; i++) {
+    const waveform_command_t* cmd = &commands[i];
+    if (waveform_unpacker_next(&unpacker, &decoded) != 1 || decoded.is_trigger != cmd->is_trigger ||
+        decoded.value != cmd->value || decoded.has_ch_vals != cmd->has_ch_vals ||
+        (cmd->has_ch_vals && memcmp(decoded.ch_vals, cmd->ch_vals, sizeof(cmd->ch_vals)) != 0)) {
+      mismatch = i;
+    }
+  }
+  if (mismatch < 0 && waveform_unpacker_next(&unpacker, &decoded) != 0) mismatch = command_count;
+  waveform_unpacker_free(&unpacker);
+  free(commands);
+  if (mismatch >= 0) {
+    fprintf(stderr, "Packed waveform doesn't match the source at command %d; nothing written\n", mismatch);
+    waveform_pack_free(&pack);
+    return -1;
+  }
+  
+  if (waveform_pack_save(&pack, out_path) != 0) {
+    waveform_pack_free(&pack);
+    return -1;
+  }
+  size_t parsed_bytes = (size_t)command_count * sizeof(waveform_command_t) + pack.word_count * sizeof(uint32_t);
+  waveform_pack_free(&pack);
+  
+  // Time a load of the result against the text parse
+  clock_gettime(CLOCK_MONOTONIC, &t2);
+  if (waveform_pack_load(out_path, &pack) != 0) {
+    fprintf(stderr, "Failed to read back packed waveform '%s'\n", out_path);
+    return -1;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t3);
+  
+  struct stat in_stat, out_stat;
+  long long in_size = (stat(in_path, &in_stat) == 0) ? (long long)in_stat.st_size : -1;
+  long long out_size = (stat(out_path, &out_stat) == 0) ? (long long)out_stat.st_size : -1;
+  printf("Packed %d commands (%llu words/pass, %u triggers) into '%s'\n", command_count,
+         (unsigned long long)pack.word_count, pack.triggers, out_path);
+  printf("  File:   %lld -> %lld bytes (%.1fx smaller)\n", in_size, out_size,
+         out_size > 0 ? (double)in_size / out_size : 0.0);
+  printf("  Memory: %zu bytes parsed and encoded -> %zu bytes packed (%.1fx smaller)\n", parsed_bytes, pack.size,
+         pack.size > 0 ? (double)parsed_bytes / pack.size : 0.0);
+  printf("  Load:   %.2f ms to parse the text, %.2f ms to load the pack\n", elapsed_ms(&t0, &t1), elapsed_ms(&t2, &t3));
+  if (timing.spi_clk_freq_hz == 0) {
+    printf("  SPI clock unknown: only cycle-count delays were accepted\n");
+  }
+  waveform_pack_free(&pack);
+  return 0;
+}
+
 int cmd_stop_dac_cmd_stream(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   // Parse board number
   int board = parse_board_number(args[0]);
@@ -960,6 +1578,354 @@ int cmd_stop_dac_cmd_stream(const char** args, int arg_count, const command_flag
   return 0;
 }
 
+// Parse a text waveform file, or decode a packed one in full, into *commands (allocated, caller frees)
+static int load_waveform_commands(const char* full_path, const struct spi_timing_t* timing, waveform_command_t** commands,
+                                  int* command_count) {
+  waveform_pack_t pack;
+  int pack_result = load_dac_waveform_pack(full_path, timing, &pack);
+  if (pack_result < 0) {
+    return -1;
+  }
+  if (pack_result != 0) {
+    return parse_waveform_file(full_path, timing, commands, command_count);
+  }
+  
+  waveform_unpacker_t unpacker;
+  if (pack.command_count > (uint64_t)INT32_MAX) {
+    fprintf(stderr, "Packed waveform '%s' has too many commands to decode in full\n", full_path);
+    waveform_pack_free(&pack);
+    return -1;
+  }
+  waveform_command_t* decoded = malloc((size_t)pack.command_count * sizeof(waveform_command_t));
+  if (decoded == NULL || waveform_unpacker_init(&unpacker, &pack) != 0) {
+    fprintf(stderr, "Failed to allocate memory for packed waveform '%s'\n", full_path);
+    free(decoded);
+    waveform_pack_free(&pack);
+    return -1;
+  }
+  int expected = (int)pack.command_count;
+  int count = 0;
+  while (count < expected && waveform_unpacker_next(&unpacker, &decoded[count]) == 1) {
+    count++;
+  }
+  waveform_unpacker_free(&unpacker);
+  waveform_pack_free(&pack);
+  if (count != expected || count == 0) {
+    fprintf(stderr, "Packed waveform '%s' is corrupt\n", full_path);
+    free(decoded);
+    return -1;
+  }
+  *commands = decoded;
+  *command_count = count;
+  return 0;
+}
+
+int cmd_upload_dac_waveform(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  int board = parse_board_number(args[0]);
+  if (board < 0) {
+    fprintf(stderr, "Invalid board number for upload_dac_waveform: '%s'. Must be 0-7.\n", args[0]);
+    return -1;
+  }
+  
+  // Parse optional iteration count (copies of the waveform laid end to end in the buffer)
+  int iterations = 1;
+  if (arg_count >= 3) {
+    char* endptr;
+    iterations = (int)parse_value(args[2], &endptr);
+    if (*endptr != '\0' || iterations < 1) {
+      fprintf(stderr, "Invalid iteration count for upload_dac_waveform: '%s'. Must be a positive integer.\n", args[2]);
+      return -1;
+    }
+  }
+  
+  if (!ctx->dac_ddr_buf->present) {
+    fprintf(stderr, "DAC DDR buffers are not in this design (build with dac_cmd_ddr_buffer set)\n");
+    return -1;
+  }
+  if (ctx->dac_cmd_stream_running[board]) {
+    fprintf(stderr, "DAC command stream for board %d is running. Stop it before uploading.\n", board);
+    return -1;
+  }
+  if (FIFO_PRESENT(sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, *(ctx->verbose))) == 0) {
+    fprintf(stderr, "DAC command FIFO for board %d is not present. Cannot upload.\n", board);
+    return -1;
+  }
+  
+  // A reader that has played everything out can be reused; one still playing can't
+  uint32_t ddr_sts = dac_ddr_buf_status(ctx->dac_ddr_buf, (uint8_t)board);
+  if (DAC_DDR_STS_ENABLED(ddr_sts)) {
+    if (!DAC_DDR_STS_EMPTY(ddr_sts)) {
+      fprintf(stderr, "DAC DDR buffer for board %d is still playing. Stop it with stop_dac_ddr first.\n", board);
+      return -1;
+    }
+    if (dac_ddr_buf_stop(ctx->dac_ddr_buf, (uint8_t)board, *(ctx->verbose)) != 0) return -1;
+  }
+  
+  char resolved_path[1024];
+  if (resolve_file_pattern(args[1], resolved_path, sizeof(resolved_path), ctx->in) != 0) {
+    return -1;
+  }
+  char full_path[1024];
+  clean_and_expand_path(resolved_path, full_path, sizeof(full_path));
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  
+  // Packed waveforms are decoded in full, since every word goes to DDR anyway
+  waveform_command_t* commands = NULL;
+  int command_count = 0;
+  if (load_waveform_commands(full_path, &timing, &commands, &command_count) != 0) {
+    return -1;
+  }
+  
+  if (iterations > 1 && waveform_loops_forever(commands, command_count)) {
+    fprintf(stderr, "Waveform file '%s' ends in a loop that repeats until cancelled; it can't be iterated\n", full_path);
+    free(commands);
+    return -1;
+  }
+  
+  if (preemph_board_active(&ctx->preemph, (uint8_t)board)) {
+    struct preemph_state_t preemph_state = preemph_waveform_commands(&ctx->preemph, (uint8_t)board, timing.spi_clk_freq_hz,
+                                                                     commands, command_count);
+    preemph_print_report(&preemph_state, stdout);
+  }
+  
+  size_t pass_words = 0;
+  uint32_t* pass = encode_waveform_commands(commands, command_count, &pass_words);
+  if (pass == NULL) {
+    free(commands);
+    return -1;
+  }
+  
+  // Lay out every iteration, with cont cleared on the very last command so the core idles after it
+  size_t max_words = dac_ddr_buf_max_words(ctx->dac_ddr_buf, *(ctx->verbose));
+  size_t total_words = pass_words * (size_t)iterations;
+  if (max_words == 0 || pass_words > max_words / (size_t)iterations) {
+    fprintf(stderr, "Waveform needs %zu words but board %d's DDR buffer holds %zu\n", total_words, board, max_words);
+    free(pass);
+    free(commands);
+    return -1;
+  }
+  uint32_t* words = malloc(total_words * sizeof(uint32_t));
+  if (words == NULL) {
+    fprintf(stderr, "Failed to allocate memory for the DAC DDR upload\n");
+    free(pass);
+    free(commands);
+    return -1;
+  }
+  for (int i = 0; i < iterations; i++) {
+    memcpy(&words[(size_t)i * pass_words], pass, pass_words * sizeof(uint32_t));
+  }
+  const waveform_command_t* last = &commands[command_count - 1];
+  uint32_t* final_cmd = &words[total_words - waveform_command_words(last)];
+  final_cmd[last->loop_commands > 0 ? 1 : 0] &= ~(1u << DAC_CMD_CONT_BIT);
+  free(pass);
+  free(commands);
+  
+  int result = dac_ddr_buf_upload(ctx->dac_ddr_buf, (uint8_t)board, words, total_words, *(ctx->verbose));
+  free(words);
+  if (result != 0 || dac_ddr_buf_start(ctx->dac_ddr_buf, (uint8_t)board, *(ctx->verbose)) != 0) {
+    return -1;
+  }
+  printf("Uploaded '%s' to board %d's DAC DDR buffer (%zu words, %d iteration%s) and started playback\n",
+         full_path, board, total_words, iterations, iterations == 1 ? "" : "s");
+  return 0;
+}
+
+int cmd_dac_ddr_sts(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  int board = parse_board_number(args[0]);
+  if (board < 0) {
+    fprintf(stderr, "Invalid board number for dac_ddr_sts: '%s'. Must be 0-7.\n", args[0]);
+    return -1;
+  }
+  if (!ctx->dac_ddr_buf->present) {
+    printf("DAC DDR buffers are not in this design.\n");
+    return 0;
+  }
+  print_dac_ddr_buf_status(ctx->dac_ddr_buf, (uint8_t)board);
+  return 0;
+}
+
+int cmd_stop_dac_ddr(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  int board = parse_board_number(args[0]);
+  if (board < 0) {
+    fprintf(stderr, "Invalid board number for stop_dac_ddr: '%s'. Must be 0-7.\n", args[0]);
+    return -1;
+  }
+  if (!dac_ddr_playing(ctx, board)) {
+    printf("DAC DDR buffer for board %d is not playing.\n", board);
+    return dac_ddr_buf_stop(ctx->dac_ddr_buf, (uint8_t)board, *(ctx->verbose));
+  }
+  
+  // Flushing the command FIFO under a running command would underflow the core, so the stream is
+  // cut at a command boundary instead and the words already queued play out
+  if (dac_ddr_buf_end_early(ctx->dac_ddr_buf, (uint8_t)board, *(ctx->verbose)) < 0) {
+    return -1;
+  }
+  for (int i = 0; i < 1000 && dac_ddr_playing(ctx, board); i++) {
+    usleep(1000);
+  }
+  if (dac_ddr_playing(ctx, board)) {
+    fprintf(stderr, "DAC DDR reader for board %d didn't reach the early end (a loop repeating until cancelled needs dac_cancel)\n", board);
+    return -1;
+  }
+  if (dac_ddr_buf_stop(ctx->dac_ddr_buf, (uint8_t)board, *(ctx->verbose)) != 0) {
+    return -1;
+  }
+  printf("DAC DDR playback for board %d stopped; the command FIFO (%u words) plays out and the core idles.\n",
+         board, FIFO_STS_WORD_COUNT(sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false)));
+  return 0;
+}
+
+// State for walking a waveform through the integrator model
+typedef struct {
+  struct integ_model_t* model;
+  const int16_t* cal;        // The board's 8 calibration offsets
+  uint16_t input[8];         // Integrator inputs since the last LDAC
+  int32_t prev_pair[2];      // Calibrated values of the pair converted last
+  uint32_t trigger_cycles;   // Assumed length of a trigger wait
+  uint32_t dac_wr_cycles;    // Shortest DAC_WR
+  int trip_command;          // Command running when the first trip happened (-1 if none yet)
+  uint64_t trip_pass;        // Pass of its loop block (0 outside loops)
+} precheck_walk_t;
+
+// Update the integrator inputs at a DAC_WR's LDAC. The core converts each channel pair using the
+// registers holding the previous pair's calibrated values (abs_dac_val is loaded in the same stage
+// that sets them), so pair k reports pair k - 1's magnitudes and pair 0 the last pair written before.
+static void precheck_dac_wr(precheck_walk_t* walk, const int16_t ch_vals[8]) {
+  for (int pair = 0; pair < 4; pair++) {
+    for (int k = 0; k < 2; k++) {
+      int ch = 2 * pair + k;
+      int16_t lagged = (int16_t)(uint16_t)walk->prev_pair[k]; // signed_to_abs takes the low 16 bits
+      walk->input[ch] = (uint16_t)((lagged < 0 ? -(int32_t)lagged : lagged) & 0x7FFF);
+      walk->prev_pair[k] = (int32_t)ch_vals[ch] + walk->cal[ch];
+    }
+  }
+}
+
+// Hold the current inputs for one command (pass 0 outside loops), then apply its LDAC
+static void precheck_command(precheck_walk_t* walk, const waveform_command_t* cmd, int index, uint64_t pass) {
+  uint64_t cycles;
+  if (cmd->is_trigger) {
+    cycles = walk->trigger_cycles;
+    if (cmd->has_ch_vals && cycles < walk->dac_wr_cycles) cycles = walk->dac_wr_cycles;
+  } else {
+    cycles = cmd->value > 0 ? cmd->value : 1;
+  }
+  integ_model_hold(walk->model, walk->input, cycles);
+  if (walk->model->tripped && walk->trip_command < 0) {
+    walk->trip_command = index;
+    walk->trip_pass = pass;
+  }
+  if (cmd->has_ch_vals) precheck_dac_wr(walk, cmd->ch_vals);
+}
+
+int cmd_precheck(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  int board = parse_board_number(args[0]);
+  if (board < 0) {
+    fprintf(stderr, "Invalid board number for precheck: '%s'. Must be 0-7.\n", args[0]);
+    return -1;
+  }
+  char resolved_path[1024];
+  if (resolve_file_pattern(args[1], resolved_path, sizeof(resolved_path), ctx->in) != 0) {
+    return -1;
+  }
+  char full_path[1024];
+  clean_and_expand_path(resolved_path, full_path, sizeof(full_path));
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  
+  // Trigger waits can't be known ahead, so each takes a given time (by default none past the write)
+  uint32_t trigger_cycles = timing.dac_wr_min_delay;
+  if (arg_count >= 3 && spi_timing_parse_delay(&timing, args[2], timing.dac_wr_min_delay, &trigger_cycles) != 0) {
+    fprintf(stderr, "Invalid trigger wait for precheck: '%s'. Use cycles, 'min', or a time with ns/us/ms/s.\n", args[2]);
+    return -1;
+  }
+  
+  uint32_t window, threshold_average, enable;
+  sys_ctrl_get_integ_settings(ctx->sys_ctrl, &window, &threshold_average, &enable);
+  if (window < INTEG_WINDOW_MIN) {
+    printf("integ_window is %u cycles: under %d, the integrator trips as soon as it is enabled\n", window, INTEG_WINDOW_MIN);
+    return -1;
+  }
+  
+  waveform_command_t* commands = NULL;
+  int command_count = 0;
+  if (load_waveform_commands(full_path, &timing, &commands, &command_count) != 0) {
+    return -1;
+  }
+  if (preemph_board_active(&ctx->preemph, (uint8_t)board)) {
+    struct preemph_state_t preemph_state = preemph_waveform_commands(&ctx->preemph, (uint8_t)board, timing.spi_clk_freq_hz,
+                                                                     commands, command_count);
+    preemph_print_report(&preemph_state, stdout);
+  }
+  struct integ_model_t* model = malloc(sizeof(struct integ_model_t));
+  if (model == NULL) {
+    fprintf(stderr, "Failed to allocate memory for the integrator model\n");
+    free(commands);
+    return -1;
+  }
+  
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  integ_model_init(model, window, threshold_average);
+  precheck_walk_t walk = {
+    .model = model, .cal = &ctx->dac_cal[board * 8], .trigger_cycles = trigger_cycles,
+    .dac_wr_cycles = timing.dac_wr_min_delay, .trip_command = -1,
+  };
+  // Loops are played out in full; one repeating until cancelled runs until its sums are periodic
+  uint64_t settle = integ_model_settle_cycles(model);
+  uint64_t forever_passes = 0;
+  for (int i = 0; i < command_count; ) {
+    int block = commands[i].loop_commands > 0 ? commands[i].loop_commands : 1;
+    bool forever = commands[i].loop_commands > 0 && commands[i].loop_passes == 0;
+    uint64_t passes = commands[i].loop_commands > 0 ? commands[i].loop_passes : 1;
+    uint64_t block_start = model->cycle;
+    for (uint64_t pass = 0; forever || pass < passes; pass++) {
+      if (forever && pass > 0 && model->cycle - block_start >= 2 * settle) {
+        forever_passes = pass;
+        break;
+      }
+      for (int k = i; k < i + block && k < command_count; k++) {
+        precheck_command(&walk, &commands[k], k, commands[i].loop_commands > 0 ? pass + 1 : 0);
+      }
+    }
+    i += block;
+  }
+  // The last values stay on the outputs, so hold them until they fill the window
+  uint64_t waveform_cycles = model->cycle;
+  if (forever_passes == 0) integ_model_hold(model, walk.input, settle);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  
+  printf("Integrator precheck of '%s' on board %d: %d commands, %llu cycles (%.6f s)\n", full_path, board, command_count,
+         (unsigned long long)waveform_cycles, timing.spi_clk_freq_hz ? (double)waveform_cycles / timing.spi_clk_freq_hz : 0.0);
+  printf("  Starts with the integrator and zero outputs, trigger waits take %u cycles", trigger_cycles);
+  if (forever_passes == 0) printf(", and the last values are held for %llu cycles", (unsigned long long)settle);
+  printf("\n");
+  printf("  Inputs are what the DAC core reports, one channel pair late (ch N carries ch N-2's value, ch 0/1 the last pair written)\n");
+  if (forever_passes > 0) {
+    printf("  The loop repeating until cancelled was modeled for %llu passes\n", (unsigned long long)forever_passes);
+  }
+  integ_model_print_report(model, (uint8_t)board, timing.spi_clk_freq_hz, stdout);
+  if (model->tripped) {
+    if (walk.trip_command >= 0 && walk.trip_pass > 0) {
+      printf("  Trips during command %d (pass %llu of its loop)\n", walk.trip_command + 1, (unsigned long long)walk.trip_pass);
+    } else if (walk.trip_command >= 0) {
+      printf("  Trips during command %d\n", walk.trip_command + 1);
+    } else {
+      printf("  Trips after the last command, while its values are held\n");
+    }
+  } else {
+    printf("  No channel goes over the threshold\n");
+  }
+  if (!enable) {
+    printf("  Note: integ_enable is 0, so the integrator won't halt the system\n");
+  }
+  printf("  Modeled in %.1f ms\n", elapsed_ms(&t0, &t1));
+  
+  bool fails = model->tripped || model->fifo_overflow;
+  free(model);
+  free(commands);
+  return fails ? -1 : 0;
+}
+
 // DAC zero command - set all DAC channels to calibrated zero
 int cmd_dac_zero(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   // Validate system is running
@@ -1010,6 +1976,10 @@ int cmd_dac_zero(const char** args, int arg_count, const command_flag_t* flags,
         return -1;
       }
     }
+    if (dac_ddr_playing(ctx, board) && (target_all || target_boards[board])) {
+      fprintf(stderr, "Cannot zero DAC channels on board %d: DAC DDR buffer is still playing. Stop it with stop_dac_ddr first.\n", board);
+      return -1;
+    }
     
     uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
     uint32_t dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
@@ -1147,7 +2117,7 @@ int cmd_stream_dac_debug(const char** args, int arg_count, const command_flag_t*
   
   // Resolve glob pattern if present
   char resolved_path[1024];
-  if (resolve_file_pattern(args[1], resolved_path, sizeof(resolved_path)) != 0) {
+  if (resolve_file_pattern(args[1], resolved_path, sizeof(resolved_path), ctx->in) != 0) {
     return -1;
   }
   
@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "daemon_server.h"
+#include "command_handler.h"
+#include "command_helper.h"
+
+// Parameters for each client connection thread
+typedef struct {
+  command_context_t* ctx;
+  int client_fd;
+  int client_id;
+} daemon_client_params_t;
+
+// Commands from all clients share stdout/stderr, so only one runs at a time
+static pthread_mutex_t g_daemon_exec_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile int g_daemon_client_count = 0;
+
+// Execute one command with stdout/stderr redirected to the client socket. Prompts read from the
+// client's own stream (in), so answers sent ahead of the prompt stay queued there for it, and
+// background threads print to the daemon's console instead.
+static int daemon_execute_for_client(command_context_t* ctx, const char* line, int client_fd, FILE* in) {
+  pthread_mutex_lock(&g_daemon_exec_mutex);
+
+  fflush(stdout);
+  fflush(stderr);
+  int saved_stdout = dup(STDOUT_FILENO);
+  int saved_stderr = dup(STDERR_FILENO);
+  dup2(client_fd, STDOUT_FILENO);
+  dup2(client_fd, STDERR_FILENO);
+  FILE* saved_in = ctx->in;
+  ctx->in = in;
+
+  int result = execute_command(line, ctx);
+
+  ctx->in = saved_in;
+  fflush(stdout);
+  fflush(stderr);
+  dup2(saved_stdout, STDOUT_FILENO);
+  dup2(saved_stderr, STDERR_FILENO);
+  close(saved_stdout);
+  close(saved_stderr);
+
+  pthread_mutex_unlock(&g_daemon_exec_mutex);
+  return result;
+}
+
+// Per-client thread: read command lines and reply with output plus an end marker
+static void* daemon_client_thread(void* arg) {
+  daemon_client_params_t* params = (daemon_client_params_t*)arg;
+  command_context_t* ctx = params->ctx;
+  int client_fd = params->client_fd;
+  int client_id = params->client_id;
+
+  FILE* in = fdopen(dup(client_fd), "r");
+  if (in == NULL) {
+    fprintf(ctx->console_err, "Daemon Client[%d]: Failed to open socket stream: %s\n", client_id, strerror(errno));
+    goto cleanup;
+  }
+
+  fprintf(ctx->console_out, "Daemon Client[%d]: Connected\n", client_id);
+  dprintf(client_fd, "Connected to shim-test daemon. Type 'help' for available commands, 'quit' to disconnect.\n");
+  dprintf(client_fd, "%s 0\n", DAEMON_END_MARKER);
+
+  char line[256];
+  while (!*(ctx->should_exit) && fgets(line, sizeof(line), in) != NULL) {
+    // Remove trailing newline characters
+    size_t len = strlen(line);
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+      line[--len] = '\0';
+    }
+
+    int result = 0;
+    if (len > 0) {
+      if (*(ctx->verbose)) {
+        fprintf(ctx->console_out, "Daemon Client[%d]: %s\n", client_id, line);
+      }
+      result = daemon_execute_for_client(ctx, line, client_fd, in);
+    }
+    dprintf(client_fd, "%s %d\n", DAEMON_END_MARKER, result);
+  }
+
+  fprintf(ctx->console_out, "Daemon Client[%d]: Disconnected\n", client_id);
+  fclose(in);
+
+cleanup:
+  close(client_fd);
+  __sync_fetch_and_sub(&g_daemon_client_count, 1);
+  free(params);
+  return NULL;
+}
+
+// Run the daemon accept loop
+int daemon_run(command_context_t* ctx, const char* socket_path) {
+  // A client hanging up mid-reply must not kill the daemon
+  signal(SIGPIPE, SIG_IGN);
+
+  // Daemon logging and background threads keep the original stdout/stderr while commands have
+  // them redirected (left open for any stream threads still running after the loop ends)
+  FILE* console_out = fdopen(dup(STDOUT_FILENO), "w");
+  FILE* console_err = fdopen(dup(STDERR_FILENO), "w");
+  if (console_out == NULL || console_err == NULL) {
+    fprintf(stderr, "Failed to open daemon console streams: %s\n", strerror(errno));
+    return -1;
+  }
+  setvbuf(console_out, NULL, _IOLBF, 0);
+  setvbuf(console_err, NULL, _IONBF, 0);
+  ctx->console_out = console_out;
+  ctx->console_err = console_err;
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+    fprintf(ctx->console_err, "Daemon socket path too long: '%s'\n", socket_path);
+    return -1;
+  }
+  strcpy(addr.sun_path, socket_path);
+
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0) {
+    fprintf(ctx->console_err, "Failed to create daemon socket: %s\n", strerror(errno));
+    return -1;
+  }
+
+  // We hold the hardware ownership lock, so any existing socket file is stale
+  unlink(socket_path);
+  if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    fprintf(ctx->console_err, "Failed to bind daemon socket '%s': %s\n", socket_path, strerror(errno));
+    close(listen_fd);
+    return -1;
+  }
+  set_file_permissions(socket_path, *(ctx->verbose));
+
+  if (listen(listen_fd, DAEMON_MAX_CLIENTS) != 0) {
+    fprintf(ctx->console_err, "Failed to listen on daemon socket '%s': %s\n", socket_path, strerror(errno));
+    close(listen_fd);
+    unlink(socket_path);
+    return -1;
+  }
+
+  fprintf(ctx->console_out, "Daemon listening on '%s'\n", socket_path);
+
+  int next_client_id = 0;
+  while (!*(ctx->should_exit)) {
+    // Poll with a timeout so an 'exit' from any client is noticed
+    struct pollfd pfd = { .fd = listen_fd, .events = POLLIN, .revents = 0 };
+    if (poll(&pfd, 1, 500) <= 0) {
+      continue;
+    }
+
+    int client_fd = accept(listen_fd, NULL, NULL);
+    if (client_fd < 0) {
+      if (errno != EINTR) {
+        fprintf(ctx->console_err, "Failed to accept daemon client: %s\n", strerror(errno));
+      }
+      continue;
+    }
+
+    if (g_daemon_client_count >= DAEMON_MAX_CLIENTS) {
+      dprintf(client_fd, "Too many clients connected (max %d)\n", DAEMON_MAX_CLIENTS);
+      close(client_fd);
+      continue;
+    }
+
+    daemon_client_params_t* params = malloc(sizeof(daemon_client_params_t));
+    if (params == NULL) {
+      fprintf(ctx->console_err, "Failed to allocate memory for daemon client\n");
+      close(client_fd);
+      continue;
+    }
+    params->ctx = ctx;
+    params->client_fd = client_fd;
+    params->client_id = next_client_id++;
+
+    __sync_fetch_and_add(&g_daemon_client_count, 1);
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, daemon_client_thread, params) != 0) {
+      fprintf(ctx->console_err, "Failed to create daemon client thread: %s\n", strerror(errno));
+      __sync_fetch_and_sub(&g_daemon_client_count, 1);
+      close(client_fd);
+      free(params);
+      continue;
+    }
+    pthread_detach(tid);
+  }
+
+  close(listen_fd);
+  unlink(socket_path);
+  fprintf(ctx->console_out, "Daemon stopped listening on '%s'\n", socket_path);
+  return 0;
+}
+
+// Write daemon output to stdout, holding back anything that may be an end marker.
+// Returns true when an end marker line has been consumed.
+static bool daemon_client_print(char* pending, size_t* pending_len, char c) {
+  pending[(*pending_len)++] = c;
+  size_t marker_len = strlen(DAEMON_END_MARKER);
+  size_t compare_len = *pending_len < marker_len ? *pending_len : marker_len;
+
+  if (strncmp(pending, DAEMON_END_MARKER, compare_len) != 0) {
+    // Not a marker: pass through immediately (prompts don't end in newlines)
+    fwrite(pending, 1, *pending_len, stdout);
+    *pending_len = 0;
+    return false;
+  }
+
+  if (c == '\n' || *pending_len >= 255) {
+    *pending_len = 0;
+    return true;
+  }
+  return false;
+}
+
+// Run an interactive client connected to a daemon
+int daemon_client_run(const char* socket_path) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Daemon socket path too long: '%s'\n", socket_path);
+    return -1;
+  }
+  strcpy(addr.sun_path, socket_path);
+
+  int sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock_fd < 0) {
+    fprintf(stderr, "Failed to create socket: %s\n", strerror(errno));
+    return -1;
+  }
+  if (connect(sock_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    fprintf(stderr, "Failed to connect to daemon at '%s': %s\n", socket_path, strerror(errno));
+    close(sock_fd);
+    return -1;
+  }
+
+  char pending[256];
+  size_t pending_len = 0;
+  bool stdin_open = true;
+  bool at_line_start = true;
+
+  while (1) {
+    struct pollfd pfds[2] = {
+      { .fd = sock_fd, .events = POLLIN, .revents = 0 },
+      { .fd = STDIN_FILENO, .events = POLLIN, .revents = 0 }
+    };
+    if (poll(pfds, stdin_open ? 2 : 1, -1) < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+
+    // Daemon output
+    if (pfds[0].revents & (POLLIN | POLLHUP)) {
+      char buf[1024];
+      ssize_t n = read(sock_fd, buf, sizeof(buf));
+      if (n <= 0) break; // Daemon closed the connection
+      for (ssize_t i = 0; i < n; i++) {
+        // Only a marker at the start of a line counts
+        if (at_line_start || pending_len > 0) {
+          if (daemon_client_print(pending, &pending_len, buf[i])) {
+            printf("\nCommand> ");
+            at_line_start = true;
+            continue;
+          }
+        } else {
+          fputc(buf[i], stdout);
+        }
+        at_line_start = (buf[i] == '\n');
+      }
+      fflush(stdout);
+    }
+
+    // User input (commands or answers to interactive prompts), forwarded unbuffered
+    if (stdin_open && (pfds[1].revents & (POLLIN | POLLHUP))) {
+      char buf[256];
+      ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+      if (n <= 0) {
+        // Let the daemon finish pending replies, then it closes the socket
+        shutdown(sock_fd, SHUT_WR);
+        stdin_open = false;
+        continue;
+      }
+      if (n >= 4 && strncmp(buf, "quit", 4) == 0 && (n == 4 || buf[4] == '\n')) {
+        break;
+      }
+      if (write(sock_fd, buf, (size_t)n) != n) {
+        fprintf(stderr, "Failed to send command to daemon: %s\n", strerror(errno));
+        break;
+      }
+    }
+  }
+
+  printf("\nDisconnected from daemon.\n");
+  close(sock_fd);
+  return 0;
+}
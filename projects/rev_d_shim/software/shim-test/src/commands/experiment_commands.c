@@ -3,6 +3,7 @@
 #include <string.h>
 #include <strings.h>
 #include <inttypes.h>
+#include <math.h>
 #include <unistd.h>
 #include <pwd.h>
 #include <sys/types.h>
@@ -11,6 +12,7 @@
 #include <pthread.h>
 #include <glob.h>
 #include <time.h>
+#include <sched.h>
 #include "experiment_commands.h"
 #include "command_helper.h"
 #include "adc_commands.h"
@@ -24,11 +26,13 @@
 #include "adc_ctrl.h"
 #include "map_memory.h"
 #include "trigger_ctrl.h"
+#include "crosstalk.h"
+#include "experiment_plan.h"
+#include "regulator.h"
 
 // Forward declarations for helper functions
 static int validate_system_running(command_context_t* ctx);
-static int count_trigger_lines_in_file(const char* file_path);
-static uint64_t calculate_expected_adc_words(const char* file_path, int iterations, bool verbose);
+static void autosave_calibration(command_context_t* ctx);
 
 // Structure for trigger monitoring thread
 typedef struct {
@@ -36,6 +40,7 @@ typedef struct {
   uint32_t expected_total_triggers;
   volatile bool* should_stop;
   bool verbose;
+  FILE* out;                      // Progress output (the console, not the client that started it)
 } trigger_monitor_params_t;
 
 // Thread function for trigger monitoring
@@ -46,6 +51,9 @@ static volatile bool g_trigger_monitor_should_stop = false;
 static pthread_t g_trigger_monitor_tid;
 static bool g_trigger_monitor_active = false;
 
+// Plan of the last waveform test (kept so unchanged files aren't parsed again on the next run)
+static experiment_plan_t g_waveform_plan;
+
 // Local helper function to check if system is running
 static int validate_system_running(command_context_t* ctx) {
   uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, *(ctx->verbose));
@@ -57,98 +65,30 @@ static int validate_system_running(command_context_t* ctx) {
   return 0;
 }
 
-// Helper function to count trigger lines in a DAC/ADC file 
-// (sum trigger counts from T lines, formatted similarly enough in both files to be fine)
-static int count_trigger_lines_in_file(const char* file_path) {
-  FILE* file = fopen(file_path, "r");
-  if (file == NULL) {
-    fprintf(stderr, "Failed to open DAC/ADC file '%s': %s\n", file_path, strerror(errno));
-    return -1;
-  }
-  
-  char line[512];
-  int trigger_count = 0;
-  
-  while (fgets(line, sizeof(line), file)) {
-    // Skip empty lines and comments
-    char* trimmed = line;
-    while (*trimmed == ' ' || *trimmed == '\t') trimmed++;
-    if (*trimmed == '\n' || *trimmed == '\r' || *trimmed == '\0' || *trimmed == '#') {
-      continue;
-    }
-    
-    // Check if line starts with T (trigger)
-    if (*trimmed == 'T') {
-      int t_count = 1;
-      // Try to parse the trigger count after 'T'
-      if (sscanf(trimmed + 1, " %d", &t_count) == 1 && t_count > 0) {
-        trigger_count += t_count;
-      } else {
-        trigger_count += 1;
-      }
-    }
+// Abandon a command sequence that was queued ahead of the hardware: flush what is still
+// sitting in the command FIFOs (a CANCEL only takes effect once the core reads it), cancel
+// the wait each core is in, and return every DAC channel to its calibrated zero
+static void abort_queued_commands(command_context_t* ctx, const bool connected_boards[8], FILE* out) {
+  uint32_t cmd_reset_mask = 1U << 16; // Trigger command buffer
+  for (int board = 0; board < 8; board++) {
+    if (connected_boards[board]) cmd_reset_mask |= 3U << (board * 2); // DAC and ADC command buffers
   }
-  
-  fclose(file);
-  return trigger_count;
-}
+  sys_ctrl_set_cmd_buf_reset(ctx->sys_ctrl, cmd_reset_mask, false);
+  usleep(1000); // 1ms delay
+  sys_ctrl_set_cmd_buf_reset(ctx->sys_ctrl, 0, false);
 
-// Helper function to calculate expected number of ADC words from an ADC command file
-static uint64_t calculate_expected_adc_words(const char* file_path, int iterations, bool verbose) {
-  // Parse the ADC command file to count D commands (only these generate ADC words)
-  
-  FILE* file = fopen(file_path, "r");
-  if (file == NULL) {
-    fprintf(stderr, "Failed to open ADC command file '%s': %s\n", file_path, strerror(errno));
-    return 0;
-  }
-  
-  // Count D commands (these generate ADC words)
-  char line[512];
-  uint64_t adc_words_per_execution = 0;
-  
-  while (fgets(line, sizeof(line), file)) {
-    // Skip empty lines and comments
-    char* trimmed = line;
-    while (*trimmed == ' ' || *trimmed == '\t') trimmed++;
-    if (*trimmed == '\n' || *trimmed == '\r' || *trimmed == '\0' || *trimmed == '#') {
-      continue;
-    }
-    
-    // Check command type - only D commands generate ADC words
-    if (*trimmed == 'D') {
-      // D commands generate 4 ADC words per execution (one per ADC channel read)
-      uint32_t delay_value = 0;
-      uint32_t repeat_value = 0;
-      
-      // Parse the delay and repeat values from the command
-      // Format: D <delay> <repeats> where repeats is the number of EXTRA times it runs
-      int parsed = sscanf(trimmed + 1, " %u %u", &delay_value, &repeat_value);
-      if (parsed >= 2) {
-        // Second parameter is the repeat count (extra executions)
-        adc_words_per_execution += (repeat_value + 1) * 4;
-      } else if (parsed == 1) {
-        // Only delay specified, runs once
-        adc_words_per_execution += 4;
-      } else {
-        // Default to runs once
-        adc_words_per_execution += 4;
-      }
-    }
-    // T and O commands don't generate ADC words, just ignore them
+  trigger_cmd_cancel(ctx->trigger_ctrl, false);
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    dac_cmd_cancel(ctx->dac_ctrl, (uint8_t)board, false);
+    adc_cmd_cancel(ctx->adc_ctrl, (uint8_t)board, false);
   }
-  
-  fclose(file);
-  
-  // Calculate total ADC words: adc_words_per_execution * total_iterations
-  uint64_t total_adc_words = adc_words_per_execution * iterations;
-  
-  if (verbose) {
-    printf("Calculated %llu ADC words per execution, %llu total ADC words (%d iterations)\n", 
-           adc_words_per_execution, total_adc_words, iterations);
+  usleep(1000); // 1ms to let cancel commands complete
+
+  for (int board = 0; board < 8; board++) {
+    if (connected_boards[board]) dac_cmd_zero(ctx->dac_ctrl, (uint8_t)board, false);
   }
-  
-  return total_adc_words;
+  fprintf(out, "Cancelled the remaining queued commands and zeroed the DAC channels\n");
 }
 
 // Channel test command implementation
@@ -349,6 +289,240 @@ int cmd_channel_test(const char** args, int arg_count, const command_flag_t* fla
   return 0;
 }
 
+// Channel calibration constants
+#define CHANNEL_CAL_NUM_DAC_VALUES  5
+#define CHANNEL_CAL_AVERAGE_COUNT   10
+#define CHANNEL_CAL_ITERATIONS      3
+#define CHANNEL_CAL_DELAY_US        1000 // DAC settling time before each ADC read
+
+// Result of calibrating one channel (filled in by its board's worker thread)
+typedef struct {
+  bool skipped;             // Not started because calibration was aborted
+  bool cal_timeout;         // No calibration data from the DAC, nothing was measured
+  bool failed;              // ADC data timeout during a measurement
+  bool poor_linearity;      // Slope out of range in some iteration
+  bool halted;              // Hardware was halted after a failure
+  int completed_iterations;
+  int16_t final_cal;        // DAC offset left set on the channel (valid once an iteration completed)
+  double offset_amps[CHANNEL_CAL_ITERATIONS];
+  double slope[CHANNEL_CAL_ITERATIONS];
+  bool division_by_zero[CHANNEL_CAL_ITERATIONS];
+  volatile bool done;       // Set once the rest of the result is final
+} channel_cal_result_t;
+
+// Work for one board: its channels are calibrated one at a time, boards run in parallel
+typedef struct {
+  command_context_t* ctx;
+  int board;
+  int start_ch;                   // First global channel (0-63) to calibrate on this board
+  int end_ch;                     // Last global channel to calibrate on this board
+  channel_cal_result_t* results;  // Indexed by global channel
+  volatile bool* abort_flag;      // Set by any board that finds the hardware halted
+} channel_cal_board_t;
+
+// Wait for a FIFO to hold data, polling its status every 0.1 ms (false on timeout)
+static bool wait_for_fifo_data(command_context_t* ctx, int board, bool dac_data) {
+  for (int tries = 0; tries < 100; tries++) {
+    uint32_t status = dac_data ? sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false)
+                               : sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+    if (FIFO_STS_WORD_COUNT(status) > 0) return true;
+    usleep(100); // 0.1ms
+  }
+  return false;
+}
+
+// Calibrate the offset of one channel
+static void calibrate_channel(command_context_t* ctx, int ch, channel_cal_result_t* result, volatile bool* abort_flag) {
+  static const int dac_values[CHANNEL_CAL_NUM_DAC_VALUES] = {-3276, -1638, 0, 1638, 3276};
+  int board = ch / 8;
+  int channel = ch % 8;
+  bool verbose = *(ctx->verbose);
+
+  if (verbose) {
+    printf("  [Ch %02d] Starting calibration (board %d, channel %d)\n", ch, board, channel);
+  }
+
+  // Get current DAC calibration value and store it
+  dac_cmd_get_cal(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, false);
+  if (!wait_for_fifo_data(ctx, board, true)) {
+    result->cal_timeout = true;
+    return;
+  }
+  uint32_t original_cal_data_word = dac_read_data(ctx->dac_ctrl, (uint8_t)board);
+  int16_t current_cal_value = (int16_t)DAC_CAL_DATA_VAL(original_cal_data_word);
+
+  for (int iter = 0; iter < CHANNEL_CAL_ITERATIONS && !result->failed && !result->poor_linearity && !*abort_flag; iter++) {
+    // DAC values and corresponding averaged ADC readings
+    double dac_vals[CHANNEL_CAL_NUM_DAC_VALUES];
+    double avg_adc_vals[CHANNEL_CAL_NUM_DAC_VALUES];
+
+    for (int i = 0; i < CHANNEL_CAL_NUM_DAC_VALUES; i++) {
+      int16_t dac_val = (int16_t)dac_values[i];
+      dac_vals[i] = (double)dac_val;
+
+      // Perform multiple reads and average them
+      double sum_adc = 0.0;
+      for (int avg = 0; avg < CHANNEL_CAL_AVERAGE_COUNT; avg++) {
+        dac_cmd_dac_wr_ch(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, dac_val, false);
+        usleep(CHANNEL_CAL_DELAY_US);
+        adc_cmd_adc_rd_ch(ctx->adc_ctrl, (uint8_t)board, (uint8_t)channel, 0, false);
+
+        if (!wait_for_fifo_data(ctx, board, false)) {
+          if (verbose) {
+            printf("  [Ch %02d] ADC data timeout at DAC value %d\n", ch, dac_val);
+          }
+          result->failed = true;
+          break;
+        }
+
+        uint32_t adc_word = adc_read_word(ctx->adc_ctrl, (uint8_t)board);
+        double adc_value = (double)offset_to_signed(adc_word & 0xFFFF);
+
+        // Subtract ADC bias if available
+        if (ctx->adc_bias_valid[ch]) {
+          adc_value -= ctx->adc_bias[ch];
+        }
+        sum_adc += adc_value;
+      }
+      if (result->failed) break;
+
+      avg_adc_vals[i] = sum_adc / CHANNEL_CAL_AVERAGE_COUNT;
+      if (verbose) {
+        printf("  [Ch %02d] DAC=%d -> ADC_avg=%.2f\n", ch, dac_val, avg_adc_vals[i]);
+      }
+    }
+    if (result->failed) break;
+
+    // Perform linear regression: y = mx + b
+    double sum_x = 0, sum_y = 0, sum_xy = 0, sum_x2 = 0;
+    for (int i = 0; i < CHANNEL_CAL_NUM_DAC_VALUES; i++) {
+      sum_x += dac_vals[i];
+      sum_y += avg_adc_vals[i];
+      sum_xy += dac_vals[i] * avg_adc_vals[i];
+      sum_x2 += dac_vals[i] * dac_vals[i];
+    }
+
+    double denominator = CHANNEL_CAL_NUM_DAC_VALUES * sum_x2 - sum_x * sum_x;
+    double slope, intercept;
+    bool division_by_zero = (denominator == 0);
+    if (division_by_zero) {
+      slope = 0;
+      intercept = sum_y / CHANNEL_CAL_NUM_DAC_VALUES;
+    } else {
+      slope = (CHANNEL_CAL_NUM_DAC_VALUES * sum_xy - sum_x * sum_y) / denominator;
+      intercept = (sum_y - slope * sum_x) / CHANNEL_CAL_NUM_DAC_VALUES;
+    }
+
+    // Poor linearity: infinite, negative or out-of-range slope
+    bool this_iter_poor_linearity = division_by_zero || slope < 0.95 || slope > 1.05;
+
+    if (verbose) {
+      printf("  [Ch %02d] Iteration %d: Current cal=%d, Slope=%.4f, Intercept=%.2f\n",
+             ch, iter + 1, current_cal_value, slope, intercept);
+    }
+
+    // Update calibration value: subtract intercept from current cal value, clamped to the valid range
+    current_cal_value = current_cal_value - (int16_t)(intercept >= 0 ? intercept + 0.5 : intercept - 0.5);
+    if (current_cal_value < -4095) current_cal_value = -4095;
+    if (current_cal_value > 4095) current_cal_value = 4095;
+    if (verbose) {
+      printf("  [Ch %02d] Updated cal value to %d\n", ch, current_cal_value);
+    }
+    dac_cmd_set_cal(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, current_cal_value, false);
+    result->final_cal = current_cal_value;
+
+    // Convert offset to amps (range -5.1 to 5.1 for ±32767)
+    result->offset_amps[iter] = intercept * 5.1 / 32767.0;
+    result->slope[iter] = slope;
+    result->division_by_zero[iter] = division_by_zero;
+    result->completed_iterations++;
+
+    if (this_iter_poor_linearity) {
+      result->poor_linearity = true;
+    }
+  }
+
+  // Zero the channel to finalize
+  dac_cmd_dac_wr_ch(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, 0, false);
+  usleep(1000); // 1ms to let DAC settle
+}
+
+// Calibrate one board's channels in order, stopping early if another board found the hardware halted
+static void* channel_cal_board_thread(void* arg) {
+  channel_cal_board_t* work = (channel_cal_board_t*)arg;
+  for (int ch = work->start_ch; ch <= work->end_ch; ch++) {
+    channel_cal_result_t* result = &work->results[ch];
+    if (*(work->abort_flag)) {
+      result->skipped = true;
+    } else {
+      calibrate_channel(work->ctx, ch, result, work->abort_flag);
+
+      // If the channel failed because the hardware halted, stop every board
+      if (result->cal_timeout || result->failed) {
+        uint32_t hw_status = sys_sts_get_hw_status(work->ctx->sys_sts, false);
+        if (HW_STS_STATE(hw_status) == S_HALTED) {
+          result->halted = true;
+          *(work->abort_flag) = true;
+        }
+      }
+    }
+    __atomic_store_n(&result->done, true, __ATOMIC_RELEASE);
+  }
+  return NULL;
+}
+
+// Print a channel's calibration row
+static void print_channel_cal_result(int ch, const channel_cal_result_t* result, bool verbose) {
+  if (result->cal_timeout) {
+    if (verbose) {
+      printf("Ch %02d : FAILED - DAC calibration data timeout\n", ch);
+    } else {
+      printf("Ch %02d : -F- |\n", ch);
+    }
+    return;
+  }
+
+  printf("Ch %02d : ", ch);
+  if (!verbose) {
+    for (int i = 0; i < result->completed_iterations; i++) {
+      if (result->division_by_zero[i]) {
+        printf("%+.4f A ( inf.) | ", result->offset_amps[i]);
+      } else if (result->slope[i] < 0) {
+        printf("%+.4f A ( neg.) | ", result->offset_amps[i]);
+      } else if (result->slope[i] > 9.99) {
+        printf("%+.4f A (9.999) | ", result->offset_amps[i]);
+      } else {
+        printf("%+.4f A (%.3f) | ", result->offset_amps[i], result->slope[i]);
+      }
+    }
+  }
+
+  // Pad skipped iterations to maintain column alignment
+  for (int i = result->completed_iterations; i < CHANNEL_CAL_ITERATIONS; i++) {
+    if (verbose) printf("  -- Skipped iteration number %d", i + 1);
+    else printf("----------------- | ");
+  }
+
+  if (verbose) {
+    if (result->failed) {
+      printf(" Calibration FAILED (code bug)");
+    } else if (result->poor_linearity) {
+      printf(" Poor linearity (check connections)");
+    } else {
+      printf(" Calibration OK");
+    }
+  } else {
+    if (result->failed) {
+      printf("-F- |");
+    } else if (result->poor_linearity) {
+      printf("-X- |");
+    } else {
+      printf("--- |");
+    }
+  }
+  printf("\n");
+}
+
 // Channel calibration command implementation
 int cmd_channel_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   // Parse arguments - either a channel number (0-63) or "all"
@@ -452,329 +626,117 @@ int cmd_channel_cal(const char** args, int arg_count, const command_flag_t* flag
   }
   usleep(1000); // 1ms to let cancel commands complete
   
-  // Calibration constants
-  const int dac_values[] = {-3276, -1638, 0, 1638, 3276};
-  const int num_dac_values = 5;
-  const int average_count = 10;
-  const int calibration_iterations = 3;
-  const int delay_ms = 1; // 1ms delay
-  
-  // Iterate through all channels to calibrate
+  // Calibrate the boards in parallel: one worker thread per board walks that board's
+  // channels, and the rows are printed here in channel order as they complete
+  channel_cal_result_t results[64];
+  memset(results, 0, sizeof(results));
+  channel_cal_board_t work[8];
+  pthread_t threads[8];
+  bool thread_started[8] = {false};
+  volatile bool abort_cal = false;
+
+  for (int board = 0; board < 8; board++) {
+    int board_start = board * 8 > start_ch ? board * 8 : start_ch;
+    int board_end = board * 8 + 7 < end_ch ? board * 8 + 7 : end_ch;
+    if (!connected_boards[board] || board_start > board_end) continue;
+
+    work[board] = (channel_cal_board_t){
+      .ctx = ctx,
+      .board = board,
+      .start_ch = board_start,
+      .end_ch = board_end,
+      .results = results,
+      .abort_flag = &abort_cal
+    };
+    if (pthread_create(&threads[board], NULL, channel_cal_board_thread, &work[board]) != 0) {
+      fprintf(stderr, "Failed to create calibration thread for board %d\n", board);
+      abort_cal = true;
+      break;
+    }
+    thread_started[board] = true;
+  }
+
+  bool halted = false;
   for (int ch = start_ch; ch <= end_ch; ch++) {
-    int board, channel;
-    board = ch / 8;
-    channel = ch % 8;
-    
-    // If calibrating all channels, skip boards that are not connected
-    if (calibrate_all && !connected_boards[board]) {
-      continue;
+    if (!thread_started[ch / 8]) continue;
+    while (!__atomic_load_n(&results[ch].done, __ATOMIC_ACQUIRE)) {
+      usleep(1000); // 1ms
     }
-    
-    printf("Ch %02d : ", ch);
+    if (halted || results[ch].skipped) continue;
+    print_channel_cal_result(ch, &results[ch], *(ctx->verbose));
     fflush(stdout);
-    
-    if (*(ctx->verbose)) {
-      printf("\n  Starting calibration for channel %d (board %d, channel %d)\n", ch, board, channel);
+    if (results[ch].halted) {
+      halted = true;
     }
-    
-    // Get current DAC calibration value and store it
-    dac_cmd_get_cal(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, *(ctx->verbose));
-    
-    // Wait for calibration data to be available
-    int tries = 0;
-    uint32_t dac_data_fifo_status;
-    while (tries < 100) {
-      dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-      if (FIFO_STS_WORD_COUNT(dac_data_fifo_status) > 0) break;
-      usleep(100); // 0.1ms
-      tries++;
+  }
+
+  for (int board = 0; board < 8; board++) {
+    if (thread_started[board]) {
+      pthread_join(threads[board], NULL);
     }
-    
-    if (FIFO_STS_WORD_COUNT(dac_data_fifo_status) == 0) {
-      if (*(ctx->verbose)) {
-        printf("FAILED - DAC calibration data timeout (no data in FIFO after %d tries)\n", tries);
-      } else {
-        printf("-F- |\n");
-      }
-      
-      // Check hardware status when calibration fails - if system is halted, abort calibration
-      printf("Reading hardware status register...\n");
-      uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, *(ctx->verbose));
-      if (HW_STS_STATE(hw_status) == S_HALTED) {
-        printf("Hardware status shows system is HALTED. Aborting channel calibration.\n");
-        print_hw_status(hw_status, *(ctx->verbose));
-        return -1;
-      }
-      
-      continue;
+  }
+
+  // Remember the offsets now set in the DAC cores
+  int64_t now = (int64_t)time(NULL);
+  for (int ch = start_ch; ch <= end_ch; ch++) {
+    if (!thread_started[ch / 8] || results[ch].completed_iterations == 0) continue;
+    ctx->dac_cal[ch] = results[ch].final_cal;
+    ctx->dac_cal_valid[ch] = true;
+    ctx->dac_cal_time[ch / 8] = now;
+  }
+
+  // If a failure left the hardware halted, abort calibration
+  if (halted || abort_cal) {
+    uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, *(ctx->verbose));
+    if (HW_STS_STATE(hw_status) == S_HALTED) {
+      printf("Hardware status shows system is HALTED. Aborting channel calibration.\n");
+      print_hw_status(hw_status, *(ctx->verbose));
     }
+    return -1;
+  }
+  
+  autosave_calibration(ctx);
+  return 0;
+}
+
+// Thread function for trigger monitoring
+static void* trigger_monitor_thread(void* arg) {
+  trigger_monitor_params_t* params = (trigger_monitor_params_t*)arg;
+  time_t last_display = time(NULL);
+  uint32_t last_trigger_count = 0;  // Since we reset count after sync, start from 0
+  bool completed_message_shown = false;
+  
+  if (params->verbose) {
+    fprintf(params->out, "Trigger monitor thread started. Expected: %u triggers\n",
+           params->expected_total_triggers);
+  }
+  
+  while (!*(params->should_stop)) {
+    usleep(500000); // 500ms polling interval
     
-    uint32_t original_cal_data_word = dac_read_data(ctx->dac_ctrl, (uint8_t)board);
-    uint16_t original_cal_value = DAC_CAL_DATA_VAL(original_cal_data_word);
-    int16_t current_cal_value = original_cal_value;
+    uint32_t current_trigger_count = sys_sts_get_trig_counter(params->sys_sts, false);
+    // Since we reset the count after sync_ch, current_trigger_count is the actual triggers received
     
-    // Perform calibration iterations
-    bool calibration_failed = false;
-    bool poor_linearity = false;
-    int completed_iterations = 0;
+    // Check if 3 seconds have passed since last display
+    time_t current_time = time(NULL);
+    if (current_time - last_display >= 3) {
+      fprintf(params->out, "Trigger count: %u/%u\n", 
+             current_trigger_count, params->expected_total_triggers);
+      fflush(params->out);
+      last_display = current_time;
+    }
     
-    for (int iter = 0; iter < calibration_iterations && !calibration_failed && !poor_linearity; iter++) {
-      // Arrays to store DAC values and corresponding averaged ADC readings
-      double dac_vals[num_dac_values];
-      double avg_adc_vals[num_dac_values];
-      
-      // Test each DAC value
-      for (int i = 0; i < num_dac_values; i++) {
-        int16_t dac_val = dac_values[i];
-        dac_vals[i] = (double)dac_val;
-        
-        if (*(ctx->verbose)) {
-          printf("    Testing DAC value %d (%d/%d), averaging %d samples...\n", dac_val, i+1, num_dac_values, average_count);
-        }
-        
-        // Perform multiple reads and average them
-        double sum_adc = 0.0;
-        
-        for (int avg = 0; avg < average_count; avg++) {
-          // Write DAC value
-          dac_cmd_dac_wr_ch(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, dac_val, *(ctx->verbose));
-          usleep(delay_ms * 1000); // Wait fixed delay
-          
-          // Read ADC value
-          adc_cmd_adc_rd_ch(ctx->adc_ctrl, (uint8_t)board, (uint8_t)channel, 0, *(ctx->verbose));
-          
-          // Wait for ADC data to be available
-          int adc_tries = 0;
-          uint32_t adc_data_fifo_status;
-          while (adc_tries < 100) {
-            adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-            if (FIFO_STS_WORD_COUNT(adc_data_fifo_status) > 0) break;
-            usleep(100); // 0.1ms
-            adc_tries++;
-          }
-          
-          if (FIFO_STS_WORD_COUNT(adc_data_fifo_status) == 0) {
-            if (*(ctx->verbose)) {
-              printf("      ADC data timeout (no data in FIFO after %d tries)\n", adc_tries);
-            }
-            calibration_failed = true;
-            break;
-          }
-          
-          uint32_t adc_word = adc_read_word(ctx->adc_ctrl, (uint8_t)board);
-          int16_t adc_reading = offset_to_signed(adc_word & 0xFFFF);
-          double adc_value = (double)adc_reading;
-          
-          // Subtract ADC bias if available
-          if (ctx->adc_bias_valid[ch]) {
-            adc_value -= ctx->adc_bias[ch];
-          }
-          
-          if (*(ctx->verbose) && avg < 3) {  // Only show first few readings to avoid spam
-            printf("      Sample %d: ADC raw=0x%08X, signed=%d, bias_corrected=%.1f\n", 
-                   avg+1, adc_word, adc_reading, adc_value);
-          }
-          
-          sum_adc += adc_value;
-        }
-        
-        if (calibration_failed) break;
-        
-        avg_adc_vals[i] = sum_adc / average_count;
+    // Check if we've reached the expected trigger count
+    if (current_trigger_count >= params->expected_total_triggers) {
+      if (!completed_message_shown) {
+        fprintf(params->out, "\nExpected trigger count reached: %u/%u\n", 
+               current_trigger_count, params->expected_total_triggers);
+        fflush(params->out);
+        completed_message_shown = true;
         
-        if (*(ctx->verbose)) {
-          printf("    DAC=%d -> ADC_avg=%.2f\n", dac_val, avg_adc_vals[i]);
-        }
-      }
-      
-      if (calibration_failed) break;
-      
-      // Perform linear regression: y = mx + b
-      // Calculate slope (m) and intercept (b)
-      double sum_x = 0, sum_y = 0, sum_xy = 0, sum_x2 = 0;
-      for (int i = 0; i < num_dac_values; i++) {
-        sum_x += dac_vals[i];
-        sum_y += avg_adc_vals[i];
-        sum_xy += dac_vals[i] * avg_adc_vals[i];
-        sum_x2 += dac_vals[i] * dac_vals[i];
-      }
-      
-      // Check for division by zero before calculating slope
-      double denominator = num_dac_values * sum_x2 - sum_x * sum_x;
-      double slope, intercept;
-      bool division_by_zero = false;
-      
-      if (denominator == 0) {
-        division_by_zero = true;
-        slope = 0; // Set to 0 to avoid using uninitialized value
-        intercept = sum_y / num_dac_values; // Simple average for intercept
-      } else {
-        slope = (num_dac_values * sum_xy - sum_x * sum_y) / denominator;
-        intercept = (sum_y - slope * sum_x) / num_dac_values;
-      }
-      
-      // Check for poor linearity conditions
-      bool this_iter_poor_linearity = false;
-      
-      // Check for division by zero (infinite slope)
-      if (division_by_zero) {
-        this_iter_poor_linearity = true;
-      }
-      // Check for slope outside acceptable range (< 0.99 or > 1.01)
-      else if (slope < 0.95 || slope > 1.05) {
-        this_iter_poor_linearity = true;
-      }
-      // Check for negative slope
-      else if (slope < 0) {
-        this_iter_poor_linearity = true;
-      }
-
-      // If verbose, print the updates to the calibration value
-      if (*(ctx->verbose)) {
-        printf("  Iteration %d: Current cal=%d, Slope=%.4f, Intercept=%.2f\n", 
-               iter + 1, current_cal_value, slope, intercept);
-        fflush(stdout);
-      }
-      
-      // Update calibration value: subtract intercept from current cal value
-      current_cal_value = current_cal_value - (int16_t)(intercept >= 0 ? intercept + 0.5 : intercept - 0.5);
-
-      // Print update info if verbose
-      if (*(ctx->verbose)) {
-        printf("    Updated cal value to %d\n", current_cal_value);
-        fflush(stdout);
-      }
-
-      // Clamp calibration value to valid range
-      if (current_cal_value < -4095) {
-        if (*(ctx->verbose)) {
-          printf("    Calibration value clamped to -4095\n");
-          fflush(stdout);
-        }
-        current_cal_value = -4095;
-      }
-      if (current_cal_value > 4095) {
-        if (*(ctx->verbose)) {
-          printf("    Calibration value clamped to 4095\n");
-          fflush(stdout);
-        }
-        current_cal_value = 4095;
-      }
-      
-      // Set new calibration value
-      dac_cmd_set_cal(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, current_cal_value, *(ctx->verbose));
-      
-      // Convert offset and slope to amps (range -5.1 to 5.1 for ±32767)
-      double offset_amps = intercept * 5.1 / 32767.0;
-      
-      // If NOT verbose, print this iteration's results with special slope formatting
-      if (!*(ctx->verbose)) {
-        if (division_by_zero) {
-          printf("%+.4f A ( inf.) | ", offset_amps);
-        } else if (slope < 0) {
-          printf("%+.4f A ( neg.) | ", offset_amps);
-        } else if (slope > 9.99) {
-          printf("%+.4f A (9.999) | ", offset_amps);
-        } else {
-          printf("%+.4f A (%.3f) | ", offset_amps, slope);
-        }
-      }
-      
-      completed_iterations++;
-      
-      // Set poor linearity flag if this iteration has issues
-      if (this_iter_poor_linearity) {
-        poor_linearity = true;
-      }
-      
-      fflush(stdout);
-    }
-
-    // Zero the channel to finalize
-    dac_cmd_dac_wr_ch(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, 0, *(ctx->verbose));
-    usleep(1000); // 1ms to let DAC settle
-    
-    // Print spaces for skipped iterations to maintain column alignment
-    for (int i = completed_iterations; i < calibration_iterations; i++) {
-      if (*(ctx->verbose)) printf("  -- Skipped iteration number %d", i + 1);
-      else printf("----------------- | "); // 18 spaces to match the format above
-    }
-    
-    // Check hardware status when calibration fails - if system is halted, abort calibration
-    if (calibration_failed) {
-      printf("Reading hardware status register...\n");
-      uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, *(ctx->verbose));
-      if (HW_STS_STATE(hw_status) == S_HALTED) {
-        printf("Hardware status shows system is HALTED. Aborting channel calibration.\n");
-        print_hw_status(hw_status, *(ctx->verbose));
-        return -1;
-      }
-    }
-    
-    // Print final status
-    if (*(ctx->verbose)) {
-      if (calibration_failed) {
-        printf(" Calibration FAILED (code bug)");
-      } else if (poor_linearity) {
-        printf(" Poor linearity (check connections)");
-      } else {
-        printf(" Calibration OK");
-      }
-    }
-    else {
-      if (calibration_failed) {
-        printf("-F- |");
-      } else if (poor_linearity) {
-        printf("-X- |");
-      } else {
-        printf("--- |");
-      }
-    }
-    
-    printf("\n");
-  }
-  
-  return 0;
-}
-
-// Thread function for trigger monitoring
-static void* trigger_monitor_thread(void* arg) {
-  trigger_monitor_params_t* params = (trigger_monitor_params_t*)arg;
-  time_t last_display = time(NULL);
-  uint32_t last_trigger_count = 0;  // Since we reset count after sync, start from 0
-  bool completed_message_shown = false;
-  
-  if (params->verbose) {
-    printf("Trigger monitor thread started. Expected: %u triggers\n",
-           params->expected_total_triggers);
-  }
-  
-  while (!*(params->should_stop)) {
-    usleep(500000); // 500ms polling interval
-    
-    uint32_t current_trigger_count = sys_sts_get_trig_counter(params->sys_sts, false);
-    // Since we reset the count after sync_ch, current_trigger_count is the actual triggers received
-    
-    // Check if 3 seconds have passed since last display
-    time_t current_time = time(NULL);
-    if (current_time - last_display >= 3) {
-      printf("Trigger count: %u/%u\n", 
-             current_trigger_count, params->expected_total_triggers);
-      fflush(stdout);
-      last_display = current_time;
-    }
-    
-    // Check if we've reached the expected trigger count
-    if (current_trigger_count >= params->expected_total_triggers) {
-      if (!completed_message_shown) {
-        printf("\nExpected trigger count reached: %u/%u\n", 
-               current_trigger_count, params->expected_total_triggers);
-        fflush(stdout);
-        completed_message_shown = true;
-        
-        // Auto-stop monitoring after reaching expected count
-        printf("Trigger monitoring auto-stopping after reaching expected count.\n");
-        break;
+        // Auto-stop monitoring after reaching expected count
+        fprintf(params->out, "Trigger monitoring auto-stopping after reaching expected count.\n");
+        break;
       }
     }
     
@@ -782,7 +744,7 @@ static void* trigger_monitor_thread(void* arg) {
   }
   
   if (params->verbose) {
-    printf("Trigger monitor thread stopping\n");
+    fprintf(params->out, "Trigger monitor thread stopping\n");
   }
   
   pthread_exit(NULL);
@@ -800,6 +762,14 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
     return -1;
   }
   
+  // The previous run's command streams read from the plan, so they must be finished first
+  for (int board = 0; board < 8; board++) {
+    if (ctx->dac_cmd_stream_running[board] || ctx->adc_cmd_stream_running[board]) {
+      printf("Error: Command streams from a previous run are still active on board %d. Use 'stop_waveform' first.\n", board);
+      return -1;
+    }
+  }
+  
   // Check if --no_reset and --no_cal flags are present
   bool skip_reset = has_flag(flags, flag_count, FLAG_NO_RESET);
   bool skip_cal = has_flag(flags, flag_count, FLAG_NO_CAL);
@@ -868,7 +838,7 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
     if (prompt_file_selection(dac_prompt, 
                              strlen(previous_dac_file) > 0 ? previous_dac_file : NULL,
                              resolved_dac_files[board], 
-                             sizeof(resolved_dac_files[board])) != 0) {
+                             sizeof(resolved_dac_files[board]), ctx->in) != 0) {
       fprintf(stderr, "Failed to get DAC file for board %d\n", board);
       return -1;
     }
@@ -881,7 +851,7 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
     if (prompt_file_selection(adc_prompt, 
                              strlen(previous_adc_file) > 0 ? previous_adc_file : NULL,
                              resolved_adc_files[board], 
-                             sizeof(resolved_adc_files[board])) != 0) {
+                             sizeof(resolved_adc_files[board]), ctx->in) != 0) {
       fprintf(stderr, "Failed to get ADC file for board %d\n", board);
       return -1;
     }
@@ -908,7 +878,7 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
     printf(": ");
     fflush(stdout);
     
-    if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+    if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
       fprintf(stderr, "Failed to read DAC iteration count input.\n");
       return -1;
     }
@@ -940,7 +910,7 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
     printf(": ");
     fflush(stdout);
     
-    if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+    if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
       fprintf(stderr, "Failed to read ADC iteration count input.\n");
       return -1;
     }
@@ -970,7 +940,7 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
   printf("Enter base output file path: ");
   fflush(stdout);
   
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read output file path.\n");
     return -1;
   }
@@ -998,7 +968,7 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
   printf("Enter SPI clock frequency in MHz: ");
   fflush(stdout);
   
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read SPI frequency.\n");
     return -1;
   }
@@ -1019,7 +989,7 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
   printf("Enter trigger lockout time (milliseconds): ");
   fflush(stdout);
   
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read trigger lockout time.\n");
     return -1;
   }
@@ -1041,82 +1011,15 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
   printf("Calculated lockout: %u cycles (%.3f ms at %.3f MHz)\n", 
          lockout_time, lockout_ms, spi_freq_mhz);
   
-  // Step 7: Calculate expected ADC words and triggers for each connected board
-  uint64_t adc_word_counts[8] = {0};  // Expected ADC words per board
-  uint32_t board_triggers[8] = {0};  // Triggers per board
-  uint32_t total_expected_triggers = 0;
-  
-  if (*(ctx->verbose)) {
-    printf("\nCalculating expected data counts:\n");
-  }
-  
-  // First pass: calculate triggers for each board and validate consistency
-  int reference_trigger_count = -1;
-  for (int board = 0; board < 8; board++) {
-    if (!connected_boards[board]) continue;
-    
-    // Count trigger lines in DAC file
-    int dac_trigger_count = count_trigger_lines_in_file(resolved_dac_files[board]);
-    if (dac_trigger_count < 0) {
-      return -1;
-    }
-    
-    // Count trigger lines in ADC file  
-    int adc_trigger_count = count_trigger_lines_in_file(resolved_adc_files[board]);
-    if (adc_trigger_count < 0) {
-      return -1;
-    }
-    
-    // Calculate total triggers for this board
-    uint32_t dac_total_triggers = dac_trigger_count * dac_iterations[board];
-    uint32_t adc_total_triggers = adc_trigger_count * adc_iterations[board];
-    
-    // Validate that DAC and ADC have same trigger count for this board
-    if (dac_total_triggers != adc_total_triggers) {
-      fprintf(stderr, "Error: Board %d DAC triggers (%u) != ADC triggers (%u)\n", 
-              board, dac_total_triggers, adc_total_triggers);
-      fprintf(stderr, "  DAC: %d triggers/file × %d iterations = %u\n", 
-              dac_trigger_count, dac_iterations[board], dac_total_triggers);
-      fprintf(stderr, "  ADC: %d triggers/file × %d iterations = %u\n", 
-              adc_trigger_count, adc_iterations[board], adc_total_triggers);
-      return -1;
-    }
-    
-    board_triggers[board] = dac_total_triggers;
-    
-    // Validate that all boards have the same trigger count
-    if (reference_trigger_count == -1) {
-      reference_trigger_count = dac_total_triggers;
-    } else if (reference_trigger_count != dac_total_triggers) {
-      fprintf(stderr, "Error: All boards must have the same total trigger count\n");
-      fprintf(stderr, "  Reference (previous boards): %d triggers\n", reference_trigger_count);
-      fprintf(stderr, "  Board %d: %u triggers\n", board, dac_total_triggers);
-      return -1;
-    }
-  }
-  
-  // Second pass: calculate ADC word counts now that triggers are validated
-  for (int board = 0; board < 8; board++) {
-    if (!connected_boards[board]) continue;
-    
-    // Calculate expected number of ADC words from ADC command file using board-specific ADC iterations
-    adc_word_counts[board] = calculate_expected_adc_words(resolved_adc_files[board], adc_iterations[board], *(ctx->verbose));
-    if (adc_word_counts[board] == 0) {
-      fprintf(stderr, "Failed to calculate expected ADC word count from ADC command file for board %d\n", board);
-      return -1;
-    }
-    
-    total_expected_triggers = board_triggers[board]; // All boards have same count
-    
-    if (*(ctx->verbose)) {
-      printf("Board %d: DAC iterations=%d, ADC iterations=%d, triggers=%u, ADC words=%llu\n", 
-             board, dac_iterations[board], adc_iterations[board], board_triggers[board], adc_word_counts[board]);
-    }
-  }
-  
-  if (*(ctx->verbose)) {
-    printf("Total expected external triggers (consistent across all boards): %u\n", total_expected_triggers);
+  // Step 7: Build the run plan: every distinct DAC/ADC file is parsed and encoded once (unchanged
+  // files are reused from the previous run), giving trigger/ADC word counts, FIFO load and duration
+  if (experiment_plan_build(&g_waveform_plan, ctx, connected_boards, resolved_dac_files, resolved_adc_files,
+                            dac_iterations, adc_iterations, lockout_time, spi_freq_mhz, false) != 0) {
+    fprintf(stderr, "Failed to plan the waveform test\n");
+    return -1;
   }
+  experiment_plan_print(&g_waveform_plan, *(ctx->verbose));
+  uint32_t total_expected_triggers = g_waveform_plan.total_triggers;
   
   // Step 8: Run calibration for all boards unless --no_cal flag is set
   if (!skip_cal) {
@@ -1132,7 +1035,7 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
       fflush(stdout);
       
       char response[16];
-      if (fgets(response, sizeof(response), stdin) == NULL) {
+      if (fgets(response, sizeof(response), ctx->in) == NULL) {
         fprintf(stderr, "Failed to read user response\n");
         return -1;
       }
@@ -1165,39 +1068,12 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
     adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, true, false, 1, *(ctx->verbose)); // Wait for 1 trigger
   }
 
-  // Step 10a: Start command streaming for each connected board
+  // Step 10a: Start command streaming for each connected board from the plan's encoded words
   if (*(ctx->verbose)) {
     printf("\nStarting command streaming for %d connected boards...\n", connected_count);
   }
-  for (int board = 0; board < 8; board++) {
-    if (!connected_boards[board]) continue;
-    
-    char board_str[16], dac_iterations_str[16], adc_iterations_str[16];
-    snprintf(board_str, sizeof(board_str), "%d", board);
-    snprintf(dac_iterations_str, sizeof(dac_iterations_str), "%d", dac_iterations[board]);
-    snprintf(adc_iterations_str, sizeof(adc_iterations_str), "%d", adc_iterations[board]);
-    
-    // Start DAC command streaming with board-specific DAC iteration count
-    if (*(ctx->verbose)) {
-      printf("  Board %d: Starting DAC command streaming from '%s' (%d iterations)\n", 
-             board, resolved_dac_files[board], dac_iterations[board]);
-    }
-    const char* dac_args[] = {board_str, resolved_dac_files[board], dac_iterations_str};
-    if (cmd_stream_dac_commands_from_file(dac_args, 3, NULL, 0, ctx) != 0) {
-      fprintf(stderr, "Failed to start DAC command streaming for board %d\n", board);
-      return -1;
-    }
-    
-    // Start ADC command streaming with board-specific ADC iteration count
-    if (*(ctx->verbose)) {
-      printf("  Board %d: Starting ADC command streaming from '%s' (%d iterations)\n", 
-             board, resolved_adc_files[board], adc_iterations[board]);
-    }
-    const char* adc_args[] = {board_str, resolved_adc_files[board], adc_iterations_str};
-    if (cmd_stream_adc_commands_from_file(adc_args, 3, NULL, 0, ctx) != 0) {
-      fprintf(stderr, "Failed to start ADC command streaming for board %d\n", board);
-      return -1;
-    }
+  if (experiment_plan_start_streams(&g_waveform_plan, ctx) != 0) {
+    return -1;
   }
   
   // Step 10b: Start ADC data streaming for each connected board
@@ -1222,11 +1098,11 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
     
     char board_str[16], word_count_str[32];
     snprintf(board_str, sizeof(board_str), "%d", board);
-    snprintf(word_count_str, sizeof(word_count_str), "%llu", adc_word_counts[board]);
+    snprintf(word_count_str, sizeof(word_count_str), "%llu", (unsigned long long)g_waveform_plan.board[board].adc_data_words);
     
     if (*(ctx->verbose)) {
       printf("  Board %d: Starting ADC data streaming to '%s' (%llu ADC words)\n", 
-             board, board_output_file, adc_word_counts[board]);
+             board, board_output_file, (unsigned long long)g_waveform_plan.board[board].adc_data_words);
     }
     const char* adc_data_args[] = {board_str, word_count_str, board_output_file};
     if (cmd_stream_adc_data_to_file(adc_data_args, 3, NULL, 0, ctx) != 0) {
@@ -1330,7 +1206,7 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
     printf("Do you want to proceed anyway? (y/N): ");
     fflush(stdout);
     
-    if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+    if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
       printf("Failed to read user input, aborting\n");
       return -1;
     }
@@ -1394,6 +1270,7 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
   monitor_params.expected_total_triggers = total_expected_triggers; // Just the external triggers
   monitor_params.should_stop = &g_trigger_monitor_should_stop;
   monitor_params.verbose = *(ctx->verbose);
+  monitor_params.out = ctx->console_out;
   
   int thread_result = pthread_create(&g_trigger_monitor_tid, NULL, trigger_monitor_thread, &monitor_params);
   if (thread_result != 0) {
@@ -1437,7 +1314,7 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
     printf("Expected data collection:\n");
     for (int board = 0; board < 8; board++) {
       if (!connected_boards[board]) continue;
-      printf("  - Board %d: %llu ADC words\n", board, adc_word_counts[board]);
+      printf("  - Board %d: %llu ADC words\n", board, (unsigned long long)g_waveform_plan.board[board].adc_data_words);
     }
     if (total_expected_triggers > 0) {
       printf("  - Trigger data: %u samples\n", total_expected_triggers);
@@ -1539,44 +1416,189 @@ int cmd_stop_waveform(const char** args, int arg_count, const command_flag_t* fl
   return 0;
 }
 
+// Fieldmap sweep: every step's DAC, ADC and trigger commands, precomputed so the hardware runs
+// the whole sweep unattended. The host only tops up the command FIFOs and drains results.
+#define FIELDMAP_MAX_STEPS           128 // Two polarities for each of 64 channels
+#define FIELDMAP_ADC_WORDS_PER_STEP  3   // Trigger wait, settle delay, ADC_RD
+#define FIELDMAP_MAX_TRIG_WORDS      (4 + 2 * FIELDMAP_MAX_STEPS)
+
+typedef struct {
+  int steps;
+  uint32_t* dac_words[8];             // One DAC_WR per step, then a final zeroing DAC_WR
+  uint32_t* adc_words[8];
+  uint32_t trig_words[FIELDMAP_MAX_TRIG_WORDS];
+  uint32_t dac_count[8];
+  uint32_t adc_count[8];
+  uint32_t trig_count;
+  uint32_t dac_sent[8];               // Words already pushed into each FIFO
+  uint32_t adc_sent[8];
+  uint32_t trig_sent;
+} fieldmap_sweep_t;
+
 // Fieldmap data collection thread structure
 typedef struct {
   command_context_t* ctx;
+  fieldmap_sweep_t sweep;
   int start_channel;
   int end_channel;
-  double amplitude;
   double delay_ms;
   uint32_t delay_cycles;
   double spi_freq_mhz;
-  const char* log_file;
+  uint32_t step_cycles;               // Internally timed step period (0 for external triggers)
+  FILE* file;
+  char log_file[1024];
   bool connected_boards[8];
   bool verbose;
   volatile bool* should_stop;
+
+  // Results, filled in bulk by the acquisition thread and consumed by the CSV writer
+  uint32_t* adc_data[8];              // 4 words per step per board
+  uint64_t* timestamps;               // Trigger timestamp per step
+  pthread_mutex_t lock;
+  pthread_cond_t rows_cond;
+  int rows_ready;                     // Steps with every board's data and a timestamp
+  bool acquisition_done;
 } fieldmap_params_t;
 
-// Thread function for fieldmap data collection
-static void* fieldmap_thread(void* arg) {
+// Build the sweep: for each channel in turn, +amplitude then -amplitude on that channel with every
+// other channel at zero. Each step is released by one trigger: external ones (with lockout) when
+// step_cycles is 0, otherwise internal ones forced by the trigger core every step_cycles.
+// A DAC_WR updates the outputs first and then waits for its trigger, so each step's DAC_WR waits on
+// the next step's trigger; the DAC must already be waiting for the first one (see cmd_fieldmap).
+// The last step is held for hold_cycles (long enough for the settle delay and the read) before
+// every channel is zeroed. The trigger count reset keeps the current trigger data format.
+static int build_fieldmap_sweep(fieldmap_sweep_t* sweep, const bool connected_boards[8], int start_ch, int end_ch,
+                                int16_t dac_amplitude, uint32_t delay_cycles, uint32_t lockout_cycles,
+                                uint32_t step_cycles, uint32_t hold_cycles, uint32_t dac_wr_min_delay,
+                                bool trig_delta_log) {
+  memset(sweep, 0, sizeof(*sweep));
+  sweep->steps = (end_ch - start_ch + 1) * 2;
+
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    sweep->dac_words[board] = malloc((size_t)(sweep->steps + 1) * DAC_WR_WORDCOUNT * sizeof(uint32_t));
+    sweep->adc_words[board] = malloc((size_t)sweep->steps * FIELDMAP_ADC_WORDS_PER_STEP * sizeof(uint32_t));
+    if (sweep->dac_words[board] == NULL || sweep->adc_words[board] == NULL) {
+      return -1;
+    }
+
+    uint32_t* dac = sweep->dac_words[board];
+    uint32_t* adc = sweep->adc_words[board];
+    for (int step = 0; step < sweep->steps; step++) {
+      int ch = start_ch + step / 2;
+      int16_t ch_vals[8] = {0};
+      if (ch / 8 == board) {
+        ch_vals[ch % 8] = (step % 2 == 0) ? dac_amplitude : (int16_t)-dac_amplitude;
+      }
+      bool last_step = (step == sweep->steps - 1);
+      dac_encode_dac_wr(&dac[step * DAC_WR_WORDCOUNT], ch_vals, !last_step, false, true, last_step ? hold_cycles : 1);
+      // Wait for the step's trigger, settle, then read all channels
+      adc[step * FIELDMAP_ADC_WORDS_PER_STEP + 0] = adc_encode_cmd(ADC_CMD_NO_OP, true, true, 1);
+      adc[step * FIELDMAP_ADC_WORDS_PER_STEP + 1] = adc_encode_cmd(ADC_CMD_NO_OP, false, true, delay_cycles);
+      adc[step * FIELDMAP_ADC_WORDS_PER_STEP + 2] = adc_encode_cmd(ADC_CMD_ADC_RD, true, false, 0);
+    }
+    int16_t zero_vals[8] = {0};
+    dac_encode_dac_wr(&dac[sweep->steps * DAC_WR_WORDCOUNT], zero_vals, false, false, true, dac_wr_min_delay);
+    sweep->dac_count[board] = (uint32_t)(sweep->steps + 1) * DAC_WR_WORDCOUNT;
+    sweep->adc_count[board] = (uint32_t)sweep->steps * FIELDMAP_ADC_WORDS_PER_STEP;
+  }
+
+  // Release the buffer stoppers, restart the trigger count, then one logged trigger per step
+  uint32_t* trig = sweep->trig_words;
+  uint32_t n = 0;
+  trig[n++] = trigger_encode_cmd(TRIG_CMD_SYNC_CH, false, 0);
+  trig[n++] = trigger_encode_reset_count(trig_delta_log);
+  if (step_cycles == 0) {
+    trig[n++] = trigger_encode_cmd(TRIG_CMD_SET_LOCKOUT, false, lockout_cycles);
+    trig[n++] = trigger_encode_cmd(TRIG_CMD_EXPECT_EXT, true, (uint32_t)sweep->steps);
+  } else {
+    for (int step = 0; step < sweep->steps; step++) {
+      trig[n++] = trigger_encode_cmd(TRIG_CMD_DELAY, false, step_cycles);
+      trig[n++] = trigger_encode_cmd(TRIG_CMD_FORCE_TRIG, true, 0);
+    }
+  }
+  sweep->trig_count = n;
+  return 0;
+}
+
+static void free_fieldmap_sweep(fieldmap_sweep_t* sweep) {
+  for (int board = 0; board < 8; board++) {
+    free(sweep->dac_words[board]);
+    free(sweep->adc_words[board]);
+    sweep->dac_words[board] = NULL;
+    sweep->adc_words[board] = NULL;
+  }
+}
+
+// Words that can be pushed from a stream into a FIFO, in whole units of `unit` words
+static uint32_t fifo_push_count(uint32_t fifo_status, uint32_t fifo_depth, uint32_t remaining, uint32_t unit) {
+  uint32_t used = FIFO_STS_WORD_COUNT(fifo_status) + 1; // +1 for safety margin
+  uint32_t space = used < fifo_depth ? fifo_depth - used : 0;
+  uint32_t count = remaining < space ? remaining : space;
+  return count - count % unit;
+}
+
+// Top up the command FIFOs from the sweep. Returns true once the whole sweep is queued.
+static bool feed_fieldmap_sweep(command_context_t* ctx, fieldmap_sweep_t* sweep, const bool connected_boards[8]) {
+  bool all_queued = true;
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    uint32_t remaining = sweep->dac_count[board] - sweep->dac_sent[board];
+    if (remaining > 0) {
+      uint32_t count = fifo_push_count(sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false),
+                                       DAC_CMD_FIFO_WORDCOUNT, remaining, DAC_WR_WORDCOUNT);
+      dac_write_cmd_words(ctx->dac_ctrl, (uint8_t)board, sweep->dac_words[board] + sweep->dac_sent[board], count);
+      sweep->dac_sent[board] += count;
+    }
+    remaining = sweep->adc_count[board] - sweep->adc_sent[board];
+    if (remaining > 0) {
+      uint32_t count = fifo_push_count(sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false),
+                                       ADC_CMD_FIFO_WORDCOUNT, remaining, FIELDMAP_ADC_WORDS_PER_STEP);
+      adc_write_cmd_words(ctx->adc_ctrl, (uint8_t)board, sweep->adc_words[board] + sweep->adc_sent[board], count);
+      sweep->adc_sent[board] += count;
+    }
+    all_queued = all_queued && sweep->dac_sent[board] == sweep->dac_count[board] &&
+                 sweep->adc_sent[board] == sweep->adc_count[board];
+  }
+  uint32_t remaining = sweep->trig_count - sweep->trig_sent;
+  if (remaining > 0) {
+    uint32_t count = fifo_push_count(sys_sts_get_trig_cmd_fifo_status(ctx->sys_sts, false),
+                                     TRIG_CMD_FIFO_WORDCOUNT, remaining, 1);
+    trigger_write_cmd_words(ctx->trigger_ctrl, sweep->trig_words + sweep->trig_sent, count);
+    sweep->trig_sent += count;
+  }
+  return all_queued && sweep->trig_sent == sweep->trig_count;
+}
+
+// CSV writer thread: formats and prints rows as the acquisition thread publishes them
+static void* fieldmap_writer_thread(void* arg) {
   fieldmap_params_t* params = (fieldmap_params_t*)arg;
   command_context_t* ctx = params->ctx;
-  int start_ch = params->start_channel;
-  int end_ch = params->end_channel;
-  double amplitude = params->amplitude;
-  const char* log_file = params->log_file;
+  FILE* file = params->file;
   bool* connected_boards = params->connected_boards;
-  volatile bool* should_stop = params->should_stop;
   double spi_freq_mhz = params->spi_freq_mhz;
-  bool verbose = params->verbose;
+  int total_steps = params->sweep.steps;
   
-  // Open log file
-  FILE* file = fopen(log_file, "w");
-  if (file == NULL) {
-    fprintf(stderr, "Fieldmap Thread: Failed to open log file '%s': %s\n", log_file, strerror(errno));
-    return NULL;
+  // Corrections applied to every sample (cal_fit tables, else the ADC bias)
+  struct cal_table_t correction;
+  get_adc_correction(ctx, &correction);
+  int fitted_channels = 0, bias_channels = 0;
+  for (int ch = 0; ch < 64; ch++) {
+    if (correction.status[ch] == CAL_FIT_OK) fitted_channels++;
+    if (correction.status[ch] == CAL_FIT_OFFSET_ONLY) bias_channels++;
   }
   
   // Write delay information and CSV header
   fprintf(file, "# ADC Delay: %.3f ms (%" PRIu32 " clock cycles at %.3f MHz SPI frequency)\n",
           params->delay_ms, params->delay_cycles, spi_freq_mhz);
+  if (params->step_cycles > 0) {
+    fprintf(file, "# Trigger: internal, every %.3f ms (%" PRIu32 " clock cycles)\n",
+            params->step_cycles / (spi_freq_mhz * 1000.0), params->step_cycles);
+  } else {
+    fprintf(file, "# Trigger: external\n");
+  }
+  fprintf(file, "# ADC correction: %d channels gain/offset fitted, %d channels bias only\n",
+          fitted_channels, bias_channels);
   fprintf(file, "time_sec,channel,polarity");
   for (int board = 0; board < 8; board++) {
     if (!connected_boards[board]) continue;
@@ -1588,220 +1610,202 @@ static void* fieldmap_thread(void* arg) {
   fprintf(file, "\n");
   fflush(file);
   
-  int current_channel = start_ch;
-  bool positive_polarity = true; // Start with positive polarity
-  int total_samples_expected = (end_ch - start_ch + 1) * 2; // 2 polarities per channel
-  int samples_collected = 0;
-  
-  printf("Fieldmap Thread: Starting data collection for %d samples\n", total_samples_expected);
-  if (verbose) {
-    printf("Fieldmap Thread [VERBOSE]: Channels %d-%d, verbose mode enabled\n", start_ch, end_ch);
-    printf("Fieldmap Thread [VERBOSE]: Connected boards: ");
-    for (int i = 0; i < 8; i++) {
-      if (connected_boards[i]) printf("%d ", i);
-    }
-    printf("\n");
-  }
-  
-  // Time-based verbose logging variables
-  time_t last_verbose_time = time(NULL);
-  time_t last_status_check_time = time(NULL);
-  
-  while (samples_collected < total_samples_expected && !(*should_stop)) {
-    int current_board = current_channel / 8;
-    time_t current_time = time(NULL);
-    
-    // Check if all connected boards have data available (4 words each) and trigger has 2 words
-    bool all_data_ready = true;
-    uint32_t trig_status = sys_sts_get_trig_data_fifo_status(ctx->sys_sts, false);
-    
-    // Periodic system status check and verbose logging (once every 5 seconds)
-    if ((current_time - last_status_check_time) >= 5) {
-      // Check system status for halt conditions (always run)
-      uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, false);
-      uint32_t state = HW_STS_STATE(hw_status);
-      uint32_t status_code = HW_STS_CODE(hw_status);
-      
-      if (state != S_RUNNING || status_code != STS_OK) {
-        printf("Fieldmap Thread [ERROR]: System not running properly!\n");
-        print_hw_status(hw_status, true);
-        
-        if (state == S_HALTED) {
-          printf("Fieldmap Thread [ERROR]: System is HALTED - stopping fieldmap!\n");
-          break; // Exit the measurement loop
-        }
-      }
-      
-      // Verbose logging (only when verbose enabled)
-      if (verbose) {
-        printf("Fieldmap Thread [VERBOSE]: Checking for sample %d/%d (ch%02d%c)\n", 
-               samples_collected + 1, total_samples_expected, current_channel,
-               positive_polarity ? '+' : '-');
-        
-        // Show status for all connected boards
-        for (int board = 0; board < 8; board++) {
-          if (!connected_boards[board]) continue;
-          uint32_t adc_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-          printf("Fieldmap Thread [VERBOSE]: Board %d ADC FIFO status=0x%08X (count=%u)\n",
-                 board, adc_status, FIFO_STS_WORD_COUNT(adc_status));
-        }
-        printf("Fieldmap Thread [VERBOSE]: Trigger FIFO status=0x%08X (count=%u)\n",
-               trig_status, FIFO_STS_WORD_COUNT(trig_status));
-      }
-      
-      last_status_check_time = current_time;
+  int rows_written = 0;
+  while (true) {
+    pthread_mutex_lock(&params->lock);
+    while (rows_written == params->rows_ready && !params->acquisition_done) {
+      pthread_cond_wait(&params->rows_cond, &params->lock);
     }
+    int rows_ready = params->rows_ready;
+    bool done = params->acquisition_done;
+    pthread_mutex_unlock(&params->lock);
     
-    // Check that all connected boards have 4 words available and trigger has 2 words
-    for (int board = 0; board < 8; board++) {
-      if (!connected_boards[board]) continue;
-      uint32_t adc_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-      if (FIFO_STS_WORD_COUNT(adc_status) < 4) {
-        all_data_ready = false;
-        break;
-      }
-    }
-    
-    if (all_data_ready && FIFO_STS_WORD_COUNT(trig_status) >= 2) {
-      if (verbose) {
-        printf("Fieldmap Thread [VERBOSE]: Data available! Reading sample %d/%d (ch%02d%c)\n",
-               samples_collected + 1, total_samples_expected, current_channel,
-               positive_polarity ? '+' : '-');
-      }
-      
-      // Read ADC data from all connected boards (4 words each)
-      int16_t channel_data[64]; // Store data for all 64 channels (8 boards x 8 channels)
-      bool channel_valid[64] = {false}; // Track which channels have valid data
+    for (; rows_written < rows_ready; rows_written++) {
+      int current_channel = params->start_channel + rows_written / 2;
+      bool positive_polarity = (rows_written % 2) == 0;
       
+      // Unpack this step's samples (each word holds an even and an odd channel) and correct them
+      int16_t channel_data[64] = {0};
       for (int board = 0; board < 8; board++) {
         if (!connected_boards[board]) continue;
-        
-        // Read 4 words from this board (ADC pair data)
+        uint32_t adc_words[4];
+        cal_table_apply_words(&correction, (uint8_t)board, &params->adc_data[board][rows_written * 4], adc_words, 4, 0);
         for (int word = 0; word < 4; word++) {
-          uint32_t adc_word = adc_read_word(ctx->adc_ctrl, (uint8_t)board);
-          
-          // Each word contains 2 channels (lower 16 bits = even channel, upper 16 bits = odd channel)
           int ch_base = board * 8 + word * 2;
-          int16_t ch_even_raw = offset_to_signed(adc_word & 0xFFFF);
-          int16_t ch_odd_raw = offset_to_signed((adc_word >> 16) & 0xFFFF);
-          
-          // Apply bias correction for even channel
-          int16_t ch_even = ch_even_raw;
-          if (ch_base < 64 && ctx->adc_bias_valid[ch_base]) {
-            double corrected = (double)ch_even_raw - ctx->adc_bias[ch_base];
-            ch_even = (int16_t)(corrected + (corrected >= 0 ? 0.5 : -0.5));
-          }
-          
-          // Apply bias correction for odd channel  
-          int16_t ch_odd = ch_odd_raw;
-          if (ch_base + 1 < 64 && ctx->adc_bias_valid[ch_base + 1]) {
-            double corrected = (double)ch_odd_raw - ctx->adc_bias[ch_base + 1];
-            ch_odd = (int16_t)(corrected + (corrected >= 0 ? 0.5 : -0.5));
-          }
-          
-          if (ch_base < 64) {
-            channel_data[ch_base] = ch_even;
-            channel_valid[ch_base] = true;
-          }
-          if (ch_base + 1 < 64) {
-            channel_data[ch_base + 1] = ch_odd;
-            channel_valid[ch_base + 1] = true;
-          }
+          channel_data[ch_base] = offset_to_signed(adc_words[word] & 0xFFFF);
+          channel_data[ch_base + 1] = offset_to_signed((adc_words[word] >> 16) & 0xFFFF);
         }
       }
-      
-      // Read trigger data (64-bit)
-      uint64_t trigger_data = trigger_read(ctx->trigger_ctrl);
-      double time_seconds = (double)trigger_data / (spi_freq_mhz * 1e6);
-      
-      if (verbose) {
-        printf("Fieldmap Thread [VERBOSE]: Read data from all boards, trigger_data=0x%016llX (%.6f sec)\n",
-               (unsigned long long)trigger_data, time_seconds);
-      }
+      double time_seconds = (double)params->timestamps[rows_written] / (spi_freq_mhz * 1e6);
       
       // Write to CSV file - connected channels only
       fprintf(file, "%.4f,ch%02d,%c", time_seconds, current_channel, positive_polarity ? '+' : '-');
+      double target_current = 0.0;
+      double max_other_current = 0.0;
+      int max_other_channel = -1;
       for (int board = 0; board < 8; board++) {
         if (!connected_boards[board]) continue;
         for (int ch_offset = 0; ch_offset < 8; ch_offset++) {
           int ch = board * 8 + ch_offset;
-          if (channel_valid[ch]) {
-            double current_amps = (double)channel_data[ch] / 32767.0 * 5.1;
-            fprintf(file, ",%.3f", current_amps);
-          } else {
-            fprintf(file, ",0.000");  // Default value for channels on connected boards
+          double current_amps = (double)channel_data[ch] / 32767.0 * 5.1;
+          fprintf(file, ",%.3f", current_amps);
+          if (ch == current_channel) {
+            target_current = current_amps;
+          } else if (max_other_channel == -1 || fabs(current_amps) > fabs(max_other_current)) {
+            max_other_current = current_amps;
+            max_other_channel = ch;
           }
         }
       }
       fprintf(file, "\n");
-      fflush(file);
-      
-      // Find target channel data and max current from other channels
-      double target_current = 0.0;
-      if (channel_valid[current_channel]) {
-        target_current = (double)channel_data[current_channel] / 32767.0 * 5.1;
-      }
-      
-      double max_other_current = 0.0;
-      int max_other_channel = -1;
-      for (int ch = 0; ch < 64; ch++) {
-        if (ch == current_channel || !channel_valid[ch]) continue;
-        double current_amps = (double)channel_data[ch] / 32767.0 * 5.1;
-        double abs_current = (current_amps < 0.0) ? -current_amps : current_amps;
-        double abs_max = (max_other_current < 0.0) ? -max_other_current : max_other_current;
-        if (abs_current > abs_max) {
-          max_other_current = current_amps;
-          max_other_channel = ch;
-        }
-      }
       
-      // Print ADC values in real-time
+      // Print ADC values as they arrive
       if (max_other_channel != -1) {
-        printf("Fieldmap: ch%02d%c = %7.3f A | max_other: ch%02d = %7.3f A [%d/%d]\n", 
+        fprintf(ctx->console_out, "Fieldmap: ch%02d%c = %7.3f A | max_other: ch%02d = %7.3f A [%d/%d]\n", 
                current_channel, positive_polarity ? '+' : '-', target_current,
-               max_other_channel, max_other_current,
-               samples_collected + 1, total_samples_expected);
+               max_other_channel, max_other_current, rows_written + 1, total_steps);
       } else {
-        printf("Fieldmap: ch%02d%c = %7.3f A | [%d/%d]\n", 
+        fprintf(ctx->console_out, "Fieldmap: ch%02d%c = %7.3f A | [%d/%d]\n", 
                current_channel, positive_polarity ? '+' : '-', target_current,
-               samples_collected + 1, total_samples_expected);
-      }
-      fflush(stdout);
-      
-      samples_collected++;
-      
-      // Advance to next measurement
-      if (positive_polarity) {
-        positive_polarity = false; // Switch to negative
-      } else {
-        positive_polarity = true;  // Switch back to positive
-        current_channel++;         // Move to next channel
-      }
-    } else {
-      // No data available, sleep briefly
-      if (verbose && (current_time - last_verbose_time) >= 5) {
-        printf("Fieldmap Thread [VERBOSE]: No data available (Trigger count=%u), waiting...\n",
-               FIFO_STS_WORD_COUNT(trig_status));
-        last_verbose_time = current_time;
+               rows_written + 1, total_steps);
       }
-      usleep(1000); // 1ms
     }
+    fflush(file);
+    fflush(ctx->console_out);
+    
+    if (done && rows_written == rows_ready) break;
   }
   
-  if (verbose) {
-    printf("Fieldmap Thread [VERBOSE]: Fieldmap ended - samples_collected=%d, total_expected=%d, should_stop=%s\n",
-           samples_collected, total_samples_expected, *should_stop ? "true" : "false");
-  }
-  
-  fclose(file);
-  
-  if (*should_stop) {
-    printf("Fieldmap Thread: Stopped by user after collecting %d samples\n", samples_collected);
+  return NULL;
+}
+
+// Thread function for fieldmap data collection: keeps the command FIFOs fed and drains
+// whatever results the hardware has produced, handing complete steps to the CSV writer
+static void* fieldmap_thread(void* arg) {
+  fieldmap_params_t* params = (fieldmap_params_t*)arg;
+  command_context_t* ctx = params->ctx;
+  fieldmap_sweep_t* sweep = &params->sweep;
+  bool* connected_boards = params->connected_boards;
+  volatile bool* should_stop = params->should_stop;
+  bool verbose = params->verbose;
+  int total_steps = sweep->steps;
+  
+  pthread_t writer;
+  if (pthread_create(&writer, NULL, fieldmap_writer_thread, params) != 0) {
+    fprintf(ctx->console_err, "Fieldmap Thread: Failed to create CSV writer thread\n");
+    abort_queued_commands(ctx, connected_boards, ctx->console_out);
+    goto cleanup;
+  }
+  
+  fprintf(ctx->console_out, "Fieldmap Thread: Starting data collection for %d samples\n", total_steps);
+  if (verbose) {
+    fprintf(ctx->console_out, "Fieldmap Thread [VERBOSE]: Channels %d-%d, verbose mode enabled\n", params->start_channel, params->end_channel);
+    fprintf(ctx->console_out, "Fieldmap Thread [VERBOSE]: Connected boards: ");
+    for (int i = 0; i < 8; i++) {
+      if (connected_boards[i]) fprintf(ctx->console_out, "%d ", i);
+    }
+    fprintf(ctx->console_out, "\n");
+  }
+  
+  uint32_t adc_received[8] = {0};
+  int trig_received = 0;
+  bool all_queued = false;
+  int rows_ready = 0;
+  time_t last_status_check_time = time(NULL);
+  
+  while (rows_ready < total_steps && !(*should_stop)) {
+    if (!all_queued) {
+      all_queued = feed_fieldmap_sweep(ctx, sweep, connected_boards);
+    }
+    
+    // Drain everything each FIFO holds
+    bool progress = false;
+    int rows_complete = total_steps;
+    for (int board = 0; board < 8; board++) {
+      if (!connected_boards[board]) continue;
+      uint32_t wanted = (uint32_t)total_steps * 4 - adc_received[board];
+      uint32_t available = FIFO_STS_WORD_COUNT(sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false));
+      uint32_t count = available < wanted ? available : wanted;
+      if (count > 0) {
+        adc_read_words(ctx->adc_ctrl, (uint8_t)board, &params->adc_data[board][adc_received[board]], count);
+        adc_received[board] += count;
+        progress = true;
+      }
+      if ((int)(adc_received[board] / 4) < rows_complete) rows_complete = (int)(adc_received[board] / 4);
+    }
+    uint32_t trig_words = FIFO_STS_WORD_COUNT(sys_sts_get_trig_data_fifo_status(ctx->sys_sts, false));
+    if (trig_words > 0 && trig_received < total_steps) {
+      size_t decoded = trigger_read_timestamps(ctx->trigger_ctrl, &params->timestamps[trig_received],
+                                               (size_t)(total_steps - trig_received), trig_words);
+      trig_received += (int)decoded;
+      progress = true;
+    }
+    if (trig_received < rows_complete) rows_complete = trig_received;
+    
+    if (rows_complete > rows_ready) {
+      rows_ready = rows_complete;
+      pthread_mutex_lock(&params->lock);
+      params->rows_ready = rows_ready;
+      pthread_cond_signal(&params->rows_cond);
+      pthread_mutex_unlock(&params->lock);
+    }
+    
+    // Periodic system status check and verbose logging (once every 5 seconds)
+    time_t current_time = time(NULL);
+    if ((current_time - last_status_check_time) >= 5) {
+      uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, false);
+      uint32_t state = HW_STS_STATE(hw_status);
+      uint32_t status_code = HW_STS_CODE(hw_status);
+      
+      if (state != S_RUNNING || status_code != STS_OK) {
+        fprintf(ctx->console_out, "Fieldmap Thread [ERROR]: System not running properly!\n");
+        print_hw_status(hw_status, true);
+        
+        if (state == S_HALTED) {
+          fprintf(ctx->console_out, "Fieldmap Thread [ERROR]: System is HALTED - stopping fieldmap!\n");
+          break;
+        }
+      }
+      if (verbose) {
+        fprintf(ctx->console_out, "Fieldmap Thread [VERBOSE]: %d/%d samples complete, %d timestamps, sweep %s\n",
+               rows_ready, total_steps, trig_received, all_queued ? "fully queued" : "still queueing");
+      }
+      last_status_check_time = current_time;
+    }
+    
+    if (!progress) {
+      usleep(1000); // 1ms
+    }
+  }
+  
+  pthread_mutex_lock(&params->lock);
+  params->acquisition_done = true;
+  pthread_cond_signal(&params->rows_cond);
+  pthread_mutex_unlock(&params->lock);
+  pthread_join(writer, NULL);
+
+  // Stopped, halted, or otherwise ended short: the rest of the sweep is still queued
+  if (rows_ready < total_steps) {
+    abort_queued_commands(ctx, connected_boards, ctx->console_out);
+  }
+
+  if (*should_stop) {
+    fprintf(ctx->console_out, "Fieldmap Thread: Stopped by user after collecting %d samples\n", rows_ready);
   } else {
-    printf("Fieldmap Thread: Collection completed, %d samples written to '%s'\n", 
-           samples_collected, log_file);
+    fprintf(ctx->console_out, "Fieldmap Thread: Collection completed, %d samples written to '%s'\n", 
+           rows_ready, params->log_file);
   }
   
+cleanup:
+  fclose(params->file);
+  free_fieldmap_sweep(sweep);
+  for (int board = 0; board < 8; board++) {
+    free(params->adc_data[board]);
+  }
+  free(params->timestamps);
+  pthread_mutex_destroy(&params->lock);
+  pthread_cond_destroy(&params->rows_cond);
+  free(params);
   return NULL;
 }
 
@@ -1827,7 +1831,7 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
   
   printf("Enter start channel (0-63): ");
   fflush(stdout);
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read start channel.\n");
     return -1;
   }
@@ -1839,7 +1843,7 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
   
   printf("Enter end channel (0-63): ");
   fflush(stdout);
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read end channel.\n");
     return -1;
   }
@@ -1893,7 +1897,7 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
   double amplitude;
   printf("Enter amplitude in amps (0.0 to 5.1): ");
   fflush(stdout);
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read amplitude.\n");
     return -1;
   }
@@ -1906,7 +1910,7 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
   double delay_ms;
   printf("Enter ADC read delay in milliseconds: ");
   fflush(stdout);
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read delay.\n");
     return -1;
   }
@@ -1919,7 +1923,7 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
   double spi_freq_mhz;
   printf("Enter SPI clock frequency in MHz: ");
   fflush(stdout);
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read SPI frequency.\n");
     return -1;
   }
@@ -1930,28 +1934,43 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
   }
   
   double lockout_ms;
-  printf("Enter trigger lockout time in milliseconds: ");
+  printf("Enter trigger lockout time in milliseconds (0 to step on internal triggers instead): ");
   fflush(stdout);
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read lockout time.\n");
     return -1;
   }
   lockout_ms = atof(input_buffer);
-  if (lockout_ms <= 0.0) {
-    fprintf(stderr, "Invalid lockout time. Must be > 0 milliseconds.\n");
+  if (lockout_ms < 0.0) {
+    fprintf(stderr, "Invalid lockout time. Must be >= 0 milliseconds.\n");
     return -1;
   }
+  bool internal_trigger = (lockout_ms == 0.0);
   
   // Calculate delay cycles from milliseconds and SPI frequency
   uint32_t delay_cycles = (uint32_t)(delay_ms * spi_freq_mhz * 1000.0);
+  if (delay_cycles > SPI_TIMING_MAX_DELAY_CYCLES) {
+    fprintf(stderr, "ADC read delay too long (%u cycles, max %u).\n", delay_cycles, SPI_TIMING_MAX_DELAY_CYCLES);
+    return -1;
+  }
   
   // Calculate lockout cycles from milliseconds and SPI frequency  
   uint32_t lockout_cycles = (uint32_t)(lockout_ms * spi_freq_mhz * 1000.0);
   
+  // A step lasts as long as the DAC update, the settle delay and the read take (with a margin);
+  // internally triggered steps follow each other at that rate
+  struct spi_timing_t timing = create_spi_timing((uint32_t)(spi_freq_mhz * 1e6));
+  uint32_t hold_cycles = delay_cycles + timing.adc_rd_min_delay + timing.dac_wr_min_delay + delay_cycles / 10;
+  if (hold_cycles > SPI_TIMING_MAX_DELAY_CYCLES) {
+    fprintf(stderr, "ADC read delay too long (%u cycle steps, max %u).\n", hold_cycles, SPI_TIMING_MAX_DELAY_CYCLES);
+    return -1;
+  }
+  uint32_t step_cycles = internal_trigger ? hold_cycles : 0;
+  
   char log_filename[1024];
   printf("Enter log file name: ");
   fflush(stdout);
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read log file name.\n");
     return -1;
   }
@@ -1983,7 +2002,11 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
   printf("  Channels: %d to %d (%d channels)\n", start_channel, end_channel, end_channel - start_channel + 1);
   printf("  Amplitude: %.3f amps\n", amplitude);
   printf("  Delay: %.3f ms (%u clock cycles)\n", delay_ms, delay_cycles);
-  printf("  Lockout: %.3f ms (%u clock cycles)\n", lockout_ms, lockout_cycles);
+  if (internal_trigger) {
+    printf("  Trigger: internal, every %.3f ms (%u clock cycles)\n", step_cycles / (spi_freq_mhz * 1000.0), step_cycles);
+  } else {
+    printf("  Lockout: %.3f ms (%u clock cycles)\n", lockout_ms, lockout_cycles);
+  }
   printf("  Log file: %s\n", final_log_path);
   printf("  SPI frequency: %.3f MHz\n", spi_freq_mhz);
   
@@ -2002,7 +2025,68 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
     printf("\nSkipping calibration (--no_cal flag set)\n");
   }
   
-  // Step 5: Reset buffers unless --no_reset flag is set
+  // Step 5: Precompute the whole sweep and allocate room for every result
+  int16_t dac_positive = (int16_t)(32767.0 * (amplitude / 5.1));
+  printf("DAC values: +%d, %d (for %.3f amps)\n", dac_positive, -dac_positive, amplitude);
+  
+  fieldmap_params_t* thread_params = calloc(1, sizeof(fieldmap_params_t));
+  if (thread_params == NULL) {
+    fprintf(stderr, "Failed to allocate fieldmap parameters\n");
+    return -1;
+  }
+  thread_params->ctx = ctx;
+  thread_params->start_channel = start_channel;
+  thread_params->end_channel = end_channel;
+  thread_params->delay_ms = delay_ms;
+  thread_params->delay_cycles = delay_cycles;
+  thread_params->spi_freq_mhz = spi_freq_mhz;
+  thread_params->step_cycles = step_cycles;
+  thread_params->verbose = *(ctx->verbose);
+  thread_params->should_stop = &ctx->fieldmap_stop;
+  snprintf(thread_params->log_file, sizeof(thread_params->log_file), "%s", final_log_path);
+  for (int i = 0; i < 8; i++) {
+    thread_params->connected_boards[i] = connected_boards[i];
+  }
+  pthread_mutex_init(&thread_params->lock, NULL);
+  pthread_cond_init(&thread_params->rows_cond, NULL);
+  
+  bool alloc_ok = build_fieldmap_sweep(&thread_params->sweep, connected_boards, start_channel, end_channel,
+                                       dac_positive, delay_cycles, lockout_cycles, step_cycles, hold_cycles,
+                                       timing.dac_wr_min_delay, ctx->trigger_ctrl->delta_log) == 0;
+  int total_steps = thread_params->sweep.steps;
+  thread_params->timestamps = malloc((size_t)total_steps * sizeof(uint64_t));
+  alloc_ok = alloc_ok && thread_params->timestamps != NULL;
+  for (int board = 0; board < 8 && alloc_ok; board++) {
+    if (!connected_boards[board]) continue;
+    thread_params->adc_data[board] = malloc((size_t)total_steps * 4 * sizeof(uint32_t));
+    alloc_ok = thread_params->adc_data[board] != NULL;
+  }
+  if (alloc_ok) {
+    thread_params->file = fopen(final_log_path, "w");
+    if (thread_params->file == NULL) {
+      fprintf(stderr, "Failed to open log file '%s': %s\n", final_log_path, strerror(errno));
+    }
+  } else {
+    fprintf(stderr, "Failed to allocate the fieldmap sweep\n");
+  }
+  if (thread_params->file == NULL) {
+    free_fieldmap_sweep(&thread_params->sweep);
+    for (int board = 0; board < 8; board++) {
+      free(thread_params->adc_data[board]);
+    }
+    free(thread_params->timestamps);
+    pthread_mutex_destroy(&thread_params->lock);
+    pthread_cond_destroy(&thread_params->rows_cond);
+    free(thread_params);
+    return -1;
+  }
+  if (*(ctx->verbose)) {
+    printf("Fieldmap [VERBOSE]: Sweep of %d steps: %u DAC and %u ADC command words per board, %u trigger command words\n",
+           total_steps, thread_params->sweep.dac_count[start_channel / 8], (uint32_t)total_steps * FIELDMAP_ADC_WORDS_PER_STEP,
+           thread_params->sweep.trig_count);
+  }
+  
+  // Step 6: Reset buffers unless --no_reset flag is set
   if (!skip_reset) {
     printf("Resetting buffers...\n");
     safe_buffer_reset(ctx, false);
@@ -2011,163 +2095,38 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
     printf("Skipping buffer reset (--no_reset flag set)\n");
   }
   
-  // Step 6: Add buffer stoppers
+  // Step 7: Add buffer stoppers; the collection thread queues the sweep behind them
   printf("Adding buffer stoppers...\n");
   for (int board = 0; board < 8; board++) {
     if (!connected_boards[board]) continue;
     
     dac_cmd_noop(ctx->dac_ctrl, (uint8_t)board, true, false, false, 1, *(ctx->verbose));
     adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, true, false, 1, *(ctx->verbose));
+    // The DAC writes the first step when the first step trigger arrives
+    dac_cmd_noop(ctx->dac_ctrl, (uint8_t)board, true, false, false, 1, *(ctx->verbose));
   }
   
-  // Calculate DAC values
-  int16_t dac_positive = (int16_t)(32767.0 * (amplitude / 5.1));
-  int16_t dac_negative = -dac_positive;
-  
-  printf("DAC values: +%d, %d (for %.3f amps)\n", dac_positive, dac_negative, amplitude);
-  
-  // Step 7: Queue DAC commands
-  printf("Queueing DAC commands...\n");
-  int total_dac_commands = 0;
-  for (int ch = start_channel; ch <= end_channel; ch++) {
-    int target_board = ch / 8;
-    int target_channel = ch % 8;
-    
-    if (*(ctx->verbose)) {
-      printf("Fieldmap [VERBOSE]: Queueing DAC commands for ch%02d (board %d, channel %d)\n", 
-             ch, target_board, target_channel);
-    }
-    
-    // Positive polarity commands for all boards
-    for (int board = 0; board < 8; board++) {
-      if (!connected_boards[board]) continue;
-      
-      int16_t ch_vals[8] = {0};
-      if (board == target_board) {
-        ch_vals[target_channel] = dac_positive;
-      }
-      
-      dac_cmd_dac_wr(ctx->dac_ctrl, (uint8_t)board, ch_vals, true, false, true, 1, *(ctx->verbose));
-      total_dac_commands++;
-    }
-    
-    // Negative polarity commands for all boards
-    for (int board = 0; board < 8; board++) {
-      if (!connected_boards[board]) continue;
-      
-      int16_t ch_vals[8] = {0};
-      if (board == target_board) {
-        ch_vals[target_channel] = dac_negative;
-      }
-      
-      dac_cmd_dac_wr(ctx->dac_ctrl, (uint8_t)board, ch_vals, true, false, true, 1, *(ctx->verbose));
-      total_dac_commands++;
-    }
-  }
-  
-  if (*(ctx->verbose)) {
-    printf("Fieldmap [VERBOSE]: Queued %d total DAC commands\n", total_dac_commands);
-  }
-  
-  // Step 8: Queue ADC commands
-  printf("Queueing ADC commands...\n");
-  int total_adc_commands = 0;
-  for (int ch = start_channel; ch <= end_channel; ch++) {
-    int target_board = ch / 8;
-    int target_channel = ch % 8;
-    
-    if (*(ctx->verbose)) {
-      printf("Fieldmap [VERBOSE]: Queueing ADC commands for ch%02d (board %d, channel %d)\n", 
-             ch, target_board, target_channel);
-    }
-    
-    // Positive polarity measurement
-    for (int board = 0; board < 8; board++) {
-      if (!connected_boards[board]) continue;
-      
-      // NOOP wait for trigger
-      adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, true, true, 1, *(ctx->verbose));
-      // Delay then read for all connected boards
-      adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, false, true, delay_cycles, *(ctx->verbose));
-      adc_cmd_adc_rd(ctx->adc_ctrl, (uint8_t)board, true, false, 0, 0, *(ctx->verbose));
-      total_adc_commands += 3;
-    }
-    
-    // Negative polarity measurement
-    for (int board = 0; board < 8; board++) {
-      if (!connected_boards[board]) continue;
-      
-      // NOOP wait for trigger
-      adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, true, true, 1, *(ctx->verbose));
-      // Delay then read for all connected boards
-      adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, false, true, delay_cycles, *(ctx->verbose));
-      adc_cmd_adc_rd(ctx->adc_ctrl, (uint8_t)board, true, false, 0, 0, *(ctx->verbose));
-      total_adc_commands += 3;
-    }
-  }
-  
-  if (*(ctx->verbose)) {
-    printf("Fieldmap [VERBOSE]: Queued %d total ADC commands\n", total_adc_commands);
-  }
-  
-  // Step 9: Start data collection thread
-  printf("Starting data collection thread...\n");
-  
-  fieldmap_params_t thread_params = {
-    .ctx = ctx,
-    .start_channel = start_channel,
-    .end_channel = end_channel,
-    .amplitude = amplitude,
-    .delay_ms = delay_ms,
-    .delay_cycles = delay_cycles,
-    .spi_freq_mhz = spi_freq_mhz,
-    .log_file = final_log_path,
-    .verbose = *(ctx->verbose),
-    .should_stop = &ctx->fieldmap_stop
-  };
-  
-  // Copy connected boards array
-  for (int i = 0; i < 8; i++) {
-    thread_params.connected_boards[i] = connected_boards[i];
-  }
-  
+  // Step 8: Start data collection; it queues the DAC, ADC and trigger streams and the sync trigger
+  // releases the sweep once the stoppers are in place
+  printf("Starting data collection thread (%d %s-triggered steps)...\n", total_steps,
+         internal_trigger ? "internally" : "externally");
   ctx->fieldmap_stop = false;
   ctx->fieldmap_running = true;
   
-  if (pthread_create(&(ctx->fieldmap_thread), NULL, fieldmap_thread, &thread_params) != 0) {
+  if (pthread_create(&(ctx->fieldmap_thread), NULL, fieldmap_thread, thread_params) != 0) {
     fprintf(stderr, "Failed to create fieldmap data collection thread\n");
     ctx->fieldmap_running = false;
+    abort_queued_commands(ctx, connected_boards, stdout);
+    fclose(thread_params->file);
+    free_fieldmap_sweep(&thread_params->sweep);
+    for (int board = 0; board < 8; board++) {
+      free(thread_params->adc_data[board]);
+    }
+    free(thread_params->timestamps);
+    free(thread_params);
     return -1;
   }
   
-  // Step 10: Send sync trigger to start
-  printf("Sending sync trigger to start fieldmap...\n");
-  if (*(ctx->verbose)) {
-    printf("Fieldmap [VERBOSE]: Sending sync trigger\n");
-  }
-  trigger_cmd_sync_ch(ctx->trigger_ctrl, false, *(ctx->verbose)); // Use verbose mode for logging
-  
-  // Reset trigger count after sync_ch to start counting from 0
-  if (*(ctx->verbose)) {
-    printf("Fieldmap [VERBOSE]: Resetting trigger count after sync\n");
-  }
-  trigger_cmd_reset_count(ctx->trigger_ctrl, *(ctx->verbose));
-  
-  // Step 11: Set up trigger system after sync
-  int total_triggers = (end_channel - start_channel + 1) * 2; // 2 per channel
-  printf("Setting up trigger system for %d triggers...\n", total_triggers);
-  
-  // Set lockout cycles (calculated earlier from user input)
-  if (*(ctx->verbose)) {
-    printf("Fieldmap [VERBOSE]: Setting lockout to %u cycles (%.3f ms at %.3f MHz)\n", lockout_cycles, lockout_ms, spi_freq_mhz);
-  }
-  trigger_cmd_set_lockout(ctx->trigger_ctrl, lockout_cycles, *(ctx->verbose));
-  
-  if (*(ctx->verbose)) {
-    printf("Fieldmap [VERBOSE]: Expecting %d external triggers\n", total_triggers);
-  }
-  trigger_cmd_expect_ext(ctx->trigger_ctrl, total_triggers, true, *(ctx->verbose)); // Enable logging
-  
   printf("\nFieldmap data collection started successfully!\n");
   printf("Data collection is running in the background.\n");
   printf("ADC values will be printed as they are read.\n");
@@ -2434,12 +2393,12 @@ static void* rev_c_dac_stream_thread(void* arg) {
   bool final_zero_trigger = stream_data->final_zero_trigger;
   bool verbose = *(ctx->verbose);
   
-  printf("Rev C DAC Stream Thread: Starting streaming from file '%s' (%d lines, %d iterations, final_zero=%s)\n", 
+  fprintf(ctx->console_out, "Rev C DAC Stream Thread: Starting streaming from file '%s' (%d lines, %d iterations, final_zero=%s)\n", 
          dac_file, line_count, iterations, final_zero_trigger ? "yes" : "no");
   
   FILE* file = fopen(dac_file, "r");
   if (file == NULL) {
-    fprintf(stderr, "Rev C DAC Stream Thread: Failed to open file '%s': %s\n", dac_file, strerror(errno));
+    fprintf(ctx->console_err, "Rev C DAC Stream Thread: Failed to open file '%s': %s\n", dac_file, strerror(errno));
     return NULL;
   }
   
@@ -2491,7 +2450,7 @@ static void* rev_c_dac_stream_thread(void* arg) {
           uint32_t fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
           
           if (FIFO_PRESENT(fifo_status) == 0) {
-            fprintf(stderr, "Rev C New DAC Stream Thread: Board %d FIFO not present, stopping\n", board);
+            fprintf(ctx->console_err, "Rev C New DAC Stream Thread: Board %d FIFO not present, stopping\n", board);
             goto cleanup;
           }
           
@@ -2522,7 +2481,7 @@ static void* rev_c_dac_stream_thread(void* arg) {
         total_words_sent += 5; // 1 command + 4 data words
         
         if (verbose && line_num <= 3) { // Only show first few lines to avoid spam
-          printf("Rev C DAC Stream Thread: Board %d, Line %d, Iteration %d, sent DAC write (5 words, channels %d-%d)\n", 
+          fprintf(ctx->console_out, "Rev C DAC Stream Thread: Board %d, Line %d, Iteration %d, sent DAC write (5 words, channels %d-%d)\n", 
                  board, line_num, iteration + 1, board * 8, board * 8 + 7);
         }
       }
@@ -2532,13 +2491,13 @@ static void* rev_c_dac_stream_thread(void* arg) {
     }
     
     if (verbose) {
-      printf("Rev C DAC Stream Thread: Completed iteration %d/%d\n", iteration + 1, iterations);
+      fprintf(ctx->console_out, "Rev C DAC Stream Thread: Completed iteration %d/%d\n", iteration + 1, iterations);
     }
   }
   
   // Send final zero trigger if requested
   if (final_zero_trigger && !(*should_stop)) {
-    printf("Rev C DAC Stream Thread: Sending final zero trigger...\n");
+    fprintf(ctx->console_out, "Rev C DAC Stream Thread: Sending final zero trigger...\n");
     
     // Create array of zeros in signed format (0.0 amps = 32767 offset = 0 signed)
     int16_t zero_vals[8] = {0, 0, 0, 0, 0, 0, 0, 0};
@@ -2549,7 +2508,7 @@ static void* rev_c_dac_stream_thread(void* arg) {
         uint32_t fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
         
         if (FIFO_PRESENT(fifo_status) == 0) {
-          fprintf(stderr, "Rev C New DAC Stream Thread: Board %d FIFO not present for final zero, stopping\n", board);
+          fprintf(ctx->console_err, "Rev C New DAC Stream Thread: Board %d FIFO not present for final zero, stopping\n", board);
           goto cleanup;
         }
         
@@ -2568,7 +2527,7 @@ static void* rev_c_dac_stream_thread(void* arg) {
       total_words_sent += 5; // 1 command + 4 data words
       
       if (verbose) {
-        printf("Rev C DAC Stream Thread: Board %d, sent final zero DAC write\n", board);
+        fprintf(ctx->console_out, "Rev C DAC Stream Thread: Board %d, sent final zero DAC write\n", board);
       }
     }
   }
@@ -2577,10 +2536,10 @@ cleanup:
   fclose(file);
   
   if (*should_stop) {
-    printf("Rev C DAC Stream Thread: Stopping stream (user requested), sent %d total commands (%d total words)\n",
+    fprintf(ctx->console_out, "Rev C DAC Stream Thread: Stopping stream (user requested), sent %d total commands (%d total words)\n",
             total_commands_sent, total_words_sent);
   } else {
-    printf("Rev C DAC Stream Thread: Stream completed, sent %d total commands (%d total words, %d iteration%s%s)\n", 
+    fprintf(ctx->console_out, "Rev C DAC Stream Thread: Stream completed, sent %d total commands (%d total words, %d iteration%s%s)\n", 
            total_commands_sent, total_words_sent, iterations, iterations == 1 ? "" : "s", final_zero_trigger ? " + final zero" : "");
   }
   
@@ -2598,14 +2557,14 @@ static void* rev_c_adc_cmd_stream_thread(void* arg) {
   bool final_zero_trigger = stream_data->final_zero_trigger;
   bool verbose = *(ctx->verbose);
   
-  printf("Rev C ADC Command Stream Thread: Starting (%d lines, %d iterations, delay=%u cycles, final_zero=%s)\n", 
+  fprintf(ctx->console_out, "Rev C ADC Command Stream Thread: Starting (%d lines, %d iterations, delay=%u cycles, final_zero=%s)\n", 
          line_count, iterations, delay_cycles, final_zero_trigger ? "yes" : "no");
   
   int total_commands_sent = 0;
   int total_words_sent = 0;
   
   // First, send set_ord commands to all boards (order: 01234567)
-  printf("Rev C ADC Command Stream Thread: Sending set_ord commands to all boards...\n");
+  fprintf(ctx->console_out, "Rev C ADC Command Stream Thread: Sending set_ord commands to all boards...\n");
   uint8_t channel_order[8] = {0, 1, 2, 3, 4, 5, 6, 7};
   for (int board = 0; board < 4; board++) {
     // Wait for FIFO space for set_ord command
@@ -2613,7 +2572,7 @@ static void* rev_c_adc_cmd_stream_thread(void* arg) {
       uint32_t fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
       
       if (FIFO_PRESENT(fifo_status) == 0) {
-        fprintf(stderr, "Rev C New ADC Command Stream Thread: Board %d FIFO not present for set_ord, stopping\n", board);
+        fprintf(ctx->console_err, "Rev C New ADC Command Stream Thread: Board %d FIFO not present for set_ord, stopping\n", board);
         return NULL;
       }
       
@@ -2631,7 +2590,7 @@ static void* rev_c_adc_cmd_stream_thread(void* arg) {
     total_words_sent ++;
     
     if (verbose) {
-      printf("Rev C ADC Command Stream Thread: Board %d, sent set_ord command\n", board);
+      fprintf(ctx->console_out, "Rev C ADC Command Stream Thread: Board %d, sent set_ord command\n", board);
     }
   }
   
@@ -2650,7 +2609,7 @@ static void* rev_c_adc_cmd_stream_thread(void* arg) {
           uint32_t fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
           
           if (FIFO_PRESENT(fifo_status) == 0) {
-            fprintf(stderr, "Rev C New ADC Command Stream Thread: Board %d FIFO not present, stopping\n", board);
+            fprintf(ctx->console_err, "Rev C New ADC Command Stream Thread: Board %d FIFO not present, stopping\n", board);
             return NULL;
           }
           
@@ -2674,12 +2633,12 @@ static void* rev_c_adc_cmd_stream_thread(void* arg) {
         total_words_sent++;
         
         // Command 3: ADC read with trigger wait for no triggers (0 triggers)
-        adc_cmd_adc_rd(ctx->adc_ctrl, (uint8_t)board, true, false, 0, 0, verbose);
+        adc_cmd_adc_rd(ctx->adc_ctrl, (uint8_t)board, true, false, 0, 0, 0, verbose);
         total_commands_sent++;
         total_words_sent++;
         
         if (verbose && line_num <= 3) { // Only show first few lines to avoid spam
-          printf("Rev C ADC Command Stream Thread: Board %d, Line %d, Iteration %d, sent 3 ADC commands\n", 
+          fprintf(ctx->console_out, "Rev C ADC Command Stream Thread: Board %d, Line %d, Iteration %d, sent 3 ADC commands\n", 
                  board, line_num, iteration + 1);
         }
       }
@@ -2689,13 +2648,13 @@ static void* rev_c_adc_cmd_stream_thread(void* arg) {
     }
     
     if (verbose) {
-      printf("Rev C ADC Command Stream Thread: Completed iteration %d/%d\n", iteration + 1, iterations);
+      fprintf(ctx->console_out, "Rev C ADC Command Stream Thread: Completed iteration %d/%d\n", iteration + 1, iterations);
     }
   }
   
   // Send final ADC commands if final zero line is requested
   if (final_zero_trigger && !(*should_stop)) {
-    printf("Rev C ADC Command Stream Thread: Sending final zero ADC commands...\n");
+    fprintf(ctx->console_out, "Rev C ADC Command Stream Thread: Sending final zero ADC commands...\n");
     
     for (int board = 0; board < 4; board++) {
       // Wait for FIFO space for final zero trigger commands
@@ -2703,7 +2662,7 @@ static void* rev_c_adc_cmd_stream_thread(void* arg) {
         uint32_t fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
         
         if (FIFO_PRESENT(fifo_status) == 0) {
-          fprintf(stderr, "Rev C New ADC Command Stream Thread: Board %d FIFO not present for final zero, stopping\n", board);
+          fprintf(ctx->console_err, "Rev C New ADC Command Stream Thread: Board %d FIFO not present for final zero, stopping\n", board);
           return NULL;
         }
         
@@ -2727,21 +2686,21 @@ static void* rev_c_adc_cmd_stream_thread(void* arg) {
       total_words_sent++;
       
       // Command 3: ADC read with trigger wait for no triggers (0 triggers)
-      adc_cmd_adc_rd(ctx->adc_ctrl, (uint8_t)board, true, false, 0, 0, verbose);
+      adc_cmd_adc_rd(ctx->adc_ctrl, (uint8_t)board, true, false, 0, 0, 0, verbose);
       total_commands_sent++;
       total_words_sent++;
       
       if (verbose) {
-        printf("Rev C ADC Command Stream Thread: Board %d, sent final zero ADC commands\n", board);
+        fprintf(ctx->console_out, "Rev C ADC Command Stream Thread: Board %d, sent final zero ADC commands\n", board);
       }
     }
   }
   
   if (*should_stop) {
-    printf("Rev C ADC Command Stream Thread: Stopping stream (user requested), sent %d total commands (%d total words)\n",
+    fprintf(ctx->console_out, "Rev C ADC Command Stream Thread: Stopping stream (user requested), sent %d total commands (%d total words)\n",
            total_commands_sent, total_words_sent);
   } else {
-    printf("Rev C ADC Command Stream Thread: Stream completed, sent %d total commands (%d total words, %d iteration%s%s)\n", 
+    fprintf(ctx->console_out, "Rev C ADC Command Stream Thread: Stream completed, sent %d total commands (%d total words, %d iteration%s%s)\n", 
            total_commands_sent, total_words_sent, iterations, iterations == 1 ? "" : "s", final_zero_trigger ? " + final zero" : "");
   }
   
@@ -2813,7 +2772,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   // Step 4: Prompt for DAC command file
   char resolved_dac_file[1024];
   if (prompt_file_selection("Enter DAC command file (32 space-separated values per line)", 
-                           NULL, resolved_dac_file, sizeof(resolved_dac_file)) != 0) {
+                           NULL, resolved_dac_file, sizeof(resolved_dac_file), ctx->in) != 0) {
     fprintf(stderr, "Failed to get DAC file\n");
     return -1;
   }
@@ -2828,7 +2787,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   printf("Enter choice (1 or 2): ");
   fflush(stdout);
   
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read input choice.\n");
     return -1;
   }
@@ -2870,7 +2829,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   printf("Enter number of iterations: ");
   fflush(stdout);
   
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read iteration count.\n");
     return -1;
   }
@@ -2892,7 +2851,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   printf("Enter SPI clock frequency in MHz: ");
   fflush(stdout);
   
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read SPI frequency.\n");
     return -1;
   }
@@ -2913,7 +2872,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   printf("Enter ADC sample delay (milliseconds): ");
   fflush(stdout);
   
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read ADC delay.\n");
     return -1;
   }
@@ -2940,7 +2899,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   printf("Enter trigger lockout time (milliseconds): ");
   fflush(stdout);
   
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read trigger lockout time.\n");
     return -1;
   }
@@ -2967,7 +2926,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   printf("Add final zero trigger? (y/n): ");
   fflush(stdout);
   
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read final zero trigger choice.\n");
     return -1;
   }
@@ -2985,7 +2944,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   printf("Enter base output file path: ");
   fflush(stdout);
   
-  if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
+  if (fgets(input_buffer, sizeof(input_buffer), ctx->in) == NULL) {
     fprintf(stderr, "Failed to read output file path.\n");
     return -1;
   }
@@ -3147,7 +3106,8 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
     .sys_sts = ctx->sys_sts,
     .expected_total_triggers = expected_triggers,
     .should_stop = &g_trigger_monitor_should_stop,
-    .verbose = *(ctx->verbose)
+    .verbose = *(ctx->verbose),
+    .out = ctx->console_out
   };
   
   g_trigger_monitor_should_stop = false;
@@ -3245,7 +3205,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
     fflush(stdout);
     
     char response[16];
-    if (fgets(response, sizeof(response), stdin) == NULL || (response[0] != 'y' && response[0] != 'Y')) {
+    if (fgets(response, sizeof(response), ctx->in) == NULL || (response[0] != 'y' && response[0] != 'Y')) {
       printf("Aborting Rev C compatibility mode.\n");
       dac_stream_stop = true;
       adc_cmd_stream_stop = true;
@@ -3303,6 +3263,80 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
 
 
 
+// Wait until a board's ADC data FIFO holds at least count words (false on timeout)
+static bool wait_for_adc_words(command_context_t* ctx, int board, uint32_t count, uint64_t timeout_us) {
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  while (true) {
+    uint32_t adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+    if (FIFO_STS_WORD_COUNT(adc_data_fifo_status) >= count) return true;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t elapsed_us = (uint64_t)(now.tv_sec - start.tv_sec) * 1000000 + (now.tv_nsec - start.tv_nsec) / 1000;
+    if (elapsed_us > timeout_us) return false;
+    usleep(1000); // 1ms
+  }
+}
+
+// Mark the boards whose DAC and ADC FIFOs are all present, returning how many there are
+static int find_connected_boards(command_context_t* ctx, bool connected_boards[8]) {
+  int connected_count = 0;
+  for (int board = 0; board < 8; board++) {
+    uint32_t adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+    uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+    uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+    uint32_t dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+    
+    connected_boards[board] = FIFO_PRESENT(adc_data_fifo_status) && 
+                              FIFO_PRESENT(dac_cmd_fifo_status) && 
+                              FIFO_PRESENT(adc_cmd_fifo_status) &&
+                              FIFO_PRESENT(dac_data_fifo_status);
+    if (connected_boards[board]) connected_count++;
+    if (*(ctx->verbose)) {
+      printf("  Board %d: %s\n", board, connected_boards[board] ? "Connected" : "Not connected");
+    }
+  }
+  return connected_count;
+}
+
+// Length of one channel sweep step: DAC_WR, settle, the back-to-back ADC_RD_CH reads, and a margin
+static uint32_t channel_sweep_step_cycles(const struct spi_timing_t* timing, uint32_t settle_cycles, int samples) {
+  return settle_cycles + (uint32_t)samples * timing->adc_rd_ch_cycles + settle_cycles / 10 + timing->dac_wr_min_delay;
+}
+
+// Queue a per-channel DAC sweep on one board, released by the next sync trigger. Each channel in
+// turn steps through dac_values while the others hold zero; settle_cycles into every step the ADC
+// takes `samples` ADC_RD_CH reads of that channel. All channels are left at zero afterwards.
+static void queue_channel_sweep(command_context_t* ctx, int board, const struct spi_timing_t* timing,
+                                const int16_t* dac_values, int num_values, int samples,
+                                uint32_t settle_cycles, uint32_t step_cycles) {
+  uint32_t read_cycles = (uint32_t)samples * timing->adc_rd_ch_cycles;
+  dac_cmd_noop(ctx->dac_ctrl, (uint8_t)board, true, false, false, 1, false);
+  adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, true, false, 1, false);
+  for (int channel = 0; channel < 8; channel++) {
+    for (int i = 0; i < num_values; i++) {
+      int16_t ch_vals[8] = {0};
+      ch_vals[channel] = dac_values[i];
+      dac_cmd_dac_wr(ctx->dac_ctrl, (uint8_t)board, ch_vals, false, false, true, step_cycles, false);
+      adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, false, false, settle_cycles, false);
+      adc_cmd_adc_rd_ch(ctx->adc_ctrl, (uint8_t)board, (uint8_t)channel, (uint32_t)samples - 1, false);
+      adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, false, false, step_cycles - settle_cycles - read_cycles, false);
+    }
+  }
+  int16_t zero_vals[8] = {0};
+  dac_cmd_dac_wr(ctx->dac_ctrl, (uint8_t)board, zero_vals, false, false, true, timing->dac_wr_min_delay, false);
+}
+
+// Read back a board's queued sweep, averaging each step: avg[channel * num_values + i]
+static void read_channel_sweep(command_context_t* ctx, int board, int num_values, int samples, double* avg) {
+  for (int step = 0; step < 8 * num_values; step++) {
+    int32_t sum = 0;
+    for (int n = 0; n < samples; n++) {
+      sum += offset_to_signed(adc_read_word(ctx->adc_ctrl, (uint8_t)board) & 0xFFFF);
+    }
+    avg[step] = (double)sum / samples;
+  }
+}
+
 // ADC bias calibration command - find and store ADC bias values for all connected channels
 int cmd_find_bias(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   printf("Starting ADC bias calibration for all connected boards...\n");
@@ -3317,33 +3351,10 @@ int cmd_find_bias(const char** args, int arg_count, const command_flag_t* flags,
   
   // Check which boards are connected by checking FIFOs
   bool connected_boards[8] = {false};
-  int connected_count = 0;
-  
   if (*(ctx->verbose)) {
     printf("Checking connected boards...\n");
   }
-  
-  for (int board = 0; board < 8; board++) {
-    uint32_t adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    
-    if (FIFO_PRESENT(adc_data_fifo_status) && 
-        FIFO_PRESENT(dac_cmd_fifo_status) && 
-        FIFO_PRESENT(adc_cmd_fifo_status) &&
-        FIFO_PRESENT(dac_data_fifo_status)) {
-      connected_boards[board] = true;
-      connected_count++;
-      if (*(ctx->verbose)) {
-        printf("  Board %d: Connected\n", board);
-      }
-    } else {
-      if (*(ctx->verbose)) {
-        printf("  Board %d: Not connected\n", board);
-      }
-    }
-  }
+  int connected_count = find_connected_boards(ctx, connected_boards);
   
   if (connected_count == 0) {
     printf("No boards are connected. Aborting ADC bias calibration.\n");
@@ -3382,14 +3393,33 @@ int cmd_find_bias(const char** args, int arg_count, const command_flag_t* flags,
   }
   usleep(1000); // 1ms to let cancel commands complete
   
+  // Both phases run as DAC/ADC command sequences timed by the cores themselves: every
+  // board's whole sequence is queued, released with one sync trigger, and the samples are
+  // read back in bulk afterwards, so host latency never enters the measurement
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  if (!spi_timing_valid(&timing)) {
+    fprintf(stderr, "SPI clock frequency is unavailable; cannot time the bias measurement sequences.\n");
+    return -1;
+  }
+
   // Calibration constants
-  const int dac_values[] = {-3276, -1638, 0, 1638, 3276};
+  const int16_t dac_values[] = {-3276, -1638, 0, 1638, 3276};
   const int num_dac_values = 5;
   const int slope_samples = 5; // Samples per DAC value for slope check
   const int bias_sample_count = 50; // Take 50 samples per channel for bias
-  const int delay_ms = 1; // 1ms delay
+  const double settle_ns = 1e6; // 1ms DAC settling time before sampling
+  const double bias_spacing_ns = 1e6; // 1ms between bias samples
   const double slope_tolerance = 0.1; // +/-0.1 slope tolerance
-  
+
+  uint32_t settle_cycles = (uint32_t)spi_timing_ns_to_cycles(&timing, settle_ns);
+  uint32_t step_cycles = channel_sweep_step_cycles(&timing, settle_cycles, slope_samples);
+  uint32_t bias_spacing_cycles = (uint32_t)spi_timing_ns_to_cycles(&timing, bias_spacing_ns);
+  if (bias_spacing_cycles < timing.adc_rd_min_delay) bias_spacing_cycles = timing.adc_rd_min_delay;
+  if (step_cycles > SPI_TIMING_MAX_DELAY_CYCLES) {
+    fprintf(stderr, "SPI clock too fast for the bias measurement step delay (%u cycles).\n", step_cycles);
+    return -1;
+  }
+
   int channels_calibrated = 0;
   int channels_failed = 0;
   bool channel_slope_valid[64] = {false}; // Track which channels pass slope test
@@ -3411,124 +3441,103 @@ int cmd_find_bias(const char** args, int arg_count, const command_flag_t* flags,
   
   // Phase 1: Slope validation for all channels
   printf("Phase 1: Validating channels are unplugged (slope near zero)...\n");
-  
-  for (int ch = 0; ch < 64; ch++) {
-    int board = ch / 8;
-    int channel = ch % 8;
-    
-    // Skip boards that are not connected
-    if (!connected_boards[board]) {
+
+  // Queue each board's sweep: every channel through every DAC value, one channel at a time
+  uint8_t default_order[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    adc_cmd_set_ord(ctx->adc_ctrl, (uint8_t)board, default_order, false);
+    queue_channel_sweep(ctx, board, &timing, dac_values, num_dac_values, slope_samples, settle_cycles, step_cycles);
+  }
+
+  uint32_t phase1_words = 8 * (uint32_t)(num_dac_values * slope_samples);
+  uint64_t phase1_us = (uint64_t)(spi_timing_cycles_to_ns(&timing, 8ULL * num_dac_values * step_cycles) / 1000.0);
+  if (*(ctx->verbose)) {
+    printf("Queued %u ADC samples per board over %.1f ms\n", phase1_words, phase1_us / 1000.0);
+  }
+  trigger_cmd_sync_ch(ctx->trigger_ctrl, false, *(ctx->verbose));
+
+  bool sweep_timed_out = false;
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+
+    // Allow twice the sequence length before giving up on the board
+    if (!wait_for_adc_words(ctx, board, phase1_words, 2 * phase1_us + 100000)) {
+      sweep_timed_out = true;
+      uint32_t available = FIFO_STS_WORD_COUNT(sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false));
+      for (int channel = 0; channel < 8; channel++) {
+        int ch = board * 8 + channel;
+        if (*(ctx->verbose)) {
+          printf("  Ch %02d: FAIL (no ADC data)\n", ch);
+        }
+        failed_channels_phase1[phase1_failed_count] = ch;
+        snprintf(failed_reasons_phase1[phase1_failed_count], sizeof(failed_reasons_phase1[phase1_failed_count]),
+                 "no ADC data (%u of %u samples)", available, phase1_words);
+        phase1_failed_count++;
+        channels_failed++;
+      }
       continue;
     }
+
+    double sweep_avg[8 * num_dac_values];
+    read_channel_sweep(ctx, board, num_dac_values, slope_samples, sweep_avg);
+
+    for (int channel = 0; channel < 8; channel++) {
+      int ch = board * 8 + channel;
+      double dac_vals[num_dac_values];
+      const double* avg_adc_vals = &sweep_avg[channel * num_dac_values];
+      for (int i = 0; i < num_dac_values; i++) {
+        dac_vals[i] = (double)dac_values[i];
+      }
     
-    if (*(ctx->verbose)) {
-      printf("Checking slope for Ch %02d...\n", ch);
-    }
-    
-    // Arrays to store DAC values and corresponding averaged ADC readings for slope test
-    double dac_vals[num_dac_values];
-    double avg_adc_vals[num_dac_values];
-    bool slope_test_failed = false;
+      // Perform linear regression: y = mx + b
+      double sum_x = 0, sum_y = 0, sum_xy = 0, sum_x2 = 0;
+      for (int i = 0; i < num_dac_values; i++) {
+        sum_x += dac_vals[i];
+        sum_y += avg_adc_vals[i];
+        sum_xy += dac_vals[i] * avg_adc_vals[i];
+        sum_x2 += dac_vals[i] * dac_vals[i];
+      }
     
-    // Test each DAC value for slope calculation
-    for (int i = 0; i < num_dac_values && !slope_test_failed; i++) {
-      int16_t dac_val = dac_values[i];
-      dac_vals[i] = (double)dac_val;
-      
-      // Perform multiple reads and average them
-      double sum_adc = 0.0;
-      
-      for (int avg = 0; avg < slope_samples && !slope_test_failed; avg++) {
-        // Write DAC value
-        dac_cmd_dac_wr_ch(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, dac_val, false);
-        usleep(delay_ms * 1000); // Wait fixed delay
-        
-        // Read ADC value
-        adc_cmd_adc_rd_ch(ctx->adc_ctrl, (uint8_t)board, (uint8_t)channel, 0, false);
-        
-        // Wait for ADC data to be available
-        int adc_tries = 0;
-        uint32_t adc_data_fifo_status;
-        while (adc_tries < 100) {
-          adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-          if (FIFO_STS_WORD_COUNT(adc_data_fifo_status) > 0) break;
-          usleep(100); // 0.1ms
-          adc_tries++;
-        }
-        
-        if (FIFO_STS_WORD_COUNT(adc_data_fifo_status) == 0) {
-          slope_test_failed = true;
-          break;
+      // Calculate slope and check for division by zero
+      double denominator = num_dac_values * sum_x2 - sum_x * sum_x;
+      if (denominator == 0) {
+        if (*(ctx->verbose)) {
+          printf("  Ch %02d: FAIL (div by zero)\n", ch);
         }
-        
-        uint32_t adc_word = adc_read_word(ctx->adc_ctrl, (uint8_t)board);
-        int16_t adc_reading = offset_to_signed(adc_word & 0xFFFF);
-        double adc_val = (double)adc_reading;
-        
-        sum_adc += adc_val;
+        failed_channels_phase1[phase1_failed_count] = ch;
+        snprintf(failed_reasons_phase1[phase1_failed_count], sizeof(failed_reasons_phase1[phase1_failed_count]), "div by zero");
+        phase1_failed_count++;
+        channels_failed++;
+        continue;
       }
-      
-      if (slope_test_failed) break;
-      
-      avg_adc_vals[i] = sum_adc / slope_samples;
-    }
+      double slope = (num_dac_values * sum_xy - sum_x * sum_y) / denominator;
     
-    if (slope_test_failed) {
-      if (*(ctx->verbose)) {
-        printf("  Ch %02d: FAIL (no ADC data)\n", ch);
-      }
-      failed_channels_phase1[phase1_failed_count] = ch;
-      snprintf(failed_reasons_phase1[phase1_failed_count], sizeof(failed_reasons_phase1[phase1_failed_count]), "no ADC data");
-      phase1_failed_count++;
-      channels_failed++;
-      continue;
-    }
-    
-    // Perform linear regression: y = mx + b
-    double sum_x = 0, sum_y = 0, sum_xy = 0, sum_x2 = 0;
-    for (int i = 0; i < num_dac_values; i++) {
-      sum_x += dac_vals[i];
-      sum_y += avg_adc_vals[i];
-      sum_xy += dac_vals[i] * avg_adc_vals[i];
-      sum_x2 += dac_vals[i] * dac_vals[i];
-    }
-    
-    // Calculate slope and check for division by zero
-    double denominator = num_dac_values * sum_x2 - sum_x * sum_x;
-    double slope;
-    
-    if (denominator == 0) {
-      if (*(ctx->verbose)) {
-        printf("  Ch %02d: FAIL (div by zero)\n", ch);
+      // Check if slope is within tolerance (close to 0)
+      if (slope < -slope_tolerance || slope > slope_tolerance) {
+        if (*(ctx->verbose)) {
+          printf("  Ch %02d: FAIL (slope=%.4f, not near 0)\n", ch, slope);
+        }
+        failed_channels_phase1[phase1_failed_count] = ch;
+        snprintf(failed_reasons_phase1[phase1_failed_count], sizeof(failed_reasons_phase1[phase1_failed_count]), "slope=%.4f (not near 0)", slope);
+        phase1_failed_count++;
+        channels_failed++;
+        continue;
       }
-      failed_channels_phase1[phase1_failed_count] = ch;
-      snprintf(failed_reasons_phase1[phase1_failed_count], sizeof(failed_reasons_phase1[phase1_failed_count]), "div by zero");
-      phase1_failed_count++;
-      channels_failed++;
-      continue;
-    }
     
-    slope = (num_dac_values * sum_xy - sum_x * sum_y) / denominator;
-    
-    // Check if slope is within tolerance (close to 0)
-    if (slope < -slope_tolerance || slope > slope_tolerance) {
+      // Slope is acceptable
+      channel_slope_valid[ch] = true;
       if (*(ctx->verbose)) {
-        printf("  Ch %02d: FAIL (slope=%.4f, not near 0)\n", ch, slope);
+        printf("  Ch %02d: slope check passed (slope=%.4f)\n", ch, slope);
       }
-      failed_channels_phase1[phase1_failed_count] = ch;
-      snprintf(failed_reasons_phase1[phase1_failed_count], sizeof(failed_reasons_phase1[phase1_failed_count]), "slope=%.4f (not near 0)", slope);
-      phase1_failed_count++;
-      channels_failed++;
-      continue;
-    }
-    
-    // Slope is acceptable
-    channel_slope_valid[ch] = true;
-    if (*(ctx->verbose)) {
-      printf("  Ch %02d: slope check passed (slope=%.4f)\n", ch, slope);
     }
   }
   
+  // A board that timed out may still have most of its sweep queued
+  if (sweep_timed_out) {
+    abort_queued_commands(ctx, connected_boards, stdout);
+  }
+  
   // Count channels that passed slope test
   int slope_passed_count = 0;
   for (int ch = 0; ch < 64; ch++) {
@@ -3556,15 +3565,48 @@ int cmd_find_bias(const char** args, int arg_count, const command_flag_t* flags,
     return -1;
   }
   
-  // Phase 2: Bias measurement for channels that passed slope test
-  printf("Phase 2: Measuring ADC bias (sampling at DAC=0, 50 samples per channel)...\n");
+  // Phase 2: Bias measurement, all channels of a board at once with ADC_RD at a fixed spacing
+  printf("Phase 2: Measuring ADC bias (sampling at DAC=0, %d samples per channel)...\n", bias_sample_count);
   
   channels_failed = 0; // Reset for bias measurement phase
+
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    dac_cmd_noop(ctx->dac_ctrl, (uint8_t)board, true, false, false, 1, false);
+    adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, true, false, 1, false);
+    int16_t zero_vals[8] = {0};
+    dac_cmd_dac_wr(ctx->dac_ctrl, (uint8_t)board, zero_vals, false, false, true, timing.dac_wr_min_delay, false);
+    adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, false, false, settle_cycles, false);
+    adc_cmd_adc_rd(ctx->adc_ctrl, (uint8_t)board, false, false, bias_spacing_cycles, (uint32_t)bias_sample_count - 1, 0, false);
+  }
+
+  uint32_t phase2_words = 4 * (uint32_t)bias_sample_count; // 8 samples packed in pairs per ADC_RD
+  uint64_t phase2_us = (uint64_t)(spi_timing_cycles_to_ns(&timing, settle_cycles + (uint64_t)bias_sample_count * bias_spacing_cycles) / 1000.0);
+  trigger_cmd_sync_ch(ctx->trigger_ctrl, false, *(ctx->verbose));
+
+  double samples[64][bias_sample_count];
+  bool board_ok[8] = {false};
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    if (!wait_for_adc_words(ctx, board, phase2_words, 2 * phase2_us + 100000)) {
+      sweep_timed_out = true;
+      continue;
+    }
+    board_ok[board] = true;
+    for (int i = 0; i < bias_sample_count; i++) {
+      for (int pair = 0; pair < 4; pair++) {
+        uint32_t adc_word = adc_read_word(ctx->adc_ctrl, (uint8_t)board);
+        samples[board * 8 + 2 * pair][i] = (double)offset_to_signed(adc_word & 0xFFFF);
+        samples[board * 8 + 2 * pair + 1][i] = (double)offset_to_signed(adc_word >> 16);
+      }
+    }
+  }
+  if (sweep_timed_out) {
+    abort_queued_commands(ctx, connected_boards, stdout);
+  }
   
-  // Iterate through channels that passed slope test
   for (int ch = 0; ch < 64; ch++) {
     int board = ch / 8;
-    int channel = ch % 8;
     
     // Skip channels that didn't pass slope test or boards not connected
     if (!connected_boards[board] || !channel_slope_valid[ch]) {
@@ -3572,44 +3614,8 @@ int cmd_find_bias(const char** args, int arg_count, const command_flag_t* flags,
     }
     
     printf("Ch %02d : ", ch);
-    fflush(stdout);
-    
-    // Array to store all samples for this channel
-    double samples[bias_sample_count];
-    bool calibration_failed = false;
-    
-    // Set DAC to zero value
-    dac_cmd_dac_wr_ch(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, 0, false);
-    usleep(delay_ms * 1000); // Wait for DAC to settle
-    
-    // Collect samples
-    for (int i = 0; i < bias_sample_count && !calibration_failed; i++) {
-      // Read ADC value
-      adc_cmd_adc_rd_ch(ctx->adc_ctrl, (uint8_t)board, (uint8_t)channel, 0, false);
-      
-      // Wait for ADC data to be available
-      int adc_tries = 0;
-      uint32_t adc_data_fifo_status;
-      while (adc_tries < 100) {
-        adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-        if (FIFO_STS_WORD_COUNT(adc_data_fifo_status) > 0) break;
-        usleep(100); // 0.1ms
-        adc_tries++;
-      }
-      
-      if (FIFO_STS_WORD_COUNT(adc_data_fifo_status) == 0) {
-        calibration_failed = true;
-        break;
-      }
-      
-      uint32_t adc_word = adc_read_word(ctx->adc_ctrl, (uint8_t)board);
-      int16_t adc_reading = offset_to_signed(adc_word & 0xFFFF);
-      samples[i] = (double)adc_reading;
-      
-      usleep(delay_ms * 1000); // Small delay between samples
-    }
     
-    if (calibration_failed) {
+    if (!board_ok[board]) {
       printf("FAIL (no ADC data)\n");
       failed_channels_phase2[phase2_failed_count] = ch;
       snprintf(failed_reasons_phase2[phase2_failed_count], sizeof(failed_reasons_phase2[phase2_failed_count]), "no ADC data");
@@ -3621,14 +3627,14 @@ int cmd_find_bias(const char** args, int arg_count, const command_flag_t* flags,
     // Calculate mean (bias)
     double sum = 0.0;
     for (int i = 0; i < bias_sample_count; i++) {
-      sum += samples[i];
+      sum += samples[ch][i];
     }
     double bias_average = sum / bias_sample_count;
     
     // Calculate standard deviation
     double variance_sum = 0.0;
     for (int i = 0; i < bias_sample_count; i++) {
-      double diff = samples[i] - bias_average;
+      double diff = samples[ch][i] - bias_average;
       variance_sum += diff * diff;
     }
     double std_dev = variance_sum > 0 ? (variance_sum / (bias_sample_count - 1)) : 0.0;
@@ -3645,6 +3651,7 @@ int cmd_find_bias(const char** args, int arg_count, const command_flag_t* flags,
     // Store the bias value
     ctx->adc_bias[ch] = bias_average;
     ctx->adc_bias_valid[ch] = true;
+    ctx->adc_bias_time[board] = (int64_t)time(NULL);
     
     // Format bias result with proper alignment and difference from previous
     char diff_str[32] = "";
@@ -3699,6 +3706,7 @@ int cmd_find_bias(const char** args, int arg_count, const command_flag_t* flags,
   }
   
   printf("ADC bias calibration completed successfully.\n");
+  autosave_calibration(ctx);
   return 0;
 }
 
@@ -3799,6 +3807,10 @@ int cmd_load_adc_bias(const char** args, int arg_count, const command_flag_t* fl
     ctx->adc_bias[ch] = 0.0;
   }
   
+  // The CSV has no timestamps: date the values by the file
+  struct stat file_stat;
+  int64_t file_time = (stat(full_path, &file_stat) == 0) ? (int64_t)file_stat.st_mtime : (int64_t)time(NULL);
+  
   int loaded_count = 0;
   int line_num = 1;
   
@@ -3831,6 +3843,7 @@ int cmd_load_adc_bias(const char** args, int arg_count, const command_flag_t* fl
     if (is_valid) {
       ctx->adc_bias[channel] = bias_value;
       ctx->adc_bias_valid[channel] = true;
+      ctx->adc_bias_time[channel / 8] = file_time;
       loaded_count++;
     }
   }
@@ -3842,9 +3855,1095 @@ int cmd_load_adc_bias(const char** args, int arg_count, const command_flag_t* fl
   
   if (loaded_count > 0) {
     printf("ADC bias correction is now active for %d channels\n", loaded_count);
+    autosave_calibration(ctx);
   } else {
     printf("No valid bias values were loaded\n");
   }
   
   return 0;
 }
+
+// Print one channel's correction table entry
+static void print_cal_entry(const struct cal_table_t* table, int ch) {
+  int board = ch / 8;
+  int channel = ch % 8;
+  if (table->status[ch] == CAL_FIT_OK) {
+    printf("%-6d %-8d %-8d %-15s %-6d %-9.5f %-9.2f %-8.2f %-8d %-10d %d\n", ch, board, channel,
+           cal_fit_status_name(table->status[ch]), table->order[ch], table->gain[ch], table->offset[ch],
+           table->rms_residual[ch], table->mul[ch], table->add[ch], table->quad[ch]);
+  } else {
+    printf("%-6d %-8d %-8d %s\n", ch, board, channel, cal_fit_status_name(table->status[ch]));
+  }
+}
+
+static void print_cal_header(void) {
+  printf("%-6s %-8s %-8s %-15s %-6s %-9s %-9s %-8s %-8s %-10s %s\n",
+         "Ch", "Board", "Channel", "Status", "Order", "Gain", "Offset", "RMS", "Mul", "Add", "Quad");
+  printf("%-6s %-8s %-8s %-15s %-6s %-9s %-9s %-8s %-8s %-10s %s\n",
+         "------", "--------", "--------", "---------------", "------", "---------", "---------",
+         "--------", "--------", "----------", "--------");
+}
+
+// Fit DAC->ADC correction tables command - sweep every connected channel and fit gain/offset (or a quadratic)
+int cmd_cal_fit(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  // Parse optional order and span
+  int order = 1;
+  if (arg_count >= 1) {
+    char* endptr;
+    order = (int)strtol(args[0], &endptr, 0);
+    if (*endptr != '\0' || order < 1 || order > CAL_TABLE_MAX_ORDER) {
+      fprintf(stderr, "Invalid fit order for cal_fit: '%s'. Must be 1 or %d.\n", args[0], CAL_TABLE_MAX_ORDER);
+      return -1;
+    }
+  }
+  int span = 3276; // 10% of full scale, the range channel_cal and find_bias sweep
+  if (arg_count >= 2) {
+    char* endptr;
+    span = (int)strtol(args[1], &endptr, 0);
+    if (*endptr != '\0' || span < 100 || span > 32767) {
+      fprintf(stderr, "Invalid span for cal_fit: '%s'. Must be 100 to 32767.\n", args[1]);
+      return -1;
+    }
+  }
+
+  if (validate_system_running(ctx) != 0) {
+    return -1;
+  }
+
+  bool connected_boards[8] = {false};
+  if (*(ctx->verbose)) {
+    printf("Checking connected boards...\n");
+  }
+  int connected_count = find_connected_boards(ctx, connected_boards);
+  if (connected_count == 0) {
+    printf("No boards are connected. Aborting correction fit.\n");
+    return -1;
+  }
+
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  if (!spi_timing_valid(&timing)) {
+    fprintf(stderr, "SPI clock frequency is unavailable; cannot time the calibration sweep.\n");
+    return -1;
+  }
+
+  // Sweep: evenly spaced DAC codes over +/-span, averaged over several reads per step
+  const int num_points = 9;
+  const int samples = 8;
+  const double settle_ns = 1e6; // 1ms DAC settling time before sampling
+  int16_t dac_values[num_points];
+  double dac_codes[num_points];
+  for (int i = 0; i < num_points; i++) {
+    dac_values[i] = (int16_t)(-span + (2 * span * i) / (num_points - 1));
+    dac_codes[i] = (double)dac_values[i];
+  }
+  uint32_t settle_cycles = (uint32_t)spi_timing_ns_to_cycles(&timing, settle_ns);
+  uint32_t step_cycles = channel_sweep_step_cycles(&timing, settle_cycles, samples);
+  if (step_cycles > SPI_TIMING_MAX_DELAY_CYCLES) {
+    fprintf(stderr, "SPI clock too fast for the calibration step delay (%u cycles).\n", step_cycles);
+    return -1;
+  }
+
+  printf("Fitting order-%d DAC->ADC corrections for %d connected board(s): %d points over +/-%d, %d samples each\n",
+         order, connected_count, num_points, span, samples);
+
+  if (!has_flag(flags, flag_count, FLAG_NO_RESET)) {
+    if (*(ctx->verbose)) {
+      printf("Resetting all buffers...\n");
+    }
+    safe_buffer_reset(ctx, *(ctx->verbose));
+    usleep(10000); // 10ms
+  }
+  for (int board = 0; board < 8; board++) {
+    if (connected_boards[board]) {
+      dac_cmd_cancel(ctx->dac_ctrl, (uint8_t)board, *(ctx->verbose));
+      adc_cmd_cancel(ctx->adc_ctrl, (uint8_t)board, *(ctx->verbose));
+    }
+  }
+  usleep(1000); // 1ms to let cancel commands complete
+
+  // Queue every board's sweep and release them together
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    queue_channel_sweep(ctx, board, &timing, dac_values, num_points, samples, settle_cycles, step_cycles);
+  }
+  uint32_t sweep_words = 8 * (uint32_t)(num_points * samples);
+  uint64_t sweep_us = (uint64_t)(spi_timing_cycles_to_ns(&timing, 8ULL * num_points * step_cycles) / 1000.0);
+  trigger_cmd_sync_ch(ctx->trigger_ctrl, false, *(ctx->verbose));
+
+  // Gather the averages point-major (adc[point][ch]) for the batch fit
+  double adc[num_points * CAL_TABLE_CHANNELS];
+  bool ch_mask[CAL_TABLE_CHANNELS] = {false};
+  memset(adc, 0, sizeof(adc));
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    if (!wait_for_adc_words(ctx, board, sweep_words, 2 * sweep_us + 100000)) {
+      printf("  Board %d: no ADC data (%u of %u samples), skipping\n", board,
+             FIFO_STS_WORD_COUNT(sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false)), sweep_words);
+      continue;
+    }
+    double sweep_avg[8 * num_points];
+    read_channel_sweep(ctx, board, num_points, samples, sweep_avg);
+    for (int channel = 0; channel < 8; channel++) {
+      int ch = board * 8 + channel;
+      ch_mask[ch] = true;
+      for (int i = 0; i < num_points; i++) {
+        adc[i * CAL_TABLE_CHANNELS + ch] = sweep_avg[channel * num_points + i];
+      }
+    }
+  }
+
+  int attempted = 0;
+  for (int ch = 0; ch < CAL_TABLE_CHANNELS; ch++) {
+    if (ch_mask[ch]) attempted++;
+  }
+  if (attempted == 0) {
+    printf("No sweep data was collected. Correction table unchanged.\n");
+    return -1;
+  }
+
+  int fitted = cal_table_fit(&ctx->adc_cal, ch_mask, dac_codes, adc, num_points, order);
+  int64_t now = (int64_t)time(NULL);
+  for (int board = 0; board < 8; board++) {
+    if (ch_mask[board * 8]) ctx->adc_cal_time[board] = now;
+  }
+
+  print_cal_header();
+  for (int ch = 0; ch < CAL_TABLE_CHANNELS; ch++) {
+    if (ch_mask[ch]) print_cal_entry(&ctx->adc_cal, ch);
+  }
+  printf("\nCorrection fit complete: %d of %d channels fitted\n", fitted, attempted);
+  if (fitted > 0) {
+    autosave_calibration(ctx);
+  }
+  return fitted == attempted ? 0 : -1;
+}
+
+// Print DAC->ADC correction table command
+int cmd_print_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  printf("DAC->ADC correction table (corrected samples are in DAC codes; Mul/Add Q%d, Quad Q%d):\n",
+         CAL_TABLE_FRAC_BITS, CAL_TABLE_FRAC_BITS + CAL_TABLE_QUAD_SHIFT);
+  print_cal_header();
+  int fitted = 0;
+  for (int ch = 0; ch < CAL_TABLE_CHANNELS; ch++) {
+    print_cal_entry(&ctx->adc_cal, ch);
+    if (ctx->adc_cal.status[ch] == CAL_FIT_OK) fitted++;
+  }
+  printf("\nSummary: %d fitted channels, %d without a fit\n", fitted, CAL_TABLE_CHANNELS - fitted);
+  return 0;
+}
+
+// Discard all fitted DAC->ADC corrections command
+int cmd_clear_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  ctx->adc_cal = create_cal_table();
+  printf("DAC->ADC correction table cleared (ADC bias values are kept).\n");
+  return 0;
+}
+
+// Load waveform pre-emphasis coefficients command
+int cmd_load_preemph(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  char resolved_path[1024];
+  if (resolve_file_pattern(args[0], resolved_path, sizeof(resolved_path), ctx->in) != 0) {
+    return -1;
+  }
+  char full_path[1024];
+  clean_and_expand_path(resolved_path, full_path, sizeof(full_path));
+  if (preemph_load(&ctx->preemph, full_path) != 0) {
+    return -1;
+  }
+  preemph_print(&ctx->preemph, stdout);
+  printf("DAC waveform files are now pre-emphasized when streamed ('clear_preemph' to stop).\n");
+  return 0;
+}
+
+// Print waveform pre-emphasis coefficients command
+int cmd_print_preemph(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  preemph_print(&ctx->preemph, stdout);
+  return 0;
+}
+
+// Discard waveform pre-emphasis command
+int cmd_clear_preemph(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  uint32_t generation = ctx->preemph.generation;
+  ctx->preemph = create_preemph();
+  ctx->preemph.generation = generation + 1;
+  printf("Pre-emphasis cleared (DAC waveform files are played verbatim).\n");
+  return 0;
+}
+
+// Copy the in-memory calibration into a store
+static void calibration_to_store(command_context_t* ctx, struct cal_store_t* store) {
+  memset(store, 0, sizeof(*store));
+  store->saved_time = (int64_t)time(NULL);
+  for (int board = 0; board < CAL_STORE_BOARDS; board++) {
+    struct cal_store_board_t* rec = &store->boards[board];
+    for (int channel = 0; channel < 8; channel++) {
+      int ch = board * 8 + channel;
+      if (ctx->adc_bias_valid[ch]) {
+        rec->adc_bias_valid |= (uint8_t)(1u << channel);
+        rec->adc_bias[channel] = (float)ctx->adc_bias[ch];
+      }
+      if (ctx->dac_cal_valid[ch]) {
+        rec->dac_cal_valid |= (uint8_t)(1u << channel);
+        rec->dac_cal[channel] = ctx->dac_cal[ch];
+      }
+    }
+    cal_store_put_fit(rec, &ctx->adc_cal, board);
+    rec->adc_bias_time = rec->adc_bias_valid ? ctx->adc_bias_time[board] : 0;
+    rec->dac_cal_time = rec->dac_cal_valid ? ctx->dac_cal_time[board] : 0;
+    rec->adc_fit_time = ctx->adc_cal_time[board];
+  }
+}
+
+// Replace the in-memory calibration with a store's contents
+static void calibration_from_store(command_context_t* ctx, const struct cal_store_t* store) {
+  for (int board = 0; board < CAL_STORE_BOARDS; board++) {
+    const struct cal_store_board_t* rec = &store->boards[board];
+    for (int channel = 0; channel < 8; channel++) {
+      int ch = board * 8 + channel;
+      ctx->adc_bias_valid[ch] = (rec->adc_bias_valid >> channel) & 1;
+      ctx->adc_bias[ch] = ctx->adc_bias_valid[ch] ? rec->adc_bias[channel] : 0.0;
+      ctx->dac_cal_valid[ch] = (rec->dac_cal_valid >> channel) & 1;
+      ctx->dac_cal[ch] = ctx->dac_cal_valid[ch] ? rec->dac_cal[channel] : 0;
+    }
+    cal_store_get_fit(rec, &ctx->adc_cal, board);
+    ctx->adc_bias_time[board] = rec->adc_bias_time;
+    ctx->dac_cal_time[board] = rec->dac_cal_time;
+    ctx->adc_cal_time[board] = rec->adc_fit_time;
+  }
+}
+
+// Format the age of a calibration timestamp ("-" if never calibrated), flagging stale entries
+static bool format_cal_age(int64_t cal_time, int64_t now, char* buf, size_t size) {
+  if (cal_time == 0) {
+    snprintf(buf, size, "-");
+    return false;
+  }
+  int64_t age = now - cal_time;
+  bool stale = age > CAL_STORE_MAX_AGE_S;
+  if (age < 3600) {
+    snprintf(buf, size, "%" PRId64 " min%s", age / 60, stale ? " (stale)" : "");
+  } else if (age < 48 * 3600) {
+    snprintf(buf, size, "%.1f h%s", age / 3600.0, stale ? " (stale)" : "");
+  } else {
+    snprintf(buf, size, "%.1f d%s", age / 86400.0, stale ? " (stale)" : "");
+  }
+  return stale;
+}
+
+// Print what calibration is held per board and how old it is
+static void print_calibration_summary(command_context_t* ctx) {
+  int64_t now = (int64_t)time(NULL);
+  int stale_count = 0;
+  printf("  %-6s %-22s %-22s %-22s\n", "Board", "ADC bias (ch, age)", "DAC offset (ch, age)", "ADC fit (ch, age)");
+  for (int board = 0; board < 8; board++) {
+    int bias_count = 0, dac_count = 0, fit_count = 0;
+    for (int channel = 0; channel < 8; channel++) {
+      int ch = board * 8 + channel;
+      bias_count += ctx->adc_bias_valid[ch];
+      dac_count += ctx->dac_cal_valid[ch];
+      fit_count += ctx->adc_cal.status[ch] == CAL_FIT_OK;
+    }
+    if (bias_count == 0 && dac_count == 0 && fit_count == 0) continue;
+    char bias_age[24], dac_age[24], fit_age[24], bias_col[48], dac_col[48], fit_col[48];
+    stale_count += format_cal_age(bias_count ? ctx->adc_bias_time[board] : 0, now, bias_age, sizeof(bias_age));
+    stale_count += format_cal_age(dac_count ? ctx->dac_cal_time[board] : 0, now, dac_age, sizeof(dac_age));
+    stale_count += format_cal_age(fit_count ? ctx->adc_cal_time[board] : 0, now, fit_age, sizeof(fit_age));
+    snprintf(bias_col, sizeof(bias_col), "%d, %s", bias_count, bias_age);
+    snprintf(dac_col, sizeof(dac_col), "%d, %s", dac_count, dac_age);
+    snprintf(fit_col, sizeof(fit_col), "%d, %s", fit_count, fit_age);
+    printf("  %-6d %-22s %-22s %-22s\n", board, bias_col, dac_col, fit_col);
+  }
+  if (stale_count > 0) {
+    printf("  WARNING: %d calibration(s) older than %" PRId64 " days; run cal_verify or recalibrate.\n",
+           stale_count, CAL_STORE_MAX_AGE_S / 86400);
+  }
+}
+
+// Save the calibration to the session's store after it changes (no-op if the store is disabled)
+static void autosave_calibration(command_context_t* ctx) {
+  if (ctx->cal_store_path[0] == '\0') return;
+  struct cal_store_t store;
+  calibration_to_store(ctx, &store);
+  if (cal_store_save(&store, ctx->cal_store_path) == 0 && *(ctx->verbose)) {
+    printf("Calibration store updated: %s\n", ctx->cal_store_path);
+  }
+}
+
+// Load a calibration store into the context (0 loaded, 1 no file, -1 invalid)
+int load_calibration_store(command_context_t* ctx, const char* path) {
+  struct cal_store_t store;
+  int result = cal_store_load(&store, path);
+  if (result != 0) return result;
+  calibration_from_store(ctx, &store);
+
+  char saved_age[24];
+  format_cal_age(store.saved_time, (int64_t)time(NULL), saved_age, sizeof(saved_age));
+  printf("Loaded calibration store '%s' (saved %s ago):\n", path, saved_age);
+  print_calibration_summary(ctx);
+  return 0;
+}
+
+// Save calibration store command
+int cmd_save_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  char full_path[1024];
+  if (arg_count >= 1) {
+    clean_and_expand_path(args[0], full_path, sizeof(full_path));
+  } else if (ctx->cal_store_path[0] != '\0') {
+    snprintf(full_path, sizeof(full_path), "%s", ctx->cal_store_path);
+  } else {
+    fprintf(stderr, "No calibration store is configured; give a file name.\n");
+    return -1;
+  }
+
+  struct cal_store_t store;
+  calibration_to_store(ctx, &store);
+  if (cal_store_save(&store, full_path) != 0) {
+    return -1;
+  }
+  printf("Saved calibration to '%s':\n", full_path);
+  print_calibration_summary(ctx);
+  return 0;
+}
+
+// Load calibration store command
+int cmd_load_cal(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  char full_path[1024];
+  if (arg_count >= 1) {
+    clean_and_expand_path(args[0], full_path, sizeof(full_path));
+  } else if (ctx->cal_store_path[0] != '\0') {
+    snprintf(full_path, sizeof(full_path), "%s", ctx->cal_store_path);
+  } else {
+    fprintf(stderr, "No calibration store is configured; give a file name.\n");
+    return -1;
+  }
+
+  int result = load_calibration_store(ctx, full_path);
+  if (result == 1) {
+    fprintf(stderr, "Calibration store '%s' does not exist\n", full_path);
+    return -1;
+  } else if (result != 0) {
+    return -1;
+  }
+
+  // The DAC offsets only take effect once written to the running cores
+  uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, false);
+  if (HW_STS_STATE(hw_status) == S_RUNNING) {
+    int pushed = push_dac_cal(ctx);
+    if (pushed < 0) {
+      fprintf(stderr, "Failed to write the DAC calibration to the hardware.\n");
+      return -1;
+    }
+    printf("Wrote DAC calibration for %d channel(s).\n", pushed);
+  } else {
+    printf("System is not running; DAC calibration will be written on the next 'on'.\n");
+  }
+  return 0;
+}
+
+// Quick calibration drift check command - three-point probe of every calibrated channel
+int cmd_cal_verify(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  double tolerance = 32.0; // DAC codes (~5 mA)
+  if (arg_count >= 1) {
+    char* endptr;
+    tolerance = strtod(args[0], &endptr);
+    if (*endptr != '\0' || tolerance <= 0) {
+      fprintf(stderr, "Invalid tolerance for cal_verify: '%s'. Must be a positive number of DAC codes.\n", args[0]);
+      return -1;
+    }
+  }
+
+  if (validate_system_running(ctx) != 0) {
+    return -1;
+  }
+
+  bool connected_boards[8] = {false};
+  if (find_connected_boards(ctx, connected_boards) == 0) {
+    printf("No boards are connected. Aborting calibration check.\n");
+    return -1;
+  }
+
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  if (!spi_timing_valid(&timing)) {
+    fprintf(stderr, "SPI clock frequency is unavailable; cannot time the calibration probe.\n");
+    return -1;
+  }
+
+  // Probe: zero and +/-10% full scale, a few reads per point
+  enum { num_points = 3 };
+  const int16_t dac_values[num_points] = {-3276, 0, 3276};
+  const int samples = 4;
+  const double settle_ns = 1e6; // 1ms DAC settling time before sampling
+  uint32_t settle_cycles = (uint32_t)spi_timing_ns_to_cycles(&timing, settle_ns);
+  uint32_t step_cycles = channel_sweep_step_cycles(&timing, settle_cycles, samples);
+  if (step_cycles > SPI_TIMING_MAX_DELAY_CYCLES) {
+    fprintf(stderr, "SPI clock too fast for the calibration step delay (%u cycles).\n", step_cycles);
+    return -1;
+  }
+
+  if (!has_flag(flags, flag_count, FLAG_NO_RESET)) {
+    safe_buffer_reset(ctx, *(ctx->verbose));
+    usleep(10000); // 10ms
+  }
+  for (int board = 0; board < 8; board++) {
+    if (connected_boards[board]) {
+      dac_cmd_cancel(ctx->dac_ctrl, (uint8_t)board, *(ctx->verbose));
+      adc_cmd_cancel(ctx->adc_ctrl, (uint8_t)board, *(ctx->verbose));
+    }
+  }
+  usleep(1000); // 1ms to let cancel commands complete
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    queue_channel_sweep(ctx, board, &timing, dac_values, num_points, samples, settle_cycles, step_cycles);
+  }
+  uint32_t sweep_words = 8 * (uint32_t)(num_points * samples);
+  uint64_t sweep_us = (uint64_t)(spi_timing_cycles_to_ns(&timing, 8ULL * num_points * step_cycles) / 1000.0);
+  trigger_cmd_sync_ch(ctx->trigger_ctrl, false, *(ctx->verbose));
+
+  printf("Checking calibration drift (tolerance %.1f DAC codes):\n", tolerance);
+  printf("%-6s %-8s %-8s %-12s %-10s %-10s %s\n", "Ch", "Board", "Channel", "Reference", "Offset", "Gain err", "Result");
+  int checked = 0, drifted = 0;
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    if (!wait_for_adc_words(ctx, board, sweep_words, 2 * sweep_us + 100000)) {
+      printf("  Board %d: no ADC data, skipping\n", board);
+      continue;
+    }
+    double sweep_avg[8 * num_points];
+    read_channel_sweep(ctx, board, num_points, samples, sweep_avg);
+
+    for (int channel = 0; channel < 8; channel++) {
+      int ch = board * 8 + channel;
+      const double* y = &sweep_avg[channel * num_points];
+      const char* reference;
+      double offset_err, gain_err;
+      if (ctx->adc_cal.status[ch] == CAL_FIT_OK) {
+        // Fitted channel: corrected readings should land back on the DAC codes
+        double corrected[num_points];
+        for (int i = 0; i < num_points; i++) {
+          double v = y[i] >= 0 ? y[i] + 0.5 : y[i] - 0.5;
+          corrected[i] = cal_table_apply_sample(&ctx->adc_cal, ch, (int16_t)v) - dac_values[i];
+        }
+        reference = "fit";
+        offset_err = corrected[1];
+        gain_err = (corrected[2] - corrected[0]) / 2.0;
+      } else if (ctx->dac_cal_valid[ch] || ctx->adc_bias_valid[ch]) {
+        // Offset-calibrated channel: bias-corrected reading should track the DAC code
+        double bias = ctx->adc_bias_valid[ch] ? ctx->adc_bias[ch] : 0.0;
+        reference = ctx->dac_cal_valid[ch] ? "dac offset" : "adc bias";
+        offset_err = y[1] - bias;
+        gain_err = (y[2] - y[0]) / 2.0 - dac_values[2];
+      } else {
+        continue;
+      }
+      bool drift = fabs(offset_err) > tolerance || fabs(gain_err) > tolerance;
+      checked++;
+      drifted += drift;
+      printf("%-6d %-8d %-8d %-12s %-10.1f %-10.1f %s\n", ch, board, channel, reference,
+             offset_err, gain_err, drift ? "DRIFT" : "PASS");
+    }
+  }
+
+  if (checked == 0) {
+    printf("No calibrated channels to check.\n");
+    return 0;
+  }
+  printf("\nCalibration check: %d of %d channels within tolerance", checked - drifted, checked);
+  if (drifted > 0) {
+    printf("; recalibrate the drifted channels (channel_cal, find_bias, cal_fit)\n");
+    return -1;
+  }
+  printf("\n");
+  return 0;
+}
+
+// Crosstalk matrix command - drive every connected channel in turn and measure all channels
+int cmd_crosstalk(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  char full_path[1024];
+  clean_and_expand_path(args[0], full_path, sizeof(full_path));
+
+  // Parse optional amplitude, samples per polarity and settle time
+  double amplitude_amps = 1.0;
+  if (arg_count >= 2) {
+    char* endptr;
+    amplitude_amps = strtod(args[1], &endptr);
+    if (*endptr != '\0' || amplitude_amps <= 0.0 || amplitude_amps > 5.1) {
+      fprintf(stderr, "Invalid amplitude for crosstalk: '%s'. Must be above 0 and at most 5.1 amps.\n", args[1]);
+      return -1;
+    }
+  }
+  int samples = 4;
+  if (arg_count >= 3) {
+    char* endptr;
+    samples = (int)strtol(args[2], &endptr, 0);
+    if (*endptr != '\0' || samples < 1 || samples > 64) {
+      fprintf(stderr, "Invalid sample count for crosstalk: '%s'. Must be 1 to 64.\n", args[2]);
+      return -1;
+    }
+  }
+
+  if (validate_system_running(ctx) != 0) {
+    return -1;
+  }
+
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  if (!spi_timing_valid(&timing)) {
+    fprintf(stderr, "SPI clock frequency is unavailable; cannot time the crosstalk sweep.\n");
+    return -1;
+  }
+  uint32_t settle_cycles = (uint32_t)spi_timing_ns_to_cycles(&timing, 1e6); // 1ms default
+  if (arg_count >= 4 && spi_timing_parse_delay(&timing, args[3], timing.dac_wr_min_delay, &settle_cycles) != 0) {
+    fprintf(stderr, "Invalid settle time for crosstalk: '%s'. Use cycles, 'min', or a time like 500us.\n", args[3]);
+    return -1;
+  }
+  if (settle_cycles < timing.dac_wr_min_delay) settle_cycles = timing.dac_wr_min_delay;
+
+  bool connected_boards[8] = {false};
+  int connected_count = find_connected_boards(ctx, connected_boards);
+  if (connected_count == 0) {
+    printf("No boards are connected. Aborting crosstalk measurement.\n");
+    return -1;
+  }
+
+  // Every step: write the DAC, settle, then `samples` ADC_RD reads of all channels at the minimum spacing
+  int16_t amplitude_code = (int16_t)(32767.0 * amplitude_amps / 5.1);
+  int num_driven = 8 * connected_count;
+  int steps = 2 * num_driven;
+  uint32_t spacing_cycles = timing.adc_rd_min_delay;
+  uint32_t read_cycles = (uint32_t)samples * spacing_cycles;
+  uint32_t step_cycles = settle_cycles + read_cycles + settle_cycles / 10 + timing.dac_wr_min_delay;
+  if (step_cycles > SPI_TIMING_MAX_DELAY_CYCLES) {
+    fprintf(stderr, "Settle time too long for the crosstalk step delay (%u cycles).\n", step_cycles);
+    return -1;
+  }
+  int driven_channels[64];
+  for (int board = 0, n = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    for (int channel = 0; channel < 8; channel++) driven_channels[n++] = board * 8 + channel;
+  }
+
+  // Precompute each board's command streams
+  uint32_t adc_words_per_step = samples > 1 ? 4 : 3;
+  size_t dac_count = 1 + (size_t)(steps + 1) * DAC_WR_WORDCOUNT;
+  size_t adc_count = 1 + (size_t)steps * adc_words_per_step;
+  if (dac_count >= DAC_CMD_FIFO_WORDCOUNT || adc_count >= ADC_CMD_FIFO_WORDCOUNT) {
+    fprintf(stderr, "Crosstalk sweep doesn't fit the command FIFOs (%zu DAC, %zu ADC words).\n", dac_count, adc_count);
+    return -1;
+  }
+  uint32_t* dac_words = malloc(dac_count * sizeof(uint32_t));
+  uint32_t* adc_words = malloc(adc_count * sizeof(uint32_t));
+  uint32_t words_per_board = (uint32_t)steps * (uint32_t)samples * 4;
+  uint32_t* data[8] = {NULL};
+  bool alloc_ok = dac_words != NULL && adc_words != NULL;
+  for (int board = 0; board < 8 && alloc_ok; board++) {
+    if (!connected_boards[board]) continue;
+    data[board] = malloc(words_per_board * sizeof(uint32_t));
+    alloc_ok = data[board] != NULL;
+  }
+  if (!alloc_ok) {
+    fprintf(stderr, "Failed to allocate the crosstalk sweep\n");
+    free(dac_words);
+    free(adc_words);
+    for (int board = 0; board < 8; board++) free(data[board]);
+    return -1;
+  }
+
+  printf("Measuring crosstalk for %d channels: +/-%.3f A (%d DAC codes), %d reads per polarity, %.3f ms per step\n",
+         num_driven, amplitude_amps, amplitude_code, samples, spi_timing_cycles_to_ns(&timing, step_cycles) / 1e6);
+
+  if (!has_flag(flags, flag_count, FLAG_NO_RESET)) {
+    if (*(ctx->verbose)) {
+      printf("Resetting all buffers...\n");
+    }
+    safe_buffer_reset(ctx, *(ctx->verbose));
+    usleep(10000); // 10ms
+  }
+  for (int board = 0; board < 8; board++) {
+    if (connected_boards[board]) {
+      dac_cmd_cancel(ctx->dac_ctrl, (uint8_t)board, *(ctx->verbose));
+      adc_cmd_cancel(ctx->adc_ctrl, (uint8_t)board, *(ctx->verbose));
+    }
+  }
+  usleep(1000); // 1ms to let cancel commands complete
+
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    size_t d = 0, a = 0;
+    dac_words[d++] = dac_encode_cmd(DAC_CMD_NO_OP, true, false, false, 1);
+    adc_words[a++] = adc_encode_cmd(ADC_CMD_NO_OP, true, false, 1);
+    for (int step = 0; step < steps; step++) {
+      int driven = driven_channels[step / 2];
+      int16_t ch_vals[8] = {0};
+      if (driven / 8 == board) {
+        ch_vals[driven % 8] = (step % 2 == 0) ? amplitude_code : (int16_t)-amplitude_code;
+      }
+      dac_encode_dac_wr(&dac_words[d], ch_vals, false, false, true, step_cycles);
+      d += DAC_WR_WORDCOUNT;
+      adc_words[a++] = adc_encode_cmd(ADC_CMD_NO_OP, false, false, settle_cycles);
+      if (samples > 1) {
+        adc_words[a++] = adc_encode_cmd(ADC_CMD_ADC_RD, false, false, spacing_cycles) | (1u << ADC_CMD_REPEAT_BIT);
+        adc_words[a++] = (uint32_t)samples - 1;
+      } else {
+        adc_words[a++] = adc_encode_cmd(ADC_CMD_ADC_RD, false, false, spacing_cycles);
+      }
+      adc_words[a++] = adc_encode_cmd(ADC_CMD_NO_OP, false, false, step_cycles - settle_cycles - read_cycles);
+    }
+    int16_t zero_vals[8] = {0};
+    dac_encode_dac_wr(&dac_words[d], zero_vals, false, false, true, timing.dac_wr_min_delay);
+    dac_write_cmd_words(ctx->dac_ctrl, (uint8_t)board, dac_words, dac_count);
+    adc_write_cmd_words(ctx->adc_ctrl, (uint8_t)board, adc_words, adc_count);
+  }
+  free(dac_words);
+  free(adc_words);
+
+  // Release every board together and drain the results in bulk as they arrive
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  uint64_t sweep_us = (uint64_t)(spi_timing_cycles_to_ns(&timing, (uint64_t)steps * step_cycles) / 1000.0);
+  uint64_t timeout_us = 2 * sweep_us + 100000;
+  trigger_cmd_sync_ch(ctx->trigger_ctrl, false, *(ctx->verbose));
+
+  uint32_t received[8] = {0};
+  uint64_t elapsed_us = 0;
+  while (elapsed_us <= timeout_us) {
+    bool done = true, progress = false;
+    for (int board = 0; board < 8; board++) {
+      if (!connected_boards[board] || received[board] == words_per_board) continue;
+      uint32_t available = FIFO_STS_WORD_COUNT(sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false));
+      uint32_t count = available < words_per_board - received[board] ? available : words_per_board - received[board];
+      if (count > 0) {
+        adc_read_words(ctx->adc_ctrl, (uint8_t)board, &data[board][received[board]], count);
+        received[board] += count;
+        progress = true;
+      }
+      done = done && received[board] == words_per_board;
+    }
+    if (done) break;
+    if (!progress) usleep(1000); // 1ms
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed_us = (uint64_t)(now.tv_sec - start.tv_sec) * 1000000 + (now.tv_nsec - start.tv_nsec) / 1000;
+  }
+
+  // Corrected per-channel sums at each polarity, then one matrix row per driven channel
+  struct cal_table_t correction;
+  get_adc_correction(ctx, &correction);
+  uint64_t channel_mask = 0;
+  for (int board = 0; board < 8; board++) {
+    if (!connected_boards[board]) continue;
+    if (received[board] < words_per_board) {
+      printf("  Board %d: no ADC data (%u of %u words), its channels are left out\n", board, received[board], words_per_board);
+      continue;
+    }
+    cal_table_apply_words(&correction, (uint8_t)board, data[board], data[board], words_per_board, 0);
+    channel_mask |= (uint64_t)0xFF << (8 * board);
+  }
+
+  struct crosstalk_matrix_t* matrix = malloc(sizeof(struct crosstalk_matrix_t));
+  if (matrix == NULL) {
+    fprintf(stderr, "Failed to allocate the crosstalk matrix\n");
+    for (int board = 0; board < 8; board++) free(data[board]);
+    return -1;
+  }
+  *matrix = create_crosstalk_matrix(channel_mask, (float)amplitude_code, (uint32_t)samples);
+  matrix->time = (int64_t)time(NULL);
+  for (int i = 0; i < num_driven; i++) {
+    int32_t pos_sums[CROSSTALK_CHANNELS] = {0}, neg_sums[CROSSTALK_CHANNELS] = {0};
+    for (int board = 0; board < 8; board++) {
+      if (!((channel_mask >> (8 * board)) & 1)) continue;
+      const uint32_t* step_data = &data[board][(size_t)(2 * i) * samples * 4];
+      crosstalk_accumulate(&pos_sums[board * 8], step_data, (size_t)samples);
+      crosstalk_accumulate(&neg_sums[board * 8], step_data + samples * 4, (size_t)samples);
+    }
+    crosstalk_set_row(matrix, driven_channels[i], pos_sums, neg_sums);
+  }
+  for (int board = 0; board < 8; board++) free(data[board]);
+
+  if (channel_mask == 0) {
+    printf("No sweep data was collected.\n");
+    free(matrix);
+    return -1;
+  }
+
+  // Summary: own-response range and the largest couplings relative to it
+  enum { worst_count = 5 };
+  int worst_driven[worst_count], worst_measured[worst_count];
+  float worst_rel[worst_count] = {0};
+  float min_gain = INFINITY, max_gain = -INFINITY;
+  int above_1pct = 0;
+  for (int i = 0; i < worst_count; i++) worst_driven[i] = worst_measured[i] = -1;
+  for (int driven = 0; driven < CROSSTALK_CHANNELS; driven++) {
+    if (!((channel_mask >> driven) & 1)) continue;
+    float gain = matrix->coupling[driven][driven];
+    if (gain < min_gain) min_gain = gain;
+    if (gain > max_gain) max_gain = gain;
+    for (int measured = 0; measured < CROSSTALK_CHANNELS; measured++) {
+      if (measured == driven || !((channel_mask >> measured) & 1)) continue;
+      float rel = fabsf(crosstalk_relative(matrix, driven, measured));
+      if (isnan(rel)) continue;
+      if (rel > 0.01f) above_1pct++;
+      for (int k = 0; k < worst_count; k++) {
+        if (worst_driven[k] >= 0 && rel <= worst_rel[k]) continue;
+        for (int j = worst_count - 1; j > k; j--) {
+          worst_rel[j] = worst_rel[j - 1];
+          worst_driven[j] = worst_driven[j - 1];
+          worst_measured[j] = worst_measured[j - 1];
+        }
+        worst_rel[k] = rel;
+        worst_driven[k] = driven;
+        worst_measured[k] = measured;
+        break;
+      }
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double total_s = (double)(now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+  printf("Crosstalk sweep done in %.2f s. Own response: %.4f to %.4f ADC codes per DAC code\n", total_s, min_gain, max_gain);
+  printf("Channel pairs coupled above 1%%: %d\n", above_1pct);
+  for (int k = 0; k < worst_count && worst_driven[k] >= 0; k++) {
+    printf("  ch%02d -> ch%02d: %+.4f%% (%.5f)\n", worst_driven[k], worst_measured[k],
+           100.0f * crosstalk_relative(matrix, worst_driven[k], worst_measured[k]),
+           matrix->coupling[worst_driven[k]][worst_measured[k]]);
+  }
+
+  bool binary = has_flag(flags, flag_count, FLAG_BIN);
+  int result = binary ? crosstalk_save_bin(matrix, full_path) : crosstalk_save_csv(matrix, full_path);
+  if (result == 0) {
+    printf("Crosstalk matrix written to '%s' (%s)\n", full_path, binary ? "binary" : "CSV");
+  }
+  free(matrix);
+  return result;
+}
+
+// Closed-loop regulation parameters (owned by the regulation thread)
+typedef struct {
+  command_context_t* ctx;
+  int first_ch;
+  int last_ch;
+  bool boards[8];                // Boards with a regulated channel
+  bool full_board[8];            // All 8 channels regulated: one DAC_WR/ADC_RD per board instead of _CH commands
+  int single_ch[8];              // The only regulated channel on a board (-1 if several)
+  uint32_t adc_words[8];         // Data words one read produces
+  int16_t target;                // DAC codes
+  uint64_t period_ns;
+  uint64_t duration_ns;          // 0 runs until stop_regulate
+  uint32_t dac_wr_delay;         // DAC_WR/ADC_RD command delays (minimum spacing)
+  uint32_t adc_rd_delay;
+  struct cal_table_t correction;
+  struct pi_ctrl_t pi[64];
+  int16_t output[64];
+  int32_t measured[64];
+  double error_sq_sum[64];
+  struct loop_hist_t wake_hist;  // Lateness of each wake-up against its deadline
+  struct loop_hist_t latency_hist; // Wake-up to last DAC write (ADC read, PI, DAC write)
+  uint64_t iterations;
+  uint64_t overruns;             // Iterations that ran past the next deadline
+  uint64_t read_timeouts;        // Iterations whose ADC data didn't arrive within the period
+  bool realtime;                 // Running under SCHED_FIFO
+} regulate_params_t;
+
+// Parse a host time with a ns/us/ms/s suffix
+static int parse_host_time_ns(const char* str, uint64_t* ns) {
+  char* endptr;
+  double value = strtod(str, &endptr);
+  if (endptr == str || value <= 0) return -1;
+  double scale;
+  if (strcmp(endptr, "ns") == 0) scale = 1.0;
+  else if (strcmp(endptr, "us") == 0) scale = 1e3;
+  else if (strcmp(endptr, "ms") == 0) scale = 1e6;
+  else if (strcmp(endptr, "s") == 0) scale = 1e9;
+  else return -1;
+  *ns = (uint64_t)(value * scale + 0.5);
+  return 0;
+}
+
+static uint64_t timespec_ns(const struct timespec* ts) {
+  return (uint64_t)ts->tv_sec * 1000000000ULL + (uint64_t)ts->tv_nsec;
+}
+
+// Regulation loop: each period read the regulated channels, run the PI step and write the corrections
+static void* regulate_thread(void* arg) {
+  regulate_params_t* p = (regulate_params_t*)arg;
+  command_context_t* ctx = p->ctx;
+  uint32_t words[8][4];
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t start_ns = timespec_ns(&ts);
+  uint64_t next_ns = start_ns;
+
+  while (!ctx->regulate_stop) {
+    next_ns += p->period_ns;
+    ts.tv_sec = (time_t)(next_ns / 1000000000ULL);
+    ts.tv_nsec = (long)(next_ns % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t wake_ns = timespec_ns(&ts);
+    loop_hist_add(&p->wake_hist, wake_ns > next_ns ? wake_ns - next_ns : 0);
+
+    // Drop data left by a read that timed out, then start every board's read so the conversions overlap
+    for (int board = 0; board < 8; board++) {
+      if (!p->boards[board]) continue;
+      uint32_t stale = FIFO_STS_WORD_COUNT(sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false));
+      while (stale > 0) {
+        uint32_t n = stale < 4 ? stale : 4;
+        adc_read_words(ctx->adc_ctrl, (uint8_t)board, words[board], n);
+        stale -= n;
+      }
+      if (p->single_ch[board] >= 0) {
+        adc_cmd_adc_rd_ch(ctx->adc_ctrl, (uint8_t)board, (uint8_t)p->single_ch[board], 0, false);
+      } else {
+        adc_cmd_adc_rd(ctx->adc_ctrl, (uint8_t)board, false, false, p->adc_rd_delay, 0, 0, false);
+      }
+    }
+
+    // Spin on each board's data FIFO (for at most one period), then update and write back
+    uint64_t deadline_ns = wake_ns + p->period_ns;
+    bool timed_out = false;
+    for (int board = 0; board < 8; board++) {
+      if (!p->boards[board]) continue;
+      while (FIFO_STS_WORD_COUNT(sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false)) < p->adc_words[board]) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        if (timespec_ns(&ts) >= deadline_ns) {
+          timed_out = true;
+          break;
+        }
+      }
+      if (timed_out) break;
+      adc_read_words(ctx->adc_ctrl, (uint8_t)board, words[board], p->adc_words[board]);
+
+      int16_t dac_vals[8] = {0};
+      for (int channel = 0; channel < 8; channel++) {
+        int ch = board * 8 + channel;
+        if (ch < p->first_ch || ch > p->last_ch) continue;
+        uint32_t word = (p->single_ch[board] >= 0) ? words[board][0] : words[board][channel / 2];
+        uint16_t raw = (p->single_ch[board] >= 0 || channel % 2 == 0) ? (uint16_t)(word & 0xFFFF) : (uint16_t)(word >> 16);
+        int32_t measured = cal_table_apply_sample(&p->correction, ch, offset_to_signed(raw));
+        p->measured[ch] = measured;
+        p->output[ch] = pi_ctrl_update(&p->pi[ch], p->target, measured);
+        double error = (double)p->target - measured;
+        p->error_sq_sum[ch] += error * error;
+        dac_vals[channel] = p->output[ch];
+        if (!p->full_board[board]) {
+          dac_cmd_dac_wr_ch(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, p->output[ch], false);
+        }
+      }
+      if (p->full_board[board]) {
+        // One burst, so the data words can't lag the command word
+        uint32_t dac_words[DAC_WR_WORDCOUNT];
+        dac_encode_dac_wr(dac_words, dac_vals, false, false, true, p->dac_wr_delay);
+        dac_write_cmd_words(ctx->dac_ctrl, (uint8_t)board, dac_words, DAC_WR_WORDCOUNT);
+      }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t done_ns = timespec_ns(&ts);
+    p->iterations++;
+    if (timed_out) {
+      p->read_timeouts++;
+    } else {
+      loop_hist_add(&p->latency_hist, done_ns - wake_ns);
+    }
+
+    // Missed deadlines are skipped rather than run back to back
+    if (done_ns >= next_ns + p->period_ns) {
+      p->overruns++;
+      next_ns += ((done_ns - next_ns) / p->period_ns) * p->period_ns;
+    }
+    if (p->duration_ns > 0 && done_ns - start_ns >= p->duration_ns) break;
+  }
+
+  // Leave the regulated channels at zero
+  for (int board = 0; board < 8; board++) {
+    if (!p->boards[board]) continue;
+    for (int channel = 0; channel < 8; channel++) {
+      int ch = board * 8 + channel;
+      if (ch >= p->first_ch && ch <= p->last_ch) {
+        dac_cmd_dac_wr_ch(ctx->dac_ctrl, (uint8_t)board, (uint8_t)channel, 0, false);
+      }
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  double elapsed_s = (timespec_ns(&ts) - start_ns) / 1e9;
+  fprintf(ctx->console_out, "\nRegulation of channels %d-%d stopped after %.2f s: %llu iterations at %.1f us period%s\n",
+         p->first_ch, p->last_ch, elapsed_s, (unsigned long long)p->iterations, p->period_ns / 1000.0,
+         p->realtime ? " (SCHED_FIFO)" : " (normal scheduling)");
+  fprintf(ctx->console_out, "  Overruns: %llu, ADC read timeouts: %llu\n",
+         (unsigned long long)p->overruns, (unsigned long long)p->read_timeouts);
+  loop_hist_print(&p->wake_hist, "Wake-up jitter", ctx->console_out);
+  loop_hist_print(&p->latency_hist, "Read-to-write latency", ctx->console_out);
+  uint64_t updates = p->iterations - p->read_timeouts;
+  fprintf(ctx->console_out, "  %-4s %8s %8s %8s %10s\n", "ch", "target", "last", "output", "rms error");
+  for (int ch = p->first_ch; ch <= p->last_ch; ch++) {
+    fprintf(ctx->console_out, "  %-4d %8d %8d %8d %10.2f\n", ch, p->target, p->measured[ch], p->output[ch],
+           updates > 0 ? sqrt(p->error_sq_sum[ch] / updates) : 0.0);
+  }
+  fflush(ctx->console_out);
+
+  // Still joined by the next regulate or stop_regulate (or at exit)
+  ctx->regulate_done = true;
+  free(p);
+  return NULL;
+}
+
+// Join a regulation thread that ended on its own (duration elapsed)
+static void join_finished_regulation(command_context_t* ctx) {
+  if (ctx->regulate_running && ctx->regulate_done) {
+    pthread_join(ctx->regulate_thread, NULL);
+    ctx->regulate_running = false;
+  }
+}
+
+// Closed-loop regulation command - hold a channel range at a target current with a PI loop
+int cmd_regulate(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  join_finished_regulation(ctx);
+  if (ctx->regulate_running) {
+    printf("Regulation is already running. Use 'stop_regulate' first.\n");
+    return -1;
+  }
+
+  int first_ch = atoi(args[0]);
+  int last_ch = atoi(args[1]);
+  if (first_ch < 0 || first_ch > 63 || last_ch < first_ch || last_ch > 63) {
+    fprintf(stderr, "Invalid channel range for regulate: %s-%s. Must be 0-63 with first <= last.\n", args[0], args[1]);
+    return -1;
+  }
+  char* endptr;
+  double target_amps = strtod(args[2], &endptr);
+  if (*endptr != '\0' || fabs(target_amps) > 5.1) {
+    fprintf(stderr, "Invalid target current for regulate: '%s'. Must be -5.1 to 5.1 amps.\n", args[2]);
+    return -1;
+  }
+  uint64_t period_ns = 1000000; // 1ms
+  if (arg_count >= 4 && parse_host_time_ns(args[3], &period_ns) != 0) {
+    fprintf(stderr, "Invalid period for regulate: '%s'. Use a time like 500us or 1ms.\n", args[3]);
+    return -1;
+  }
+  double kp = 0.2, ki = 0.05;
+  if (arg_count >= 5) {
+    kp = strtod(args[4], &endptr);
+    if (*endptr != '\0' || kp < 0 || kp > PI_CTRL_MAX_GAIN) {
+      fprintf(stderr, "Invalid kp for regulate: '%s'. Must be 0 to %.0f.\n", args[4], PI_CTRL_MAX_GAIN);
+      return -1;
+    }
+  }
+  if (arg_count >= 6) {
+    ki = strtod(args[5], &endptr);
+    if (*endptr != '\0' || ki < 0 || ki > PI_CTRL_MAX_GAIN) {
+      fprintf(stderr, "Invalid ki for regulate: '%s'. Must be 0 to %.0f.\n", args[5], PI_CTRL_MAX_GAIN);
+      return -1;
+    }
+  }
+  uint64_t duration_ns = 0;
+  if (arg_count >= 7 && parse_host_time_ns(args[6], &duration_ns) != 0) {
+    fprintf(stderr, "Invalid duration for regulate: '%s'. Use a time like 10s.\n", args[6]);
+    return -1;
+  }
+
+  if (validate_system_running(ctx) != 0) {
+    return -1;
+  }
+  struct spi_timing_t timing = get_spi_timing(ctx);
+  if (!spi_timing_valid(&timing)) {
+    fprintf(stderr, "SPI clock frequency is unavailable; cannot time the regulation loop.\n");
+    return -1;
+  }
+
+  regulate_params_t* p = calloc(1, sizeof(regulate_params_t));
+  if (p == NULL) {
+    fprintf(stderr, "Failed to allocate regulation state\n");
+    return -1;
+  }
+  p->ctx = ctx;
+  p->first_ch = first_ch;
+  p->last_ch = last_ch;
+  p->target = (int16_t)(32767.0 * target_amps / 5.1);
+  p->period_ns = period_ns;
+  p->duration_ns = duration_ns;
+  p->dac_wr_delay = timing.dac_wr_min_delay;
+  p->adc_rd_delay = timing.adc_rd_min_delay;
+  get_adc_correction(ctx, &p->correction);
+  p->wake_hist = create_loop_hist();
+  p->latency_hist = create_loop_hist();
+  for (int ch = 0; ch < 64; ch++) {
+    p->pi[ch] = create_pi_ctrl(kp, ki, PI_CTRL_OUTPUT_LIMIT);
+  }
+
+  bool connected_boards[8] = {false};
+  find_connected_boards(ctx, connected_boards);
+  for (int board = first_ch / 8; board <= last_ch / 8; board++) {
+    if (!connected_boards[board]) {
+      fprintf(stderr, "Board %d (channels %d-%d) is not connected.\n", board, board * 8, board * 8 + 7);
+      free(p);
+      return -1;
+    }
+    if (ctx->dac_cmd_stream_running[board] || ctx->adc_cmd_stream_running[board] || ctx->adc_data_stream_running[board]) {
+      fprintf(stderr, "Board %d has active command/data streams. Stop them before regulating.\n", board);
+      free(p);
+      return -1;
+    }
+    int lo = (first_ch > board * 8) ? first_ch : board * 8;
+    int hi = (last_ch < board * 8 + 7) ? last_ch : board * 8 + 7;
+    p->boards[board] = true;
+    p->full_board[board] = (lo == board * 8 && hi == board * 8 + 7);
+    p->single_ch[board] = (lo == hi) ? lo % 8 : -1;
+    p->adc_words[board] = (lo == hi) ? 1 : 4;
+  }
+
+  // Start from empty FIFOs and idle cores on the regulated boards
+  if (!has_flag(flags, flag_count, FLAG_NO_RESET)) {
+    safe_buffer_reset(ctx, *(ctx->verbose));
+    usleep(10000); // 10ms
+  }
+  for (int board = 0; board < 8; board++) {
+    if (!p->boards[board]) continue;
+    dac_cmd_cancel(ctx->dac_ctrl, (uint8_t)board, *(ctx->verbose));
+    adc_cmd_cancel(ctx->adc_ctrl, (uint8_t)board, *(ctx->verbose));
+  }
+  usleep(1000); // 1ms to let cancel commands complete
+
+  printf("Regulating channels %d-%d at %.3f A (%d DAC codes): period %.1f us, kp %.3f, ki %.3f%s\n",
+         first_ch, last_ch, target_amps, p->target, period_ns / 1000.0, kp, ki,
+         duration_ns > 0 ? "" : " - 'stop_regulate' ends it");
+
+  // Prefer a real-time thread; fall back to normal scheduling without the privilege
+  ctx->regulate_stop = false;
+  ctx->regulate_done = false;
+  ctx->regulate_running = true;
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+  pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+  struct sched_param sp = {.sched_priority = sched_get_priority_max(SCHED_FIFO) - 10};
+  pthread_attr_setschedparam(&attr, &sp);
+  p->realtime = true;
+  int result = pthread_create(&ctx->regulate_thread, &attr, regulate_thread, p);
+  pthread_attr_destroy(&attr);
+  if (result == EPERM) {
+    printf("  No permission for SCHED_FIFO; running with normal scheduling (expect more jitter)\n");
+    p->realtime = false;
+    result = pthread_create(&ctx->regulate_thread, NULL, regulate_thread, p);
+  }
+  if (result != 0) {
+    fprintf(stderr, "Failed to create regulation thread: %s\n", strerror(result));
+    ctx->regulate_running = false;
+    free(p);
+    return -1;
+  }
+  return 0;
+}
+
+// Stop closed-loop regulation (the thread prints its timing report)
+int cmd_stop_regulate(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  join_finished_regulation(ctx);
+  if (!ctx->regulate_running) {
+    printf("No regulation is currently running.\n");
+    return 0;
+  }
+  ctx->regulate_stop = true;
+  if (pthread_join(ctx->regulate_thread, NULL) != 0) {
+    fprintf(stderr, "Failed to join regulation thread.\n");
+    return -1;
+  }
+  ctx->regulate_running = false;
+  return 0;
+}
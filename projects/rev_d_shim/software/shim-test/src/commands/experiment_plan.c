@@ -0,0 +1,374 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "experiment_plan.h"
+#include "dac_ctrl.h"
+#include "adc_ctrl.h"
+
+// Triggers waited for by a T line (a count of 0 still waits for one)
+static uint32_t trigger_line_count(uint32_t value) {
+  return value > 0 ? value : 1;
+}
+
+// Counts for one pass of a DAC file (a loop block counts once per pass, but its words are only
+// pushed once). Returns -1 for a loop that repeats until cancelled, which has no end to plan for.
+static int summarize_dac_source(plan_source_t* src) {
+  uint32_t gap = 0;
+  uint32_t passes = 1;
+  int loop_end = 0;
+  for (int i = 0; i < src->command_count; i++) {
+    const waveform_command_t* cmd = &src->dac_commands[i];
+    if (cmd->loop_commands > 0) {
+      if (cmd->loop_passes == 0) {
+        fprintf(stderr, "DAC file '%s' loops until cancelled, so it can't be part of a plan\n", src->path);
+        return -1;
+      }
+      passes = cmd->loop_passes;
+      loop_end = i + cmd->loop_commands;
+    } else if (i == loop_end) {
+      passes = 1;
+    }
+    uint32_t words = waveform_command_words(cmd);
+    if (cmd->is_trigger) {
+      src->triggers += trigger_line_count(cmd->value) * passes;
+      if (gap > src->max_gap_words) src->max_gap_words = gap;
+      gap = words;
+    } else {
+      src->timed_cycles += (uint64_t)cmd->value * passes;
+      gap += words;
+    }
+  }
+  if (gap > src->max_gap_words) src->max_gap_words = gap;
+  return 0;
+}
+
+// Counts for one pass of an ADC file
+static void summarize_adc_source(plan_source_t* src) {
+  uint32_t gap = 0;
+  for (int i = 0; i < src->command_count; i++) {
+    const adc_command_t* cmd = &src->adc_commands[i];
+    uint32_t words = ((cmd->type == 'D') && (cmd->repeat_count > 0)) ? 2 : 1;
+    if (cmd->type == 'T') {
+      src->triggers += trigger_line_count(cmd->value);
+      if (gap > src->max_gap_words) src->max_gap_words = gap;
+      gap = words;
+    } else {
+      if (cmd->type == 'D') {
+        src->adc_data_words += 4 * ((uint64_t)cmd->repeat_count + 1);
+        src->timed_cycles += (uint64_t)cmd->value * ((uint64_t)cmd->repeat_count + 1);
+      }
+      gap += words;
+    }
+  }
+  if (gap > src->max_gap_words) src->max_gap_words = gap;
+}
+
+// Clipping report for a packed DAC file, from one decode pass
+static int preemph_pack_report(plan_source_t* src, const struct preemph_t* preemph, uint8_t board, uint32_t spi_clk_freq_hz) {
+  waveform_unpacker_t unpacker;
+  if (waveform_unpacker_init(&unpacker, &src->pack) != 0) return -1;
+  src->preemph = create_preemph_state(board, spi_clk_freq_hz);
+  waveform_command_t cmd;
+  int result;
+  while ((result = waveform_unpacker_next(&unpacker, &cmd)) == 1) {
+    preemph_waveform_command(preemph, &src->preemph, &cmd);
+  }
+  waveform_unpacker_free(&unpacker);
+  if (result < 0) {
+    fprintf(stderr, "Packed waveform '%s' is corrupt at command %llu\n", src->path, (unsigned long long)unpacker.decoded);
+    return -1;
+  }
+  return 0;
+}
+
+static void free_source(plan_source_t* src) {
+  waveform_pack_free(&src->pack);
+  free(src->dac_commands);
+  free(src->adc_commands);
+  free(src->words);
+  memset(src, 0, sizeof(*src));
+}
+
+// Find a source for a file, parsing it only if no unchanged copy is already held.
+// preemph_board >= 0 filters a DAC file with that board's pre-emphasis.
+static int get_source(experiment_plan_t* plan, const char* path, bool is_dac, const struct spi_timing_t* timing,
+                      const struct preemph_t* preemph, int preemph_board) {
+  struct stat st;
+  bool have_stat = (stat(path, &st) == 0);
+
+  for (int i = 0; i < plan->source_count; i++) {
+    plan_source_t* src = &plan->sources[i];
+    if (src->path[0] == '\0' || src->is_dac != is_dac || strcmp(src->path, path) != 0 ||
+        src->preemph_board != preemph_board) continue;
+    if (have_stat && src->size == st.st_size && src->mtime.tv_sec == st.st_mtim.tv_sec &&
+        src->mtime.tv_nsec == st.st_mtim.tv_nsec && src->spi_clk_freq_hz == timing->spi_clk_freq_hz &&
+        (preemph_board < 0 || src->preemph_generation == preemph->generation)) {
+      src->in_use = true;
+      return i;
+    }
+    if (!src->in_use) free_source(src); // Stale copy
+  }
+
+  // Take an empty slot, or evict a source this build doesn't use
+  int slot = -1;
+  for (int i = 0; i < plan->source_count && slot < 0; i++) {
+    if (plan->sources[i].path[0] == '\0') slot = i;
+  }
+  if (slot < 0 && plan->source_count < EXPERIMENT_PLAN_MAX_SOURCES) slot = plan->source_count++;
+  for (int i = 0; i < plan->source_count && slot < 0; i++) {
+    if (!plan->sources[i].in_use) {
+      free_source(&plan->sources[i]);
+      slot = i;
+    }
+  }
+  if (slot < 0) {
+    fprintf(stderr, "Too many distinct command files for one plan (max %d)\n", EXPERIMENT_PLAN_MAX_SOURCES);
+    return -1;
+  }
+
+  plan_source_t* src = &plan->sources[slot];
+  memset(src, 0, sizeof(*src));
+  snprintf(src->path, sizeof(src->path), "%s", path);
+  src->preemph_board = preemph_board;
+  if (is_dac) {
+    int pack_result = load_dac_waveform_pack(path, timing, &src->pack);
+    if (pack_result < 0) {
+      free_source(src);
+      return -1;
+    }
+    src->packed = (pack_result == 0);
+  }
+
+  if (src->packed) {
+    // The header has the per-pass counts; the commands are only decoded while streaming
+    src->command_count = (int)src->pack.command_count;
+    src->word_count = src->pack.word_count;
+    src->triggers = src->pack.triggers;
+    src->timed_cycles = src->pack.timed_cycles;
+    src->max_gap_words = src->pack.max_gap_words;
+    if (preemph_board >= 0) {
+      if (preemph_pack_report(src, preemph, (uint8_t)preemph_board, timing->spi_clk_freq_hz) != 0) {
+        free_source(src);
+        return -1;
+      }
+      src->preemph_generation = preemph->generation;
+    }
+  } else {
+    int result = is_dac ? parse_waveform_file(path, timing, &src->dac_commands, &src->command_count)
+                        : parse_adc_command_file(path, timing, &src->adc_commands, &src->command_count);
+    if (result != 0) {
+      free_source(src);
+      return -1;
+    }
+    if (preemph_board >= 0) {
+      src->preemph = preemph_waveform_commands(preemph, (uint8_t)preemph_board, timing->spi_clk_freq_hz,
+                                               src->dac_commands, src->command_count);
+      src->preemph_generation = preemph->generation;
+    }
+    src->words = is_dac ? encode_waveform_commands(src->dac_commands, src->command_count, &src->word_count)
+                        : encode_adc_commands(src->adc_commands, src->command_count, &src->word_count);
+    if (src->words == NULL) {
+      free_source(src);
+      return -1;
+    }
+    if (is_dac) {
+      if (summarize_dac_source(src) != 0) {
+        free_source(src);
+        return -1;
+      }
+    } else {
+      summarize_adc_source(src);
+    }
+  }
+
+  src->is_dac = is_dac;
+  if (have_stat) {
+    src->mtime = st.st_mtim;
+    src->size = st.st_size;
+  }
+  src->spi_clk_freq_hz = timing->spi_clk_freq_hz;
+  src->in_use = true;
+  plan->parsed_files++;
+  return slot;
+}
+
+int experiment_plan_build(experiment_plan_t* plan, command_context_t* ctx, const bool boards[8],
+                          const char dac_files[8][1024], const char adc_files[8][1024],
+                          const int dac_iterations[8], const int adc_iterations[8],
+                          uint32_t lockout_cycles, double spi_freq_mhz, bool binary_output) {
+  struct spi_timing_t timing = get_spi_timing(ctx);
+
+  for (int i = 0; i < plan->source_count; i++) plan->sources[i].in_use = false;
+  memset(plan->boards, 0, sizeof(plan->boards));
+  memset(plan->board, 0, sizeof(plan->board));
+  plan->total_triggers = 0;
+  plan->duration_cycles = 0;
+  plan->parsed_files = 0;
+  plan->lockout_cycles = lockout_cycles;
+  plan->spi_freq_mhz = spi_freq_mhz;
+  plan->binary_output = binary_output;
+
+  int reference_board = -1;
+  uint64_t max_timed_cycles = 0;
+  for (int b = 0; b < 8; b++) {
+    if (!boards[b]) continue;
+    board_plan_t* bp = &plan->board[b];
+    int preemph_board = preemph_board_active(&ctx->preemph, (uint8_t)b) ? b : -1;
+    bp->dac_source = get_source(plan, dac_files[b], true, &timing, &ctx->preemph, preemph_board);
+    if (bp->dac_source < 0) return -1;
+    bp->adc_source = get_source(plan, adc_files[b], false, &timing, &ctx->preemph, -1);
+    if (bp->adc_source < 0) return -1;
+    bp->dac_iterations = dac_iterations[b];
+    bp->adc_iterations = adc_iterations[b];
+
+    const plan_source_t* dac = &plan->sources[bp->dac_source];
+    const plan_source_t* adc = &plan->sources[bp->adc_source];
+    uint32_t dac_total_triggers = dac->triggers * (uint32_t)bp->dac_iterations;
+    uint32_t adc_total_triggers = adc->triggers * (uint32_t)bp->adc_iterations;
+
+    // Validate that DAC and ADC have same trigger count for this board
+    if (dac_total_triggers != adc_total_triggers) {
+      fprintf(stderr, "Error: Board %d DAC triggers (%u) != ADC triggers (%u)\n",
+              b, dac_total_triggers, adc_total_triggers);
+      fprintf(stderr, "  DAC: %u triggers/file × %d iterations = %u\n",
+              dac->triggers, bp->dac_iterations, dac_total_triggers);
+      fprintf(stderr, "  ADC: %u triggers/file × %d iterations = %u\n",
+              adc->triggers, bp->adc_iterations, adc_total_triggers);
+      return -1;
+    }
+
+    // Validate that all boards have the same trigger count
+    if (reference_board < 0) {
+      reference_board = b;
+      plan->total_triggers = dac_total_triggers;
+    } else if (plan->total_triggers != dac_total_triggers) {
+      fprintf(stderr, "Error: All boards must have the same total trigger count\n");
+      fprintf(stderr, "  Board %d: %u triggers\n", reference_board, plan->total_triggers);
+      fprintf(stderr, "  Board %d: %u triggers\n", b, dac_total_triggers);
+      return -1;
+    }
+
+    bp->triggers = dac_total_triggers;
+    bp->adc_data_words = adc->adc_data_words * (uint64_t)bp->adc_iterations;
+    if (bp->adc_data_words == 0) {
+      fprintf(stderr, "Board %d: ADC command file '%s' has no reads (D lines)\n", b, adc->path);
+      return -1;
+    }
+    uint64_t dac_cycles = dac->timed_cycles * (uint64_t)bp->dac_iterations;
+    uint64_t adc_cycles = adc->timed_cycles * (uint64_t)bp->adc_iterations;
+    bp->timed_cycles = dac_cycles > adc_cycles ? dac_cycles : adc_cycles;
+    if (bp->timed_cycles > max_timed_cycles) max_timed_cycles = bp->timed_cycles;
+    bp->adc_file_bytes = bp->adc_data_words *
+                         (binary_output ? sizeof(uint32_t) : EXPERIMENT_PLAN_ADC_ASCII_BYTES_PER_WORD);
+  }
+
+  // Sources left over from a previous plan that this one doesn't use
+  for (int i = 0; i < plan->source_count; i++) {
+    if (!plan->sources[i].in_use && plan->sources[i].path[0] != '\0') free_source(&plan->sources[i]);
+  }
+
+  memcpy(plan->boards, boards, sizeof(plan->boards));
+  plan->duration_cycles = max_timed_cycles + (uint64_t)plan->total_triggers * lockout_cycles;
+  plan->trig_file_bytes = (uint64_t)plan->total_triggers *
+                          (binary_output ? sizeof(uint64_t) : EXPERIMENT_PLAN_TRIG_ASCII_BYTES);
+  return 0;
+}
+
+// Human-readable byte count
+static void format_bytes(uint64_t bytes, char* buf, size_t size) {
+  if (bytes >= 1024ULL * 1024 * 1024) {
+    snprintf(buf, size, "%.2f GiB", bytes / (1024.0 * 1024 * 1024));
+  } else if (bytes >= 1024 * 1024) {
+    snprintf(buf, size, "%.2f MiB", bytes / (1024.0 * 1024));
+  } else if (bytes >= 1024) {
+    snprintf(buf, size, "%.1f KiB", bytes / 1024.0);
+  } else {
+    snprintf(buf, size, "%llu B", (unsigned long long)bytes);
+  }
+}
+
+void experiment_plan_print(const experiment_plan_t* plan, bool verbose) {
+  double cycle_s = 1.0 / (plan->spi_freq_mhz * 1e6);
+  double duration_s = plan->duration_cycles * cycle_s;
+  const char* size_note = plan->binary_output ? "" : " at most";
+  char size_str[32];
+
+  int in_use = 0;
+  for (int i = 0; i < plan->source_count; i++) {
+    if (plan->sources[i].in_use) in_use++;
+  }
+  printf("\nExperiment plan (%d file%s parsed, %d reused from the previous run):\n",
+         plan->parsed_files, plan->parsed_files == 1 ? "" : "s", in_use - plan->parsed_files);
+
+  for (int b = 0; b < 8; b++) {
+    if (!plan->boards[b]) continue;
+    const board_plan_t* bp = &plan->board[b];
+    const plan_source_t* dac = &plan->sources[bp->dac_source];
+    const plan_source_t* adc = &plan->sources[bp->adc_source];
+    format_bytes(bp->adc_file_bytes, size_str, sizeof(size_str));
+    printf("  Board %d: %u triggers, %llu ADC words (%s%s)\n", b, bp->triggers,
+           (unsigned long long)bp->adc_data_words, size_str, size_note);
+    printf("    DAC: %zu words/pass x %d, max %u words between triggers (FIFO %u)%s\n",
+           dac->word_count, bp->dac_iterations, dac->max_gap_words, DAC_CMD_FIFO_WORDCOUNT,
+           dac->max_gap_words > DAC_CMD_FIFO_WORDCOUNT ? " - may underflow unless delays are long" : "");
+    if (dac->preemph_board >= 0) {
+      preemph_print_report(&dac->preemph, stdout);
+    }
+    printf("    ADC: %zu words/pass x %d, max %u words between triggers (FIFO %u)%s\n",
+           adc->word_count, bp->adc_iterations, adc->max_gap_words, ADC_CMD_FIFO_WORDCOUNT,
+           adc->max_gap_words > ADC_CMD_FIFO_WORDCOUNT ? " - may underflow unless delays are long" : "");
+    if (verbose && duration_s > 0.0) {
+      double dac_rate = dac->word_count * (double)bp->dac_iterations / duration_s;
+      double adc_rate = adc->word_count * (double)bp->adc_iterations / duration_s;
+      double data_rate = bp->adc_data_words / duration_s;
+      printf("    Average feed: DAC %.0f words/s, ADC %.0f words/s; ADC data %.0f words/s\n",
+             dac_rate, adc_rate, data_rate);
+      printf("    Files: DAC '%s', ADC '%s'\n", dac->path, adc->path);
+    }
+  }
+
+  format_bytes(plan->trig_file_bytes, size_str, sizeof(size_str));
+  printf("  Triggers: %u total (%s%s)\n", plan->total_triggers, size_str, size_note);
+  printf("  Duration: at least %.3f s (%llu cycles timed, %u lockout cycles per trigger)\n",
+         duration_s, (unsigned long long)plan->duration_cycles, plan->lockout_cycles);
+}
+
+int experiment_plan_start_streams(const experiment_plan_t* plan, command_context_t* ctx) {
+  for (int b = 0; b < 8; b++) {
+    if (!plan->boards[b]) continue;
+    const board_plan_t* bp = &plan->board[b];
+    const plan_source_t* dac = &plan->sources[bp->dac_source];
+    const plan_source_t* adc = &plan->sources[bp->adc_source];
+
+    if (*(ctx->verbose)) {
+      printf("  Board %d: Starting DAC command streaming from '%s' (%d iterations)\n", b, dac->path, bp->dac_iterations);
+    }
+    int result = dac->packed
+      ? start_dac_packed_stream(ctx, (uint8_t)b, dac->path, &dac->pack, bp->dac_iterations,
+                                dac->preemph_board >= 0 ? &ctx->preemph : NULL, false)
+      : start_dac_cmd_stream(ctx, (uint8_t)b, dac->path, dac->dac_commands, dac->command_count,
+                             dac->words, dac->word_count, bp->dac_iterations, false);
+    if (result != 0) {
+      fprintf(stderr, "Failed to start DAC command streaming for board %d\n", b);
+      return -1;
+    }
+
+    if (*(ctx->verbose)) {
+      printf("  Board %d: Starting ADC command streaming from '%s' (%d iterations)\n", b, adc->path, bp->adc_iterations);
+    }
+    if (start_adc_cmd_stream(ctx, (uint8_t)b, adc->path, adc->adc_commands, adc->command_count,
+                             adc->words, adc->word_count, bp->adc_iterations, false, false) != 0) {
+      fprintf(stderr, "Failed to start ADC command streaming for board %d\n", b);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void experiment_plan_free(experiment_plan_t* plan) {
+  for (int i = 0; i < plan->source_count; i++) free_source(&plan->sources[i]);
+  plan->source_count = 0;
+  memset(plan->boards, 0, sizeof(plan->boards));
+}
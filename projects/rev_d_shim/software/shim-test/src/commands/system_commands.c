@@ -10,11 +10,16 @@
 #include <pthread.h>
 #include <glob.h>
 #include "system_commands.h"
+#include "map_memory.h"
 #include "command_helper.h"
 #include "experiment_commands.h"
+#include "dac_commands.h"
 #include "sys_sts.h"
 #include "sys_ctrl.h"
 #include "spi_clk_ctrl.h"
+#include "trigger_ctrl.h"
+#include "hw_backend.h"
+#include "hw_trace.h"
 
 // Basic system commands
 int cmd_verbose(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
@@ -26,11 +31,35 @@ int cmd_verbose(const char** args, int arg_count, const command_flag_t* flags, i
 int cmd_on(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   printf("Turning the system on...\n");
   sys_ctrl_turn_on(ctx->sys_ctrl, *(ctx->verbose));
+
+  // The trigger core comes out of reset logging full timestamps
+  trigger_reset_decoder(ctx->trigger_ctrl, false);
+  // The ADC cores come out of reset with framing off
+  for (int board = 0; board < 8; board++) ctx->adc_ctrl->frame_len[board] = 0;
+
+  // Watch for the hardware halting so the flight recorder can be dumped (real hardware only)
+  if (g_hw_trace_enabled && g_hw_backend == NULL) {
+    sys_sts_start_hw_manager_irq_monitor(ctx->sys_sts, *(ctx->verbose));
+  }
   
   // Wait a bit and check status
   usleep(100000); // 100ms
   uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, *(ctx->verbose));
   print_hw_status(hw_status, *(ctx->verbose));
+
+  // The DAC cores come up with zero offsets: restore the remembered ones
+  bool have_dac_cal = false;
+  for (int ch = 0; ch < 64; ch++) {
+    have_dac_cal |= ctx->dac_cal_valid[ch];
+  }
+  if (have_dac_cal && HW_STS_STATE(hw_status) == S_RUNNING) {
+    int pushed = push_dac_cal(ctx);
+    if (pushed < 0) {
+      fprintf(stderr, "Failed to restore DAC calibration; run channel_cal or load_cal.\n");
+    } else {
+      printf("Restored DAC calibration for %d channel(s).\n", pushed);
+    }
+  }
   return 0;
 }
 
@@ -240,6 +269,58 @@ int cmd_spi_clk_freq(const char** args, int arg_count, const command_flag_t* fla
   return 0;
 }
 
+int cmd_mem_map(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  printf("Memory map registry:\n");
+  map_memory_print_registry();
+  return 0;
+}
+
+int cmd_hw_trace(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  if (strcmp(args[0], "on") == 0) {
+    uint32_t entries = 0;
+    if (arg_count > 1) {
+      char* endptr;
+      entries = parse_value(args[1], &endptr);
+      if (*endptr != '\0' || entries == 0) {
+        fprintf(stderr, "Invalid ring size for hw_trace: '%s'. Must be a positive number of entries.\n", args[1]);
+        return -1;
+      }
+    }
+    hw_trace_enable(entries);
+    // Dump automatically if the hardware halts while it's running
+    if (g_hw_backend == NULL && HW_STS_STATE(sys_sts_get_hw_status(ctx->sys_sts, *(ctx->verbose))) == S_RUNNING) {
+      sys_sts_start_hw_manager_irq_monitor(ctx->sys_sts, *(ctx->verbose));
+    }
+    hw_trace_print_status();
+  } else if (strcmp(args[0], "off") == 0) {
+    hw_trace_disable();
+    printf("Hardware trace stopped (recorded accesses are kept until cleared).\n");
+  } else if (strcmp(args[0], "clear") == 0) {
+    hw_trace_clear();
+    printf("Hardware trace cleared.\n");
+  } else if (strcmp(args[0], "status") == 0) {
+    hw_trace_print_status();
+  } else if (strcmp(args[0], "dump") == 0) {
+    if (arg_count < 2) {
+      size_t entries = hw_trace_dump(stdout);
+      printf("Dumped %zu accesses.\n", entries);
+      return 0;
+    }
+    char full_path[1024];
+    clean_and_expand_path(args[1], full_path, sizeof(full_path));
+    long entries = hw_trace_dump_to_file(full_path);
+    if (entries < 0) {
+      fprintf(stderr, "Failed to open '%s' for the hardware trace: %s\n", full_path, strerror(errno));
+      return -1;
+    }
+    printf("Hardware trace (%ld accesses) written to '%s'.\n", entries, full_path);
+  } else {
+    fprintf(stderr, "Unknown hw_trace action: '%s'. Use on, off, clear, status or dump.\n", args[0]);
+    return -1;
+  }
+  return 0;
+}
+
 // Integrator configuration commands
 int cmd_set_integ_window(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   char* endptr;
@@ -89,6 +89,37 @@ int cmd_trig_reset_count(const char** args, int arg_count, const command_flag_t*
   return 0;
 }
 
+int cmd_trig_log_format(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  if (arg_count == 0) {
+    printf("Trigger data format: %s\n", ctx->trigger_ctrl->delta_log ? "delta" : "full");
+    return 0;
+  }
+
+  bool delta_log;
+  if (strcmp(args[0], "delta") == 0) {
+    delta_log = true;
+  } else if (strcmp(args[0], "full") == 0) {
+    delta_log = false;
+  } else {
+    fprintf(stderr, "Invalid format for trig_log_format: '%s'. Must be 'full' or 'delta'.\n", args[0]);
+    return -1;
+  }
+
+  // Entries already in the FIFO would be decoded in the wrong format
+  if (ctx->trig_data_stream_running) {
+    fprintf(stderr, "Cannot change the trigger data format while a trigger data stream is running.\n");
+    return -1;
+  }
+  if (!FIFO_STS_EMPTY(sys_sts_get_trig_data_fifo_status(ctx->sys_sts, *(ctx->verbose)))) {
+    fprintf(stderr, "Trigger data FIFO is not empty. Read out the remaining data before changing the format.\n");
+    return -1;
+  }
+
+  trigger_cmd_set_log_format(ctx->trigger_ctrl, delta_log, *(ctx->verbose));
+  printf("Trigger data format set to %s (trigger count and timer reset).\n", delta_log ? "delta" : "full");
+  return 0;
+}
+
 int cmd_trig_count(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   uint32_t count = sys_sts_get_trig_counter(ctx->sys_sts, *(ctx->verbose));
   printf("Current trigger count: %u (0x%08X)\n", count, count);
@@ -162,14 +193,14 @@ static void* trigger_data_stream_thread(void* arg) {
   bool verbose = *(ctx->verbose);
 
   if (verbose) {
-    printf("Trigger Stream Thread: Starting to write %llu samples to file '%s' (%s format)\n", 
+    fprintf(ctx->console_out, "Trigger Stream Thread: Starting to write %llu samples to file '%s' (%s format)\n", 
            sample_count, file_path, binary_mode ? "binary" : "ASCII");
   }
 
   // Open file for writing (binary or text mode based on format)
   FILE* file = fopen(file_path, binary_mode ? "wb" : "w");
   if (file == NULL) {
-    fprintf(stderr, "Trigger Stream Thread: Failed to open file '%s' for writing: %s\n", 
+    fprintf(ctx->console_err, "Trigger Stream Thread: Failed to open file '%s' for writing: %s\n", 
            file_path, strerror(errno));
     goto cleanup;
   }
@@ -181,22 +212,21 @@ static void* trigger_data_stream_thread(void* arg) {
     uint32_t data_status = sys_sts_get_trig_data_fifo_status(ctx->sys_sts, false);
 
     if (FIFO_PRESENT(data_status) == 0) {
-      fprintf(stderr, "Trigger Stream Thread: Data FIFO not present, stopping stream\n");
+      fprintf(ctx->console_err, "Trigger Stream Thread: Data FIFO not present, stopping stream\n");
       break;
     }
 
-    // Check if there are at least 2 words available for a sample
+    // Decode the next sample from the available words (one or two, depending on the format)
     uint32_t fifo_count = FIFO_STS_WORD_COUNT(data_status);
-    if (fifo_count >= 2) {
-      // Read 64-bit trigger data (2 words)
-      uint64_t trigger_data = trigger_read(ctx->trigger_ctrl);
+    uint64_t trigger_data;
+    if (fifo_count > 0 && trigger_read_timestamps(ctx->trigger_ctrl, &trigger_data, 1, fifo_count) == 1) {
 
       // Write data based on format mode
       if (binary_mode) {
         // Binary mode: write raw 64-bit value directly
         size_t written = fwrite(&trigger_data, sizeof(uint64_t), 1, file);
         if (written != 1) {
-          fprintf(stderr, "Trigger Stream Thread: Failed to write to file: %s\n", strerror(errno));
+          fprintf(ctx->console_err, "Trigger Stream Thread: Failed to write to file: %s\n", strerror(errno));
           break;
         }
       } else {
@@ -210,7 +240,7 @@ static void* trigger_data_stream_thread(void* arg) {
       samples_written++;
 
       if (verbose && samples_written % 1000 == 0) {
-        printf("Trigger Stream Thread: Written %llu/%llu samples (%.1f%%)\n",
+        fprintf(ctx->console_out, "Trigger Stream Thread: Written %llu/%llu samples (%.1f%%)\n",
                samples_written, sample_count,
                (double)samples_written / sample_count * 100.0);
       }
@@ -225,10 +255,10 @@ static void* trigger_data_stream_thread(void* arg) {
   }
 
   if (*should_stop) {
-    printf("Trigger Stream Thread: Stream stopped by user after writing %llu samples\n",
+    fprintf(ctx->console_out, "Trigger Stream Thread: Stream stopped by user after writing %llu samples\n",
            samples_written);
   } else {
-    printf("Trigger Stream Thread: Stream completed, wrote %llu samples to file '%s'\n",
+    fprintf(ctx->console_out, "Trigger Stream Thread: Stream completed, wrote %llu samples to file '%s'\n",
            samples_written, file_path);
   }
 
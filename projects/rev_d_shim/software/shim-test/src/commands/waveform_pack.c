@@ -0,0 +1,389 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "waveform_pack.h"
+#include "dac_ctrl.h"
+
+// Op byte: op in bits 7:6, CMD flags below
+#define PACK_OP_SHIFT         6
+#define PACK_OP_CMD           0u
+#define PACK_OP_REPEAT        1u
+#define PACK_FLAG_TRIGGER     (1u << 0)
+#define PACK_FLAG_HAS_VALS    (1u << 1)
+#define PACK_FLAG_VALUE_SAME  (1u << 2)
+#define PACK_FLAG_VALS_SAME   (1u << 3)
+
+#define PACK_HISTORY_MASK     (WAVEFORM_PACK_MAX_DISTANCE - 1)
+#define PACK_HASH_BITS        16
+
+_Static_assert((WAVEFORM_PACK_MAX_DISTANCE & PACK_HISTORY_MASK) == 0, "WAVEFORM_PACK_MAX_DISTANCE must be a power of two");
+
+// File header, followed by data_size bytes of encoded commands
+typedef struct {
+  uint32_t magic;                // WAVEFORM_PACK_MAGIC
+  uint16_t version;              // WAVEFORM_PACK_VERSION
+  uint16_t header_size;          // sizeof(pack_header_t)
+  uint32_t spi_clk_freq_hz;
+  uint32_t triggers;
+  uint64_t command_count;
+  uint64_t word_count;
+  uint64_t timed_cycles;
+  uint32_t max_gap_words;
+  uint32_t reserved;
+  uint64_t data_size;
+} pack_header_t;
+
+_Static_assert(sizeof(pack_header_t) == 56, "pack_header_t layout changed: bump WAVEFORM_PACK_VERSION");
+
+// Growable output buffer
+typedef struct {
+  uint8_t* data;
+  size_t size;
+  size_t capacity;
+} pack_buf_t;
+
+static int buf_reserve(pack_buf_t* buf, size_t extra) {
+  if (buf->size + extra <= buf->capacity) return 0;
+  size_t capacity = buf->capacity ? buf->capacity : 4096;
+  while (capacity < buf->size + extra) capacity *= 2;
+  uint8_t* data = realloc(buf->data, capacity);
+  if (data == NULL) return -1;
+  buf->data = data;
+  buf->capacity = capacity;
+  return 0;
+}
+
+static void put_varint(pack_buf_t* buf, uint64_t value) {
+  while (value >= 0x80) {
+    buf->data[buf->size++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  buf->data[buf->size++] = (uint8_t)value;
+}
+
+static int get_varint(const waveform_pack_t* pack, size_t* pos, uint64_t* value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (*pos >= pack->size) return -1;
+    uint8_t byte = pack->data[(*pos)++];
+    result |= (uint64_t)(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+static uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static bool commands_equal(const waveform_command_t* a, const waveform_command_t* b) {
+  if (a->is_trigger != b->is_trigger || a->value != b->value || a->has_ch_vals != b->has_ch_vals) return false;
+  return !a->has_ch_vals || memcmp(a->ch_vals, b->ch_vals, sizeof(a->ch_vals)) == 0;
+}
+
+static uint32_t command_hash(const waveform_command_t* cmd) {
+  uint32_t hash = 2166136261u; // FNV-1a over the fields commands_equal compares
+  hash = (hash ^ (cmd->is_trigger ? 1u : 0u) ^ (cmd->has_ch_vals ? 2u : 0u)) * 16777619u;
+  hash = (hash ^ cmd->value) * 16777619u;
+  if (cmd->has_ch_vals) {
+    for (int ch = 0; ch < 8; ch++) hash = (hash ^ (uint16_t)cmd->ch_vals[ch]) * 16777619u;
+  }
+  return hash >> (32 - PACK_HASH_BITS);
+}
+
+// Commands matching the ones distance back, starting at i
+static int match_length(const waveform_command_t* commands, int command_count, int i, int distance) {
+  int length = 0;
+  while (i + length < command_count && commands_equal(&commands[i + length], &commands[i + length - distance])) {
+    length++;
+  }
+  return length;
+}
+
+// Pack parsed commands
+int waveform_pack_commands(const waveform_command_t* commands, int command_count, uint32_t spi_clk_freq_hz,
+                           waveform_pack_t* pack) {
+  memset(pack, 0, sizeof(*pack));
+  // REPEAT ops already cover repeated blocks; hardware loops stay in plain text files
+  for (int i = 0; i < command_count; i++) {
+    if (commands[i].loop_commands > 0) {
+      fprintf(stderr, "Waveforms with loops (L/E) can't be packed\n");
+      return -1;
+    }
+  }
+  int* last_seen = malloc(sizeof(int) << PACK_HASH_BITS);
+  if (last_seen == NULL) {
+    fprintf(stderr, "Failed to allocate waveform packing table\n");
+    return -1;
+  }
+  for (int i = 0; i < (1 << PACK_HASH_BITS); i++) last_seen[i] = -1;
+
+  pack_buf_t buf = {0};
+  int16_t prev_vals[8] = {0};
+  uint32_t prev_value = 0;
+  int last_distance = 0;
+  uint32_t gap = 0;
+  int i = 0;
+  while (i < command_count) {
+    if (buf_reserve(&buf, 32) != 0) {
+      fprintf(stderr, "Failed to allocate packed waveform buffer\n");
+      free(buf.data);
+      free(last_seen);
+      return -1;
+    }
+
+    // Replay from the last occurrence of this command, or at the last block distance
+    int best_distance = 0, best_length = 0;
+    int seen = last_seen[command_hash(&commands[i])];
+    int candidates[2] = {seen >= 0 ? i - seen : 0, last_distance};
+    for (int c = 0; c < 2; c++) {
+      int distance = candidates[c];
+      if (distance <= 0 || distance > WAVEFORM_PACK_MAX_DISTANCE || distance > i) continue;
+      int length = match_length(commands, command_count, i, distance);
+      if (length > best_length) {
+        best_length = length;
+        best_distance = distance;
+      }
+    }
+
+    int consumed;
+    if (best_length >= WAVEFORM_PACK_MIN_REPEAT) {
+      buf.data[buf.size++] = (uint8_t)(PACK_OP_REPEAT << PACK_OP_SHIFT);
+      put_varint(&buf, (uint64_t)best_distance);
+      put_varint(&buf, (uint64_t)best_length);
+      last_distance = best_distance;
+      consumed = best_length;
+    } else {
+      const waveform_command_t* cmd = &commands[i];
+      uint8_t tag = (uint8_t)(PACK_OP_CMD << PACK_OP_SHIFT);
+      if (cmd->is_trigger) tag |= PACK_FLAG_TRIGGER;
+      if (cmd->value == prev_value) tag |= PACK_FLAG_VALUE_SAME;
+      if (cmd->has_ch_vals) {
+        tag |= PACK_FLAG_HAS_VALS;
+        if (memcmp(cmd->ch_vals, prev_vals, sizeof(prev_vals)) == 0) tag |= PACK_FLAG_VALS_SAME;
+      }
+      buf.data[buf.size++] = tag;
+      if (!(tag & PACK_FLAG_VALUE_SAME)) put_varint(&buf, cmd->value);
+      if (cmd->has_ch_vals && !(tag & PACK_FLAG_VALS_SAME)) {
+        for (int ch = 0; ch < 8; ch++) {
+          put_varint(&buf, zigzag((int32_t)cmd->ch_vals[ch] - prev_vals[ch]));
+        }
+      }
+      consumed = 1;
+    }
+
+    // Track decoder state and per-pass counts over the commands just covered
+    for (int k = i; k < i + consumed; k++) {
+      const waveform_command_t* cmd = &commands[k];
+      last_seen[command_hash(cmd)] = k;
+      prev_value = cmd->value;
+      if (cmd->has_ch_vals) memcpy(prev_vals, cmd->ch_vals, sizeof(prev_vals));
+      uint32_t words = cmd->has_ch_vals ? DAC_WR_WORDCOUNT : 1;
+      pack->word_count += words;
+      if (cmd->is_trigger) {
+        pack->triggers += cmd->value > 0 ? cmd->value : 1;
+        if (gap > pack->max_gap_words) pack->max_gap_words = gap;
+        gap = words;
+      } else {
+        pack->timed_cycles += cmd->value;
+        gap += words;
+      }
+    }
+    i += consumed;
+  }
+  if (gap > pack->max_gap_words) pack->max_gap_words = gap;
+  free(last_seen);
+
+  pack->spi_clk_freq_hz = spi_clk_freq_hz;
+  pack->command_count = (uint64_t)command_count;
+  pack->data = buf.data;
+  pack->size = buf.size;
+  return 0;
+}
+
+// Save a packed waveform
+int waveform_pack_save(const waveform_pack_t* pack, const char* path) {
+  pack_header_t header = {
+    .magic = WAVEFORM_PACK_MAGIC,
+    .version = WAVEFORM_PACK_VERSION,
+    .header_size = sizeof(pack_header_t),
+    .spi_clk_freq_hz = pack->spi_clk_freq_hz,
+    .triggers = pack->triggers,
+    .command_count = pack->command_count,
+    .word_count = pack->word_count,
+    .timed_cycles = pack->timed_cycles,
+    .max_gap_words = pack->max_gap_words,
+    .reserved = 0,
+    .data_size = pack->size
+  };
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to create packed waveform '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            (pack->size == 0 || fwrite(pack->data, pack->size, 1, file) == 1);
+  ok = (fclose(file) == 0) && ok;
+  if (!ok) {
+    fprintf(stderr, "Failed to write packed waveform '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+// Whether a file starts with the packed waveform magic
+bool waveform_pack_is_packed(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) return false;
+  uint32_t magic = 0;
+  bool packed = fread(&magic, sizeof(magic), 1, file) == 1 && magic == WAVEFORM_PACK_MAGIC;
+  fclose(file);
+  return packed;
+}
+
+// Load a packed waveform
+int waveform_pack_load(const char* path, waveform_pack_t* pack) {
+  memset(pack, 0, sizeof(*pack));
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open waveform file '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+  pack_header_t header;
+  if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != WAVEFORM_PACK_MAGIC) {
+    fclose(file);
+    return 1;
+  }
+  if (header.version != WAVEFORM_PACK_VERSION || header.header_size != sizeof(pack_header_t)) {
+    fprintf(stderr, "Packed waveform '%s' has an unsupported version (%u)\n", path, header.version);
+    fclose(file);
+    return -1;
+  }
+  if (header.command_count == 0 || header.command_count > (uint64_t)INT32_MAX) {
+    fprintf(stderr, "Packed waveform '%s' has an invalid command count (%llu)\n", path,
+            (unsigned long long)header.command_count);
+    fclose(file);
+    return -1;
+  }
+  pack->data = malloc(header.data_size > 0 ? header.data_size : 1);
+  if (pack->data == NULL) {
+    fprintf(stderr, "Failed to allocate %llu bytes for packed waveform '%s'\n", (unsigned long long)header.data_size, path);
+    fclose(file);
+    return -1;
+  }
+  bool ok = header.data_size == 0 || fread(pack->data, header.data_size, 1, file) == 1;
+  ok = ok && fgetc(file) == EOF;
+  fclose(file);
+  if (!ok) {
+    fprintf(stderr, "Packed waveform '%s' is truncated or has trailing data\n", path);
+    waveform_pack_free(pack);
+    return -1;
+  }
+  pack->size = header.data_size;
+  pack->spi_clk_freq_hz = header.spi_clk_freq_hz;
+  pack->command_count = header.command_count;
+  pack->word_count = header.word_count;
+  pack->timed_cycles = header.timed_cycles;
+  pack->triggers = header.triggers;
+  pack->max_gap_words = header.max_gap_words;
+  return 0;
+}
+
+void waveform_pack_free(waveform_pack_t* pack) {
+  free(pack->data);
+  memset(pack, 0, sizeof(*pack));
+}
+
+// Start a pass
+int waveform_unpacker_init(waveform_unpacker_t* unpacker, const waveform_pack_t* pack) {
+  memset(unpacker, 0, sizeof(*unpacker));
+  unpacker->history = malloc(WAVEFORM_PACK_MAX_DISTANCE * sizeof(waveform_command_t));
+  if (unpacker->history == NULL) {
+    fprintf(stderr, "Failed to allocate waveform decoder history\n");
+    return -1;
+  }
+  unpacker->pack = pack;
+  return 0;
+}
+
+// Rewind to the start of the pass
+void waveform_unpacker_rewind(waveform_unpacker_t* unpacker) {
+  unpacker->pos = 0;
+  unpacker->decoded = 0;
+  unpacker->repeat_left = 0;
+  memset(unpacker->prev_vals, 0, sizeof(unpacker->prev_vals));
+}
+
+// Decode the next command
+int waveform_unpacker_next(waveform_unpacker_t* unpacker, waveform_command_t* cmd) {
+  const waveform_pack_t* pack = unpacker->pack;
+  if (unpacker->decoded >= pack->command_count) {
+    return (unpacker->pos == pack->size && unpacker->repeat_left == 0) ? 0 : -1;
+  }
+
+  if (unpacker->repeat_left == 0) {
+    if (unpacker->pos >= pack->size) return -1;
+    uint8_t tag = pack->data[unpacker->pos++];
+    uint32_t op = tag >> PACK_OP_SHIFT;
+    if (op == PACK_OP_REPEAT) {
+      uint64_t distance, count;
+      if (get_varint(pack, &unpacker->pos, &distance) != 0 || get_varint(pack, &unpacker->pos, &count) != 0) return -1;
+      if (distance == 0 || distance > WAVEFORM_PACK_MAX_DISTANCE || distance > unpacker->decoded ||
+          count == 0 || count > pack->command_count - unpacker->decoded) return -1;
+      unpacker->repeat_distance = (uint32_t)distance;
+      unpacker->repeat_left = count;
+    } else if (op == PACK_OP_CMD) {
+      uint32_t prev_value = unpacker->decoded > 0 ? unpacker->history[(unpacker->decoded - 1) & PACK_HISTORY_MASK].value : 0;
+      cmd->is_trigger = (tag & PACK_FLAG_TRIGGER) != 0;
+      cmd->has_ch_vals = (tag & PACK_FLAG_HAS_VALS) != 0;
+      if (tag & PACK_FLAG_VALUE_SAME) {
+        cmd->value = prev_value;
+      } else {
+        uint64_t value;
+        if (get_varint(pack, &unpacker->pos, &value) != 0 || value > SPI_TIMING_MAX_DELAY_CYCLES) return -1;
+        cmd->value = (uint32_t)value;
+      }
+      if (cmd->has_ch_vals) {
+        if (tag & PACK_FLAG_VALS_SAME) {
+          memcpy(cmd->ch_vals, unpacker->prev_vals, sizeof(cmd->ch_vals));
+        } else {
+          for (int ch = 0; ch < 8; ch++) {
+            uint64_t delta;
+            if (get_varint(pack, &unpacker->pos, &delta) != 0 || delta > UINT32_MAX) return -1;
+            int32_t value = unpacker->prev_vals[ch] + unzigzag((uint32_t)delta);
+            if (value < -32767 || value > 32767) return -1;
+            cmd->ch_vals[ch] = (int16_t)value;
+          }
+        }
+      }
+      goto store;
+    } else {
+      return -1;
+    }
+  }
+
+  *cmd = unpacker->history[(unpacker->decoded - unpacker->repeat_distance) & PACK_HISTORY_MASK];
+  unpacker->repeat_left--;
+
+store:
+  cmd->cont = true;
+  cmd->loop_commands = 0;
+  cmd->loop_passes = 0;
+  if (cmd->has_ch_vals) memcpy(unpacker->prev_vals, cmd->ch_vals, sizeof(unpacker->prev_vals));
+  unpacker->history[unpacker->decoded & PACK_HISTORY_MASK] = *cmd;
+  unpacker->decoded++;
+  return 1;
+}
+
+void waveform_unpacker_free(waveform_unpacker_t* unpacker) {
+  free(unpacker->history);
+  unpacker->history = NULL;
+}
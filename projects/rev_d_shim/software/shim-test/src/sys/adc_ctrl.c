@@ -3,6 +3,7 @@
 #include <string.h>
 #include "adc_ctrl.h"
 #include "map_memory.h"
+#include "hw_backend.h"
 
 // Create ADC control structure for a single board
 struct adc_ctrl_t create_adc_ctrl(bool verbose) {
@@ -15,6 +16,7 @@ struct adc_ctrl_t create_adc_ctrl(bool verbose) {
       fprintf(stderr, "Failed to map ADC FIFO access for board %d\n", board);
       exit(EXIT_FAILURE);
     }
+    adc_ctrl.frame_len[board] = 0;
   }
 
   return adc_ctrl;
@@ -35,7 +37,7 @@ uint32_t adc_read_word(struct adc_ctrl_t *adc_ctrl, uint8_t board) {
   
   // Use volatile access to prevent compiler optimization and ensure actual memory read
   volatile uint32_t *buffer_ptr = adc_ctrl->buffer[board];
-  uint32_t value = *buffer_ptr;
+  uint32_t value = hw_read32(buffer_ptr);
   
   return value;
 }
@@ -197,6 +199,18 @@ char* adc_format_command(uint8_t cmd_code, bool verbose) {
       strcat(buffer, "ADC_RD_CH");
       break;
     }
+    case ADC_CMD_SET_AVG: {
+      strcat(buffer, "SET_AVG");
+      break;
+    }
+    case ADC_CMD_SET_FRAME: {
+      strcat(buffer, "SET_FRAME");
+      break;
+    }
+    case ADC_CMD_LOOP: {
+      strcat(buffer, "LOOP");
+      break;
+    }
     case ADC_CMD_CANCEL: {
       strcat(buffer, "CANCEL");
       break;
@@ -222,18 +236,15 @@ void adc_cmd_noop(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool trig, bool co
     fprintf(stderr, "Invalid command value: %u. Must be 0 to 33554431 (25-bit value).\n", value);
     return;
   }
-  uint32_t cmd_word = (ADC_CMD_NO_OP  << ADC_CMD_CMD_LSB ) |
-                      ((trig ? 1 : 0) << ADC_CMD_TRIG_BIT) |
-                      ((cont ? 1 : 0) << ADC_CMD_CONT_BIT) |
-                      (value & 0x1FFFFFF);
+  uint32_t cmd_word = adc_encode_cmd(ADC_CMD_NO_OP, trig, cont, value);
   
   if (verbose) {
     printf("ADC[%d] NO_OP command word: 0x%08X\n", board, cmd_word);
   }
-  *(adc_ctrl->buffer[board]) = cmd_word;
+  hw_write32(adc_ctrl->buffer[board], cmd_word);
 }
 
-void adc_cmd_adc_rd(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool trig, bool cont, uint32_t value, uint32_t repeat_count, bool verbose) {
+void adc_cmd_adc_rd(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool trig, bool cont, uint32_t value, uint32_t repeat_count, uint8_t avg_log2, bool verbose) {
   if (board > 7) {
     fprintf(stderr, "Invalid ADC board: %d. Must be 0-7.\n", board);
     return;
@@ -242,23 +253,27 @@ void adc_cmd_adc_rd(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool trig, bool
     fprintf(stderr, "Invalid command value: %u. Must be 0 to 33554431 (25-bit value).\n", value);
     return;
   }
-  uint32_t cmd_word = (ADC_CMD_ADC_RD << ADC_CMD_CMD_LSB ) |
-                      ((trig ? 1 : 0) << ADC_CMD_TRIG_BIT) |
-                      ((cont ? 1 : 0) << ADC_CMD_CONT_BIT) |
-                      (((repeat_count > 0) ? 1 : 0) << ADC_CMD_REPEAT_BIT) |
-                      (value & 0x1FFFFFF);
+  if (avg_log2 > ADC_AVG_LOG2_MAX) {
+    fprintf(stderr, "Invalid ADC averaging: 2^%d reads. Must be 2^0 to 2^%d.\n", avg_log2, ADC_AVG_LOG2_MAX);
+    return;
+  }
+  // Averaged reads are wrapped in SET_AVG words, restoring single reads after the last repeat
+  uint32_t words[4];
+  size_t count = 0;
+  if (avg_log2 > 0) words[count++] = adc_encode_set_avg(avg_log2);
+  count += adc_encode_adc_rd(&words[count], trig, cont, value, repeat_count);
+  if (avg_log2 > 0) words[count++] = adc_encode_set_avg(0);
   
   if (verbose) {
-    printf("ADC[%d] ADC_RD command word: 0x%08X\n", board, cmd_word);
-  }
-  *(adc_ctrl->buffer[board]) = cmd_word;
-
-  if (repeat_count > 0) {
-    if (verbose) {
+    if (avg_log2 > 0) {
+      printf("ADC[%d] SET_AVG command word: 0x%08X (%u reads per channel)\n", board, words[0], 1u << avg_log2);
+    }
+    printf("ADC[%d] ADC_RD command word: 0x%08X\n", board, words[avg_log2 > 0 ? 1 : 0]);
+    if (repeat_count > 0) {
       printf("ADC[%d] REPEAT count: 0x%08X (repeat count: %u)\n", board, repeat_count, repeat_count);
     }
-    *(adc_ctrl->buffer[board]) = repeat_count;
   }
+  adc_write_cmd_words(adc_ctrl, board, words, count);
 }
 
 void adc_cmd_adc_rd_ch(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint8_t ch, uint32_t repeat_count, bool verbose) {
@@ -278,13 +293,13 @@ void adc_cmd_adc_rd_ch(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint8_t ch, u
   if (verbose) {
     printf("ADC[%d] ADC_RD_CH command word: 0x%08X (channel: %d)\n", board, cmd_word, ch);
   }
-  *(adc_ctrl->buffer[board]) = cmd_word;
+  hw_write32(adc_ctrl->buffer[board], cmd_word);
 
   if (repeat_count > 0) {
     if (verbose) {
       printf("ADC[%d] REPEAT count: 0x%08X (repeat count: %u)\n", board, repeat_count, repeat_count);
     }
-    *(adc_ctrl->buffer[board]) = repeat_count;
+    hw_write32(adc_ctrl->buffer[board], repeat_count);
   }
 }
 
@@ -301,22 +316,51 @@ void adc_cmd_set_ord(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint8_t channel
     }
   }
 
-  uint32_t cmd_word = (ADC_CMD_SET_ORD << ADC_CMD_CMD_LSB) |
-                      ((channel_order[7] & 0x7) << 21    ) |
-                      ((channel_order[6] & 0x7) << 18    ) |
-                      ((channel_order[5] & 0x7) << 15    ) |
-                      ((channel_order[4] & 0x7) << 12    ) |
-                      ((channel_order[3] & 0x7) <<  9    ) |
-                      ((channel_order[2] & 0x7) <<  6    ) |
-                      ((channel_order[1] & 0x7) <<  3    ) |
-                      ((channel_order[0] & 0x7) <<  0    );
+  uint32_t cmd_word = adc_encode_set_ord(channel_order);
 
   if (verbose) {
     printf("ADC[%d] SET_ORD command word: 0x%08X (order: [%d,%d,%d,%d,%d,%d,%d,%d])\n", 
            board, cmd_word, channel_order[0], channel_order[1], channel_order[2], channel_order[3],
            channel_order[4], channel_order[5], channel_order[6], channel_order[7]);
   }
-  *(adc_ctrl->buffer[board]) = cmd_word;
+  hw_write32(adc_ctrl->buffer[board], cmd_word);
+}
+
+void adc_cmd_set_avg(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint8_t avg_log2, bool verbose) {
+  if (board > 7) {
+    fprintf(stderr, "Invalid ADC board: %d. Must be 0-7.\n", board);
+    return;
+  }
+  if (avg_log2 > ADC_AVG_LOG2_MAX) {
+    fprintf(stderr, "Invalid ADC averaging: 2^%d reads. Must be 2^0 to 2^%d.\n", avg_log2, ADC_AVG_LOG2_MAX);
+    return;
+  }
+
+  uint32_t cmd_word = adc_encode_set_avg(avg_log2);
+
+  if (verbose) {
+    printf("ADC[%d] SET_AVG command word: 0x%08X (%u reads per channel)\n", board, cmd_word, 1u << avg_log2);
+  }
+  hw_write32(adc_ctrl->buffer[board], cmd_word);
+}
+
+void adc_cmd_set_frame(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint16_t frame_len, bool verbose) {
+  if (board > 7) {
+    fprintf(stderr, "Invalid ADC board: %d. Must be 0-7.\n", board);
+    return;
+  }
+  if (frame_len > ADC_FRAME_LEN_MAX) {
+    fprintf(stderr, "Invalid ADC frame length: %u words. Must be 0 to %d.\n", frame_len, ADC_FRAME_LEN_MAX);
+    return;
+  }
+
+  uint32_t cmd_word = adc_encode_set_frame(frame_len);
+
+  if (verbose) {
+    printf("ADC[%d] SET_FRAME command word: 0x%08X (%u data words per frame)\n", board, cmd_word, frame_len);
+  }
+  hw_write32(adc_ctrl->buffer[board], cmd_word);
+  adc_ctrl->frame_len[board] = frame_len;
 }
 
 void adc_cmd_cancel(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool verbose) {
@@ -330,7 +374,7 @@ void adc_cmd_cancel(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool verbose) {
   if (verbose) {
     printf("ADC[%d] CANCEL command word: 0x%08X\n", board, cmd_word);
   }
-  *(adc_ctrl->buffer[board]) = cmd_word;
+  hw_write32(adc_ctrl->buffer[board], cmd_word);
 }
 
 // Convert and format a single ADC sample from a 32-bit word (low 16 bits)
@@ -374,3 +418,64 @@ char* adc_format_pair(uint32_t data_word, bool verbose) {
   
   return buffer;
 }
+
+// Command stream functions
+uint32_t adc_encode_cmd(uint8_t cmd, bool trig, bool cont, uint32_t value) {
+  return ((uint32_t)cmd   << ADC_CMD_CMD_LSB ) |
+         ((trig ? 1 : 0) << ADC_CMD_TRIG_BIT) |
+         ((cont ? 1 : 0) << ADC_CMD_CONT_BIT) |
+         (value & 0x1FFFFFF);
+}
+
+size_t adc_encode_adc_rd(uint32_t words[2], bool trig, bool cont, uint32_t value, uint32_t repeat_count) {
+  words[0] = adc_encode_cmd(ADC_CMD_ADC_RD, trig, cont, value) |
+             (((repeat_count > 0) ? 1 : 0) << ADC_CMD_REPEAT_BIT);
+  if (repeat_count == 0) return 1;
+  words[1] = repeat_count;
+  return 2;
+}
+
+uint32_t adc_encode_set_ord(const uint8_t channel_order[8]) {
+  return (ADC_CMD_SET_ORD << ADC_CMD_CMD_LSB) |
+         ((channel_order[7] & 0x7) << 21    ) |
+         ((channel_order[6] & 0x7) << 18    ) |
+         ((channel_order[5] & 0x7) << 15    ) |
+         ((channel_order[4] & 0x7) << 12    ) |
+         ((channel_order[3] & 0x7) <<  9    ) |
+         ((channel_order[2] & 0x7) <<  6    ) |
+         ((channel_order[1] & 0x7) <<  3    ) |
+         ((channel_order[0] & 0x7) <<  0    );
+}
+
+uint32_t adc_encode_set_avg(uint8_t avg_log2) {
+  return ((uint32_t)ADC_CMD_SET_AVG << ADC_CMD_CMD_LSB) | (avg_log2 & 0xF);
+}
+
+uint32_t adc_encode_set_frame(uint16_t frame_len) {
+  return ((uint32_t)ADC_CMD_SET_FRAME << ADC_CMD_CMD_LSB) | frame_len;
+}
+
+uint32_t adc_encode_loop(uint32_t block_words, uint32_t passes) {
+  return ((uint32_t)ADC_CMD_LOOP << ADC_CMD_CMD_LSB) |
+         ((block_words & ADC_LOOP_LEN_MAX) << ADC_LOOP_LEN_LSB) |
+         (passes & ADC_LOOP_PASSES_MAX);
+}
+
+void adc_write_cmd_words(struct adc_ctrl_t *adc_ctrl, uint8_t board, const uint32_t *words, size_t count) {
+  if (board > 7) {
+    fprintf(stderr, "Invalid ADC board: %d. Must be 0-7.\n", board);
+    return;
+  }
+  hw_write_burst32(adc_ctrl->buffer[board], words, count);
+}
+
+void adc_read_words(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint32_t *words, size_t count) {
+  if (board > 7) {
+    fprintf(stderr, "Invalid ADC board: %d. Must be 0-7.\n", board);
+    return;
+  }
+  volatile uint32_t *buffer_ptr = adc_ctrl->buffer[board];
+  for (size_t i = 0; i < count; i++) {
+    words[i] = hw_read32(buffer_ptr);
+  }
+}
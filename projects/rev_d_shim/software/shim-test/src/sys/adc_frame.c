@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <string.h>
+#include "adc_frame.h"
+
+// Start checking a stream
+void adc_frame_check_init(struct adc_frame_check_t *check, uint8_t board, uint32_t frame_len, FILE *log) {
+  memset(check, 0, sizeof(*check));
+  check->board = board;
+  check->frame_len = frame_len;
+  check->log = log;
+  if (log) {
+    fprintf(log, "# ADC frame check: board %u, %u data words per frame\n", board, frame_len);
+    fprintf(log, "# gap <data word> <data words> <words lost> <first frame> <last frame>: words missing somewhere in that span of data words\n");
+    fprintf(log, "# unverified <data word> <data words>: a span of data words no pair of markers accounts for\n");
+  }
+}
+
+static bool is_marker(const struct adc_frame_check_t *check, uint32_t word) {
+  return ADC_FRAME_IS_MARKER(word, check->board) && ADC_FRAME_DROPS(word) <= check->frame_len;
+}
+
+// Whether a marker with this drop count, at the current word, sits where it follows the marker at index
+static bool marker_fits(const struct adc_frame_check_t *check, uint64_t index, uint32_t drops) {
+  return check->index - index - 1 + drops == check->frame_len;
+}
+
+// Whether the marker at index can still be followed by the next word
+static bool can_follow(const struct adc_frame_check_t *check, uint64_t index) {
+  return check->index - index <= check->frame_len;
+}
+
+static void pass_data(struct adc_frame_check_t *check, uint32_t word, uint32_t *data, size_t *count) {
+  data[(*count)++] = word;
+  check->stats.data_words++;
+  check->span_words++;
+}
+
+static void hold_word(struct adc_frame_check_t *check, uint32_t word) {
+  if (check->hold_count == 0) check->hold_index = check->index;
+  check->hold[check->hold_count++] = word;
+}
+
+// Pass on the held words ahead of stream position `until` as data
+static void release_held(struct adc_frame_check_t *check, uint64_t until, uint32_t *data, size_t *count) {
+  if (until <= check->hold_index) return;
+  size_t n = (size_t)(until - check->hold_index);
+  if (n > check->hold_count) n = check->hold_count;
+  for (size_t i = 0; i < n; i++) pass_data(check, check->hold[i], data, count);
+  memmove(check->hold, &check->hold[n], (check->hold_count - n) * sizeof(uint32_t));
+  check->hold_count -= n;
+  check->hold_index += n;
+}
+
+// Drop the flagged candidates along with any jumps from them (their words are data), then pass on
+// the held words ahead of the oldest candidate left
+static void drop_candidates(struct adc_frame_check_t *check, bool drop[ADC_FRAME_MAX_CANDIDATES], uint32_t *data, size_t *count) {
+  int map[ADC_FRAME_MAX_CANDIDATES];
+  int kept = 0;
+  for (int i = 0; i < check->candidate_count; i++) {
+    struct adc_frame_candidate_t candidate = check->candidates[i];
+    // Parents always come first
+    if (candidate.parent >= 0 && drop[candidate.parent]) drop[i] = true;
+    if (drop[i]) continue;
+    if (candidate.parent >= 0) candidate.parent = map[candidate.parent];
+    map[i] = kept;
+    check->candidates[kept++] = candidate;
+  }
+  check->candidate_count = kept;
+  release_held(check, kept > 0 ? check->candidates[0].index : check->hold_index + check->hold_count, data, count);
+}
+
+static void drop_all_candidates(struct adc_frame_check_t *check, uint32_t *data, size_t *count) {
+  bool drop[ADC_FRAME_MAX_CANDIDATES];
+  for (int i = 0; i < check->candidate_count; i++) drop[i] = true;
+  drop_candidates(check, drop, data, count);
+}
+
+// Accept the marker at index, closing the current span. If linked, it follows the last accepted
+// marker and the span is checked; otherwise sync starts over at it and the span is unverified.
+static void accept_marker(struct adc_frame_check_t *check, uint64_t index, uint16_t seq, uint32_t drops, bool linked) {
+  struct adc_frame_stats_t *stats = &check->stats;
+  if (linked) {
+    uint32_t jump = (uint16_t)(seq - check->last_seq);
+    if (jump == 0) jump = 0x10000;
+    uint64_t lost = (uint64_t)(jump - 1) * check->frame_len + drops;
+    if (lost > 0) {
+      stats->gaps++;
+      stats->words_lost += lost;
+      if (check->log) {
+        fprintf(check->log, "gap %llu %llu %llu %u %u\n", (unsigned long long)check->span_start,
+                (unsigned long long)check->span_words, (unsigned long long)lost, (uint16_t)(check->last_seq + 1), seq);
+      }
+    }
+  } else if (check->span_words > 0) {
+    stats->unverified += check->span_words;
+    if (check->log) {
+      fprintf(check->log, "unverified %llu %llu\n", (unsigned long long)check->span_start,
+              (unsigned long long)check->span_words);
+    }
+  }
+  check->synced = true;
+  check->last_seq = seq;
+  check->last_index = index;
+  check->span_start = stats->data_words;
+  check->span_words = 0;
+  stats->markers++;
+}
+
+// Accept candidate i and the jumps leading to it; every other held word is data
+static void confirm_candidate(struct adc_frame_check_t *check, int i, uint32_t *data, size_t *count) {
+  bool chain[ADC_FRAME_MAX_CANDIDATES] = {false};
+  int head = i;
+  for (int j = i; j >= 0; j = check->candidates[j].parent) {
+    chain[j] = true;
+    head = j;
+  }
+  // The chain's first marker follows the last accepted one if in sync
+  bool linked = check->synced;
+  int next = head;
+  for (size_t k = 0; k < check->hold_count; k++) {
+    uint64_t index = check->hold_index + k;
+    if (next <= i && check->candidates[next].index == index) {
+      accept_marker(check, index, check->candidates[next].seq, ADC_FRAME_DROPS(check->hold[k]), linked);
+      linked = true;
+      do next++; while (next <= i && !chain[next]);
+    } else {
+      pass_data(check, check->hold[k], data, count);
+    }
+  }
+  check->hold_index += check->hold_count;
+  check->hold_count = 0;
+  check->candidate_count = 0;
+}
+
+// Drop candidates that can no longer be followed (unless a jump from them still can), and lose
+// sync if the last accepted marker's successor can no longer turn up
+static void prune_candidates(struct adc_frame_check_t *check, uint32_t *data, size_t *count) {
+  bool root_live = check->synced && can_follow(check, check->last_index);
+  if (check->candidate_count > 0) {
+    bool live[ADC_FRAME_MAX_CANDIDATES];
+    bool drop[ADC_FRAME_MAX_CANDIDATES];
+    for (int i = 0; i < check->candidate_count; i++) live[i] = can_follow(check, check->candidates[i].index);
+    for (int i = check->candidate_count - 1; i >= 0; i--) {
+      int parent = check->candidates[i].parent;
+      if (!live[i]) continue;
+      if (parent >= 0) live[parent] = true;
+      else root_live = true;
+    }
+    for (int i = 0; i < check->candidate_count; i++) drop[i] = !live[i];
+    drop_candidates(check, drop, data, count);
+  }
+  if (check->synced && !root_live) {
+    check->synced = false;
+    check->stats.sync_losses++;
+  }
+}
+
+// Out of sync, the last frame's worth of words is held back. A marker-like word's drop count
+// says where its marker would be, so a pair of markers with consecutive sequence numbers is
+// found without tracking candidates (every word may look like a marker).
+static void check_word_unsynced(struct adc_frame_check_t *check, uint32_t word, uint32_t *data, size_t *count) {
+  uint32_t frame_len = check->frame_len;
+  // A stream opening with marker 0 starts where framing started, so it syncs right away (and a
+  // frame lost right after it shows up as a jump from it)
+  if (check->index == 0 && is_marker(check, word) && ADC_FRAME_SEQ(word) == 0 && ADC_FRAME_DROPS(word) == 0) {
+    accept_marker(check, 0, 0, 0, false);
+    return;
+  }
+  hold_word(check, word);
+  if (is_marker(check, word) && check->index >= frame_len - ADC_FRAME_DROPS(word) + 1) {
+    uint64_t prev = check->index - (frame_len - ADC_FRAME_DROPS(word)) - 1;
+    uint32_t prev_word = prev >= check->hold_index ? check->hold[prev - check->hold_index] : 0;
+    if (prev >= check->hold_index && is_marker(check, prev_word) &&
+        ADC_FRAME_SEQ(word) == (uint16_t)(ADC_FRAME_SEQ(prev_word) + 1)) {
+      // Everything ahead of the pair is unverified, the frame between them is checked
+      release_held(check, prev, data, count);
+      accept_marker(check, prev, ADC_FRAME_SEQ(prev_word), 0, false);
+      check->hold_index++;
+      check->hold_count--;
+      memmove(check->hold, &check->hold[1], check->hold_count * sizeof(uint32_t));
+      release_held(check, check->index, data, count);
+      accept_marker(check, check->index, ADC_FRAME_SEQ(word), ADC_FRAME_DROPS(word), true);
+      check->hold_index++;
+      check->hold_count = 0;
+      return;
+    }
+  }
+  // Words too far back to start a pair are data
+  if (check->index >= frame_len) release_held(check, check->index - frame_len, data, count);
+}
+
+static void check_word(struct adc_frame_check_t *check, uint32_t word, uint32_t *data, size_t *count) {
+  if (!check->synced) {
+    check_word_unsynced(check, word, data, count);
+    return;
+  }
+  // Make room for one more held word
+  if (check->hold_count == ADC_FRAME_HOLD_WORDS) drop_all_candidates(check, data, count);
+
+  if (is_marker(check, word)) {
+    uint16_t seq = ADC_FRAME_SEQ(word);
+    uint32_t drops = ADC_FRAME_DROPS(word);
+    // The next marker after the last accepted one
+    if (check->synced && seq == (uint16_t)(check->last_seq + 1) && marker_fits(check, check->last_index, drops)) {
+      drop_all_candidates(check, data, count);
+      accept_marker(check, check->index, seq, drops, true);
+      return;
+    }
+    // The next marker after a candidate confirms it
+    for (int i = check->candidate_count - 1; i >= 0; i--) {
+      if (seq == (uint16_t)(check->candidates[i].seq + 1) && marker_fits(check, check->candidates[i].index, drops)) {
+        confirm_candidate(check, i, data, count);
+        accept_marker(check, check->index, seq, drops, true);
+        return;
+      }
+    }
+    // A jump in sequence number waits for confirmation (when the table is full, the candidates
+    // already in it are kept, as the real one is the oldest)
+    int parent = -2;
+    for (int i = check->candidate_count - 1; i >= 0 && parent == -2; i--) {
+      if (marker_fits(check, check->candidates[i].index, drops)) parent = i;
+    }
+    if (parent == -2 && marker_fits(check, check->last_index, drops)) parent = -1;
+    if (parent != -2 && check->candidate_count < ADC_FRAME_MAX_CANDIDATES) {
+      check->candidates[check->candidate_count++] = (struct adc_frame_candidate_t){check->index, seq, parent};
+      hold_word(check, word);
+      return;
+    }
+  }
+
+  if (check->candidate_count > 0) hold_word(check, word);
+  else pass_data(check, word, data, count);
+}
+
+// Take in a block of stream words
+size_t adc_frame_check_words(struct adc_frame_check_t *check, const uint32_t *words, size_t count, uint32_t *data) {
+  size_t data_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    check_word(check, words[i], data, &data_count);
+    if (check->candidate_count > 0 || (check->synced && !can_follow(check, check->last_index))) {
+      prune_candidates(check, data, &data_count);
+    }
+    check->index++;
+  }
+  return data_count;
+}
+
+// Number of markers in candidate i's chain of jumps
+static int chain_length(const struct adc_frame_check_t *check, int i) {
+  int length = 0;
+  for (int j = i; j >= 0; j = check->candidates[j].parent) length++;
+  return length;
+}
+
+// Whether the stream ran past every spot the marker before candidate i could have been followed
+// by its next sequence number, so the jump to candidate i is the only way left to read it
+static bool jump_certain(const struct adc_frame_check_t *check, int i) {
+  int parent = check->candidates[i].parent;
+  uint64_t parent_index = parent >= 0 ? check->candidates[parent].index : check->last_index;
+  return check->index - parent_index > (uint64_t)check->frame_len + 1;
+}
+
+// End of stream: no marker will confirm the candidates left. The longest chain of them (the
+// earliest on a tie, preferring ones whose jump is certain) is accepted if its jump is certain.
+// Otherwise its words are stripped and everything after the last accepted marker is unverified.
+static void finish_candidates(struct adc_frame_check_t *check, uint32_t *data, size_t *count) {
+  int best = 0;
+  for (int i = 1; i < check->candidate_count; i++) {
+    bool certain = jump_certain(check, i);
+    bool best_certain = jump_certain(check, best);
+    if (certain != best_certain ? certain : chain_length(check, i) > chain_length(check, best)) best = i;
+  }
+  if (jump_certain(check, best)) {
+    confirm_candidate(check, best, data, count);
+    return;
+  }
+
+  bool chain[ADC_FRAME_MAX_CANDIDATES] = {false};
+  for (int j = best; j >= 0; j = check->candidates[j].parent) chain[j] = true;
+  int next = 0;
+  for (size_t k = 0; k < check->hold_count; k++) {
+    while (next < check->candidate_count && (!chain[next] || check->candidates[next].index < check->hold_index + k)) next++;
+    if (next < check->candidate_count && check->candidates[next].index == check->hold_index + k) {
+      check->stats.stripped++;
+    } else {
+      pass_data(check, check->hold[k], data, count);
+    }
+  }
+  check->hold_index += check->hold_count;
+  check->hold_count = 0;
+  check->candidate_count = 0;
+  check->synced = false;
+}
+
+// End of stream
+size_t adc_frame_check_finish(struct adc_frame_check_t *check, uint32_t *data) {
+  size_t data_count = 0;
+  if (check->candidate_count > 0) finish_candidates(check, data, &data_count);
+  // Out of sync, the last frame's worth of words is still held back
+  release_held(check, check->hold_index + check->hold_count, data, &data_count);
+  struct adc_frame_stats_t *stats = &check->stats;
+  uint64_t tail = 0;
+  if (check->synced) {
+    tail = check->span_words;
+  } else if (check->span_words > 0) {
+    stats->unverified += check->span_words;
+    if (check->log) {
+      fprintf(check->log, "unverified %llu %llu\n", (unsigned long long)check->span_start,
+              (unsigned long long)check->span_words);
+    }
+  }
+  if (check->log) {
+    fprintf(check->log, "# Summary: %llu data words, %llu markers, %llu gaps, %llu words lost, %llu unverified, %llu stripped unconfirmed, %llu after the last marker\n",
+            (unsigned long long)stats->data_words, (unsigned long long)stats->markers, (unsigned long long)stats->gaps,
+            (unsigned long long)stats->words_lost, (unsigned long long)stats->unverified, (unsigned long long)stats->stripped,
+            (unsigned long long)tail);
+    fprintf(check->log, "# Complete: %s\n", adc_frame_check_complete(check) ? "yes" : "no");
+  }
+  return data_count;
+}
+
+bool adc_frame_check_complete(const struct adc_frame_check_t *check) {
+  const struct adc_frame_stats_t *stats = &check->stats;
+  return stats->markers > 0 && stats->gaps == 0 && stats->unverified == 0 && stats->stripped == 0 &&
+         stats->sync_losses == 0;
+}
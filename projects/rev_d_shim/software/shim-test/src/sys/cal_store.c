@@ -0,0 +1,157 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "cal_store.h"
+
+// File header, followed by CAL_STORE_BOARDS records of record_size bytes
+typedef struct {
+  uint32_t magic;                // CAL_STORE_MAGIC
+  uint16_t version;              // CAL_STORE_VERSION
+  uint16_t board_count;          // CAL_STORE_BOARDS
+  uint32_t record_size;          // sizeof(struct cal_store_board_t)
+  uint32_t crc32;                // CRC-32 of the records
+  int64_t saved_time;
+} cal_store_header_t;
+
+_Static_assert(sizeof(cal_store_header_t) == 24, "cal_store_header_t layout changed");
+_Static_assert(sizeof(struct cal_store_board_t) == 288, "cal_store_board_t layout changed: bump CAL_STORE_VERSION");
+
+// CRC-32 (IEEE 802.3, bitwise; the store is only a few KiB)
+static uint32_t crc32_update(uint32_t crc, const void *data, size_t len) {
+  const uint8_t *p = (const uint8_t *)data;
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= p[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1u));
+    }
+  }
+  return ~crc;
+}
+
+// Default store path
+void cal_store_default_path(char *path, size_t size) {
+  const char *home = getenv("HOME");
+  if (home != NULL && home[0] != '\0') {
+    snprintf(path, size, "%s/%s", home, CAL_STORE_DEFAULT_FILE);
+  } else {
+    snprintf(path, size, "%s", CAL_STORE_DEFAULT_FILE);
+  }
+}
+
+// Write a store atomically
+int cal_store_save(const struct cal_store_t *store, const char *path) {
+  char tmp_path[1100];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+  cal_store_header_t header = {
+    .magic = CAL_STORE_MAGIC,
+    .version = CAL_STORE_VERSION,
+    .board_count = CAL_STORE_BOARDS,
+    .record_size = sizeof(struct cal_store_board_t),
+    .crc32 = crc32_update(0, store->boards, sizeof(store->boards)),
+    .saved_time = store->saved_time
+  };
+
+  FILE *file = fopen(tmp_path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to create calibration store '%s': %s\n", tmp_path, strerror(errno));
+    return -1;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(store->boards, sizeof(store->boards), 1, file) == 1;
+  ok = (fflush(file) == 0) && ok;
+  ok = (fsync(fileno(file)) == 0) && ok;
+  ok = (fclose(file) == 0) && ok;
+  if (!ok || rename(tmp_path, path) != 0) {
+    fprintf(stderr, "Failed to write calibration store '%s': %s\n", path, strerror(errno));
+    unlink(tmp_path);
+    return -1;
+  }
+  return 0;
+}
+
+// Read and validate a store
+int cal_store_load(struct cal_store_t *store, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    if (errno == ENOENT) return 1;
+    fprintf(stderr, "Failed to open calibration store '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  cal_store_header_t header;
+  struct cal_store_t loaded;
+  memset(&loaded, 0, sizeof(loaded));
+  size_t header_read = fread(&header, sizeof(header), 1, file);
+  if (header_read != 1 || header.magic != CAL_STORE_MAGIC) {
+    fprintf(stderr, "Calibration store '%s' is not a calibration store file\n", path);
+    fclose(file);
+    return -1;
+  }
+  if (header.version != CAL_STORE_VERSION || header.board_count != CAL_STORE_BOARDS ||
+      header.record_size != sizeof(struct cal_store_board_t)) {
+    fprintf(stderr, "Calibration store '%s' has an unsupported layout (version %u, %u boards, %u-byte records)\n",
+            path, header.version, header.board_count, header.record_size);
+    fclose(file);
+    return -1;
+  }
+  size_t records_read = fread(loaded.boards, sizeof(loaded.boards), 1, file);
+  fclose(file);
+  if (records_read != 1) {
+    fprintf(stderr, "Calibration store '%s' is truncated\n", path);
+    return -1;
+  }
+  if (crc32_update(0, loaded.boards, sizeof(loaded.boards)) != header.crc32) {
+    fprintf(stderr, "Calibration store '%s' is corrupt (CRC mismatch)\n", path);
+    return -1;
+  }
+
+  loaded.saved_time = header.saved_time;
+  *store = loaded;
+  return 0;
+}
+
+// Move a store aside
+int cal_store_backup(const char *path, char *backup_path, size_t size) {
+  snprintf(backup_path, size, "%s.bak", path);
+  if (rename(path, backup_path) != 0) {
+    fprintf(stderr, "Failed to move calibration store '%s' to '%s': %s\n", path, backup_path, strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+// Copy a board's fit entries into a store record
+void cal_store_put_fit(struct cal_store_board_t *board_rec, const struct cal_table_t *table, int board) {
+  for (int channel = 0; channel < 8; channel++) {
+    int ch = board * 8 + channel;
+    board_rec->fit_status[channel] = table->status[ch];
+    board_rec->fit_order[channel] = table->order[ch];
+    board_rec->fit_mul[channel] = table->mul[ch];
+    board_rec->fit_add[channel] = table->add[ch];
+    board_rec->fit_quad[channel] = table->quad[ch];
+    board_rec->fit_gain[channel] = table->gain[ch];
+    board_rec->fit_offset[channel] = table->offset[ch];
+    board_rec->fit_rms[channel] = table->rms_residual[ch];
+  }
+}
+
+// Copy a board's fit entries from a store record (only fitted channels; the rest become the identity)
+void cal_store_get_fit(const struct cal_store_board_t *board_rec, struct cal_table_t *table, int board) {
+  for (int channel = 0; channel < 8; channel++) {
+    int ch = board * 8 + channel;
+    cal_table_clear_channel(table, ch);
+    if (board_rec->fit_status[channel] != CAL_FIT_OK) continue;
+    table->status[ch] = CAL_FIT_OK;
+    table->order[ch] = board_rec->fit_order[channel];
+    table->mul[ch] = board_rec->fit_mul[channel];
+    table->add[ch] = board_rec->fit_add[channel];
+    table->quad[ch] = board_rec->fit_quad[channel];
+    table->gain[ch] = board_rec->fit_gain[channel];
+    table->offset[ch] = board_rec->fit_offset[channel];
+    table->rms_residual[ch] = board_rec->fit_rms[channel];
+  }
+}
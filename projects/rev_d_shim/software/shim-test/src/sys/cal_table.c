@@ -0,0 +1,254 @@
+#include <math.h>
+#include <string.h>
+#include "cal_table.h"
+
+// Fits are done on y / CAL_FIT_Y_SCALE so the y^4 sums stay well conditioned
+#define CAL_FIT_Y_SCALE 32768.0
+
+#define CAL_TABLE_ONE   (int32_t) (1 << CAL_TABLE_FRAC_BITS)
+#define CAL_TABLE_ROUND (int32_t) (1 << (CAL_TABLE_FRAC_BITS - 1))
+
+// Create an identity table
+struct cal_table_t create_cal_table(void) {
+  struct cal_table_t table;
+  memset(&table, 0, sizeof(table));
+  for (int ch = 0; ch < CAL_TABLE_CHANNELS; ch++) {
+    cal_table_clear_channel(&table, ch);
+  }
+  return table;
+}
+
+// Reset a channel to the identity
+void cal_table_clear_channel(struct cal_table_t *table, int ch) {
+  table->mul[ch] = CAL_TABLE_ONE;
+  table->add[ch] = CAL_TABLE_ROUND;
+  table->quad[ch] = 0;
+  table->status[ch] = CAL_FIT_NONE;
+  table->order[ch] = 0;
+  table->gain[ch] = 1.0f;
+  table->offset[ch] = 0.0f;
+  table->rms_residual[ch] = 0.0f;
+}
+
+// Whether a channel has a correction
+bool cal_table_channel_valid(const struct cal_table_t *table, int ch) {
+  return table->status[ch] == CAL_FIT_OK || table->status[ch] == CAL_FIT_OFFSET_ONLY;
+}
+
+// Name of a CAL_FIT_* status
+const char *cal_fit_status_name(uint8_t status) {
+  switch (status) {
+    case CAL_FIT_NONE:         return "none";
+    case CAL_FIT_OK:           return "fitted";
+    case CAL_FIT_OFFSET_ONLY:  return "offset only";
+    case CAL_FIT_NO_DATA:      return "too few points";
+    case CAL_FIT_SINGULAR:     return "no response";
+    case CAL_FIT_OUT_OF_RANGE: return "out of range";
+    default:                   return "?";
+  }
+}
+
+// Store a channel's fitted polynomial x = c0 + c1*y + c2*y^2 (false if it doesn't fit the table)
+static bool store_fit(struct cal_table_t *table, int ch, double c0, double c1, double c2, int order) {
+  double mul = c1 * CAL_TABLE_ONE;
+  double add = c0 * CAL_TABLE_ONE;
+  double quad = ldexp(c2, CAL_TABLE_FRAC_BITS + CAL_TABLE_QUAD_SHIFT);
+  if (fabs(mul) >= CAL_TABLE_MAX_MUL || fabs(add) >= CAL_TABLE_MAX_ADD || fabs(quad) >= 2147483647.0) {
+    return false;
+  }
+  table->mul[ch] = (int32_t)lround(mul);
+  table->add[ch] = (int32_t)lround(add) + CAL_TABLE_ROUND;
+  table->quad[ch] = (int32_t)lround(quad);
+  table->order[ch] = (uint8_t)order;
+
+  // Forward diagnostics at DAC zero: find the y where x(y) = 0 (Newton from the linear root)
+  double y0 = -c0 / c1;
+  for (int iter = 0; iter < 4 && c2 != 0.0; iter++) {
+    double slope = c1 + 2.0 * c2 * y0;
+    if (slope == 0.0) break;
+    y0 -= (c0 + c1 * y0 + c2 * y0 * y0) / slope;
+  }
+  table->offset[ch] = (float)y0;
+  table->gain[ch] = (float)(1.0 / (c1 + 2.0 * c2 * y0));
+  return true;
+}
+
+// Batch least-squares fit. The normal-equation sums are accumulated for all channels at once
+// (structure of arrays, channel index innermost) so the loops vectorize.
+int cal_table_fit(struct cal_table_t *table, const bool ch_mask[CAL_TABLE_CHANNELS],
+                  const double *dac_codes, const double *adc, int points, int order) {
+  if (order < 1) order = 1;
+  if (order > CAL_TABLE_MAX_ORDER) order = CAL_TABLE_MAX_ORDER;
+  if (points > CAL_TABLE_MAX_POINTS) points = CAL_TABLE_MAX_POINTS;
+
+  // s[p][ch] = sum(u^p), t[p][ch] = sum(x * u^p) with u = y / CAL_FIT_Y_SCALE
+  double s[2 * CAL_TABLE_MAX_ORDER + 1][CAL_TABLE_CHANNELS];
+  double t[CAL_TABLE_MAX_ORDER + 1][CAL_TABLE_CHANNELS];
+  memset(s, 0, sizeof(s));
+  memset(t, 0, sizeof(t));
+
+  for (int k = 0; k < points; k++) {
+    const double x = dac_codes[k];
+    const double *y = &adc[(size_t)k * CAL_TABLE_CHANNELS];
+    for (int ch = 0; ch < CAL_TABLE_CHANNELS; ch++) {
+      double u = y[ch] * (1.0 / CAL_FIT_Y_SCALE);
+      double u2 = u * u;
+      s[0][ch] += 1.0;
+      s[1][ch] += u;
+      s[2][ch] += u2;
+      t[0][ch] += x;
+      t[1][ch] += x * u;
+      if (order == 2) {
+        s[3][ch] += u2 * u;
+        s[4][ch] += u2 * u2;
+        t[2][ch] += x * u2;
+      }
+    }
+  }
+
+  // Solve each channel's normal equations (Cramer's rule), in normalized units
+  double a[CAL_TABLE_MAX_ORDER + 1][CAL_TABLE_CHANNELS];
+  uint8_t status[CAL_TABLE_CHANNELS];
+  for (int ch = 0; ch < CAL_TABLE_CHANNELS; ch++) {
+    a[0][ch] = a[1][ch] = a[2][ch] = 0.0;
+    if (points <= order) {
+      status[ch] = CAL_FIT_NO_DATA;
+      continue;
+    }
+    if (order == 1) {
+      double det = s[0][ch] * s[2][ch] - s[1][ch] * s[1][ch];
+      if (det <= 1e-12 * s[0][ch] * s[2][ch]) {
+        status[ch] = CAL_FIT_SINGULAR;
+        continue;
+      }
+      a[0][ch] = (t[0][ch] * s[2][ch] - s[1][ch] * t[1][ch]) / det;
+      a[1][ch] = (s[0][ch] * t[1][ch] - s[1][ch] * t[0][ch]) / det;
+    } else {
+      double m00 = s[0][ch], m01 = s[1][ch], m02 = s[2][ch];
+      double m11 = s[2][ch], m12 = s[3][ch], m22 = s[4][ch];
+      double c00 = m11 * m22 - m12 * m12;
+      double c01 = m02 * m12 - m01 * m22;
+      double c02 = m01 * m12 - m02 * m11;
+      double det = m00 * c00 + m01 * c01 + m02 * c02;
+      if (det <= 1e-12 * m00 * m11 * m22) {
+        status[ch] = CAL_FIT_SINGULAR;
+        continue;
+      }
+      double c11 = m00 * m22 - m02 * m02;
+      double c12 = m01 * m02 - m00 * m12;
+      double c22 = m00 * m11 - m01 * m01;
+      a[0][ch] = (c00 * t[0][ch] + c01 * t[1][ch] + c02 * t[2][ch]) / det;
+      a[1][ch] = (c01 * t[0][ch] + c11 * t[1][ch] + c12 * t[2][ch]) / det;
+      a[2][ch] = (c02 * t[0][ch] + c12 * t[1][ch] + c22 * t[2][ch]) / det;
+    }
+    status[ch] = CAL_FIT_OK;
+  }
+
+  // Residuals, again for all channels at once
+  double sq_residual[CAL_TABLE_CHANNELS];
+  memset(sq_residual, 0, sizeof(sq_residual));
+  for (int k = 0; k < points; k++) {
+    const double x = dac_codes[k];
+    const double *y = &adc[(size_t)k * CAL_TABLE_CHANNELS];
+    for (int ch = 0; ch < CAL_TABLE_CHANNELS; ch++) {
+      double u = y[ch] * (1.0 / CAL_FIT_Y_SCALE);
+      double r = x - (a[0][ch] + (a[1][ch] + a[2][ch] * u) * u);
+      sq_residual[ch] += r * r;
+    }
+  }
+
+  int fitted = 0;
+  for (int ch = 0; ch < CAL_TABLE_CHANNELS; ch++) {
+    if (!ch_mask[ch]) continue;
+    cal_table_clear_channel(table, ch);
+    if (status[ch] == CAL_FIT_OK &&
+        !store_fit(table, ch, a[0][ch], a[1][ch] / CAL_FIT_Y_SCALE,
+                   a[2][ch] / (CAL_FIT_Y_SCALE * CAL_FIT_Y_SCALE), order)) {
+      status[ch] = CAL_FIT_OUT_OF_RANGE;
+    }
+    table->status[ch] = status[ch];
+    if (status[ch] == CAL_FIT_OK) {
+      table->rms_residual[ch] = (float)sqrt(sq_residual[ch] / points);
+      fitted++;
+    }
+  }
+  return fitted;
+}
+
+// Set an offset-only entry that subtracts an ADC bias from the channel
+void cal_table_set_offset(struct cal_table_t *table, int ch, double adc_bias) {
+  double add = -adc_bias * CAL_TABLE_ONE;
+  if (add >= CAL_TABLE_MAX_ADD) add = CAL_TABLE_MAX_ADD - 1;
+  if (add <= -CAL_TABLE_MAX_ADD) add = -CAL_TABLE_MAX_ADD + 1;
+  cal_table_clear_channel(table, ch);
+  table->add[ch] = (int32_t)lround(add) + CAL_TABLE_ROUND;
+  table->status[ch] = CAL_FIT_OFFSET_ONLY;
+  table->offset[ch] = (float)adc_bias;
+}
+
+// Saturate a corrected value to a signed 16-bit sample
+static inline int32_t saturate16(int32_t v) {
+  return v < -32768 ? -32768 : (v > 32767 ? 32767 : v);
+}
+
+// Linear correction (32-bit), and the general one with the quadratic term (64-bit)
+static inline int32_t correct_linear(int32_t y, int32_t mul, int32_t add) {
+  return saturate16((y * mul + add) >> CAL_TABLE_FRAC_BITS);
+}
+
+static inline int32_t correct_quad(int32_t y, int32_t mul, int32_t add, int32_t quad) {
+  int64_t acc = (int64_t)y * mul + add + (((int64_t)y * y * quad) >> CAL_TABLE_QUAD_SHIFT);
+  acc >>= CAL_TABLE_FRAC_BITS;
+  return acc < -32768 ? -32768 : (acc > 32767 ? 32767 : (int32_t)acc);
+}
+
+// Correct a single signed sample
+int16_t cal_table_apply_sample(const struct cal_table_t *table, int ch, int16_t sample) {
+  if (table->quad[ch] != 0) {
+    return (int16_t)correct_quad(sample, table->mul[ch], table->add[ch], table->quad[ch]);
+  }
+  return (int16_t)correct_linear(sample, table->mul[ch], table->add[ch]);
+}
+
+// Correct a block of packed ADC_RD words from one board
+void cal_table_apply_words(const struct cal_table_t *table, uint8_t board, const uint32_t *words,
+                           uint32_t *out, size_t count, uint32_t first_word) {
+  // Lane coefficients rotated so lane 0 is the low half of words[0]
+  int32_t mul[8], add[8], quad[8];
+  bool has_quad = false;
+  for (int lane = 0; lane < 8; lane++) {
+    int ch = board * 8 + (int)((2 * first_word + lane) & 7);
+    mul[lane] = table->mul[ch];
+    add[lane] = table->add[ch];
+    quad[lane] = table->quad[ch];
+    has_quad |= quad[lane] != 0;
+  }
+
+  // Whole reads (four words, eight samples) with fixed lanes
+  size_t full = count & ~(size_t)3;
+  for (size_t i = 0; i < full; i += 4) {
+    int32_t y[8], r[8];
+    for (int w = 0; w < 4; w++) {
+      y[2 * w] = (int32_t)(words[i + w] & 0xFFFF) - 0x8000;
+      y[2 * w + 1] = (int32_t)(words[i + w] >> 16) - 0x8000;
+    }
+    if (has_quad) {
+      for (int lane = 0; lane < 8; lane++) r[lane] = correct_quad(y[lane], mul[lane], add[lane], quad[lane]);
+    } else {
+      for (int lane = 0; lane < 8; lane++) r[lane] = correct_linear(y[lane], mul[lane], add[lane]);
+    }
+    for (int w = 0; w < 4; w++) {
+      out[i + w] = (uint32_t)(r[2 * w] + 0x8000) | ((uint32_t)(r[2 * w + 1] + 0x8000) << 16);
+    }
+  }
+
+  // Remaining words of a partial read
+  for (size_t i = full; i < count; i++) {
+    int lane = (int)(2 * (i & 3));
+    int32_t lo = (int32_t)(words[i] & 0xFFFF) - 0x8000;
+    int32_t hi = (int32_t)(words[i] >> 16) - 0x8000;
+    lo = correct_quad(lo, mul[lane], add[lane], quad[lane]);
+    hi = correct_quad(hi, mul[lane + 1], add[lane + 1], quad[lane + 1]);
+    out[i] = (uint32_t)(lo + 0x8000) | ((uint32_t)(hi + 0x8000) << 16);
+  }
+}
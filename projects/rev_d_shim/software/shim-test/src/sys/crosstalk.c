@@ -0,0 +1,116 @@
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "crosstalk.h"
+
+_Static_assert(sizeof(crosstalk_file_header_t) == 32, "crosstalk_file_header_t layout changed");
+
+static bool channel_measured(const struct crosstalk_matrix_t *matrix, int ch) {
+  return (matrix->channel_mask >> ch) & 1;
+}
+
+// Create an empty matrix
+struct crosstalk_matrix_t create_crosstalk_matrix(uint64_t channel_mask, float amplitude, uint32_t samples) {
+  struct crosstalk_matrix_t matrix;
+  matrix.channel_mask = channel_mask;
+  matrix.amplitude = amplitude;
+  matrix.samples = samples;
+  matrix.time = 0;
+  for (int driven = 0; driven < CROSSTALK_CHANNELS; driven++) {
+    for (int measured = 0; measured < CROSSTALK_CHANNELS; measured++) {
+      matrix.coupling[driven][measured] = NAN;
+    }
+  }
+  return matrix;
+}
+
+// Sum whole reads into eight fixed lanes (lane 2w is the low half of word w, 2w+1 the high half)
+void crosstalk_accumulate(int32_t sums[8], const uint32_t *words, size_t reads) {
+  int32_t acc[8] = {0};
+  for (size_t r = 0; r < reads; r++) {
+    const uint32_t *read = &words[4 * r];
+    int32_t y[8];
+    for (int w = 0; w < 4; w++) {
+      y[2 * w] = (int32_t)(read[w] & 0xFFFF) - 0x8000;
+      y[2 * w + 1] = (int32_t)(read[w] >> 16) - 0x8000;
+    }
+    for (int lane = 0; lane < 8; lane++) acc[lane] += y[lane];
+  }
+  for (int lane = 0; lane < 8; lane++) sums[lane] += acc[lane];
+}
+
+// Fill the row of a driven channel
+void crosstalk_set_row(struct crosstalk_matrix_t *matrix, int driven,
+                       const int32_t pos_sums[CROSSTALK_CHANNELS], const int32_t neg_sums[CROSSTALK_CHANNELS]) {
+  // (mean(+) - mean(-)) / (2 * amplitude), in one multiply per channel
+  float scale = 1.0f / (2.0f * matrix->amplitude * (float)matrix->samples);
+  for (int measured = 0; measured < CROSSTALK_CHANNELS; measured++) {
+    float coupling = (float)(pos_sums[measured] - neg_sums[measured]) * scale;
+    matrix->coupling[driven][measured] = channel_measured(matrix, measured) ? coupling : NAN;
+  }
+}
+
+// Coupling relative to the driven channel's own response
+float crosstalk_relative(const struct crosstalk_matrix_t *matrix, int driven, int measured) {
+  float self = matrix->coupling[driven][driven];
+  if (isnan(self) || self == 0.0f) return NAN;
+  return matrix->coupling[driven][measured] / self;
+}
+
+// Write the matrix as CSV
+int crosstalk_save_csv(const struct crosstalk_matrix_t *matrix, const char *path) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open crosstalk file '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+  fprintf(file, "# Crosstalk matrix: rows are driven channels, columns measured channels\n");
+  fprintf(file, "# Entries: measured response per unit drive (ADC codes per DAC code, +/-%.0f DAC codes, %u reads per polarity)\n",
+          matrix->amplitude, matrix->samples);
+  fprintf(file, "# Time: %lld\n", (long long)matrix->time);
+  fprintf(file, "driven");
+  for (int measured = 0; measured < CROSSTALK_CHANNELS; measured++) {
+    if (channel_measured(matrix, measured)) fprintf(file, ",ch%02d", measured);
+  }
+  fprintf(file, "\n");
+  for (int driven = 0; driven < CROSSTALK_CHANNELS; driven++) {
+    if (!channel_measured(matrix, driven)) continue;
+    fprintf(file, "ch%02d", driven);
+    for (int measured = 0; measured < CROSSTALK_CHANNELS; measured++) {
+      if (channel_measured(matrix, measured)) fprintf(file, ",%.6g", matrix->coupling[driven][measured]);
+    }
+    fprintf(file, "\n");
+  }
+  if (fclose(file) != 0) {
+    fprintf(stderr, "Failed to write crosstalk file '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+// Write the matrix in the binary format
+int crosstalk_save_bin(const struct crosstalk_matrix_t *matrix, const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open crosstalk file '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+  crosstalk_file_header_t header = {
+    .magic = CROSSTALK_MAGIC,
+    .version = CROSSTALK_VERSION,
+    .channels = CROSSTALK_CHANNELS,
+    .channel_mask = matrix->channel_mask,
+    .amplitude = matrix->amplitude,
+    .samples = matrix->samples,
+    .time = matrix->time
+  };
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(matrix->coupling, sizeof(matrix->coupling), 1, file) == 1;
+  ok = (fclose(file) == 0) && ok;
+  if (!ok) {
+    fprintf(stderr, "Failed to write crosstalk file '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+  return 0;
+}
@@ -3,6 +3,7 @@
 #include <string.h>
 #include "dac_ctrl.h"
 #include "map_memory.h"
+#include "hw_backend.h"
 
 // Create DAC control structure for all boards
 struct dac_ctrl_t create_dac_ctrl(bool verbose) {
@@ -27,7 +28,7 @@ uint32_t dac_read_data(struct dac_ctrl_t *dac_ctrl, uint8_t board) {
     return 0; // Return 0 for invalid board
   }
 
-  return *(dac_ctrl->buffer[board]);
+  return hw_read32(dac_ctrl->buffer[board]);
 }
 
 // Interpret and format DAC data word as calibration or debug information
@@ -179,16 +180,12 @@ void dac_cmd_noop(struct dac_ctrl_t *dac_ctrl, uint8_t board, bool trig, bool co
     fprintf(stderr, "Invalid command value: %u. Must be 0 to 33554431 (25-bit value).\n", value);
     return;
   }
-  uint32_t cmd_word = (DAC_CMD_NO_OP  << DAC_CMD_CMD_LSB ) |
-                      ((ldac ? 1 : 0) << DAC_CMD_LDAC_BIT) |
-                      ((trig ? 1 : 0) << DAC_CMD_TRIG_BIT) |
-                      ((cont ? 1 : 0) << DAC_CMD_CONT_BIT) |
-                      (value & 0x1FFFFFF);
+  uint32_t cmd_word = dac_encode_cmd(DAC_CMD_NO_OP, trig, cont, ldac, value);
   
   if (verbose) {
     printf("DAC[%d] NO_OP command word: 0x%08X\n", board, cmd_word);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  hw_write32(dac_ctrl->buffer[board], cmd_word);
 }
 
 void dac_cmd_dac_wr(struct dac_ctrl_t *dac_ctrl, uint8_t board, int16_t ch_vals[8], bool trig, bool cont, bool ldac, uint32_t value, bool verbose) {
@@ -201,29 +198,18 @@ void dac_cmd_dac_wr(struct dac_ctrl_t *dac_ctrl, uint8_t board, int16_t ch_vals[
     return;
   }
   
-  uint32_t cmd_word = (DAC_CMD_DAC_WR << DAC_CMD_CMD_LSB ) |
-                      ((trig ? 1 : 0) << DAC_CMD_TRIG_BIT) |
-                      ((cont ? 1 : 0) << DAC_CMD_CONT_BIT) |
-                      ((ldac ? 1 : 0) << DAC_CMD_LDAC_BIT) |
-                      (value & 0x1FFFFFF);
+  // Command word followed by the channel values, sent as one burst
+  uint32_t words[DAC_WR_WORDCOUNT];
+  dac_encode_dac_wr(words, ch_vals, trig, cont, ldac, value);
   
   if (verbose) {
-    printf("DAC[%d] DAC_WR command word: 0x%08X\n", board, cmd_word);
-  }
-  *(dac_ctrl->buffer[board]) = cmd_word;
-
-  // Write channel values
-  for (int i = 0; i < 8; i += 2) {
-    // Each word contains two channels: [31:16] = ch N+1, [15:0] = ch N
-    uint16_t val0 = signed_to_offset(ch_vals[i]);
-    uint16_t val1 = signed_to_offset(ch_vals[i + 1]);
-    uint32_t word = ((uint32_t)val1 << 16) | val0;
-    if (verbose) {
+    printf("DAC[%d] DAC_WR command word: 0x%08X\n", board, words[0]);
+    for (int i = 0; i < 8; i += 2) {
       printf("DAC[%d] Channel data word %d: 0x%08X (ch%d=0x%04X, ch%d=0x%04X)\n", 
-             board, i/2, word, i, val0, i+1, val1);
+             board, i/2, words[1 + i / 2], i, words[1 + i / 2] & 0xFFFF, i+1, words[1 + i / 2] >> 16);
     }
-    *(dac_ctrl->buffer[board]) = word;
   }
+  hw_write_burst32(dac_ctrl->buffer[board], words, DAC_WR_WORDCOUNT);
 }
 
 void dac_cmd_dac_wr_ch(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t ch, int16_t ch_val, bool verbose) {
@@ -244,7 +230,7 @@ void dac_cmd_dac_wr_ch(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t ch, i
     printf("DAC[%d] DAC_WR_CH command word: 0x%08X (channel %d, value=0x%04X)\n", 
            board, cmd_word, ch, (uint16_t)signed_to_offset(ch_val) & 0xFFFF);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  hw_write32(dac_ctrl->buffer[board], cmd_word);
 }
 
 void dac_cmd_set_cal(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t channel, int16_t cal, bool verbose) {
@@ -265,7 +251,7 @@ void dac_cmd_set_cal(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t channel
     printf("DAC[%d] SET_CAL command word: 0x%08X (channel %d, cal=0x%04X)\n", 
            board, cmd_word, channel, (uint16_t)cal & 0xFFFF);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  hw_write32(dac_ctrl->buffer[board], cmd_word);
 }
 
 void dac_cmd_get_cal(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t channel, bool verbose) {
@@ -285,7 +271,51 @@ void dac_cmd_get_cal(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t channel
     printf("DAC[%d] GET_CAL command word: 0x%08X (channel %d)\n", 
            board, cmd_word, channel);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  hw_write32(dac_ctrl->buffer[board], cmd_word);
+}
+
+void dac_cmd_set_cal_batch(struct dac_ctrl_t *dac_ctrl, uint8_t board, const int16_t cal[8], uint8_t channel_mask, bool verbose) {
+  if (board > 7) {
+    fprintf(stderr, "Invalid DAC board: %d. Must be 0-7.\n", board);
+    return;
+  }
+
+  uint32_t words[8];
+  size_t count = 0;
+  for (int channel = 0; channel < 8; channel++) {
+    if (!(channel_mask & (1u << channel))) continue;
+    words[count++] = (DAC_CMD_SET_CAL << DAC_CMD_CMD_LSB) |
+                     (channel << 16) | // Channel index
+                     ((uint16_t)cal[channel] & 0xFFFF);
+    if (verbose) {
+      printf("DAC[%d] SET_CAL command word: 0x%08X (channel %d, cal=0x%04X)\n", 
+             board, words[count - 1], channel, (uint16_t)cal[channel] & 0xFFFF);
+    }
+  }
+  if (count > 0) {
+    hw_write_burst32(dac_ctrl->buffer[board], words, count);
+  }
+}
+
+void dac_cmd_get_cal_batch(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t channel_mask, bool verbose) {
+  if (board > 7) {
+    fprintf(stderr, "Invalid DAC board: %d. Must be 0-7.\n", board);
+    return;
+  }
+
+  uint32_t words[8];
+  size_t count = 0;
+  for (int channel = 0; channel < 8; channel++) {
+    if (!(channel_mask & (1u << channel))) continue;
+    words[count++] = (DAC_CMD_GET_CAL << DAC_CMD_CMD_LSB) |
+                     (channel << 16); // Channel index
+    if (verbose) {
+      printf("DAC[%d] GET_CAL command word: 0x%08X (channel %d)\n", board, words[count - 1], channel);
+    }
+  }
+  if (count > 0) {
+    hw_write_burst32(dac_ctrl->buffer[board], words, count);
+  }
 }
 
 void dac_cmd_zero(struct dac_ctrl_t *dac_ctrl, uint8_t board, bool verbose) {
@@ -298,7 +328,7 @@ void dac_cmd_zero(struct dac_ctrl_t *dac_ctrl, uint8_t board, bool verbose) {
   if (verbose) {
     printf("DAC[%d] ZERO command word: 0x%08X\n", board, cmd_word);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  hw_write32(dac_ctrl->buffer[board], cmd_word);
 }
 
 void dac_cmd_cancel(struct dac_ctrl_t *dac_ctrl, uint8_t board, bool verbose) {
@@ -311,5 +341,36 @@ void dac_cmd_cancel(struct dac_ctrl_t *dac_ctrl, uint8_t board, bool verbose) {
   if (verbose) {
     printf("DAC[%d] CANCEL command word: 0x%08X\n", board, cmd_word);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  hw_write32(dac_ctrl->buffer[board], cmd_word);
+}
+
+// Command stream functions
+uint32_t dac_encode_cmd(uint8_t cmd, bool trig, bool cont, bool ldac, uint32_t value) {
+  return ((uint32_t)cmd   << DAC_CMD_CMD_LSB ) |
+         ((trig ? 1 : 0) << DAC_CMD_TRIG_BIT) |
+         ((cont ? 1 : 0) << DAC_CMD_CONT_BIT) |
+         ((ldac ? 1 : 0) << DAC_CMD_LDAC_BIT) |
+         (value & 0x1FFFFFF);
+}
+
+void dac_encode_dac_wr(uint32_t words[DAC_WR_WORDCOUNT], const int16_t ch_vals[8], bool trig, bool cont, bool ldac, uint32_t value) {
+  words[0] = dac_encode_cmd(DAC_CMD_DAC_WR, trig, cont, ldac, value);
+  // Each word contains two channels: [31:16] = ch N+1, [15:0] = ch N
+  for (int i = 0; i < 8; i += 2) {
+    words[1 + i / 2] = ((uint32_t)signed_to_offset(ch_vals[i + 1]) << 16) | signed_to_offset(ch_vals[i]);
+  }
+}
+
+uint32_t dac_encode_loop(uint32_t block_words, uint32_t passes) {
+  return ((uint32_t)DAC_CMD_LOOP << DAC_CMD_CMD_LSB) |
+         ((block_words & DAC_LOOP_LEN_MAX) << DAC_LOOP_LEN_LSB) |
+         (passes & DAC_LOOP_PASSES_MAX);
+}
+
+void dac_write_cmd_words(struct dac_ctrl_t *dac_ctrl, uint8_t board, const uint32_t *words, size_t count) {
+  if (board > 7) {
+    fprintf(stderr, "Invalid DAC board: %d. Must be 0-7.\n", board);
+    return;
+  }
+  hw_write_burst32(dac_ctrl->buffer[board], words, count);
 }
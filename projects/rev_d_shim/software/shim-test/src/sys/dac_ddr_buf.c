@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "dac_ddr_buf.h"
+#include "map_memory.h"
+#include "hw_backend.h"
+#include "dac_ctrl.h"
+
+// Create DAC DDR buffer structure
+struct dac_ddr_buf_t create_dac_ddr_buf(struct sys_sts_t *sys_sts, bool verbose) {
+  struct dac_ddr_buf_t ddr_buf;
+
+  // Reading an absent reader's registers is a bus error, so check the design options first
+  ddr_buf.present = (sys_sts_get_design_opts(sys_sts, verbose) >> DESIGN_OPT_DAC_DDR_BUF_BIT) & 1;
+  ddr_buf.mem = NULL;
+  ddr_buf.phys_addr = 0;
+  ddr_buf.size_bytes = 0;
+
+  // Map the reader registers for each board
+  for (int board = 0; board < 8; board++) {
+    ddr_buf.reader[board] = map_32bit_memory(DAC_DDR_READER(board), DAC_DDR_READER_WORDCOUNT, "DAC DDR Reader", verbose);
+    if (ddr_buf.reader[board] == NULL) {
+      fprintf(stderr, "Failed to map DAC DDR reader registers for board %d\n", board);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (verbose) printf("DAC DDR buffer readers %s\n", ddr_buf.present ? "present" : "not in this design");
+  return ddr_buf;
+}
+
+// Map the DMA buffer on first use
+static int dac_ddr_buf_map(struct dac_ddr_buf_t *ddr_buf, bool verbose) {
+  if (ddr_buf->mem != NULL) return 0;
+  ddr_buf->mem = map_dma_buffer(DAC_DDR_BUF_NAME, DAC_DDR_BUF_SIM_BYTES, &ddr_buf->phys_addr, &ddr_buf->size_bytes, verbose);
+  return ddr_buf->mem != NULL ? 0 : -1;
+}
+
+// Bytes of the buffer given to each board
+static size_t dac_ddr_buf_slice_bytes(const struct dac_ddr_buf_t *ddr_buf) {
+  return (ddr_buf->size_bytes / 8) & ~(size_t)(DAC_DDR_BUF_ALIGN - 1);
+}
+
+// Check that the readers exist and the board is valid
+static int dac_ddr_buf_check(struct dac_ddr_buf_t *ddr_buf, uint8_t board) {
+  if (!ddr_buf->present) {
+    fprintf(stderr, "DAC DDR buffers are not in this design (build with dac_cmd_ddr_buffer set)\n");
+    return -1;
+  }
+  if (board > 7) {
+    fprintf(stderr, "Invalid DAC board: %d. Must be 0-7.\n", board);
+    return -1;
+  }
+  return 0;
+}
+
+// Most command words one board's slice can hold (a full circular buffer would look empty)
+size_t dac_ddr_buf_max_words(struct dac_ddr_buf_t *ddr_buf, bool verbose) {
+  if (dac_ddr_buf_map(ddr_buf, verbose) != 0) return 0;
+  size_t slice = dac_ddr_buf_slice_bytes(ddr_buf);
+  return slice >= sizeof(uint32_t) ? slice / sizeof(uint32_t) - 1 : 0;
+}
+
+// Upload a command stream and arm the board's reader
+int dac_ddr_buf_upload(struct dac_ddr_buf_t *ddr_buf, uint8_t board, const uint32_t *words, size_t count, bool verbose) {
+  if (dac_ddr_buf_check(ddr_buf, board) != 0) return -1;
+  size_t max_words = dac_ddr_buf_max_words(ddr_buf, verbose);
+  if (count == 0 || count > max_words) {
+    fprintf(stderr, "DAC DDR upload of %zu words doesn't fit board %d's buffer (1 to %zu words)\n", count, board, max_words);
+    return -1;
+  }
+  volatile uint32_t *regs = ddr_buf->reader[board];
+  uint32_t sts = hw_read32(regs + DAC_DDR_STATUS_OFFSET);
+  if (DAC_DDR_STS_ENABLED(sts) || DAC_DDR_STS_BUSY(sts)) {
+    fprintf(stderr, "DAC DDR reader for board %d is running. Stop it before uploading.\n", board);
+    return -1;
+  }
+
+  // Fill the board's slice (the mapping is uncached, so the words are in DDR once the barrier passes)
+  size_t slice = dac_ddr_buf_slice_bytes(ddr_buf);
+  size_t offset = (size_t)board * slice;
+  volatile uint32_t *dst = ddr_buf->mem + offset / sizeof(uint32_t);
+  for (size_t i = 0; i < count; i++) dst[i] = words[i];
+  __sync_synchronize();
+
+  // Point the reader at the slice and restart it from the beginning
+  hw_write32(regs + DAC_DDR_BASE_OFFSET, ddr_buf->phys_addr + (uint32_t)offset);
+  hw_write32(regs + DAC_DDR_SIZE_OFFSET, (uint32_t)slice);
+  hw_write32(regs + DAC_DDR_CTRL_OFFSET, DAC_DDR_CTRL_CLEAR);
+  hw_write32(regs + DAC_DDR_WR_PTR_OFFSET, (uint32_t)(count * sizeof(uint32_t)));
+
+  if (verbose) {
+    printf("Uploaded %zu words to DAC DDR buffer for board %d at 0x%08" PRIx32 "\n", count, board,
+           ddr_buf->phys_addr + (uint32_t)offset);
+  }
+  return 0;
+}
+
+// Enable a board's reader
+int dac_ddr_buf_start(struct dac_ddr_buf_t *ddr_buf, uint8_t board, bool verbose) {
+  if (dac_ddr_buf_check(ddr_buf, board) != 0) return -1;
+  volatile uint32_t *regs = ddr_buf->reader[board];
+  if (DAC_DDR_STS_RD_ERROR(hw_read32(regs + DAC_DDR_STATUS_OFFSET))) {
+    fprintf(stderr, "DAC DDR reader for board %d has a read error. Upload again to clear it.\n", board);
+    return -1;
+  }
+  hw_write32(regs + DAC_DDR_CTRL_OFFSET, DAC_DDR_CTRL_ENABLE);
+  if (verbose) printf("Enabled DAC DDR reader for board %d\n", board);
+  return 0;
+}
+
+// End a board's playback early at a command boundary
+int dac_ddr_buf_end_early(struct dac_ddr_buf_t *ddr_buf, uint8_t board, bool verbose) {
+  if (dac_ddr_buf_check(ddr_buf, board) != 0) return -1;
+  volatile uint32_t *regs = ddr_buf->reader[board];
+  if (!DAC_DDR_STS_ENABLED(hw_read32(regs + DAC_DDR_STATUS_OFFSET))) {
+    fprintf(stderr, "DAC DDR reader for board %d is not running\n", board);
+    return -1;
+  }
+  uint32_t base = hw_read32(regs + DAC_DDR_BASE_OFFSET);
+  uint32_t wr_ptr = hw_read32(regs + DAC_DDR_WR_PTR_OFFSET);
+  uint32_t rd_ptr = hw_read32(regs + DAC_DDR_RD_PTR_OFFSET);
+  volatile uint32_t *stream = map_memory_dma_ptr(base, wr_ptr);
+  if (stream == NULL || rd_ptr > wr_ptr) {
+    // Only streams laid out by dac_ddr_buf_upload (starting at the base, never wrapped) can be walked
+    fprintf(stderr, "DAC DDR buffer for board %d wasn't uploaded by this program; can't find a command boundary\n", board);
+    return -1;
+  }
+
+  // Walk the commands from the start of the stream to the first boundary past the margin
+  size_t end = wr_ptr / sizeof(uint32_t);
+  size_t min_index = rd_ptr / sizeof(uint32_t) + DAC_DDR_END_MARGIN_WORDS;
+  uint32_t block_left = 0;
+  size_t i = 0;
+  while (i < end) {
+    uint32_t word = stream[i];
+    uint32_t cmd = (word >> DAC_CMD_CMD_LSB) & 0x7;
+    if (cmd == DAC_CMD_LOOP) {
+      block_left = (word >> DAC_LOOP_LEN_LSB) & DAC_LOOP_LEN_MAX;
+      i++;
+      continue;
+    }
+    uint32_t len = (cmd == DAC_CMD_DAC_WR) ? DAC_WR_WORDCOUNT : 1;
+    bool in_block = block_left > 0;
+    block_left = block_left > len ? block_left - len : 0;
+    if (!in_block && i >= min_index && i + len < end) break;
+    i += len;
+  }
+  if (i >= end) {
+    if (verbose) printf("DAC DDR playback for board %d is too close to its end to cut short\n", board);
+    return 1;
+  }
+
+  // The reader fetches at most one burst ahead of its read pointer, so the patch is safe if it is still behind
+  stream[i] = stream[i] & ~(1u << DAC_CMD_CONT_BIT);
+  __sync_synchronize();
+  uint32_t len = (((stream[i] >> DAC_CMD_CMD_LSB) & 0x7) == DAC_CMD_DAC_WR) ? DAC_WR_WORDCOUNT : 1;
+  hw_write32(regs + DAC_DDR_WR_PTR_OFFSET, (uint32_t)((i + len) * sizeof(uint32_t)));
+  rd_ptr = hw_read32(regs + DAC_DDR_RD_PTR_OFFSET);
+  if (rd_ptr / sizeof(uint32_t) + DAC_DDR_BUF_ALIGN / sizeof(uint32_t) > i) {
+    fprintf(stderr, "DAC DDR reader for board %d overtook the early end; playback may underflow\n", board);
+    return -1;
+  }
+  if (verbose) {
+    printf("DAC DDR playback for board %d ends after word %zu (%zu words were left)\n", board, i + len, end - i - len);
+  }
+  return 0;
+}
+
+// Disable a board's reader and wait for any burst in flight
+int dac_ddr_buf_stop(struct dac_ddr_buf_t *ddr_buf, uint8_t board, bool verbose) {
+  if (dac_ddr_buf_check(ddr_buf, board) != 0) return -1;
+  volatile uint32_t *regs = ddr_buf->reader[board];
+  hw_write32(regs + DAC_DDR_CTRL_OFFSET, 0);
+  // A burst is at most 16 beats, so this only takes more than one poll if the FIFO is stalled
+  for (int i = 0; i < 1000; i++) {
+    if (!DAC_DDR_STS_BUSY(hw_read32(regs + DAC_DDR_STATUS_OFFSET))) {
+      if (verbose) printf("Disabled DAC DDR reader for board %d\n", board);
+      return 0;
+    }
+    usleep(100);
+  }
+  fprintf(stderr, "DAC DDR reader for board %d is still busy after being disabled\n", board);
+  return -1;
+}
+
+// Read a board's reader status word
+uint32_t dac_ddr_buf_status(struct dac_ddr_buf_t *ddr_buf, uint8_t board) {
+  if (dac_ddr_buf_check(ddr_buf, board) != 0) return 0;
+  return hw_read32(ddr_buf->reader[board] + DAC_DDR_STATUS_OFFSET);
+}
+
+// Print a board's reader registers
+void print_dac_ddr_buf_status(struct dac_ddr_buf_t *ddr_buf, uint8_t board) {
+  if (dac_ddr_buf_check(ddr_buf, board) != 0) return;
+  volatile uint32_t *regs = ddr_buf->reader[board];
+  uint32_t sts = hw_read32(regs + DAC_DDR_STATUS_OFFSET);
+  uint32_t base = hw_read32(regs + DAC_DDR_BASE_OFFSET);
+  uint32_t size = hw_read32(regs + DAC_DDR_SIZE_OFFSET);
+  uint32_t wr_ptr = hw_read32(regs + DAC_DDR_WR_PTR_OFFSET);
+  uint32_t rd_ptr = hw_read32(regs + DAC_DDR_RD_PTR_OFFSET);
+  uint32_t words_fed = hw_read32(regs + DAC_DDR_WORDS_FED_OFFSET);
+
+  printf("DAC DDR reader for board %d:\n", board);
+  printf("  Enabled: %s  Busy: %s  Read error: %s  Empty: %s\n",
+         DAC_DDR_STS_ENABLED(sts) ? "yes" : "no", DAC_DDR_STS_BUSY(sts) ? "yes" : "no",
+         DAC_DDR_STS_RD_ERROR(sts) ? "YES" : "no", DAC_DDR_STS_EMPTY(sts) ? "yes" : "no");
+  printf("  Buffer: 0x%08" PRIx32 " (%" PRIu32 " bytes)\n", base, size);
+  printf("  Read pointer: %" PRIu32 " / write pointer: %" PRIu32 " bytes\n", rd_ptr, wr_ptr);
+  printf("  Words fed to the command FIFO: %" PRIu32 "\n", words_fed);
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include "hw_backend.h"
+
+const hw_backend_ops_t *g_hw_backend = NULL;
+
+// Install a backend (NULL restores direct access)
+void hw_backend_install(const hw_backend_ops_t *ops) {
+  g_hw_backend = ops;
+}
+
+// Name of the active backend
+const char *hw_backend_name(void) {
+  return g_hw_backend != NULL ? g_hw_backend->name : "mmio";
+}
+
+#if defined(__arm__)
+// Load the words into a register list and store them with one STM (an INCR burst from reg).
+// r7 is skipped since it may be the Thumb frame pointer.
+#define HW_STM_BURST(reg_list, ...) \
+  __asm__ volatile("ldmia %1, {" reg_list "}\n\tstmia %0, {" reg_list "}" \
+                   : : "r"(reg), "r"(words) : __VA_ARGS__, "memory")
+#endif
+
+// Push words into a FIFO with multi-word stores
+void hw_write_burst32(volatile uint32_t *reg, const uint32_t *words, size_t count) {
+  if (__builtin_expect(g_hw_trace_enabled, 0)) {
+    for (size_t i = 0; i < count; i++) {
+      hw_trace_record_slow(HW_TRACE_WRITE, reg + i % HW_BURST_MAX_WORDS, words[i]);
+    }
+  }
+
+  if (g_hw_backend != NULL) {
+    uint32_t phys_addr = map_memory_phys_addr(reg);
+    for (size_t i = 0; i < count; i++) {
+      g_hw_backend->write32(phys_addr + 4 * (uint32_t)(i % HW_BURST_MAX_WORDS), words[i]);
+    }
+    return;
+  }
+
+  while (count > 0) {
+    size_t n = count < HW_BURST_MAX_WORDS ? count : HW_BURST_MAX_WORDS;
+#if defined(__arm__)
+    switch (n) {
+      case 1: *reg = words[0]; break;
+      case 2: HW_STM_BURST("r4, r5", "r4", "r5"); break;
+      case 3: HW_STM_BURST("r4, r5, r6", "r4", "r5", "r6"); break;
+      case 4: HW_STM_BURST("r4, r5, r6, r8", "r4", "r5", "r6", "r8"); break;
+      case 5: HW_STM_BURST("r4, r5, r6, r8, r9", "r4", "r5", "r6", "r8", "r9"); break;
+      default: HW_STM_BURST("r4, r5, r6, r8, r9, r10", "r4", "r5", "r6", "r8", "r9", "r10"); break;
+    }
+#else
+    for (size_t i = 0; i < n; i++) reg[i] = words[i];
+#endif
+    words += n;
+    count -= n;
+  }
+}
@@ -0,0 +1,138 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "hw_cosim.h"
+#include "hw_backend.h"
+#include "map_memory.h"
+
+static hw_cosim_mailbox_t *g_cosim_mailbox = NULL;
+static pthread_mutex_t g_cosim_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool g_cosim_warned_decerr = false;
+
+// Check whether a process still exists
+static bool cosim_pid_alive(uint32_t pid) {
+  return pid != 0 && (kill((pid_t)pid, 0) == 0 || errno != ESRCH);
+}
+
+// Release the mailbox for the next client
+static void cosim_detach(void) {
+  if (g_cosim_mailbox != NULL) {
+    __sync_bool_compare_and_swap(&g_cosim_mailbox->client_pid, (uint32_t)getpid(), 0);
+  }
+}
+
+// Run one request on the model and wait for the harness to finish it
+static uint32_t cosim_request(uint32_t op, uint32_t phys_addr, uint32_t value) {
+  hw_cosim_mailbox_t *mb = g_cosim_mailbox;
+  pthread_mutex_lock(&g_cosim_lock);
+
+  mb->op = op;
+  mb->addr = phys_addr;
+  mb->data = value;
+  uint32_t seq = mb->req_seq + 1;
+  __atomic_store_n(&mb->req_seq, seq, __ATOMIC_RELEASE);
+
+  // Spin briefly (an access takes a few model cycles), then yield between polls
+  uint32_t polls = 0;
+  while (__atomic_load_n(&mb->ack_seq, __ATOMIC_ACQUIRE) != seq) {
+    if (++polls < HW_COSIM_SPIN_POLLS) continue;
+    if ((polls & 0xFFFF) == 0 && !cosim_pid_alive(mb->harness_pid)) {
+      fprintf(stderr, "Co-simulation harness (pid %" PRIu32 ") exited during an access to 0x%08" PRIx32 "\n",
+              mb->harness_pid, phys_addr);
+      exit(EXIT_FAILURE);
+    }
+    sched_yield();
+  }
+
+  uint32_t result = mb->data;
+  if (mb->resp == HW_COSIM_RESP_DECERR && !g_cosim_warned_decerr) {
+    fprintf(stderr, "Co-simulation model has nothing at 0x%08" PRIx32 " (further misses not reported)\n", phys_addr);
+    g_cosim_warned_decerr = true;
+  }
+  pthread_mutex_unlock(&g_cosim_lock);
+  return result;
+}
+
+static uint32_t cosim_read32(uint32_t phys_addr) {
+  return cosim_request(HW_COSIM_OP_READ, phys_addr, 0);
+}
+
+static void cosim_write32(uint32_t phys_addr, uint32_t value) {
+  cosim_request(HW_COSIM_OP_WRITE, phys_addr, value);
+}
+
+static const hw_backend_ops_t g_hw_cosim_ops = {
+  .name = "cosim",
+  .read32 = cosim_read32,
+  .write32 = cosim_write32,
+};
+
+// Attach to a running harness and install the co-simulation backend
+int hw_cosim_install(const char *shm_name, bool verbose) {
+  int fd = shm_open(shm_name, O_RDWR, 0);
+  if (fd < 0) {
+    fprintf(stderr, "Failed to open co-simulation mailbox '%s': %s (is shim-cosim running?)\n", shm_name, strerror(errno));
+    return -1;
+  }
+  void *mem = mmap(NULL, sizeof(hw_cosim_mailbox_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) {
+    fprintf(stderr, "Failed to map co-simulation mailbox '%s': %s\n", shm_name, strerror(errno));
+    return -1;
+  }
+  hw_cosim_mailbox_t *mb = (hw_cosim_mailbox_t *)mem;
+
+  if (mb->magic != HW_COSIM_MAGIC || mb->version != HW_COSIM_VERSION) {
+    fprintf(stderr, "Co-simulation mailbox '%s' is not ready or is from another version\n", shm_name);
+    munmap(mem, sizeof(hw_cosim_mailbox_t));
+    return -1;
+  }
+  if (!cosim_pid_alive(mb->harness_pid)) {
+    fprintf(stderr, "Co-simulation harness for '%s' is no longer running\n", shm_name);
+    munmap(mem, sizeof(hw_cosim_mailbox_t));
+    return -1;
+  }
+
+  // One client at a time (a crashed client's claim is taken over)
+  uint32_t owner = mb->client_pid;
+  if (owner != 0 && cosim_pid_alive(owner)) {
+    fprintf(stderr, "Co-simulation harness for '%s' is in use by pid %" PRIu32 "\n", shm_name, owner);
+    munmap(mem, sizeof(hw_cosim_mailbox_t));
+    return -1;
+  }
+  if (!__sync_bool_compare_and_swap(&mb->client_pid, owner, (uint32_t)getpid())) {
+    fprintf(stderr, "Co-simulation harness for '%s' was claimed by another client\n", shm_name);
+    munmap(mem, sizeof(hw_cosim_mailbox_t));
+    return -1;
+  }
+  // Pick up after any request a previous client left unfinished
+  while (__atomic_load_n(&mb->ack_seq, __ATOMIC_ACQUIRE) != mb->req_seq) sched_yield();
+
+  g_cosim_mailbox = mb;
+  atexit(cosim_detach);
+  if (verbose) {
+    printf("Attached to co-simulation harness '%s' (pid %" PRIu32 ", %" PRIu32 " boards, %" PRIu32 " Hz SPI clock)\n",
+           shm_name, mb->harness_pid, mb->board_count, mb->spi_clk_freq_hz);
+  }
+
+  map_memory_set_backend(MAP_BACKEND_SIM);
+  hw_backend_install(&g_hw_cosim_ops);
+  return 0;
+}
+
+// Model time of the last completed access in SPI clock cycles
+uint64_t hw_cosim_now_cycles(void) {
+  if (g_cosim_mailbox == NULL) return 0;
+  pthread_mutex_lock(&g_cosim_lock);
+  uint64_t cycles = g_cosim_mailbox->spi_clk_cycles;
+  pthread_mutex_unlock(&g_cosim_lock);
+  return cycles;
+}
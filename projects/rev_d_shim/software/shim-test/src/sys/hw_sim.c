@@ -0,0 +1,1128 @@
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hw_sim.h"
+#include "hw_backend.h"
+#include "map_memory.h"
+#include "sys_ctrl.h"
+#include "sys_sts.h"
+#include "dac_ctrl.h"
+#include "adc_ctrl.h"
+#include "trigger_ctrl.h"
+#include "dac_ddr_buf.h"
+#include "spi_timing.h"
+
+#define SIM_NEVER                UINT64_MAX
+#define SIM_DAC_ABS_CAL_MAX      4096     // ABS_CAL_MAX in shim_ad5676_dac_ctrl
+#define SIM_TRIG_LOCKOUT_DEFAULT 10000000 // TRIGGER_LOCKOUT_DEFAULT in shim_trigger_core
+#define SIM_TRIG_LOCKOUT_MIN     4        // TRIGGER_LOCKOUT_MIN in shim_trigger_core
+#define SIM_TRIG_RESYNC_INTERVAL 256      // DELTA_RESYNC_INTERVAL in shim_trigger_core
+
+// Synchronous FIFO model
+typedef struct {
+  uint32_t *words;
+  uint32_t depth;
+  uint32_t head;
+  uint32_t count;
+  uint64_t last_push; // Time of the most recent write
+} sim_fifo_t;
+
+// Command core states (shared by the DAC and ADC models)
+typedef enum {
+  SIM_CORE_IDLE,      // Waiting for the next command
+  SIM_CORE_BUSY,      // SPI transfer and/or delay in progress
+  SIM_CORE_TRIG_WAIT, // Waiting for triggers
+  SIM_CORE_ERROR      // Halted by a fault
+} sim_core_state_t;
+
+// DDR reader feeding a DAC command FIFO (axi_ddr_fifo_reader)
+typedef struct {
+  int board;
+  bool enable;
+  bool rd_error;
+  uint32_t base;
+  uint32_t size;
+  uint32_t wr_ptr;
+  uint32_t rd_ptr;
+  uint32_t words_fed;
+} sim_ddr_reader_t;
+
+// DAC or ADC command core
+typedef struct {
+  sim_fifo_t cmd;
+  sim_fifo_t data;
+  sim_core_state_t state;
+  uint64_t t;              // Time the current state was entered (idle: time of last evaluation)
+  uint64_t xfer_end;       // End of the SPI transfer of the current command (SIM_NEVER once applied)
+  uint64_t busy_until;     // End of the SIM_CORE_BUSY state
+  uint32_t wait_trigs;     // Triggers to wait for once the transfer is done
+  uint32_t trig_remaining; // Triggers left in SIM_CORE_TRIG_WAIT
+  bool expect_next;        // Current command has CONTINUE set
+  uint32_t cur_cmd;        // Current command word
+  uint32_t xfer_words[4];  // DAC_WR data words (DAC), or ADC_RD_CH channel / ADC_RD averaging (ADC)
+  int16_t cal[8];          // DAC calibration values
+  int16_t out[8];          // Calibrated DAC outputs
+  uint8_t order[8];        // ADC sample order
+  uint8_t avg_log2;        // ADC averaging (log2 of reads per channel)
+  uint32_t frame_len;      // ADC data words per frame (0 = framing off)
+  uint32_t frame_count;    // Data words so far in the current frame
+  uint32_t frame_drops;    // Data words dropped so far in the current frame
+  uint16_t frame_seq;      // Current frame's sequence number
+  bool marker_pending;     // Frame marker waiting for room in the data FIFO
+  uint32_t marker_word;
+  uint32_t repeat_left;    // ADC repeats left of cur_cmd
+  uint32_t loop_mem[DAC_LOOP_WORDCOUNT]; // Loop buffer (same depth in both cores)
+  uint32_t loop_len;       // Words in the active loop block (0 if none)
+  uint32_t loop_ptr;       // Next word of the block
+  uint32_t loop_passes_left; // Replay passes left, counting the current one
+  bool loop_forever;       // Replay until cancelled
+  bool loop_replay;        // Commands come from loop_mem (false while the first pass is captured)
+  sim_ddr_reader_t *ddr;   // DDR reader refilling the command FIFO (NULL if none)
+} sim_core_t;
+
+// Trigger core states
+typedef enum {
+  SIM_TRIG_IDLE,
+  SIM_TRIG_DELAY,
+  SIM_TRIG_SYNC,
+  SIM_TRIG_EXPECT,
+  SIM_TRIG_ERROR
+} sim_trig_state_t;
+
+// Trigger core
+typedef struct {
+  sim_fifo_t cmd;
+  sim_fifo_t data;
+  sim_trig_state_t state;
+  uint64_t t;
+  uint64_t busy_until;
+  uint32_t ext_remaining;
+  uint32_t lockout;
+  uint64_t lockout_until;
+  bool log;
+  uint32_t counter;
+  uint64_t timer_start; // Time of the first logged trigger (0 when not started)
+  bool delta_mode;      // Delta log format (bit 0 of the last RESET_COUNT value)
+  bool delta_synced;    // Full timestamp logged since the last RESET_COUNT
+  uint32_t delta_count; // Deltas logged since the last full timestamp
+  uint64_t last_log;    // Timestamp of the last logged trigger
+} sim_trig_t;
+
+// Whole simulator
+typedef struct {
+  hw_sim_config_t config;
+  pthread_mutex_t lock;
+  struct timespec start;
+  struct spi_timing_t timing; // ~CS high times and command durations at the SPI clock
+  uint64_t startup_cycles;
+  uint64_t grace_cycles;
+  uint32_t ctrl_regs[SYS_CTRL_WORDCOUNT];
+  uint32_t hw_state;
+  uint32_t hw_code;
+  uint32_t hw_board;
+  uint64_t running_at;       // Time the pending startup reaches S_RUNNING
+  unsigned int noise_seed;
+  sim_core_t dac[8];
+  sim_core_t adc[8];
+  sim_trig_t trig;
+  sim_ddr_reader_t dac_ddr[8];
+} sim_t;
+
+static sim_t g_sim;
+
+//////////////////// FIFOs ////////////////////
+
+static void sim_fifo_init(sim_fifo_t *fifo, uint32_t depth) {
+  fifo->words = calloc(depth, sizeof(uint32_t));
+  if (fifo->words == NULL) {
+    fprintf(stderr, "Failed to allocate simulated FIFO\n");
+    exit(EXIT_FAILURE);
+  }
+  fifo->depth = depth;
+  fifo->head = 0;
+  fifo->count = 0;
+  fifo->last_push = 0;
+}
+
+static bool sim_fifo_push(sim_fifo_t *fifo, uint32_t word) {
+  if (fifo->count >= fifo->depth) return false;
+  fifo->words[(fifo->head + fifo->count) % fifo->depth] = word;
+  fifo->count++;
+  return true;
+}
+
+static uint32_t sim_fifo_peek(const sim_fifo_t *fifo, uint32_t index) {
+  return fifo->words[(fifo->head + index) % fifo->depth];
+}
+
+static uint32_t sim_fifo_pop(sim_fifo_t *fifo) {
+  uint32_t word = fifo->words[fifo->head];
+  fifo->head = (fifo->head + 1) % fifo->depth;
+  fifo->count--;
+  return word;
+}
+
+static void sim_fifo_clear(sim_fifo_t *fifo) {
+  fifo->head = 0;
+  fifo->count = 0;
+}
+
+// FIFO status word as reported in the status register
+static uint32_t sim_fifo_status(const sim_fifo_t *fifo, bool present) {
+  if (!present) return 0;
+  return (fifo->count & 0x7FFFFFF) |
+         ((uint32_t)(fifo->count >= fifo->depth) << 27) |
+         ((uint32_t)(fifo->count + 1 >= fifo->depth) << 28) |
+         ((uint32_t)(fifo->count == 0) << 29) |
+         ((uint32_t)(fifo->count <= 1) << 30) |
+         (1u << 31);
+}
+
+//////////////////// Timing ////////////////////
+
+static uint64_t sim_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double elapsed_s = (double)(now.tv_sec - g_sim.start.tv_sec) + (double)(now.tv_nsec - g_sim.start.tv_nsec) / 1e9;
+  return (uint64_t)(elapsed_s * g_sim.config.time_scale * g_sim.config.spi_clk_freq_hz);
+}
+
+static bool sim_board_present(int board) {
+  return (g_sim.config.board_mask >> board) & 1;
+}
+
+//////////////////// Hardware manager ////////////////////
+
+// Halt the system with a fault code (only the first fault is kept)
+static void sim_fault(uint32_t code, int board) {
+  if (g_sim.hw_state != S_RUNNING) return;
+  g_sim.hw_state = S_HALTED;
+  g_sim.hw_code = code;
+  g_sim.hw_board = (uint32_t)board & 0x7;
+  for (int b = 0; b < 8; b++) {
+    g_sim.dac[b].state = SIM_CORE_ERROR;
+    g_sim.adc[b].state = SIM_CORE_ERROR;
+  }
+  g_sim.trig.state = SIM_TRIG_ERROR;
+}
+
+// Return a core to its reset state (FIFO contents are kept)
+static void sim_core_reset(sim_core_t *core, uint64_t now) {
+  core->state = SIM_CORE_IDLE;
+  core->t = now;
+  core->xfer_end = SIM_NEVER;
+  core->busy_until = 0;
+  core->wait_trigs = 0;
+  core->trig_remaining = 0;
+  core->expect_next = false;
+  core->repeat_left = 0;
+  core->loop_len = 0;
+  core->loop_replay = false;
+  for (int ch = 0; ch < 8; ch++) {
+    core->cal[ch] = 0;
+    core->out[ch] = 0;
+    core->order[ch] = (uint8_t)ch;
+  }
+  core->avg_log2 = 0;
+  core->frame_len = 0;
+  core->marker_pending = false;
+}
+
+static void sim_trig_reset(uint64_t now) {
+  sim_trig_t *trig = &g_sim.trig;
+  trig->state = SIM_TRIG_IDLE;
+  trig->t = now;
+  trig->busy_until = 0;
+  trig->ext_remaining = 0;
+  trig->lockout = SIM_TRIG_LOCKOUT_DEFAULT;
+  trig->lockout_until = 0;
+  trig->log = false;
+  trig->counter = 0;
+  trig->timer_start = 0;
+  trig->delta_mode = false;
+  trig->delta_synced = false;
+  trig->delta_count = 0;
+  trig->last_log = 0;
+}
+
+static void sim_set_enable(uint32_t value, uint64_t now) {
+  if (value & 1) {
+    if (g_sim.hw_state == S_IDLE) {
+      g_sim.hw_state = S_AMP_POWER_WAIT;
+      g_sim.hw_code = STS_OK;
+      g_sim.running_at = now + g_sim.startup_cycles;
+    }
+  } else if (g_sim.hw_state != S_IDLE) {
+    g_sim.hw_state = S_IDLE;
+    g_sim.hw_code = STS_PS_SHUTDOWN;
+    g_sim.hw_board = 0;
+  }
+}
+
+// Apply the buffer reset registers (held FIFOs stay empty)
+static void sim_apply_buf_resets(void) {
+  uint32_t cmd_mask = g_sim.ctrl_regs[CMD_BUF_RESET_OFFSET];
+  uint32_t data_mask = g_sim.ctrl_regs[DATA_BUF_RESET_OFFSET];
+  for (int b = 0; b < 8; b++) {
+    if (cmd_mask & (1u << (2 * b))) sim_fifo_clear(&g_sim.dac[b].cmd);
+    if (cmd_mask & (1u << (2 * b + 1))) sim_fifo_clear(&g_sim.adc[b].cmd);
+    if (data_mask & (1u << (2 * b))) sim_fifo_clear(&g_sim.dac[b].data);
+    if (data_mask & (1u << (2 * b + 1))) sim_fifo_clear(&g_sim.adc[b].data);
+  }
+  if (cmd_mask & (1u << 16)) sim_fifo_clear(&g_sim.trig.cmd);
+  if (data_mask & (1u << 16)) sim_fifo_clear(&g_sim.trig.data);
+}
+
+//////////////////// Command source ////////////////////
+// Commands come from the command FIFO, or from the loop buffer while a loop block is replayed
+
+static void sim_loop_clear(sim_core_t *core) {
+  core->loop_len = 0;
+  core->loop_replay = false;
+}
+
+// Start capturing a loop block from a LOOP command word. Returns false for a bad LOOP.
+static bool sim_loop_start(sim_core_t *core, uint32_t word) {
+  uint32_t len = (word >> DAC_LOOP_LEN_LSB) & DAC_LOOP_LEN_MAX;
+  uint32_t passes = word & DAC_LOOP_PASSES_MAX;
+  if (core->loop_len > 0 || len == 0 || len > DAC_LOOP_WORDCOUNT) return false;
+  core->loop_len = len;
+  core->loop_ptr = 0;
+  core->loop_forever = (passes == 0);
+  core->loop_passes_left = passes > 0 ? passes - 1 : 0;
+  core->loop_replay = false;
+  return true;
+}
+
+// Refill the command FIFO from the DDR reader. The reader keeps up with any core,
+// so the FIFO is simply topped up whenever the core looks at it.
+static void sim_ddr_feed(sim_core_t *core) {
+  sim_ddr_reader_t *rd = core->ddr;
+  if (rd == NULL || !rd->enable || rd->rd_error) return;
+  if (g_sim.ctrl_regs[CMD_BUF_RESET_OFFSET] & (1u << (2 * rd->board))) return;
+  while (rd->rd_ptr != rd->wr_ptr && core->cmd.count < core->cmd.depth) {
+    volatile uint32_t *word = map_memory_dma_ptr(rd->base + rd->rd_ptr, sizeof(uint32_t));
+    if (word == NULL) {
+      // Outside any DMA buffer: the interconnect would answer with DECERR
+      rd->rd_error = true;
+      rd->enable = false;
+      return;
+    }
+    sim_fifo_push(&core->cmd, *word);
+    rd->words_fed++;
+    rd->rd_ptr += sizeof(uint32_t);
+    if (rd->rd_ptr >= rd->size) rd->rd_ptr = 0;
+  }
+}
+
+// Words available to the core
+static uint32_t sim_src_count(sim_core_t *core) {
+  sim_ddr_feed(core);
+  if (!core->loop_replay) return core->cmd.count;
+  if (core->loop_forever || core->loop_passes_left > 1) return UINT32_MAX;
+  return core->loop_len - core->loop_ptr + core->cmd.count;
+}
+
+static uint32_t sim_src_peek(const sim_core_t *core) {
+  return core->loop_replay ? core->loop_mem[core->loop_ptr] : sim_fifo_peek(&core->cmd, 0);
+}
+
+static uint32_t sim_src_pop(sim_core_t *core) {
+  sim_ddr_feed(core);
+  if (core->loop_len == 0) return sim_fifo_pop(&core->cmd);
+  uint32_t word;
+  if (core->loop_replay) {
+    word = core->loop_mem[core->loop_ptr];
+  } else {
+    word = sim_fifo_pop(&core->cmd);
+    core->loop_mem[core->loop_ptr] = word;
+  }
+  if (++core->loop_ptr == core->loop_len) {
+    core->loop_ptr = 0;
+    if (core->loop_replay && !core->loop_forever) core->loop_passes_left--;
+    if (core->loop_forever || core->loop_passes_left > 0) core->loop_replay = true;
+    else sim_loop_clear(core);
+  }
+  return word;
+}
+
+// A CANCEL waiting in the FIFO breaks out of a replay at the next command
+static void sim_src_check_break(sim_core_t *core) {
+  sim_ddr_feed(core);
+  if (core->loop_replay && core->cmd.count > 0 &&
+      ((sim_fifo_peek(&core->cmd, 0) >> DAC_CMD_CMD_LSB) & 0x7) == DAC_CMD_CANCEL) {
+    sim_loop_clear(core);
+  }
+}
+
+//////////////////// DAC core ////////////////////
+
+// Load a DAC channel from an offset-format value, applying calibration
+static void sim_dac_load(sim_core_t *dac, int board, int ch, uint16_t raw) {
+  int32_t value = (int32_t)offset_to_signed(raw) + dac->cal[ch];
+  if (raw == 0 || value < -32767 || value > 32767) {
+    sim_fault(STS_DAC_VAL_OOB, board);
+    return;
+  }
+  dac->out[ch] = (int16_t)value;
+}
+
+static void sim_dac_push_data(sim_core_t *dac, int board, uint32_t word) {
+  if (!sim_fifo_push(&dac->data, word)) {
+    sim_fault(STS_DAC_DATA_BUF_OVERFLOW, board);
+  }
+}
+
+// Start the command at the head of the DAC command FIFO at dac->t.
+// Returns false if the command is still waiting for its data words.
+static bool sim_dac_start(sim_core_t *dac, int board, uint64_t limit) {
+  sim_src_check_break(dac);
+  uint32_t word = sim_src_peek(dac);
+  uint32_t cmd = (word >> DAC_CMD_CMD_LSB) & 0x7;
+  bool trig = (word >> DAC_CMD_TRIG_BIT) & 1;
+  bool cont = (word >> DAC_CMD_CONT_BIT) & 1;
+  uint32_t value = word & 0x1FFFFFF;
+  uint8_t ch = (word >> 16) & 0x7;
+  uint64_t t = dac->t;
+
+  if (cmd == DAC_CMD_DAC_WR && sim_src_count(dac) < DAC_WR_WORDCOUNT) {
+    // Data words written right after the command word belong to the same burst
+    if (limit < dac->cmd.last_push + g_sim.grace_cycles) return false;
+    sim_fault(STS_DAC_CMD_BUF_UNDERFLOW, board);
+    return false;
+  }
+
+  sim_src_pop(dac);
+  dac->cur_cmd = word;
+  dac->expect_next = false;
+  dac->wait_trigs = 0;
+  dac->xfer_end = SIM_NEVER;
+  dac->state = SIM_CORE_BUSY;
+  dac->busy_until = t + 1;
+
+  switch (cmd) {
+    case DAC_CMD_NO_OP:
+      dac->expect_next = cont;
+      if (trig) dac->wait_trigs = value;
+      else dac->busy_until = t + (value > 0 ? value : 1);
+      break;
+    case DAC_CMD_DAC_WR: {
+      for (int i = 0; i < 4; i++) dac->xfer_words[i] = sim_src_pop(dac);
+      uint64_t write_cycles = g_sim.timing.dac_wr_min_delay;
+      dac->xfer_end = t + write_cycles;
+      dac->expect_next = cont;
+      if (trig) {
+        dac->wait_trigs = value;
+        dac->busy_until = dac->xfer_end;
+      } else if (value < write_cycles) {
+        sim_fault(STS_DAC_DELAY_TOO_SHORT, board);
+      } else {
+        dac->busy_until = t + value;
+      }
+      break;
+    }
+    case DAC_CMD_DAC_WR_CH:
+      dac->xfer_words[0] = word;
+      dac->xfer_end = t + g_sim.timing.dac_wr_ch_cycles;
+      dac->busy_until = dac->xfer_end;
+      break;
+    case DAC_CMD_SET_CAL: {
+      int16_t cal = (int16_t)(word & 0xFFFF);
+      if (cal > SIM_DAC_ABS_CAL_MAX || cal < -SIM_DAC_ABS_CAL_MAX) {
+        sim_fault(STS_DAC_CAL_OOB, board);
+        break;
+      }
+      dac->cal[ch] = cal;
+      break;
+    }
+    case DAC_CMD_GET_CAL:
+      sim_dac_push_data(dac, board, ((uint32_t)DAC_CAL_DATA << 28) | ((uint32_t)ch << 16) | (uint16_t)dac->cal[ch]);
+      break;
+    case DAC_CMD_ZERO:
+      dac->xfer_end = t + g_sim.timing.dac_wr_min_delay;
+      dac->busy_until = dac->xfer_end;
+      break;
+    case DAC_CMD_LOOP:
+      if (!sim_loop_start(dac, word)) sim_fault(STS_BAD_DAC_CMD, board);
+      break;
+    case DAC_CMD_CANCEL:
+      sim_loop_clear(dac);
+      break;
+    default:
+      sim_fault(STS_BAD_DAC_CMD, board);
+      break;
+  }
+  return true;
+}
+
+// Apply the outputs of a finished DAC transfer
+static void sim_dac_finish_xfer(sim_core_t *dac, int board) {
+  uint32_t cmd = (dac->cur_cmd >> DAC_CMD_CMD_LSB) & 0x7;
+  if (cmd == DAC_CMD_DAC_WR) {
+    for (int i = 0; i < 4; i++) {
+      sim_dac_load(dac, board, 2 * i, dac->xfer_words[i] & 0xFFFF);
+      sim_dac_load(dac, board, 2 * i + 1, dac->xfer_words[i] >> 16);
+    }
+  } else if (cmd == DAC_CMD_DAC_WR_CH) {
+    sim_dac_load(dac, board, (dac->xfer_words[0] >> 16) & 0x7, dac->xfer_words[0] & 0xFFFF);
+  } else if (cmd == DAC_CMD_ZERO) {
+    for (int ch = 0; ch < 8; ch++) dac->out[ch] = dac->cal[ch];
+  }
+  dac->xfer_end = SIM_NEVER;
+}
+
+//////////////////// ADC core ////////////////////
+
+// Simulated reading of an ADC channel: the same board's DAC channel looped back
+static uint16_t sim_adc_sample(int board, int ch) {
+  double value = g_sim.dac[board].out[ch] * g_sim.config.loopback_gain + g_sim.config.loopback_offset;
+  if (g_sim.config.noise_lsb > 0) {
+    int span = 2 * g_sim.config.noise_lsb + 1;
+    value += (rand_r(&g_sim.noise_seed) % span) - g_sim.config.noise_lsb;
+  }
+  if (value > 32767) value = 32767;
+  if (value < -32767) value = -32767;
+  return signed_to_offset((int16_t)value);
+}
+
+// Averaged reading of an ADC channel (offset-binary sum shifted down, as the core's accumulators)
+static uint16_t sim_adc_avg_sample(int board, int ch, uint32_t avg_log2) {
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < (1u << avg_log2); i++) sum += sim_adc_sample(board, ch);
+  return (uint16_t)(sum >> avg_log2);
+}
+
+// Push a waiting frame marker if there is room (it goes ahead of any sample)
+static void sim_adc_push_marker(sim_core_t *adc) {
+  if (adc->marker_pending && sim_fifo_push(&adc->data, adc->marker_word)) adc->marker_pending = false;
+}
+
+// Queue a frame marker
+static void sim_adc_set_marker(sim_core_t *adc, int board, uint16_t seq, uint32_t drops) {
+  adc->marker_word = ((uint32_t)ADC_FRAME_MARKER_TAG << 28) | ((uint32_t)board << 25) | (drops << 16) | seq;
+  adc->marker_pending = true;
+  sim_adc_push_marker(adc);
+}
+
+static void sim_adc_push_data(sim_core_t *adc, int board, uint32_t word) {
+  if (adc->frame_len == 0) {
+    if (!sim_fifo_push(&adc->data, word)) sim_fault(STS_ADC_DATA_BUF_OVERFLOW, board);
+    return;
+  }
+  // Framing: a sample that finds the FIFO full is dropped and counted in its frame's marker
+  sim_adc_push_marker(adc);
+  if (!sim_fifo_push(&adc->data, word)) adc->frame_drops++;
+  if (++adc->frame_count == adc->frame_len) {
+    // A marker still waiting means this whole frame was dropped, so its marker is skipped
+    if (!adc->marker_pending) sim_adc_set_marker(adc, board, adc->frame_seq, adc->frame_drops);
+    adc->frame_seq++;
+    adc->frame_count = 0;
+    adc->frame_drops = 0;
+  }
+}
+
+// Execute one pass of an ADC command word at adc->t
+static void sim_adc_exec(sim_core_t *adc, int board, uint32_t word) {
+  uint32_t cmd = (word >> ADC_CMD_CMD_LSB) & 0x7;
+  bool trig = (word >> ADC_CMD_TRIG_BIT) & 1;
+  bool cont = (word >> ADC_CMD_CONT_BIT) & 1;
+  uint32_t value = word & 0x1FFFFFF;
+  uint64_t t = adc->t;
+
+  adc->cur_cmd = word;
+  adc->expect_next = false;
+  adc->wait_trigs = 0;
+  adc->xfer_end = SIM_NEVER;
+  adc->state = SIM_CORE_BUSY;
+  adc->busy_until = t + 1;
+
+  switch (cmd) {
+    case ADC_CMD_NO_OP:
+      adc->expect_next = cont;
+      if (trig) adc->wait_trigs = value;
+      else adc->busy_until = t + (value > 0 ? value : 1);
+      break;
+    case ADC_CMD_SET_ORD:
+      for (int i = 0; i < 8; i++) adc->order[i] = (word >> (3 * i)) & 0x7;
+      break;
+    case ADC_CMD_SET_AVG:
+      if ((word & 0xF) > ADC_AVG_LOG2_MAX) sim_fault(STS_BAD_ADC_CMD, board);
+      else adc->avg_log2 = (uint8_t)(word & 0xF);
+      break;
+    case ADC_CMD_SET_FRAME:
+      if ((word & 0xFFFF) > ADC_FRAME_LEN_MAX) {
+        sim_fault(STS_BAD_ADC_CMD, board);
+        break;
+      }
+      adc->frame_len = word & 0xFFFF;
+      adc->frame_count = 0;
+      adc->frame_drops = 0;
+      adc->frame_seq = 1;
+      adc->marker_pending = false;
+      if (adc->frame_len > 0) sim_adc_set_marker(adc, board, 0, 0);
+      break;
+    case ADC_CMD_ADC_RD: {
+      uint64_t read_cycles = spi_timing_adc_rd_avg_min_delay(&g_sim.timing, adc->avg_log2);
+      adc->xfer_words[0] = adc->avg_log2;
+      adc->xfer_end = t + read_cycles;
+      adc->expect_next = cont;
+      if (trig) {
+        adc->wait_trigs = value;
+        adc->busy_until = adc->xfer_end;
+      } else if (value < read_cycles) {
+        sim_fault(STS_ADC_DELAY_TOO_SHORT, board);
+      } else {
+        adc->busy_until = t + value;
+      }
+      break;
+    }
+    case ADC_CMD_ADC_RD_CH:
+      adc->xfer_words[0] = word & 0x7;
+      adc->xfer_end = t + g_sim.timing.adc_rd_ch_cycles;
+      adc->busy_until = adc->xfer_end;
+      break;
+    case ADC_CMD_LOOP:
+      if (!sim_loop_start(adc, word)) sim_fault(STS_BAD_ADC_CMD, board);
+      break;
+    case ADC_CMD_CANCEL:
+      adc->repeat_left = 0;
+      sim_loop_clear(adc);
+      break;
+    default:
+      sim_fault(STS_BAD_ADC_CMD, board);
+      break;
+  }
+}
+
+// Start the command at the head of the ADC command FIFO at adc->t.
+// Returns false if the command is still waiting for its repeat count.
+static bool sim_adc_start(sim_core_t *adc, int board, uint64_t limit) {
+  sim_src_check_break(adc);
+  uint32_t word = sim_src_peek(adc);
+  uint32_t cmd = (word >> ADC_CMD_CMD_LSB) & 0x7;
+  bool repeat = (cmd == ADC_CMD_ADC_RD || cmd == ADC_CMD_ADC_RD_CH) && ((word >> ADC_CMD_REPEAT_BIT) & 1);
+
+  if (repeat && sim_src_count(adc) < 2) {
+    if (limit < adc->cmd.last_push + g_sim.grace_cycles) return false;
+    sim_fault(STS_ADC_CMD_BUF_UNDERFLOW, board);
+    return false;
+  }
+
+  sim_src_pop(adc);
+  adc->repeat_left = repeat ? sim_src_pop(adc) : 0;
+  sim_adc_exec(adc, board, repeat ? word & ~(1u << ADC_CMD_REPEAT_BIT) : word);
+  return true;
+}
+
+// Push the samples of a finished ADC transfer
+static void sim_adc_finish_xfer(sim_core_t *adc, int board) {
+  uint32_t cmd = (adc->cur_cmd >> ADC_CMD_CMD_LSB) & 0x7;
+  if (cmd == ADC_CMD_ADC_RD) {
+    for (int i = 0; i < 8; i += 2) {
+      uint32_t word = ((uint32_t)sim_adc_avg_sample(board, adc->order[i + 1], adc->xfer_words[0]) << 16) |
+                      sim_adc_avg_sample(board, adc->order[i], adc->xfer_words[0]);
+      sim_adc_push_data(adc, board, word);
+    }
+  } else if (cmd == ADC_CMD_ADC_RD_CH) {
+    sim_adc_push_data(adc, board, sim_adc_sample(board, (int)adc->xfer_words[0]));
+  }
+  adc->xfer_end = SIM_NEVER;
+}
+
+//////////////////// Command core stepping ////////////////////
+
+// A command (including its trigger wait) has completed at time t
+static void sim_core_done(sim_core_t *core, bool is_adc, int board, uint64_t t) {
+  core->state = SIM_CORE_IDLE;
+  core->t = t;
+  if (is_adc && core->repeat_left > 0) {
+    core->repeat_left--;
+    sim_adc_exec(core, board, core->cur_cmd);
+    return;
+  }
+  if (core->expect_next && sim_src_count(core) == 0) {
+    sim_fault(is_adc ? STS_ADC_CMD_BUF_UNDERFLOW : STS_DAC_CMD_BUF_UNDERFLOW, board);
+  }
+}
+
+// Advance a DAC or ADC core through every event up to time limit
+static void sim_core_step(sim_core_t *core, bool is_adc, int board, uint64_t limit) {
+  while (g_sim.hw_state == S_RUNNING) {
+    switch (core->state) {
+      case SIM_CORE_IDLE:
+        if (sim_src_count(core) == 0) {
+          if (core->t < limit) core->t = limit;
+          return;
+        }
+        if (core->t > limit) return;
+        if (!(is_adc ? sim_adc_start(core, board, limit) : sim_dac_start(core, board, limit))) return;
+        break;
+      case SIM_CORE_BUSY:
+        if (core->xfer_end <= limit) {
+          // Bring the same board's DAC up to the sample time so the loopback sees its output then
+          if (is_adc) sim_core_step(&g_sim.dac[board], false, board, core->xfer_end);
+          if (g_sim.hw_state != S_RUNNING) return;
+          if (is_adc) sim_adc_finish_xfer(core, board);
+          else sim_dac_finish_xfer(core, board);
+          if (g_sim.hw_state != S_RUNNING) return;
+        }
+        if (core->busy_until > limit) return;
+        if (core->wait_trigs > 0) {
+          core->state = SIM_CORE_TRIG_WAIT;
+          core->trig_remaining = core->wait_trigs;
+          core->t = core->busy_until;
+        } else {
+          sim_core_done(core, is_adc, board, core->busy_until);
+        }
+        break;
+      case SIM_CORE_TRIG_WAIT:
+      case SIM_CORE_ERROR:
+        return;
+    }
+  }
+}
+
+// CANCEL written to an empty command FIFO ends a delay or trigger wait right away
+static bool sim_core_cancel(sim_core_t *core, bool is_adc, uint64_t now) {
+  if (core->cmd.count != 0) return false;
+  if (core->state == SIM_CORE_BUSY || core->state == SIM_CORE_TRIG_WAIT || (is_adc && core->repeat_left > 0)) {
+    if (core->xfer_end != SIM_NEVER && core->xfer_end > now) return false; // Transfers run to completion
+    core->state = SIM_CORE_IDLE;
+    core->t = now;
+    core->xfer_end = SIM_NEVER;
+    core->repeat_left = 0;
+    core->expect_next = false;
+    sim_loop_clear(core);
+    return true;
+  }
+  return false;
+}
+
+//////////////////// Trigger core ////////////////////
+
+static bool sim_all_waiting(uint64_t *latest) {
+  *latest = 0;
+  for (int b = 0; b < 8; b++) {
+    if (!sim_board_present(b)) continue;
+    sim_core_t *cores[2] = {&g_sim.dac[b], &g_sim.adc[b]};
+    for (int i = 0; i < 2; i++) {
+      if (cores[i]->state != SIM_CORE_TRIG_WAIT) return false;
+      if (cores[i]->t > *latest) *latest = cores[i]->t;
+    }
+  }
+  return true;
+}
+
+// Distribute a trigger pulse at time t to every core
+static void sim_fire_trigger(uint64_t t, bool log) {
+  sim_trig_t *trig = &g_sim.trig;
+  for (int b = 0; b < 8 && g_sim.hw_state == S_RUNNING; b++) {
+    if (!sim_board_present(b)) continue;
+    for (int is_adc = 0; is_adc < 2; is_adc++) {
+      sim_core_t *core = is_adc ? &g_sim.adc[b] : &g_sim.dac[b];
+      if (core->state != SIM_CORE_TRIG_WAIT) {
+        sim_fault(is_adc ? STS_UNEXP_ADC_TRIG : STS_UNEXP_DAC_TRIG, b);
+        return;
+      }
+      if (--core->trig_remaining == 0) {
+        sim_core_done(core, is_adc, b, t);
+      }
+    }
+  }
+
+  trig->counter++;
+  if (log) {
+    if (trig->timer_start == 0) trig->timer_start = t;
+    uint64_t timestamp = t - trig->timer_start + 1;
+    uint64_t delta = timestamp - trig->last_log;
+    bool resync = !trig->delta_synced || delta > TRIG_DELTA_MAX ||
+                  trig->delta_count >= SIM_TRIG_RESYNC_INTERVAL - 1;
+    uint32_t words = (!trig->delta_mode || resync) ? 2 : 1;
+    if (trig->data.count + words > trig->data.depth) {
+      sim_fault(STS_TRIG_DATA_BUF_OVERFLOW, 0);
+      return;
+    }
+    trig->last_log = timestamp;
+    if (!trig->delta_mode) {
+      sim_fifo_push(&trig->data, (uint32_t)timestamp);
+      sim_fifo_push(&trig->data, (uint32_t)(timestamp >> 32));
+    } else if (resync) {
+      sim_fifo_push(&trig->data, TRIG_DATA_RESYNC_FLAG | (uint32_t)((timestamp >> 32) & TRIG_DELTA_MAX));
+      sim_fifo_push(&trig->data, (uint32_t)timestamp);
+      trig->delta_synced = true;
+      trig->delta_count = 0;
+    } else {
+      sim_fifo_push(&trig->data, (uint32_t)delta);
+      trig->delta_count++;
+    }
+  }
+}
+
+// Time of the trigger core's next event (SIM_NEVER if it is blocked)
+static uint64_t sim_trig_next_event(void) {
+  sim_trig_t *trig = &g_sim.trig;
+  switch (trig->state) {
+    case SIM_TRIG_IDLE:
+      return trig->cmd.count > 0 ? trig->t : SIM_NEVER;
+    case SIM_TRIG_DELAY:
+      return trig->busy_until;
+    case SIM_TRIG_SYNC: {
+      uint64_t latest;
+      if (!sim_all_waiting(&latest)) return SIM_NEVER;
+      return latest > trig->t ? latest : trig->t;
+    }
+    case SIM_TRIG_EXPECT: {
+      uint32_t period = g_sim.config.ext_trig_period;
+      if (period == 0) return SIM_NEVER;
+      uint64_t earliest = trig->t > trig->lockout_until ? trig->t : trig->lockout_until;
+      return (earliest + period - 1) / period * period;
+    }
+    default:
+      return SIM_NEVER;
+  }
+}
+
+// Process the trigger core's next event at time t
+static void sim_trig_event(uint64_t t) {
+  sim_trig_t *trig = &g_sim.trig;
+  switch (trig->state) {
+    case SIM_TRIG_IDLE: {
+      uint32_t word = sim_fifo_pop(&trig->cmd);
+      uint32_t cmd = (word >> TRIG_CMD_CODE_SHIFT) & 0x7;
+      uint32_t value = word & TRIG_CMD_VALUE_MASK;
+      trig->log = (word >> TRIG_CMD_LOG_BIT) & 1;
+      trig->t = t + 1;
+      switch (cmd) {
+        case TRIG_CMD_SYNC_CH:
+          trig->state = SIM_TRIG_SYNC;
+          trig->t = t;
+          break;
+        case TRIG_CMD_SET_LOCKOUT:
+          if (value >= SIM_TRIG_LOCKOUT_MIN) trig->lockout = value;
+          break;
+        case TRIG_CMD_EXPECT_EXT:
+          if (value > 0) {
+            trig->state = SIM_TRIG_EXPECT;
+            trig->ext_remaining = value;
+            trig->t = t;
+          }
+          break;
+        case TRIG_CMD_DELAY:
+          trig->state = SIM_TRIG_DELAY;
+          trig->busy_until = t + value;
+          break;
+        case TRIG_CMD_FORCE_TRIG:
+          sim_fire_trigger(t, trig->log);
+          break;
+        case TRIG_CMD_RESET_COUNT:
+          trig->counter = 0;
+          trig->timer_start = 0;
+          trig->delta_mode = value & TRIG_RESET_COUNT_DELTA;
+          trig->delta_synced = false;
+          break;
+        case TRIG_CMD_CANCEL:
+          break;
+        default:
+          sim_fault(STS_BAD_TRIG_CMD, 0);
+          break;
+      }
+      break;
+    }
+    case SIM_TRIG_DELAY:
+      trig->state = SIM_TRIG_IDLE;
+      trig->t = trig->busy_until;
+      break;
+    case SIM_TRIG_SYNC:
+      sim_fire_trigger(t, trig->log);
+      if (trig->state == SIM_TRIG_SYNC) {
+        trig->state = SIM_TRIG_IDLE;
+        trig->t = t;
+      }
+      break;
+    case SIM_TRIG_EXPECT:
+      sim_fire_trigger(t, trig->log);
+      trig->lockout_until = t + trig->lockout;
+      trig->t = t + 1;
+      if (--trig->ext_remaining == 0 && trig->state == SIM_TRIG_EXPECT) {
+        trig->state = SIM_TRIG_IDLE;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+//////////////////// Simulation loop ////////////////////
+
+// Bring the whole model up to the current time
+static uint64_t sim_advance(void) {
+  uint64_t now = sim_now();
+
+  if (g_sim.hw_state == S_AMP_POWER_WAIT && now >= g_sim.running_at) {
+    g_sim.hw_state = S_RUNNING;
+    for (int b = 0; b < 8; b++) {
+      sim_core_reset(&g_sim.dac[b], g_sim.running_at);
+      sim_core_reset(&g_sim.adc[b], g_sim.running_at);
+    }
+    sim_trig_reset(g_sim.running_at);
+  }
+
+  // Step the cores up to each trigger event in turn, since triggers couple them
+  while (g_sim.hw_state == S_RUNNING) {
+    uint64_t next = sim_trig_next_event();
+    uint64_t limit = next < now ? next : now;
+    for (int b = 0; b < 8; b++) {
+      if (!sim_board_present(b)) continue;
+      // The ADC goes first and pulls the DAC along to each of its sample times
+      sim_core_step(&g_sim.adc[b], true, b, limit);
+      sim_core_step(&g_sim.dac[b], false, b, limit);
+    }
+    if (g_sim.hw_state != S_RUNNING) break;
+    next = sim_trig_next_event();
+    if (next > now) {
+      if (g_sim.trig.state == SIM_TRIG_IDLE && g_sim.trig.t < now) g_sim.trig.t = now;
+      break;
+    }
+    sim_trig_event(next);
+  }
+  return now;
+}
+
+//////////////////// Register access ////////////////////
+
+// Status register contents
+static uint32_t sim_read_sts(uint32_t offset) {
+  if (offset == HW_STS_REG_OFFSET) {
+    return (g_sim.hw_state & 0xF) | ((g_sim.hw_code & 0x1FFFFFF) << 4) | (g_sim.hw_board << 29);
+  }
+  for (int b = 0; b < 8; b++) {
+    bool present = sim_board_present(b);
+    if (offset == (uint32_t)DAC_CMD_FIFO_STS_OFFSET(b)) return sim_fifo_status(&g_sim.dac[b].cmd, present);
+    if (offset == (uint32_t)DAC_DATA_FIFO_STS_OFFSET(b)) return sim_fifo_status(&g_sim.dac[b].data, present);
+    if (offset == (uint32_t)ADC_CMD_FIFO_STS_OFFSET(b)) return sim_fifo_status(&g_sim.adc[b].cmd, present);
+    if (offset == (uint32_t)ADC_DATA_FIFO_STS_OFFSET(b)) return sim_fifo_status(&g_sim.adc[b].data, present);
+  }
+  switch (offset) {
+    case TRIG_CMD_FIFO_STS_OFFSET: return sim_fifo_status(&g_sim.trig.cmd, true);
+    case TRIG_DATA_FIFO_STS_OFFSET: return sim_fifo_status(&g_sim.trig.data, true);
+    case SPI_CLK_FREQ_OFFSET: return g_sim.config.spi_clk_freq_hz;
+    case DEBUG_REG_OFFSET:
+      return (1u << DEBUG_SPI_CLK_LOCKED_BIT) |
+             ((g_sim.timing.dac_n_cs_high_time & 0x1F) << 2) |
+             ((g_sim.timing.adc_n_cs_high_time & 0xFF) << 7);
+    case TRIG_COUNTER_OFFSET: return g_sim.trig.counter;
+    case DESIGN_OPTS_OFFSET: return (uint32_t)g_sim.config.dac_ddr_buffer << DESIGN_OPT_DAC_DDR_BUF_BIT;
+    default: return 0;
+  }
+}
+
+// Find which command core a FIFO address belongs to (trigger FIFO: board 8)
+static int sim_fifo_board(uint32_t phys_addr, bool *is_adc) {
+  if (phys_addr - (uint32_t)TRIG_FIFO < AXI_FIFO_BRIDGE_RANGE) {
+    *is_adc = false;
+    return 8;
+  }
+  // The bridges ignore the address within their range, so burst beats all reach the FIFO
+  for (int b = 0; b < 8; b++) {
+    if (phys_addr - (uint32_t)DAC_FIFO(b) < AXI_FIFO_BRIDGE_RANGE) { *is_adc = false; return b; }
+    if (phys_addr - (uint32_t)ADC_FIFO(b) < AXI_FIFO_BRIDGE_RANGE) { *is_adc = true; return b; }
+  }
+  return -1;
+}
+
+// Find which board's DDR reader a register address belongs to (-1 if none)
+static int sim_ddr_reader_board(uint32_t phys_addr, uint32_t *offset) {
+  if (!g_sim.config.dac_ddr_buffer) return -1;
+  for (int b = 0; b < 8; b++) {
+    uint32_t rel = phys_addr - (uint32_t)DAC_DDR_READER(b);
+    if (rel < DAC_DDR_READER_WORDCOUNT * 4 && sim_board_present(b)) {
+      *offset = rel / 4;
+      return b;
+    }
+  }
+  return -1;
+}
+
+static uint32_t sim_ddr_reader_read(sim_ddr_reader_t *rd, uint32_t offset) {
+  switch (offset) {
+    case DAC_DDR_CTRL_OFFSET: return rd->enable ? DAC_DDR_CTRL_ENABLE : 0;
+    case DAC_DDR_BASE_OFFSET: return rd->base;
+    case DAC_DDR_SIZE_OFFSET: return rd->size;
+    case DAC_DDR_WR_PTR_OFFSET: return rd->wr_ptr;
+    case DAC_DDR_RD_PTR_OFFSET: return rd->rd_ptr;
+    case DAC_DDR_STATUS_OFFSET:
+      return (uint32_t)rd->enable | ((uint32_t)rd->rd_error << 2) | ((uint32_t)(rd->rd_ptr == rd->wr_ptr) << 3);
+    case DAC_DDR_WORDS_FED_OFFSET: return rd->words_fed;
+    default: return 0;
+  }
+}
+
+// Register writes the core would refuse with SLVERR are dropped (bursts are never in flight here)
+static void sim_ddr_reader_write(sim_ddr_reader_t *rd, uint32_t offset, uint32_t value) {
+  switch (offset) {
+    case DAC_DDR_CTRL_OFFSET:
+      if ((value & DAC_DDR_CTRL_CLEAR) && !(value & DAC_DDR_CTRL_ENABLE) && !rd->enable) {
+        rd->rd_ptr = 0;
+        rd->words_fed = 0;
+        rd->rd_error = false;
+      } else if (!(value & DAC_DDR_CTRL_CLEAR) && !((value & DAC_DDR_CTRL_ENABLE) && rd->rd_error)) {
+        rd->enable = value & DAC_DDR_CTRL_ENABLE;
+      }
+      break;
+    case DAC_DDR_BASE_OFFSET:
+      if (!rd->enable) rd->base = value & ~(uint32_t)(DAC_DDR_BUF_ALIGN - 1);
+      break;
+    case DAC_DDR_SIZE_OFFSET:
+      if (!rd->enable) {
+        rd->size = value & ~(uint32_t)(DAC_DDR_BUF_ALIGN - 1);
+        rd->wr_ptr = 0;
+        rd->rd_ptr = 0;
+      }
+      break;
+    case DAC_DDR_WR_PTR_OFFSET:
+      if ((value & ~3u) < rd->size) rd->wr_ptr = value & ~3u;
+      break;
+    default:
+      break;
+  }
+}
+
+static uint32_t sim_read32(uint32_t phys_addr) {
+  pthread_mutex_lock(&g_sim.lock);
+  sim_advance();
+  uint32_t value = 0;
+  uint32_t reader_offset;
+  int reader_board;
+
+  if (phys_addr >= SYS_CTRL_BASE && phys_addr < SYS_CTRL_BASE + SYS_CTRL_WORDCOUNT * 4) {
+    value = g_sim.ctrl_regs[(phys_addr - SYS_CTRL_BASE) / 4];
+  } else if (phys_addr >= SYS_STS && phys_addr < SYS_STS + 0x1000) {
+    value = sim_read_sts((phys_addr - SYS_STS) / 4);
+  } else if ((reader_board = sim_ddr_reader_board(phys_addr, &reader_offset)) >= 0) {
+    value = sim_ddr_reader_read(&g_sim.dac_ddr[reader_board], reader_offset);
+  } else {
+    bool is_adc;
+    int board = sim_fifo_board(phys_addr, &is_adc);
+    if (board == 8) {
+      if (g_sim.trig.data.count > 0) value = sim_fifo_pop(&g_sim.trig.data);
+      else sim_fault(STS_TRIG_DATA_BUF_UNDERFLOW, 0);
+    } else if (board >= 0 && sim_board_present(board)) {
+      sim_core_t *core = is_adc ? &g_sim.adc[board] : &g_sim.dac[board];
+      if (core->data.count > 0) value = sim_fifo_pop(&core->data);
+      else sim_fault(is_adc ? STS_ADC_DATA_BUF_UNDERFLOW : STS_DAC_DATA_BUF_UNDERFLOW, board);
+    }
+  }
+
+  pthread_mutex_unlock(&g_sim.lock);
+  return value;
+}
+
+static void sim_write32(uint32_t phys_addr, uint32_t value) {
+  pthread_mutex_lock(&g_sim.lock);
+  uint64_t now = sim_advance();
+  uint32_t reader_offset;
+  int reader_board;
+
+  if (phys_addr >= SYS_CTRL_BASE && phys_addr < SYS_CTRL_BASE + SYS_CTRL_WORDCOUNT * 4) {
+    uint32_t offset = (phys_addr - SYS_CTRL_BASE) / 4;
+    g_sim.ctrl_regs[offset] = value;
+    if (offset == SYSTEM_ENABLE_OFFSET) sim_set_enable(value, now);
+    sim_apply_buf_resets();
+  } else if ((reader_board = sim_ddr_reader_board(phys_addr, &reader_offset)) >= 0) {
+    sim_ddr_reader_write(&g_sim.dac_ddr[reader_board], reader_offset, value);
+  } else {
+    bool is_adc;
+    int board = sim_fifo_board(phys_addr, &is_adc);
+    if (board == 8) {
+      sim_trig_t *trig = &g_sim.trig;
+      bool cancel = ((value >> TRIG_CMD_CODE_SHIFT) & 0x7) == TRIG_CMD_CANCEL;
+      if (cancel && trig->cmd.count == 0 && trig->state != SIM_TRIG_IDLE && trig->state != SIM_TRIG_ERROR) {
+        trig->state = SIM_TRIG_IDLE;
+        trig->t = now;
+        trig->ext_remaining = 0;
+      } else if (!(g_sim.ctrl_regs[CMD_BUF_RESET_OFFSET] & (1u << 16))) {
+        if (!sim_fifo_push(&trig->cmd, value)) sim_fault(STS_TRIG_CMD_BUF_OVERFLOW, 0);
+        trig->cmd.last_push = now;
+      }
+    } else if (board >= 0 && sim_board_present(board)) {
+      sim_core_t *core = is_adc ? &g_sim.adc[board] : &g_sim.dac[board];
+      bool cancel = ((value >> DAC_CMD_CMD_LSB) & 0x7) == DAC_CMD_CANCEL;
+      bool held = g_sim.ctrl_regs[CMD_BUF_RESET_OFFSET] & (1u << (2 * board + (is_adc ? 1 : 0)));
+      if (!(cancel && g_sim.hw_state == S_RUNNING && sim_core_cancel(core, is_adc, now)) && !held) {
+        if (!sim_fifo_push(&core->cmd, value)) {
+          sim_fault(is_adc ? STS_ADC_CMD_BUF_OVERFLOW : STS_DAC_CMD_BUF_OVERFLOW, board);
+        }
+        core->cmd.last_push = now;
+      }
+    }
+    // Other addresses (e.g. the SPI clock wizard) accept and ignore writes
+  }
+
+  pthread_mutex_unlock(&g_sim.lock);
+}
+
+static const hw_backend_ops_t g_hw_sim_ops = {
+  .name = "sim",
+  .read32 = sim_read32,
+  .write32 = sim_write32,
+};
+
+//////////////////// Setup ////////////////////
+
+// Default simulator configuration
+hw_sim_config_t hw_sim_default_config(void) {
+  hw_sim_config_t config = {
+    .spi_clk_freq_hz = HW_SIM_DEFAULT_SPI_CLK_HZ,
+    .board_mask = HW_SIM_DEFAULT_BOARD_MASK,
+    .time_scale = 1.0,
+    .ext_trig_period = 0,
+    .loopback_gain = 1.0,
+    .loopback_offset = 0,
+    .noise_lsb = 0,
+    .dac_ddr_buffer = true,
+  };
+  return config;
+}
+
+// Install the simulator as the hardware backend
+void hw_sim_install(const hw_sim_config_t *config) {
+  memset(&g_sim, 0, sizeof(g_sim));
+  g_sim.config = *config;
+  if (g_sim.config.spi_clk_freq_hz == 0) g_sim.config.spi_clk_freq_hz = HW_SIM_DEFAULT_SPI_CLK_HZ;
+  if (g_sim.config.time_scale <= 0) g_sim.config.time_scale = 1.0;
+  pthread_mutex_init(&g_sim.lock, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &g_sim.start);
+
+  uint32_t freq = g_sim.config.spi_clk_freq_hz;
+  g_sim.timing = create_spi_timing(freq);
+  g_sim.startup_cycles = (uint64_t)HW_SIM_STARTUP_US * freq / 1000000;
+  g_sim.grace_cycles = (uint64_t)HW_SIM_BURST_GRACE_US * freq / 1000000;
+  g_sim.noise_seed = 1;
+
+  g_sim.hw_state = S_IDLE;
+  g_sim.hw_code = STS_EMPTY;
+  for (int b = 0; b < 8; b++) {
+    sim_fifo_init(&g_sim.dac[b].cmd, DAC_CMD_FIFO_WORDCOUNT);
+    sim_fifo_init(&g_sim.dac[b].data, DAC_DATA_FIFO_WORDCOUNT);
+    sim_fifo_init(&g_sim.adc[b].cmd, ADC_CMD_FIFO_WORDCOUNT);
+    sim_fifo_init(&g_sim.adc[b].data, ADC_DATA_FIFO_WORDCOUNT);
+    sim_core_reset(&g_sim.dac[b], 0);
+    sim_core_reset(&g_sim.adc[b], 0);
+    g_sim.dac_ddr[b].board = b;
+    if (g_sim.config.dac_ddr_buffer) g_sim.dac[b].ddr = &g_sim.dac_ddr[b];
+  }
+  sim_fifo_init(&g_sim.trig.cmd, TRIG_CMD_FIFO_WORDCOUNT);
+  sim_fifo_init(&g_sim.trig.data, TRIG_DATA_FIFO_WORDCOUNT);
+  sim_trig_reset(0);
+
+  map_memory_set_backend(MAP_BACKEND_SIM);
+  hw_backend_install(&g_hw_sim_ops);
+}
+
+// Current simulated time in SPI clock cycles
+uint64_t hw_sim_now_cycles(void) {
+  return sim_now();
+}
@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "hw_trace.h"
+#include "hw_backend.h"
+#include "map_memory.h"
+#include "sys_ctrl.h"
+#include "sys_sts.h"
+#include "spi_clk_ctrl.h"
+#include "dac_ctrl.h"
+#include "adc_ctrl.h"
+#include "trigger_ctrl.h"
+
+// One recorded access
+typedef struct {
+  uint64_t ticks;                  // Timestamp in the ticks of the selected clock
+  const volatile uint32_t *reg;    // Mapped register (decoded to a physical address when dumped)
+  uint32_t value;                  // Value read or written
+  int32_t tid;                     // Kernel thread ID of the accessing thread
+  uint8_t op;                      // HW_TRACE_READ or HW_TRACE_WRITE
+} hw_trace_entry_t;
+
+// Per-thread ring. Only the owning thread writes entries and head; readers
+// detect entries overwritten during a dump by re-reading head afterwards.
+typedef struct {
+  volatile uint64_t head;          // Total entries ever written
+  uint64_t start;                  // Entries before this were cleared (written by hw_trace_clear only)
+  uint32_t mask;                   // Ring size minus one
+  volatile int in_use;             // Nonzero while a live thread owns the ring
+  hw_trace_entry_t entries[];
+} hw_trace_ring_t;
+
+// Timestamp sources
+typedef enum {
+  HW_TRACE_CLOCK_NONE,             // Not picked yet (nothing is recorded)
+  HW_TRACE_CLOCK_GTIMER,           // Cortex-A9 global timer ticks
+  HW_TRACE_CLOCK_MONOTONIC         // CLOCK_MONOTONIC nanoseconds (simulator, or no timer mapping)
+} hw_trace_clock_t;
+
+volatile int g_hw_trace_enabled = 0;
+
+static int g_clock = HW_TRACE_CLOCK_NONE;
+static const volatile uint32_t *g_gtimer = NULL;
+static uint64_t g_calib_ticks = 0; // Clock reading at selection, paired with g_calib_ns for the tick rate
+static uint64_t g_calib_ns = 0;
+
+static hw_trace_ring_t *g_rings[HW_TRACE_MAX_THREADS];
+static uint32_t g_ring_count = 0;
+static uint32_t g_ring_entries = HW_TRACE_DEFAULT_ENTRIES;
+static pthread_mutex_t g_ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t g_ring_key;
+static pthread_once_t g_ring_key_once = PTHREAD_ONCE_INIT;
+
+// Calling thread's ring (NULL until its first traced access, g_no_ring if none was available)
+static __thread hw_trace_ring_t *t_ring = NULL;
+static __thread int32_t t_tid = 0;
+static hw_trace_ring_t g_no_ring;
+
+// Release a thread's ring for reuse when the thread exits (its entries stay until overwritten)
+static void release_ring(void *ring) {
+  __atomic_store_n(&((hw_trace_ring_t *)ring)->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void create_ring_key(void) {
+  pthread_key_create(&g_ring_key, release_ring);
+}
+
+// Attach a ring to the calling thread: a new one while there's room, otherwise one released by an exited thread
+static hw_trace_ring_t *acquire_ring(void) {
+  pthread_once(&g_ring_key_once, create_ring_key);
+  hw_trace_ring_t *ring = NULL;
+
+  pthread_mutex_lock(&g_ring_lock);
+  if (g_ring_count < HW_TRACE_MAX_THREADS) {
+    ring = calloc(1, sizeof(hw_trace_ring_t) + (size_t)g_ring_entries * sizeof(hw_trace_entry_t));
+    if (ring != NULL) {
+      ring->mask = g_ring_entries - 1;
+      ring->in_use = 1;
+      __atomic_store_n(&g_rings[g_ring_count], ring, __ATOMIC_RELEASE);
+      __atomic_store_n(&g_ring_count, g_ring_count + 1, __ATOMIC_RELEASE);
+    }
+  } else {
+    for (uint32_t i = 0; i < g_ring_count; i++) {
+      if (!__atomic_load_n(&g_rings[i]->in_use, __ATOMIC_ACQUIRE)) {
+        ring = g_rings[i];
+        ring->in_use = 1;
+        break;
+      }
+    }
+  }
+  pthread_mutex_unlock(&g_ring_lock);
+
+  if (ring == NULL) return &g_no_ring;
+  pthread_setspecific(g_ring_key, ring);
+  return ring;
+}
+
+static uint64_t monotonic_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// Read the 64-bit global timer (re-reading if the high word rolled over between the halves)
+static inline uint64_t read_gtimer(const volatile uint32_t *gtimer) {
+  uint32_t hi, lo;
+  do {
+    hi = gtimer[HW_TRACE_GTIMER_HI];
+    lo = gtimer[HW_TRACE_GTIMER_LO];
+  } while (hi != gtimer[HW_TRACE_GTIMER_HI]);
+  return ((uint64_t)hi << 32) | lo;
+}
+
+static inline uint64_t read_clock(int clock) {
+  return clock == HW_TRACE_CLOCK_GTIMER ? read_gtimer(g_gtimer) : monotonic_ns();
+}
+
+// Pick the timestamp source: the global timer on hardware if it can be mapped and is counting
+static void select_clock(void) {
+  int clock = HW_TRACE_CLOCK_MONOTONIC;
+  if (g_hw_backend == NULL) {
+    uint32_t *page = map_32bit_memory(HW_TRACE_GTIMER_PAGE, (HW_TRACE_GTIMER_OFFSET >> 2) + HW_TRACE_GTIMER_CTRL + 1, "a9_global_timer", false);
+    if (page == NULL) {
+      fprintf(stderr, "Could not map the global timer; hw_trace falls back to CLOCK_MONOTONIC (~1 us per access)\n");
+    } else if (!(page[(HW_TRACE_GTIMER_OFFSET >> 2) + HW_TRACE_GTIMER_CTRL] & 1)) {
+      fprintf(stderr, "The global timer is stopped; hw_trace falls back to CLOCK_MONOTONIC (~1 us per access)\n");
+    } else {
+      g_gtimer = page + (HW_TRACE_GTIMER_OFFSET >> 2);
+      clock = HW_TRACE_CLOCK_GTIMER;
+    }
+  }
+  g_calib_ticks = read_clock(clock);
+  g_calib_ns = monotonic_ns();
+  __atomic_store_n(&g_clock, clock, __ATOMIC_RELEASE);
+}
+
+// Clock ticks per nanosecond, measured against CLOCK_MONOTONIC since the clock was picked
+static double ticks_per_ns(int clock) {
+  if (clock != HW_TRACE_CLOCK_GTIMER) return 1.0;
+  uint64_t elapsed_ns = monotonic_ns() - g_calib_ns;
+  if (elapsed_ns < HW_TRACE_CALIBRATE_NS) {
+    usleep((useconds_t)((HW_TRACE_CALIBRATE_NS - elapsed_ns) / 1000));
+  }
+  uint64_t ticks = read_gtimer(g_gtimer);
+  uint64_t ns = monotonic_ns();
+  return (double)(ticks - g_calib_ticks) / (double)(ns - g_calib_ns);
+}
+
+// Start recording
+void hw_trace_enable(uint32_t ring_entries) {
+  if (ring_entries == 0) ring_entries = HW_TRACE_DEFAULT_ENTRIES;
+  uint32_t size = 1;
+  while (size < ring_entries && size < (1u << 24)) size <<= 1;
+
+  pthread_mutex_lock(&g_ring_lock);
+  g_ring_entries = size;
+  if (g_clock == HW_TRACE_CLOCK_NONE) select_clock();
+  pthread_mutex_unlock(&g_ring_lock);
+  __atomic_store_n(&g_hw_trace_enabled, 1, __ATOMIC_RELEASE);
+}
+
+// Stop recording
+void hw_trace_disable(void) {
+  __atomic_store_n(&g_hw_trace_enabled, 0, __ATOMIC_RELEASE);
+}
+
+// Discard all recorded entries
+void hw_trace_clear(void) {
+  uint32_t count = __atomic_load_n(&g_ring_count, __ATOMIC_ACQUIRE);
+  for (uint32_t i = 0; i < count; i++) {
+    g_rings[i]->start = __atomic_load_n(&g_rings[i]->head, __ATOMIC_ACQUIRE);
+  }
+}
+
+// Record one access
+void hw_trace_record_slow(uint8_t op, const volatile uint32_t *reg, uint32_t value) {
+  hw_trace_ring_t *ring = t_ring;
+  if (ring == NULL) {
+    ring = t_ring = acquire_ring();
+    t_tid = (int32_t)syscall(SYS_gettid);
+  }
+  int clock = __atomic_load_n(&g_clock, __ATOMIC_ACQUIRE);
+  if (ring == &g_no_ring || clock == HW_TRACE_CLOCK_NONE) return;
+
+  uint64_t head = ring->head;
+  hw_trace_entry_t *entry = &ring->entries[head & ring->mask];
+  entry->ticks = read_clock(clock);
+  entry->reg = reg;
+  entry->value = value;
+  entry->tid = t_tid;
+  entry->op = op;
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Name a physical register address
+static void describe_addr(uint32_t phys_addr, char *buf, size_t size) {
+  if (phys_addr >= SYS_CTRL_BASE && phys_addr < SYS_STS) {
+    snprintf(buf, size, "sys_ctrl+0x%X", phys_addr - SYS_CTRL_BASE);
+  } else if (phys_addr >= SYS_STS && phys_addr < SPI_CLK_BASE) {
+    uint32_t offset = (phys_addr - SYS_STS) / 4;
+    if (offset == HW_STS_REG_OFFSET) {
+      snprintf(buf, size, "hw_status");
+    } else {
+      snprintf(buf, size, "sys_sts[%u]", offset);
+    }
+  } else if (phys_addr >= SPI_CLK_BASE && phys_addr < AXI_CTRL_WINDOW_BASE + AXI_CTRL_WINDOW_SIZE) {
+    snprintf(buf, size, "spi_clk+0x%X", phys_addr - SPI_CLK_BASE);
+  } else if (phys_addr - TRIG_FIFO < AXI_FIFO_BRIDGE_RANGE) {
+    snprintf(buf, size, "trig_fifo");
+  } else if (phys_addr >= AXI_FIFO_WINDOW_BASE && phys_addr < AXI_FIFO_WINDOW_BASE + AXI_FIFO_WINDOW_SIZE) {
+    uint32_t board = (phys_addr - AXI_FIFO_WINDOW_BASE) >> 16;
+    if (phys_addr - DAC_FIFO(board) < AXI_FIFO_BRIDGE_RANGE) {
+      snprintf(buf, size, "dac_fifo[%u]", board);
+    } else if (phys_addr - ADC_FIFO(board) < AXI_FIFO_BRIDGE_RANGE) {
+      snprintf(buf, size, "adc_fifo[%u]", board);
+    } else {
+      snprintf(buf, size, "fifo_window+0x%X", phys_addr - AXI_FIFO_WINDOW_BASE);
+    }
+  } else {
+    snprintf(buf, size, "?");
+  }
+}
+
+static int compare_entries(const void *a, const void *b) {
+  uint64_t ta = ((const hw_trace_entry_t *)a)->ticks;
+  uint64_t tb = ((const hw_trace_entry_t *)b)->ticks;
+  return (ta > tb) - (ta < tb);
+}
+
+// Write all recorded entries, oldest first
+size_t hw_trace_dump(FILE *out) {
+  uint32_t count = __atomic_load_n(&g_ring_count, __ATOMIC_ACQUIRE);
+  size_t capacity = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    capacity += (size_t)g_rings[i]->mask + 1;
+  }
+
+  hw_trace_entry_t *merged = capacity > 0 ? malloc(capacity * sizeof(hw_trace_entry_t)) : NULL;
+  if (capacity > 0 && merged == NULL) {
+    fprintf(stderr, "Failed to allocate %zu trace entries for the dump\n", capacity);
+    return 0;
+  }
+
+  // Copy each ring, then drop any entries its owner overwrote while they were being copied
+  size_t total = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    hw_trace_ring_t *ring = g_rings[i];
+    uint64_t size = (uint64_t)ring->mask + 1;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t first = head > size ? head - size : 0;
+    if (first < ring->start) first = ring->start;
+
+    size_t copied_from = total;
+    for (uint64_t n = first; n < head; n++) {
+      merged[total++] = ring->entries[n & ring->mask];
+    }
+
+    uint64_t head_after = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (head_after > size && head_after - size > first) {
+      uint64_t lost = head_after - size - first;
+      if (lost > head - first) lost = head - first;
+      memmove(&merged[copied_from], &merged[copied_from + lost], (size_t)(head - first - lost) * sizeof(hw_trace_entry_t));
+      total -= (size_t)lost;
+    }
+  }
+
+  qsort(merged, total, sizeof(hw_trace_entry_t), compare_entries);
+  int clock = __atomic_load_n(&g_clock, __ATOMIC_ACQUIRE);
+  double ticks_per_us = total > 0 ? ticks_per_ns(clock) * 1000.0 : 1.0;
+
+  fprintf(out, "# Hardware access trace: %zu entries from %u thread ring(s)\n", total, count);
+  fprintf(out, "# time_us (from first entry)  tid  op  phys_addr  register  value\n");
+  for (size_t i = 0; i < total; i++) {
+    uint32_t phys_addr = map_memory_phys_addr(merged[i].reg);
+    char name[32];
+    describe_addr(phys_addr, name, sizeof(name));
+    fprintf(out, "%14.3f  %6d  %s  0x%08X  %-14s  0x%08X\n",
+            (double)(merged[i].ticks - merged[0].ticks) / ticks_per_us, merged[i].tid,
+            merged[i].op == HW_TRACE_WRITE ? "W" : "R", phys_addr, name, merged[i].value);
+  }
+  fflush(out);
+
+  free(merged);
+  return total;
+}
+
+// Dump to a file path
+long hw_trace_dump_to_file(const char *path) {
+  FILE *out = fopen(path, "w");
+  if (out == NULL) {
+    return -1;
+  }
+  size_t total = hw_trace_dump(out);
+  fclose(out);
+  return (long)total;
+}
+
+// Print ring usage
+void hw_trace_print_status(void) {
+  uint32_t count = __atomic_load_n(&g_ring_count, __ATOMIC_ACQUIRE);
+  printf("Hardware trace: %s, %u entries per new thread ring\n",
+         g_hw_trace_enabled ? "recording" : "stopped", g_ring_entries);
+  int clock = __atomic_load_n(&g_clock, __ATOMIC_ACQUIRE);
+  printf("  Timestamps: %s\n", clock == HW_TRACE_CLOCK_GTIMER ? "A9 global timer" :
+         clock == HW_TRACE_CLOCK_MONOTONIC ? "CLOCK_MONOTONIC" : "not selected yet");
+  printf("  Thread rings: %u of %u\n", count, HW_TRACE_MAX_THREADS);
+  for (uint32_t i = 0; i < count; i++) {
+    hw_trace_ring_t *ring = g_rings[i];
+    uint64_t size = (uint64_t)ring->mask + 1;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t first = head > size ? head - size : 0;
+    if (first < ring->start) first = ring->start;
+    printf("  Ring %2u: %s, %llu accesses recorded, %llu held (size %llu)\n", i,
+           ring->in_use ? "live thread" : "thread exited",
+           (unsigned long long)head, (unsigned long long)(head - first), (unsigned long long)size);
+  }
+}
@@ -0,0 +1,247 @@
+#include <string.h>
+#include "integ_model.h"
+
+// FIFO fill over the write (inflow) and read (outflow) bursts. Neither depends on the data, so a
+// window either always overflows at the same cycle or never does. Both repeat every chunk period
+// once reading starts, so a few periods past the first read cover every case.
+static void integ_model_check_fifo(struct integ_model_t *model) {
+  uint64_t period = model->period_cycles;
+  uint64_t last = (uint64_t)model->window + 3 * period;
+  uint64_t push_start = period;                  // Writes follow the inflow timer reaching 0
+  uint64_t pop_start = model->window - 16;       // Reads follow the outflow timer reaching 16
+  uint64_t push = push_start, pop = pop_start;   // Next cycle of each burst
+  uint32_t entries = 0;
+
+  while (push <= last || pop <= last) {
+    uint64_t cycle = push < pop ? push : pop;
+    bool wr = (cycle == push), rd = (cycle == pop);
+    if (wr && entries == INTEG_FIFO_ENTRIES) {
+      model->fifo_overflow = true;
+      model->fifo_overflow_cycle = cycle;
+      return;
+    }
+    entries = entries + (wr ? 1 : 0) - (rd && entries > 0 ? 1 : 0);
+    if (entries > model->fifo_peak_entries) model->fifo_peak_entries = entries;
+    // 8 consecutive cycles per burst, one burst per period
+    if (wr) push = ((push - push_start) % period == 7) ? push + period - 7 : push + 1;
+    if (rd) pop = ((pop - pop_start) % period == 7) ? pop + period - 7 : pop + 1;
+  }
+}
+
+// Start the model as the core enters RUNNING
+int integ_model_init(struct integ_model_t *model, uint32_t window, uint32_t threshold_average) {
+  memset(model, 0, sizeof(*model));
+  if (window < INTEG_WINDOW_MIN) return -1;
+
+  uint32_t msb = 31;
+  while (!(window >> msb)) msb--;
+  model->window = window;
+  model->threshold_average = threshold_average & INTEG_THRESHOLD_MASK;
+  model->chunk_width = msb - 10;
+  model->period_steps = (1u << model->chunk_width) - 1;
+  model->period_cycles = (uint64_t)INTEG_SAMPLE_CYCLES * model->period_steps + 1;
+  model->max_value = (uint64_t)model->threshold_average * (window >> 4);
+  // The outflow timer starts at window - 1 and adds a step at each multiple of 16 above 0
+  model->first_steps = (window - 1) / INTEG_SAMPLE_CYCLES;
+  integ_model_check_fifo(model);
+  return 0;
+}
+
+// Cycles after which a held input has fully replaced the window's contents
+uint64_t integ_model_settle_cycles(const struct integ_model_t *model) {
+  return (uint64_t)model->window + 2 * model->period_cycles;
+}
+
+// Queue chunks with the same sums
+static void integ_push_chunks(struct integ_model_t *model, const uint64_t sum[8], uint64_t count) {
+  if (model->run_count > 0) {
+    struct integ_chunk_run_t *tail = &model->runs[(model->run_head + model->run_count - 1) % INTEG_MODEL_MAX_RUNS];
+    if (memcmp(tail->sum, sum, sizeof(tail->sum)) == 0) {
+      tail->count += count;
+      return;
+    }
+  }
+  // Runs are consumed about a window behind, so the ring can't fill
+  struct integ_chunk_run_t *run = &model->runs[(model->run_head + model->run_count) % INTEG_MODEL_MAX_RUNS];
+  memcpy(run->sum, sum, sizeof(run->sum));
+  run->count = count;
+  model->run_count++;
+}
+
+// Sample the input into chunks until end
+static void integ_inflow(struct integ_model_t *model, const uint16_t input[8], uint64_t end) {
+  uint32_t chunk_samples = model->period_steps + 1;
+  uint64_t last_sample = (uint64_t)INTEG_SAMPLE_CYCLES * model->period_steps; // Offset of a chunk's last sample
+
+  while (model->sample_cycle < end) {
+    if (model->sample_index == 0 && model->sample_cycle + last_sample < end) {
+      // Whole chunks of this input
+      uint64_t count = (end - 1 - model->sample_cycle - last_sample) / model->period_cycles + 1;
+      uint64_t sum[8];
+      for (int lane = 0; lane < 8; lane++) sum[lane] = (uint64_t)input[lane] * chunk_samples;
+      integ_push_chunks(model, sum, count);
+      model->sample_cycle += count * model->period_cycles;
+      continue;
+    }
+    uint64_t samples = (end - model->sample_cycle + INTEG_SAMPLE_CYCLES - 1) / INTEG_SAMPLE_CYCLES;
+    if (samples > chunk_samples - model->sample_index) samples = chunk_samples - model->sample_index;
+    for (int lane = 0; lane < 8; lane++) model->chunk_sum[lane] += (uint64_t)input[lane] * samples;
+    model->sample_index += (uint32_t)samples;
+    model->sample_cycle += samples * INTEG_SAMPLE_CYCLES;
+    if (model->sample_index == chunk_samples) {
+      integ_push_chunks(model, model->chunk_sum, 1);
+      memset(model->chunk_sum, 0, sizeof(model->chunk_sum));
+      model->sample_index = 0;
+      // The next chunk starts the cycle after the last sample
+      model->sample_cycle += model->period_cycles - (uint64_t)INTEG_SAMPLE_CYCLES * chunk_samples;
+    }
+  }
+}
+
+// Outflow steps taking one extra among the first x steps of a run of periods: the last
+// remainder - 1 steps of each period
+static uint64_t integ_extra_steps(uint64_t x, uint32_t period_steps, uint32_t remainder) {
+  if (remainder <= 1) return 0;
+  uint64_t first = period_steps + 1 - remainder;
+  uint64_t in_period = x % period_steps;
+  return (x / period_steps) * (remainder - 1) + (in_period > first ? in_period - first : 0);
+}
+
+// Cycle the delta of a step is computed on (first phase steps count from 0, then period steps)
+static uint64_t integ_step_cycle(const struct integ_model_t *model, bool first_phase, uint64_t step) {
+  if (first_phase) {
+    return model->window - 1 - (uint64_t)INTEG_SAMPLE_CYCLES * (model->first_steps - step);
+  }
+  return model->window + (step / model->period_steps) * model->period_cycles
+         + (uint64_t)INTEG_SAMPLE_CYCLES * (step % model->period_steps);
+}
+
+// Add count steps of one input and outflow chunk. Each step adds input - outflow or one less, so
+// the sums only move one way and the peak is at an end; a trip is found by bisection.
+static void integ_add_steps(struct integ_model_t *model, const uint16_t input[8], const uint64_t *outflow_sum,
+                            bool first_phase, uint64_t step, uint64_t count) {
+  uint32_t steps = model->period_steps;
+  uint64_t trip_cycle = UINT64_MAX;
+  uint8_t trip_channels = 0;
+
+  for (int lane = 0; lane < 8; lane++) {
+    int64_t rate = input[lane];
+    uint32_t remainder = 0;
+    if (!first_phase) {
+      rate -= (int64_t)(outflow_sum[lane] >> model->chunk_width);
+      remainder = (uint32_t)(outflow_sum[lane] & steps);
+    }
+    uint64_t extra0 = integ_extra_steps(step, steps, remainder);
+    int64_t start = model->total_sum[lane];
+    int64_t end = start + rate * (int64_t)count - (int64_t)(integ_extra_steps(step + count, steps, remainder) - extra0);
+    model->total_sum[lane] = end;
+    if (end <= model->peak_sum[lane]) continue;
+
+    // Each sum is visible the second cycle after its delta is computed
+    model->peak_sum[lane] = end;
+    model->peak_cycle[lane] = integ_step_cycle(model, first_phase, step + count - 1) + 2;
+    if (model->tripped || end <= (int64_t)model->max_value) continue;
+    uint64_t lo = 1, hi = count;
+    while (lo < hi) {
+      uint64_t mid = lo + (hi - lo) / 2;
+      int64_t sum = start + rate * (int64_t)mid - (int64_t)(integ_extra_steps(step + mid, steps, remainder) - extra0);
+      if (sum > (int64_t)model->max_value) hi = mid;
+      else lo = mid + 1;
+    }
+    uint64_t cycle = integ_step_cycle(model, first_phase, step + lo - 1) + 2;
+    if (cycle < trip_cycle) {
+      trip_cycle = cycle;
+      trip_channels = 0;
+    }
+    if (cycle == trip_cycle) trip_channels |= (uint8_t)(1u << lane);
+  }
+
+  if (trip_channels != 0) {
+    model->tripped = true;
+    model->trip_cycle = trip_cycle;
+    model->trip_channels = trip_channels;
+  }
+}
+
+// Add every step computed before end
+static void integ_sum(struct integ_model_t *model, const uint16_t input[8], uint64_t end) {
+  // Before the first chunk leaves, every step adds the input
+  if (model->first_done < model->first_steps) {
+    uint64_t cycle = integ_step_cycle(model, true, model->first_done);
+    if (cycle >= end) return;
+    uint64_t count = (end - cycle + INTEG_SAMPLE_CYCLES - 1) / INTEG_SAMPLE_CYCLES;
+    if (count > model->first_steps - model->first_done) count = model->first_steps - model->first_done;
+    integ_add_steps(model, input, NULL, true, model->first_done, count);
+    model->first_done += count;
+    if (model->first_done < model->first_steps) return;
+  }
+  if (end <= model->window) return;
+
+  // Steps computed before end, counted from the first chunk period
+  uint64_t since = end - model->window;
+  uint64_t in_period = (since % model->period_cycles + INTEG_SAMPLE_CYCLES - 1) / INTEG_SAMPLE_CYCLES;
+  if (in_period > model->period_steps) in_period = model->period_steps;
+  uint64_t end_step = (since / model->period_cycles) * model->period_steps + in_period;
+
+  while (model->period_step < end_step) {
+    // Period p drains chunk p, which was queued a window earlier
+    uint64_t period = model->period_step / model->period_steps;
+    struct integ_chunk_run_t *run = &model->runs[model->run_head];
+    while (period >= model->run_head_period + run->count) {
+      model->run_head_period += run->count;
+      model->run_head = (model->run_head + 1) % INTEG_MODEL_MAX_RUNS;
+      model->run_count--;
+      run = &model->runs[model->run_head];
+    }
+    uint64_t run_end = (model->run_head_period + run->count) * model->period_steps;
+    uint64_t count = (end_step < run_end ? end_step : run_end) - model->period_step;
+    integ_add_steps(model, input, run->sum, false, model->period_step, count);
+    model->period_step += count;
+  }
+}
+
+// Hold the 8 inputs for a number of cycles
+void integ_model_hold(struct integ_model_t *model, const uint16_t input[8], uint64_t cycles) {
+  if (model->window < INTEG_WINDOW_MIN || cycles == 0) return;
+  uint64_t end = model->cycle + cycles;
+  // Chunks are always queued well before they drain, so the inflow can run ahead first
+  integ_inflow(model, input, end);
+  integ_sum(model, input, end);
+  model->cycle = end;
+}
+
+// Print a cycle count, with the time if the SPI clock is known
+static void integ_print_cycle(uint64_t cycle, uint32_t spi_clk_freq_hz, FILE *out) {
+  fprintf(out, "cycle %llu", (unsigned long long)cycle);
+  if (spi_clk_freq_hz != 0) fprintf(out, " (%.6f s)", (double)cycle / spi_clk_freq_hz);
+}
+
+// Print the per-channel peaks and margins
+void integ_model_print_report(const struct integ_model_t *model, uint8_t board, uint32_t spi_clk_freq_hz, FILE *out) {
+  uint64_t steps = model->window >> 4;
+  fprintf(out, "  Board %u integrator: window %u cycles, average limit %u, sum limit %llu (chunks of %u samples)\n",
+          board, model->window, model->threshold_average, (unsigned long long)model->max_value, model->period_steps + 1);
+  for (int lane = 0; lane < 8; lane++) {
+    int64_t margin = (int64_t)model->max_value - model->peak_sum[lane];
+    fprintf(out, "    ch %d: peak sum %lld (%.1f%% of limit), margin %lld (%.1f average codes) at ",
+            board * 8 + lane, (long long)model->peak_sum[lane],
+            model->max_value ? 100.0 * model->peak_sum[lane] / model->max_value : 0.0,
+            (long long)margin, steps ? (double)margin / steps : 0.0);
+    integ_print_cycle(model->peak_cycle[lane], spi_clk_freq_hz, out);
+    fprintf(out, "\n");
+  }
+  if (model->tripped) {
+    fprintf(out, "    Over threshold first at ");
+    integ_print_cycle(model->trip_cycle, spi_clk_freq_hz, out);
+    fprintf(out, " on channel%s", (model->trip_channels & (model->trip_channels - 1)) ? "s" : "");
+    for (int lane = 0; lane < 8; lane++) {
+      if (model->trip_channels & (1u << lane)) fprintf(out, " %d", board * 8 + lane);
+    }
+    fprintf(out, "\n");
+  }
+  if (model->fifo_overflow) {
+    fprintf(out, "    This window overflows the integrator FIFO at ");
+    integ_print_cycle(model->fifo_overflow_cycle, spi_clk_freq_hz, out);
+    fprintf(out, " whatever the waveform (threshold overflow error)\n");
+  }
+}
@@ -1,19 +1,133 @@
+#include <errno.h> // For errno
 #include <fcntl.h> // For open function
 #include <inttypes.h> // For PRIx32 format specifier
 #include <stdint.h> // For uint32_t type
 #include <stdbool.h> // For bool type
 #include <stdio.h> // For printf and perror functions
 #include <stdlib.h> // For exit function and NULL definition etc.
+#include <string.h> // For strcmp and strcspn functions
+#include <sys/file.h> // For flock function
 #include <sys/mman.h> // For mmap function
+#include <sys/stat.h> // For fchmod function
 #include <unistd.h> // For sysconf function
+#include "map_memory.h"
 
-// Map a 32-bit memory region
-uint32_t *map_32bit_memory(uint32_t base_addr, size_t wordcount, char *name, bool verbose) {
+// A contiguous AXI window in the registry
+typedef struct {
+  const char *name;          // Window (and UIO device) name
+  uint32_t base_addr;        // Physical base address
+  uint32_t size;             // Size in bytes
+  volatile uint32_t *mapped; // Mapping of the whole window (NULL until first use)
+  int uio_index;             // UIO device the window was mapped from (-1 for /dev/mem)
+} map_window_t;
 
-  if (verbose) {
-    printf("Mapping memory region [%s] at base address 0x%" PRIx32 " with size %zu bytes...\n", name, base_addr, wordcount * 4);
+static map_window_t g_map_windows[] = {
+  {AXI_CTRL_WINDOW_NAME, AXI_CTRL_WINDOW_BASE, AXI_CTRL_WINDOW_SIZE, NULL, -1},
+  {AXI_FIFO_WINDOW_NAME, AXI_FIFO_WINDOW_BASE, AXI_FIFO_WINDOW_SIZE, NULL, -1},
+};
+#define MAP_WINDOW_COUNT (sizeof(g_map_windows) / sizeof(g_map_windows[0]))
+
+static map_backend_t g_map_backend = MAP_BACKEND_AUTO;
+static int g_hw_lock_fd = -1; // Hardware ownership lock, held until the process exits
+
+// A mapped DMA buffer
+typedef struct {
+  char name[64];             // u-dma-buf device name
+  uint32_t phys_addr;        // Physical base address
+  size_t size;               // Size in bytes
+  volatile uint32_t *mapped; // Host mapping
+} map_dma_buf_t;
+
+static map_dma_buf_t g_map_dma_bufs[MAP_DMA_BUF_MAX];
+static size_t g_map_dma_buf_count = 0;
+
+// Select the mapping backend
+void map_memory_set_backend(map_backend_t backend) {
+  g_map_backend = backend;
+}
+
+// Read a single line from a sysfs file (newline stripped)
+static int read_sysfs_line(const char *path, char *buf, size_t buf_size) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) return -1;
+  if (fgets(buf, (int)buf_size, f) == NULL) {
+    fclose(f);
+    return -1;
+  }
+  fclose(f);
+  buf[strcspn(buf, "\n")] = '\0';
+  return 0;
+}
+
+// Find the /dev/uioN device whose name matches uio_name
+int find_uio_device(const char *uio_name, char *dev_path, size_t dev_path_size) {
+  char path[128];
+  char name[64];
+  for (int i = 0; i < 32; i++) {
+    snprintf(path, sizeof(path), "/sys/class/uio/uio%d/name", i);
+    if (read_sysfs_line(path, name, sizeof(name)) != 0) continue;
+    if (strcmp(name, uio_name) == 0) {
+      if (dev_path != NULL) snprintf(dev_path, dev_path_size, "/dev/uio%d", i);
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Map a window from its UIO region (map0 of the matching UIO device)
+static volatile uint32_t *map_window_uio(map_window_t *window, bool verbose) {
+  char dev_path[32];
+  int uio_index = find_uio_device(window->name, dev_path, sizeof(dev_path));
+  if (uio_index < 0) {
+    if (verbose) printf("No UIO device exports window [%s]\n", window->name);
+    return NULL;
+  }
+
+  // Check that the exported region matches the window
+  char path[128];
+  char value[64];
+  snprintf(path, sizeof(path), "/sys/class/uio/uio%d/maps/map0/addr", uio_index);
+  if (read_sysfs_line(path, value, sizeof(value)) != 0 || strtoul(value, NULL, 0) != window->base_addr) {
+    fprintf(stderr, "UIO device %s does not start at window [%s] base 0x%" PRIx32 "\n", dev_path, window->name, window->base_addr);
+    return NULL;
+  }
+  snprintf(path, sizeof(path), "/sys/class/uio/uio%d/maps/map0/size", uio_index);
+  if (read_sysfs_line(path, value, sizeof(value)) != 0 || strtoul(value, NULL, 0) < window->size) {
+    fprintf(stderr, "UIO device %s is smaller than window [%s] (0x%" PRIx32 " bytes)\n", dev_path, window->name, window->size);
+    return NULL;
+  }
+
+  int uio_fd = open(dev_path, O_RDWR);
+  if (uio_fd < 0) {
+    perror("open");
+    return NULL;
+  }
+
+  // UIO map N is selected with an mmap offset of N pages
+  void *mapped = mmap(NULL, window->size, PROT_READ | PROT_WRITE, MAP_SHARED, uio_fd, 0);
+  close(uio_fd);
+  if (mapped == MAP_FAILED) {
+    perror("mmap");
+    return NULL;
+  }
+
+  window->uio_index = uio_index;
+  if (verbose) printf("Mapped window [%s] from %s\n", window->name, dev_path);
+  return (volatile uint32_t *)mapped;
+}
+
+// Real hardware is only mapped while holding the ownership lock, so every tool built on this
+// module (not just the ones that claim it up front) refuses to map under another owner
+static bool map_memory_own_hw(bool verbose) {
+  if (claim_hw_ownership(HW_OWNER_LOCK_PATH, verbose) >= 0) {
+    return true;
   }
+  fprintf(stderr, "Hardware is already owned by another process (lock '%s')\n", HW_OWNER_LOCK_PATH);
+  return false;
+}
 
+// Map a physical region through /dev/mem
+static volatile uint32_t *map_devmem(uint32_t base_addr, size_t size_bytes, const char *name, bool verbose) {
   // File descriptor for /dev/mem
   int dev_mem_fd;
   
@@ -26,30 +140,253 @@ uint32_t *map_32bit_memory(uint32_t base_addr, size_t wordcount, char *name, boo
 
   // Calculate the page size and the number of pages needed
   long page_size = sysconf(_SC_PAGESIZE);
-  size_t num_pages = ((wordcount * 4) + page_size - 1) / page_size; // Round up to the nearest page
+  size_t num_pages = (size_bytes + page_size - 1) / page_size; // Round up to the nearest page
 
   // Map the memory region
-  if (verbose) printf("Mapping %zu pages of size %ld bytes...\n", num_pages, page_size);
-  uint32_t *mapped_memory = (uint32_t *)mmap(NULL, num_pages * page_size, PROT_READ | PROT_WRITE, MAP_SHARED, dev_mem_fd, base_addr);
+  if (verbose) printf("Mapping %zu pages of size %ld bytes for [%s]...\n", num_pages, page_size, name);
+  void *mapped_memory = mmap(NULL, num_pages * page_size, PROT_READ | PROT_WRITE, MAP_SHARED, dev_mem_fd, base_addr);
+
+  // Close the file descriptor for /dev/mem (the mapping stays valid)
+  close(dev_mem_fd);
   
   // Check if the mapping was successful
   if (mapped_memory == MAP_FAILED) {
     perror("mmap");
-    close(dev_mem_fd);
     return NULL;
   }
 
+  return (volatile uint32_t *)mapped_memory;
+}
+
+// Map a whole registry window on first use
+static volatile uint32_t *map_window(map_window_t *window, bool verbose) {
+  if (window->mapped != NULL) {
+    return window->mapped;
+  }
+
+  if (g_map_backend == MAP_BACKEND_SIM) {
+    // Only the addresses matter: every access is routed to the simulator by physical address
+    void *mapped = mmap(NULL, window->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+      perror("mmap");
+      return NULL;
+    }
+    if (verbose) printf("Allocated simulated window [%s]\n", window->name);
+    window->mapped = (volatile uint32_t *)mapped;
+    return window->mapped;
+  }
+
+  if (!map_memory_own_hw(verbose)) {
+    return NULL;
+  }
+  if (g_map_backend != MAP_BACKEND_DEVMEM) {
+    window->mapped = map_window_uio(window, verbose);
+    if (window->mapped == NULL && g_map_backend == MAP_BACKEND_UIO) {
+      fprintf(stderr, "Window [%s] is not available as a UIO region\n", window->name);
+      return NULL;
+    }
+  }
+  if (window->mapped == NULL) {
+    window->mapped = map_devmem(window->base_addr, window->size, window->name, verbose);
+  }
+  return window->mapped;
+}
+
+// Map a 32-bit memory region
+uint32_t *map_32bit_memory(uint32_t base_addr, size_t wordcount, char *name, bool verbose) {
+
   if (verbose) {
-    printf("Memory region %s mapped", name);
+    printf("Mapping memory region [%s] at base address 0x%" PRIx32 " with size %zu bytes...\n", name, base_addr, wordcount * 4);
   }
 
-  // Close the file descriptor for /dev/mem
-  close(dev_mem_fd);
+  // Use the shared window mapping if the region lies inside one
+  for (size_t i = 0; i < MAP_WINDOW_COUNT; i++) {
+    map_window_t *window = &g_map_windows[i];
+    if (base_addr >= window->base_addr &&
+        (uint64_t)base_addr + wordcount * 4 <= (uint64_t)window->base_addr + window->size) {
+      volatile uint32_t *window_ptr = map_window(window, verbose);
+      if (window_ptr == NULL) {
+        return NULL;
+      }
+      if (verbose) {
+        printf("Memory region %s mapped at offset 0x%" PRIx32 " of window [%s]\n", name, base_addr - window->base_addr, window->name);
+      }
+      return (uint32_t *)(window_ptr + (base_addr - window->base_addr) / sizeof(uint32_t));
+    }
+  }
 
-  // Return the pointer to the mapped memory region
+  // Regions outside the registry get their own mapping
+  if (g_map_backend == MAP_BACKEND_SIM) {
+    fprintf(stderr, "Memory region %s at 0x%" PRIx32 " is outside every simulated window\n", name, base_addr);
+    return NULL;
+  }
+  if (g_map_backend == MAP_BACKEND_UIO) {
+    fprintf(stderr, "Memory region %s at 0x%" PRIx32 " is outside every UIO window\n", name, base_addr);
+    return NULL;
+  }
+  if (!map_memory_own_hw(verbose)) {
+    return NULL;
+  }
+  uint32_t *mapped_memory = (uint32_t *)map_devmem(base_addr, wordcount * 4, name, verbose);
+  if (mapped_memory != NULL && verbose) {
+    printf("Memory region %s mapped\n", name);
+  }
   return mapped_memory;
 }
 
+// Physical address of a pointer returned by map_32bit_memory
+uint32_t map_memory_phys_addr(const volatile uint32_t *ptr) {
+  for (size_t i = 0; i < MAP_WINDOW_COUNT; i++) {
+    map_window_t *window = &g_map_windows[i];
+    if (window->mapped == NULL) continue;
+    uintptr_t offset = (uintptr_t)ptr - (uintptr_t)window->mapped;
+    if ((uintptr_t)ptr >= (uintptr_t)window->mapped && offset < window->size) {
+      return window->base_addr + (uint32_t)offset;
+    }
+  }
+  return 0;
+}
+
+// Map a u-dma-buf DMA buffer
+volatile uint32_t *map_dma_buffer(const char *name, size_t sim_size, uint32_t *phys_addr, size_t *size_bytes, bool verbose) {
+  for (size_t i = 0; i < g_map_dma_buf_count; i++) {
+    if (strcmp(g_map_dma_bufs[i].name, name) == 0) {
+      *phys_addr = g_map_dma_bufs[i].phys_addr;
+      *size_bytes = g_map_dma_bufs[i].size;
+      return g_map_dma_bufs[i].mapped;
+    }
+  }
+  if (g_map_dma_buf_count >= MAP_DMA_BUF_MAX) {
+    fprintf(stderr, "Too many DMA buffers mapped (max %d)\n", MAP_DMA_BUF_MAX);
+    return NULL;
+  }
+  map_dma_buf_t *buf = &g_map_dma_bufs[g_map_dma_buf_count];
+  snprintf(buf->name, sizeof(buf->name), "%s", name);
+
+  if (g_map_backend == MAP_BACKEND_SIM) {
+    // Stacked after any earlier stand-ins, 64 KiB aligned
+    uint32_t base = MAP_SIM_DMA_BASE;
+    if (g_map_dma_buf_count > 0) {
+      map_dma_buf_t *prev = &g_map_dma_bufs[g_map_dma_buf_count - 1];
+      base = (uint32_t)((prev->phys_addr + prev->size + 0xFFFF) & ~(size_t)0xFFFF);
+    }
+    void *mapped = mmap(NULL, sim_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+      perror("mmap");
+      return NULL;
+    }
+    buf->phys_addr = base;
+    buf->size = sim_size;
+    buf->mapped = (volatile uint32_t *)mapped;
+    if (verbose) printf("Allocated simulated DMA buffer [%s] (%zu bytes)\n", name, sim_size);
+  } else {
+    if (!map_memory_own_hw(verbose)) {
+      return NULL;
+    }
+    // The driver reports where the buffer landed
+    char path[128];
+    char value[64];
+    snprintf(path, sizeof(path), "/sys/class/u-dma-buf/%s/phys_addr", name);
+    if (read_sysfs_line(path, value, sizeof(value)) != 0) {
+      fprintf(stderr, "No u-dma-buf device [%s] (is the u-dma-buf module loaded?)\n", name);
+      return NULL;
+    }
+    buf->phys_addr = (uint32_t)strtoul(value, NULL, 0);
+    snprintf(path, sizeof(path), "/sys/class/u-dma-buf/%s/size", name);
+    if (read_sysfs_line(path, value, sizeof(value)) != 0) {
+      fprintf(stderr, "Failed to read the size of u-dma-buf device [%s]\n", name);
+      return NULL;
+    }
+    buf->size = (size_t)strtoul(value, NULL, 0);
+
+    // O_SYNC gives an uncached mapping, so host writes reach DDR before the logic reads them
+    snprintf(path, sizeof(path), "/dev/%s", name);
+    int fd = open(path, O_RDWR | O_SYNC);
+    if (fd < 0) {
+      perror("open");
+      return NULL;
+    }
+    void *mapped = mmap(NULL, buf->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+      perror("mmap");
+      return NULL;
+    }
+    buf->mapped = (volatile uint32_t *)mapped;
+    if (verbose) printf("Mapped DMA buffer [%s] at 0x%08" PRIx32 " (%zu bytes)\n", name, buf->phys_addr, buf->size);
+  }
+
+  g_map_dma_buf_count++;
+  *phys_addr = buf->phys_addr;
+  *size_bytes = buf->size;
+  return buf->mapped;
+}
+
+// Host pointer to a physical range inside a mapped DMA buffer
+volatile uint32_t *map_memory_dma_ptr(uint32_t phys_addr, size_t size_bytes) {
+  for (size_t i = 0; i < g_map_dma_buf_count; i++) {
+    map_dma_buf_t *buf = &g_map_dma_bufs[i];
+    if (phys_addr >= buf->phys_addr && (uint64_t)phys_addr + size_bytes <= (uint64_t)buf->phys_addr + buf->size) {
+      return buf->mapped + (phys_addr - buf->phys_addr) / sizeof(uint32_t);
+    }
+  }
+  return NULL;
+}
+
+// Print the registry windows and how each one was mapped
+void map_memory_print_registry(void) {
+  for (size_t i = 0; i < MAP_WINDOW_COUNT; i++) {
+    map_window_t *window = &g_map_windows[i];
+    printf("  [%s] 0x%08" PRIx32 " - 0x%08" PRIx32 ": ", window->name,
+           window->base_addr, window->base_addr + window->size - 1);
+    if (window->mapped == NULL) {
+      printf("not mapped\n");
+    } else if (g_map_backend == MAP_BACKEND_SIM) {
+      printf("simulated\n");
+    } else if (window->uio_index >= 0) {
+      printf("mapped from /dev/uio%d\n", window->uio_index);
+    } else {
+      printf("mapped from /dev/mem\n");
+    }
+  }
+  for (size_t i = 0; i < g_map_dma_buf_count; i++) {
+    map_dma_buf_t *buf = &g_map_dma_bufs[i];
+    printf("  [%s] 0x%08" PRIx32 " - 0x%08" PRIx32 ": DMA buffer%s\n", buf->name, buf->phys_addr,
+           (uint32_t)(buf->phys_addr + buf->size - 1), g_map_backend == MAP_BACKEND_SIM ? " (simulated)" : "");
+  }
+}
+
+// Take exclusive ownership of the hardware mappings.
+// The lock is released automatically when the owning process exits.
+int claim_hw_ownership(const char *lock_path, bool verbose) {
+  // Already ours (a second flock on a new descriptor would conflict with our own lock)
+  if (g_hw_lock_fd >= 0) {
+    return g_hw_lock_fd;
+  }
+
+  // Open an existing lock without O_CREAT: with protected_regular set, O_CREAT on another user's
+  // file in sticky /tmp is refused even when its mode allows writing
+  int lock_fd = open(lock_path, O_RDWR);
+  if (lock_fd < 0 && errno == ENOENT) {
+    lock_fd = open(lock_path, O_RDWR | O_CREAT, 0666);
+    // The umask strips the group/other write bits; every user of the tools needs to open it
+    if (lock_fd >= 0) fchmod(lock_fd, 0666);
+  }
+  if (lock_fd < 0) {
+    perror("open");
+    return -1;
+  }
+
+  if (flock(lock_fd, LOCK_EX | LOCK_NB) != 0) {
+    close(lock_fd);
+    return -1;
+  }
+
+  if (verbose) printf("Claimed hardware ownership lock '%s'\n", lock_path);
+  g_hw_lock_fd = lock_fd;
+  return lock_fd;
+}
+
 // Convert offset binary format to signed value
 int16_t offset_to_signed(uint16_t val) {
   return (int16_t)((uint32_t)val - 0x8000);
@@ -0,0 +1,257 @@
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "preemph.h"
+
+// Parse a time with a ns/us/ms/s suffix into seconds
+static int parse_time_s(const char *str, double *seconds) {
+  char *endptr;
+  double value = strtod(str, &endptr);
+  if (endptr == str || value < 0) return -1;
+  if (strcmp(endptr, "ns") == 0) *seconds = value * 1e-9;
+  else if (strcmp(endptr, "us") == 0) *seconds = value * 1e-6;
+  else if (strcmp(endptr, "ms") == 0) *seconds = value * 1e-3;
+  else if (strcmp(endptr, "s") == 0) *seconds = value;
+  else return -1;
+  return 0;
+}
+
+// Create an empty set
+struct preemph_t create_preemph(void) {
+  struct preemph_t preemph;
+  memset(&preemph, 0, sizeof(preemph));
+  return preemph;
+}
+
+// Load a coefficients file
+int preemph_load(struct preemph_t *preemph, const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open pre-emphasis file '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  struct preemph_t loaded = create_preemph();
+  char line[256];
+  int line_num = 0;
+  int terms = 0;
+  while (fgets(line, sizeof(line), file)) {
+    line_num++;
+    char *comment = strchr(line, '#');
+    if (comment != NULL) *comment = '\0';
+
+    char field[3][64];
+    int fields = sscanf(line, "%63s %63s %63s", field[0], field[1], field[2]);
+    if (fields <= 0) continue;
+
+    if (strcmp(field[0], "trigger_hold") == 0) {
+      if (fields != 2 || parse_time_s(field[1], &loaded.trigger_hold_s) != 0) {
+        fprintf(stderr, "Invalid line %d: expected 'trigger_hold <time>' (ns/us/ms/s)\n", line_num);
+        fclose(file);
+        return -1;
+      }
+      continue;
+    }
+
+    if (fields != 3) {
+      fprintf(stderr, "Invalid line %d: expected '<channel|*> <amplitude> <tau>'\n", line_num);
+      fclose(file);
+      return -1;
+    }
+    int first_ch = 0, last_ch = PREEMPH_CHANNELS - 1;
+    if (strcmp(field[0], "*") != 0) {
+      char *endptr;
+      long ch = strtol(field[0], &endptr, 10);
+      if (*endptr != '\0' || ch < 0 || ch >= PREEMPH_CHANNELS) {
+        fprintf(stderr, "Invalid line %d: channel '%s' must be 0-%d or '*'\n", line_num, field[0], PREEMPH_CHANNELS - 1);
+        fclose(file);
+        return -1;
+      }
+      first_ch = last_ch = (int)ch;
+    }
+    char *endptr;
+    double amplitude = strtod(field[1], &endptr);
+    if (*endptr != '\0' || fabs(amplitude) > PREEMPH_MAX_AMPLITUDE) {
+      fprintf(stderr, "Invalid line %d: amplitude '%s' must be within +/-%.1f\n", line_num, field[1], PREEMPH_MAX_AMPLITUDE);
+      fclose(file);
+      return -1;
+    }
+    double tau_s;
+    if (parse_time_s(field[2], &tau_s) != 0 || tau_s <= 0) {
+      fprintf(stderr, "Invalid line %d: time constant '%s' must be a positive time with ns/us/ms/s\n", line_num, field[2]);
+      fclose(file);
+      return -1;
+    }
+
+    for (int ch = first_ch; ch <= last_ch; ch++) {
+      int k = loaded.term_count[ch];
+      if (k >= PREEMPH_MAX_TERMS) {
+        fprintf(stderr, "Invalid line %d: channel %d already has %d terms\n", line_num, ch, PREEMPH_MAX_TERMS);
+        fclose(file);
+        return -1;
+      }
+      loaded.amplitude[ch][k] = amplitude;
+      loaded.amplitude_q15[ch][k] = (int32_t)lround(amplitude * (1 << PREEMPH_Q15_BITS));
+      loaded.tau_s[ch][k] = tau_s;
+      loaded.term_count[ch] = k + 1;
+    }
+    terms++;
+  }
+  fclose(file);
+
+  if (terms == 0) {
+    fprintf(stderr, "Pre-emphasis file '%s' has no terms\n", path);
+    return -1;
+  }
+  loaded.loaded = true;
+  loaded.generation = preemph->generation + 1;
+  snprintf(loaded.path, sizeof(loaded.path), "%s", path);
+  *preemph = loaded;
+  return 0;
+}
+
+// Whether any of a board's channels has a term
+bool preemph_board_active(const struct preemph_t *preemph, uint8_t board) {
+  if (!preemph->loaded || board > 7) return false;
+  for (int channel = 0; channel < 8; channel++) {
+    if (preemph->term_count[board * 8 + channel] > 0) return true;
+  }
+  return false;
+}
+
+// Start a board's filter at rest
+struct preemph_state_t create_preemph_state(uint8_t board, uint32_t spi_clk_freq_hz) {
+  struct preemph_state_t state;
+  memset(&state, 0, sizeof(state));
+  state.board = board;
+  state.spi_clk_freq_hz = spi_clk_freq_hz;
+  state.decay_cycles = PREEMPH_HOLD_SETTLED; // No decays cached yet
+  return state;
+}
+
+// Filter one word group, then hold
+void preemph_step(const struct preemph_t *preemph, struct preemph_state_t *state, int16_t ch_vals[8], uint32_t hold_cycles) {
+  const int base = state->board * 8;
+  int32_t amplitude[PREEMPH_MAX_TERMS][8];
+  int terms = 0;
+  for (int lane = 0; lane < 8; lane++) {
+    if (preemph->term_count[base + lane] > terms) terms = preemph->term_count[base + lane];
+    for (int k = 0; k < PREEMPH_MAX_TERMS; k++) {
+      amplitude[k][lane] = (k < preemph->term_count[base + lane]) ? preemph->amplitude_q15[base + lane][k] : 0;
+    }
+  }
+
+  if (ch_vals != NULL) {
+    // y = x + sum_k a_k * (x - l_k), accumulated in Q(15 + 8)
+    int32_t x[8];
+    int64_t acc[8];
+    for (int lane = 0; lane < 8; lane++) {
+      x[lane] = (int32_t)ch_vals[lane] << PREEMPH_STATE_BITS;
+      acc[lane] = (int64_t)x[lane] << PREEMPH_Q15_BITS;
+    }
+    for (int k = 0; k < terms; k++) {
+      for (int lane = 0; lane < 8; lane++) {
+        acc[lane] += (int64_t)amplitude[k][lane] * (x[lane] - state->level[k][lane]);
+      }
+    }
+    const int shift = PREEMPH_Q15_BITS + PREEMPH_STATE_BITS;
+    for (int lane = 0; lane < 8; lane++) {
+      int32_t y = (int32_t)((acc[lane] + ((int64_t)1 << (shift - 1))) >> shift);
+      int32_t magnitude = y < 0 ? -y : y;
+      if (magnitude > state->peak[lane]) state->peak[lane] = magnitude;
+      state->input[lane] = ch_vals[lane];
+      if (y > PREEMPH_DAC_LIMIT) {
+        y = PREEMPH_DAC_LIMIT;
+        state->clipped[lane]++;
+      } else if (y < -PREEMPH_DAC_LIMIT) {
+        y = -PREEMPH_DAC_LIMIT;
+        state->clipped[lane]++;
+      }
+      ch_vals[lane] = (int16_t)y;
+    }
+    state->writes++;
+  }
+
+  // Each level relaxes towards the held input: l_k = x + (l_k - x) * exp(-hold / tau_k)
+  int32_t x[8];
+  for (int lane = 0; lane < 8; lane++) x[lane] = (int32_t)state->input[lane] << PREEMPH_STATE_BITS;
+  if (hold_cycles == PREEMPH_HOLD_SETTLED || state->spi_clk_freq_hz == 0) {
+    for (int k = 0; k < terms; k++) {
+      for (int lane = 0; lane < 8; lane++) state->level[k][lane] = x[lane];
+    }
+    state->residual = 0;
+    return;
+  }
+  if (hold_cycles != state->decay_cycles) {
+    // Waveforms reuse a handful of delays, so the exponentials are only evaluated when the hold changes
+    double hold_s = (double)hold_cycles / state->spi_clk_freq_hz;
+    for (int k = 0; k < PREEMPH_MAX_TERMS; k++) {
+      for (int lane = 0; lane < 8; lane++) {
+        state->decay[k][lane] = (k < preemph->term_count[base + lane])
+          ? (int32_t)lround(exp(-hold_s / preemph->tau_s[base + lane][k]) * (1 << PREEMPH_Q15_BITS)) : 0;
+      }
+    }
+    state->decay_cycles = hold_cycles;
+  }
+  int32_t residual = 0;
+  for (int k = 0; k < terms; k++) {
+    for (int lane = 0; lane < 8; lane++) {
+      int64_t delta = (int64_t)state->decay[k][lane] * (state->level[k][lane] - x[lane]);
+      int32_t level = x[lane] + (int32_t)((delta + (1 << (PREEMPH_Q15_BITS - 1))) >> PREEMPH_Q15_BITS);
+      state->level[k][lane] = level;
+      int32_t diff = level - x[lane];
+      if (diff < 0) diff = -diff;
+      if ((diff >> PREEMPH_STATE_BITS) > residual) residual = diff >> PREEMPH_STATE_BITS;
+    }
+  }
+  state->residual = residual;
+}
+
+// Hold cycles assumed for a trigger wait
+uint32_t preemph_trigger_hold_cycles(const struct preemph_t *preemph, uint32_t trigger_count, uint32_t spi_clk_freq_hz) {
+  if (preemph->trigger_hold_s <= 0) return PREEMPH_HOLD_SETTLED;
+  double cycles = preemph->trigger_hold_s * spi_clk_freq_hz * (trigger_count > 0 ? trigger_count : 1);
+  return cycles >= (double)(PREEMPH_HOLD_SETTLED - 1) ? PREEMPH_HOLD_SETTLED - 1 : (uint32_t)cycles;
+}
+
+// Print the coefficients of every filtered channel
+void preemph_print(const struct preemph_t *preemph, FILE *out) {
+  if (!preemph->loaded) {
+    fprintf(out, "No pre-emphasis loaded (waveforms are played verbatim).\n");
+    return;
+  }
+  fprintf(out, "Pre-emphasis from '%s':\n", preemph->path);
+  if (preemph->trigger_hold_s > 0) {
+    fprintf(out, "  Trigger waits assumed to last %.3f ms each\n", preemph->trigger_hold_s * 1e3);
+  } else {
+    fprintf(out, "  Trigger waits assumed long enough for every term to settle\n");
+  }
+  fprintf(out, "  %-4s %s\n", "ch", "terms (amplitude @ tau)");
+  for (int ch = 0; ch < PREEMPH_CHANNELS; ch++) {
+    if (preemph->term_count[ch] == 0) continue;
+    fprintf(out, "  %-4d", ch);
+    for (int k = 0; k < preemph->term_count[ch]; k++) {
+      fprintf(out, " %+.4f @ %.3f ms", preemph->amplitude[ch][k], preemph->tau_s[ch][k] * 1e3);
+    }
+    fprintf(out, "\n");
+  }
+}
+
+// Print a board's clipping report
+void preemph_print_report(const struct preemph_state_t *state, FILE *out) {
+  uint64_t clipped = 0;
+  for (int lane = 0; lane < 8; lane++) clipped += state->clipped[lane];
+  fprintf(out, "  Board %u pre-emphasis: %llu writes, %llu clipped channel values\n", state->board,
+          (unsigned long long)state->writes, (unsigned long long)clipped);
+  for (int lane = 0; lane < 8; lane++) {
+    if (state->clipped[lane] == 0) continue;
+    fprintf(out, "    ch %d: %llu writes clipped, peak %d codes (%.1f%% over full scale)\n",
+            state->board * 8 + lane, (unsigned long long)state->clipped[lane], state->peak[lane],
+            100.0 * (state->peak[lane] - PREEMPH_DAC_LIMIT) / PREEMPH_DAC_LIMIT);
+  }
+  if (state->residual > 0) {
+    fprintf(out, "    Filter hasn't settled by the end of the waveform (%d codes left); repeated passes each start from rest\n",
+            state->residual);
+  }
+}
@@ -0,0 +1,130 @@
+#include <string.h>
+#include "regulator.h"
+
+static const uint32_t loop_hist_edges_us[LOOP_HIST_BINS - 1] = {
+  1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000
+};
+
+static int32_t gain_to_q16(double gain) {
+  if (gain > PI_CTRL_MAX_GAIN) gain = PI_CTRL_MAX_GAIN;
+  if (gain < -PI_CTRL_MAX_GAIN) gain = -PI_CTRL_MAX_GAIN;
+  return (int32_t)(gain * (1 << PI_CTRL_FRAC_BITS) + (gain >= 0 ? 0.5 : -0.5));
+}
+
+// Create a controller
+struct pi_ctrl_t create_pi_ctrl(double kp, double ki, int32_t limit) {
+  struct pi_ctrl_t pi = {
+    .kp = gain_to_q16(kp),
+    .ki = gain_to_q16(ki),
+    .integral = 0,
+    .limit = (limit > 0 && limit <= PI_CTRL_OUTPUT_LIMIT) ? limit : PI_CTRL_OUTPUT_LIMIT,
+    .saturated = false
+  };
+  return pi;
+}
+
+// One controller step
+int16_t pi_ctrl_update(struct pi_ctrl_t *pi, int16_t target, int32_t measured) {
+  int64_t error = (int64_t)target - measured;
+  int64_t limit_q16 = (int64_t)pi->limit << PI_CTRL_FRAC_BITS;
+
+  // Conditional integration: hold the integrator while saturated in the error's direction
+  int64_t integral = pi->integral + pi->ki * error;
+  if (integral > limit_q16) integral = limit_q16;
+  if (integral < -limit_q16) integral = -limit_q16;
+
+  int64_t out_q16 = ((int64_t)target << PI_CTRL_FRAC_BITS) + pi->kp * error + integral;
+  int64_t out = (out_q16 + (1 << (PI_CTRL_FRAC_BITS - 1))) >> PI_CTRL_FRAC_BITS;
+  bool saturated = false;
+  if (out > pi->limit) {
+    out = pi->limit;
+    saturated = true;
+  } else if (out < -pi->limit) {
+    out = -pi->limit;
+    saturated = true;
+  }
+  if (!saturated || (error > 0) != (out > 0)) {
+    pi->integral = integral;
+  }
+  pi->saturated = saturated;
+  return (int16_t)out;
+}
+
+// Clear the integrator
+void pi_ctrl_reset(struct pi_ctrl_t *pi) {
+  pi->integral = 0;
+  pi->saturated = false;
+}
+
+// Create an empty histogram
+struct loop_hist_t create_loop_hist(void) {
+  struct loop_hist_t hist;
+  memset(&hist, 0, sizeof(hist));
+  hist.min_ns = UINT64_MAX;
+  return hist;
+}
+
+// Add one sample
+void loop_hist_add(struct loop_hist_t *hist, uint64_t ns) {
+  int bin = 0;
+  while (bin < LOOP_HIST_BINS - 1 && ns >= (uint64_t)loop_hist_edges_us[bin] * 1000) bin++;
+  hist->bins[bin]++;
+  hist->count++;
+  hist->sum_ns += ns;
+  if (ns < hist->min_ns) hist->min_ns = ns;
+  if (ns > hist->max_ns) hist->max_ns = ns;
+}
+
+// Upper edge of a bucket in microseconds
+uint32_t loop_hist_edge_us(int bin) {
+  return (bin >= 0 && bin < LOOP_HIST_BINS - 1) ? loop_hist_edges_us[bin] : 0;
+}
+
+// Percentile estimate from the buckets
+uint64_t loop_hist_percentile_ns(const struct loop_hist_t *hist, double percentile) {
+  if (hist->count == 0) return 0;
+  uint64_t rank = (uint64_t)(percentile / 100.0 * hist->count + 0.5);
+  if (rank < 1) rank = 1;
+  uint64_t seen = 0;
+  for (int bin = 0; bin < LOOP_HIST_BINS - 1; bin++) {
+    seen += hist->bins[bin];
+    if (seen >= rank) {
+      uint64_t edge_ns = (uint64_t)loop_hist_edges_us[bin] * 1000;
+      return edge_ns < hist->max_ns ? edge_ns : hist->max_ns;
+    }
+  }
+  return hist->max_ns;
+}
+
+// Print the statistics and the non-empty buckets
+void loop_hist_print(const struct loop_hist_t *hist, const char *name, FILE *out) {
+  if (hist->count == 0) {
+    fprintf(out, "  %s: no samples\n", name);
+    return;
+  }
+  fprintf(out, "  %s: min %.1f us, mean %.1f us, p99 <= %.1f us, max %.1f us (%llu samples)\n", name,
+          hist->min_ns / 1000.0, (double)hist->sum_ns / hist->count / 1000.0,
+          loop_hist_percentile_ns(hist, 99.0) / 1000.0, hist->max_ns / 1000.0,
+          (unsigned long long)hist->count);
+
+  uint64_t peak = 0;
+  for (int bin = 0; bin < LOOP_HIST_BINS; bin++) {
+    if (hist->bins[bin] > peak) peak = hist->bins[bin];
+  }
+  uint32_t low_us = 0;
+  for (int bin = 0; bin < LOOP_HIST_BINS; bin++) {
+    uint32_t high_us = loop_hist_edge_us(bin);
+    if (hist->bins[bin] > 0) {
+      char range[32];
+      if (high_us > 0) {
+        snprintf(range, sizeof(range), "%u-%u us", low_us, high_us);
+      } else {
+        snprintf(range, sizeof(range), ">= %u us", low_us);
+      }
+      int bar = (int)((hist->bins[bin] * 40 + peak - 1) / peak);
+      fprintf(out, "    %-14s %10llu %5.1f%% %.*s\n", range, (unsigned long long)hist->bins[bin],
+              100.0 * hist->bins[bin] / hist->count, bar, "########################################");
+    }
+    low_us = high_us;
+  }
+}
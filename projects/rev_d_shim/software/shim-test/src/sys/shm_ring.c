@@ -0,0 +1,175 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "shm_ring.h"
+
+// Map an open shared memory object and fill in the ring pointers
+static int shm_ring_map(struct shm_ring_t *ring, int fd, size_t map_size, int prot) {
+  void *mem = mmap(NULL, map_size, prot, MAP_SHARED, fd, 0);
+  if (mem == MAP_FAILED) {
+    fprintf(stderr, "Failed to map shared memory ring '%s': %s\n", ring->name, strerror(errno));
+    return -1;
+  }
+  ring->header = (shm_ring_header_t *)mem;
+  ring->data = (volatile uint32_t *)((uint8_t *)mem + sizeof(shm_ring_header_t));
+  ring->map_size = map_size;
+  return 0;
+}
+
+// Create (or recreate) a ring as its writer
+int shm_ring_create(struct shm_ring_t *ring, const char *name, uint32_t capacity_words, bool verbose) {
+  if (capacity_words == 0 || (capacity_words & (capacity_words - 1)) != 0 || capacity_words > (1u << 30)) {
+    fprintf(stderr, "Shared memory ring size must be a power of two up to 2^30 (got %u words)\n", capacity_words);
+    return -1;
+  }
+
+  memset(ring, 0, sizeof(*ring));
+  snprintf(ring->name, sizeof(ring->name), "%s", name);
+  ring->owner = true;
+
+  // Remove any stale ring left behind by a previous daemon
+  shm_unlink(ring->name);
+
+  int fd = shm_open(ring->name, O_CREAT | O_RDWR, 0666);
+  if (fd < 0) {
+    fprintf(stderr, "Failed to create shared memory ring '%s': %s\n", ring->name, strerror(errno));
+    return -1;
+  }
+  fchmod(fd, 0666); // Readers don't need to run as the daemon's user
+
+  size_t map_size = sizeof(shm_ring_header_t) + (size_t)capacity_words * sizeof(uint32_t);
+  if (ftruncate(fd, (off_t)map_size) != 0) {
+    fprintf(stderr, "Failed to size shared memory ring '%s': %s\n", ring->name, strerror(errno));
+    close(fd);
+    shm_unlink(ring->name);
+    return -1;
+  }
+
+  int result = shm_ring_map(ring, fd, map_size, PROT_READ | PROT_WRITE);
+  close(fd);
+  if (result != 0) {
+    shm_unlink(ring->name);
+    return -1;
+  }
+
+  ring->header->capacity_words = capacity_words;
+  ring->header->write_count = 0;
+  ring->header->write_claim = 0;
+  ring->header->active = 1;
+  __atomic_store_n(&ring->header->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+
+  if (verbose) {
+    printf("Created shared memory ring '%s' (%u words, %zu bytes)\n", ring->name, capacity_words, map_size);
+  }
+  return 0;
+}
+
+// Attach to an existing ring as a reader
+int shm_ring_attach(struct shm_ring_t *ring, const char *name, bool verbose) {
+  memset(ring, 0, sizeof(*ring));
+  snprintf(ring->name, sizeof(ring->name), "%s", name);
+  ring->owner = false;
+
+  int fd = shm_open(ring->name, O_RDONLY, 0);
+  if (fd < 0) {
+    fprintf(stderr, "Failed to open shared memory ring '%s': %s\n", ring->name, strerror(errno));
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(shm_ring_header_t)) {
+    fprintf(stderr, "Shared memory ring '%s' is not initialized\n", ring->name);
+    close(fd);
+    return -1;
+  }
+
+  int result = shm_ring_map(ring, fd, (size_t)st.st_size, PROT_READ);
+  close(fd);
+  if (result != 0) {
+    return -1;
+  }
+
+  if (__atomic_load_n(&ring->header->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC ||
+      sizeof(shm_ring_header_t) + (size_t)ring->header->capacity_words * sizeof(uint32_t) > ring->map_size) {
+    fprintf(stderr, "Shared memory ring '%s' has an invalid header\n", ring->name);
+    shm_ring_close(ring);
+    return -1;
+  }
+
+  if (verbose) {
+    printf("Attached to shared memory ring '%s' (%u words)\n", ring->name, ring->header->capacity_words);
+  }
+  return 0;
+}
+
+// Append words to the ring (writer only)
+void shm_ring_write(struct shm_ring_t *ring, const uint32_t *words, uint32_t count) {
+  uint32_t mask = ring->header->capacity_words - 1;
+  uint32_t write_count = ring->header->write_count;
+  // Claim the slots before overwriting them, so readers copying them notice
+  __atomic_store_n(&ring->header->write_claim, write_count + count, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  for (uint32_t i = 0; i < count; i++) {
+    ring->data[(write_count + i) & mask] = words[i];
+  }
+  // Publish the data before the new write count
+  __atomic_store_n(&ring->header->write_count, write_count + count, __ATOMIC_RELEASE);
+}
+
+// Position of the next word the writer will write
+uint32_t shm_ring_position(const struct shm_ring_t *ring) {
+  return __atomic_load_n(&ring->header->write_count, __ATOMIC_ACQUIRE);
+}
+
+// Copy words out of the ring (reader side)
+int64_t shm_ring_read(const struct shm_ring_t *ring, uint32_t *read_count, uint32_t *out, uint32_t max_words) {
+  uint32_t capacity = ring->header->capacity_words;
+  uint32_t mask = capacity - 1;
+  uint32_t write_count = __atomic_load_n(&ring->header->write_count, __ATOMIC_ACQUIRE);
+
+  if (write_count - *read_count > capacity) {
+    *read_count = write_count - capacity;
+    return -1;
+  }
+
+  uint32_t available = write_count - *read_count;
+  uint32_t count = available > max_words ? max_words : available;
+  for (uint32_t i = 0; i < count; i++) {
+    out[i] = ring->data[(*read_count + i) & mask];
+  }
+
+  // The writer may have started overwriting what we copied
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  uint32_t write_claim = __atomic_load_n(&ring->header->write_claim, __ATOMIC_RELAXED);
+  if (write_claim - *read_count > capacity) {
+    *read_count = write_claim - capacity;
+    return -1;
+  }
+
+  *read_count += count;
+  return count;
+}
+
+// Whether the writer is still streaming into the ring
+bool shm_ring_active(const struct shm_ring_t *ring) {
+  return __atomic_load_n(&ring->header->active, __ATOMIC_ACQUIRE) != 0;
+}
+
+// Unmap the ring, unlinking it if this handle is the writer
+void shm_ring_close(struct shm_ring_t *ring) {
+  if (ring->header == NULL) {
+    return;
+  }
+  if (ring->owner) {
+    __atomic_store_n(&ring->header->active, 0, __ATOMIC_RELEASE);
+    shm_unlink(ring->name);
+  }
+  munmap((void *)ring->header, ring->map_size);
+  ring->header = NULL;
+  ring->data = NULL;
+}
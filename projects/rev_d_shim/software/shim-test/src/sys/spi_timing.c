@@ -0,0 +1,115 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "spi_timing.h"
+
+// Cycles covering t_nis NiS at spi_clk_freq_hz, rounded up (f * T + 2^30 - 1) >> 30
+static uint32_t nis_to_cycles(uint64_t t_nis, uint32_t spi_clk_freq_hz) {
+  uint64_t product = (uint64_t)spi_clk_freq_hz * t_nis + ((1ULL << SPI_TIMING_NIS_SHIFT) - 1);
+  return (uint32_t)(product >> SPI_TIMING_NIS_SHIFT);
+}
+
+// DAC ~CS high time (as shim_ad5676_dac_timing_calc)
+uint32_t spi_timing_dac_n_cs_high_time(uint32_t spi_clk_freq_hz) {
+  // The update time is compared against the whole word without subtracting the 24 data bits,
+  // which the hardware does too (conservative at low clock rates)
+  uint32_t update = nis_to_cycles(SPI_TIMING_DAC_T_UPDATE_NIS, spi_clk_freq_hz);
+  if (update <= SPI_TIMING_DAC_SPI_BITS) update = 0;
+  uint32_t min_high = nis_to_cycles(SPI_TIMING_DAC_T_MIN_N_CS_NIS, spi_clk_freq_hz);
+  if (min_high < SPI_TIMING_DAC_MIN_N_CS_CYCLES) min_high = SPI_TIMING_DAC_MIN_N_CS_CYCLES;
+  uint32_t cycles = update > min_high ? update : min_high;
+  return cycles >= SPI_TIMING_DAC_MAX_N_CS_CYCLES ? SPI_TIMING_DAC_MAX_N_CS_CYCLES - 1 : cycles - 1;
+}
+
+// ADC ~CS high time (as shim_ads816x_adc_timing_calc for the ADS8168)
+uint32_t spi_timing_adc_n_cs_high_time(uint32_t spi_clk_freq_hz) {
+  uint32_t conv = nis_to_cycles(SPI_TIMING_ADC_T_CONV_NIS, spi_clk_freq_hz);
+  if (conv < SPI_TIMING_ADC_MIN_N_CS_CYCLES) conv = SPI_TIMING_ADC_MIN_N_CS_CYCLES;
+  uint32_t cycle = nis_to_cycles(SPI_TIMING_ADC_T_CYCLE_NIS, spi_clk_freq_hz);
+  cycle = cycle > SPI_TIMING_ADC_SPI_BITS ? cycle - SPI_TIMING_ADC_SPI_BITS : 0;
+  uint32_t cycles = conv > cycle ? conv : cycle;
+  return cycles >= SPI_TIMING_ADC_MAX_N_CS_CYCLES ? SPI_TIMING_ADC_MAX_N_CS_CYCLES - 1 : cycles - 1;
+}
+
+// Compute the timing for an SPI clock frequency
+struct spi_timing_t create_spi_timing(uint32_t spi_clk_freq_hz) {
+  struct spi_timing_t timing;
+  memset(&timing, 0, sizeof(timing));
+  if (spi_clk_freq_hz == 0) return timing;
+
+  timing.spi_clk_freq_hz = spi_clk_freq_hz;
+  timing.dac_n_cs_high_time = spi_timing_dac_n_cs_high_time(spi_clk_freq_hz);
+  timing.adc_n_cs_high_time = spi_timing_adc_n_cs_high_time(spi_clk_freq_hz);
+  timing.dac_word_cycles = (timing.dac_n_cs_high_time + 1) + SPI_TIMING_DAC_SPI_BITS + SPI_TIMING_WORD_OVERHEAD_CYCLES;
+  timing.adc_word_cycles = (timing.adc_n_cs_high_time + 1) + SPI_TIMING_ADC_SPI_BITS + SPI_TIMING_WORD_OVERHEAD_CYCLES;
+  timing.dac_wr_min_delay = SPI_TIMING_DAC_WR_WORDS * timing.dac_word_cycles + SPI_TIMING_CMD_OVERHEAD_CYCLES;
+  timing.dac_wr_ch_cycles = SPI_TIMING_DAC_WR_CH_WORDS * timing.dac_word_cycles + SPI_TIMING_CMD_OVERHEAD_CYCLES;
+  timing.adc_rd_min_delay = SPI_TIMING_ADC_RD_WORDS * timing.adc_word_cycles + SPI_TIMING_CMD_OVERHEAD_CYCLES;
+  timing.adc_rd_ch_cycles = SPI_TIMING_ADC_RD_CH_WORDS * timing.adc_word_cycles + SPI_TIMING_CMD_OVERHEAD_CYCLES;
+  return timing;
+}
+
+uint32_t spi_timing_adc_rd_avg_min_delay(const struct spi_timing_t *timing, uint32_t avg_log2) {
+  uint32_t words = ((SPI_TIMING_ADC_RD_WORDS - 1) << avg_log2) + 1;
+  return words * timing->adc_word_cycles + SPI_TIMING_CMD_OVERHEAD_CYCLES;
+}
+
+bool spi_timing_valid(const struct spi_timing_t *timing) {
+  return timing->spi_clk_freq_hz != 0;
+}
+
+uint64_t spi_timing_ns_to_cycles(const struct spi_timing_t *timing, double ns) {
+  if (ns <= 0) return 0;
+  // Drop floating-point noise before rounding up so exact multiples of the period stay exact
+  double cycles = ns * timing->spi_clk_freq_hz / 1e9;
+  return (uint64_t)ceil(cycles - 1e-9);
+}
+
+double spi_timing_cycles_to_ns(const struct spi_timing_t *timing, uint64_t cycles) {
+  if (timing->spi_clk_freq_hz == 0) return 0;
+  return (double)cycles * 1e9 / timing->spi_clk_freq_hz;
+}
+
+// Parse a delay in cycles, "min", or a physical time
+int spi_timing_parse_delay(const struct spi_timing_t *timing, const char *str, uint32_t min_cycles, uint32_t *cycles) {
+  if (strcmp(str, "min") == 0) {
+    if (!spi_timing_valid(timing)) return -1;
+    *cycles = min_cycles;
+    return 0;
+  }
+
+  char *endptr;
+  if (strncmp(str, "0x", 2) == 0 || strncmp(str, "0X", 2) == 0) {
+    unsigned long value = strtoul(str, &endptr, 16);
+    if (*endptr != '\0' || value > SPI_TIMING_MAX_DELAY_CYCLES) return -1;
+    *cycles = (uint32_t)value;
+    return 0;
+  }
+
+  double value = strtod(str, &endptr);
+  if (endptr == str || value < 0) return -1;
+
+  double scale_ns;
+  if (*endptr == '\0') {
+    // Plain cycle count (must be an integer)
+    if (value != floor(value) || value > SPI_TIMING_MAX_DELAY_CYCLES) return -1;
+    *cycles = (uint32_t)value;
+    return 0;
+  } else if (strcmp(endptr, "ns") == 0) {
+    scale_ns = 1.0;
+  } else if (strcmp(endptr, "us") == 0) {
+    scale_ns = 1e3;
+  } else if (strcmp(endptr, "ms") == 0) {
+    scale_ns = 1e6;
+  } else if (strcmp(endptr, "s") == 0) {
+    scale_ns = 1e9;
+  } else {
+    return -1;
+  }
+
+  if (!spi_timing_valid(timing)) return -1;
+  uint64_t converted = spi_timing_ns_to_cycles(timing, value * scale_ns);
+  if (converted > SPI_TIMING_MAX_DELAY_CYCLES) return -1;
+  *cycles = (uint32_t)converted;
+  return 0;
+}
@@ -4,6 +4,7 @@
 #include <sys/mman.h> // For mmap function
 #include "sys_ctrl.h"    // Include the header for sys_ctrl structure
 #include "map_memory.h"  // Include the header for map_memory function
+#include "hw_backend.h"  // Include the header for register access functions
 
 // Create a system control structure
 struct sys_ctrl_t create_sys_ctrl(bool verbose) {
@@ -34,7 +35,7 @@ void sys_ctrl_turn_on(struct sys_ctrl_t *sys_ctrl, bool verbose) {
   if (verbose) {
     printf("Turning on the system...\n");
   }
-  *(sys_ctrl->system_enable) = 1; // Set the system enable register to 1
+  hw_write32(sys_ctrl->system_enable, 1); // Set the system enable register to 1
 }
 
 // Turn the system off
@@ -42,7 +43,7 @@ void sys_ctrl_turn_off(struct sys_ctrl_t *sys_ctrl, bool verbose) {
   if (verbose) {
     printf("Turning off the system...\n");
   }
-  *(sys_ctrl->system_enable) = 0; // Set the system enable register to 0
+  hw_write32(sys_ctrl->system_enable, 0); // Set the system enable register to 0
 }
 
 // Set the boot_test_skip register to a 16-bit value
@@ -51,9 +52,9 @@ void sys_ctrl_set_boot_test_skip(struct sys_ctrl_t *sys_ctrl, uint16_t value, bo
     printf("Setting boot_test_skip to 0x%" PRIx32 "\n", value);
   }
   // Write the 16-bit value to the boot_test_skip register
-  *(sys_ctrl->boot_test_skip) = (uint32_t)value;
+  hw_write32(sys_ctrl->boot_test_skip, (uint32_t)value);
   if (verbose) {
-    printf("boot_test_skip set to 0x%" PRIx32 "\n", *(sys_ctrl->boot_test_skip));
+    printf("boot_test_skip set to 0x%" PRIx32 "\n", hw_read32(sys_ctrl->boot_test_skip));
   }
 }
 
@@ -63,9 +64,9 @@ void sys_ctrl_set_debug(struct sys_ctrl_t *sys_ctrl, uint16_t value, bool verbos
     printf("Setting debug to 0x%" PRIx32 "\n", value);
   }
   // Write the 16-bit value to the debug register
-  *(sys_ctrl->debug) = (uint32_t)value;
+  hw_write32(sys_ctrl->debug, (uint32_t)value);
   if (verbose) {
-    printf("debug set to 0x%" PRIx32 "\n", *(sys_ctrl->debug));
+    printf("debug set to 0x%" PRIx32 "\n", hw_read32(sys_ctrl->debug));
   }
 }
 
@@ -79,9 +80,9 @@ void sys_ctrl_set_cmd_buf_reset(struct sys_ctrl_t *sys_ctrl, uint32_t mask, bool
     printf("Setting cmd_buf_reset to 0x%" PRIx32 "\n", mask);
   }
   // Write the 17-bit mask to the cmd_buf_reset register
-  *(sys_ctrl->cmd_buf_reset) = mask & 0x1FFFF; // Mask to 17 bits
+  hw_write32(sys_ctrl->cmd_buf_reset, mask & 0x1FFFF); // Mask to 17 bits
   if (verbose) {
-    printf("cmd_buf_reset set to 0x%" PRIx32 "\n", *(sys_ctrl->cmd_buf_reset));
+    printf("cmd_buf_reset set to 0x%" PRIx32 "\n", hw_read32(sys_ctrl->cmd_buf_reset));
   }
 }
 
@@ -95,41 +96,41 @@ void sys_ctrl_set_data_buf_reset(struct sys_ctrl_t *sys_ctrl, uint32_t mask, boo
     printf("Setting data_buf_reset to 0x%" PRIx32 "\n", mask);
   }
   // Write the 17-bit mask to the data_buf_reset register
-  *(sys_ctrl->data_buf_reset) = mask & 0x1FFFF; // Mask to 17 bits
+  hw_write32(sys_ctrl->data_buf_reset, mask & 0x1FFFF); // Mask to 17 bits
   if (verbose) {
-    printf("data_buf_reset set to 0x%" PRIx32 "\n", *(sys_ctrl->data_buf_reset));
+    printf("data_buf_reset set to 0x%" PRIx32 "\n", hw_read32(sys_ctrl->data_buf_reset));
   }
 }
 
 // Invert the MOSI SCK polarity register
 void sys_ctrl_invert_mosi_sck(struct sys_ctrl_t *sys_ctrl, bool verbose) {
-  uint32_t current_value = *(sys_ctrl->mosi_sck_pol);
+  uint32_t current_value = hw_read32(sys_ctrl->mosi_sck_pol);
   uint32_t new_value = current_value ^ 0x1; // Invert the last bit
   
   if (verbose) {
     printf("Inverting MOSI SCK polarity from 0x%" PRIx32 " to 0x%" PRIx32 "\n", current_value, new_value);
   }
   
-  *(sys_ctrl->mosi_sck_pol) = new_value;
+  hw_write32(sys_ctrl->mosi_sck_pol, new_value);
   
   if (verbose) {
-    printf("MOSI SCK polarity set to 0x%" PRIx32 "\n", *(sys_ctrl->mosi_sck_pol));
+    printf("MOSI SCK polarity set to 0x%" PRIx32 "\n", hw_read32(sys_ctrl->mosi_sck_pol));
   }
 }
 
 // Invert the MISO SCK polarity register
 void sys_ctrl_invert_miso_sck(struct sys_ctrl_t *sys_ctrl, bool verbose) {
-  uint32_t current_value = *(sys_ctrl->miso_sck_pol);
+  uint32_t current_value = hw_read32(sys_ctrl->miso_sck_pol);
   uint32_t new_value = current_value ^ 0x1; // Invert the last bit
   
   if (verbose) {
     printf("Inverting MISO SCK polarity from 0x%" PRIx32 " to 0x%" PRIx32 "\n", current_value, new_value);
   }
   
-  *(sys_ctrl->miso_sck_pol) = new_value;
+  hw_write32(sys_ctrl->miso_sck_pol, new_value);
   
   if (verbose) {
-    printf("MISO SCK polarity set to 0x%" PRIx32 "\n", *(sys_ctrl->miso_sck_pol));
+    printf("MISO SCK polarity set to 0x%" PRIx32 "\n", hw_read32(sys_ctrl->miso_sck_pol));
   }
 }
 
@@ -139,9 +140,9 @@ void sys_ctrl_set_integ_window(struct sys_ctrl_t *sys_ctrl, uint32_t value, bool
     printf("Setting integ_window to 0x%" PRIx32 "\n", value);
   }
   // Write the 32-bit value to the integrator window register
-  *(sys_ctrl->integ_window) = value;
+  hw_write32(sys_ctrl->integ_window, value);
   if (verbose) {
-    printf("integ_window set to 0x%" PRIx32 "\n", *(sys_ctrl->integ_window));
+    printf("integ_window set to 0x%" PRIx32 "\n", hw_read32(sys_ctrl->integ_window));
   }
 }
 
@@ -151,9 +152,9 @@ void sys_ctrl_set_integ_threshold_average(struct sys_ctrl_t *sys_ctrl, uint32_t
     printf("Setting integ_threshold_average to 0x%" PRIx32 "\n", value);
   }
   // Write the 32-bit value to the integrator threshold average register
-  *(sys_ctrl->integ_threshold_average) = value;
+  hw_write32(sys_ctrl->integ_threshold_average, value);
   if (verbose) {
-    printf("integ_threshold_average set to 0x%" PRIx32 "\n", *(sys_ctrl->integ_threshold_average));
+    printf("integ_threshold_average set to 0x%" PRIx32 "\n", hw_read32(sys_ctrl->integ_threshold_average));
   }
 }
 
@@ -163,8 +164,15 @@ void sys_ctrl_set_integ_enable(struct sys_ctrl_t *sys_ctrl, uint32_t value, bool
     printf("Setting integ_enable to 0x%" PRIx32 "\n", value);
   }
   // Write the 32-bit value to the integrator enable register
-  *(sys_ctrl->integ_enable) = value;
+  hw_write32(sys_ctrl->integ_enable, value);
   if (verbose) {
-    printf("integ_enable set to 0x%" PRIx32 "\n", *(sys_ctrl->integ_enable));
+    printf("integ_enable set to 0x%" PRIx32 "\n", hw_read32(sys_ctrl->integ_enable));
   }
 }
+
+// Read back the integrator window, threshold average and enable registers
+void sys_ctrl_get_integ_settings(struct sys_ctrl_t *sys_ctrl, uint32_t *window, uint32_t *threshold_average, uint32_t *enable) {
+  *window = hw_read32(sys_ctrl->integ_window);
+  *threshold_average = hw_read32(sys_ctrl->integ_threshold_average);
+  *enable = hw_read32(sys_ctrl->integ_enable);
+}
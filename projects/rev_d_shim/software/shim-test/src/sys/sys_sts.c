@@ -4,8 +4,12 @@
 #include <unistd.h> // For read, write, close functions
 #include <fcntl.h> // For open function
 #include <pthread.h> // For pthread functions
+#include <string.h> // For strerror function
+#include <errno.h> // For errno
 #include "sys_sts.h"
 #include "map_memory.h"
+#include "hw_backend.h"
+#include "hw_trace.h"
 
 // Function to create system status structure
 struct sys_sts_t create_sys_sts(bool verbose) {
@@ -41,6 +45,9 @@ struct sys_sts_t create_sys_sts(bool verbose) {
   
   // Initialize trigger counter pointer
   sys_sts.trig_counter = sys_sts_ptr + TRIG_COUNTER_OFFSET;
+
+  // Initialize design options pointer
+  sys_sts.design_opts = sys_sts_ptr + DESIGN_OPTS_OFFSET;
   
   return sys_sts;
 }
@@ -49,27 +56,27 @@ struct sys_sts_t create_sys_sts(bool verbose) {
 uint32_t sys_sts_get_hw_status(struct sys_sts_t *sys_sts, bool verbose) {
   if (verbose) {
     printf("Reading hardware status register...\n");
-    printf("Hardware status raw: 0x%" PRIx32 "\n", *(sys_sts->hw_status_reg));
+    printf("Hardware status raw: 0x%" PRIx32 "\n", hw_read32(sys_sts->hw_status_reg));
   }
-  return *(sys_sts->hw_status_reg);
+  return hw_read32(sys_sts->hw_status_reg);
 }
 
 // Get SPI clock frequency in Hz
 uint32_t sys_sts_get_spi_clk_freq_hz(struct sys_sts_t *sys_sts, bool verbose) {
   if (verbose) {
     printf("Reading SPI clock frequency register...\n");
-    printf("SPI clock frequency raw: 0x%" PRIx32 "\n", *(sys_sts->spi_clk_freq_hz));
+    printf("SPI clock frequency raw: 0x%" PRIx32 "\n", hw_read32(sys_sts->spi_clk_freq_hz));
   }
-  return *(sys_sts->spi_clk_freq_hz);
+  return hw_read32(sys_sts->spi_clk_freq_hz);
 }
 
 // Get FIFO status from a status pointer
 uint32_t get_fifo_status(volatile uint32_t *fifo_sts_ptr, const char *fifo_name, bool verbose) {
   if (verbose) {
     printf("Reading %s FIFO status register...\n", fifo_name);
-    printf("%s FIFO status raw: 0x%08" PRIx32 "\n", fifo_name, *fifo_sts_ptr);
+    printf("%s FIFO status raw: 0x%08" PRIx32 "\n", fifo_name, hw_read32(fifo_sts_ptr));
   }
-  return *fifo_sts_ptr;
+  return hw_read32(fifo_sts_ptr);
 }
 
 // Interpret and print hardware status
@@ -290,7 +297,7 @@ void print_spi_clk_freq(uint32_t freq_hz, bool verbose) {
 
 // Print debug register
 void print_debug_register(struct sys_sts_t *sys_sts) {
-  uint32_t value = *(sys_sts->debug);
+  uint32_t value = hw_read32(sys_sts->debug);
   printf("Debug Register: 0x%08" PRIx32 " (0b", value);
   for (int bit = 31; bit >= 0; bit--) {
     printf("%u", (value >> bit) & 1);
@@ -354,18 +361,27 @@ uint32_t sys_sts_get_trig_data_fifo_status(struct sys_sts_t *sys_sts, bool verbo
 uint32_t sys_sts_get_debug(struct sys_sts_t *sys_sts, bool verbose) {
   if (verbose) {
     printf("Reading debug register...\n");
-    printf("Debug register raw: 0x%" PRIx32 "\n", *(sys_sts->debug));
+    printf("Debug register raw: 0x%" PRIx32 "\n", hw_read32(sys_sts->debug));
   }
-  return *(sys_sts->debug);
+  return hw_read32(sys_sts->debug);
 }
 
 // Get trigger counter value
 uint32_t sys_sts_get_trig_counter(struct sys_sts_t *sys_sts, bool verbose) {
   if (verbose) {
     printf("Reading trigger counter register...\n");
-    printf("Trigger counter raw: 0x%" PRIx32 "\n", *(sys_sts->trig_counter));
+    printf("Trigger counter raw: 0x%" PRIx32 "\n", hw_read32(sys_sts->trig_counter));
+  }
+  return hw_read32(sys_sts->trig_counter);
+}
+
+// Function to get design options word
+uint32_t sys_sts_get_design_opts(struct sys_sts_t *sys_sts, bool verbose) {
+  if (verbose) {
+    printf("Reading design options register...\n");
+    printf("Design options raw: 0x%" PRIx32 "\n", hw_read32(sys_sts->design_opts));
   }
-  return *(sys_sts->trig_counter);
+  return hw_read32(sys_sts->design_opts);
 }
 
 // Print FIFO status details
@@ -389,10 +405,14 @@ struct hw_manager_irq_data {
   bool verbose;
 };
 
+// Set while a monitoring thread is running (only one is started at a time)
+static volatile int hw_manager_irq_monitor_running = 0;
+
 // Thread function to monitor hardware manager interrupt
 static void *hw_manager_irq_thread_func(void *arg) {
   struct hw_manager_irq_data *irq_data = (struct hw_manager_irq_data *)arg;
-  const char *uio_path = "/dev/uio0"; // Hardware manager interrupt is uio0
+  char uio_path[32] = "/dev/uio0"; // Hardware manager interrupt is uio0 unless found by name
+  find_uio_device(HW_MANAGER_IRQ_UIO_NAME, uio_path, sizeof(uio_path));
   int fd;
   uint32_t irq_count;
   uint32_t clear_value = 1;
@@ -404,7 +424,8 @@ static void *hw_manager_irq_thread_func(void *arg) {
   // Open the UIO device for hardware manager interrupt
   fd = open(uio_path, O_RDWR);
   if (fd < 0) {
-    perror("Failed to open hardware manager UIO device (/dev/uio0)");
+    fprintf(stderr, "Failed to open hardware manager UIO device (%s): %s\n", uio_path, strerror(errno));
+    __atomic_store_n(&hw_manager_irq_monitor_running, 0, __ATOMIC_RELEASE);
     pthread_exit(NULL);
   }
 
@@ -442,6 +463,15 @@ static void *hw_manager_irq_thread_func(void *arg) {
       
       // Check if hardware status is "running" - if not, exit the monitoring loop
       if (HW_STS_STATE(hw_status) != S_RUNNING) {
+        // Save the register accesses that led up to the halt
+        if (g_hw_trace_enabled) {
+          long entries = hw_trace_dump_to_file(HW_TRACE_DUMP_PATH);
+          if (entries < 0) {
+            fprintf(stderr, "Failed to write hardware trace to '%s': %s\n", HW_TRACE_DUMP_PATH, strerror(errno));
+          } else {
+            printf("Hardware trace (%ld accesses) written to '%s'\n", entries, HW_TRACE_DUMP_PATH);
+          }
+        }
         if (irq_data->verbose) {
           printf("Hardware is no longer running - exiting interrupt monitor\n");
         }
@@ -463,6 +493,7 @@ static void *hw_manager_irq_thread_func(void *arg) {
   if (irq_data->verbose) {
     printf("Hardware manager interrupt monitor thread exiting\n");
   }
+  __atomic_store_n(&hw_manager_irq_monitor_running, 0, __ATOMIC_RELEASE);
   
   pthread_exit(NULL);
 }
@@ -473,6 +504,11 @@ int sys_sts_start_hw_manager_irq_monitor(struct sys_sts_t *sys_sts, bool verbose
   static pthread_t irq_thread;
   int result;
 
+  // Already monitoring
+  if (__atomic_exchange_n(&hw_manager_irq_monitor_running, 1, __ATOMIC_ACQ_REL)) {
+    return 0;
+  }
+
   // Setup thread data
   irq_data.sys_sts = sys_sts;
   irq_data.verbose = verbose;
@@ -485,6 +521,7 @@ int sys_sts_start_hw_manager_irq_monitor(struct sys_sts_t *sys_sts, bool verbose
   result = pthread_create(&irq_thread, NULL, hw_manager_irq_thread_func, &irq_data);
   if (result != 0) {
     fprintf(stderr, "Failed to create hardware manager interrupt thread: %d\n", result);
+    __atomic_store_n(&hw_manager_irq_monitor_running, 0, __ATOMIC_RELEASE);
     return -1;
   }
 
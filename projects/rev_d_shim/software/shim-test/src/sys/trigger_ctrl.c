@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include "trigger_ctrl.h"
 #include "map_memory.h"
+#include "hw_backend.h"
 
 // Create trigger control structure
 struct trigger_ctrl_t create_trigger_ctrl(bool verbose) {
@@ -13,15 +14,56 @@ struct trigger_ctrl_t create_trigger_ctrl(bool verbose) {
     fprintf(stderr, "Failed to map trigger FIFO access memory region.\n");
     exit(EXIT_FAILURE);
   }
+
+  // Full format until a delta RESET_COUNT is sent
+  trigger_ctrl.first_word = 0;
+  trigger_reset_decoder(&trigger_ctrl, false);
   
   return trigger_ctrl;
 }
 
-// Read 64-bit trigger data from FIFO as a pair of 32-bit words
+// Reset the data decoder, the next entry in either format starts from scratch
+void trigger_reset_decoder(struct trigger_ctrl_t *trigger_ctrl, bool delta_log) {
+  trigger_ctrl->delta_log = delta_log;
+  trigger_ctrl->have_first_word = false;
+  trigger_ctrl->last_timestamp = 0;
+}
+
+// Feed one data word to the decoder, returns true once it completes a timestamp
+static bool trigger_decode_word(struct trigger_ctrl_t *trigger_ctrl, uint32_t word, uint64_t *timestamp) {
+  if (trigger_ctrl->have_first_word) {
+    trigger_ctrl->have_first_word = false;
+    if (trigger_ctrl->delta_log) {
+      *timestamp = ((uint64_t)(trigger_ctrl->first_word & TRIG_DELTA_MAX) << 32) | word; // Full timestamp
+    } else {
+      *timestamp = ((uint64_t)word << 32) | trigger_ctrl->first_word; // Combine into 64-bit value
+    }
+  } else if (!trigger_ctrl->delta_log || (word & TRIG_DATA_RESYNC_FLAG)) {
+    trigger_ctrl->have_first_word = true;
+    trigger_ctrl->first_word = word;
+    return false;
+  } else {
+    *timestamp = trigger_ctrl->last_timestamp + word; // Delta from the previous trigger
+  }
+  trigger_ctrl->last_timestamp = *timestamp;
+  return true;
+}
+
+// Read the next 64-bit trigger timestamp from the FIFO (one or two words, depending on the format)
 uint64_t trigger_read(struct trigger_ctrl_t *trigger_ctrl) {
-  uint32_t low_word = *(trigger_ctrl->buffer);
-  uint32_t high_word = *(trigger_ctrl->buffer);
-  return ((uint64_t)high_word << 32) | low_word; // Combine into 64-bit value
+  uint64_t timestamp;
+  while (!trigger_decode_word(trigger_ctrl, hw_read32(trigger_ctrl->buffer), &timestamp));
+  return timestamp;
+}
+
+// Read and decode the words currently in the FIFO into timestamps
+size_t trigger_read_timestamps(struct trigger_ctrl_t *trigger_ctrl, uint64_t *timestamps, size_t max_count, uint32_t words_available) {
+  size_t count = 0;
+  while (count < max_count && words_available > 0) {
+    words_available--;
+    if (trigger_decode_word(trigger_ctrl, hw_read32(trigger_ctrl->buffer), &timestamps[count])) count++;
+  }
+  return count;
 }
 
 // Trigger command functions
@@ -34,7 +76,7 @@ void trigger_cmd_sync_ch(struct trigger_ctrl_t *trigger_ctrl, bool log, bool ver
            cmd_word, TRIG_CMD_SYNC_CH, log ? 1 : 0);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  hw_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_set_lockout(struct trigger_ctrl_t *trigger_ctrl, uint32_t cycles, bool verbose) {
@@ -50,7 +92,7 @@ void trigger_cmd_set_lockout(struct trigger_ctrl_t *trigger_ctrl, uint32_t cycle
            cmd_word, TRIG_CMD_SET_LOCKOUT, cycles);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  hw_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_expect_ext(struct trigger_ctrl_t *trigger_ctrl, uint32_t count, bool log, bool verbose) {
@@ -68,7 +110,7 @@ void trigger_cmd_expect_ext(struct trigger_ctrl_t *trigger_ctrl, uint32_t count,
            cmd_word, TRIG_CMD_EXPECT_EXT, log ? 1 : 0, count);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  hw_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_delay(struct trigger_ctrl_t *trigger_ctrl, uint32_t cycles, bool verbose) {
@@ -84,7 +126,7 @@ void trigger_cmd_delay(struct trigger_ctrl_t *trigger_ctrl, uint32_t cycles, boo
            cmd_word, TRIG_CMD_DELAY, cycles);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  hw_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_force_trig(struct trigger_ctrl_t *trigger_ctrl, bool log, bool verbose) {
@@ -96,7 +138,7 @@ void trigger_cmd_force_trig(struct trigger_ctrl_t *trigger_ctrl, bool log, bool
            cmd_word, TRIG_CMD_FORCE_TRIG, log ? 1 : 0);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  hw_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_cancel(struct trigger_ctrl_t *trigger_ctrl, bool verbose) {
@@ -107,17 +149,37 @@ void trigger_cmd_cancel(struct trigger_ctrl_t *trigger_ctrl, bool verbose) {
            cmd_word, TRIG_CMD_CANCEL);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  hw_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_reset_count(struct trigger_ctrl_t *trigger_ctrl, bool verbose) {
-  uint32_t cmd_word = (TRIG_CMD_RESET_COUNT << TRIG_CMD_CODE_SHIFT);
+  uint32_t cmd_word = trigger_encode_reset_count(trigger_ctrl->delta_log);
   
   if (verbose) {
-    printf("  Writing trigger reset_count command: 0x%08X (cmd=0x%X)\n", 
-           cmd_word, TRIG_CMD_RESET_COUNT);
+    printf("  Writing trigger reset_count command: 0x%08X (cmd=0x%X, delta=%d)\n", 
+           cmd_word, TRIG_CMD_RESET_COUNT, trigger_ctrl->delta_log ? 1 : 0);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  hw_write32(trigger_ctrl->buffer, cmd_word);
+}
+
+void trigger_cmd_set_log_format(struct trigger_ctrl_t *trigger_ctrl, bool delta_log, bool verbose) {
+  trigger_reset_decoder(trigger_ctrl, delta_log);
+  trigger_cmd_reset_count(trigger_ctrl, verbose);
 }
   
+
+// Command stream functions
+uint32_t trigger_encode_cmd(uint8_t cmd, bool log, uint32_t value) {
+  return ((uint32_t)cmd << TRIG_CMD_CODE_SHIFT) |
+         ((log ? 1 : 0) << TRIG_CMD_LOG_BIT) |
+         (value & TRIG_CMD_VALUE_MASK);
+}
+
+uint32_t trigger_encode_reset_count(bool delta_log) {
+  return trigger_encode_cmd(TRIG_CMD_RESET_COUNT, false, delta_log ? TRIG_RESET_COUNT_DELTA : 0);
+}
+
+void trigger_write_cmd_words(struct trigger_ctrl_t *trigger_ctrl, const uint32_t *words, size_t count) {
+  hw_write_burst32(trigger_ctrl->buffer, words, count);
+}
@@ -1,11 +1,14 @@
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/file.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 //////////////////// Mapped Memory Definitions ////////////////////
@@ -19,6 +22,9 @@
 #define STS_SIZE        (uint32_t) 2048 / 8 // Size of the status register in bytes
 #define SPI_CLK_SIZE    (uint32_t) 2048 // Size of the SPI_CLK interface in bytes
 
+// Hardware ownership lock shared with shim-test (HW_OWNER_LOCK_PATH in its map_memory.h)
+#define HW_OWNER_LOCK_PATH "/tmp/shim-test.lock"
+
 
 
 //////////////////// Function Prototypes ////////////////////
@@ -45,6 +51,19 @@ int main()
 
   printf("System page size: %d\n", sysconf(_SC_PAGESIZE));
 
+  // Don't touch the hardware while shim-test (or its daemon) owns it.
+  // The lock is released automatically when this process exits.
+  // Created world-writable (past the umask) so any user can open it later
+  int lock_fd = open(HW_OWNER_LOCK_PATH, O_RDWR);
+  if (lock_fd < 0 && errno == ENOENT) {
+    lock_fd = open(HW_OWNER_LOCK_PATH, O_RDWR | O_CREAT, 0666);
+    if (lock_fd >= 0) fchmod(lock_fd, 0666);
+  }
+  if (lock_fd < 0 || flock(lock_fd, LOCK_EX | LOCK_NB) != 0) {
+    fprintf(stderr, "Hardware is already owned by another process (lock '%s').\n", HW_OWNER_LOCK_PATH);
+    return EXIT_FAILURE;
+  }
+
   // Open /dev/mem to access physical memory
   printf("Opening /dev/mem...\n");
   if((fd = open("/dev/mem", O_RDWR)) < 0)
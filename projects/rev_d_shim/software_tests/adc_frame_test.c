@@ -0,0 +1,190 @@
+// Unit tests for the ADC frame checker (software/shim-test/src/sys/adc_frame.c)
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "adc_frame.h"
+#include "test_check.h"
+
+#define MAX_WORDS 8192
+
+// A stream as the ADC core writes it (see the core README's Framing section)
+struct stream_t {
+  uint32_t words[MAX_WORDS];     // Data words and markers, in order
+  size_t count;
+  uint32_t data[MAX_WORDS];      // The data words alone (what the checker should pass on)
+  size_t data_count;
+};
+
+static uint32_t marker(uint8_t board, uint32_t drops, uint16_t seq) {
+  return ((uint32_t)ADC_FRAME_MARKER_TAG << 28) | ((uint32_t)(board & 0x7) << 25) | (drops << 16) | seq;
+}
+
+static void push_word(struct stream_t *s, uint32_t word) {
+  s->words[s->count++] = word;
+}
+
+static void push_data(struct stream_t *s, uint32_t word) {
+  push_word(s, word);
+  s->data[s->data_count++] = word;
+}
+
+// Marker 0, then frames 1 to frames. lost[f] is the number of frame f's data words dropped; a
+// frame with all of them dropped while the previous marker waits has no marker (skip[f]).
+static void build_stream(struct stream_t *s, uint8_t board, uint32_t frame_len, uint16_t frames,
+                         const uint32_t *lost, const bool *skip) {
+  memset(s, 0, sizeof(*s));
+  push_word(s, marker(board, 0, 0));
+  for (uint16_t f = 1; f <= frames; f++) {
+    if (skip != NULL && skip[f]) continue;
+    uint32_t drops = lost != NULL ? lost[f] : 0;
+    for (uint32_t i = 0; i < frame_len - drops; i++) push_data(s, 0x00010000u | ((uint32_t)f << 8) | i);
+    push_word(s, marker(board, drops, f));
+  }
+}
+
+// Run a stream through the checker in blocks of block words (NULL log)
+static size_t run_check(struct adc_frame_check_t *check, const struct stream_t *s, uint8_t board,
+                        uint32_t frame_len, size_t block, uint32_t *out) {
+  static uint32_t data[MAX_WORDS + ADC_FRAME_HOLD_WORDS];
+  size_t out_count = 0;
+  adc_frame_check_init(check, board, frame_len, NULL);
+  for (size_t i = 0; i < s->count; i += block) {
+    size_t n = s->count - i < block ? s->count - i : block;
+    size_t got = adc_frame_check_words(check, &s->words[i], n, data);
+    memcpy(&out[out_count], data, got * sizeof(uint32_t));
+    out_count += got;
+  }
+  size_t got = adc_frame_check_finish(check, data);
+  memcpy(&out[out_count], data, got * sizeof(uint32_t));
+  return out_count + got;
+}
+
+// Check a stream in several block sizes: the data comes out intact and the counters match
+static void expect_stream(const char *name, const struct stream_t *s, uint8_t board, uint32_t frame_len,
+                          uint64_t markers, uint64_t gaps, uint64_t words_lost, bool complete) {
+  static const size_t blocks[] = {1, 3, 256, MAX_WORDS};
+  static uint32_t out[MAX_WORDS + ADC_FRAME_HOLD_WORDS];
+  for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+    struct adc_frame_check_t check;
+    size_t out_count = run_check(&check, s, board, frame_len, blocks[b], out);
+    CHECK(out_count == s->data_count, "%s (blocks of %zu): %zu data words, expected %zu", name, blocks[b], out_count, s->data_count);
+    CHECK(out_count != s->data_count || memcmp(out, s->data, out_count * sizeof(uint32_t)) == 0,
+          "%s (blocks of %zu): data words changed", name, blocks[b]);
+    CHECK(check.stats.markers == markers, "%s (blocks of %zu): %llu markers, expected %llu", name, blocks[b],
+          (unsigned long long)check.stats.markers, (unsigned long long)markers);
+    CHECK(check.stats.gaps == gaps, "%s (blocks of %zu): %llu gaps, expected %llu", name, blocks[b],
+          (unsigned long long)check.stats.gaps, (unsigned long long)gaps);
+    CHECK(check.stats.words_lost == words_lost, "%s (blocks of %zu): %llu words lost, expected %llu", name, blocks[b],
+          (unsigned long long)check.stats.words_lost, (unsigned long long)words_lost);
+    CHECK(adc_frame_check_complete(&check) == complete, "%s (blocks of %zu): complete is %d, expected %d", name, blocks[b],
+          adc_frame_check_complete(&check), complete);
+  }
+}
+
+static void test_clean(void) {
+  struct stream_t s;
+  build_stream(&s, 2, 4, 10, NULL, NULL);
+  expect_stream("clean", &s, 2, 4, 11, 0, 0, true);
+}
+
+static void test_gap_first_frame(void) {
+  struct stream_t s;
+  bool skip[11] = {false};
+  skip[1] = true;
+  build_stream(&s, 2, 4, 10, NULL, skip);
+  expect_stream("first frame skipped", &s, 2, 4, 10, 1, 4, false);
+
+  // Only the frame after the gap is left, so no consecutive pair ever lines up
+  build_stream(&s, 2, 4, 2, NULL, skip);
+  expect_stream("first frame skipped, one frame after", &s, 2, 4, 2, 1, 4, false);
+
+  uint32_t lost[11] = {0};
+  lost[1] = 3;
+  build_stream(&s, 2, 4, 10, lost, NULL);
+  expect_stream("first frame partly dropped", &s, 2, 4, 11, 1, 3, false);
+}
+
+static void test_gap_last_frame(void) {
+  struct stream_t s;
+  bool skip[11] = {false};
+  skip[9] = true;
+  build_stream(&s, 2, 4, 10, NULL, skip);
+  expect_stream("frame 9 of 10 skipped", &s, 2, 4, 10, 1, 4, false);
+
+  uint32_t lost[11] = {0};
+  lost[10] = 2;
+  build_stream(&s, 2, 4, 10, lost, NULL);
+  expect_stream("last frame partly dropped", &s, 2, 4, 11, 1, 2, false);
+}
+
+static void test_back_to_back_gaps(void) {
+  struct stream_t s;
+  bool skip[13] = {false};
+  skip[3] = skip[4] = true;
+  build_stream(&s, 5, 6, 12, NULL, skip);
+  expect_stream("frames 3 and 4 skipped", &s, 5, 6, 11, 1, 12, false);
+
+  memset(skip, 0, sizeof(skip));
+  skip[3] = skip[5] = skip[7] = true;
+  build_stream(&s, 5, 6, 12, NULL, skip);
+  expect_stream("frames 3, 5 and 7 skipped", &s, 5, 6, 10, 3, 18, false);
+
+  // Gaps in the last spans, confirmed only by the end of the stream
+  memset(skip, 0, sizeof(skip));
+  skip[9] = skip[11] = true;
+  build_stream(&s, 5, 6, 12, NULL, skip);
+  expect_stream("frames 9 and 11 of 12 skipped", &s, 5, 6, 11, 2, 12, false);
+
+  uint32_t lost[13] = {0};
+  lost[6] = 1;
+  lost[7] = 6;
+  lost[8] = 2;
+  build_stream(&s, 5, 6, 12, lost, NULL);
+  expect_stream("frames 6 to 8 partly dropped", &s, 5, 6, 13, 3, 9, false);
+}
+
+// A stream cut off right after a jump that a marker with drops could still explain: the marker
+// is stripped rather than passed on as data, and the capture is incomplete
+static void test_unconfirmed_jump(void) {
+  struct stream_t s;
+  uint32_t lost[11] = {0};
+  bool skip[11] = {false};
+  skip[9] = true;
+  lost[10] = 1;
+  build_stream(&s, 0, 4, 10, lost, skip);
+  struct adc_frame_check_t check;
+  static uint32_t out[MAX_WORDS + ADC_FRAME_HOLD_WORDS];
+  size_t out_count = run_check(&check, &s, 0, 4, 1, out);
+  CHECK(out_count == s.data_count && memcmp(out, s.data, out_count * sizeof(uint32_t)) == 0,
+        "unconfirmed jump: data words changed");
+  CHECK(check.stats.stripped == 1, "unconfirmed jump: %llu stripped, expected 1", (unsigned long long)check.stats.stripped);
+  CHECK(check.stats.unverified == 3, "unconfirmed jump: %llu unverified, expected 3", (unsigned long long)check.stats.unverified);
+  CHECK(!adc_frame_check_complete(&check), "unconfirmed jump: reported complete");
+}
+
+// Data that looks like a marker wherever it lands (the one 7 words after each marker fits as a jump),
+// in a stream that stops partway into a frame before that spot
+static void test_marker_like_data(void) {
+  struct stream_t s;
+  memset(&s, 0, sizeof(s));
+  uint32_t frame_len = 8;
+  uint32_t lookalike = marker(3, 2, 0x4321); // Fits 6 words after a marker
+  push_word(&s, marker(3, 0, 0));
+  for (uint16_t f = 1; f <= 5; f++) {
+    for (uint32_t i = 0; i < frame_len; i++) push_data(&s, lookalike);
+    push_word(&s, marker(3, 0, f));
+  }
+  for (uint32_t i = 0; i < 5; i++) push_data(&s, lookalike);
+  expect_stream("marker-like data", &s, 3, frame_len, 6, 0, 0, true);
+}
+
+int main(void) {
+  test_clean();
+  test_gap_first_frame();
+  test_gap_last_frame();
+  test_back_to_back_gaps();
+  test_unconfirmed_jump();
+  test_marker_like_data();
+  return test_report("adc_frame_test");
+}
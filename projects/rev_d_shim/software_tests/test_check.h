@@ -0,0 +1,27 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+
+// Minimal checks for the software unit tests: failures are printed and counted, and the test
+// program's exit status is test_report's
+static int g_test_checks = 0;
+static int g_test_failures = 0;
+
+#define CHECK(cond, ...) do { \
+  g_test_checks++; \
+  if (!(cond)) { \
+    g_test_failures++; \
+    fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+    fprintf(stderr, __VA_ARGS__); \
+    fprintf(stderr, "\n"); \
+  } \
+} while (0)
+
+// Print the totals and return the exit status (0 if every check passed)
+static inline int test_report(const char *name) {
+  printf("%s: %d checks, %d failed\n", name, g_test_checks, g_test_failures);
+  return g_test_failures == 0 ? 0 : 1;
+}
+
+#endif // TEST_CHECK_H
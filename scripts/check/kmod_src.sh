@@ -43,9 +43,12 @@ else
   ./scripts/check/petalinux_project.sh ${BRD} ${VER} ${PRJ} # Includes PetaLinux environment check
 fi
 
-# Check for the kernel_modules file
-KERNEL_MODULES_FILE="projects/${PRJ}/cfg/${BRD}/${VER}/petalinux/${PETALINUX_VERSION}/kernel_modules"
-if [ -f "${KERNEL_MODULES_FILE}" ]; then
+# Check the kernel_modules file and those of any design options (options/<option>/kernel_modules)
+PRJ_CFG_DIR="projects/${PRJ}/cfg/${BRD}/${VER}/petalinux/${PETALINUX_VERSION}"
+for KERNEL_MODULES_FILE in "${PRJ_CFG_DIR}/kernel_modules" ${PRJ_CFG_DIR}/options/*/kernel_modules; do
+  if [ ! -f "${KERNEL_MODULES_FILE}" ]; then
+    continue
+  fi
   while IFS= read -r module || [ -n "$module" ]; do
     # Ensure each line is a single word
     if [[ ! "$module" =~ ^[a-z0-9-]+$ ]]; then
@@ -85,4 +88,4 @@ if [ -f "${KERNEL_MODULES_FILE}" ]; then
       exit 1
     fi
   done <"${KERNEL_MODULES_FILE}"
-fi
+done
@@ -14,6 +14,24 @@ fi
 
 # Collect all C files in the specified folder
 C_FILES=$(find "$1" -type f -name "*.c")
+INCLUDE_DIRS=$(find "$1" -type d)
+
+# Add sources shared from other folders, listed one per line in an optional
+# "shared_sources" file (paths relative to the software folder)
+if [ -f "$1/shared_sources" ]; then
+  while read -r SHARED_DIR || [ -n "$SHARED_DIR" ]; do
+    # Skip blank lines and comments
+    if [ -z "$SHARED_DIR" ] || [ "${SHARED_DIR:0:1}" == "#" ]; then
+      continue
+    fi
+    if [ ! -d "$1/$SHARED_DIR" ]; then
+      echo "Error: Shared source folder '$1/$SHARED_DIR' does not exist."
+      exit 1
+    fi
+    C_FILES+=" $(find "$1/$SHARED_DIR" -type f -name "*.c")"
+    INCLUDE_DIRS+=" $(find "$1/$SHARED_DIR" -type d)"
+  done < "$1/shared_sources"
+fi
 # Check if any C files were found
 if [ -z "$C_FILES" ]; then
   echo "Error: No C files found in '$1'."
@@ -21,8 +39,6 @@ if [ -z "$C_FILES" ]; then
   exit 1
 fi
 
-# Collect all subdirectories in the specified folder
-INCLUDE_DIRS=$(find "$1" -type d)
 # Add include directories to the compiler flags (including the root folder)
 INCLUDE_FLAGS="-I$1"  # Include the root folder
 for dir in $INCLUDE_DIRS; do
@@ -0,0 +1,27 @@
+#!/bin/bash
+# This script reads a project's block design tcl file and prints the value a design option is set to
+# (the first top-level "set <option> <value>" line). Prints nothing if the option is never set.
+
+# Check if two arguments are provided
+if [ $# -ne 2 ]; then
+  echo "Usage: $0 <file> <option>"
+  exit 1
+fi
+
+# Assign arguments to variables
+file="$1"
+option="$2"
+
+# Check if the file exists
+if [ ! -f "$file" ]; then
+  echo "File not found: $file"
+  exit 1
+fi
+
+# Find the first unindented "set <option> <value>" line and print the value
+while IFS= read -r line; do
+  if [[ $line =~ ^set[[:space:]]+${option}[[:space:]]+([^[:space:]#]+) ]]; then
+    echo "${BASH_REMATCH[1]}"
+    exit 0
+  fi
+done < "$file"
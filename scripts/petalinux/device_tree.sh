@@ -24,7 +24,7 @@ set -e
 REL_DEVICE_TREE_PATH="projects/${PRJ}/cfg/${BRD}/${VER}/petalinux/${PETALINUX_VERSION}/device_tree.dtsi"
 
 # Check for the device tree file, end if it does not exist
-if [ ! -d "projects/${PRJ}/software" ]; then
+if [ ! -f "${REL_DEVICE_TREE_PATH}" ]; then
   echo "[PTLNX DEVICE TREE] No device tree to include for PetaLinux version ${PETALINUX_VERSION} of ${PBV}"
   echo " Path: ${REL_DEVICE_TREE_PATH}"
   exit 0
@@ -36,4 +36,12 @@ cd tmp/${BRD}/${VER}/${PRJ}/petalinux
 # Copy the device tree file to the PetaLinux project
 echo "[PTLNX DEVICE TREE] Copying device tree file to PetaLinux project"
 cp -f "${REV_D_DIR}/${REL_DEVICE_TREE_PATH}" "project-spec/meta-user/recipes-bsp/device-tree/files/system-user.dtsi"
-  
+
+# Append the device tree fragments of any design options set in the block design
+for OPT_DIR in ${REV_D_DIR}/projects/${PRJ}/cfg/${BRD}/${VER}/petalinux/${PETALINUX_VERSION}/options/*/; do
+  OPT=$(basename "${OPT_DIR}")
+  if [ -f "${OPT_DIR}/device_tree.dtsi" ] && [ "$(${REV_D_DIR}/scripts/make/get_tcl_option.sh ${REV_D_DIR}/projects/${PRJ}/block_design.tcl ${OPT})" = "1" ]; then
+    echo "[PTLNX DEVICE TREE] Appending device tree fragment for design option: ${OPT}"
+    cat "${OPT_DIR}/device_tree.dtsi" >> "project-spec/meta-user/recipes-bsp/device-tree/files/system-user.dtsi"
+  fi
+done
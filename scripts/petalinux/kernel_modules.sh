@@ -20,9 +20,21 @@ set -e
 # Check that the minimum kernel module requirements are met
 ./scripts/check/kmod_src.sh ${BRD} ${VER} ${PRJ}
 
-# Check for a kernel_modules file
-REL_KERNEL_MODULES_PATH="projects/${PRJ}/cfg/${BRD}/${VER}/petalinux/${PETALINUX_VERSION}/kernel_modules"
-if [ ! -f "${REL_KERNEL_MODULES_PATH}" ]; then
+# Collect the kernel_modules files: the project's own list, then the lists of any design options set in the block design
+# (option modules are also loaded at boot, since the option's device tree fragment expects them)
+REL_PRJ_CFG_DIR="projects/${PRJ}/cfg/${BRD}/${VER}/petalinux/${PETALINUX_VERSION}"
+REL_KERNEL_MODULES_PATH="${REL_PRJ_CFG_DIR}/kernel_modules"
+KERNEL_MODULES_FILES=()
+if [ -f "${REL_KERNEL_MODULES_PATH}" ]; then
+  KERNEL_MODULES_FILES+=("${REL_KERNEL_MODULES_PATH}")
+fi
+for OPT_DIR in ${REL_PRJ_CFG_DIR}/options/*/; do
+  OPT=$(basename "${OPT_DIR}")
+  if [ -f "${OPT_DIR}/kernel_modules" ] && [ "$(./scripts/make/get_tcl_option.sh projects/${PRJ}/block_design.tcl ${OPT})" = "1" ]; then
+    KERNEL_MODULES_FILES+=("${OPT_DIR}kernel_modules")
+  fi
+done
+if [ ${#KERNEL_MODULES_FILES[@]} -eq 0 ]; then
   echo "[PTLNX KMODS] INFO: No kernel_modules file found. Skipping kernel module checks."
   echo "  Path: ${REL_KERNEL_MODULES_PATH}"
   exit 0
@@ -36,21 +48,32 @@ cd tmp/${BRD}/${VER}/${PRJ}/petalinux
 
 # Add kernel modules to the project
 echo "[PTLNX KMODS] Adding kernel modules to PetaLinux project"
-while IFS= read -r MOD; do
-  echo "[PTLNX KMODS] Adding kernel module: ${MOD}"
-  petalinux-create modules --name ${MOD} --enable --force
-
-  # Copy the source files into the kernel module directory
-  SRC_DIR="${REV_D_DIR}/kernel_modules/${MOD}/petalinux"
-  KMOD_DIR="project-spec/meta-user/recipes-modules/${MOD}/files"
+ADDED_MODS=()
+for KERNEL_MODULES_FILE in "${KERNEL_MODULES_FILES[@]}"; do
+  while IFS= read -r MOD || [ -n "$MOD" ]; do
+    KMOD_DIR="project-spec/meta-user/recipes-modules/${MOD}/files"
 
-  # Copy the makefile and top source file, overwriting the default ones
-  cp -f "${SRC_DIR}/Makefile" "${KMOD_DIR}/Makefile"
-  cp -f "${SRC_DIR}/${MOD}.c" "${KMOD_DIR}/${MOD}.c"
+    # Create the module recipe once, even if the module is listed by both the project and a design option
+    if [[ ! " ${ADDED_MODS[*]} " =~ " ${MOD} " ]]; then
+      echo "[PTLNX KMODS] Adding kernel module: ${MOD}"
+      petalinux-create modules --name ${MOD} --enable --force
+      ADDED_MODS+=("${MOD}")
 
-  # Copy any additional source files, excluding those two
-  find "${SRC_DIR}" -type f ! -name "Makefile" ! -name "${MOD}.c" -exec cp -f {} "${KMOD_DIR}/" \;
+      # Copy the source files into the kernel module directory
+      SRC_DIR="${REV_D_DIR}/kernel_modules/${MOD}/petalinux"
 
-done < ${REV_D_DIR}/${REL_KERNEL_MODULES_PATH}
+      # Copy the makefile and top source file, overwriting the default ones
+      cp -f "${SRC_DIR}/Makefile" "${KMOD_DIR}/Makefile"
+      cp -f "${SRC_DIR}/${MOD}.c" "${KMOD_DIR}/${MOD}.c"
 
+      # Copy any additional source files, excluding those two
+      find "${SRC_DIR}" -type f ! -name "Makefile" ! -name "${MOD}.c" -exec cp -f {} "${KMOD_DIR}/" \;
+    fi
 
+    # Load design option modules at boot
+    if [ "${KERNEL_MODULES_FILE}" != "${REL_KERNEL_MODULES_PATH}" ]; then
+      echo "[PTLNX KMODS] Loading kernel module at boot: ${MOD}"
+      echo "KERNEL_MODULE_AUTOLOAD += \"${MOD}\"" >> "project-spec/meta-user/recipes-modules/${MOD}/${MOD}.bb"
+    fi
+  done < ${REV_D_DIR}/${KERNEL_MODULES_FILE}
+done
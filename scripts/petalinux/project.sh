@@ -105,3 +105,12 @@ if [ -f "${PRJ_CFG_DIR}/kernel_config.cfg" ]; then
 else
   echo "[PTLNX PROJECT] No kernel configuration file, skipping append"
 fi
+
+# Append the kernel configuration of any design options set in the block design
+for OPT_DIR in ${PRJ_CFG_DIR}/options/*/; do
+  OPT=$(basename "${OPT_DIR}")
+  if [ -f "${OPT_DIR}/kernel_config.cfg" ] && [ "$(${REV_D_DIR}/scripts/make/get_tcl_option.sh ${REV_D_DIR}/projects/${PRJ}/block_design.tcl ${OPT})" = "1" ]; then
+    echo "[PTLNX PROJECT] Appending kernel configuration for design option: ${OPT}"
+    cat ${OPT_DIR}/kernel_config.cfg >> project-spec/meta-user/recipes-kernel/linux/linux-xlnx/bsp.cfg
+  fi
+done
@@ -77,6 +77,25 @@ for SW_DIR in ${SW_PATH}/*; do
     # Get a list of .c and .h files that aren't the top file
     C_FILES=$(find "${SW_DIR}" -type f -name "*.c" ! -name "${SW_NAME}.c")
     H_FILES=$(find "${SW_DIR}" -type f -name "*.h")
+
+    # Add sources shared from other folders, listed one per line in an optional
+    # "shared_sources" file (paths relative to the software folder)
+    if [ -f "${SW_DIR}/shared_sources" ]; then
+      while read -r SHARED_DIR || [ -n "${SHARED_DIR}" ]; do
+        # Skip blank lines and comments
+        if [ -z "${SHARED_DIR}" ] || [ "${SHARED_DIR:0:1}" == "#" ]; then
+          continue
+        fi
+        if [ ! -d "${SW_DIR}/${SHARED_DIR}" ]; then
+          echo "[PTLNX SOFTWARE] ERROR:"
+          echo "${SW_NAME} shared source folder does not exist: ${SHARED_DIR}"
+          echo " Path: projects/${PRJ}/software/${SW_NAME}/shared_sources"
+          exit 1
+        fi
+        C_FILES+=" $(find "${SW_DIR}/${SHARED_DIR}" -type f -name "*.c")"
+        H_FILES+=" $(find "${SW_DIR}/${SHARED_DIR}" -type f -name "*.h")"
+      done < "${SW_DIR}/shared_sources"
+    fi
     SRC_FILES=""
     if [ -n "${C_FILES}" ]; then
       SRC_FILES+=" ${C_FILES}"